@@ -56,14 +56,51 @@
 struct ac_addrlib {
    ADDR_HANDLE handle;
 
+   /* The swizzle equations of the GFX9+ swizzle modes. */
+   const ADDR_EQUATION *equations;
+   unsigned num_equations;
+
    /* The cache of DCC retile maps for reuse when allocating images of
     * similar sizes.
     */
    simple_mtx_t dcc_retile_map_lock;
    struct hash_table *dcc_retile_maps;
    struct hash_table *dcc_retile_tile_indices;
+
+   /* The cache of Addr2ComputeSurfaceInfo results, for applications
+    * creating many surfaces of the same size and format.
+    */
+   simple_mtx_t surf_info_lock;
+   struct hash_table *surf_infos;
+};
+
+/* Bound the memory used by the surface info cache.  It's simply emptied
+ * when it's full.
+ */
+#define SURF_INFO_CACHE_MAX_ENTRIES 256
+
+struct surf_info_cache_entry {
+   ADDR2_COMPUTE_SURFACE_INFO_INPUT in; /* the key */
+   ADDR2_COMPUTE_SURFACE_INFO_OUTPUT out;
+   ADDR2_MIP_INFO mip_info[RADEON_SURF_MAX_LEVELS];
 };
 
+static uint32_t surf_info_hash_key(const void *key)
+{
+   return _mesa_hash_data(key, sizeof(ADDR2_COMPUTE_SURFACE_INFO_INPUT));
+}
+
+static bool surf_info_keys_equal(const void *a, const void *b)
+{
+   return memcmp(a, b, sizeof(ADDR2_COMPUTE_SURFACE_INFO_INPUT)) == 0;
+}
+
+static void surf_info_free(struct hash_entry *entry)
+{
+   /* The key is part of the data. */
+   free(entry->data);
+}
+
 struct dcc_retile_map_key {
    enum radeon_family family;
    unsigned retile_width;
@@ -411,11 +448,16 @@ struct ac_addrlib *ac_addrlib_create(const struct radeon_info *info,
    }
 
    addrlib->handle = addrCreateOutput.hLib;
+   addrlib->equations = addrCreateOutput.pEquationTable;
+   addrlib->num_equations = addrCreateOutput.numEquations;
    simple_mtx_init(&addrlib->dcc_retile_map_lock, mtx_plain);
    addrlib->dcc_retile_maps = _mesa_hash_table_create(NULL, dcc_retile_map_hash_key,
                         dcc_retile_map_keys_equal);
    addrlib->dcc_retile_tile_indices = _mesa_hash_table_create(NULL, dcc_retile_tile_hash_key,
                                                               dcc_retile_tile_keys_equal);
+   simple_mtx_init(&addrlib->surf_info_lock, mtx_plain);
+   addrlib->surf_infos = _mesa_hash_table_create(NULL, surf_info_hash_key,
+                                                 surf_info_keys_equal);
    return addrlib;
 }
 
@@ -425,6 +467,8 @@ void ac_addrlib_destroy(struct ac_addrlib *addrlib)
    simple_mtx_destroy(&addrlib->dcc_retile_map_lock);
    _mesa_hash_table_destroy(addrlib->dcc_retile_maps, dcc_retile_map_free);
    _mesa_hash_table_destroy(addrlib->dcc_retile_tile_indices, dcc_retile_tile_free);
+   simple_mtx_destroy(&addrlib->surf_info_lock);
+   _mesa_hash_table_destroy(addrlib->surf_infos, surf_info_free);
    free(addrlib);
 }
 
@@ -1426,6 +1470,62 @@ static bool is_dcc_supported_by_DCN(const struct radeon_info *info,
    }
 }
 
+/* Addr2ComputeSurfaceInfo with a cache of the results keyed by the input.
+ * Only the mip info is returned through the output pointers.
+ */
+static ADDR_E_RETURNCODE
+ac_addrlib_compute_surface_info(struct ac_addrlib *addrlib,
+                                const ADDR2_COMPUTE_SURFACE_INFO_INPUT *in,
+                                ADDR2_COMPUTE_SURFACE_INFO_OUTPUT *out)
+{
+   ADDR2_MIP_INFO *mip_info = out->pMipInfo;
+   struct surf_info_cache_entry *cached;
+   struct hash_entry *entry;
+   ADDR_E_RETURNCODE ret;
+
+   assert(!out->pStereoInfo);
+
+   simple_mtx_lock(&addrlib->surf_info_lock);
+   entry = _mesa_hash_table_search(addrlib->surf_infos, in);
+   if (entry) {
+      cached = entry->data;
+      *out = cached->out;
+      out->pMipInfo = mip_info;
+      if (mip_info)
+         memcpy(mip_info, cached->mip_info, in->numMipLevels * sizeof(*mip_info));
+      simple_mtx_unlock(&addrlib->surf_info_lock);
+      return ADDR_OK;
+   }
+   simple_mtx_unlock(&addrlib->surf_info_lock);
+
+   ret = Addr2ComputeSurfaceInfo(addrlib->handle, in, out);
+   if (ret != ADDR_OK || !mip_info || in->numMipLevels > RADEON_SURF_MAX_LEVELS)
+      return ret;
+
+   cached = calloc(1, sizeof(*cached));
+   if (!cached)
+      return ret;
+
+   cached->in = *in;
+   cached->out = *out;
+   cached->out.pMipInfo = NULL;
+   memcpy(cached->mip_info, mip_info, in->numMipLevels * sizeof(*mip_info));
+
+   simple_mtx_lock(&addrlib->surf_info_lock);
+   if (_mesa_hash_table_search(addrlib->surf_infos, in)) {
+      /* Another thread was faster. */
+      free(cached);
+   } else {
+      if (_mesa_hash_table_num_entries(addrlib->surf_infos) >=
+          SURF_INFO_CACHE_MAX_ENTRIES)
+         _mesa_hash_table_clear(addrlib->surf_infos, surf_info_free);
+      _mesa_hash_table_insert(addrlib->surf_infos, &cached->in, cached);
+   }
+   simple_mtx_unlock(&addrlib->surf_info_lock);
+
+   return ret;
+}
+
 static int gfx9_compute_miptree(struct ac_addrlib *addrlib,
             const struct radeon_info *info,
             const struct ac_surf_config *config,
@@ -1439,7 +1539,7 @@ static int gfx9_compute_miptree(struct ac_addrlib *addrlib,
    out.size = sizeof(ADDR2_COMPUTE_SURFACE_INFO_OUTPUT);
    out.pMipInfo = mip_info;
 
-   ret = Addr2ComputeSurfaceInfo(addrlib->handle, in, &out);
+   ret = ac_addrlib_compute_surface_info(addrlib, in, &out);
    if (ret != ADDR_OK)
       return ret;
 
@@ -1463,6 +1563,10 @@ static int gfx9_compute_miptree(struct ac_addrlib *addrlib,
    surf->u.gfx9.fmask.swizzle_mode = surf->u.gfx9.surf.swizzle_mode & ~0x3;
    surf->u.gfx9.fmask.epitch = surf->u.gfx9.surf.epitch;
 
+   surf->u.gfx9.swizzle_eq_index =
+      out.equationIndex < addrlib->num_equations ? out.equationIndex :
+                                                   AC_SURF_INVALID_EQ_INDEX;
+
    surf->u.gfx9.surf_slice_size = out.sliceSize;
    surf->u.gfx9.surf_pitch = out.pitch;
    surf->u.gfx9.surf_height = out.height;
@@ -2282,6 +2386,71 @@ int ac_compute_surface(struct ac_addrlib *addrlib, const struct radeon_info *inf
    return 0;
 }
 
+/* Get the swizzle equation of a GFX9+ surface.  Returns false if the
+ * surface is linear, or if its swizzle mode has no equation (e.g. for MSAA).
+ */
+bool ac_surface_get_swizzle_eq(struct ac_addrlib *addrlib,
+                               const struct radeon_surf *surf,
+                               struct ac_surf_swizzle_eq *eq)
+{
+   const ADDR_EQUATION *addr_eq;
+
+   if (surf->u.gfx9.swizzle_eq_index == AC_SURF_INVALID_EQ_INDEX ||
+       surf->u.gfx9.swizzle_eq_index >= addrlib->num_equations)
+      return false;
+
+   addr_eq = &addrlib->equations[surf->u.gfx9.swizzle_eq_index];
+   if (addr_eq->numBits > AC_SURF_MAX_EQ_BITS || addr_eq->stackedDepthSlices)
+      return false;
+
+   memset(eq, 0, sizeof(*eq));
+   eq->num_bits = addr_eq->numBits;
+
+   for (unsigned i = 0; i < addr_eq->numBits; i++) {
+      const ADDR_CHANNEL_SETTING terms[] = {
+         addr_eq->addr[i], addr_eq->xor1[i], addr_eq->xor2[i],
+      };
+
+      for (unsigned t = 0; t < ARRAY_SIZE(terms); t++) {
+         uint32_t *bits;
+
+         if (!terms[t].valid)
+            continue;
+
+         switch (terms[t].channel) {
+         case 0:
+            bits = eq->x;
+            break;
+         case 1:
+            bits = eq->y;
+            break;
+         default:
+            bits = eq->z;
+            break;
+         }
+
+         if (terms[t].index >= AC_SURF_MAX_EQ_BITS)
+            return false;
+
+         bits[terms[t].index] ^= 1u << i;
+      }
+   }
+
+   return true;
+}
+
+void ac_surf_swizzle_eq_row(const struct ac_surf_swizzle_eq *eq,
+                            uint32_t x, uint32_t y, uint32_t z,
+                            unsigned bpe, unsigned count, uint32_t *offsets)
+{
+   const uint32_t yz = ac_surf_swizzle_eq_channel(eq->y, eq->num_bits, y) ^
+                       ac_surf_swizzle_eq_channel(eq->z, eq->num_bits, z);
+
+   for (unsigned i = 0; i < count; i++)
+      offsets[i] = yz ^ ac_surf_swizzle_eq_channel(eq->x, eq->num_bits,
+                                                   (x + i) * bpe);
+}
+
 /* This is meant to be used for disabling DCC. */
 void ac_surface_zero_dcc_fields(struct radeon_surf *surf)
 {
@@ -166,6 +166,11 @@ struct gfx9_surf_layout {
    uint16_t base_mip_width;
    uint16_t base_mip_height;
 
+   /* Index of the swizzle equation in the addrlib equation table, or
+    * AC_SURF_INVALID_EQ_INDEX.  See ac_surface_get_swizzle_eq().
+    */
+   uint16_t swizzle_eq_index;
+
    uint64_t stencil_offset; /* separate stencil */
 
    uint8_t                dcc_block_width;
@@ -319,6 +324,61 @@ void ac_surface_override_offset_stride(const struct radeon_info *info,
                               unsigned num_mipmap_levels,
                               uint64_t offset, unsigned pitch);
 
+#define AC_SURF_INVALID_EQ_INDEX 0xffff
+#define AC_SURF_MAX_EQ_BITS 20
+
+/* The swizzle equation of a GFX9+ surface, for CPU (de)tiling.
+ *
+ * The offset of an element within a swizzle block is linear over GF(2) in the
+ * bits of its coordinates, so it's the XOR of the address bits toggled by
+ * each set bit of x (in bytes), y and z (in elements and slices).  This
+ * is cheap to evaluate for many coordinates at once, and loops over it
+ * vectorize well.
+ *
+ * The block offset doesn't include the pipe/bank XOR (tile_swizzle) nor the
+ * offset of the block itself, which callers add from the block dimensions
+ * and the surface pitch.
+ */
+struct ac_surf_swizzle_eq {
+   unsigned num_bits; /* log2 of the block size in bytes */
+   uint32_t x[AC_SURF_MAX_EQ_BITS];
+   uint32_t y[AC_SURF_MAX_EQ_BITS];
+   uint32_t z[AC_SURF_MAX_EQ_BITS];
+};
+
+bool ac_surface_get_swizzle_eq(struct ac_addrlib *addrlib,
+                               const struct radeon_surf *surf,
+                               struct ac_surf_swizzle_eq *eq);
+
+static inline uint32_t
+ac_surf_swizzle_eq_channel(const uint32_t *bits, unsigned num_bits, uint32_t v)
+{
+   uint32_t offset = 0;
+
+   for (unsigned i = 0; i < num_bits; i++)
+      offset ^= bits[i] & -((v >> i) & 1);
+   return offset;
+}
+
+/* The offset in the swizzle block of the element at (x, y, z), where x is
+ * in bytes.
+ */
+static inline uint32_t
+ac_surf_swizzle_eq_offset(const struct ac_surf_swizzle_eq *eq,
+                          uint32_t x, uint32_t y, uint32_t z)
+{
+   return ac_surf_swizzle_eq_channel(eq->x, eq->num_bits, x) ^
+          ac_surf_swizzle_eq_channel(eq->y, eq->num_bits, y) ^
+          ac_surf_swizzle_eq_channel(eq->z, eq->num_bits, z);
+}
+
+/* The swizzle block offsets of count elements of bpe bytes starting at
+ * element (x, y, z) along a row.
+ */
+void ac_surf_swizzle_eq_row(const struct ac_surf_swizzle_eq *eq,
+                            uint32_t x, uint32_t y, uint32_t z,
+                            unsigned bpe, unsigned count, uint32_t *offsets);
+
 #ifdef __cplusplus
 }
 #endif
@@ -123,78 +123,6 @@ uint16_t get_events_for_counter(counter_type ctr)
    return 0;
 }
 
-struct wait_imm {
-   static const uint8_t unset_counter = 0xff;
-
-   uint8_t vm;
-   uint8_t exp;
-   uint8_t lgkm;
-   uint8_t vs;
-
-   wait_imm() :
-      vm(unset_counter), exp(unset_counter), lgkm(unset_counter), vs(unset_counter) {}
-   wait_imm(uint16_t vm_, uint16_t exp_, uint16_t lgkm_, uint16_t vs_) :
-      vm(vm_), exp(exp_), lgkm(lgkm_), vs(vs_) {}
-
-   wait_imm(enum chip_class chip, uint16_t packed) : vs(unset_counter)
-   {
-      vm = packed & 0xf;
-      if (chip >= GFX9)
-         vm |= (packed >> 10) & 0x30;
-
-      exp = (packed >> 4) & 0x7;
-
-      lgkm = (packed >> 8) & 0xf;
-      if (chip >= GFX10)
-         lgkm |= (packed >> 8) & 0x30;
-   }
-
-   uint16_t pack(enum chip_class chip) const
-   {
-      uint16_t imm = 0;
-      assert(exp == unset_counter || exp <= 0x7);
-      switch (chip) {
-      case GFX10:
-      case GFX10_3:
-         assert(lgkm == unset_counter || lgkm <= 0x3f);
-         assert(vm == unset_counter || vm <= 0x3f);
-         imm = ((vm & 0x30) << 10) | ((lgkm & 0x3f) << 8) | ((exp & 0x7) << 4) | (vm & 0xf);
-         break;
-      case GFX9:
-         assert(lgkm == unset_counter || lgkm <= 0xf);
-         assert(vm == unset_counter || vm <= 0x3f);
-         imm = ((vm & 0x30) << 10) | ((lgkm & 0xf) << 8) | ((exp & 0x7) << 4) | (vm & 0xf);
-         break;
-      default:
-         assert(lgkm == unset_counter || lgkm <= 0xf);
-         assert(vm == unset_counter || vm <= 0xf);
-         imm = ((lgkm & 0xf) << 8) | ((exp & 0x7) << 4) | (vm & 0xf);
-         break;
-      }
-      if (chip < GFX9 && vm == wait_imm::unset_counter)
-         imm |= 0xc000; /* should have no effect on pre-GFX9 and now we won't have to worry about the architecture when interpreting the immediate */
-      if (chip < GFX10 && lgkm == wait_imm::unset_counter)
-         imm |= 0x3000; /* should have no effect on pre-GFX10 and now we won't have to worry about the architecture when interpreting the immediate */
-      return imm;
-   }
-
-   bool combine(const wait_imm& other)
-   {
-      bool changed = other.vm < vm || other.exp < exp || other.lgkm < lgkm || other.vs < vs;
-      vm = std::min(vm, other.vm);
-      exp = std::min(exp, other.exp);
-      lgkm = std::min(lgkm, other.lgkm);
-      vs = std::min(vs, other.vs);
-      return changed;
-   }
-
-   bool empty() const
-   {
-      return vm == unset_counter && exp == unset_counter &&
-             lgkm == unset_counter && vs == unset_counter;
-   }
-};
-
 struct wait_entry {
    wait_imm imm;
    uint16_t events; /* use wait_event notion */
@@ -204,6 +132,8 @@ struct wait_entry {
    bool has_vmem_nosampler:1;
    bool has_vmem_sampler:1;
 
+   wait_entry() : events(0), counters(0), wait_on_read(false), logical(false),
+                  has_vmem_nosampler(false), has_vmem_sampler(false) {}
    wait_entry(wait_event event, wait_imm imm, bool logical, bool wait_on_read)
            : imm(imm), events(event), counters(get_counters_for_event(event)),
              wait_on_read(wait_on_read), logical(logical),
@@ -258,6 +188,8 @@ struct wait_entry {
 };
 
 struct wait_ctx {
+   static const unsigned max_reg_cnt = 512;
+
    Program *program;
    enum chip_class chip_class;
    uint16_t max_vm_cnt;
@@ -277,7 +209,10 @@ struct wait_ctx {
    wait_imm barrier_imm[storage_count];
    uint16_t barrier_events[storage_count] = {}; /* use wait_event notion */
 
-   std::map<PhysReg,wait_entry> gpr_map;
+   /* Dense per-register state: gpr_map[reg] is only valid if the
+    * corresponding bit in gpr_mask is set. */
+   uint64_t gpr_mask[max_reg_cnt / 64] = {};
+   wait_entry gpr_map[max_reg_cnt];
 
    /* used for vmem/smem scores */
    bool collect_statistics;
@@ -314,17 +249,21 @@ struct wait_ctx {
       pending_flat_vm |= other->pending_flat_vm;
       pending_s_buffer_store |= other->pending_s_buffer_store;
 
-      for (std::pair<PhysReg,wait_entry> entry : other->gpr_map)
-      {
-         std::map<PhysReg,wait_entry>::iterator it = gpr_map.find(entry.first);
-         if (entry.second.logical != logical)
-            continue;
+      for (unsigned i = 0; i < max_reg_cnt / 64; i++) {
+         uint64_t mask = other->gpr_mask[i];
+         while (mask) {
+            unsigned reg = i * 64 + u_bit_scan64(&mask);
+            const wait_entry& entry = other->gpr_map[reg];
+            if (entry.logical != logical)
+               continue;
 
-         if (it != gpr_map.end()) {
-            changed |= it->second.join(entry.second);
-         } else {
-            gpr_map.insert(entry);
-            changed = true;
+            if (gpr_mask[i] & (1ull << (reg % 64))) {
+               changed |= gpr_map[reg].join(entry);
+            } else {
+               gpr_map[reg] = entry;
+               gpr_mask[i] |= 1ull << (reg % 64);
+               changed = true;
+            }
          }
       }
 
@@ -374,6 +313,13 @@ struct wait_ctx {
       entry.remove_counter(counter);
    }
 
+   wait_entry *find_entry(PhysReg reg)
+   {
+      if (reg.reg() >= max_reg_cnt || !(gpr_mask[reg.reg() / 64] & (1ull << (reg.reg() % 64))))
+         return NULL;
+      return &gpr_map[reg.reg()];
+   }
+
    void advance_unwaited_instrs()
    {
       for (unsigned i = 0; i < num_counters; i++) {
@@ -394,11 +340,11 @@ wait_imm check_instr(Instruction* instr, wait_ctx& ctx)
       /* check consecutively read gprs */
       for (unsigned j = 0; j < op.size(); j++) {
          PhysReg reg{op.physReg() + j};
-         std::map<PhysReg,wait_entry>::iterator it = ctx.gpr_map.find(reg);
-         if (it == ctx.gpr_map.end() || !it->second.wait_on_read)
+         wait_entry *entry = ctx.find_entry(reg);
+         if (!entry || !entry->wait_on_read)
             continue;
 
-         wait.combine(it->second.imm);
+         wait.combine(entry->imm);
       }
    }
 
@@ -408,24 +354,24 @@ wait_imm check_instr(Instruction* instr, wait_ctx& ctx)
       {
          PhysReg reg{def.physReg() + j};
 
-         std::map<PhysReg,wait_entry>::iterator it = ctx.gpr_map.find(reg);
-         if (it == ctx.gpr_map.end())
+         wait_entry *entry = ctx.find_entry(reg);
+         if (!entry)
             continue;
 
          /* Vector Memory reads and writes return in the order they were issued */
          bool has_sampler = instr->format == Format::MIMG && !instr->operands[1].isUndefined() && instr->operands[1].regClass() == s4;
-         if (instr->isVMEM() && ((it->second.events & vm_events) == event_vmem) &&
-             it->second.has_vmem_nosampler == !has_sampler && it->second.has_vmem_sampler == has_sampler)
+         if (instr->isVMEM() && ((entry->events & vm_events) == event_vmem) &&
+             entry->has_vmem_nosampler == !has_sampler && entry->has_vmem_sampler == has_sampler)
             continue;
 
          /* LDS reads and writes return in the order they were issued. same for GDS */
          if (instr->format == Format::DS) {
             bool gds = static_cast<DS_instruction*>(instr)->gds;
-            if ((it->second.events & lgkm_events) == (gds ? event_gds : event_lds))
+            if ((entry->events & lgkm_events) == (gds ? event_gds : event_lds))
                continue;
          }
 
-         wait.combine(it->second.imm);
+         wait.combine(entry->imm);
       }
    }
 
@@ -547,21 +493,22 @@ wait_imm kill(Instruction* instr, wait_ctx& ctx, memory_sync_info sync_info)
       }
 
       /* remove all gprs with higher counter from map */
-      std::map<PhysReg,wait_entry>::iterator it = ctx.gpr_map.begin();
-      while (it != ctx.gpr_map.end())
-      {
-         if (imm.exp != wait_imm::unset_counter && imm.exp <= it->second.imm.exp)
-            ctx.wait_and_remove_from_entry(it->first, it->second, counter_exp);
-         if (imm.vm != wait_imm::unset_counter && imm.vm <= it->second.imm.vm)
-            ctx.wait_and_remove_from_entry(it->first, it->second, counter_vm);
-         if (imm.lgkm != wait_imm::unset_counter && imm.lgkm <= it->second.imm.lgkm)
-            ctx.wait_and_remove_from_entry(it->first, it->second, counter_lgkm);
-         if (imm.vs != wait_imm::unset_counter && imm.vs <= it->second.imm.vs)
-            ctx.wait_and_remove_from_entry(it->first, it->second, counter_vs);
-         if (!it->second.counters)
-            it = ctx.gpr_map.erase(it);
-         else
-            it++;
+      for (unsigned i = 0; i < wait_ctx::max_reg_cnt / 64; i++) {
+         uint64_t mask = ctx.gpr_mask[i];
+         while (mask) {
+            unsigned reg = i * 64 + u_bit_scan64(&mask);
+            wait_entry& entry = ctx.gpr_map[reg];
+            if (imm.exp != wait_imm::unset_counter && imm.exp <= entry.imm.exp)
+               ctx.wait_and_remove_from_entry(PhysReg{reg}, entry, counter_exp);
+            if (imm.vm != wait_imm::unset_counter && imm.vm <= entry.imm.vm)
+               ctx.wait_and_remove_from_entry(PhysReg{reg}, entry, counter_vm);
+            if (imm.lgkm != wait_imm::unset_counter && imm.lgkm <= entry.imm.lgkm)
+               ctx.wait_and_remove_from_entry(PhysReg{reg}, entry, counter_lgkm);
+            if (imm.vs != wait_imm::unset_counter && imm.vs <= entry.imm.vs)
+               ctx.wait_and_remove_from_entry(PhysReg{reg}, entry, counter_vs);
+            if (!entry.counters)
+               ctx.gpr_mask[i] &= ~(1ull << (reg % 64));
+         }
       }
    }
 
@@ -632,22 +579,25 @@ void update_counters(wait_ctx& ctx, wait_event event, memory_sync_info sync=memo
    if (ctx.pending_flat_vm)
       counters &= ~counter_vm;
 
-   for (std::pair<const PhysReg,wait_entry>& e : ctx.gpr_map) {
-      wait_entry& entry = e.second;
+   for (unsigned i = 0; i < wait_ctx::max_reg_cnt / 64; i++) {
+      uint64_t mask = ctx.gpr_mask[i];
+      while (mask) {
+         wait_entry& entry = ctx.gpr_map[i * 64 + u_bit_scan64(&mask)];
 
-      if (entry.events & ctx.unordered_events)
-         continue;
+         if (entry.events & ctx.unordered_events)
+            continue;
 
-      assert(entry.events);
+         assert(entry.events);
 
-      if ((counters & counter_exp) && (entry.events & exp_events) == event && entry.imm.exp < ctx.max_exp_cnt)
-         entry.imm.exp++;
-      if ((counters & counter_lgkm) && (entry.events & lgkm_events) == event && entry.imm.lgkm < ctx.max_lgkm_cnt)
-         entry.imm.lgkm++;
-      if ((counters & counter_vm) && (entry.events & vm_events) == event && entry.imm.vm < ctx.max_vm_cnt)
-         entry.imm.vm++;
-      if ((counters & counter_vs) && (entry.events & vs_events) == event && entry.imm.vs < ctx.max_vs_cnt)
-         entry.imm.vs++;
+         if ((counters & counter_exp) && (entry.events & exp_events) == event && entry.imm.exp < ctx.max_exp_cnt)
+            entry.imm.exp++;
+         if ((counters & counter_lgkm) && (entry.events & lgkm_events) == event && entry.imm.lgkm < ctx.max_lgkm_cnt)
+            entry.imm.lgkm++;
+         if ((counters & counter_vm) && (entry.events & vm_events) == event && entry.imm.vm < ctx.max_vm_cnt)
+            entry.imm.vm++;
+         if ((counters & counter_vs) && (entry.events & vs_events) == event && entry.imm.vs < ctx.max_vs_cnt)
+            entry.imm.vs++;
+      }
    }
 }
 
@@ -662,12 +612,15 @@ void update_counters_for_flat_load(wait_ctx& ctx, memory_sync_info sync=memory_s
 
    update_barrier_imm(ctx, counter_vm | counter_lgkm, event_flat, sync);
 
-   for (std::pair<PhysReg,wait_entry> e : ctx.gpr_map)
-   {
-      if (e.second.counters & counter_vm)
-         e.second.imm.vm = 0;
-      if (e.second.counters & counter_lgkm)
-         e.second.imm.lgkm = 0;
+   for (unsigned i = 0; i < wait_ctx::max_reg_cnt / 64; i++) {
+      uint64_t mask = ctx.gpr_mask[i];
+      while (mask) {
+         wait_entry& entry = ctx.gpr_map[i * 64 + u_bit_scan64(&mask)];
+         if (entry.counters & counter_vm)
+            entry.imm.vm = 0;
+         if (entry.counters & counter_lgkm)
+            entry.imm.lgkm = 0;
+      }
    }
    ctx.pending_flat_lgkm = true;
    ctx.pending_flat_vm = true;
@@ -692,9 +645,14 @@ void insert_wait_entry(wait_ctx& ctx, PhysReg reg, RegClass rc, wait_event event
    new_entry.has_vmem_sampler = (event & event_vmem) && has_sampler;
 
    for (unsigned i = 0; i < rc.size(); i++) {
-      auto it = ctx.gpr_map.emplace(PhysReg{reg.reg()+i}, new_entry);
-      if (!it.second)
-         it.first->second.join(new_entry);
+      unsigned idx = reg.reg() + i;
+      assert(idx < wait_ctx::max_reg_cnt);
+      if (ctx.gpr_mask[idx / 64] & (1ull << (idx % 64))) {
+         ctx.gpr_map[idx].join(new_entry);
+      } else {
+         ctx.gpr_map[idx] = new_entry;
+         ctx.gpr_mask[idx / 64] |= 1ull << (idx % 64);
+      }
    }
 
    if (ctx.collect_statistics) {
@@ -34,13 +34,18 @@ static radv_compiler_statistic_info statistic_infos[] = {
    [aco::statistic_instructions] = {"Instructions", "Instruction count"},
    [aco::statistic_copies] = {"Copies", "Copy instructions created for pseudo-instructions"},
    [aco::statistic_branches] = {"Branches", "Branch instructions"},
-   [aco::statistic_cycles] = {"Busy Cycles", "Estimate of busy cycles"},
+   [aco::statistic_cycles] = {"Busy Cycles", "Estimate of cycles spent issuing instructions"},
    [aco::statistic_vmem_clauses] = {"VMEM Clause", "Number of VMEM clauses (includes 1-sized clauses)"},
    [aco::statistic_smem_clauses] = {"SMEM Clause", "Number of SMEM clauses (includes 1-sized clauses)"},
    [aco::statistic_vmem_score] = {"VMEM Score", "Average VMEM def-use distances"},
    [aco::statistic_smem_score] = {"SMEM Score", "Average SMEM def-use distances"},
    [aco::statistic_sgpr_presched] = {"Pre-Sched SGPRs", "SGPR usage before scheduling"},
    [aco::statistic_vgpr_presched] = {"Pre-Sched VGPRs", "VGPR usage before scheduling"},
+   [aco::statistic_latency_presched] = {"Pre-Sched Latency", "Estimate of cycles including memory stalls before scheduling"},
+   [aco::statistic_latency_postsched] = {"Post-Sched Latency", "Estimate of cycles including memory stalls after scheduling"},
+   [aco::statistic_lds_spill_bytes] = {"LDS Spill Bytes", "Bytes of LDS per workgroup used for VGPR spilling"},
+   [aco::statistic_latency] = {"Latency", "Issue cycles plus stall cycles of a single wave"},
+   [aco::statistic_inv_throughput] = {"Inverse Throughput", "Estimated busy cycles of a wave when the SIMD is fully occupied"},
 };
 
 static void validate(aco::Program *program)
@@ -82,8 +87,10 @@ void aco_compile_shader(unsigned shader_count,
    validate(program.get());
 
    /* Optimization */
-   aco::value_numbering(program.get());
-   aco::optimize(program.get());
+   if (!args->options->key.optimisations_disabled) {
+      aco::value_numbering(program.get());
+      aco::optimize(program.get());
+   }
 
    /* cleanup and exec mask handling */
    aco::setup_reduce_temp(program.get());
@@ -111,7 +118,10 @@ void aco_compile_shader(unsigned shader_count,
 
    if (program->collect_statistics)
       aco::collect_presched_stats(program.get());
-   aco::schedule_program(program.get(), live_vars);
+   if (!args->options->key.optimisations_disabled)
+      aco::schedule_program(program.get(), live_vars);
+   if (program->collect_statistics)
+      aco::collect_postsched_stats(program.get());
    validate(program.get());
 
    /* Register Allocation */
@@ -176,6 +176,25 @@ struct memory_sync_info {
 };
 static_assert(sizeof(memory_sync_info) == 3, "Unexpected padding");
 
+struct wait_imm {
+   static const uint8_t unset_counter = 0xff;
+
+   uint8_t vm;
+   uint8_t exp;
+   uint8_t lgkm;
+   uint8_t vs;
+
+   wait_imm();
+   wait_imm(uint16_t vm_, uint16_t exp_, uint16_t lgkm_, uint16_t vs_);
+   wait_imm(enum chip_class chip, uint16_t packed);
+
+   uint16_t pack(enum chip_class chip) const;
+
+   bool combine(const wait_imm& other);
+
+   bool empty() const;
+};
+
 enum fp_round {
    fp_round_ne = 0,
    fp_round_pi = 1,
@@ -1295,10 +1314,14 @@ struct Pseudo_reduction_instruction : public Instruction {
 };
 static_assert(sizeof(Pseudo_reduction_instruction) == sizeof(Instruction) + 4, "Unexpected padding");
 
+/* Arena of the Program currently being compiled on this thread. All
+ * instructions are allocated from it and freed together with the Program. */
+extern thread_local aco::monotonic_buffer_resource *instruction_buffer;
+
 struct instr_deleter_functor {
-   void operator()(void* p) {
-      free(p);
-   }
+   /* Don't free individual instructions: the memory is owned by the
+    * instruction_buffer and released as a whole with the Program. */
+   void operator()(void* p) {}
 };
 
 template<typename T>
@@ -1308,7 +1331,8 @@ template<typename T>
 T* create_instruction(aco_opcode opcode, Format format, uint32_t num_operands, uint32_t num_definitions)
 {
    std::size_t size = sizeof(T) + num_operands * sizeof(Operand) + num_definitions * sizeof(Definition);
-   char *data = (char*) calloc(1, size);
+   assert(instruction_buffer);
+   char *data = (char*) instruction_buffer->allocate(size, alignof(T));
    T* inst = (T*) data;
 
    inst->opcode = opcode;
@@ -1534,11 +1558,34 @@ enum statistic {
    statistic_smem_score,
    statistic_sgpr_presched,
    statistic_vgpr_presched,
+   statistic_latency_presched,
+   statistic_latency_postsched,
+   statistic_lds_spill_bytes,
+   statistic_latency,
+   statistic_inv_throughput,
    num_statistics
 };
 
 class Program final {
 public:
+   Program()
+   {
+      instruction_buffer = &m;
+   }
+
+   ~Program()
+   {
+      if (instruction_buffer == &m)
+         instruction_buffer = nullptr;
+   }
+
+   Program(const Program&) = delete;
+   Program& operator=(const Program&) = delete;
+
+   /* Owns the memory of all instructions of this program. Declared first so
+    * that it is destroyed after everything referencing instructions. */
+   aco::monotonic_buffer_resource m;
+
    float_mode next_fp_mode;
    std::vector<Block> blocks;
    RegisterDemand max_reg_demand = RegisterDemand();
@@ -1648,6 +1695,11 @@ void lower_phis(Program* program);
 void calc_min_waves(Program* program);
 void update_vgpr_sgpr_demand(Program* program, const RegisterDemand new_demand);
 live live_var_analysis(Program* program, const struct radv_nir_compiler_options *options);
+/* Updates the liveness information of the given blocks after instructions were
+ * inserted without changing any block's live-in set, e.g. copies at the end of
+ * a predecessor. Avoids a full live_var_analysis() in that case. */
+void update_live_var_analysis(Program* program, live& live_vars,
+                              const std::vector<unsigned>& modified_blocks);
 std::vector<uint16_t> dead_code_analysis(Program *program);
 void dominator_tree(Program* program);
 void insert_exec_mask(Program *program);
@@ -1674,6 +1726,7 @@ void perfwarn(bool cond, const char *msg, Instruction *instr=NULL);
 #endif
 
 void collect_presched_stats(Program *program);
+void collect_postsched_stats(Program *program);
 void collect_preasm_stats(Program *program);
 void collect_postasm_stats(Program *program, const std::vector<uint32_t>& code);
 
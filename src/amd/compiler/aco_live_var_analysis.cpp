@@ -30,6 +30,7 @@
 #include "aco_ir.h"
 #include "util/u_math.h"
 
+#include <algorithm>
 #include <set>
 #include <vector>
 
@@ -83,8 +84,11 @@ RegisterDemand get_demand_before(RegisterDemand demand, aco_ptr<Instruction>& in
 }
 
 namespace {
-void process_live_temps_per_block(Program *program, live& lives, Block* block,
-                                  std::set<unsigned>& worklist, std::vector<uint16_t>& phi_sgpr_ops)
+/* Computes the register demand and the kill flags of a single block from its
+ * live-out set and returns the set of temporaries which are live at the start
+ * of the block (after the phi definitions). Doesn't touch other blocks. */
+TempSet process_live_temps_block_local(Program *program, live& lives, Block* block,
+                                       uint16_t phi_sgpr_ops)
 {
    std::vector<RegisterDemand>& register_demand = lives.register_demand[block->index];
    RegisterDemand new_demand;
@@ -103,7 +107,7 @@ void process_live_temps_per_block(Program *program, live& lives, Block* block,
    /* initialize register demand */
    for (Temp t : live)
       new_demand += t;
-   new_demand.sgpr -= phi_sgpr_ops[block->index];
+   new_demand.sgpr -= phi_sgpr_ops;
 
    /* traverse the instructions backwards */
    int idx;
@@ -142,7 +146,7 @@ void process_live_temps_per_block(Program *program, live& lives, Block* block,
 
       /* GEN */
       if (insn->opcode == aco_opcode::p_logical_end) {
-         new_demand.sgpr += phi_sgpr_ops[block->index];
+         new_demand.sgpr += phi_sgpr_ops;
       } else {
          /* we need to do this in a separate loop because the next one can
           * setKill() for several operands at once and we don't want to
@@ -208,6 +212,15 @@ void process_live_temps_per_block(Program *program, live& lives, Block* block,
       phi_idx--;
    }
 
+   assert(block->index != 0 || (new_demand == RegisterDemand() && live.empty()));
+   return live;
+}
+
+void process_live_temps_per_block(Program *program, live& lives, Block* block,
+                                  std::set<unsigned>& worklist, std::vector<uint16_t>& phi_sgpr_ops)
+{
+   TempSet live = process_live_temps_block_local(program, lives, block, phi_sgpr_ops[block->index]);
+
    /* now, we need to merge the live-ins into the live-out sets */
    for (Temp t : live) {
       std::vector<unsigned>& preds = t.is_linear() ? block->linear_preds : block->logical_preds;
@@ -225,10 +238,12 @@ void process_live_temps_per_block(Program *program, live& lives, Block* block,
    }
 
    /* handle phi operands */
-   phi_idx = idx;
-   while (phi_idx >= 0) {
+   int phi_idx = -1;
+   while (phi_idx + 1 < (int) block->instructions.size() &&
+          is_phi(block->instructions[phi_idx + 1]))
+      phi_idx++;
+   for (; phi_idx >= 0; phi_idx--) {
       Instruction *insn = block->instructions[phi_idx].get();
-      assert(is_phi(insn));
       /* directly insert into the predecessors live-out set */
       std::vector<unsigned>& preds = insn->opcode == aco_opcode::p_phi
                                    ? block->logical_preds
@@ -248,10 +263,27 @@ void process_live_temps_per_block(Program *program, live& lives, Block* block,
                phi_sgpr_ops[preds[i]] += operand.size();
          }
       }
-      phi_idx--;
    }
+}
 
-   assert(block->index != 0 || (new_demand == RegisterDemand() && live.empty()));
+/* Returns the temporaries live at the start of a block, given its live-out set. */
+TempSet get_live_in(const Block& block, const TempSet& live_out)
+{
+   TempSet live = live_out;
+   for (auto it = block.instructions.rbegin(); it != block.instructions.rend(); ++it) {
+      Instruction *insn = it->get();
+      for (const Definition& def : insn->definitions) {
+         if (def.isTemp())
+            live.erase(def.getTemp());
+      }
+      if (is_phi(insn) || insn->opcode == aco_opcode::p_logical_end)
+         continue;
+      for (const Operand& op : insn->operands) {
+         if (op.isTemp())
+            live.insert(op.getTemp());
+      }
+   }
+   return live;
 }
 
 unsigned calc_waves_per_workgroup(Program *program)
@@ -405,5 +437,60 @@ live live_var_analysis(Program* program,
    return result;
 }
 
+void update_live_var_analysis(Program* program, live& live_vars,
+                              const std::vector<unsigned>& modified_blocks)
+{
+   for (unsigned block_idx : modified_blocks) {
+      Block& block = program->blocks[block_idx];
+
+      std::vector<unsigned> succs = block.linear_succs;
+      for (unsigned succ : block.logical_succs) {
+         if (std::find(succs.begin(), succs.end(), succ) == succs.end())
+            succs.push_back(succ);
+      }
+
+      /* recompute the live-out set from the live-ins of the successors */
+      TempSet live_out;
+      for (unsigned succ_idx : succs) {
+         Block& succ = program->blocks[succ_idx];
+         bool logical = std::find(succ.logical_preds.begin(), succ.logical_preds.end(), block_idx) != succ.logical_preds.end();
+         bool linear = std::find(succ.linear_preds.begin(), succ.linear_preds.end(), block_idx) != succ.linear_preds.end();
+         for (Temp t : get_live_in(succ, live_vars.live_out[succ_idx])) {
+            if (t.is_linear() ? linear : logical)
+               live_out.insert(t);
+         }
+      }
+
+      /* and from the phi operands which come from this block */
+      uint16_t phi_sgpr_ops = 0;
+      for (unsigned succ_idx : succs) {
+         Block& succ = program->blocks[succ_idx];
+         for (aco_ptr<Instruction>& phi : succ.instructions) {
+            if (!is_phi(phi))
+               break;
+            std::vector<unsigned>& preds = phi->opcode == aco_opcode::p_phi
+                                         ? succ.logical_preds
+                                         : succ.linear_preds;
+            for (unsigned i = 0; i < preds.size(); ++i) {
+               Operand& operand = phi->operands[i];
+               if (preds[i] != block_idx || !operand.isTemp())
+                  continue;
+               const bool inserted = live_out.insert(operand.getTemp()).second;
+               if (inserted && phi->opcode == aco_opcode::p_phi && operand.getTemp().type() == RegType::sgpr)
+                  phi_sgpr_ops += operand.size();
+            }
+         }
+      }
+
+      live_vars.live_out[block_idx] = std::move(live_out);
+      process_live_temps_block_local(program, live_vars, &block, phi_sgpr_ops);
+   }
+
+   RegisterDemand new_demand;
+   for (Block& block : program->blocks)
+      new_demand.update(block.register_demand);
+   update_vgpr_sgpr_demand(program, new_demand);
+}
+
 }
 
@@ -205,8 +205,17 @@ void lower_to_cssa(Program* program, live& live_vars, const struct radv_nir_comp
 
    insert_parallelcopies(ctx);
 
-   /* update live variable information */
-   live_vars = live_var_analysis(program, options);
+   /* The parallelcopies only use temporaries which were already live-out of
+    * the predecessors, so only their live-out sets and register demand have
+    * to be updated. */
+   std::vector<unsigned> modified_blocks;
+   for (auto&& entry : ctx.logical_phi_info)
+      modified_blocks.push_back(entry.first);
+   for (auto&& entry : ctx.linear_phi_info) {
+      if (!ctx.logical_phi_info.count(entry.first))
+         modified_blocks.push_back(entry.first);
+   }
+   update_live_var_analysis(program, live_vars, modified_blocks);
 }
 }
 
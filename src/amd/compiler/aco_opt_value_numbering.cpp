@@ -23,12 +23,16 @@
  */
 
 #include <map>
-#include <unordered_map>
+#include <vector>
 #include "aco_ir.h"
 
 /*
  * Implements the algorithm for dominator-tree value numbering
  * from "Value Numbering" by Briggs, Cooper, and Simpson.
+ *
+ * The expressions of a block stay available while its dominator subtree is
+ * processed and are removed again afterwards, so that an expression computed
+ * in a sibling block doesn't hide the one from a common dominator.
  */
 
 namespace aco {
@@ -328,13 +332,125 @@ struct InstrPred {
    }
 };
 
-using expr_set = std::unordered_map<Instruction*, uint32_t, InstrHash, InstrPred>;
+/* Flat open-addressing hash table mapping expressions to the block of the
+ * instruction which computes them. Uses linear probing with backward-shift
+ * deletion, so that no tombstones accumulate while entries are added and
+ * removed for the dominator subtrees.
+ */
+class expr_set {
+public:
+   struct entry {
+      Instruction* instr;
+      uint32_t block;
+      uint32_t hash;
+   };
+
+   explicit expr_set(unsigned expected_size)
+   {
+      unsigned size = 16;
+      while (size < expected_size * 2)
+         size *= 2;
+      entries.resize(size);
+   }
+
+   /* Returns the entry of an equal expression or inserts instr. */
+   std::pair<entry*, bool> emplace(Instruction* instr, uint32_t block)
+   {
+      if ((num_entries + 1) * 2 > entries.size())
+         grow();
+
+      uint32_t hash = InstrHash()(instr);
+      for (unsigned i = hash & mask();; i = (i + 1) & mask()) {
+         entry& e = entries[i];
+         if (!e.instr) {
+            e = entry{instr, block, hash};
+            num_entries++;
+            return std::make_pair(&e, true);
+         }
+         if (e.hash == hash && InstrPred()(e.instr, instr))
+            return std::make_pair(&e, false);
+      }
+   }
+
+   /* Removes the entry which points to exactly this instruction. */
+   void erase(Instruction* instr)
+   {
+      unsigned i = InstrHash()(instr) & mask();
+      while (entries[i].instr != instr) {
+         assert(entries[i].instr);
+         i = (i + 1) & mask();
+      }
+
+      /* shift back following entries which would become unreachable */
+      unsigned j = i;
+      while (true) {
+         j = (j + 1) & mask();
+         if (!entries[j].instr)
+            break;
+         unsigned home = entries[j].hash & mask();
+         /* move if home is cyclically outside of (i, j] */
+         if ((j > i && (home <= i || home > j)) ||
+             (j < i && (home <= i && home > j))) {
+            entries[i] = entries[j];
+            i = j;
+         }
+      }
+      entries[i] = entry{};
+      num_entries--;
+   }
+
+   /* Replaces the instruction of an entry by one with an equal expression. */
+   void replace(Instruction* old_instr, Instruction* instr, uint32_t block)
+   {
+      unsigned i = InstrHash()(old_instr) & mask();
+      while (entries[i].instr != old_instr) {
+         assert(entries[i].instr);
+         i = (i + 1) & mask();
+      }
+      entries[i].instr = instr;
+      entries[i].block = block;
+   }
+
+private:
+   unsigned mask() const { return entries.size() - 1; }
+
+   void grow()
+   {
+      std::vector<entry> old = std::move(entries);
+      entries = std::vector<entry>(old.size() * 2);
+      for (entry& e : old) {
+         if (!e.instr)
+            continue;
+         unsigned i = e.hash & mask();
+         while (entries[i].instr)
+            i = (i + 1) & mask();
+         entries[i] = e;
+      }
+   }
+
+   std::vector<entry> entries;
+   unsigned num_entries = 0;
+};
+
+/* Records the changes made to the expression set while processing a block,
+ * so that they can be reverted when leaving the block's dominator subtree.
+ */
+struct expr_undo {
+   Instruction* instr;
+   Instruction* shadowed; /* entry which instr replaced, if any */
+   uint32_t shadowed_block;
+};
 
 struct vn_ctx {
    Program* program;
    expr_set expr_values;
    std::map<uint32_t, Temp> renames;
 
+   /* blocks on the dominator tree path to the current block, together with
+    * the size of the undo log before they were processed */
+   std::vector<std::pair<uint32_t, size_t>> dom_stack;
+   std::vector<expr_undo> undo_log;
+
    /* The exec id should be the same on the same level of control flow depth.
     * Together with the check for dominator relations, it is safe to assume
     * that the same exec_id also means the same execution mask.
@@ -342,12 +458,16 @@ struct vn_ctx {
     */
    uint32_t exec_id = 1;
 
-   vn_ctx(Program* program) : program(program) {
+   vn_ctx(Program* program) : program(program), expr_values(count_instructions(program)) {
       static_assert(sizeof(Temp) == 4, "Temp must fit in 32bits");
+   }
+
+   static unsigned count_instructions(Program* program)
+   {
       unsigned size = 0;
       for (Block& block : program->blocks)
          size += block.instructions.size();
-      expr_values.reserve(size);
+      return size;
    }
 };
 
@@ -396,15 +516,16 @@ void process_block(vn_ctx& ctx, Block& block)
       }
 
       instr->pass_flags = ctx.exec_id;
-      std::pair<expr_set::iterator, bool> res = ctx.expr_values.emplace(instr.get(), block.index);
+      std::pair<expr_set::entry*, bool> res = ctx.expr_values.emplace(instr.get(), block.index);
 
       /* if there was already an expression with the same value number */
       if (!res.second) {
-         Instruction* orig_instr = res.first->first;
+         Instruction* orig_instr = res.first->instr;
+         uint32_t orig_block = res.first->block;
          assert(instr->definitions.size() == orig_instr->definitions.size());
          /* check if the original instruction dominates the current one */
-         if (dominates(ctx, res.first->second, block.index) &&
-             ctx.program->blocks[res.first->second].fp_mode.canReplace(block.fp_mode)) {
+         if (dominates(ctx, orig_block, block.index) &&
+             ctx.program->blocks[orig_block].fp_mode.canReplace(block.fp_mode)) {
             for (unsigned i = 0; i < instr->definitions.size(); i++) {
                assert(instr->definitions[i].regClass() == orig_instr->definitions[i].regClass());
                assert(instr->definitions[i].isTemp());
@@ -419,11 +540,14 @@ void process_block(vn_ctx& ctx, Block& block)
                   orig_instr->definitions[i].setNUW(true);
             }
          } else {
-            ctx.expr_values.erase(res.first);
-            ctx.expr_values.emplace(instr.get(), block.index);
+            /* shadow the original expression until we leave this subtree */
+            res.first->instr = instr.get();
+            res.first->block = block.index;
+            ctx.undo_log.push_back({instr.get(), orig_instr, orig_block});
             new_instructions.emplace_back(std::move(instr));
          }
       } else {
+         ctx.undo_log.push_back({instr.get(), nullptr, 0});
          new_instructions.emplace_back(std::move(instr));
       }
    }
@@ -431,6 +555,32 @@ void process_block(vn_ctx& ctx, Block& block)
    block.instructions = std::move(new_instructions);
 }
 
+/* Removes the expressions of all blocks which don't dominate the given one,
+ * so that only values which are available are found.
+ */
+void leave_dominator_subtrees(vn_ctx& ctx, Block& block)
+{
+   while (!ctx.dom_stack.empty()) {
+      uint32_t parent = ctx.dom_stack.back().first;
+      int child = block.index;
+      while (child > (int) parent)
+         child = ctx.program->blocks[child].logical_idom;
+      if (child == (int) parent)
+         break;
+
+      size_t log_size = ctx.dom_stack.back().second;
+      while (ctx.undo_log.size() > log_size) {
+         expr_undo& undo = ctx.undo_log.back();
+         if (undo.shadowed)
+            ctx.expr_values.replace(undo.instr, undo.shadowed, undo.shadowed_block);
+         else
+            ctx.expr_values.erase(undo.instr);
+         ctx.undo_log.pop_back();
+      }
+      ctx.dom_stack.pop_back();
+   }
+}
+
 void rename_phi_operands(Block& block, std::map<uint32_t, Temp>& renames)
 {
    for (aco_ptr<Instruction>& phi : block.instructions) {
@@ -467,10 +617,13 @@ void value_numbering(Program* program)
          loop_headers.pop_back();
       }
 
-      if (block.logical_idom != -1)
+      if (block.logical_idom != -1) {
+         leave_dominator_subtrees(ctx, block);
+         ctx.dom_stack.emplace_back(block.index, ctx.undo_log.size());
          process_block(ctx, block);
-      else
+      } else {
          rename_phi_operands(block, ctx.renames);
+      }
 
       /* increment exec_id when entering nested control flow */
       if (block.kind & block_kind_branch ||
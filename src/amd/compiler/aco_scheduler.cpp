@@ -85,6 +85,9 @@ private:
 
 struct sched_ctx {
    int16_t num_waves;
+   /* the current block uses at most half of the registers available at
+    * num_waves, so memory instructions can be scheduled more aggressively */
+   bool low_pressure;
    int16_t last_SMEM_stall;
    int last_SMEM_dep_idx;
    MoveState mv;
@@ -531,6 +534,11 @@ void schedule_SMEM(sched_ctx& ctx, Block* block,
    int max_moves = SMEM_MAX_MOVES;
    int16_t k = 0;
 
+   if (ctx.low_pressure) {
+      window_size *= 2;
+      max_moves *= 2;
+   }
+
    /* don't move s_memtime/s_memrealtime */
    if (current->opcode == aco_opcode::s_memtime || current->opcode == aco_opcode::s_memrealtime)
       return;
@@ -662,6 +670,12 @@ void schedule_VMEM(sched_ctx& ctx, Block* block,
    int clause_max_grab_dist = VMEM_CLAUSE_MAX_GRAB_DIST;
    int16_t k = 0;
 
+   if (ctx.low_pressure) {
+      window_size *= 2;
+      max_moves *= 2;
+      clause_max_grab_dist *= 2;
+   }
+
    /* first, check if we have instructions before current to move down */
    hazard_query indep_hq;
    hazard_query clause_hq;
@@ -844,6 +858,8 @@ void schedule_block(sched_ctx& ctx, Program *program, Block* block, live& live_v
    ctx.last_SMEM_stall = INT16_MIN;
    ctx.mv.block = block;
    ctx.mv.register_demand = live_vars.register_demand[block->index].data();
+   ctx.low_pressure = block->register_demand.vgpr <= ctx.mv.max_registers.vgpr / 2 &&
+                      block->register_demand.sgpr <= ctx.mv.max_registers.sgpr / 2;
 
    /* go through all instructions and find memory loads */
    for (unsigned idx = 0; idx < block->instructions.size(); idx++) {
@@ -910,6 +926,9 @@ void schedule_program(Program *program, live& live_vars)
    else
       ctx.num_waves = 7;
    ctx.num_waves = std::max<uint16_t>(ctx.num_waves, program->min_waves);
+   /* max_waves includes the occupancy limits imposed by the workgroup size
+    * and LDS usage: targeting more waves than that only sacrifices latency
+    * hiding without any gain, so use the registers available at max_waves. */
    ctx.num_waves = std::min<uint16_t>(ctx.num_waves, program->max_waves);
 
    assert(ctx.num_waves > 0 && ctx.num_waves <= program->num_waves);
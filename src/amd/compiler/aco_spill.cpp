@@ -1071,6 +1071,9 @@ void process_block(spill_ctx& ctx, unsigned block_idx, Block* block,
    std::vector<std::map<Temp, uint32_t>> local_next_use_distance;
    std::vector<aco_ptr<Instruction>> instructions;
    unsigned idx = 0;
+   /* Variables reloaded in this block, whose spill slot still holds their
+    * value: spilling them again only needs to split the live range. */
+   std::map<Temp, uint32_t> reloaded_spills;
 
    /* phis are handled separetely */
    while (block->instructions[idx]->opcode == aco_opcode::p_phi ||
@@ -1110,6 +1113,8 @@ void process_block(spill_ctx& ctx, unsigned block_idx, Block* block,
          Temp new_tmp = {ctx.program->allocateId(), op.regClass()};
          ctx.renames[block_idx][op.getTemp()] = new_tmp;
          reloads[new_tmp] = std::make_pair(op.getTemp(), current_spills[op.getTemp()]);
+         if (!ctx.remat.count(op.getTemp()))
+            reloaded_spills[op.getTemp()] = current_spills[op.getTemp()];
          current_spills.erase(op.getTemp());
          op.setTemp(new_tmp);
          spilled_registers -= new_tmp;
@@ -1157,6 +1162,17 @@ void process_block(spill_ctx& ctx, unsigned block_idx, Block* block,
             }
 
             assert(distance != 0 && distance > idx);
+
+            /* The value of a reloaded variable is still in its spill slot,
+             * so it doesn't have to be stored again. */
+            auto reloaded = reloaded_spills.find(to_spill);
+            if (reloaded != reloaded_spills.end()) {
+               current_spills[to_spill] = reloaded->second;
+               spilled_registers += to_spill;
+               reloaded_spills.erase(reloaded);
+               continue;
+            }
+
             uint32_t spill_id = ctx.allocate_spill_id(to_spill.regClass());
 
             /* add interferences with currently spilled variables */
@@ -1164,6 +1180,9 @@ void process_block(spill_ctx& ctx, unsigned block_idx, Block* block,
                ctx.add_interference(spill_id, pair.second);
             for (std::pair<Temp, std::pair<Temp, uint32_t>> pair : reloads)
                ctx.add_interference(spill_id, pair.second.second);
+            /* keep the slots of reloaded variables intact */
+            for (std::pair<Temp, uint32_t> pair : reloaded_spills)
+               ctx.add_interference(spill_id, pair.second);
 
             current_spills[to_spill] = spill_id;
             spilled_registers += to_spill;
@@ -1358,6 +1377,47 @@ Temp load_scratch_resource(spill_ctx& ctx, Temp& scratch_offset,
                      Operand(rsrc_conf));
 }
 
+Temp load_lds_spill_address(Builder& bld, unsigned wave_size)
+{
+   /* each lane of the wave owns one dword per spill slot */
+   Temp lane_id = bld.vop3(aco_opcode::v_mbcnt_lo_u32_b32, bld.def(v1), Operand((uint32_t) -1), Operand(0u));
+   if (wave_size == 64) {
+      if (bld.program->chip_class <= GFX7)
+         lane_id = bld.vop2(aco_opcode::v_mbcnt_hi_u32_b32, bld.def(v1), Operand((uint32_t) -1), lane_id);
+      else
+         lane_id = bld.vop3(aco_opcode::v_mbcnt_hi_u32_b32_e64, bld.def(v1), Operand((uint32_t) -1), lane_id);
+   }
+   return bld.vop2(aco_opcode::v_lshlrev_b32, bld.def(v1), Operand(2u), lane_id);
+}
+
+/* LDS instructions only use m0 as the size limit before GFX9 */
+Temp load_lds_spill_m0(Builder& bld)
+{
+   if (bld.program->chip_class >= GFX9)
+      return Temp();
+   return bld.sopk(aco_opcode::s_movk_i32, bld.def(s1, m0), 0xffff);
+}
+
+void spill_vgpr_to_lds(Builder& bld, Temp addr, Temp m, Temp data, unsigned offset)
+{
+   Instruction *instr;
+   if (m == Temp())
+      instr = bld.ds(aco_opcode::ds_write_b32, addr, data, offset);
+   else
+      instr = bld.ds(aco_opcode::ds_write_b32, addr, data, bld.m0(m), offset);
+   static_cast<DS_instruction *>(instr)->sync = memory_sync_info(storage_vgpr_spill, semantic_private);
+}
+
+void reload_vgpr_from_lds(Builder& bld, Definition def, Temp addr, Temp m, unsigned offset)
+{
+   Instruction *instr;
+   if (m == Temp())
+      instr = bld.ds(aco_opcode::ds_read_b32, def, addr, offset);
+   else
+      instr = bld.ds(aco_opcode::ds_read_b32, def, addr, bld.m0(m), offset);
+   static_cast<DS_instruction *>(instr)->sync = memory_sync_info(storage_vgpr_spill, semantic_private);
+}
+
 void add_interferences(spill_ctx& ctx, std::vector<bool>& is_assigned,
                        std::vector<uint32_t>& slots, std::vector<bool>& slots_used,
                        unsigned id)
@@ -1456,7 +1516,7 @@ void assign_spill_slots_helper(spill_ctx& ctx, RegType type,
    *num_slots = slots_used.size();
 }
 
-void assign_spill_slots(spill_ctx& ctx, unsigned spills_to_vgpr) {
+void assign_spill_slots(spill_ctx& ctx, unsigned spills_to_vgpr, bool can_spill_to_lds) {
    std::vector<uint32_t> slots(ctx.interferences.size());
    std::vector<bool> is_assigned(ctx.interferences.size());
 
@@ -1500,6 +1560,12 @@ void assign_spill_slots(spill_ctx& ctx, unsigned spills_to_vgpr) {
    std::vector<Temp> vgpr_spill_temps((sgpr_spill_slots + ctx.wave_size - 1) / ctx.wave_size);
    assert(vgpr_spill_temps.size() <= spills_to_vgpr);
 
+   /* spill vgprs to LDS instead of scratch if the workgroup leaves enough room for it */
+   unsigned lds_spill_base = ctx.program->config->lds_size * ctx.program->lds_alloc_granule;
+   unsigned lds_spill_bytes = vgpr_spill_slots * ctx.wave_size * 4;
+   bool spill_to_lds = can_spill_to_lds && vgpr_spill_slots &&
+                       lds_spill_base + lds_spill_bytes <= ctx.program->lds_limit;
+
    /* replace pseudo instructions with actual hardware instructions */
    Temp scratch_offset = ctx.program->scratch_offset, scratch_rsrc = Temp();
    unsigned last_top_level_block_idx = 0;
@@ -1556,6 +1622,9 @@ void assign_spill_slots(spill_ctx& ctx, unsigned spills_to_vgpr) {
       std::vector<aco_ptr<Instruction>> instructions;
       instructions.reserve(block.instructions.size());
       Builder bld(ctx.program, &instructions);
+
+      /* the LDS spill address and m0 are emitted once per block, on first use */
+      Temp lds_addr = Temp(), lds_m0 = Temp();
       for (it = block.instructions.begin(); it != block.instructions.end(); ++it) {
 
          if ((*it)->opcode == aco_opcode::p_spill) {
@@ -1565,6 +1634,28 @@ void assign_spill_slots(spill_ctx& ctx, unsigned spills_to_vgpr) {
                /* never reloaded, so don't spill */
             } else if (!is_assigned[spill_id]) {
                unreachable("No spill slot assigned for spill id");
+            } else if (ctx.interferences[spill_id].first.type() == RegType::vgpr && spill_to_lds) {
+               /* spill vgpr to LDS */
+               ctx.program->config->spilled_vgprs += (*it)->operands[0].size();
+               unsigned offset = lds_spill_base + slots[spill_id] * ctx.wave_size * 4;
+               assert((*it)->operands[0].isTemp());
+               Temp temp = (*it)->operands[0].getTemp();
+               assert(temp.type() == RegType::vgpr && !temp.is_linear());
+               if (lds_addr == Temp()) {
+                  lds_addr = load_lds_spill_address(bld, ctx.wave_size);
+                  lds_m0 = load_lds_spill_m0(bld);
+               }
+               if (temp.size() > 1) {
+                  Instruction* split{create_instruction<Pseudo_instruction>(aco_opcode::p_split_vector, Format::PSEUDO, 1, temp.size())};
+                  split->operands[0] = Operand(temp);
+                  for (unsigned i = 0; i < temp.size(); i++)
+                     split->definitions[i] = bld.def(v1);
+                  bld.insert(split);
+                  for (unsigned i = 0; i < temp.size(); i++)
+                     spill_vgpr_to_lds(bld, lds_addr, lds_m0, split->definitions[i].getTemp(), offset + i * ctx.wave_size * 4);
+               } else {
+                  spill_vgpr_to_lds(bld, lds_addr, lds_m0, temp, offset);
+               }
             } else if (ctx.interferences[spill_id].first.type() == RegType::vgpr) {
                /* spill vgpr */
                ctx.program->config->spilled_vgprs += (*it)->operands[0].size();
@@ -1638,6 +1729,26 @@ void assign_spill_slots(spill_ctx& ctx, unsigned spills_to_vgpr) {
 
             if (!is_assigned[spill_id]) {
                unreachable("No spill slot assigned for spill id");
+            } else if (ctx.interferences[spill_id].first.type() == RegType::vgpr && spill_to_lds) {
+               /* reload vgpr from LDS */
+               unsigned offset = lds_spill_base + slots[spill_id] * ctx.wave_size * 4;
+               Definition def = (*it)->definitions[0];
+               if (lds_addr == Temp()) {
+                  lds_addr = load_lds_spill_address(bld, ctx.wave_size);
+                  lds_m0 = load_lds_spill_m0(bld);
+               }
+               if (def.size() > 1) {
+                  Instruction* vec{create_instruction<Pseudo_instruction>(aco_opcode::p_create_vector, Format::PSEUDO, def.size(), 1)};
+                  vec->definitions[0] = def;
+                  for (unsigned i = 0; i < def.size(); i++) {
+                     Temp tmp = bld.tmp(v1);
+                     vec->operands[i] = Operand(tmp);
+                     reload_vgpr_from_lds(bld, Definition(tmp), lds_addr, lds_m0, offset + i * ctx.wave_size * 4);
+                  }
+                  bld.insert(vec);
+               } else {
+                  reload_vgpr_from_lds(bld, def, lds_addr, lds_m0, offset);
+               }
             } else if (ctx.interferences[spill_id].first.type() == RegType::vgpr) {
                /* reload vgpr */
                uint32_t spill_slot = slots[spill_id];
@@ -1708,8 +1819,14 @@ void assign_spill_slots(spill_ctx& ctx, unsigned spills_to_vgpr) {
       block.instructions = std::move(instructions);
    }
 
-   /* update required scratch memory */
-   ctx.program->config->scratch_bytes_per_wave += align(vgpr_spill_slots * 4 * ctx.program->wave_size, 1024);
+   /* update required scratch or LDS memory */
+   if (spill_to_lds) {
+      ctx.program->config->lds_size = DIV_ROUND_UP(lds_spill_base + lds_spill_bytes, ctx.program->lds_alloc_granule);
+      if (ctx.program->collect_statistics)
+         ctx.program->statistics[statistic_lds_spill_bytes] = lds_spill_bytes;
+   } else {
+      ctx.program->config->scratch_bytes_per_wave += align(vgpr_spill_slots * 4 * ctx.program->wave_size, 1024);
+   }
 
    /* SSA elimination inserts copies for logical phis right before p_logical_end
     * So if a linear vgpr is used between that p_logical_end and the branch,
@@ -1789,6 +1906,17 @@ void spill(Program* program, live& live_vars, const struct radv_nir_compiler_opt
    int spills_to_vgpr = (program->max_reg_demand.sgpr - register_target.sgpr + program->wave_size - 1 + 32) / program->wave_size;
    register_target.vgpr = program->vgpr_limit - spills_to_vgpr;
 
+   /* Compute workgroups which consist of a single wave can spill vgprs to unused
+    * LDS, addressed by the lane index alone. This needs one vgpr for the address,
+    * which is only reserved if vgprs have to be spilled at all. */
+   bool can_spill_to_lds = program->stage == compute_cs &&
+                           program->workgroup_size <= program->wave_size &&
+                           program->max_reg_demand.vgpr > register_target.vgpr &&
+                           program->config->lds_size * program->lds_alloc_granule +
+                           program->wave_size * 4 <= program->lds_limit;
+   if (can_spill_to_lds)
+      register_target.vgpr -= 1;
+
    /* initialize ctx */
    spill_ctx ctx(register_target, program, live_vars.register_demand);
    compute_global_next_uses(ctx);
@@ -1799,7 +1927,7 @@ void spill(Program* program, live& live_vars, const struct radv_nir_compiler_opt
       spill_block(ctx, i);
 
    /* assign spill slots and DCE rematerialized code */
-   assign_spill_slots(ctx, spills_to_vgpr);
+   assign_spill_slots(ctx, spills_to_vgpr, can_spill_to_lds);
 
    /* update live variable information */
    live_vars = live_var_analysis(program, options);
@@ -24,9 +24,66 @@
 #include "aco_ir.h"
 #include "util/crc32.h"
 
+#include <array>
+#include <unordered_map>
+
 namespace aco {
 
-/* sgpr_presched/vgpr_presched */
+static unsigned get_result_latency(const Instruction *instr)
+{
+   if (instr->isVMEM() || instr->isFlatOrGlobal())
+      return 320;
+   else if (instr->format == Format::SMEM)
+      return 40;
+   else if (instr->format == Format::DS)
+      return 64;
+   else
+      return 4;
+}
+
+/* Estimates the cycles spent in a program before register allocation: every
+ * instruction issues in 4 cycles and waits for the results of its operands.
+ * Stalls on memory results are assumed to be hidden by the other waves on the
+ * SIMD, so only the part not covered by them is counted. */
+static unsigned estimate_latency(Program *program)
+{
+   unsigned waves = std::max<unsigned>(program->num_waves, 1);
+   unsigned total = 0;
+
+   std::unordered_map<uint32_t, unsigned> ready;
+   for (Block& block : program->blocks) {
+      unsigned cycle = 0;
+      ready.clear();
+
+      for (aco_ptr<Instruction>& instr : block.instructions) {
+         unsigned issue = cycle;
+         for (const Operand& op : instr->operands) {
+            if (!op.isTemp())
+               continue;
+            auto it = ready.find(op.tempId());
+            if (it != ready.end() && it->second > issue)
+               issue = it->second;
+         }
+
+         /* the other waves issue while this one is stalled */
+         cycle += (issue - cycle) / waves;
+
+         unsigned latency = get_result_latency(instr.get());
+         for (const Definition& def : instr->definitions) {
+            if (def.isTemp())
+               ready[def.tempId()] = cycle + latency;
+         }
+         cycle += 4;
+      }
+
+      /* assume loops execute 4 times */
+      total += cycle << (block.loop_nest_depth * 2);
+   }
+
+   return total;
+}
+
+/* sgpr_presched/vgpr_presched/latency_presched */
 void collect_presched_stats(Program *program)
 {
    RegisterDemand presched_demand;
@@ -34,14 +91,232 @@ void collect_presched_stats(Program *program)
       presched_demand.update(block.register_demand);
    program->statistics[statistic_sgpr_presched] = presched_demand.sgpr;
    program->statistics[statistic_vgpr_presched] = presched_demand.vgpr;
+   program->statistics[statistic_latency_presched] = estimate_latency(program);
 }
 
-/* instructions/branches/vmem_clauses/smem_clauses/cycles */
+/* latency_postsched */
+void collect_postsched_stats(Program *program)
+{
+   program->statistics[statistic_latency_postsched] = estimate_latency(program);
+}
+
+namespace {
+
+struct perf_info {
+   unsigned latency; /* cycles until the result can be used by the next instruction */
+   unsigned issue; /* cycles the SIMD is busy issuing the instruction */
+};
+
+bool is_transcendental(aco_opcode op)
+{
+   switch (op) {
+   case aco_opcode::v_rcp_f32:
+   case aco_opcode::v_rcp_iflag_f32:
+   case aco_opcode::v_rcp_clamp_f32:
+   case aco_opcode::v_rsq_f32:
+   case aco_opcode::v_sqrt_f32:
+   case aco_opcode::v_exp_f32:
+   case aco_opcode::v_exp_legacy_f32:
+   case aco_opcode::v_log_f32:
+   case aco_opcode::v_log_legacy_f32:
+   case aco_opcode::v_sin_f32:
+   case aco_opcode::v_cos_f32:
+   case aco_opcode::v_rcp_f16:
+   case aco_opcode::v_rsq_f16:
+   case aco_opcode::v_sqrt_f16:
+   case aco_opcode::v_exp_f16:
+   case aco_opcode::v_log_f16:
+   case aco_opcode::v_sin_f16:
+   case aco_opcode::v_cos_f16:
+   case aco_opcode::v_rcp_f64:
+   case aco_opcode::v_rsq_f64:
+   case aco_opcode::v_sqrt_f64:
+   case aco_opcode::v_mul_lo_u32:
+   case aco_opcode::v_mul_hi_u32:
+   case aco_opcode::v_mul_hi_i32:
+   case aco_opcode::v_mad_u64_u32:
+   case aco_opcode::v_mad_i64_i32:
+      return true;
+   default:
+      return false;
+   }
+}
+
+bool is_dword64_valu(Instruction *instr)
+{
+   for (const Operand& op : instr->operands) {
+      if (op.isTemp() && op.getTemp().type() == RegType::vgpr && op.size() == 2)
+         return true;
+   }
+   for (const Definition& def : instr->definitions) {
+      if (def.getTemp().type() == RegType::vgpr && def.size() == 2)
+         return true;
+   }
+   return false;
+}
+
+/* Rate of double precision operations relative to single precision */
+unsigned get_dword64_rate(Program *program)
+{
+   switch (program->family) {
+   case CHIP_TAHITI:
+      return 4;
+   case CHIP_HAWAII:
+   case CHIP_VEGA20:
+   case CHIP_ARCTURUS:
+      return 2;
+   default:
+      return 16;
+   }
+}
+
+perf_info get_perf_info(Program *program, Instruction *instr)
+{
+   /* GFX10 issues wave32 in a single pass and wave64 in two passes, while
+    * GCN issues every wave over 4 cycles on a SIMD16 */
+   bool gfx10 = program->chip_class >= GFX10;
+   unsigned valu_issue = gfx10 ? program->wave_size / 32 : 4;
+   unsigned salu_issue = gfx10 ? 1 : 4;
+
+   if (instr->isVALU()) {
+      unsigned issue = valu_issue;
+      if (is_transcendental(instr->opcode))
+         issue *= 4;
+      else if (is_dword64_valu(instr))
+         issue *= get_dword64_rate(program);
+      return {issue + (gfx10 ? 4u : 0u), issue};
+   } else if (instr->isSALU()) {
+      if (instr->format == Format::SOPP && instr->opcode == aco_opcode::s_nop)
+         return {0, (static_cast<SOPP_instruction*>(instr)->imm + 1) * salu_issue};
+      return {gfx10 ? 2u : 4u, salu_issue};
+   } else if (instr->format == Format::PSEUDO) {
+      return {0, 0};
+   }
+
+   return {get_result_latency(instr), salu_issue};
+}
+
+enum wait_counter {
+   wait_counter_vm,
+   wait_counter_lgkm,
+   wait_counter_exp,
+   wait_counter_vs,
+   num_wait_counters,
+};
+
+/* Estimates the cycles a single wave spends in straight-line code. Results of
+ * ALU instructions are tracked per register, memory results complete out of
+ * band and are only waited for by s_waitcnt. */
+class cycle_estimator {
+public:
+   cycle_estimator(Program *program_) : program(program_)
+   {
+      reg_ready.fill(0);
+   }
+
+   void add(Instruction *instr);
+
+   unsigned cycle = 0; /* issue and stall cycles, in program order */
+   unsigned issue_cycles = 0; /* cycles the SIMD is busy with this wave */
+
+private:
+   void wait(wait_counter counter, unsigned count);
+   void wait(const wait_imm& imm);
+
+   Program *program;
+   std::array<unsigned, 512> reg_ready;
+   std::vector<unsigned> pending[num_wait_counters];
+};
+
+void cycle_estimator::wait(wait_counter counter, unsigned count)
+{
+   std::vector<unsigned>& queue = pending[counter];
+   if (queue.size() <= count)
+      return;
+
+   /* memory instructions of different types may complete out of order */
+   unsigned done = queue.size() - count;
+   for (unsigned i = 0; i < done; i++)
+      cycle = std::max(cycle, queue[i]);
+   queue.erase(queue.begin(), std::next(queue.begin(), done));
+}
+
+void cycle_estimator::wait(const wait_imm& imm)
+{
+   if (imm.vm != wait_imm::unset_counter)
+      wait(wait_counter_vm, imm.vm);
+   if (imm.lgkm != wait_imm::unset_counter)
+      wait(wait_counter_lgkm, imm.lgkm);
+   if (imm.exp != wait_imm::unset_counter)
+      wait(wait_counter_exp, imm.exp);
+   if (imm.vs != wait_imm::unset_counter)
+      wait(wait_counter_vs, imm.vs);
+}
+
+void cycle_estimator::add(Instruction *instr)
+{
+   if (instr->opcode == aco_opcode::s_waitcnt) {
+      wait(wait_imm(program->chip_class, static_cast<SOPP_instruction*>(instr)->imm));
+   } else if (instr->opcode == aco_opcode::s_waitcnt_vscnt) {
+      wait(wait_counter_vs, static_cast<SOPK_instruction*>(instr)->imm);
+   }
+
+   /* wait for the ALU results of the operands */
+   for (const Operand& op : instr->operands) {
+      if (op.isConstant() || op.isUndefined())
+         continue;
+      for (unsigned i = 0; i < op.size() && op.physReg() + i < reg_ready.size(); i++)
+         cycle = std::max(cycle, reg_ready[op.physReg() + i]);
+   }
+
+   perf_info perf = get_perf_info(program, instr);
+   unsigned start = cycle;
+   cycle += perf.issue;
+   issue_cycles += perf.issue;
+
+   bool is_mem = instr->isVMEM() || instr->isFlatOrGlobal() ||
+                 instr->format == Format::SMEM || instr->format == Format::DS ||
+                 instr->format == Format::EXP;
+   if (is_mem) {
+      unsigned done = start + perf.latency;
+      if (instr->format == Format::SMEM || instr->format == Format::DS ||
+          instr->isFlatOrGlobal())
+         pending[wait_counter_lgkm].push_back(done);
+      if (instr->format == Format::EXP)
+         pending[wait_counter_exp].push_back(done);
+      if (instr->isVMEM() || instr->isFlatOrGlobal()) {
+         if (program->chip_class >= GFX10 && instr->definitions.empty())
+            pending[wait_counter_vs].push_back(done);
+         else
+            pending[wait_counter_vm].push_back(done);
+      }
+      return;
+   }
+   if (instr->opcode == aco_opcode::s_sendmsg) {
+      pending[wait_counter_lgkm].push_back(start + perf.latency);
+      return;
+   }
+
+   for (const Definition& def : instr->definitions) {
+      for (unsigned i = 0; i < def.size() && def.physReg() + i < reg_ready.size(); i++)
+         reg_ready[def.physReg() + i] = start + perf.latency;
+   }
+}
+
+} /* end namespace */
+
+/* instructions/branches/vmem_clauses/smem_clauses/cycles/latency/inv_throughput */
 void collect_preasm_stats(Program *program)
 {
+   /* the state is carried over from the previous block in program order */
+   cycle_estimator estimator(program);
+   uint64_t latency = 0, busy = 0;
+
    for (Block& block : program->blocks) {
       std::set<Temp> vmem_clause_res;
       std::set<Temp> smem_clause_res;
+      unsigned block_start = estimator.cycle;
+      unsigned block_issue = estimator.issue_cycles;
 
       program->statistics[statistic_instructions] += block.instructions.size();
 
@@ -69,15 +344,27 @@ void collect_preasm_stats(Program *program)
             smem_clause_res.clear();
           }
 
-         /* TODO: this incorrectly assumes instructions always take 4 cycles */
-         /* assume loops execute 4 times (TODO: it would be nice to be able to consider loop unrolling) */
-         unsigned iter = 1 << (block.loop_nest_depth * 2);
-         program->statistics[statistic_cycles] += 4 * iter;
+         estimator.add(instr.get());
       }
 
       program->statistics[statistic_vmem_clauses] += vmem_clause_res.size();
       program->statistics[statistic_smem_clauses] += smem_clause_res.size();
+
+      /* assume loops execute 4 times (TODO: it would be nice to be able to consider loop unrolling) */
+      unsigned iter = 1 << (block.loop_nest_depth * 2);
+      latency += (uint64_t)(estimator.cycle - block_start) * iter;
+      busy += (uint64_t)(estimator.issue_cycles - block_issue) * iter;
    }
+
+   /* While a wave stalls, the other waves on the SIMD can issue. If the SIMD
+    * is full, a wave costs at least its own issue cycles and at least its
+    * share of the latency. */
+   unsigned waves = std::max<unsigned>(program->num_waves, 1);
+   uint64_t inv_throughput = std::max<uint64_t>(busy, latency / waves);
+
+   program->statistics[statistic_cycles] = std::min<uint64_t>(busy, UINT32_MAX);
+   program->statistics[statistic_latency] = std::min<uint64_t>(latency, UINT32_MAX);
+   program->statistics[statistic_inv_throughput] = std::min<uint64_t>(inv_throughput, UINT32_MAX);
 }
 
 void collect_postasm_stats(Program *program, const std::vector<uint32_t>& code)
@@ -26,6 +26,10 @@
 #define ACO_UTIL_H
 
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iterator>
 
 namespace aco {
@@ -228,6 +232,99 @@ private:
    size_type length{ 0 };     //!> Size of the span
 };
 
+/*! \brief      Definition of a monotonic buffer resource
+*
+*   \details    A monotonic buffer resource hands out memory from a chain of
+*               large blocks and never returns individual allocations. All
+*               memory is released at once when the resource is destroyed.
+*               This makes allocation a pointer bump and deallocation free,
+*               which suits objects that live as long as the owning Program.
+*/
+class monotonic_buffer_resource {
+public:
+   /*! \brief                 Constructor taking the size of the first block
+   *   \param[in] size        Size in bytes of the first block (excluding the header)
+   */
+   explicit monotonic_buffer_resource(size_t size = initial_size)
+   {
+      buffer = create_block(nullptr, size);
+   }
+
+   ~monotonic_buffer_resource()
+   {
+      release();
+      free(buffer);
+   }
+
+   monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+   monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) = delete;
+
+   /*! \brief                 Allocates zero-initialized memory from the current block
+   *   \param[in] size        Size in bytes of the allocation
+   *   \param[in] alignment   Alignment of the allocation, must be a power of two
+   *   \return                Pointer to the allocated memory
+   */
+   void* allocate(size_t size, size_t alignment)
+   {
+      assert(alignment && (alignment & (alignment - 1)) == 0);
+      buffer->current_idx = align(buffer->current_idx, alignment);
+      if (buffer->current_idx + size > buffer->data_size) {
+         /* grow geometrically, but make sure the request fits */
+         size_t new_size = buffer->data_size * 2;
+         while (new_size < size + alignment)
+            new_size *= 2;
+         buffer = create_block(buffer, new_size);
+         buffer->current_idx = align(buffer->current_idx, alignment);
+      }
+
+      void* ptr = &buffer->data[buffer->current_idx];
+      buffer->current_idx += size;
+      return ptr;
+   }
+
+   /*! \brief                 Frees all blocks except the first one, which is reset
+   */
+   void release()
+   {
+      while (buffer->next) {
+         Buffer* next = buffer->next;
+         free(buffer);
+         buffer = next;
+      }
+      buffer->current_idx = 0;
+      memset(buffer->data, 0, buffer->data_size);
+   }
+
+private:
+   static constexpr size_t initial_size = 65536 - 64;
+
+   struct Buffer {
+      Buffer* next;
+      size_t current_idx;
+      size_t data_size;
+      alignas(16) uint8_t data[];
+   };
+
+   static size_t align(size_t offset, size_t alignment)
+   {
+      return (offset + alignment - 1) & ~(alignment - 1);
+   }
+
+   static Buffer* create_block(Buffer* next, size_t size)
+   {
+      /* calloc so that allocate() can hand out zeroed memory */
+      Buffer* block = (Buffer*) calloc(1, sizeof(Buffer) + size);
+      if (!block)
+         abort();
+      block->next = next;
+      block->current_idx = 0;
+      block->data_size = size;
+      return block;
+   }
+
+   Buffer* buffer;
+};
+
 } // namespace aco
 
 #endif // ACO_UTIL_H
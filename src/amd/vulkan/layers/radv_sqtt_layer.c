@@ -21,7 +21,11 @@
  * IN THE SOFTWARE.
  */
 
+#include <inttypes.h>
+#include <unistd.h>
+
 #include "radv_private.h"
+#include "util/os_time.h"
 
 /**
  * Identifiers for RGP SQ thread-tracing markers (Table 1)
@@ -571,33 +575,91 @@ radv_describe_layout_transition(struct radv_cmd_buffer *cmd_buffer,
 	cmd_buffer->state.num_layout_transitions++;
 }
 
+/* Minimum delay between two dumps of frame time spikes, so that a stutter
+ * lasting a few seconds doesn't fill /tmp with captures.
+ */
+#define RADV_THREAD_TRACE_SPIKE_INTERVAL_NS (10ll * 1000000000ll)
+
+static bool
+radv_thread_trace_triggered(struct radv_device *device)
+{
+	const char *file = device->thread_trace_trigger_file;
+
+	if (!file || access(file, F_OK) != 0)
+		return false;
+
+	/* Remove the trigger file so that only one frame is captured. */
+	if (unlink(file) != 0) {
+		fprintf(stderr, "RADV: could not remove the thread trace "
+				"trigger file '%s', ignoring it.\n", file);
+		device->thread_trace_trigger_file = NULL;
+		return false;
+	}
+
+	return true;
+}
+
 /* TODO: Improve the way to trigger capture (overlay, etc). */
 static void
 radv_handle_thread_trace(VkQueue _queue)
 {
 	RADV_FROM_HANDLE(radv_queue, queue, _queue);
+	struct radv_device *device = queue->device;
 	static bool thread_trace_enabled = false;
+	static bool thread_trace_forced = false;
 	static uint64_t num_frames = 0;
+	static int64_t frame_start = 0;
+	static int64_t last_spike_dump = 0;
+	bool rolling = device->thread_trace_spike_ns > 0;
 
 	if (thread_trace_enabled) {
 		struct radv_thread_trace thread_trace = {};
+		int64_t now = os_time_get_nano();
+		bool dump = true;
 
 		radv_end_thread_trace(queue);
 		thread_trace_enabled = false;
 
+		/* In rolling mode, only keep the frames that took longer than
+		 * the threshold, rate limited.
+		 */
+		if (rolling && !thread_trace_forced) {
+			dump = (uint64_t)(now - frame_start) > device->thread_trace_spike_ns &&
+			       (!last_spike_dump ||
+				now - last_spike_dump > RADV_THREAD_TRACE_SPIKE_INTERVAL_NS);
+			if (dump) {
+				fprintf(stderr, "RADV: frame %"PRIu64" took %.2f ms, "
+					"dumping thread trace.\n", num_frames,
+					(now - frame_start) / 1000000.0);
+				last_spike_dump = now;
+			}
+		}
+		thread_trace_forced = false;
+
 		/* TODO: Do something better than this whole sync. */
 		radv_QueueWaitIdle(_queue);
 
-		if (radv_get_thread_trace(queue, &thread_trace))
+		if (dump && radv_get_thread_trace(queue, &thread_trace))
 			radv_dump_thread_trace(queue->device, &thread_trace);
-	} else {
-		if (num_frames == queue->device->thread_trace_start_frame) {
-			radv_begin_thread_trace(queue);
-			assert(!thread_trace_enabled);
-			thread_trace_enabled = true;
-		}
+	}
+
+	if (device->thread_trace_start_frame >= 0 &&
+	    num_frames == (uint64_t)device->thread_trace_start_frame)
+		thread_trace_forced = true;
+	if (radv_thread_trace_triggered(device))
+		thread_trace_forced = true;
+
+	if (rolling || thread_trace_forced) {
+		radv_begin_thread_trace(queue);
+		assert(!thread_trace_enabled);
+		thread_trace_enabled = true;
 	}
 	num_frames++;
+
+	/* The frame time excludes the wait above, which only exists because
+	 * of the capture itself.
+	 */
+	frame_start = os_time_get_nano();
 }
 
 VkResult sqtt_QueuePresentKHR(
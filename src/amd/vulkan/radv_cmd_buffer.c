@@ -336,6 +336,71 @@ enum ring_type radv_queue_family_to_ring(int f) {
 	}
 }
 
+static int
+radv_cmd_pool_upload_class(uint64_t size)
+{
+	if (!util_is_power_of_two_or_zero64(size) ||
+	    size < RADV_CMD_POOL_UPLOAD_MIN_SIZE)
+		return -1;
+
+	unsigned class = util_logbase2_64(size / RADV_CMD_POOL_UPLOAD_MIN_SIZE);
+	return class < RADV_CMD_POOL_UPLOAD_SIZE_CLASSES ? class : -1;
+}
+
+/* Gives an upload buffer of a command buffer being reset back to its pool.
+ * The command buffer isn't pending anymore at that point, so the buffer
+ * can be reused right away.
+ */
+static void
+radv_cmd_pool_release_upload(struct radv_device *device,
+			     struct radv_cmd_pool *pool,
+			     struct radv_cmd_buffer_upload *upload)
+{
+	int class = pool ? radv_cmd_pool_upload_class(upload->size) : -1;
+
+	if (class < 0 ||
+	    pool->upload_cache_count[class] >= RADV_CMD_POOL_UPLOAD_MAX_CACHED) {
+		device->ws->buffer_destroy(upload->upload_bo);
+		free(upload);
+		return;
+	}
+
+	list_add(&upload->list, &pool->upload_cache[class]);
+	pool->upload_cache_count[class]++;
+}
+
+static struct radv_cmd_buffer_upload *
+radv_cmd_pool_take_upload(struct radv_cmd_pool *pool, uint64_t size)
+{
+	int class = pool ? radv_cmd_pool_upload_class(size) : -1;
+
+	if (class < 0 || list_is_empty(&pool->upload_cache[class]))
+		return NULL;
+
+	struct radv_cmd_buffer_upload *upload =
+		list_first_entry(&pool->upload_cache[class],
+				 struct radv_cmd_buffer_upload, list);
+	list_del(&upload->list);
+	pool->upload_cache_count[class]--;
+
+	return upload;
+}
+
+static void
+radv_cmd_pool_free_upload_cache(struct radv_device *device,
+				struct radv_cmd_pool *pool)
+{
+	for (unsigned i = 0; i < RADV_CMD_POOL_UPLOAD_SIZE_CLASSES; i++) {
+		list_for_each_entry_safe(struct radv_cmd_buffer_upload, up,
+					 &pool->upload_cache[i], list) {
+			device->ws->buffer_destroy(up->upload_bo);
+			list_del(&up->list);
+			free(up);
+		}
+		pool->upload_cache_count[i] = 0;
+	}
+}
+
 static void
 radv_destroy_cmd_buffer(struct radv_cmd_buffer *cmd_buffer)
 {
@@ -406,9 +471,9 @@ radv_reset_cmd_buffer(struct radv_cmd_buffer *cmd_buffer)
 
 	list_for_each_entry_safe(struct radv_cmd_buffer_upload, up,
 				 &cmd_buffer->upload.list, list) {
-		cmd_buffer->device->ws->buffer_destroy(up->upload_bo);
 		list_del(&up->list);
-		free(up);
+		radv_cmd_pool_release_upload(cmd_buffer->device,
+					     cmd_buffer->pool, up);
 	}
 
 	cmd_buffer->push_constant_stages = 0;
@@ -472,29 +537,45 @@ radv_cmd_buffer_resize_upload_buf(struct radv_cmd_buffer *cmd_buffer,
 {
 	uint64_t new_size;
 	struct radeon_winsys_bo *bo;
-	struct radv_cmd_buffer_upload *upload;
+	struct radv_cmd_buffer_upload *upload, *cached;
 	struct radv_device *device = cmd_buffer->device;
+	uint8_t *map;
 
-	new_size = MAX2(min_needed, 16 * 1024);
+	new_size = MAX2(min_needed, RADV_CMD_POOL_UPLOAD_MIN_SIZE);
 	new_size = MAX2(new_size, 2 * cmd_buffer->upload.size);
 
-	bo = device->ws->buffer_create(device->ws,
-				       new_size, 4096,
-				       RADEON_DOMAIN_GTT,
-				       RADEON_FLAG_CPU_ACCESS|
-				       RADEON_FLAG_NO_INTERPROCESS_SHARING |
-				       RADEON_FLAG_32BIT |
-				       RADEON_FLAG_GTT_WC,
-				       RADV_BO_PRIORITY_UPLOAD_BUFFER);
+	/* Stick to the size classes of the pool cache when possible. */
+	if (radv_cmd_pool_upload_class(util_next_power_of_two64(new_size)) >= 0)
+		new_size = util_next_power_of_two64(new_size);
 
-	if (!bo) {
-		cmd_buffer->record_result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
-		return false;
+	cached = radv_cmd_pool_take_upload(cmd_buffer->pool, new_size);
+	if (cached) {
+		bo = cached->upload_bo;
+		map = cached->map;
+	} else {
+		bo = device->ws->buffer_create(device->ws,
+					       new_size, 4096,
+					       RADEON_DOMAIN_GTT,
+					       RADEON_FLAG_CPU_ACCESS|
+					       RADEON_FLAG_NO_INTERPROCESS_SHARING |
+					       RADEON_FLAG_32BIT |
+					       RADEON_FLAG_GTT_WC,
+					       RADV_BO_PRIORITY_UPLOAD_BUFFER);
+
+		if (!bo) {
+			cmd_buffer->record_result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+			return false;
+		}
+
+		map = NULL;
 	}
 
 	radv_cs_add_buffer(device->ws, cmd_buffer->cs, bo);
 	if (cmd_buffer->upload.upload_bo) {
-		upload = malloc(sizeof(*upload));
+		/* Reuse the entry of the cached buffer, if any, to track the
+		 * current one.
+		 */
+		upload = cached ? cached : malloc(sizeof(*upload));
 
 		if (!upload) {
 			cmd_buffer->record_result = VK_ERROR_OUT_OF_HOST_MEMORY;
@@ -504,12 +585,14 @@ radv_cmd_buffer_resize_upload_buf(struct radv_cmd_buffer *cmd_buffer,
 
 		memcpy(upload, &cmd_buffer->upload, sizeof(*upload));
 		list_add(&upload->list, &cmd_buffer->upload.list);
+	} else {
+		free(cached);
 	}
 
 	cmd_buffer->upload.upload_bo = bo;
 	cmd_buffer->upload.size = new_size;
 	cmd_buffer->upload.offset = 0;
-	cmd_buffer->upload.map = device->ws->buffer_map(cmd_buffer->upload.upload_bo);
+	cmd_buffer->upload.map = map ? map : device->ws->buffer_map(cmd_buffer->upload.upload_bo);
 
 	if (!cmd_buffer->upload.map) {
 		cmd_buffer->record_result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
@@ -4758,6 +4841,11 @@ VkResult radv_CreateCommandPool(
 	list_inithead(&pool->cmd_buffers);
 	list_inithead(&pool->free_cmd_buffers);
 
+	for (unsigned i = 0; i < RADV_CMD_POOL_UPLOAD_SIZE_CLASSES; i++) {
+		list_inithead(&pool->upload_cache[i]);
+		pool->upload_cache_count[i] = 0;
+	}
+
 	pool->queue_family_index = pCreateInfo->queueFamilyIndex;
 
 	*pCmdPool = radv_cmd_pool_to_handle(pool);
@@ -4787,15 +4875,18 @@ void radv_DestroyCommandPool(
 		radv_destroy_cmd_buffer(cmd_buffer);
 	}
 
+	radv_cmd_pool_free_upload_cache(device, pool);
+
 	vk_object_base_finish(&pool->base);
 	vk_free2(&device->vk.alloc, pAllocator, pool);
 }
 
 VkResult radv_ResetCommandPool(
-	VkDevice                                    device,
+	VkDevice                                    _device,
 	VkCommandPool                               commandPool,
 	VkCommandPoolResetFlags                     flags)
 {
+	RADV_FROM_HANDLE(radv_device, device, _device);
 	RADV_FROM_HANDLE(radv_cmd_pool, pool, commandPool);
 	VkResult result;
 
@@ -4806,14 +4897,18 @@ VkResult radv_ResetCommandPool(
 			return result;
 	}
 
+	if (flags & VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT)
+		radv_cmd_pool_free_upload_cache(device, pool);
+
 	return VK_SUCCESS;
 }
 
 void radv_TrimCommandPool(
-    VkDevice                                    device,
+    VkDevice                                    _device,
     VkCommandPool                               commandPool,
     VkCommandPoolTrimFlags                      flags)
 {
+	RADV_FROM_HANDLE(radv_device, device, _device);
 	RADV_FROM_HANDLE(radv_cmd_pool, pool, commandPool);
 
 	if (!pool)
@@ -4823,6 +4918,8 @@ void radv_TrimCommandPool(
 				 &pool->free_cmd_buffers, pool_link) {
 		radv_destroy_cmd_buffer(cmd_buffer);
 	}
+
+	radv_cmd_pool_free_upload_cache(device, pool);
 }
 
 static void
@@ -1209,6 +1209,38 @@ void radv_UpdateDescriptorSets(
 			            descriptorCopyCount, pDescriptorCopies);
 }
 
+/* Whether next can be written by the same loop as prev, continuing where it
+ * stops in the source data, the set and its buffer list.
+ */
+static bool
+radv_template_entries_mergeable(const struct radv_descriptor_update_template_entry *prev,
+                                const struct radv_descriptor_update_template_entry *next)
+{
+	if (next->descriptor_type != prev->descriptor_type ||
+	    next->descriptor_type == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT ||
+	    next->src_stride != prev->src_stride ||
+	    next->dst_stride != prev->dst_stride ||
+	    next->has_sampler != prev->has_sampler ||
+	    next->sampler_offset != prev->sampler_offset ||
+	    next->immutable_samplers || prev->immutable_samplers)
+		return false;
+
+	switch (next->descriptor_type) {
+	case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+	case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+		if (next->dst_offset != prev->dst_offset + prev->descriptor_count)
+			return false;
+		break;
+	default:
+		if (next->dst_offset != prev->dst_offset + prev->descriptor_count * prev->dst_stride)
+			return false;
+		break;
+	}
+
+	return next->buffer_offset == prev->buffer_offset + prev->descriptor_count &&
+	       next->src_offset == prev->src_offset + prev->descriptor_count * prev->src_stride;
+}
+
 VkResult radv_CreateDescriptorUpdateTemplate(VkDevice _device,
                                              const VkDescriptorUpdateTemplateCreateInfo *pCreateInfo,
                                              const VkAllocationCallbacks *pAllocator,
@@ -1220,7 +1252,7 @@ VkResult radv_CreateDescriptorUpdateTemplate(VkDevice _device,
 	const size_t size = sizeof(struct radv_descriptor_update_template) +
 		sizeof(struct radv_descriptor_update_template_entry) * entry_count;
 	struct radv_descriptor_update_template *templ;
-	uint32_t i;
+	uint32_t i, n = 0;
 
 	templ = vk_alloc2(&device->vk.alloc, pAllocator, size, 8, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
 	if (!templ)
@@ -1229,8 +1261,6 @@ VkResult radv_CreateDescriptorUpdateTemplate(VkDevice _device,
 	vk_object_base_init(&device->vk, &templ->base,
 			    VK_OBJECT_TYPE_DESCRIPTOR_UPDATE_TEMPLATE);
 
-	templ->entry_count = entry_count;
-
 	if (pCreateInfo->templateType == VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR) {
 		RADV_FROM_HANDLE(radv_pipeline_layout, pipeline_layout, pCreateInfo->pipelineLayout);
 
@@ -1284,7 +1314,7 @@ VkResult radv_CreateDescriptorUpdateTemplate(VkDevice _device,
 			break;
 		}
 
-		templ->entry[i] = (struct radv_descriptor_update_template_entry) {
+		const struct radv_descriptor_update_template_entry new_entry = {
 			.descriptor_type = entry->descriptorType,
 			.descriptor_count = entry->descriptorCount,
 			.src_offset = entry->offset,
@@ -1296,8 +1326,18 @@ VkResult radv_CreateDescriptorUpdateTemplate(VkDevice _device,
 			.sampler_offset = radv_combined_image_descriptor_sampler_offset(binding_layout),
 			.immutable_samplers = immutable_samplers
 		};
+
+		/* Runs of descriptors spread over several template entries are
+		 * written in one go.
+		 */
+		if (n && radv_template_entries_mergeable(&templ->entry[n - 1], &new_entry))
+			templ->entry[n - 1].descriptor_count += new_entry.descriptor_count;
+		else
+			templ->entry[n++] = new_entry;
 	}
 
+	templ->entry_count = n;
+
 	*pDescriptorUpdateTemplate = radv_descriptor_update_template_to_handle(templ);
 	return VK_SUCCESS;
 }
@@ -1323,68 +1363,84 @@ void radv_update_descriptor_set_with_template(struct radv_device *device,
                                               const void *pData)
 {
 	RADV_FROM_HANDLE(radv_descriptor_update_template, templ, descriptorUpdateTemplate);
-	uint32_t i;
+	uint32_t i, j;
 
+	/* Switch once per entry, so that every loop below only writes one
+	 * kind of descriptor.
+	 */
 	for (i = 0; i < templ->entry_count; ++i) {
-		struct radeon_winsys_bo **buffer_list = set->descriptors + templ->entry[i].buffer_offset;
-		uint32_t *pDst = set->mapped_ptr + templ->entry[i].dst_offset;
-		const uint8_t *pSrc = ((const uint8_t *) pData) + templ->entry[i].src_offset;
-		uint32_t j;
-
-		if (templ->entry[i].descriptor_type == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT) {
-			memcpy((uint8_t*)pDst, pSrc, templ->entry[i].descriptor_count);
-			continue;
-		}
-
-		for (j = 0; j < templ->entry[i].descriptor_count; ++j) {
-			switch (templ->entry[i].descriptor_type) {
-			case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
-			case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC: {
-				const unsigned idx = templ->entry[i].dst_offset + j;
-				assert(!(set->layout->flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR));
-				write_dynamic_buffer_descriptor(device, set->dynamic_descriptors + idx,
-								buffer_list, (struct VkDescriptorBufferInfo *) pSrc);
-				break;
+		const struct radv_descriptor_update_template_entry *entry = &templ->entry[i];
+		struct radeon_winsys_bo **buffer_list = set->descriptors + entry->buffer_offset;
+		uint32_t *pDst = set->mapped_ptr + entry->dst_offset;
+		const uint8_t *pSrc = ((const uint8_t *) pData) + entry->src_offset;
+		const uint32_t count = entry->descriptor_count;
+		const size_t src_stride = entry->src_stride;
+		const uint32_t dst_stride = entry->dst_stride;
+
+		switch (entry->descriptor_type) {
+		case VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT:
+			memcpy((uint8_t*)pDst, pSrc, count);
+			break;
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+			assert(!(set->layout->flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR));
+			for (j = 0; j < count; ++j, pSrc += src_stride) {
+				write_dynamic_buffer_descriptor(device,
+								set->dynamic_descriptors + entry->dst_offset + j,
+								buffer_list + j,
+								(struct VkDescriptorBufferInfo *) pSrc);
 			}
-			case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-			case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-				write_buffer_descriptor(device, cmd_buffer, pDst, buffer_list,
+			break;
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+			for (j = 0; j < count; ++j, pSrc += src_stride, pDst += dst_stride) {
+				write_buffer_descriptor(device, cmd_buffer, pDst, buffer_list + j,
 				                        (struct VkDescriptorBufferInfo *) pSrc);
-				break;
-			case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
-			case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
-				write_texel_buffer_descriptor(device, cmd_buffer, pDst, buffer_list,
+			}
+			break;
+		case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+		case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+			for (j = 0; j < count; ++j, pSrc += src_stride, pDst += dst_stride) {
+				write_texel_buffer_descriptor(device, cmd_buffer, pDst, buffer_list + j,
 						              *(VkBufferView *) pSrc);
-				break;
-			case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-			case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-			case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
-				write_image_descriptor(device, cmd_buffer, 64, pDst, buffer_list,
-						       templ->entry[i].descriptor_type,
+			}
+			break;
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+			for (j = 0; j < count; ++j, pSrc += src_stride, pDst += dst_stride) {
+				write_image_descriptor(device, cmd_buffer, 64, pDst, buffer_list + j,
+						       entry->descriptor_type,
 					               (struct VkDescriptorImageInfo *) pSrc);
-				break;
-			case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-				write_combined_image_sampler_descriptor(device, cmd_buffer, templ->entry[i].sampler_offset,
-									pDst, buffer_list, templ->entry[i].descriptor_type,
+			}
+			break;
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+			for (j = 0; j < count; ++j, pSrc += src_stride, pDst += dst_stride) {
+				write_combined_image_sampler_descriptor(device, cmd_buffer, entry->sampler_offset,
+									pDst, buffer_list + j, entry->descriptor_type,
 									(struct VkDescriptorImageInfo *) pSrc,
-									templ->entry[i].has_sampler);
-				if (templ->entry[i].immutable_samplers) {
-					memcpy((char*)pDst + templ->entry[i].sampler_offset, templ->entry[i].immutable_samplers + 4 * j, 16);
+									entry->has_sampler);
+				if (entry->immutable_samplers) {
+					memcpy((char*)pDst + entry->sampler_offset, entry->immutable_samplers + 4 * j, 16);
 				}
-				break;
-			case VK_DESCRIPTOR_TYPE_SAMPLER:
-				if (templ->entry[i].has_sampler)
+			}
+			break;
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+			if (entry->has_sampler) {
+				for (j = 0; j < count; ++j, pSrc += src_stride, pDst += dst_stride)
 					write_sampler_descriptor(device, pDst,
 					                         (struct VkDescriptorImageInfo *) pSrc);
-				else if (templ->entry[i].immutable_samplers)
-					memcpy(pDst, templ->entry[i].immutable_samplers + 4 * j, 16);
-				break;
-			default:
-				break;
+			} else if (entry->immutable_samplers) {
+				if (dst_stride == 4) {
+					memcpy(pDst, entry->immutable_samplers, 16 * count);
+				} else {
+					for (j = 0; j < count; ++j, pDst += dst_stride)
+						memcpy(pDst, entry->immutable_samplers + 4 * j, 16);
+				}
 			}
-		        pSrc += templ->entry[i].src_stride;
-			pDst += templ->entry[i].dst_stride;
-			++buffer_list;
+			break;
+		default:
+			break;
 		}
 	}
 }
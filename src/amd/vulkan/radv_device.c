@@ -53,8 +53,10 @@
 #include "util/mesa-sha1.h"
 #include "util/timespec.h"
 #include "util/u_atomic.h"
+#include "util/u_cpu_detect.h"
 #include "compiler/glsl_types.h"
 #include "util/driconf.h"
+#include "util/u_cpu_trace.h"
 
 static struct radv_timeline_point *
 radv_timeline_find_point_at_least_locked(struct radv_device *device,
@@ -532,6 +534,7 @@ static const struct debug_control radv_perftest_options[] = {
 	{"pswave32", RADV_PERFTEST_PS_WAVE_32},
 	{"gewave32", RADV_PERFTEST_GE_WAVE_32},
 	{"dfsm", RADV_PERFTEST_DFSM},
+	{"fastcompile", RADV_PERFTEST_FAST_COMPILE},
 	{NULL, 0}
 };
 
@@ -2475,15 +2478,27 @@ radv_get_int_debug_option(const char *name, int default_value)
 	return result;
 }
 
+/* Thread trace is enabled either for a single frame selected by index, for
+ * the frames following a trigger file creation, or in rolling mode where
+ * every frame is traced and only those slower than the spike threshold are
+ * dumped.
+ */
+static bool
+radv_thread_trace_enabled(void)
+{
+	return radv_get_int_debug_option("RADV_THREAD_TRACE", -1) >= 0 ||
+	       radv_get_int_debug_option("RADV_THREAD_TRACE_SPIKE", 0) > 0 ||
+	       getenv("RADV_THREAD_TRACE_TRIGGER");
+}
+
 static void
 radv_device_init_dispatch(struct radv_device *device)
 {
 	const struct radv_instance *instance = device->physical_device->instance;
 	const struct radv_device_dispatch_table *dispatch_table_layer = NULL;
 	bool unchecked = instance->debug_flags & RADV_DEBUG_ALL_ENTRYPOINTS;
-	int radv_thread_trace = radv_get_int_debug_option("RADV_THREAD_TRACE", -1);
 
-	if (radv_thread_trace >= 0) {
+	if (radv_thread_trace_enabled()) {
 		/* Use device entrypoints from the SQTT layer if enabled. */
 		dispatch_table_layer = &sqtt_device_dispatch_table;
 	}
@@ -2765,8 +2780,7 @@ VkResult radv_CreateDevice(
 		radv_dump_enabled_options(device, stderr);
 	}
 
-	int radv_thread_trace = radv_get_int_debug_option("RADV_THREAD_TRACE", -1);
-	if (radv_thread_trace >= 0) {
+	if (radv_thread_trace_enabled()) {
 		fprintf(stderr, "*************************************************\n");
 		fprintf(stderr, "* WARNING: Thread trace support is experimental *\n");
 		fprintf(stderr, "*************************************************\n");
@@ -2781,7 +2795,12 @@ VkResult radv_CreateDevice(
 		/* Default buffer size set to 1MB per SE. */
 		device->thread_trace_buffer_size =
 			radv_get_int_debug_option("RADV_THREAD_TRACE_BUFFER_SIZE", 1024 * 1024);
-		device->thread_trace_start_frame = radv_thread_trace;
+		device->thread_trace_start_frame =
+			radv_get_int_debug_option("RADV_THREAD_TRACE", -1);
+		/* Frame time threshold in milliseconds for rolling captures. */
+		device->thread_trace_spike_ns =
+			MAX2(radv_get_int_debug_option("RADV_THREAD_TRACE_SPIKE", 0), 0) * 1000000ull;
+		device->thread_trace_trigger_file = getenv("RADV_THREAD_TRACE_TRIGGER");
 
 		if (!radv_thread_trace_init(device))
 			goto fail;
@@ -2844,6 +2863,33 @@ VkResult radv_CreateDevice(
 	if (result != VK_SUCCESS)
 		goto fail_mem_cache;
 
+	/* Stages which don't depend on each other are compiled in parallel,
+	 * the calling thread always takes part, so leave one CPU for it.
+	 */
+	util_cpu_detect();
+	unsigned num_compile_threads = MIN2(util_cpu_caps.nr_cpus - 1, 4);
+	if (num_compile_threads &&
+	    !util_queue_init(&device->shader_compile_queue, "radv_sh", 16,
+	                     num_compile_threads,
+	                     UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+	                     UTIL_QUEUE_INIT_SHARED_CPU_LIMIT)) {
+		result = VK_ERROR_OUT_OF_HOST_MEMORY;
+		goto fail_timeline_cond;
+	}
+
+	/* Pipeline jobs wait for their stage jobs, so they need their own
+	 * threads to not starve the compile queue.
+	 */
+	if (num_compile_threads &&
+	    !util_queue_init(&device->pipeline_create_queue, "radv_pipe", 16,
+	                     MIN2(util_cpu_caps.nr_cpus - 1, 8),
+	                     UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+	                     UTIL_QUEUE_INIT_SHARED_CPU_LIMIT)) {
+		util_queue_destroy(&device->shader_compile_queue);
+		result = VK_ERROR_OUT_OF_HOST_MEMORY;
+		goto fail_timeline_cond;
+	}
+
 	device->force_aniso =
 		MIN2(16, radv_get_int_debug_option("RADV_TEX_ANISO", -1));
 	if (device->force_aniso >= 0) {
@@ -2854,6 +2900,8 @@ VkResult radv_CreateDevice(
 	*pDevice = radv_device_to_handle(device);
 	return VK_SUCCESS;
 
+fail_timeline_cond:
+	pthread_cond_destroy(&device->timeline_cond);
 fail_mem_cache:
 	radv_DestroyPipelineCache(radv_device_to_handle(device), pc, NULL);
 fail_meta:
@@ -2909,6 +2957,11 @@ void radv_DestroyDevice(
 	}
 	radv_device_finish_meta(device);
 
+	if (util_queue_is_initialized(&device->pipeline_create_queue))
+		util_queue_destroy(&device->pipeline_create_queue);
+	if (util_queue_is_initialized(&device->shader_compile_queue))
+		util_queue_destroy(&device->shader_compile_queue);
+
 	VkPipelineCache pc = radv_pipeline_cache_to_handle(device->mem_cache);
 	radv_DestroyPipelineCache(radv_device_to_handle(device), pc, NULL);
 
@@ -4714,6 +4767,7 @@ VkResult radv_QueueSubmit(
 	const VkSubmitInfo*                         pSubmits,
 	VkFence                                     fence)
 {
+	UTIL_CPU_TRACE_FUNC();
 	RADV_FROM_HANDLE(radv_queue, queue, _queue);
 	VkResult result;
 	uint32_t fence_idx = 0;
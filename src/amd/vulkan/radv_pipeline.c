@@ -2338,7 +2338,8 @@ radv_generate_graphics_pipeline_key(struct radv_pipeline *pipeline,
 	struct radv_pipeline_key key;
 	memset(&key, 0, sizeof(key));
 
-	if (pCreateInfo->flags & VK_PIPELINE_CREATE_DISABLE_OPTIMIZATION_BIT)
+	if ((pCreateInfo->flags & VK_PIPELINE_CREATE_DISABLE_OPTIMIZATION_BIT) ||
+	    (pipeline->device->instance->perftest_flags & RADV_PERFTEST_FAST_COMPILE))
 		key.optimisations_disabled = 1;
 
 	key.has_multiview_view_index = !!subpass->view_mask;
@@ -2561,8 +2562,10 @@ radv_fill_shader_keys(struct radv_device *device,
 		}
 	}
 
-	for(int i = 0; i < MESA_SHADER_STAGES; ++i)
+	for(int i = 0; i < MESA_SHADER_STAGES; ++i) {
 		keys[i].has_multiview_view_index = key->has_multiview_view_index;
+		keys[i].optimisations_disabled = key->optimisations_disabled;
+	}
 
 	keys[MESA_SHADER_FRAGMENT].fs.col_format = key->col_format;
 	keys[MESA_SHADER_FRAGMENT].fs.is_int8 = key->is_int8;
@@ -2823,6 +2826,135 @@ void radv_stop_feedback(VkPipelineCreationFeedbackEXT *feedback, bool cache_hit)
 	                   (cache_hit ? VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT : 0);
 }
 
+struct radv_shader_compile_job {
+	struct radv_device *device;
+	struct radv_shader_module *module;
+	struct nir_shader *nir;
+	struct radv_pipeline_layout *layout;
+	const struct radv_shader_variant_key *key;
+	struct radv_shader_info *info;
+	bool keep_executable_info;
+	bool keep_statistic_info;
+	VkPipelineCreationFeedbackEXT *feedback;
+
+	struct radv_shader_variant *variant;
+	struct radv_shader_binary *binary;
+	struct util_queue_fence fence;
+};
+
+static void
+radv_shader_compile_job_execute(void *data, int thread_index)
+{
+	struct radv_shader_compile_job *job = data;
+
+	radv_start_feedback(job->feedback);
+
+	job->variant = radv_shader_variant_compile(job->device, job->module, &job->nir, 1,
+	                                           job->layout, job->key, job->info,
+	                                           job->keep_executable_info,
+	                                           job->keep_statistic_info,
+	                                           &job->binary);
+
+	radv_stop_feedback(job->feedback, false);
+}
+
+/* Compiles a stage which doesn't depend on any other stage's results on
+ * the device's compile queue, or right away if there is no queue.
+ */
+static void
+radv_shader_compile_job_submit(struct radv_device *device,
+                               struct radv_shader_compile_job *job)
+{
+	util_queue_fence_init(&job->fence);
+
+	if (util_queue_is_initialized(&device->shader_compile_queue)) {
+		util_queue_add_job(&device->shader_compile_queue, job, &job->fence,
+		                   radv_shader_compile_job_execute, NULL, 0);
+	} else {
+		radv_shader_compile_job_execute(job, 0);
+		util_queue_fence_signal(&job->fence);
+	}
+}
+
+static void
+radv_shader_compile_job_wait(struct radv_shader_compile_job *job)
+{
+	util_queue_fence_wait(&job->fence);
+	util_queue_fence_destroy(&job->fence);
+}
+
+/* Hashes the pre-rasterization stages and the fragment shader on their
+ * own. The code of each part only depends on the shaders of all stages and
+ * on its own part of the pipeline key, so pipelines which only differ in
+ * their vertex input or color export state can share the other part.
+ */
+static void
+radv_hash_shader_parts(unsigned char *pre_raster_hash,
+		       unsigned char *fs_hash,
+		       const VkPipelineShaderStageCreateInfo **stages,
+		       const struct radv_pipeline_layout *layout,
+		       const struct radv_pipeline_key *key,
+		       uint32_t flags)
+{
+	struct radv_pipeline_key part_key;
+
+	part_key = *key;
+	part_key.col_format = 0;
+	part_key.is_int8 = 0;
+	part_key.is_int10 = 0;
+	part_key.is_dual_src = false;
+	radv_hash_shaders(pre_raster_hash, stages, layout, &part_key, flags);
+	pre_raster_hash[0] ^= 4;
+
+	part_key = *key;
+	part_key.instance_rate_inputs = 0;
+	memset(part_key.instance_rate_divisors, 0, sizeof(part_key.instance_rate_divisors));
+	memset(part_key.vertex_attribute_formats, 0, sizeof(part_key.vertex_attribute_formats));
+	memset(part_key.vertex_attribute_bindings, 0, sizeof(part_key.vertex_attribute_bindings));
+	memset(part_key.vertex_attribute_offsets, 0, sizeof(part_key.vertex_attribute_offsets));
+	memset(part_key.vertex_attribute_strides, 0, sizeof(part_key.vertex_attribute_strides));
+	part_key.vertex_alpha_adjust = 0;
+	part_key.vertex_post_shuffle = 0;
+	radv_hash_shaders(fs_hash, stages, layout, &part_key, flags);
+	fs_hash[0] ^= 2;
+}
+
+/* Adds the variants of the given stages, if they were all compiled by this
+ * pipeline, as their own cache entry.
+ */
+static void
+radv_pipeline_cache_insert_part(struct radv_pipeline *pipeline,
+				struct radv_device *device,
+				struct radv_pipeline_cache *cache,
+				const unsigned char *hash,
+				uint32_t stage_mask,
+				struct radv_shader_binary **binaries)
+{
+	struct radv_shader_variant *variants[MESA_SHADER_STAGES] = {0};
+	struct radv_shader_binary *part_binaries[MESA_SHADER_STAGES] = {NULL};
+
+	for (unsigned i = 0; i < MESA_SHADER_STAGES; ++i) {
+		if (!(stage_mask & (1u << i)) || !pipeline->shaders[i])
+			continue;
+		if (!binaries[i])
+			return;
+
+		variants[i] = pipeline->shaders[i];
+		part_binaries[i] = binaries[i];
+	}
+
+	radv_pipeline_cache_insert_shaders(device, cache, hash, variants,
+					   part_binaries);
+
+	/* Another thread may have inserted the same part meanwhile, in which
+	 * case ours were replaced by the cached variants.
+	 */
+	for (unsigned i = 0; i < MESA_SHADER_STAGES; ++i) {
+		if (variants[i])
+			pipeline->shaders[i] = variants[i];
+	}
+}
+
 VkResult radv_create_shaders(struct radv_pipeline *pipeline,
                              struct radv_device *device,
                              struct radv_pipeline_cache *cache,
@@ -2839,6 +2971,7 @@ VkResult radv_create_shaders(struct radv_pipeline *pipeline,
 	struct radv_shader_variant_key keys[MESA_SHADER_STAGES] = {{{{{0}}}}};
 	struct radv_shader_info infos[MESA_SHADER_STAGES] = {0};
 	unsigned char hash[20], gs_copy_hash[20];
+	unsigned char pre_raster_hash[20], fs_hash[20];
 	bool keep_executable_info = (flags & VK_PIPELINE_CREATE_CAPTURE_INTERNAL_REPRESENTATIONS_BIT_KHR) || device->keep_shader_info;
 	bool keep_statistic_info = (flags & VK_PIPELINE_CREATE_CAPTURE_STATISTICS_BIT_KHR) ||
 	                           (device->instance->debug_flags & RADV_DEBUG_DUMP_SHADER_STATS) ||
@@ -2859,9 +2992,18 @@ VkResult radv_create_shaders(struct radv_pipeline *pipeline,
 	}
 
 	radv_hash_shaders(hash, pStages, pipeline->layout, key, get_hash_flags(device));
-	memcpy(gs_copy_hash, hash, 20);
+	radv_hash_shader_parts(pre_raster_hash, fs_hash, pStages, pipeline->layout,
+			       key, get_hash_flags(device));
+
+	/* The GS copy shader only depends on the pre-rasterization part. */
+	memcpy(gs_copy_hash, pre_raster_hash, 20);
 	gs_copy_hash[0] ^= 1;
 
+	const bool use_parts = !modules[MESA_SHADER_COMPUTE] &&
+			       !keep_executable_info && !keep_statistic_info;
+	const uint32_t fs_mask = 1u << MESA_SHADER_FRAGMENT;
+	const uint32_t pre_raster_mask = BITFIELD_MASK(MESA_SHADER_FRAGMENT);
+
 	bool found_in_application_cache = true;
 	if (modules[MESA_SHADER_GEOMETRY] && !keep_executable_info && !keep_statistic_info) {
 		struct radv_shader_variant *variants[MESA_SHADER_STAGES] = {0};
@@ -2878,6 +3020,32 @@ VkResult radv_create_shaders(struct radv_pipeline *pipeline,
 		return VK_SUCCESS;
 	}
 
+	/* Otherwise reuse whichever part was already compiled for another
+	 * pipeline, and only compile the other one.
+	 */
+	bool pre_raster_cached = false;
+	if (use_parts) {
+		struct radv_shader_variant *variants[MESA_SHADER_STAGES] = {0};
+
+		if (radv_create_shader_variants_from_pipeline_cache(device, cache, fs_hash, variants,
+		                                                    &found_in_application_cache))
+			pipeline->shaders[MESA_SHADER_FRAGMENT] = variants[MESA_SHADER_FRAGMENT];
+
+		memset(variants, 0, sizeof(variants));
+		if (radv_create_shader_variants_from_pipeline_cache(device, cache, pre_raster_hash, variants,
+		                                                    &found_in_application_cache)) {
+			for (unsigned i = 0; i < MESA_SHADER_FRAGMENT; ++i)
+				pipeline->shaders[i] = variants[i];
+			pre_raster_cached = true;
+		}
+
+		if (pipeline->shaders[MESA_SHADER_FRAGMENT] && pre_raster_cached &&
+		    (!modules[MESA_SHADER_GEOMETRY] || pipeline->gs_copy_shader)) {
+			radv_stop_feedback(pipeline_feedback, found_in_application_cache);
+			return VK_SUCCESS;
+		}
+	}
+
 	if (flags & VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT_EXT) {
 		radv_stop_feedback(pipeline_feedback, found_in_application_cache);
 		return VK_PIPELINE_COMPILE_REQUIRED_EXT;
@@ -2930,7 +3098,7 @@ VkResult radv_create_shaders(struct radv_pipeline *pipeline,
 		merge_tess_info(&nir[MESA_SHADER_TESS_EVAL]->info, &nir[MESA_SHADER_TESS_CTRL]->info);
 	}
 
-	if (!(flags & VK_PIPELINE_CREATE_DISABLE_OPTIMIZATION_BIT))
+	if (!key->optimisations_disabled)
 		radv_link_shaders(pipeline, nir);
 
 	radv_set_linked_driver_locations(pipeline, nir, infos);
@@ -2986,6 +3154,26 @@ VkResult radv_create_shaders(struct radv_pipeline *pipeline,
 		gfx9_get_gs_info(key, pipeline, nir, infos, gs_info);
 	}
 
+	/* The fragment shader doesn't depend on the results of the other
+	 * stages, so compile it while the geometry stages are compiled.
+	 */
+	struct radv_shader_compile_job fs_job = {
+		.device = device,
+		.module = modules[MESA_SHADER_FRAGMENT],
+		.nir = nir[MESA_SHADER_FRAGMENT],
+		.layout = pipeline->layout,
+		.key = keys + MESA_SHADER_FRAGMENT,
+		.info = infos + MESA_SHADER_FRAGMENT,
+		.keep_executable_info = keep_executable_info,
+		.keep_statistic_info = keep_statistic_info,
+		.feedback = stage_feedbacks[MESA_SHADER_FRAGMENT],
+	};
+	bool fs_job_submitted = false;
+	if (nir[MESA_SHADER_FRAGMENT] && !pipeline->shaders[MESA_SHADER_FRAGMENT]) {
+		radv_shader_compile_job_submit(device, &fs_job);
+		fs_job_submitted = true;
+	}
+
 	if(modules[MESA_SHADER_GEOMETRY]) {
 		struct radv_shader_binary *gs_copy_binary = NULL;
 		if (!pipeline->gs_copy_shader &&
@@ -3023,21 +3211,6 @@ VkResult radv_create_shaders(struct radv_pipeline *pipeline,
 		free(gs_copy_binary);
 	}
 
-	if (nir[MESA_SHADER_FRAGMENT]) {
-		if (!pipeline->shaders[MESA_SHADER_FRAGMENT]) {
-			radv_start_feedback(stage_feedbacks[MESA_SHADER_FRAGMENT]);
-
-			pipeline->shaders[MESA_SHADER_FRAGMENT] =
-			       radv_shader_variant_compile(device, modules[MESA_SHADER_FRAGMENT], &nir[MESA_SHADER_FRAGMENT], 1,
-			                                  pipeline->layout, keys + MESA_SHADER_FRAGMENT,
-							  infos + MESA_SHADER_FRAGMENT,
-			                                  keep_executable_info, keep_statistic_info,
-			                                  &binaries[MESA_SHADER_FRAGMENT]);
-
-			radv_stop_feedback(stage_feedbacks[MESA_SHADER_FRAGMENT], false);
-		}
-	}
-
 	if (device->physical_device->rad_info.chip_class >= GFX9 && modules[MESA_SHADER_TESS_CTRL]) {
 		if (!pipeline->shaders[MESA_SHADER_TESS_CTRL]) {
 			struct nir_shader *combined_nir[] = {nir[MESA_SHADER_VERTEX], nir[MESA_SHADER_TESS_CTRL]};
@@ -3076,6 +3249,10 @@ VkResult radv_create_shaders(struct radv_pipeline *pipeline,
 	}
 
 	for (int i = 0; i < MESA_SHADER_STAGES; ++i) {
+		/* the fragment shader is compiled by fs_job */
+		if (i == MESA_SHADER_FRAGMENT)
+			continue;
+
 		if(modules[i] && !pipeline->shaders[i]) {
 			if (i == MESA_SHADER_TESS_CTRL) {
 				keys[MESA_SHADER_TESS_CTRL].tcs.num_inputs = util_last_bit64(pipeline->shaders[MESA_SHADER_VERTEX]->info.vs.ls_outputs_written);
@@ -3096,7 +3273,29 @@ VkResult radv_create_shaders(struct radv_pipeline *pipeline,
 		}
 	}
 
-	if (!keep_executable_info && !keep_statistic_info) {
+	if (fs_job_submitted) {
+		radv_shader_compile_job_wait(&fs_job);
+		pipeline->shaders[MESA_SHADER_FRAGMENT] = fs_job.variant;
+		binaries[MESA_SHADER_FRAGMENT] = fs_job.binary;
+	}
+
+	if (use_parts) {
+		radv_pipeline_cache_insert_part(pipeline, device, cache, fs_hash,
+						fs_mask, binaries);
+		if (!pre_raster_cached)
+			radv_pipeline_cache_insert_part(pipeline, device, cache,
+							pre_raster_hash,
+							pre_raster_mask, binaries);
+	}
+
+	/* Pipelines made of cached parts are found through the parts. */
+	bool all_compiled = true;
+	for (int i = 0; i < MESA_SHADER_STAGES; ++i) {
+		if (pipeline->shaders[i] && !binaries[i])
+			all_compiled = false;
+	}
+
+	if (!keep_executable_info && !keep_statistic_info && all_compiled) {
 		radv_pipeline_cache_insert_shaders(device, cache, hash, pipeline->shaders,
 						   binaries);
 	}
@@ -4997,6 +5196,89 @@ radv_graphics_pipeline_create(
 	return VK_SUCCESS;
 }
 
+struct radv_pipeline_create_job {
+	VkDevice device;
+	VkPipelineCache cache;
+	const VkGraphicsPipelineCreateInfo *create_info;
+	const VkAllocationCallbacks *alloc;
+	VkPipeline *pipeline;
+
+	VkResult result;
+	struct util_queue_fence fence;
+};
+
+static void
+radv_pipeline_create_job_execute(void *data, int thread_index)
+{
+	struct radv_pipeline_create_job *job = data;
+
+	job->result = radv_graphics_pipeline_create(job->device, job->cache,
+						    job->create_info, NULL,
+						    job->alloc, job->pipeline);
+}
+
+/* Creates all the pipelines on the device's pipeline queue, the calling
+ * thread taking the last one, and then returns the same results as
+ * creating them one after the other would.
+ */
+static VkResult
+radv_create_graphics_pipelines_parallel(struct radv_device *device,
+					VkPipelineCache cache,
+					uint32_t count,
+					const VkGraphicsPipelineCreateInfo *pCreateInfos,
+					const VkAllocationCallbacks *pAllocator,
+					VkPipeline *pPipelines,
+					struct radv_pipeline_create_job *jobs)
+{
+	VkResult result = VK_SUCCESS;
+	bool early_return = false;
+
+	for (unsigned i = 0; i < count; i++) {
+		pPipelines[i] = VK_NULL_HANDLE;
+
+		jobs[i] = (struct radv_pipeline_create_job) {
+			.device = radv_device_to_handle(device),
+			.cache = cache,
+			.create_info = &pCreateInfos[i],
+			.alloc = pAllocator,
+			.pipeline = &pPipelines[i],
+		};
+		util_queue_fence_init(&jobs[i].fence);
+
+		if (i < count - 1) {
+			util_queue_add_job(&device->pipeline_create_queue,
+					   &jobs[i], &jobs[i].fence,
+					   radv_pipeline_create_job_execute,
+					   NULL, 0);
+		}
+	}
+
+	radv_pipeline_create_job_execute(&jobs[count - 1], 0);
+	util_queue_fence_signal(&jobs[count - 1].fence);
+
+	for (unsigned i = 0; i < count; i++) {
+		util_queue_fence_wait(&jobs[i].fence);
+		util_queue_fence_destroy(&jobs[i].fence);
+
+		/* The pipelines after an early return must not be returned,
+		 * even though they were created in the meantime.
+		 */
+		if (early_return) {
+			radv_DestroyPipeline(radv_device_to_handle(device),
+					     pPipelines[i], pAllocator);
+			pPipelines[i] = VK_NULL_HANDLE;
+		} else if (jobs[i].result != VK_SUCCESS) {
+			result = jobs[i].result;
+			pPipelines[i] = VK_NULL_HANDLE;
+
+			if (pCreateInfos[i].flags & VK_PIPELINE_CREATE_EARLY_RETURN_ON_FAILURE_BIT_EXT)
+				early_return = true;
+		}
+	}
+
+	return result;
+}
+
 VkResult radv_CreateGraphicsPipelines(
 	VkDevice                                    _device,
 	VkPipelineCache                             pipelineCache,
@@ -5005,9 +5287,31 @@ VkResult radv_CreateGraphicsPipelines(
 	const VkAllocationCallbacks*                pAllocator,
 	VkPipeline*                                 pPipelines)
 {
+	RADV_FROM_HANDLE(radv_device, device, _device);
+	RADV_FROM_HANDLE(radv_pipeline_cache, cache, pipelineCache);
 	VkResult result = VK_SUCCESS;
 	unsigned i = 0;
 
+	/* The cache is only safe to use from several threads if the
+	 * application didn't tell us that it synchronizes it.
+	 */
+	if (count > 1 &&
+	    util_queue_is_initialized(&device->pipeline_create_queue) &&
+	    !(cache && (cache->flags & VK_PIPELINE_CACHE_CREATE_EXTERNALLY_SYNCHRONIZED_BIT_EXT))) {
+		struct radv_pipeline_create_job *jobs =
+			vk_alloc2(&device->vk.alloc, pAllocator,
+				  count * sizeof(*jobs), 8,
+				  VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+		if (jobs) {
+			result = radv_create_graphics_pipelines_parallel(device, pipelineCache,
+									 count, pCreateInfos,
+									 pAllocator, pPipelines,
+									 jobs);
+			vk_free2(&device->vk.alloc, pAllocator, jobs);
+			return result;
+		}
+	}
+
 	for (; i < count; i++) {
 		VkResult r;
 		r = radv_graphics_pipeline_create(_device,
@@ -5106,7 +5410,8 @@ radv_generate_compute_pipeline_key(struct radv_pipeline *pipeline,
 	struct radv_pipeline_key key;
 	memset(&key, 0, sizeof(key));
 
-	if (pCreateInfo->flags & VK_PIPELINE_CREATE_DISABLE_OPTIMIZATION_BIT)
+	if ((pCreateInfo->flags & VK_PIPELINE_CREATE_DISABLE_OPTIMIZATION_BIT) ||
+	    (pipeline->device->instance->perftest_flags & RADV_PERFTEST_FAST_COMPILE))
 		key.optimisations_disabled = 1;
 
 	const VkPipelineShaderStageRequiredSubgroupSizeCreateInfoEXT *subgroup_size =
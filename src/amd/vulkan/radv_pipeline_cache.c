@@ -42,6 +42,26 @@ struct cache_entry {
 	char code[0];
 };
 
+/* Open addressing table of the entries. Entries are never removed while
+ * other threads may look them up, so readers only need to see slots and
+ * the table pointer published after what they point to is initialized.
+ */
+struct radv_pipeline_cache_table {
+	struct radv_pipeline_cache_table *next;
+	uint32_t size;
+	struct cache_entry *entries[0];
+};
+
+static struct radv_pipeline_cache_table *
+radv_pipeline_cache_table_create(uint32_t size)
+{
+	struct radv_pipeline_cache_table *table =
+		calloc(1, sizeof(*table) + size * sizeof(table->entries[0]));
+	if (table)
+		table->size = size;
+	return table;
+}
+
 static void
 radv_pipeline_cache_lock(struct radv_pipeline_cache *cache)
 {
@@ -71,34 +91,39 @@ radv_pipeline_cache_init(struct radv_pipeline_cache *cache,
 	cache->modified = false;
 	cache->kernel_count = 0;
 	cache->total_size = 0;
-	cache->table_size = 1024;
-	const size_t byte_size = cache->table_size * sizeof(cache->hash_table[0]);
-	cache->hash_table = malloc(byte_size);
+	cache->old_tables = NULL;
 
-	/* We don't consider allocation failure fatal, we just start with a 0-sized
-	 * cache. Disable caching when we want to keep shader debug info, since
+	/* We don't consider allocation failure fatal, we just start without a
+	 * table. Disable caching when we want to keep shader debug info, since
 	 * we don't get the debug info on cached shaders. */
-	if (cache->hash_table == NULL ||
-	    (device->instance->debug_flags & RADV_DEBUG_NO_CACHE))
-		cache->table_size = 0;
+	if (device->instance->debug_flags & RADV_DEBUG_NO_CACHE)
+		cache->table = NULL;
 	else
-		memset(cache->hash_table, 0, byte_size);
+		cache->table = radv_pipeline_cache_table_create(1024);
 }
 
 void
 radv_pipeline_cache_finish(struct radv_pipeline_cache *cache)
 {
-	for (unsigned i = 0; i < cache->table_size; ++i)
-		if (cache->hash_table[i]) {
+	struct radv_pipeline_cache_table *table = cache->table;
+
+	for (unsigned i = 0; table && i < table->size; ++i)
+		if (table->entries[i]) {
 			for(int j = 0; j < MESA_SHADER_STAGES; ++j)  {
-				if (cache->hash_table[i]->variants[j])
+				if (table->entries[i]->variants[j])
 					radv_shader_variant_destroy(cache->device,
-								    cache->hash_table[i]->variants[j]);
+								    table->entries[i]->variants[j]);
 			}
-			vk_free(&cache->alloc, cache->hash_table[i]);
+			vk_free(&cache->alloc, table->entries[i]);
 		}
 	pthread_mutex_destroy(&cache->mutex);
-	free(cache->hash_table);
+	free(table);
+
+	while (cache->old_tables) {
+		table = cache->old_tables;
+		cache->old_tables = table->next;
+		free(table);
+	}
 }
 
 static uint32_t
@@ -145,19 +170,22 @@ radv_hash_shaders(unsigned char *hash,
 }
 
 
+/* Doesn't need the cache lock, see struct radv_pipeline_cache_table. */
 static struct cache_entry *
-radv_pipeline_cache_search_unlocked(struct radv_pipeline_cache *cache,
-				    const unsigned char *sha1)
+radv_pipeline_cache_search(struct radv_pipeline_cache *cache,
+			   const unsigned char *sha1)
 {
-	const uint32_t mask = cache->table_size - 1;
+	struct radv_pipeline_cache_table *table = p_atomic_read(&cache->table);
 	const uint32_t start = (*(uint32_t *) sha1);
 
-	if (cache->table_size == 0)
+	if (!table)
 		return NULL;
 
-	for (uint32_t i = 0; i < cache->table_size; i++) {
+	const uint32_t mask = table->size - 1;
+
+	for (uint32_t i = 0; i < table->size; i++) {
 		const uint32_t index = (start + i) & mask;
-		struct cache_entry *entry = cache->hash_table[index];
+		struct cache_entry *entry = p_atomic_read(&table->entries[index]);
 
 		if (!entry)
 			return NULL;
@@ -170,72 +198,46 @@ radv_pipeline_cache_search_unlocked(struct radv_pipeline_cache *cache,
 	unreachable("hash table should never be full");
 }
 
-static struct cache_entry *
-radv_pipeline_cache_search(struct radv_pipeline_cache *cache,
-			   const unsigned char *sha1)
-{
-	struct cache_entry *entry;
-
-	radv_pipeline_cache_lock(cache);
-
-	entry = radv_pipeline_cache_search_unlocked(cache, sha1);
-
-	radv_pipeline_cache_unlock(cache);
-
-	return entry;
-}
-
 static void
-radv_pipeline_cache_set_entry(struct radv_pipeline_cache *cache,
+radv_pipeline_cache_set_entry(struct radv_pipeline_cache_table *table,
 			      struct cache_entry *entry)
 {
-	const uint32_t mask = cache->table_size - 1;
+	const uint32_t mask = table->size - 1;
 	const uint32_t start = entry->sha1_dw[0];
 
-	/* We'll always be able to insert when we get here. */
-	assert(cache->kernel_count < cache->table_size / 2);
-
-	for (uint32_t i = 0; i < cache->table_size; i++) {
+	for (uint32_t i = 0; i < table->size; i++) {
 		const uint32_t index = (start + i) & mask;
-		if (!cache->hash_table[index]) {
-			cache->hash_table[index] = entry;
+		if (!table->entries[index]) {
+			p_atomic_set(&table->entries[index], entry);
 			break;
 		}
 	}
-
-	cache->total_size += entry_size(entry);
-	cache->kernel_count++;
 }
 
 
 static VkResult
 radv_pipeline_cache_grow(struct radv_pipeline_cache *cache)
 {
-	const uint32_t table_size = cache->table_size * 2;
-	const uint32_t old_table_size = cache->table_size;
-	const size_t byte_size = table_size * sizeof(cache->hash_table[0]);
-	struct cache_entry **table;
-	struct cache_entry **old_table = cache->hash_table;
+	struct radv_pipeline_cache_table *old_table = cache->table;
+	struct radv_pipeline_cache_table *table;
 
-	table = malloc(byte_size);
+	table = radv_pipeline_cache_table_create(old_table->size * 2);
 	if (table == NULL)
 		return vk_error(cache->device->instance, VK_ERROR_OUT_OF_HOST_MEMORY);
 
-	cache->hash_table = table;
-	cache->table_size = table_size;
-	cache->kernel_count = 0;
-	cache->total_size = 0;
-
-	memset(cache->hash_table, 0, byte_size);
-	for (uint32_t i = 0; i < old_table_size; i++) {
-		struct cache_entry *entry = old_table[i];
+	for (uint32_t i = 0; i < old_table->size; i++) {
+		struct cache_entry *entry = old_table->entries[i];
 		if (!entry)
 			continue;
 
-		radv_pipeline_cache_set_entry(cache, entry);
+		radv_pipeline_cache_set_entry(table, entry);
 	}
 
-	free(old_table);
+	/* Lookups still walking the old table find the same entries there. */
+	p_atomic_set(&cache->table, table);
+
+	old_table->next = cache->old_tables;
+	cache->old_tables = old_table;
 
 	return VK_SUCCESS;
 }
@@ -244,14 +246,20 @@ static void
 radv_pipeline_cache_add_entry(struct radv_pipeline_cache *cache,
 			      struct cache_entry *entry)
 {
-	if (cache->kernel_count == cache->table_size / 2)
+	if (!cache->table)
+		return;
+
+	if (cache->kernel_count == cache->table->size / 2)
 		radv_pipeline_cache_grow(cache);
 
 	/* Failing to grow that hash table isn't fatal, but may mean we don't
 	 * have enough space to add this new kernel. Only add it if there's room.
 	 */
-	if (cache->kernel_count < cache->table_size / 2)
-		radv_pipeline_cache_set_entry(cache, entry);
+	if (cache->kernel_count < cache->table->size / 2) {
+		radv_pipeline_cache_set_entry(cache->table, entry);
+		cache->total_size += entry_size(entry);
+		cache->kernel_count++;
+	}
 }
 
 static bool
@@ -277,9 +285,30 @@ radv_create_shader_variants_from_pipeline_cache(struct radv_device *device,
 		*found_in_application_cache = false;
 	}
 
+	/* Entries whose variants were all created already can be used without
+	 * the lock, the rest is serialized with inserts.
+	 */
+	entry = radv_pipeline_cache_search(cache, sha1);
+	if (entry) {
+		bool complete = true;
+
+		for (int i = 0; i < MESA_SHADER_STAGES; ++i) {
+			variants[i] = p_atomic_read(&entry->variants[i]);
+			if (!variants[i] && entry->binary_sizes[i])
+				complete = false;
+		}
+
+		if (complete) {
+			for (int i = 0; i < MESA_SHADER_STAGES; ++i)
+				if (variants[i])
+					p_atomic_inc(&variants[i]->ref_count);
+			return true;
+		}
+	}
+
 	radv_pipeline_cache_lock(cache);
 
-	entry = radv_pipeline_cache_search_unlocked(cache, sha1);
+	entry = radv_pipeline_cache_search(cache, sha1);
 
 	if (!entry) {
 		*found_in_application_cache = false;
@@ -329,7 +358,8 @@ radv_create_shader_variants_from_pipeline_cache(struct radv_device *device,
 			memcpy(binary, p, entry->binary_sizes[i]);
 			p += entry->binary_sizes[i];
 
-			entry->variants[i] = radv_shader_variant_create(device, binary, false);
+			p_atomic_set(&entry->variants[i],
+				     radv_shader_variant_create(device, binary, false));
 			free(binary);
 		} else if (entry->binary_sizes[i]) {
 			p += entry->binary_sizes[i];
@@ -363,14 +393,14 @@ radv_pipeline_cache_insert_shaders(struct radv_device *device,
 		cache = device->mem_cache;
 
 	radv_pipeline_cache_lock(cache);
-	struct cache_entry *entry = radv_pipeline_cache_search_unlocked(cache, sha1);
+	struct cache_entry *entry = radv_pipeline_cache_search(cache, sha1);
 	if (entry) {
 		for (int i = 0; i < MESA_SHADER_STAGES; ++i) {
 			if (entry->variants[i]) {
 				radv_shader_variant_destroy(cache->device, variants[i]);
 				variants[i] = entry->variants[i];
 			} else {
-				entry->variants[i] = variants[i];
+				p_atomic_set(&entry->variants[i], variants[i]);
 			}
 			if (variants[i])
 				p_atomic_inc(&variants[i]->ref_count);
@@ -587,11 +617,12 @@ VkResult radv_GetPipelineCacheData(
 	memcpy(header->uuid, device->physical_device->cache_uuid, VK_UUID_SIZE);
 	p += header->header_size;
 
+	struct radv_pipeline_cache_table *table = cache->table;
 	struct cache_entry *entry;
-	for (uint32_t i = 0; i < cache->table_size; i++) {
-		if (!cache->hash_table[i])
+	for (uint32_t i = 0; table && i < table->size; i++) {
+		if (!table->entries[i])
 			continue;
-		entry = cache->hash_table[i];
+		entry = table->entries[i];
 		const uint32_t size = entry_size(entry);
 		if (end < p + size) {
 			result = VK_INCOMPLETE;
@@ -613,15 +644,21 @@ static void
 radv_pipeline_cache_merge(struct radv_pipeline_cache *dst,
 			  struct radv_pipeline_cache *src)
 {
-	for (uint32_t i = 0; i < src->table_size; i++) {
-		struct cache_entry *entry = src->hash_table[i];
+	struct radv_pipeline_cache_table *table = src->table;
+
+	radv_pipeline_cache_lock(dst);
+
+	for (uint32_t i = 0; table && i < table->size; i++) {
+		struct cache_entry *entry = table->entries[i];
 		if (!entry || radv_pipeline_cache_search(dst, entry->sha1))
 			continue;
 
 		radv_pipeline_cache_add_entry(dst, entry);
 
-		src->hash_table[i] = NULL;
+		table->entries[i] = NULL;
 	}
+
+	radv_pipeline_cache_unlock(dst);
 }
 
 VkResult radv_MergePipelineCaches(
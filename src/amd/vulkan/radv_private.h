@@ -48,6 +48,7 @@
 #include "compiler/shader_enums.h"
 #include "util/macros.h"
 #include "util/list.h"
+#include "util/u_queue.h"
 #include "util/xmlconfig.h"
 #include "vk_alloc.h"
 #include "vk_debug_report.h"
@@ -357,16 +358,22 @@ bool radv_physical_device_extension_supported(struct radv_physical_device *dev,
 
 struct cache_entry;
 
+struct radv_pipeline_cache_table;
+
 struct radv_pipeline_cache {
 	struct vk_object_base                        base;
 	struct radv_device *                         device;
+	/* Serializes inserts, lookups don't take it. */
 	pthread_mutex_t                              mutex;
 	VkPipelineCacheCreateFlags                   flags;
 
 	uint32_t                                     total_size;
-	uint32_t                                     table_size;
 	uint32_t                                     kernel_count;
-	struct cache_entry **                        hash_table;
+	/* Replaced atomically when growing. Replaced tables are kept until
+	 * the cache is destroyed, since lookups may still be walking them.
+	 */
+	struct radv_pipeline_cache_table *           table;
+	struct radv_pipeline_cache_table *           old_tables;
 	bool                                         modified;
 
 	VkAllocationCallbacks                        alloc;
@@ -793,6 +800,14 @@ struct radv_device {
 	/* Backup in-memory cache to be used if the app doesn't provide one */
 	struct radv_pipeline_cache *                mem_cache;
 
+	/* Worker threads compiling independent stages of a pipeline. */
+	struct util_queue                            shader_compile_queue;
+
+	/* Worker threads creating the pipelines of a single
+	 * vkCreateGraphicsPipelines() call in parallel.
+	 */
+	struct util_queue                            pipeline_create_queue;
+
 	/*
 	 * use different counters so MSAA MRTs get consecutive surface indices,
 	 * even if MASK is allocated in between.
@@ -832,6 +847,8 @@ struct radv_device {
 	void *thread_trace_ptr;
 	uint32_t thread_trace_buffer_size;
 	int thread_trace_start_frame;
+	uint64_t thread_trace_spike_ns;
+	const char *thread_trace_trigger_file;
 
 	/* Overallocation. */
 	bool overallocation_disallowed;
@@ -1334,12 +1351,23 @@ struct radv_cmd_state {
 	uint32_t num_layout_transitions;
 };
 
+/* Upload buffers released by command buffer resets are kept in the pool,
+ * by power of two size from RADV_CMD_POOL_UPLOAD_MIN_SIZE, to be reused by
+ * the next command buffers which need to grow their upload buffer.
+ */
+#define RADV_CMD_POOL_UPLOAD_MIN_SIZE (16 * 1024)
+#define RADV_CMD_POOL_UPLOAD_SIZE_CLASSES 8
+#define RADV_CMD_POOL_UPLOAD_MAX_CACHED 32
+
 struct radv_cmd_pool {
 	struct vk_object_base                        base;
 	VkAllocationCallbacks                        alloc;
 	struct list_head                             cmd_buffers;
 	struct list_head                             free_cmd_buffers;
 	uint32_t queue_family_index;
+
+	struct list_head                             upload_cache[RADV_CMD_POOL_UPLOAD_SIZE_CLASSES];
+	unsigned                                     upload_cache_count[RADV_CMD_POOL_UPLOAD_SIZE_CLASSES];
 };
 
 struct radv_cmd_buffer_upload {
@@ -48,6 +48,7 @@
 #include "aco_interface.h"
 
 #include "util/string_buffer.h"
+#include "util/u_cpu_trace.h"
 
 static const struct nir_shader_compiler_options nir_options_llvm = {
 	.vertex_id_zero_based = true,
@@ -208,6 +209,7 @@ void
 radv_optimize_nir(struct nir_shader *shader, bool optimize_conservatively,
                   bool allow_copies)
 {
+        struct set *skip = _mesa_pointer_set_create(NULL);
         bool progress;
         unsigned lower_flrp =
                 (shader->options->lower_flrp16 ? 16 : 0) |
@@ -217,11 +219,11 @@ radv_optimize_nir(struct nir_shader *shader, bool optimize_conservatively,
         do {
                 progress = false;
 
-		NIR_PASS(progress, shader, nir_split_array_vars, nir_var_function_temp);
-		NIR_PASS(progress, shader, nir_shrink_vec_array_vars, nir_var_function_temp);
+		NIR_LOOP_PASS(progress, skip, shader, nir_split_array_vars, nir_var_function_temp);
+		NIR_LOOP_PASS(progress, skip, shader, nir_shrink_vec_array_vars, nir_var_function_temp);
 
-                NIR_PASS_V(shader, nir_lower_vars_to_ssa);
-		NIR_PASS_V(shader, nir_lower_pack);
+                NIR_LOOP_PASS_V(skip, shader, nir_lower_vars_to_ssa);
+		NIR_LOOP_PASS_V(skip, shader, nir_lower_pack);
 
 		if (allow_copies) {
 			/* Only run this pass in the first call to
@@ -229,45 +231,49 @@ radv_optimize_nir(struct nir_shader *shader, bool optimize_conservatively,
 			 * lowered away any copy_deref instructions and we
 			 *  don't want to introduce any more.
 			*/
-			NIR_PASS(progress, shader, nir_opt_find_array_copies);
+			NIR_LOOP_PASS(progress, skip, shader, nir_opt_find_array_copies);
 		}
 
-		NIR_PASS(progress, shader, nir_opt_copy_prop_vars);
-		NIR_PASS(progress, shader, nir_opt_dead_write_vars);
-		NIR_PASS(progress, shader, nir_remove_dead_variables,
-			 nir_var_function_temp | nir_var_shader_in | nir_var_shader_out,
-			 NULL);
-
-                NIR_PASS_V(shader, nir_lower_alu_to_scalar, NULL, NULL);
-                NIR_PASS_V(shader, nir_lower_phis_to_scalar);
-
-                NIR_PASS(progress, shader, nir_copy_prop);
-                NIR_PASS(progress, shader, nir_opt_remove_phis);
-                NIR_PASS(progress, shader, nir_opt_dce);
-                if (nir_opt_trivial_continues(shader)) {
+		NIR_LOOP_PASS(progress, skip, shader, nir_opt_copy_prop_vars);
+		NIR_LOOP_PASS(progress, skip, shader, nir_opt_dead_write_vars);
+		NIR_LOOP_PASS(progress, skip, shader, nir_remove_dead_variables,
+			      nir_var_function_temp | nir_var_shader_in | nir_var_shader_out,
+			      NULL);
+
+                NIR_LOOP_PASS_V(skip, shader, nir_lower_alu_to_scalar, NULL, NULL);
+                NIR_LOOP_PASS_V(skip, shader, nir_lower_phis_to_scalar);
+
+                NIR_LOOP_PASS(progress, skip, shader, nir_copy_prop);
+                NIR_LOOP_PASS(progress, skip, shader, nir_opt_remove_phis);
+                NIR_LOOP_PASS(progress, skip, shader, nir_opt_dce);
+                bool trivial_continues_progress = false;
+                NIR_LOOP_PASS(trivial_continues_progress, skip, shader,
+                              nir_opt_trivial_continues);
+                if (trivial_continues_progress) {
                         progress = true;
-                        NIR_PASS(progress, shader, nir_copy_prop);
-			NIR_PASS(progress, shader, nir_opt_remove_phis);
-                        NIR_PASS(progress, shader, nir_opt_dce);
+                        NIR_LOOP_PASS(progress, skip, shader, nir_copy_prop);
+			NIR_LOOP_PASS(progress, skip, shader, nir_opt_remove_phis);
+                        NIR_LOOP_PASS(progress, skip, shader, nir_opt_dce);
                 }
-                NIR_PASS(progress, shader, nir_opt_if, true);
-                NIR_PASS(progress, shader, nir_opt_dead_cf);
-                NIR_PASS(progress, shader, nir_opt_cse);
-                NIR_PASS(progress, shader, nir_opt_peephole_select, 8, true, true);
-                NIR_PASS(progress, shader, nir_opt_constant_folding);
-                NIR_PASS(progress, shader, nir_opt_algebraic);
+                NIR_LOOP_PASS(progress, skip, shader, nir_opt_if, true);
+                NIR_LOOP_PASS(progress, skip, shader, nir_opt_dead_cf);
+                NIR_LOOP_PASS(progress, skip, shader, nir_opt_cse);
+                NIR_LOOP_PASS(progress, skip, shader, nir_opt_peephole_select, 8, true, true);
+                NIR_LOOP_PASS(progress, skip, shader, nir_opt_constant_folding);
+                NIR_LOOP_PASS(progress, skip, shader, nir_opt_algebraic);
 
                 if (lower_flrp != 0) {
                         bool lower_flrp_progress = false;
-                        NIR_PASS(lower_flrp_progress,
-                                 shader,
-                                 nir_lower_flrp,
-                                 lower_flrp,
-                                 false /* always_precise */,
-                                 shader->options->lower_ffma);
+                        NIR_LOOP_PASS(lower_flrp_progress,
+                                      skip,
+                                      shader,
+                                      nir_lower_flrp,
+                                      lower_flrp,
+                                      false /* always_precise */,
+                                      shader->options->lower_ffma);
                         if (lower_flrp_progress) {
-                                NIR_PASS(progress, shader,
-                                         nir_opt_constant_folding);
+                                NIR_LOOP_PASS(progress, skip, shader,
+                                              nir_opt_constant_folding);
                                 progress = true;
                         }
 
@@ -277,12 +283,14 @@ radv_optimize_nir(struct nir_shader *shader, bool optimize_conservatively,
                         lower_flrp = 0;
                 }
 
-                NIR_PASS(progress, shader, nir_opt_undef);
+                NIR_LOOP_PASS(progress, skip, shader, nir_opt_undef);
                 if (shader->options->max_unroll_iterations) {
-                        NIR_PASS(progress, shader, nir_opt_loop_unroll, 0);
+                        NIR_LOOP_PASS(progress, skip, shader, nir_opt_loop_unroll, 0);
                 }
         } while (progress && !optimize_conservatively);
 
+        _mesa_set_destroy(skip, NULL);
+
 	NIR_PASS(progress, shader, nir_opt_conditional_discard);
         NIR_PASS(progress, shader, nir_opt_shrink_vectors);
         NIR_PASS(progress, shader, nir_opt_move, nir_move_load_ubo);
@@ -1232,6 +1240,7 @@ radv_shader_variant_compile(struct radv_device *device,
 			   bool keep_shader_info, bool keep_statistic_info,
 			   struct radv_shader_binary **binary_out)
 {
+	UTIL_CPU_TRACE_FUNC();
 	struct radv_nir_compiler_options options = {0};
 
 	options.layout = layout;
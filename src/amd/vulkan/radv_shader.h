@@ -127,6 +127,7 @@ struct radv_shader_variant_key {
 		struct radv_vs_out_key vs_common_out;
 	};
 	bool has_multiview_view_index;
+	bool optimisations_disabled;
 };
 
 struct radv_nir_compiler_options {
@@ -683,10 +683,32 @@ static void radv_amdgpu_cs_execute_secondary(struct radeon_cmdbuf *_parent,
 	if (parent->status != VK_SUCCESS || child->status != VK_SUCCESS)
 		return;
 
-	for (unsigned i = 0; i < child->num_buffers; ++i) {
-		radv_amdgpu_cs_add_buffer_internal(parent,
-		                                   child->handles[i].bo_handle,
-		                                   child->handles[i].bo_priority);
+	if (!parent->num_buffers && child->num_buffers) {
+		/* The child's list has no duplicates already, take it as is
+		 * instead of looking each buffer up.
+		 */
+		if (parent->max_num_buffers < child->num_buffers) {
+			struct drm_amdgpu_bo_list_entry *new_entries =
+				realloc(parent->handles, child->num_buffers * sizeof(*new_entries));
+			if (!new_entries) {
+				parent->status = VK_ERROR_OUT_OF_HOST_MEMORY;
+				return;
+			}
+			parent->max_num_buffers = child->num_buffers;
+			parent->handles = new_entries;
+		}
+
+		memcpy(parent->handles, child->handles,
+		       child->num_buffers * sizeof(*parent->handles));
+		memcpy(parent->buffer_hash_table, child->buffer_hash_table,
+		       sizeof(parent->buffer_hash_table));
+		parent->num_buffers = child->num_buffers;
+	} else {
+		for (unsigned i = 0; i < child->num_buffers; ++i) {
+			radv_amdgpu_cs_add_buffer_internal(parent,
+			                                   child->handles[i].bo_handle,
+			                                   child->handles[i].bo_priority);
+		}
 	}
 
 	for (unsigned i = 0; i < child->num_virtual_buffers; ++i) {
@@ -702,11 +724,22 @@ static void radv_amdgpu_cs_execute_secondary(struct radeon_cmdbuf *_parent,
 		radeon_emit(&parent->base, child->ib.ib_mc_address >> 32);
 		radeon_emit(&parent->base, child->ib.size);
 	} else {
-		if (parent->base.cdw + child->base.cdw > parent->base.max_dw)
-			radv_amdgpu_cs_grow(&parent->base, child->base.cdw);
+		/* Without IB buffers there is nothing the parent could jump to,
+		 * copy all of the child's dwords, including the buffers it
+		 * filled before hitting the IB size limit.
+		 */
+		for (unsigned i = 0; i <= child->num_old_cs_buffers; ++i) {
+			const struct radeon_cmdbuf *buf = i < child->num_old_cs_buffers ?
+				&child->old_cs_buffers[i] : &child->base;
 
-		memcpy(parent->base.buf + parent->base.cdw, child->base.buf, 4 * child->base.cdw);
-		parent->base.cdw += child->base.cdw;
+			if (parent->base.cdw + buf->cdw > parent->base.max_dw)
+				radv_amdgpu_cs_grow(&parent->base, buf->cdw);
+			if (parent->status != VK_SUCCESS)
+				return;
+
+			memcpy(parent->base.buf + parent->base.cdw, buf->buf, 4 * buf->cdw);
+			parent->base.cdw += buf->cdw;
+		}
 	}
 }
 
@@ -83,6 +83,7 @@
 #include <math.h>
 #include "builtin_functions.h"
 #include "util/hash_table.h"
+#include "util/set.h"
 
 #define M_PIf   ((float) M_PI)
 #define M_PI_2f ((float) M_PI_2)
@@ -878,19 +879,42 @@ public:
    void release();
    ir_function_signature *find(_mesa_glsl_parse_state *state,
                                const char *name, exec_list *actual_parameters);
+   ir_function *get_function(const char *name);
 
    /**
     * A shader to hold all the built-in signatures; created by this module.
     *
-    * This includes signatures for every built-in, regardless of version or
-    * enabled extensions.  The availability predicate associated with each
-    * signature allows matching_signature() to filter out the irrelevant ones.
+    * This includes signatures for every built-in which was looked up so far,
+    * regardless of version or enabled extensions.  The availability predicate
+    * associated with each signature allows matching_signature() to filter out
+    * the irrelevant ones.
     */
    gl_shader *shader;
 
 private:
    void *mem_ctx;
 
+   /**
+    * Names create_builtins() was already run for.
+    *
+    * Building the IR of every built-in up front is a noticeable part of the
+    * startup of short-lived processes, while a shader only calls a handful of
+    * them, so a built-in function is only created the first time its name is
+    * looked up.
+    */
+   struct set *created_names;
+
+   /**
+    * Name of the only built-in function create_builtins() should create, or
+    * NULL to create all of those it's asked to.
+    */
+   const char *requested_name;
+
+   bool wants_function(const char *name) const
+   {
+      return requested_name == NULL || strcmp(name, requested_name) == 0;
+   }
+
    void create_shader();
    void create_intrinsics();
    void create_builtins();
@@ -1263,7 +1287,7 @@ enum image_function_flags {
  *  @{
  */
 builtin_builder::builtin_builder()
-   : shader(NULL)
+   : shader(NULL), created_names(NULL), requested_name(NULL)
 {
    mem_ctx = NULL;
 }
@@ -1286,7 +1310,7 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
     */
    state->uses_builtin_functions = true;
 
-   ir_function *f = shader->symbols->get_function(name);
+   ir_function *f = get_function(name);
    if (f == NULL)
       return NULL;
 
@@ -1298,6 +1322,24 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
    return sig;
 }
 
+/**
+ * Look up a built-in function by name, creating it if this is the first
+ * time it's asked for.
+ */
+ir_function *
+builtin_builder::get_function(const char *name)
+{
+   if (_mesa_set_search(created_names, name) == NULL) {
+      _mesa_set_add(created_names, ralloc_strdup(mem_ctx, name));
+
+      requested_name = name;
+      create_builtins();
+      requested_name = NULL;
+   }
+
+   return shader->symbols->get_function(name);
+}
+
 void
 builtin_builder::initialize()
 {
@@ -1308,9 +1350,12 @@ builtin_builder::initialize()
    glsl_type_singleton_init_or_ref();
 
    mem_ctx = ralloc_context(NULL);
+   created_names = _mesa_set_create(mem_ctx, _mesa_hash_string,
+                                    _mesa_key_string_equal);
    create_shader();
+
+   /* The built-ins call into the intrinsics, these are always created. */
    create_intrinsics();
-   create_builtins();
 }
 
 void
@@ -1318,6 +1363,7 @@ builtin_builder::release()
 {
    ralloc_free(mem_ctx);
    mem_ctx = NULL;
+   created_names = NULL;
 
    ralloc_free(shader);
    shader = NULL;
@@ -1549,8 +1595,16 @@ builtin_builder::create_intrinsics()
 /**
  * Create ir_function and ir_function_signature objects for each built-in.
  *
- * Contains a list of every available built-in.
+ * Contains a list of every available built-in.  Only the function named
+ * requested_name is created, the signatures passed to add_function() are
+ * not even built for the others.
  */
+#define add_function(NAME, ...)                    \
+   do {                                            \
+      if (wants_function(NAME))                    \
+         add_function(NAME, __VA_ARGS__);          \
+   } while (0)
+
 void
 builtin_builder::create_builtins()
 {
@@ -4559,6 +4613,8 @@ builtin_builder::create_builtins()
 #undef FIU2_MIXED
 }
 
+#undef add_function
+
 void
 builtin_builder::add_function(const char *name, ...)
 {
@@ -4629,6 +4685,9 @@ builtin_builder::add_image_function(const char *name,
       glsl_type::uimage2DMSArray_type
    };
 
+   if (!wants_function(name))
+      return;
+
    ir_function *f = new(mem_ctx) ir_function(name);
 
    for (unsigned i = 0; i < ARRAY_SIZE(types); ++i) {
@@ -7681,7 +7740,7 @@ _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state, const char *name)
    ir_function *f;
    bool ret = false;
    mtx_lock(&builtins_lock);
-   f = builtins.shader->symbols->get_function(name);
+   f = builtins.get_function(name);
    if (f != NULL) {
       foreach_in_list(ir_function_signature, sig, &f->signatures) {
          if (sig->is_builtin_available(state)) {
@@ -7701,6 +7760,17 @@ _mesa_glsl_get_builtin_function_shader()
    return builtins.shader;
 }
 
+ir_function *
+_mesa_glsl_get_builtin_function(const char *name)
+{
+   ir_function *f;
+   mtx_lock(&builtins_lock);
+   f = builtins.get_function(name);
+   mtx_unlock(&builtins_lock);
+
+   return f;
+}
+
 
 /**
  * Get the function signature for main from a shader
@@ -51,6 +51,9 @@ _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state,
 extern gl_shader *
 _mesa_glsl_get_builtin_function_shader(void);
 
+extern ir_function *
+_mesa_glsl_get_builtin_function(const char *name);
+
 extern ir_function_signature *
 _mesa_get_main_function_signature(glsl_symbol_table *symbols);
 
@@ -34,6 +34,7 @@
 #include "util/ralloc.h"
 #include "util/disk_cache.h"
 #include "util/mesa-sha1.h"
+#include "util/os_time.h"
 #include "ast.h"
 #include "glsl_parser_extras.h"
 #include "glsl_parser.h"
@@ -2078,8 +2079,9 @@ opt_shader_and_create_symbol_table(struct gl_context *ctx,
                              ctx->Const.NativeIntegers);
    } else {
       /* Repeat it until it stops making changes. */
+      glsl_common_opt_state opt_state;
       while (do_common_optimization(shader->ir, false, false, options,
-                                    ctx->Const.NativeIntegers))
+                                    ctx->Const.NativeIntegers, &opt_state))
          ;
    }
 
@@ -2122,10 +2124,60 @@ opt_shader_and_create_symbol_table(struct gl_context *ctx,
                                       shader->symbols);
 }
 
+/**
+ * Whether running \p source through glcpp could change what the GLSL lexer
+ * sees.  That is not the case when the only directive is a leading
+ * #version and there are no comments, line continuations or identifiers
+ * which might name a predefined macro (__VERSION__, GL_ES, extension
+ * names, ...).  Checking this is much cheaper than preprocessing.
+ */
+static bool
+source_needs_preprocessing(const char *source)
+{
+   const char *s = source + strspn(source, " \t\n");
+
+   if (*s == '#') {
+      s++;
+      s += strspn(s, " \t");
+      if (strncmp(s, "version", 7) != 0 || (s[7] != ' ' && s[7] != '\t'))
+         return true;
+      s += 7;
+   }
+
+   for (; *s != '\0'; s++) {
+      switch (*s) {
+      case '#':
+      case '\\':
+      case '\v':
+      case '\f':
+         return true;
+      case '\r':
+         /* The GLSL lexer only counts '\n' as a line break. */
+         if (s[1] != '\n')
+            return true;
+         break;
+      case '/':
+         if (s[1] == '/' || s[1] == '*')
+            return true;
+         break;
+      case '_':
+         if (s[1] == '_')
+            return true;
+         break;
+      case 'G':
+         if (s[1] == 'L' && s[2] == '_')
+            return true;
+         break;
+      }
+   }
+
+   return false;
+}
+
 static bool
 can_skip_compile(struct gl_context *ctx, struct gl_shader *shader,
                  const char *source, bool force_recompile,
-                 bool source_has_shader_include)
+                 bool source_has_shader_include, GLbitfield shader_flags)
 {
    if (!force_recompile) {
       if (ctx->Cache) {
@@ -2134,7 +2186,7 @@ can_skip_compile(struct gl_context *ctx, struct gl_shader *shader,
                                 shader->sha1);
          if (disk_cache_has_key(ctx->Cache, shader->sha1)) {
             /* We've seen this shader before and know it compiles */
-            if (ctx->_Shader->Flags & GLSL_CACHE_INFO) {
+            if (shader_flags & GLSL_CACHE_INFO) {
                _mesa_sha1_format(buf, shader->sha1);
                fprintf(stderr, "deferring compile of shader: %s\n", buf);
             }
@@ -2165,7 +2217,8 @@ can_skip_compile(struct gl_context *ctx, struct gl_shader *shader,
 
 void
 _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
-                          bool dump_ast, bool dump_hir, bool force_recompile)
+                          bool dump_ast, bool dump_hir, bool force_recompile,
+                          GLbitfield shader_flags)
 {
    const char *source = force_recompile && shader->FallbackSource ?
       shader->FallbackSource : shader->Source;
@@ -2182,7 +2235,8 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
     * keep duplicate copies of the shader include source tree and paths.
     */
    if (!source_has_shader_include &&
-       can_skip_compile(ctx, shader, source, force_recompile, false))
+       can_skip_compile(ctx, shader, source, force_recompile, false,
+                        shader_flags))
       return;
 
     struct _mesa_glsl_parse_state *state =
@@ -2192,7 +2246,8 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
       (void) p_atomic_cmpxchg(&ir_variable::temporaries_allocate_names,
                               false, true);
 
-   if (!source_has_shader_include || !force_recompile) {
+   if ((!source_has_shader_include || !force_recompile) &&
+       source_needs_preprocessing(source)) {
       state->error = glcpp_preprocess(state, &source, &state->info_log,
                                       add_builtin_defines, state, ctx);
    }
@@ -2202,7 +2257,8 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
     * include.
     */
    if (source_has_shader_include &&
-       can_skip_compile(ctx, shader, source, force_recompile, true))
+       can_skip_compile(ctx, shader, source, force_recompile, true,
+                        shader_flags))
       return;
 
    if (!state->error) {
@@ -2274,7 +2330,7 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
    if (ctx->Cache && shader->CompileStatus == COMPILE_SUCCESS) {
       char sha1_buf[41];
       disk_cache_put_key(ctx->Cache, shader->sha1);
-      if (ctx->_Shader->Flags & GLSL_CACHE_INFO) {
+      if (shader_flags & GLSL_CACHE_INFO) {
          _mesa_sha1_format(sha1_buf, shader->sha1);
          fprintf(stderr, "marking shader: %s\n", sha1_buf);
       }
@@ -2282,6 +2338,20 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
 }
 
 } /* extern "C" */
+
+/**
+ * Whether MESA_GLSL contains "opt_time", to print how long each pass of
+ * do_common_optimization() takes.
+ */
+static bool
+opt_timing_enabled()
+{
+   static const char *const env = getenv("MESA_GLSL");
+   static const bool enabled = env && strstr(env, "opt_time");
+
+   return enabled;
+}
+
 /**
  * Do the set of common optimizations passes
  *
@@ -2300,28 +2370,53 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
  *                                    implementations supporting integers
  *                                    natively (as opposed to supporting
  *                                    integers in floating point registers).
+ * \param state                       State kept between the calls of an
+ *                                    optimization loop, used to skip the
+ *                                    passes which can't make progress.  May
+ *                                    be \c NULL.
  */
 bool
 do_common_optimization(exec_list *ir, bool linked,
 		       bool uniform_locations_assigned,
                        const struct gl_shader_compiler_options *options,
-                       bool native_integers)
+                       bool native_integers,
+                       glsl_common_opt_state *state)
 {
    const bool debug = false;
+   const bool timing = opt_timing_enabled();
    bool progress = false;
 
+   /* Without a state nothing can be skipped, each pass runs once anyway. */
+   glsl_common_opt_state local_state;
+   if (state == NULL)
+      state = &local_state;
+
+   unsigned pass_index = 0;
+
 #define OPT(PASS, ...) do {                                             \
-      if (debug) {                                                      \
+      const unsigned index = pass_index++;                              \
+      assert(index < ARRAY_SIZE(state->clean_generation));              \
+      if (state->clean_generation[index] == state->generation)          \
+         break;                                                         \
+      if (debug)                                                        \
          fprintf(stderr, "START GLSL optimization %s\n", #PASS);        \
-         const bool opt_progress = PASS(__VA_ARGS__);                   \
-         progress = opt_progress || progress;                           \
+      const int64_t start = timing ? os_time_get_nano() : 0;            \
+      const bool opt_progress = PASS(__VA_ARGS__);                      \
+      if (timing) {                                                     \
+         fprintf(stderr, "GLSL optimization %s: %" PRId64 " ns\n",      \
+                 #PASS, os_time_get_nano() - start);                    \
+      }                                                                 \
+      if (debug) {                                                      \
          if (opt_progress)                                              \
             _mesa_print_ir(stderr, ir, NULL);                           \
          fprintf(stderr, "GLSL optimization %s: %s progress\n",         \
                  #PASS, opt_progress ? "made" : "no");                  \
-      } else {                                                          \
-         progress = PASS(__VA_ARGS__) || progress;                      \
       }                                                                 \
+      if (opt_progress)                                                 \
+         state->generation++;                                           \
+      else                                                              \
+         state->clean_generation[index] = state->generation;            \
+      progress = opt_progress || progress;                              \
    } while (false)
 
    OPT(lower_instructions, ir, SUB_TO_ADD_NEG);
@@ -2375,8 +2470,10 @@ do_common_optimization(exec_list *ir, bool linked,
     * causes to constant arrays.
     */
    bool array_split = optimize_split_arrays(ir, linked);
-   if (array_split)
+   if (array_split) {
       do_constant_propagation(ir);
+      state->generation++;
+   }
    progress |= array_split;
 
    OPT(optimize_redundant_jumps, ir);
@@ -2384,7 +2481,8 @@ do_common_optimization(exec_list *ir, bool linked,
    if (options->MaxUnrollIterations) {
       loop_state *ls = analyze_loop_variables(ir);
       if (ls->loop_found) {
-         bool loop_progress = unroll_loops(ir, ls, options);
+         bool unrolled = unroll_loops(ir, ls, options);
+         bool loop_progress = unrolled;
          while (loop_progress) {
             loop_progress = false;
             loop_progress |= do_constant_propagation(ir);
@@ -2408,7 +2506,9 @@ do_common_optimization(exec_list *ir, bool linked,
                                             options->EmitNoCont,
                                             options->EmitNoLoops);
          }
-         progress |= loop_progress;
+         if (unrolled)
+            state->generation++;
+         progress |= unrolled;
       }
       delete ls;
    }
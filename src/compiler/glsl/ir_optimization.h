@@ -90,10 +90,32 @@ enum lower_packing_builtins_op {
    LOWER_PACK_USE_BFE                   = 0x0800,
 };
 
+/**
+ * State kept by do_common_optimization() between the iterations of an
+ * optimization loop over the same IR.
+ *
+ * A pass is a function of the IR only, so once it ran without making
+ * progress it can't make any until some other pass changes the IR again.
+ * The IR must not be changed by anything else while the state is in use.
+ */
+struct glsl_common_opt_state {
+   glsl_common_opt_state() : generation(1)
+   {
+      memset(clean_generation, 0, sizeof(clean_generation));
+   }
+
+   /** Incremented every time a pass makes progress. */
+   unsigned generation;
+
+   /** Generation each pass last ran on without making progress. */
+   unsigned clean_generation[32];
+};
+
 bool do_common_optimization(exec_list *ir, bool linked,
 			    bool uniform_locations_assigned,
                             const struct gl_shader_compiler_options *options,
-                            bool native_integers);
+                            bool native_integers,
+                            glsl_common_opt_state *state = NULL);
 
 bool ir_constant_fold(ir_rvalue **rvalue);
 
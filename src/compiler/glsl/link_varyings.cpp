@@ -38,6 +38,7 @@
 #include "link_varyings.h"
 #include "main/macros.h"
 #include "util/hash_table.h"
+#include "util/set.h"
 #include "util/u_math.h"
 #include "program.h"
 
@@ -1064,6 +1065,35 @@ tfeedback_decl::is_same(const tfeedback_decl &x, const tfeedback_decl &y)
 }
 
 
+/**
+ * Hash of the variable and array index of a tfeedback_decl, consistent with
+ * is_same().
+ */
+uint32_t
+tfeedback_decl::hash(const tfeedback_decl &x)
+{
+   assert(x.is_varying());
+
+   uint32_t hash = _mesa_hash_string(x.var_name);
+   if (x.is_subscripted)
+      hash = hash * 31 + x.array_subscript + 1;
+   return hash;
+}
+
+static uint32_t
+tfeedback_decl_hash(const void *x)
+{
+   return tfeedback_decl::hash(*(const tfeedback_decl *) x);
+}
+
+static bool
+tfeedback_decl_equal(const void *x, const void *y)
+{
+   return tfeedback_decl::is_same(*(const tfeedback_decl *) x,
+                                  *(const tfeedback_decl *) y);
+}
+
+
 /**
  * Assign a location and stream ID for this tfeedback_decl object based on the
  * transform feedback candidate found by find_candidate.
@@ -1431,6 +1461,13 @@ parse_tfeedback_decls(struct gl_context *ctx, struct gl_shader_program *prog,
                       const void *mem_ctx, unsigned num_names,
                       char **varying_names, tfeedback_decl *decls)
 {
+   /* Programs may capture hundreds of varyings, check for duplicates with a
+    * set rather than by comparing every pair of declarations.
+    */
+   struct set *seen = _mesa_set_create(NULL, tfeedback_decl_hash,
+                                       tfeedback_decl_equal);
+   bool ok = true;
+
    for (unsigned i = 0; i < num_names; ++i) {
       decls[i].init(ctx, mem_ctx, varying_names[i]);
 
@@ -1447,17 +1484,17 @@ parse_tfeedback_decls(struct gl_context *ctx, struct gl_shader_program *prog,
        * specify the same varying variable and array index", since transform
        * feedback of arrays would be useless otherwise.
        */
-      for (unsigned j = 0; j < i; ++j) {
-         if (decls[j].is_varying()) {
-            if (tfeedback_decl::is_same(decls[i], decls[j])) {
-               linker_error(prog, "Transform feedback varying %s specified "
-                            "more than once.", varying_names[i]);
-               return false;
-            }
-         }
+      if (_mesa_set_search(seen, &decls[i]) != NULL) {
+         linker_error(prog, "Transform feedback varying %s specified "
+                      "more than once.", varying_names[i]);
+         ok = false;
+         break;
       }
+      _mesa_set_add(seen, &decls[i]);
    }
-   return true;
+
+   _mesa_set_destroy(seen, NULL);
+   return ok;
 }
 
 
@@ -2347,10 +2384,10 @@ var_counts_against_varying_limit(gl_shader_stage stage, const ir_variable *var)
 class tfeedback_candidate_generator : public program_resource_visitor
 {
 public:
-   tfeedback_candidate_generator(void *mem_ctx,
+   tfeedback_candidate_generator(void *lin_ctx,
                                  hash_table *tfeedback_candidates,
                                  gl_shader_stage stage)
-      : mem_ctx(mem_ctx),
+      : lin_ctx(lin_ctx),
         tfeedback_candidates(tfeedback_candidates),
         stage(stage),
         toplevel_var(NULL),
@@ -2385,21 +2422,21 @@ private:
       assert(!type->without_array()->is_struct());
       assert(!type->without_array()->is_interface());
 
-      tfeedback_candidate *candidate
-         = rzalloc(this->mem_ctx, tfeedback_candidate);
+      tfeedback_candidate *candidate = (tfeedback_candidate *)
+         linear_zalloc_child(this->lin_ctx, sizeof(tfeedback_candidate));
       candidate->toplevel_var = this->toplevel_var;
       candidate->type = type;
       candidate->offset = this->varying_floats;
       _mesa_hash_table_insert(this->tfeedback_candidates,
-                              ralloc_strdup(this->mem_ctx, name),
+                              linear_strdup(this->lin_ctx, name),
                               candidate);
       this->varying_floats += type->component_slots();
    }
 
    /**
-    * Memory context used to allocate hash table keys and values.
+    * Linear allocator used for hash table keys and values.
     */
-   void * const mem_ctx;
+   void * const lin_ctx;
 
    /**
     * Hash table in which tfeedback_candidate objects should be stored.
@@ -2425,7 +2462,7 @@ private:
 namespace linker {
 
 void
-populate_consumer_input_sets(void *mem_ctx, exec_list *ir,
+populate_consumer_input_sets(void *lin_ctx, exec_list *ir,
                              hash_table *consumer_inputs,
                              hash_table *consumer_interface_inputs,
                              ir_variable *consumer_inputs_with_locations[VARYING_SLOT_TESS_MAX])
@@ -2462,14 +2499,14 @@ populate_consumer_input_sets(void *mem_ctx, exec_list *ir,
                input_var;
          } else if (input_var->get_interface_type() != NULL) {
             char *const iface_field_name =
-               ralloc_asprintf(mem_ctx, "%s.%s",
+               linear_asprintf(lin_ctx, "%s.%s",
                   input_var->get_interface_type()->without_array()->name,
                   input_var->name);
             _mesa_hash_table_insert(consumer_interface_inputs,
                                     iface_field_name, input_var);
          } else {
             _mesa_hash_table_insert(consumer_inputs,
-                                    ralloc_strdup(mem_ctx, input_var->name),
+                                    linear_strdup(lin_ctx, input_var->name),
                                     input_var);
          }
       }
@@ -2483,7 +2520,7 @@ populate_consumer_input_sets(void *mem_ctx, exec_list *ir,
  * validation (here) that the types, etc. are compatible.
  */
 ir_variable *
-get_matching_input(void *mem_ctx,
+get_matching_input(void *lin_ctx,
                    const ir_variable *output_var,
                    hash_table *consumer_inputs,
                    hash_table *consumer_interface_inputs,
@@ -2495,7 +2532,7 @@ get_matching_input(void *mem_ctx,
       input_var = consumer_inputs_with_locations[output_var->data.location];
    } else if (output_var->get_interface_type() != NULL) {
       char *const iface_field_name =
-         ralloc_asprintf(mem_ctx, "%s.%s",
+         linear_asprintf(lin_ctx, "%s.%s",
             output_var->get_interface_type()->without_array()->name,
             output_var->name);
       hash_entry *entry = _mesa_hash_table_search(consumer_interface_inputs, iface_field_name);
@@ -2690,6 +2727,12 @@ assign_varying_locations(struct gl_context *ctx,
                            producer ? producer->Stage : MESA_SHADER_NONE,
                            consumer ? consumer->Stage : MESA_SHADER_NONE);
    void *hash_table_ctx = ralloc_context(NULL);
+
+   /* Hash table keys and transform feedback candidates are never freed
+    * individually.  The candidates are referenced by tfeedback_decls, so
+    * they have to live as long as mem_ctx.
+    */
+   void *lin_ctx = linear_alloc_parent(mem_ctx, 0);
    hash_table *tfeedback_candidates =
          _mesa_hash_table_create(hash_table_ctx, _mesa_hash_string,
                                  _mesa_key_string_equal);
@@ -2729,7 +2772,7 @@ assign_varying_locations(struct gl_context *ctx,
       canonicalize_shader_io(producer->ir, ir_var_shader_out);
 
    if (consumer)
-      linker::populate_consumer_input_sets(mem_ctx, consumer->ir,
+      linker::populate_consumer_input_sets(lin_ctx, consumer->ir,
                                            consumer_inputs,
                                            consumer_interface_inputs,
                                            consumer_inputs_with_locations);
@@ -2747,7 +2790,7 @@ assign_varying_locations(struct gl_context *ctx,
                  producer->Stage == MESA_SHADER_GEOMETRY));
 
          if (num_tfeedback_decls > 0) {
-            tfeedback_candidate_generator g(mem_ctx, tfeedback_candidates, producer->Stage);
+            tfeedback_candidate_generator g(lin_ctx, tfeedback_candidates, producer->Stage);
             /* From OpenGL 4.6 (Core Profile) spec, section 11.1.2.1
              * ("Vertex Shader Variables / Output Variables")
              *
@@ -2772,7 +2815,7 @@ assign_varying_locations(struct gl_context *ctx,
          }
 
          ir_variable *const input_var =
-            linker::get_matching_input(mem_ctx, output_var, consumer_inputs,
+            linker::get_matching_input(lin_ctx, output_var, consumer_inputs,
                                        consumer_interface_inputs,
                                        consumer_inputs_with_locations);
 
@@ -2854,13 +2897,14 @@ assign_varying_locations(struct gl_context *ctx,
          }
 
          /* Create new candidate and replace matched_candidate */
-         new_candidate = rzalloc(mem_ctx, tfeedback_candidate);
+         new_candidate = (tfeedback_candidate *)
+            linear_zalloc_child(lin_ctx, sizeof(tfeedback_candidate));
          new_candidate->toplevel_var = new_var;
          new_candidate->toplevel_var->data.is_unmatched_generic_inout = 1;
          new_candidate->type = new_var->type;
          new_candidate->offset = 0;
          _mesa_hash_table_insert(tfeedback_candidates,
-                                 ralloc_strdup(mem_ctx, new_var->name),
+                                 linear_strdup(lin_ctx, new_var->name),
                                  new_candidate);
 
          tfeedback_decls[i].set_lowered_candidate(new_candidate);
@@ -2882,7 +2926,7 @@ assign_varying_locations(struct gl_context *ctx,
        * start removing things we shouldn't.
        */
       ir_variable *const input_var =
-         linker::get_matching_input(mem_ctx, matched_candidate->toplevel_var,
+         linker::get_matching_input(lin_ctx, matched_candidate->toplevel_var,
                                     consumer_inputs,
                                     consumer_interface_inputs,
                                     consumer_inputs_with_locations);
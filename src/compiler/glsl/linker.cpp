@@ -85,6 +85,9 @@
 #include "shader_cache.h"
 #include "util/u_string.h"
 #include "util/u_math.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_queue.h"
+#include "c11/threads.h"
 
 
 #include "main/shaderobj.h"
@@ -4536,20 +4539,145 @@ static void
 linker_optimisation_loop(struct gl_context *ctx, exec_list *ir,
                          unsigned stage)
 {
-      if (ctx->Const.GLSLOptimizeConservatively) {
+      const struct gl_shader_compiler_options *options =
+         &ctx->Const.ShaderCompilerOptions[stage];
+
+      /* Without indirect sampler indexing, loops indexing sampler arrays
+       * must be unrolled and their indices constant-propagated before
+       * validate_sampler_array_indexing() runs, which needs the full set of
+       * optimisations.
+       */
+      if (ctx->Const.GLSLOptimizeConservatively && options->NirOptions &&
+          !options->EmitNoIndirectSampler) {
+         /* The stage is translated to NIR and optimised there, only run
+          * what's needed for the program to behave and to be counted
+          * correctly: calls to functions from other shaders of the stage
+          * have to be inlined, invariance has to reach every value an
+          * invariant output depends on, and what's unused must go so
+          * inactive uniforms and varyings don't count against the limits.
+          */
+         do_function_inlining(ir);
+         propagate_invariance(ir);
+         do_dead_functions(ir);
+         while (do_dead_code(ir, false))
+            ;
+      } else if (ctx->Const.GLSLOptimizeConservatively) {
          /* Run it just once. */
-         do_common_optimization(ir, true, false,
-                                &ctx->Const.ShaderCompilerOptions[stage],
+         do_common_optimization(ir, true, false, options,
                                 ctx->Const.NativeIntegers);
       } else {
          /* Repeat it until it stops making changes. */
-         while (do_common_optimization(ir, true, false,
-                                       &ctx->Const.ShaderCompilerOptions[stage],
-                                       ctx->Const.NativeIntegers))
+         glsl_common_opt_state opt_state;
+         while (do_common_optimization(ir, true, false, options,
+                                       ctx->Const.NativeIntegers, &opt_state))
             ;
       }
 }
 
+/**
+ * Optimize a stage before storage is assigned to its attributes, uniforms
+ * and varyings.
+ */
+static void
+linker_optimise_stage(struct gl_context *ctx, struct gl_linked_shader *sh,
+                      unsigned stage)
+{
+   /* Call opts before lowering const arrays to uniforms so we can const
+    * propagate any elements accessed directly.
+    */
+   linker_optimisation_loop(ctx, sh->ir, stage);
+
+   /* Call opts after lowering const arrays to copy propagate things. */
+   if (ctx->Const.GLSLLowerConstArrays &&
+       lower_const_arrays_to_uniforms(sh->ir, stage,
+                                      ctx->Const.Program[stage].MaxUniformComponents))
+      linker_optimisation_loop(ctx, sh->ir, stage);
+}
+
+/* Each stage's IR is allocated out of its own gl_linked_shader and nothing
+ * but the glsl_type tables, which have their own lock, is shared between
+ * stages, so the stages of a program can be optimised concurrently.
+ */
+static struct util_queue optimise_queue;
+static bool optimise_queue_ready;
+static once_flag optimise_queue_once = ONCE_FLAG_INIT;
+
+static void
+optimise_queue_init(void)
+{
+   util_cpu_detect();
+   if (util_cpu_caps.nr_cpus <= 1)
+      return;
+
+   /* The calling thread always optimises one of the stages itself. */
+   unsigned num_threads = MIN2(util_cpu_caps.nr_cpus, MESA_SHADER_STAGES) - 1;
+   optimise_queue_ready =
+      util_queue_init(&optimise_queue, "glsl_link", MESA_SHADER_STAGES,
+                      num_threads, UTIL_QUEUE_INIT_RESIZE_IF_FULL);
+}
+
+struct optimise_stage_job {
+   struct gl_context *ctx;
+   struct gl_linked_shader *sh;
+   unsigned stage;
+   struct util_queue_fence fence;
+};
+
+static void
+optimise_stage_execute(void *data, int thread_index)
+{
+   struct optimise_stage_job *job = (struct optimise_stage_job *) data;
+
+   linker_optimise_stage(job->ctx, job->sh, job->stage);
+}
+
+/**
+ * Optimize all the linked stages.  All but the last one are handed to the
+ * optimisation queue, the last one is optimised by the calling thread.
+ */
+static void
+linker_optimise_stages(struct gl_context *ctx, struct gl_shader_program *prog)
+{
+   struct optimise_stage_job jobs[MESA_SHADER_STAGES];
+   unsigned num_jobs = 0;
+   int last = -1;
+
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      if (prog->_LinkedShaders[i])
+         last = i;
+   }
+
+   if (last < 0)
+      return;
+
+   call_once(&optimise_queue_once, optimise_queue_init);
+
+   for (int i = 0; i < last; i++) {
+      if (prog->_LinkedShaders[i] == NULL)
+         continue;
+
+      if (!optimise_queue_ready) {
+         linker_optimise_stage(ctx, prog->_LinkedShaders[i], i);
+         continue;
+      }
+
+      struct optimise_stage_job *job = &jobs[num_jobs++];
+      job->ctx = ctx;
+      job->sh = prog->_LinkedShaders[i];
+      job->stage = i;
+      util_queue_fence_init(&job->fence);
+      util_queue_add_job(&optimise_queue, job, &job->fence,
+                         optimise_stage_execute, NULL, 0);
+   }
+
+   linker_optimise_stage(ctx, prog->_LinkedShaders[last], last);
+
+   for (unsigned i = 0; i < num_jobs; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+}
+
 void
 link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
 {
@@ -4885,20 +5013,10 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
             goto done;
          }
       }
-
-      /* Call opts before lowering const arrays to uniforms so we can const
-       * propagate any elements accessed directly.
-       */
-      linker_optimisation_loop(ctx, prog->_LinkedShaders[i]->ir, i);
-
-      /* Call opts after lowering const arrays to copy propagate things. */
-      if (ctx->Const.GLSLLowerConstArrays &&
-          lower_const_arrays_to_uniforms(prog->_LinkedShaders[i]->ir, i,
-                                         ctx->Const.Program[i].MaxUniformComponents))
-         linker_optimisation_loop(ctx, prog->_LinkedShaders[i]->ir, i);
-
    }
 
+   linker_optimise_stages(ctx, prog);
+
    /* Validation for special cases where we allow sampler array indexing
     * with loop induction variable. This check emits a warning or error
     * depending if backend can handle dynamic indexing.
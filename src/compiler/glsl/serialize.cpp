@@ -156,11 +156,22 @@ write_buffer_blocks(struct blob *metadata, struct gl_shader_program *prog)
    }
 }
 
+/**
+ * Read a name, referencing it in the blob when \p in_place is set and
+ * copying it into \p mem_ctx otherwise.
+ */
+static char *
+read_name(struct blob_reader *metadata, const void *mem_ctx, bool in_place)
+{
+   char *name = blob_read_string(metadata);
+   return in_place ? name : ralloc_strdup(mem_ctx, name);
+}
+
 static void
 read_buffer_block(struct blob_reader *metadata, struct gl_uniform_block *b,
-                  struct gl_shader_program *prog)
+                  struct gl_shader_program *prog, bool in_place)
 {
-      b->Name = ralloc_strdup(prog->data, blob_read_string (metadata));
+      b->Name = read_name(metadata, prog->data, in_place);
       b->NumUniforms = blob_read_uint32(metadata);
       b->Binding = blob_read_uint32(metadata);
       b->UniformBufferSize = blob_read_uint32(metadata);
@@ -170,14 +181,14 @@ read_buffer_block(struct blob_reader *metadata, struct gl_uniform_block *b,
          rzalloc_array(prog->data, struct gl_uniform_buffer_variable,
                        b->NumUniforms);
       for (unsigned j = 0; j < b->NumUniforms; j++) {
-         b->Uniforms[j].Name = ralloc_strdup(prog->data,
-                                             blob_read_string (metadata));
+         b->Uniforms[j].Name = read_name(metadata, prog->data, in_place);
 
          char *index_name = blob_read_string(metadata);
          if (strcmp(b->Uniforms[j].Name, index_name) == 0) {
             b->Uniforms[j].IndexName = b->Uniforms[j].Name;
          } else {
-            b->Uniforms[j].IndexName = ralloc_strdup(prog->data, index_name);
+            b->Uniforms[j].IndexName =
+               in_place ? index_name : ralloc_strdup(prog->data, index_name);
          }
 
          b->Uniforms[j].Type = decode_type_from_blob(metadata);
@@ -187,7 +198,7 @@ read_buffer_block(struct blob_reader *metadata, struct gl_uniform_block *b,
 
 static void
 read_buffer_blocks(struct blob_reader *metadata,
-                   struct gl_shader_program *prog)
+                   struct gl_shader_program *prog, bool in_place)
 {
    prog->data->NumUniformBlocks = blob_read_uint32(metadata);
    prog->data->NumShaderStorageBlocks = blob_read_uint32(metadata);
@@ -201,11 +212,13 @@ read_buffer_blocks(struct blob_reader *metadata,
                     prog->data->NumShaderStorageBlocks);
 
    for (unsigned i = 0; i < prog->data->NumUniformBlocks; i++) {
-      read_buffer_block(metadata, &prog->data->UniformBlocks[i], prog);
+      read_buffer_block(metadata, &prog->data->UniformBlocks[i], prog,
+                        in_place);
    }
 
    for (unsigned i = 0; i < prog->data->NumShaderStorageBlocks; i++) {
-      read_buffer_block(metadata, &prog->data->ShaderStorageBlocks[i], prog);
+      read_buffer_block(metadata, &prog->data->ShaderStorageBlocks[i], prog,
+                        in_place);
    }
 
    for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
@@ -489,7 +502,8 @@ write_uniforms(struct blob *metadata, struct gl_shader_program *prog)
 }
 
 static void
-read_uniforms(struct blob_reader *metadata, struct gl_shader_program *prog)
+read_uniforms(struct blob_reader *metadata, struct gl_shader_program *prog,
+              bool in_place)
 {
    struct gl_uniform_storage *uniforms;
    union gl_constant_value *data;
@@ -514,7 +528,7 @@ read_uniforms(struct blob_reader *metadata, struct gl_shader_program *prog)
    for (unsigned i = 0; i < prog->data->NumUniformStorage; i++) {
       uniforms[i].type = decode_type_from_blob(metadata);
       uniforms[i].array_elements = blob_read_uint32(metadata);
-      uniforms[i].name = ralloc_strdup(prog, blob_read_string (metadata));
+      uniforms[i].name = read_name(metadata, prog, in_place);
       uniforms[i].builtin = blob_read_uint32(metadata);
       uniforms[i].remap_location = blob_read_uint32(metadata);
       uniforms[i].block_index = blob_read_uint32(metadata);
@@ -1297,9 +1311,17 @@ serialize_glsl_program(struct blob *blob, struct gl_context *ctx,
    write_program_resource_list(blob, prog);
 }
 
+/**
+ * Restore a program serialized by serialize_glsl_program().
+ *
+ * When \p blob_outlives_data is set, the memory of \p blob is guaranteed to
+ * live as long as \c prog->data and the names of the uniforms and buffer
+ * blocks point into it rather than being copied.
+ */
 extern "C" bool
 deserialize_glsl_program(struct blob_reader *blob, struct gl_context *ctx,
-                         struct gl_shader_program *prog)
+                         struct gl_shader_program *prog,
+                         bool blob_outlives_data)
 {
    /* Fixed function programs generated by Mesa can't be serialized. */
    if (prog->Name == 0)
@@ -1309,7 +1331,7 @@ deserialize_glsl_program(struct blob_reader *blob, struct gl_context *ctx,
 
    blob_copy_bytes(blob, prog->data->sha1, sizeof(prog->data->sha1));
 
-   read_uniforms(blob, prog);
+   read_uniforms(blob, prog, blob_outlives_data);
 
    read_hash_tables(blob, prog);
 
@@ -1330,7 +1352,7 @@ deserialize_glsl_program(struct blob_reader *blob, struct gl_context *ctx,
 
    read_atomic_buffers(blob, prog);
 
-   read_buffer_blocks(blob, prog);
+   read_buffer_blocks(blob, prog, blob_outlives_data);
 
    read_subroutines(blob, prog);
 
@@ -41,7 +41,8 @@ serialize_glsl_program(struct blob *blob, struct gl_context *ctx,
 
 bool
 deserialize_glsl_program(struct blob_reader *blob, struct gl_context *ctx,
-                         struct gl_shader_program *prog);
+                         struct gl_shader_program *prog,
+                         bool blob_outlives_data);
 
 #ifdef __cplusplus
 } /* extern "C" */
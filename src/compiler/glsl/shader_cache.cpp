@@ -70,7 +70,8 @@ extern "C" {
 static void
 compile_shaders(struct gl_context *ctx, struct gl_shader_program *prog) {
    for (unsigned i = 0; i < prog->NumShaders; i++) {
-      _mesa_glsl_compile_shader(ctx, prog->Shaders[i], false, false, true);
+      _mesa_glsl_compile_shader(ctx, prog->Shaders[i], false, false, true,
+                                ctx->_Shader->Flags);
    }
 }
 
@@ -140,6 +141,12 @@ fail:
    blob_finish(&metadata);
 }
 
+static void
+free_cache_item(void *mem)
+{
+   free(*(uint8_t **) mem);
+}
+
 bool
 shader_cache_read_program_metadata(struct gl_context *ctx,
                                    struct gl_shader_program *prog)
@@ -233,10 +240,17 @@ shader_cache_read_program_metadata(struct gl_context *ctx,
               sha1buf);
    }
 
+   /* The names of the uniforms and buffer blocks are used straight from the
+    * cache item, which is kept for as long as the program data.
+    */
+   uint8_t **buffer_ref = ralloc(prog->data, uint8_t *);
+   *buffer_ref = buffer;
+   ralloc_set_destructor(buffer_ref, free_cache_item);
+
    struct blob_reader metadata;
    blob_reader_init(&metadata, buffer, size);
 
-   bool deserialized = deserialize_glsl_program(&metadata, ctx, prog);
+   bool deserialized = deserialize_glsl_program(&metadata, ctx, prog, true);
 
    if (!deserialized || metadata.current != metadata.end || metadata.overrun) {
       /* Something has gone wrong discard the item from the cache and rebuild
@@ -251,14 +265,11 @@ shader_cache_read_program_metadata(struct gl_context *ctx,
 
       disk_cache_remove(cache, prog->data->sha1);
       compile_shaders(ctx, prog);
-      free(buffer);
       return false;
    }
 
    /* This is used to flag a shader retrieved from cache */
    prog->data->LinkStatus = LINKING_SKIPPED;
 
-   free (buffer);
-
    return true;
 }
@@ -474,6 +474,126 @@ test_put_key_and_get_key(void)
 
    disk_cache_destroy(cache);
 }
+
+static void
+test_put_and_get_single_file(void)
+{
+   struct disk_cache *cache;
+   char blob[] = "This is a blob of thirty-seven bytes";
+   uint8_t blob_key[20];
+   uint8_t *one_MB;
+   uint8_t one_MB_key[20];
+   char *result;
+   size_t size;
+
+   setenv("MESA_DISK_CACHE_SINGLE_FILE", "true", 1);
+   setenv("MESA_GLSL_CACHE_MAX_SIZE", "1M", 1);
+
+   cache = disk_cache_create("test", "single_file", 0);
+
+   disk_cache_compute_key(cache, blob, sizeof(blob), blob_key);
+
+   result = disk_cache_get(cache, blob_key, &size);
+   expect_null(result, "single file disk_cache_get with non-existent item");
+
+   disk_cache_put(cache, blob_key, blob, sizeof(blob), NULL);
+
+   /* disk_cache_put() hands things off to a thread so wait for it. */
+   disk_cache_wait_for_idle(cache);
+
+   result = disk_cache_get(cache, blob_key, &size);
+   expect_equal_str(blob, result,
+                    "single file disk_cache_get of existing item (pointer)");
+   expect_equal(size, sizeof(blob),
+                "single file disk_cache_get of existing item (size)");
+
+   free(result);
+
+   /* Entries must survive reopening the cache. */
+   disk_cache_destroy(cache);
+   cache = disk_cache_create("test", "single_file", 0);
+
+   expect_true(does_cache_contain(cache, blob_key),
+               "single file cache keeps entries across disk_cache_create");
+
+   /* Adding an incompressible 1MB item must compact the file. */
+   one_MB = malloc(1024 * 1024);
+   for (unsigned i = 0; i < 1024 * 1024; i++)
+      one_MB[i] = rand();
+
+   disk_cache_compute_key(cache, one_MB, 1024 * 1024, one_MB_key);
+   disk_cache_put(cache, one_MB_key, one_MB, 1024 * 1024, NULL);
+
+   /* disk_cache_put() hands things off to a thread so wait for it. */
+   disk_cache_wait_for_idle(cache);
+
+   result = disk_cache_get(cache, one_MB_key, &size);
+   expect_true(result && size == 1024 * 1024 &&
+               memcmp(result, one_MB, size) == 0,
+               "single file disk_cache_get of 1MB item");
+   expect_true(!does_cache_contain(cache, blob_key),
+               "single file compaction after overflow with MAX_SIZE=1M");
+
+   free(result);
+   free(one_MB);
+
+   disk_cache_destroy(cache);
+
+   unsetenv("MESA_DISK_CACHE_SINGLE_FILE");
+}
+
+static void
+test_read_only_layer(void)
+{
+   struct disk_cache *cache;
+   char blob[] = "This is a blob of thirty-seven bytes";
+   uint8_t blob_key[20];
+   uint8_t key_a[20] = {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9,
+                         10, 11, 12, 13, 14, 15, 16, 17, 18, 19};
+   char *result;
+   size_t size;
+
+   /* Build the read-only layer with the single file backend. */
+   setenv("MESA_GLSL_CACHE_DIR", CACHE_TEST_TMP "/ro-layer", 1);
+   setenv("MESA_DISK_CACHE_SINGLE_FILE", "true", 1);
+
+   cache = disk_cache_create("test", "read_only", 0);
+
+   disk_cache_compute_key(cache, blob, sizeof(blob), blob_key);
+   disk_cache_put(cache, blob_key, blob, sizeof(blob), NULL);
+
+   /* disk_cache_put() hands things off to a thread so wait for it. */
+   disk_cache_wait_for_idle(cache);
+   disk_cache_destroy(cache);
+
+   unsetenv("MESA_DISK_CACHE_SINGLE_FILE");
+
+   /* Then look it up through an empty writeable cache. */
+   setenv("MESA_DISK_CACHE_RO_DIR",
+          CACHE_TEST_TMP "/ro-layer/" CACHE_DIR_NAME, 1);
+   setenv("MESA_GLSL_CACHE_DIR", CACHE_TEST_TMP "/rw-layer", 1);
+
+   cache = disk_cache_create("test", "read_only", 0);
+
+   result = disk_cache_get(cache, blob_key, &size);
+   expect_equal_str(blob, result, "disk_cache_get from the read-only layer");
+   expect_equal(size, sizeof(blob),
+                "disk_cache_get from the read-only layer (size)");
+   free(result);
+
+   expect_true(!disk_cache_has_key(cache, key_a),
+               "disk_cache_has_key of a key in neither layer");
+
+   /* Writes still go to the writeable cache. */
+   disk_cache_put_key(cache, key_a);
+   expect_true(disk_cache_has_key(cache, key_a),
+               "disk_cache_has_key with a read-only layer");
+
+   disk_cache_destroy(cache);
+
+   unsetenv("MESA_DISK_CACHE_RO_DIR");
+   setenv("MESA_GLSL_CACHE_DIR", CACHE_TEST_TMP "/mesa-glsl-cache-dir", 1);
+}
 #endif /* ENABLE_SHADER_CACHE */
 
 int
@@ -488,6 +608,10 @@ main(void)
 
    test_put_key_and_get_key();
 
+   test_put_and_get_single_file();
+
+   test_read_only_layer();
+
    err = rmrf_local(CACHE_TEST_TMP);
    expect_equal(err, 0, "Removing " CACHE_TEST_TMP " again");
 #endif /* ENABLE_SHADER_CACHE */
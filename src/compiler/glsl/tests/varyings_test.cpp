@@ -36,13 +36,13 @@
 
 namespace linker {
 void
-populate_consumer_input_sets(void *mem_ctx, exec_list *ir,
+populate_consumer_input_sets(void *lin_ctx, exec_list *ir,
                              hash_table *consumer_inputs,
                              hash_table *consumer_interface_inputs,
                              ir_variable *consumer_inputs_with_locations[VARYING_SLOT_MAX]);
 
 ir_variable *
-get_matching_input(void *mem_ctx,
+get_matching_input(void *lin_ctx,
                    const ir_variable *output_var,
                    hash_table *consumer_inputs,
                    hash_table *consumer_interface_inputs,
@@ -63,6 +63,7 @@ public:
    }
 
    void *mem_ctx;
+   void *lin_ctx;
    exec_list ir;
    hash_table *consumer_inputs;
    hash_table *consumer_interface_inputs;
@@ -77,6 +78,7 @@ link_varyings::SetUp()
    glsl_type_singleton_init_or_ref();
 
    this->mem_ctx = ralloc_context(NULL);
+   this->lin_ctx = linear_alloc_parent(this->mem_ctx, 0);
    this->ir.make_empty();
 
    this->consumer_inputs =
@@ -124,7 +126,7 @@ TEST_F(link_varyings, single_simple_input)
 
    ir.push_tail(v);
 
-   linker::populate_consumer_input_sets(mem_ctx,
+   linker::populate_consumer_input_sets(lin_ctx,
                                         &ir,
                                         consumer_inputs,
                                         consumer_interface_inputs,
@@ -152,7 +154,7 @@ TEST_F(link_varyings, gl_ClipDistance)
 
    ir.push_tail(clipdistance);
 
-   linker::populate_consumer_input_sets(mem_ctx,
+   linker::populate_consumer_input_sets(lin_ctx,
                                         &ir,
                                         consumer_inputs,
                                         consumer_interface_inputs,
@@ -179,7 +181,7 @@ TEST_F(link_varyings, gl_CullDistance)
 
    ir.push_tail(culldistance);
 
-   linker::populate_consumer_input_sets(mem_ctx,
+   linker::populate_consumer_input_sets(lin_ctx,
                                         &ir,
                                         consumer_inputs,
                                         consumer_interface_inputs,
@@ -201,7 +203,7 @@ TEST_F(link_varyings, single_interface_input)
 
    ir.push_tail(v);
 
-   linker::populate_consumer_input_sets(mem_ctx,
+   linker::populate_consumer_input_sets(lin_ctx,
                                         &ir,
                                         consumer_inputs,
                                         consumer_interface_inputs,
@@ -234,7 +236,7 @@ TEST_F(link_varyings, one_interface_and_one_simple_input)
 
    ir.push_tail(iface);
 
-   linker::populate_consumer_input_sets(mem_ctx,
+   linker::populate_consumer_input_sets(lin_ctx,
                                         &ir,
                                         consumer_inputs,
                                         consumer_interface_inputs,
@@ -265,7 +267,7 @@ TEST_F(link_varyings, interface_field_doesnt_match_noninterface)
 
    ir.push_tail(in_v);
 
-   linker::populate_consumer_input_sets(mem_ctx,
+   linker::populate_consumer_input_sets(lin_ctx,
                                         &ir,
                                         consumer_inputs,
                                         consumer_interface_inputs,
@@ -282,7 +284,7 @@ TEST_F(link_varyings, interface_field_doesnt_match_noninterface)
    out_v->init_interface_type(simple_interface);
 
    ir_variable *const match =
-      linker::get_matching_input(mem_ctx,
+      linker::get_matching_input(lin_ctx,
                                  out_v,
                                  consumer_inputs,
                                  consumer_interface_inputs,
@@ -307,7 +309,7 @@ TEST_F(link_varyings, interface_field_doesnt_match_noninterface_vice_versa)
 
    ir.push_tail(in_v);
 
-   linker::populate_consumer_input_sets(mem_ctx,
+   linker::populate_consumer_input_sets(lin_ctx,
                                         &ir,
                                         consumer_inputs,
                                         consumer_interface_inputs,
@@ -321,7 +323,7 @@ TEST_F(link_varyings, interface_field_doesnt_match_noninterface_vice_versa)
                                ir_var_shader_out);
 
    ir_variable *const match =
-      linker::get_matching_input(mem_ctx,
+      linker::get_matching_input(lin_ctx,
                                  out_v,
                                  consumer_inputs,
                                  consumer_interface_inputs,
@@ -26,16 +26,17 @@
 #include "compiler/glsl/glsl_parser_extras.h"
 #include "glsl_types.h"
 #include "util/hash_table.h"
+#include "util/u_atomic.h"
 #include "util/u_string.h"
 
 
 mtx_t glsl_type::hash_mutex = _MTX_INITIALIZER_NP;
 hash_table *glsl_type::explicit_matrix_types = NULL;
-hash_table *glsl_type::array_types = NULL;
-hash_table *glsl_type::struct_types = NULL;
-hash_table *glsl_type::interface_types = NULL;
-hash_table *glsl_type::function_types = NULL;
-hash_table *glsl_type::subroutine_types = NULL;
+glsl_type_table *glsl_type::array_types = NULL;
+glsl_type_table *glsl_type::struct_types = NULL;
+glsl_type_table *glsl_type::interface_types = NULL;
+glsl_type_table *glsl_type::function_types = NULL;
+glsl_type_table *glsl_type::subroutine_types = NULL;
 
 /* There might be multiple users for types (e.g. application using OpenGL
  * and Vulkan simultanously or app using multiple Vulkan instances). Counter
@@ -43,6 +44,114 @@ hash_table *glsl_type::subroutine_types = NULL;
  */
 static uint32_t glsl_type_users = 0;
 
+/**
+ * Read-mostly set of the aggregate types created so far.
+ *
+ * The compiler threads of every context look up the same few types over and
+ * over, so lookups don't take glsl_type::hash_mutex: slots are only ever
+ * filled, never emptied, and a table is never filled to more than half of
+ * its size.  When it would be, a copy twice the size is built and published
+ * instead, the old table stays around until the types are released since a
+ * reader might still be walking it.  Insertions are serialised by
+ * glsl_type::hash_mutex.
+ */
+struct glsl_type_table {
+   struct slot {
+      uint32_t hash;
+
+      /** Written last, a slot is valid once this is seen non-NULL. */
+      const glsl_type *type;
+   };
+
+   /** Number of slots, a power of two. */
+   unsigned size;
+   unsigned entries;
+   slot *slots;
+
+   /** Table this one replaced. */
+   glsl_type_table *prev;
+};
+
+typedef bool (*type_table_match_fn)(const void *type, const void *key);
+
+static const glsl_type *
+type_table_search(glsl_type_table *const *table_ptr, uint32_t hash,
+                  type_table_match_fn match, const void *key)
+{
+   const glsl_type_table *table = p_atomic_read(table_ptr);
+   if (table == NULL)
+      return NULL;
+
+   const unsigned mask = table->size - 1;
+   for (unsigned i = hash & mask;; i = (i + 1) & mask) {
+      const glsl_type *t = p_atomic_read(&table->slots[i].type);
+      if (t == NULL)
+         return NULL;
+      if (table->slots[i].hash == hash && match(t, key))
+         return t;
+   }
+}
+
+static void
+type_table_add(glsl_type_table *table, uint32_t hash, const glsl_type *t)
+{
+   const unsigned mask = table->size - 1;
+   unsigned i = hash & mask;
+   while (table->slots[i].type != NULL)
+      i = (i + 1) & mask;
+
+   table->slots[i].hash = hash;
+   p_atomic_set(&table->slots[i].type, t);
+   table->entries++;
+}
+
+/**
+ * Add a type which isn't in the table yet, hash_mutex must be held.
+ */
+static void
+type_table_insert(glsl_type_table **table_ptr, uint32_t hash,
+                  const glsl_type *t)
+{
+   glsl_type_table *table = *table_ptr;
+
+   if (table == NULL || (table->entries + 1) * 2 > table->size) {
+      glsl_type_table *grown = new glsl_type_table;
+      grown->size = table ? table->size * 2 : 64;
+      grown->entries = 0;
+      grown->slots =
+         (glsl_type_table::slot *) calloc(grown->size, sizeof(*grown->slots));
+      grown->prev = table;
+
+      for (unsigned i = 0; table && i < table->size; i++) {
+         if (table->slots[i].type != NULL)
+            type_table_add(grown, table->slots[i].hash, table->slots[i].type);
+      }
+
+      p_atomic_set(table_ptr, grown);
+      table = grown;
+   }
+
+   type_table_add(table, hash, t);
+}
+
+static void
+type_table_destroy(glsl_type_table **table_ptr)
+{
+   glsl_type_table *table = *table_ptr;
+
+   for (unsigned i = 0; table && i < table->size; i++)
+      delete table->slots[i].type;
+
+   while (table != NULL) {
+      glsl_type_table *prev = table->prev;
+      free(table->slots);
+      delete table;
+      table = prev;
+   }
+
+   *table_ptr = NULL;
+}
+
 glsl_type::glsl_type(GLenum gl_type,
                      glsl_base_type base_type, unsigned vector_elements,
                      unsigned matrix_columns, const char *name,
@@ -498,12 +607,7 @@ const glsl_type *glsl_type::get_uint16_type() const
 static void
 hash_free_type_function(struct hash_entry *entry)
 {
-   glsl_type *type = (glsl_type *) entry->data;
-
-   if (type->is_array())
-      free((void*)entry->key);
-
-   delete type;
+   delete (glsl_type *) entry->data;
 }
 
 void
@@ -532,30 +636,11 @@ glsl_type_singleton_decref()
       glsl_type::explicit_matrix_types = NULL;
    }
 
-   if (glsl_type::array_types != NULL) {
-      _mesa_hash_table_destroy(glsl_type::array_types, hash_free_type_function);
-      glsl_type::array_types = NULL;
-   }
-
-   if (glsl_type::struct_types != NULL) {
-      _mesa_hash_table_destroy(glsl_type::struct_types, hash_free_type_function);
-      glsl_type::struct_types = NULL;
-   }
-
-   if (glsl_type::interface_types != NULL) {
-      _mesa_hash_table_destroy(glsl_type::interface_types, hash_free_type_function);
-      glsl_type::interface_types = NULL;
-   }
-
-   if (glsl_type::function_types != NULL) {
-      _mesa_hash_table_destroy(glsl_type::function_types, hash_free_type_function);
-      glsl_type::function_types = NULL;
-   }
-
-   if (glsl_type::subroutine_types != NULL) {
-      _mesa_hash_table_destroy(glsl_type::subroutine_types, hash_free_type_function);
-      glsl_type::subroutine_types = NULL;
-   }
+   type_table_destroy(&glsl_type::array_types);
+   type_table_destroy(&glsl_type::struct_types);
+   type_table_destroy(&glsl_type::interface_types);
+   type_table_destroy(&glsl_type::function_types);
+   type_table_destroy(&glsl_type::subroutine_types);
 
    mtx_unlock(&glsl_type::hash_mutex);
 }
@@ -1023,44 +1108,56 @@ glsl_type::get_image_instance(enum glsl_sampler_dim dim,
    unreachable("switch statement above should be complete");
 }
 
+namespace {
+struct array_key {
+   const glsl_type *base;
+   unsigned length;
+   unsigned explicit_stride;
+};
+}
+
+static bool
+array_key_match(const void *a, const void *b)
+{
+   const glsl_type *const type = (const glsl_type *) a;
+   const array_key *const key = (const array_key *) b;
+
+   return type->fields.array == key->base &&
+          type->length == key->length &&
+          type->explicit_stride == key->explicit_stride;
+}
+
 const glsl_type *
 glsl_type::get_array_instance(const glsl_type *base,
                               unsigned array_size,
                               unsigned explicit_stride)
 {
-   /* Generate a name using the base type pointer in the key.  This is
-    * done because the name of the base type may not be unique across
-    * shaders.  For example, two shaders may have different record types
-    * named 'foo'.
+   /* The key uses the base type pointer rather than its name since the name
+    * of the base type may not be unique across shaders.  For example, two
+    * shaders may have different record types named 'foo'.
     */
-   char key[128];
-   snprintf(key, sizeof(key), "%p[%u]x%uB", (void *) base, array_size,
-            explicit_stride);
+   const array_key key = { base, array_size, explicit_stride };
+   const uint32_t hash = _mesa_hash_data(&key, sizeof(key));
 
-   mtx_lock(&glsl_type::hash_mutex);
    assert(glsl_type_users > 0);
 
-   if (array_types == NULL) {
-      array_types = _mesa_hash_table_create(NULL, _mesa_hash_string,
-                                            _mesa_key_string_equal);
-   }
+   const glsl_type *t =
+      type_table_search(&array_types, hash, array_key_match, &key);
+   if (t == NULL) {
+      mtx_lock(&glsl_type::hash_mutex);
 
-   const struct hash_entry *entry = _mesa_hash_table_search(array_types, key);
-   if (entry == NULL) {
-      const glsl_type *t = new glsl_type(base, array_size, explicit_stride);
+      t = type_table_search(&array_types, hash, array_key_match, &key);
+      if (t == NULL) {
+         t = new glsl_type(base, array_size, explicit_stride);
+         type_table_insert(&array_types, hash, t);
+      }
 
-      entry = _mesa_hash_table_insert(array_types,
-                                      strdup(key),
-                                      (void *) t);
+      mtx_unlock(&glsl_type::hash_mutex);
    }
 
-   assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_ARRAY);
-   assert(((glsl_type *) entry->data)->length == array_size);
-   assert(((glsl_type *) entry->data)->fields.array == base);
-
-   glsl_type *t = (glsl_type *) entry->data;
-
-   mtx_unlock(&glsl_type::hash_mutex);
+   assert(t->base_type == GLSL_TYPE_ARRAY);
+   assert(t->length == array_size);
+   assert(t->fields.array == base);
 
    return t;
 }
@@ -1243,31 +1340,28 @@ glsl_type::get_struct_instance(const glsl_struct_field *fields,
                                bool packed)
 {
    const glsl_type key(fields, num_fields, name, packed);
+   const uint32_t hash = record_key_hash(&key);
 
-   mtx_lock(&glsl_type::hash_mutex);
    assert(glsl_type_users > 0);
 
-   if (struct_types == NULL) {
-      struct_types = _mesa_hash_table_create(NULL, record_key_hash,
-                                             record_key_compare);
-   }
+   const glsl_type *t =
+      type_table_search(&struct_types, hash, record_key_compare, &key);
+   if (t == NULL) {
+      mtx_lock(&glsl_type::hash_mutex);
 
-   const struct hash_entry *entry = _mesa_hash_table_search(struct_types,
-                                                            &key);
-   if (entry == NULL) {
-      const glsl_type *t = new glsl_type(fields, num_fields, name, packed);
+      t = type_table_search(&struct_types, hash, record_key_compare, &key);
+      if (t == NULL) {
+         t = new glsl_type(fields, num_fields, name, packed);
+         type_table_insert(&struct_types, hash, t);
+      }
 
-      entry = _mesa_hash_table_insert(struct_types, t, (void *) t);
+      mtx_unlock(&glsl_type::hash_mutex);
    }
 
-   assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_STRUCT);
-   assert(((glsl_type *) entry->data)->length == num_fields);
-   assert(strcmp(((glsl_type *) entry->data)->name, name) == 0);
-   assert(((glsl_type *) entry->data)->packed == packed);
-
-   glsl_type *t = (glsl_type *) entry->data;
-
-   mtx_unlock(&glsl_type::hash_mutex);
+   assert(t->base_type == GLSL_TYPE_STRUCT);
+   assert(t->length == num_fields);
+   assert(strcmp(t->name, name) == 0);
+   assert(t->packed == packed);
 
    return t;
 }
@@ -1281,31 +1375,27 @@ glsl_type::get_interface_instance(const glsl_struct_field *fields,
                                   const char *block_name)
 {
    const glsl_type key(fields, num_fields, packing, row_major, block_name);
+   const uint32_t hash = record_key_hash(&key);
 
-   mtx_lock(&glsl_type::hash_mutex);
    assert(glsl_type_users > 0);
 
-   if (interface_types == NULL) {
-      interface_types = _mesa_hash_table_create(NULL, record_key_hash,
-                                                record_key_compare);
-   }
+   const glsl_type *t =
+      type_table_search(&interface_types, hash, record_key_compare, &key);
+   if (t == NULL) {
+      mtx_lock(&glsl_type::hash_mutex);
 
-   const struct hash_entry *entry = _mesa_hash_table_search(interface_types,
-                                                            &key);
-   if (entry == NULL) {
-      const glsl_type *t = new glsl_type(fields, num_fields,
-                                         packing, row_major, block_name);
+      t = type_table_search(&interface_types, hash, record_key_compare, &key);
+      if (t == NULL) {
+         t = new glsl_type(fields, num_fields, packing, row_major, block_name);
+         type_table_insert(&interface_types, hash, t);
+      }
 
-      entry = _mesa_hash_table_insert(interface_types, t, (void *) t);
+      mtx_unlock(&glsl_type::hash_mutex);
    }
 
-   assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_INTERFACE);
-   assert(((glsl_type *) entry->data)->length == num_fields);
-   assert(strcmp(((glsl_type *) entry->data)->name, block_name) == 0);
-
-   glsl_type *t = (glsl_type *) entry->data;
-
-   mtx_unlock(&glsl_type::hash_mutex);
+   assert(t->base_type == GLSL_TYPE_INTERFACE);
+   assert(t->length == num_fields);
+   assert(strcmp(t->name, block_name) == 0);
 
    return t;
 }
@@ -1314,29 +1404,26 @@ const glsl_type *
 glsl_type::get_subroutine_instance(const char *subroutine_name)
 {
    const glsl_type key(subroutine_name);
+   const uint32_t hash = record_key_hash(&key);
 
-   mtx_lock(&glsl_type::hash_mutex);
    assert(glsl_type_users > 0);
 
-   if (subroutine_types == NULL) {
-      subroutine_types = _mesa_hash_table_create(NULL, record_key_hash,
-                                                 record_key_compare);
-   }
+   const glsl_type *t =
+      type_table_search(&subroutine_types, hash, record_key_compare, &key);
+   if (t == NULL) {
+      mtx_lock(&glsl_type::hash_mutex);
 
-   const struct hash_entry *entry = _mesa_hash_table_search(subroutine_types,
-                                                            &key);
-   if (entry == NULL) {
-      const glsl_type *t = new glsl_type(subroutine_name);
+      t = type_table_search(&subroutine_types, hash, record_key_compare, &key);
+      if (t == NULL) {
+         t = new glsl_type(subroutine_name);
+         type_table_insert(&subroutine_types, hash, t);
+      }
 
-      entry = _mesa_hash_table_insert(subroutine_types, t, (void *) t);
+      mtx_unlock(&glsl_type::hash_mutex);
    }
 
-   assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_SUBROUTINE);
-   assert(strcmp(((glsl_type *) entry->data)->name, subroutine_name) == 0);
-
-   glsl_type *t = (glsl_type *) entry->data;
-
-   mtx_unlock(&glsl_type::hash_mutex);
+   assert(t->base_type == GLSL_TYPE_SUBROUTINE);
+   assert(strcmp(t->name, subroutine_name) == 0);
 
    return t;
 }
@@ -1370,29 +1457,27 @@ glsl_type::get_function_instance(const glsl_type *return_type,
                                  unsigned num_params)
 {
    const glsl_type key(return_type, params, num_params);
+   const uint32_t hash = function_key_hash(&key);
 
-   mtx_lock(&glsl_type::hash_mutex);
    assert(glsl_type_users > 0);
 
-   if (function_types == NULL) {
-      function_types = _mesa_hash_table_create(NULL, function_key_hash,
-                                               function_key_compare);
-   }
+   const glsl_type *t =
+      type_table_search(&function_types, hash, function_key_compare, &key);
+   if (t == NULL) {
+      mtx_lock(&glsl_type::hash_mutex);
 
-   struct hash_entry *entry = _mesa_hash_table_search(function_types, &key);
-   if (entry == NULL) {
-      const glsl_type *t = new glsl_type(return_type, params, num_params);
+      t = type_table_search(&function_types, hash, function_key_compare, &key);
+      if (t == NULL) {
+         t = new glsl_type(return_type, params, num_params);
+         type_table_insert(&function_types, hash, t);
+      }
 
-      entry = _mesa_hash_table_insert(function_types, t, (void *) t);
+      mtx_unlock(&glsl_type::hash_mutex);
    }
 
-   const glsl_type *t = (const glsl_type *)entry->data;
-
    assert(t->base_type == GLSL_TYPE_FUNCTION);
    assert(t->length == num_params);
 
-   mtx_unlock(&glsl_type::hash_mutex);
-
    return t;
 }
 
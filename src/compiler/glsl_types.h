@@ -1261,20 +1261,20 @@ private:
    /** Hash table containing the known explicit matrix and vector types. */
    static struct hash_table *explicit_matrix_types;
 
-   /** Hash table containing the known array types. */
-   static struct hash_table *array_types;
+   /** Table containing the known array types. */
+   static struct glsl_type_table *array_types;
 
-   /** Hash table containing the known struct types. */
-   static struct hash_table *struct_types;
+   /** Table containing the known struct types. */
+   static struct glsl_type_table *struct_types;
 
-   /** Hash table containing the known interface types. */
-   static struct hash_table *interface_types;
+   /** Table containing the known interface types. */
+   static struct glsl_type_table *interface_types;
 
-   /** Hash table containing the known subroutine types. */
-   static struct hash_table *subroutine_types;
+   /** Table containing the known subroutine types. */
+   static struct glsl_type_table *subroutine_types;
 
-   /** Hash table containing the known function types. */
-   static struct hash_table *function_types;
+   /** Table containing the known function types. */
+   static struct glsl_type_table *function_types;
 
    static bool record_key_compare(const void *a, const void *b);
    static unsigned record_key_hash(const void *key);
@@ -309,6 +309,7 @@ nir_function_impl_create_bare(nir_shader *shader)
    impl->reg_alloc = 0;
    impl->ssa_alloc = 0;
    impl->valid_metadata = nir_metadata_none;
+   impl->range_ht = NULL;
 
    /* create start & end blocks */
    nir_block *start_block = nir_block_create(shader);
@@ -655,6 +656,108 @@ nir_ssa_undef_instr_create(nir_shader *shader,
    return instr;
 }
 
+/* Returns the size the nir_*_instr_create() functions allocate for instr. */
+static size_t
+instr_alloc_size(const nir_instr *instr)
+{
+   switch (instr->type) {
+   case nir_instr_type_alu:
+      return sizeof(nir_alu_instr) +
+             nir_op_infos[nir_instr_as_alu(instr)->op].num_inputs *
+             sizeof(nir_alu_src);
+   case nir_instr_type_deref:
+      return sizeof(nir_deref_instr);
+   case nir_instr_type_intrinsic:
+      return sizeof(nir_intrinsic_instr) +
+             nir_intrinsic_infos[nir_instr_as_intrinsic(instr)->intrinsic].num_srcs *
+             sizeof(nir_src);
+   case nir_instr_type_load_const:
+      return sizeof(nir_load_const_instr) +
+             nir_instr_as_load_const(instr)->def.num_components *
+             sizeof(nir_const_value);
+   case nir_instr_type_ssa_undef:
+      return sizeof(nir_ssa_undef_instr);
+   case nir_instr_type_tex:
+      return sizeof(nir_tex_instr);
+   case nir_instr_type_phi:
+      return sizeof(nir_phi_instr);
+   case nir_instr_type_jump:
+      return sizeof(nir_jump_instr);
+   case nir_instr_type_call:
+      return sizeof(nir_call_instr) +
+             nir_instr_as_call(instr)->num_params * sizeof(nir_src);
+   case nir_instr_type_parallel_copy:
+      return sizeof(nir_parallel_copy_instr);
+   default:
+      unreachable("bad instr type");
+   }
+}
+
+static void
+add_alloc_size(size_t *size, unsigned *count, size_t alloc_size)
+{
+   *size += alloc_size;
+   (*count)++;
+}
+
+static void
+cf_list_alloc_size(const struct exec_list *cf_list,
+                   size_t *size, unsigned *count)
+{
+   foreach_list_typed(nir_cf_node, node, node, cf_list) {
+      switch (node->type) {
+      case nir_cf_node_block:
+         add_alloc_size(size, count, sizeof(nir_block));
+         nir_foreach_instr(instr, nir_cf_node_as_block(node))
+            add_alloc_size(size, count, instr_alloc_size(instr));
+         break;
+      case nir_cf_node_if:
+         add_alloc_size(size, count, sizeof(nir_if));
+         cf_list_alloc_size(&nir_cf_node_as_if(node)->then_list, size, count);
+         cf_list_alloc_size(&nir_cf_node_as_if(node)->else_list, size, count);
+         break;
+      case nir_cf_node_loop:
+         add_alloc_size(size, count, sizeof(nir_loop));
+         cf_list_alloc_size(&nir_cf_node_as_loop(node)->body, size, count);
+         break;
+      default:
+         unreachable("bad cf type");
+      }
+   }
+}
+
+/**
+ * Computes the number and total size of the allocations that the
+ * variables, registers, functions, control flow and instructions of
+ * \p shader take directly out of the shader, for ralloc_reserve().
+ */
+void
+nir_shader_get_alloc_size(const nir_shader *shader,
+                          size_t *size, unsigned *count)
+{
+   *size = 0;
+   *count = 0;
+
+   foreach_list_typed(nir_variable, var, node, &shader->variables)
+      add_alloc_size(size, count, sizeof(nir_variable));
+
+   foreach_list_typed(nir_function, func, node, &shader->functions) {
+      add_alloc_size(size, count, sizeof(nir_function));
+      if (!func->impl)
+         continue;
+
+      add_alloc_size(size, count, sizeof(nir_function_impl));
+      foreach_list_typed(nir_variable, var, node, &func->impl->locals)
+         add_alloc_size(size, count, sizeof(nir_variable));
+      foreach_list_typed(nir_register, reg, node, &func->impl->registers)
+         add_alloc_size(size, count, sizeof(nir_register));
+
+      /* The end block isn't part of the body. */
+      add_alloc_size(size, count, sizeof(nir_block));
+      cf_list_alloc_size(&func->impl->body, size, count);
+   }
+}
+
 static nir_const_value
 const_value_float(double d, unsigned bit_size)
 {
@@ -44,10 +44,8 @@
 #define XXH_INLINE_ALL
 #include "util/xxhash.h"
 #include <stdio.h>
-
-#ifndef NDEBUG
 #include "util/debug.h"
-#endif /* NDEBUG */
+#include "util/os_time.h"
 
 #include "nir_opcodes.h"
 
@@ -2742,6 +2740,24 @@ typedef enum {
     */
    nir_metadata_loop_analysis = 0x10,
 
+   /** Indicates that nir_function_impl::range_ht holds valid results of
+    * nir_analyze_range().
+    *
+    * The results are computed lazily, requiring this metadata type only
+    * makes sure the cache is there.  A pass can preserve this metadata type
+    * if it doesn't add, remove or change any instructions.
+    */
+   nir_metadata_range_analysis = 0x20,
+
+   /** Indicates that nir_validate_shader() found no errors in the function
+    * and that it hasn't changed since.
+    *
+    * This is set by the validator rather than by nir_metadata_require(), and
+    * lets it skip functions a pass left alone.  Only passes which preserve
+    * nir_metadata_all keep it.
+    */
+   nir_metadata_validated = 0x40,
+
    /** All metadata
     *
     * This includes all nir_metadata flags except not_properly_reset.  Passes
@@ -2778,6 +2794,9 @@ typedef struct {
    unsigned num_blocks;
 
    nir_metadata valid_metadata;
+
+   /** Cache for nir_analyze_range(), see nir_metadata_range_analysis */
+   struct hash_table *range_ht;
 } nir_function_impl;
 
 #define nir_foreach_function_temp_variable(var, impl) \
@@ -3761,6 +3780,9 @@ nir_variable *nir_variable_clone(const nir_variable *c, nir_shader *shader);
 
 void nir_shader_replace(nir_shader *dest, nir_shader *src);
 
+void nir_shader_get_alloc_size(const nir_shader *shader,
+                               size_t *size, unsigned *count);
+
 void nir_shader_serialize_deserialize(nir_shader *s);
 
 #ifndef NDEBUG
@@ -3824,6 +3846,24 @@ static inline bool should_serialize_deserialize_nir(void) { return false; }
 static inline bool should_print_nir(void) { return false; }
 #endif /* NDEBUG */
 
+/* Unlike the debug options above, pass statistics are also available in
+ * release builds, since that is where timings are meaningful.
+ */
+static inline bool
+should_collect_nir_pass_stats(void)
+{
+   static int collect_stats = -1;
+   if (collect_stats < 0)
+      collect_stats = env_var_as_boolean("NIR_PASS_STATS", false);
+
+   return collect_stats;
+}
+
+/* Accounts one call of \p pass, which started at \p start_ns as returned by
+ * os_time_get_nano(), for the summary printed at exit.
+ */
+void nir_pass_stats_record(const char *pass, int64_t start_ns, bool progress);
+
 #define _PASS(pass, nir, do_pass) do {                               \
    if (should_skip_nir(#pass)) {                                     \
       printf("skipping %s\n", #pass);                                \
@@ -3844,7 +3884,12 @@ static inline bool should_print_nir(void) { return false; }
    nir_metadata_set_validation_flag(nir);                            \
    if (should_print_nir())                                           \
       printf("%s\n", #pass);                                         \
-   if (pass(nir, ##__VA_ARGS__)) {                                   \
+   int64_t _pass_start =                                             \
+      should_collect_nir_pass_stats() ? os_time_get_nano() : 0;      \
+   bool _pass_progress = pass(nir, ##__VA_ARGS__);                   \
+   if (should_collect_nir_pass_stats())                              \
+      nir_pass_stats_record(#pass, _pass_start, _pass_progress);     \
+   if (_pass_progress) {                                             \
       progress = true;                                               \
       if (should_print_nir())                                        \
          nir_print_shader(nir, stdout);                              \
@@ -3855,13 +3900,55 @@ static inline bool should_print_nir(void) { return false; }
 #define NIR_PASS_V(nir, pass, ...) _PASS(pass, nir,                  \
    if (should_print_nir())                                           \
       printf("%s\n", #pass);                                         \
+   int64_t _pass_start =                                             \
+      should_collect_nir_pass_stats() ? os_time_get_nano() : 0;      \
    pass(nir, ##__VA_ARGS__);                                         \
+   if (should_collect_nir_pass_stats())                              \
+      nir_pass_stats_record(#pass, _pass_start, false);              \
    if (should_print_nir())                                           \
       nir_print_shader(nir, stdout);                                 \
 )
 
 #define NIR_SKIP(name) should_skip_nir(#name)
 
+/* Fixed-point optimization loops can use NIR_LOOP_PASS instead of NIR_PASS
+ * to skip passes that would only run again without making progress.
+ *
+ * \p skip is a pointer set, created before the loop, holding the call sites
+ * that made no progress since the shader last changed.  A call site is
+ * skipped while it is in the set, and the set is emptied whenever a pass
+ * makes progress.  This produces the same shader as running every pass, as
+ * long as the arguments of each call site don't change between iterations
+ * and every pass that can change the shader inside the loop goes through
+ * NIR_LOOP_PASS or NIR_LOOP_PASS_V.
+ */
+#define _LOOP_PASS(pass_progress, skip, do_pass) do {                \
+   static char _loop_pass_site;                                      \
+   if (_mesa_set_search(skip, &_loop_pass_site))                     \
+      break;                                                         \
+   bool pass_progress = false;                                       \
+   do_pass                                                           \
+   if (pass_progress)                                                \
+      _mesa_set_clear(skip, NULL);                                   \
+   else                                                              \
+      _mesa_set_add(skip, &_loop_pass_site);                         \
+} while (0)
+
+#define NIR_LOOP_PASS(progress, skip, nir, pass, ...)                \
+   _LOOP_PASS(_loop_pass_progress, skip,                             \
+      NIR_PASS(_loop_pass_progress, nir, pass, ##__VA_ARGS__);       \
+      if (_loop_pass_progress)                                       \
+         progress = true;                                            \
+   )
+
+/* Like NIR_LOOP_PASS, for passes whose progress shouldn't keep the loop
+ * going on its own, but which still return whether they changed the shader.
+ */
+#define NIR_LOOP_PASS_V(skip, nir, pass, ...)                        \
+   _LOOP_PASS(_loop_pass_progress, skip,                             \
+      NIR_PASS(_loop_pass_progress, nir, pass, ##__VA_ARGS__);       \
+   )
+
 /** An instruction filtering callback
  *
  * Returns true if the instruction should be processed and false otherwise.
@@ -4532,6 +4619,22 @@ void nir_loop_analyze_impl(nir_function_impl *impl,
 
 bool nir_ssa_defs_interfere(nir_ssa_def *a, nir_ssa_def *b);
 
+/** A snapshot of the SSA use lists of a function, see nir_use_table.c
+ *
+ * The sources using the def with index i are srcs[offsets[i]] up to, but
+ * not including, srcs[if_offsets[i]], followed by the if conditions using it
+ * up to srcs[offsets[i + 1]].
+ */
+typedef struct {
+   unsigned num_defs;
+   uint32_t *offsets;
+   uint32_t *if_offsets;
+   nir_src **srcs;
+} nir_use_table;
+
+nir_use_table *nir_use_table_create(void *mem_ctx, nir_function_impl *impl,
+                                    const struct exec_list *extra_instrs);
+
 bool nir_repair_ssa_impl(nir_function_impl *impl);
 bool nir_repair_ssa(nir_shader *shader);
 
@@ -4651,6 +4754,7 @@ bool nir_opt_load_store_vectorize(nir_shader *shader, nir_variable_mode modes,
 void nir_strip(nir_shader *shader);
 
 void nir_sweep(nir_shader *shader);
+void nir_shader_compact(nir_shader *shader);
 
 void nir_remap_dual_slot_attributes(nir_shader *shader,
                                     uint64_t *dual_slot_inputs);
@@ -1075,7 +1075,7 @@ _algebraic_pass_template = mako.template.Template("""
 % if state_xforms: # avoid emitting a 0-length array for MSVC
 static const struct transform ${pass_name}_state${state_id}_xforms[] = {
 % for i in state_xforms:
-  { ${xforms[i].search.c_ptr(cache)}, ${xforms[i].replace.c_value_ptr(cache)}, ${xforms[i].condition_index} },
+  { ${xforms[i].search.c_ptr(cache)}, ${xforms[i].replace.c_value_ptr(cache)}, ${xforms[i].condition_index}, ${i} },
 % endfor
 };
 % endif
@@ -1125,6 +1125,16 @@ const uint16_t ${pass_name}_transform_counts[] = {
 % endfor
 };
 
+static struct nir_algebraic_stats ${pass_name}_stats = {
+   .pass_name = "${pass_name}",
+   .num_rules = ${len(xforms)},
+   .attempts = (uint32_t [${len(xforms)}]) { 0 },
+   .hits = (uint32_t [${len(xforms)}]) { 0 },
+   .transforms = ${pass_name}_transforms,
+   .transform_counts = ${pass_name}_transform_counts,
+   .num_states = ${len(automaton.state_patterns)},
+};
+
 bool
 ${pass_name}(nir_shader *shader)
 {
@@ -1139,12 +1149,15 @@ ${pass_name}(nir_shader *shader)
    condition_flags[${index}] = ${condition};
    % endfor
 
+   struct nir_algebraic_stats *stats =
+      should_collect_nir_algebraic_stats() ? &${pass_name}_stats : NULL;
+
    nir_foreach_function(function, shader) {
       if (function->impl) {
          progress |= nir_algebraic_impl(function->impl, condition_flags,
                                         ${pass_name}_transforms,
                                         ${pass_name}_transform_counts,
-                                        ${pass_name}_table);
+                                        ${pass_name}_table, stats);
       }
    }
 
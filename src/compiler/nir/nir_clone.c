@@ -728,6 +728,12 @@ nir_shader_clone(void *mem_ctx, const nir_shader *s)
    nir_shader *ns = nir_shader_create(mem_ctx, s->info.stage, s->options, NULL);
    state.ns = ns;
 
+   /* Lay the clone out in a single block, which also makes it compact. */
+   size_t alloc_size;
+   unsigned alloc_count;
+   nir_shader_get_alloc_size(s, &alloc_size, &alloc_count);
+   ralloc_reserve(ns, alloc_size, alloc_count);
+
    clone_var_list(&state, &ns->variables, &s->variables);
 
    /* Go through and clone functions */
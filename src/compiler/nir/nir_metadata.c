@@ -35,6 +35,8 @@ nir_metadata_require(nir_function_impl *impl, nir_metadata required, ...)
 {
 #define NEEDS_UPDATE(X) ((required & ~impl->valid_metadata) & (X))
 
+   assert(!(required & nir_metadata_validated));
+
    if (NEEDS_UPDATE(nir_metadata_block_index))
       nir_index_blocks(impl);
    if (NEEDS_UPDATE(nir_metadata_dominance))
@@ -47,6 +49,10 @@ nir_metadata_require(nir_function_impl *impl, nir_metadata required, ...)
       nir_loop_analyze_impl(impl, va_arg(ap, nir_variable_mode));
       va_end(ap);
    }
+   if (NEEDS_UPDATE(nir_metadata_range_analysis)) {
+      assert(impl->range_ht == NULL);
+      impl->range_ht = _mesa_pointer_hash_table_create(impl);
+   }
 
 #undef NEEDS_UPDATE
 
@@ -57,6 +63,15 @@ void
 nir_metadata_preserve(nir_function_impl *impl, nir_metadata preserved)
 {
    impl->valid_metadata &= preserved;
+
+   /* The cached ranges are keyed by instruction pointers, which may be
+    * reused by new instructions, so drop them right away.
+    */
+   if (!(impl->valid_metadata & nir_metadata_range_analysis) &&
+       impl->range_ht) {
+      _mesa_hash_table_destroy(impl->range_ht, NULL);
+      impl->range_ht = NULL;
+   }
 }
 
 void
@@ -78,6 +78,11 @@ struct gcm_state {
 
    unsigned num_instrs;
    struct gcm_instr_info *instr_infos;
+
+   /* Uses of each def.  Nothing changes them while scheduling late, so this
+    * avoids walking the use lists of every def.
+    */
+   nir_use_table *uses;
 };
 
 /* Recursively walks the CFG and builds the block_info structure */
@@ -389,9 +394,12 @@ gcm_schedule_late_def(nir_ssa_def *def, void *void_state)
 {
    struct gcm_state *state = void_state;
 
+   nir_use_table *uses = state->uses;
    nir_block *lca = NULL;
 
-   nir_foreach_use(use_src, def) {
+   for (uint32_t i = uses->offsets[def->index];
+        i < uses->if_offsets[def->index]; i++) {
+      nir_src *use_src = uses->srcs[i];
       nir_instr *use_instr = use_src->parent_instr;
 
       gcm_schedule_late_instr(use_instr, state);
@@ -415,8 +423,9 @@ gcm_schedule_late_def(nir_ssa_def *def, void *void_state)
       }
    }
 
-   nir_foreach_if_use(use_src, def) {
-      nir_if *if_stmt = use_src->parent_if;
+   for (uint32_t i = uses->if_offsets[def->index];
+        i < uses->offsets[def->index + 1]; i++) {
+      nir_if *if_stmt = uses->srcs[i]->parent_if;
 
       /* For if statements, we consider the block to be the one immediately
        * preceding the if CF node.
@@ -632,9 +641,13 @@ opt_gcm_impl(nir_function_impl *impl, bool value_number)
    foreach_list_typed(nir_instr, instr, node, &state.instrs)
       gcm_schedule_early_instr(instr, &state);
 
+   state.uses = nir_use_table_create(NULL, impl, &state.instrs);
+
    foreach_list_typed(nir_instr, instr, node, &state.instrs)
       gcm_schedule_late_instr(instr, &state);
 
+   ralloc_free(state.uses);
+
    while (!exec_list_is_empty(&state.instrs)) {
       nir_instr *instr = exec_node_data(nir_instr,
                                         state.instrs.tail_sentinel.prev, node);
@@ -0,0 +1,132 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Per-pass statistics gathered by NIR_PASS and NIR_PASS_V when
+ * NIR_PASS_STATS is set, and printed to stderr when the process exits.
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nir.h"
+#include "util/os_time.h"
+#include "util/simple_mtx.h"
+#include "util/u_process.h"
+
+struct nir_pass_stats {
+   const char *name;
+   uint64_t calls;
+   uint64_t progress;
+   int64_t time_ns;
+};
+
+static simple_mtx_t stats_mtx = _SIMPLE_MTX_INITIALIZER_NP;
+static struct hash_table *stats_table;
+
+static int
+compare_stats(const void *a, const void *b)
+{
+   const struct nir_pass_stats *sa = *(const struct nir_pass_stats **)a;
+   const struct nir_pass_stats *sb = *(const struct nir_pass_stats **)b;
+
+   if (sa->time_ns != sb->time_ns)
+      return sa->time_ns < sb->time_ns ? 1 : -1;
+
+   return strcmp(sa->name, sb->name);
+}
+
+static void
+print_stats_at_exit(void)
+{
+   simple_mtx_lock(&stats_mtx);
+
+   unsigned count = stats_table->entries;
+   struct nir_pass_stats **sorted = malloc(count * sizeof(*sorted));
+   if (!sorted) {
+      simple_mtx_unlock(&stats_mtx);
+      return;
+   }
+
+   unsigned i = 0;
+   int64_t total_ns = 0;
+   hash_table_foreach(stats_table, entry) {
+      sorted[i++] = entry->data;
+      total_ns += ((struct nir_pass_stats *)entry->data)->time_ns;
+   }
+   qsort(sorted, count, sizeof(*sorted), compare_stats);
+
+   const char *process = util_get_process_name();
+   fprintf(stderr, "NIR pass statistics for %s (%.3f ms total):\n",
+           process ? process : "unknown", total_ns / 1000000.0);
+   fprintf(stderr, "%-40s %10s %10s %12s %10s\n",
+           "pass", "calls", "progress", "time (ms)", "no-op (%)");
+   for (i = 0; i < count; i++) {
+      const struct nir_pass_stats *s = sorted[i];
+      fprintf(stderr, "%-40s %10"PRIu64" %10"PRIu64" %12.3f %10.1f\n",
+              s->name, s->calls, s->progress, s->time_ns / 1000000.0,
+              100.0 * (s->calls - s->progress) / s->calls);
+   }
+
+   free(sorted);
+   simple_mtx_unlock(&stats_mtx);
+}
+
+void
+nir_pass_stats_record(const char *pass, int64_t start_ns, bool progress)
+{
+   int64_t time_ns = os_time_get_nano() - start_ns;
+
+   simple_mtx_lock(&stats_mtx);
+
+   if (!stats_table) {
+      stats_table = _mesa_hash_table_create(NULL, _mesa_hash_string,
+                                            _mesa_key_string_equal);
+      if (!stats_table) {
+         simple_mtx_unlock(&stats_mtx);
+         return;
+      }
+      atexit(print_stats_at_exit);
+   }
+
+   struct hash_entry *entry = _mesa_hash_table_search(stats_table, pass);
+   struct nir_pass_stats *s;
+   if (entry) {
+      s = entry->data;
+   } else {
+      s = rzalloc(stats_table, struct nir_pass_stats);
+      if (!s) {
+         simple_mtx_unlock(&stats_mtx);
+         return;
+      }
+      /* Pass names come from string literals in NIR_PASS. */
+      s->name = pass;
+      _mesa_hash_table_insert(stats_table, pass, s);
+   }
+
+   s->calls++;
+   s->progress += progress;
+   s->time_ns += time_ns;
+
+   simple_mtx_unlock(&stats_mtx);
+}
@@ -76,6 +76,9 @@ typedef struct {
    /* Cost of the maximum-delay path from this node to the leaves. */
    uint32_t max_delay;
 
+   /* Clause type from nir_schedule_options::instr_clause_cb, or 0. */
+   unsigned clause;
+
    /* scoreboard->time value when this instruction can be scheduled without
     * any stalls expected.
     */
@@ -110,6 +113,9 @@ typedef struct {
     */
    int pressure;
 
+   /* Clause type of the last scheduled instruction. */
+   unsigned last_clause;
+
    /* Options specified by the backend */
    const nir_schedule_options *options;
 } nir_schedule_scoreboard;
@@ -641,6 +647,27 @@ nir_schedule_choose_instruction_csp(nir_schedule_scoreboard *scoreboard)
 {
    nir_schedule_node *chosen = NULL;
 
+   /* Keep filling the current clause from the ready set, if any. */
+   if (scoreboard->last_clause) {
+      list_for_each_entry(nir_schedule_node, n, &scoreboard->dag->heads, dag.link) {
+         if (scoreboard->time < n->ready_time ||
+             n->clause != scoreboard->last_clause)
+            continue;
+
+         if (!chosen || chosen->max_delay < n->max_delay)
+            chosen = n;
+      }
+      if (chosen) {
+         if (debug) {
+            fprintf(stderr, "chose (ready clause):   ");
+            nir_print_instr(chosen->instr, stderr);
+            fprintf(stderr, "\n");
+         }
+
+         return chosen;
+      }
+   }
+
    /* Find the leader in the ready (shouldn't-stall) set with the maximum
     * cost.
     */
@@ -947,6 +974,7 @@ nir_schedule_mark_node_scheduled(nir_schedule_scoreboard *scoreboard,
 
    scoreboard->time = MAX2(n->ready_time, scoreboard->time);
    scoreboard->time++;
+   scoreboard->last_clause = n->clause;
 }
 
 static void
@@ -1032,17 +1060,27 @@ nir_schedule_block(nir_schedule_scoreboard *scoreboard, nir_block *block)
 
    scoreboard->dag = dag_create(mem_ctx);
 
+   const nir_schedule_options *options = scoreboard->options;
+
    nir_foreach_instr(instr, block) {
       nir_schedule_node *n =
          rzalloc(mem_ctx, nir_schedule_node);
 
       n->instr = instr;
-      n->delay = nir_schedule_get_delay(instr);
+      if (options->instr_delay_cb)
+         n->delay = options->instr_delay_cb(instr, options->instr_delay_cb_data);
+      else
+         n->delay = nir_schedule_get_delay(instr);
+      if (options->instr_clause_cb)
+         n->clause = options->instr_clause_cb(instr,
+                                              options->instr_clause_cb_data);
       dag_init_node(scoreboard->dag, &n->dag);
 
       _mesa_hash_table_insert(scoreboard->instr_map, instr, n);
    }
 
+   scoreboard->last_clause = 0;
+
    calculate_forward_deps(scoreboard, block);
    calculate_reverse_deps(scoreboard, block);
 
@@ -73,6 +73,22 @@ typedef struct nir_schedule_options {
                          void *user_data);
    /* Data to pass to the callback */
    void *intrinsic_cb_data;
+   /* Callback returning the approximate number of cycles between starting
+    * instr and its results being available.  If NULL, a generic estimate is
+    * used, which only gives texture instructions a long latency.
+    */
+   uint32_t (* instr_delay_cb)(nir_instr *instr, void *user_data);
+   /* Data to pass to the callback */
+   void *instr_delay_cb_data;
+   /* Callback returning the type of clause that instr can be grouped into,
+    * such as texture fetches or memory loads, or 0 if none.  While it isn't
+    * trying to reduce register pressure, the scheduler prefers a ready
+    * instruction of the same clause type as the previous one, so that the
+    * backend can put them in a single clause.
+    */
+   unsigned (* instr_clause_cb)(nir_instr *instr, void *user_data);
+   /* Data to pass to the callback */
+   void *instr_clause_cb_data;
 } nir_schedule_options;
 
 void nir_schedule(nir_shader *shader, const nir_schedule_options *options);
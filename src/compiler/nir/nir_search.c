@@ -30,6 +30,9 @@
 #include "nir_builder.h"
 #include "nir_worklist.h"
 #include "util/half_float.h"
+#include "util/simple_mtx.h"
+#include "util/u_atomic.h"
+#include "util/u_process.h"
 
 /* This should be the same as nir_search_max_comm_ops in nir_algebraic.py. */
 #define NIR_SEARCH_MAX_COMM_OPS 8
@@ -577,7 +580,7 @@ construct_value(nir_builder *build,
    }
 }
 
-UNUSED static void dump_value(const nir_search_value *val)
+static void dump_value(const nir_search_value *val)
 {
    switch (val->type) {
    case nir_search_value_constant: {
@@ -863,6 +866,7 @@ nir_algebraic_instr(nir_builder *build, nir_instr *instr,
                     const uint16_t *transform_counts,
                     struct util_dynarray *states,
                     const struct per_op_table *pass_op_table,
+                    struct nir_algebraic_stats *stats,
                     nir_instr_worklist *worklist)
 {
 
@@ -880,31 +884,124 @@ nir_algebraic_instr(nir_builder *build, nir_instr *instr,
       nir_is_float_control_signed_zero_inf_nan_preserve(execution_mode, bit_size) ||
       nir_is_denorm_flush_to_zero(execution_mode, bit_size);
 
+   /* Rules that only differ in their replacement or condition share their
+    * search expression, and whether it matches only depends on the
+    * expression and the instruction, so don't try it twice in a row.
+    */
+   const nir_search_expression *failed_search = NULL;
+
    int xform_idx = *util_dynarray_element(states, uint16_t,
                                           alu->dest.dest.ssa.index);
    for (uint16_t i = 0; i < transform_counts[xform_idx]; i++) {
       const struct transform *xform = &transforms[xform_idx][i];
-      if (condition_flags[xform->condition_offset] &&
-          !(xform->search->inexact && ignore_inexact) &&
-          nir_replace_instr(build, alu, range_ht, states, pass_op_table,
+      if (!condition_flags[xform->condition_offset] ||
+          (xform->search->inexact && ignore_inexact) ||
+          xform->search == failed_search)
+         continue;
+
+      if (stats)
+         p_atomic_inc(&stats->attempts[xform->index]);
+
+      if (nir_replace_instr(build, alu, range_ht, states, pass_op_table,
                             xform->search, xform->replace, worklist)) {
+         if (stats)
+            p_atomic_inc(&stats->hits[xform->index]);
+
          _mesa_hash_table_clear(range_ht, NULL);
          return true;
       }
+
+      failed_search = xform->search;
    }
 
    return false;
 }
 
+static simple_mtx_t algebraic_stats_mtx = _SIMPLE_MTX_INITIALIZER_NP;
+static struct util_dynarray algebraic_stats_passes;
+
+static const struct transform *
+find_rule(const struct nir_algebraic_stats *stats, unsigned index)
+{
+   for (unsigned s = 0; s < stats->num_states; s++) {
+      for (unsigned i = 0; i < stats->transform_counts[s]; i++) {
+         if (stats->transforms[s][i].index == index)
+            return &stats->transforms[s][i];
+      }
+   }
+
+   return NULL;
+}
+
+static void
+print_algebraic_stats_at_exit(void)
+{
+   simple_mtx_lock(&algebraic_stats_mtx);
+
+   util_dynarray_foreach(&algebraic_stats_passes,
+                         struct nir_algebraic_stats *, stats_ptr) {
+      const struct nir_algebraic_stats *stats = *stats_ptr;
+
+      unsigned never_fired = 0;
+      for (unsigned i = 0; i < stats->num_rules; i++)
+         never_fired += stats->hits[i] == 0;
+
+      const char *process = util_get_process_name();
+      fprintf(stderr, "%s rules that never fired in %s: %u of %u\n",
+              stats->pass_name, process ? process : "unknown",
+              never_fired, stats->num_rules);
+
+      /* Rules that were tried without ever matching are the ones costing
+       * compile time, so show their number of attempts.
+       */
+      for (unsigned i = 0; i < stats->num_rules; i++) {
+         if (stats->hits[i] != 0)
+            continue;
+
+         const struct transform *xform = find_rule(stats, i);
+         assert(xform);
+
+         fprintf(stderr, "%10u  ", stats->attempts[i]);
+         dump_value(&xform->search->value);
+         fprintf(stderr, " -> ");
+         dump_value(xform->replace);
+         fprintf(stderr, "\n");
+      }
+   }
+
+   simple_mtx_unlock(&algebraic_stats_mtx);
+}
+
+static void
+register_algebraic_stats(struct nir_algebraic_stats *stats)
+{
+   simple_mtx_lock(&algebraic_stats_mtx);
+
+   if (!stats->registered) {
+      if (!algebraic_stats_passes.size)
+         atexit(print_algebraic_stats_at_exit);
+
+      util_dynarray_append(&algebraic_stats_passes,
+                           struct nir_algebraic_stats *, stats);
+      stats->registered = true;
+   }
+
+   simple_mtx_unlock(&algebraic_stats_mtx);
+}
+
 bool
 nir_algebraic_impl(nir_function_impl *impl,
                    const bool *condition_flags,
                    const struct transform **transforms,
                    const uint16_t *transform_counts,
-                   const struct per_op_table *pass_op_table)
+                   const struct per_op_table *pass_op_table,
+                   struct nir_algebraic_stats *stats)
 {
    bool progress = false;
 
+   if (stats && !p_atomic_read(&stats->registered))
+      register_algebraic_stats(stats);
+
    nir_builder build;
    nir_builder_init(&build, impl);
 
@@ -919,7 +1016,9 @@ nir_algebraic_impl(nir_function_impl *impl,
    }
    memset(states.data, 0, states.size);
 
-   struct hash_table *range_ht = _mesa_pointer_hash_table_create(NULL);
+   /* Range analysis results stay valid across runs that make no progress. */
+   nir_metadata_require(impl, nir_metadata_range_analysis);
+   struct hash_table *range_ht = impl->range_ht;
 
    nir_instr_worklist *worklist = nir_instr_worklist_create();
 
@@ -952,11 +1051,10 @@ nir_algebraic_impl(nir_function_impl *impl,
       progress |= nir_algebraic_instr(&build, instr,
                                       range_ht, condition_flags,
                                       transforms, transform_counts, &states,
-                                      pass_op_table, worklist);
+                                      pass_op_table, stats, worklist);
    }
 
    nir_instr_worklist_destroy(worklist);
-   ralloc_free(range_ht);
    util_dynarray_fini(&states);
 
    if (progress) {
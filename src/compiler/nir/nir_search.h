@@ -178,8 +178,39 @@ struct transform {
    const nir_search_expression *search;
    const nir_search_value *replace;
    unsigned condition_offset;
+
+   /* Position of the rule in the pass, for nir_algebraic_stats. */
+   uint16_t index;
+};
+
+/* How often each rule of an algebraic pass was matched against an
+ * instruction and how often it fired, gathered when NIR_ALGEBRAIC_STATS is
+ * set.  Rules that never fired are printed to stderr when the process exits.
+ */
+struct nir_algebraic_stats {
+   const char *pass_name;
+   unsigned num_rules;
+   uint32_t *attempts;
+   uint32_t *hits;
+
+   /* Used to find the rules back from their index when printing. */
+   const struct transform **transforms;
+   const uint16_t *transform_counts;
+   unsigned num_states;
+
+   bool registered;
 };
 
+static inline bool
+should_collect_nir_algebraic_stats(void)
+{
+   static int collect_stats = -1;
+   if (collect_stats < 0)
+      collect_stats = env_var_as_boolean("NIR_ALGEBRAIC_STATS", false);
+
+   return collect_stats;
+}
+
 /* Note: these must match the start states created in
  * TreeAutomaton._build_table()
  */
@@ -210,6 +241,7 @@ nir_algebraic_impl(nir_function_impl *impl,
                    const bool *condition_flags,
                    const struct transform **transforms,
                    const uint16_t *transform_counts,
-                   const struct per_op_table *pass_op_table);
+                   const struct per_op_table *pass_op_table,
+                   struct nir_algebraic_stats *stats);
 
 #endif /* _NIR_SEARCH_ */
@@ -1999,6 +1999,13 @@ nir_serialize(struct blob *blob, const nir_shader *nir, bool strip)
 
    size_t idx_size_offset = blob_reserve_uint32(blob);
 
+   /* Let the reader reserve memory for the whole shader at once. */
+   size_t alloc_size;
+   unsigned alloc_count;
+   nir_shader_get_alloc_size(nir, &alloc_size, &alloc_count);
+   blob_write_uint32(blob, MIN2(alloc_size, UINT32_MAX));
+   blob_write_uint32(blob, alloc_count);
+
    struct shader_info info = nir->info;
    uint32_t strings = 0;
    if (!strip && info.name)
@@ -2051,6 +2058,8 @@ nir_deserialize(void *mem_ctx,
    list_inithead(&ctx.phi_srcs);
    ctx.idx_table_len = blob_read_uint32(blob);
    ctx.idx_table = calloc(ctx.idx_table_len, sizeof(uintptr_t));
+   uint32_t alloc_size = blob_read_uint32(blob);
+   uint32_t alloc_count = blob_read_uint32(blob);
 
    uint32_t strings = blob_read_uint32(blob);
    char *name = (strings & 0x1) ? blob_read_string(blob) : NULL;
@@ -2061,6 +2070,11 @@ nir_deserialize(void *mem_ctx,
 
    ctx.nir = nir_shader_create(mem_ctx, info.stage, options, NULL);
 
+   /* Allocate the instructions, blocks, variables and registers out of a
+    * single block.  If that fails, they just come from malloc.
+    */
+   ralloc_reserve(ctx.nir, alloc_size, alloc_count);
+
    info.name = name ? ralloc_strdup(ctx.nir, name) : NULL;
    info.label = label ? ralloc_strdup(ctx.nir, label) : NULL;
 
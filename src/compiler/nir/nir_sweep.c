@@ -175,3 +175,19 @@ nir_sweep(nir_shader *nir)
    /* Free everything we didn't steal back. */
    ralloc_free(rubbish);
 }
+
+/**
+ * Replaces the shader's memory with a clone of it, laid out in a single
+ * block.
+ *
+ * Like nir_sweep(), this frees dead memory, but it also undoes the
+ * fragmentation left by many rounds of optimizations, at the cost of
+ * invalidating any pointer into the shader other than the nir_shader itself.
+ * Instruction pass_flags are not preserved.
+ */
+void
+nir_shader_compact(nir_shader *nir)
+{
+   nir_shader *clone = nir_shader_clone(ralloc_parent(nir), nir);
+   nir_shader_replace(nir, clone);
+}
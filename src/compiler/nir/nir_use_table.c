@@ -0,0 +1,133 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "nir.h"
+
+/*
+ * Builds a compact snapshot of the SSA use lists of a function.
+ *
+ * Walking nir_ssa_def::uses means chasing a pointer per use into whatever
+ * instruction holds the source.  Passes which walk the uses of most defs
+ * without changing them can instead build this table once, with two linear
+ * walks over the instructions, and then read each def's uses from a
+ * contiguous array.  The table is not updated as the shader changes.
+ */
+
+struct use_table_state {
+   nir_use_table *table;
+   uint32_t *counts;
+};
+
+static bool
+count_src(nir_src *src, void *void_state)
+{
+   struct use_table_state *state = void_state;
+
+   if (src->is_ssa)
+      state->counts[src->ssa->index]++;
+
+   return true;
+}
+
+static bool
+add_src(nir_src *src, void *void_state)
+{
+   struct use_table_state *state = void_state;
+
+   if (src->is_ssa)
+      state->table->srcs[state->counts[src->ssa->index]++] = src;
+
+   return true;
+}
+
+/* Builds the table for the instructions of \p impl's blocks, plus those in
+ * \p extra_instrs if not NULL, for passes that temporarily pull
+ * instructions out of their blocks.
+ */
+nir_use_table *
+nir_use_table_create(void *mem_ctx, nir_function_impl *impl,
+                     const struct exec_list *extra_instrs)
+{
+   nir_use_table *table = ralloc(mem_ctx, nir_use_table);
+   unsigned num_defs = impl->ssa_alloc;
+
+   table->num_defs = num_defs;
+   table->offsets = ralloc_array(table, uint32_t, num_defs + 1);
+   table->if_offsets = ralloc_array(table, uint32_t, num_defs);
+
+   struct use_table_state state = {
+      .table = table,
+      .counts = rzalloc_array(NULL, uint32_t, num_defs * 2),
+   };
+   uint32_t *if_counts = state.counts + num_defs;
+
+   if (extra_instrs) {
+      foreach_list_typed(nir_instr, instr, node, extra_instrs)
+         nir_foreach_src(instr, count_src, &state);
+   }
+
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr(instr, block)
+         nir_foreach_src(instr, count_src, &state);
+
+      nir_if *following_if = nir_block_get_following_if(block);
+      if (following_if && following_if->condition.is_ssa)
+         if_counts[following_if->condition.ssa->index]++;
+   }
+
+   /* Each def's instruction uses come first, then its if uses.  The counts
+    * become the insertion cursors.
+    */
+   uint32_t num_uses = 0;
+   for (unsigned i = 0; i < num_defs; i++) {
+      table->offsets[i] = num_uses;
+      table->if_offsets[i] = num_uses + state.counts[i];
+      num_uses = table->if_offsets[i] + if_counts[i];
+
+      state.counts[i] = table->offsets[i];
+      if_counts[i] = table->if_offsets[i];
+   }
+   table->offsets[num_defs] = num_uses;
+
+   table->srcs = ralloc_array(table, nir_src *, num_uses);
+
+   if (extra_instrs) {
+      foreach_list_typed(nir_instr, instr, node, extra_instrs)
+         nir_foreach_src(instr, add_src, &state);
+   }
+
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr(instr, block)
+         nir_foreach_src(instr, add_src, &state);
+
+      nir_if *following_if = nir_block_get_following_if(block);
+      if (following_if && following_if->condition.is_ssa) {
+         unsigned index = following_if->condition.ssa->index;
+         table->srcs[if_counts[index]++] = &following_if->condition;
+      }
+   }
+
+   ralloc_free(state.counts);
+
+   return table;
+}
@@ -27,6 +27,7 @@
 
 #include "nir.h"
 #include "c11/threads.h"
+#include "util/u_atomic.h"
 #include <assert.h>
 
 /*
@@ -1209,11 +1210,21 @@ validate_function_impl(nir_function_impl *impl, validate_state *state)
 }
 
 static void
-validate_function(nir_function *func, validate_state *state)
+validate_function(nir_function *func, bool validate_all,
+                  validate_state *state)
 {
    if (func->impl != NULL) {
       validate_assert(state, func->impl->function == func);
+
+      /* Only check functions that changed since they were last validated. */
+      if (!validate_all &&
+          (func->impl->valid_metadata & nir_metadata_validated))
+         return;
+
       validate_function_impl(func->impl, state);
+
+      if (_mesa_hash_table_num_entries(state->errors) == 0)
+         func->impl->valid_metadata |= nir_metadata_validated;
    }
 }
 
@@ -1283,6 +1294,16 @@ nir_validate_shader(nir_shader *shader, const char *when)
    if (!should_validate)
       return;
 
+   /* Every full_interval-th validation checks all functions, in case a pass
+    * changed one without invalidating its metadata.
+    */
+   static int full_interval = -1;
+   static unsigned validation_count;
+   if (full_interval < 0)
+      full_interval = env_var_as_unsigned("NIR_VALIDATE_FULL_INTERVAL", 16);
+   bool validate_all = full_interval &&
+      p_atomic_inc_return(&validation_count) % full_interval == 0;
+
    validate_state state;
    init_validate_state(&state);
 
@@ -1304,7 +1325,7 @@ nir_validate_shader(nir_shader *shader, const char *when)
 
    exec_list_validate(&shader->functions);
    foreach_list_typed(nir_function, func, node, &shader->functions) {
-      validate_function(func, &state);
+      validate_function(func, validate_all, &state);
    }
 
    if (_mesa_hash_table_num_entries(state.errors) > 0)
@@ -0,0 +1,335 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Times the common NIR passes, and a typical optimization loop, over a
+ * corpus of shaders and prints the median of each over a number of runs.
+ *
+ * The corpus is a few shaders built here, plus the nir_serialize() blobs
+ * found in the directory pointed to by NIR_BENCHMARK_CORPUS, if set.
+ * NIR_BENCHMARK_RUNS sets the number of runs, 15 by default.
+ *
+ * Each pass is timed on its own, on clones of the shaders as left by the
+ * passes before it in the list, so that it sees the kind of input it gets
+ * in drivers.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <dirent.h>
+#include <vector>
+
+#include "nir.h"
+#include "nir_builder.h"
+#include "nir_serialize.h"
+#include "util/os_file.h"
+#include "util/os_time.h"
+
+namespace {
+
+static bool
+lower_alu_to_scalar(nir_shader *shader)
+{
+   return nir_lower_alu_to_scalar(shader, NULL, NULL);
+}
+
+static bool
+opt_if(nir_shader *shader)
+{
+   return nir_opt_if(shader, false);
+}
+
+static bool
+opt_peephole_select(nir_shader *shader)
+{
+   return nir_opt_peephole_select(shader, 8, true, true);
+}
+
+static bool
+opt_loop_unroll(nir_shader *shader)
+{
+   return nir_opt_loop_unroll(shader, nir_var_function_temp);
+}
+
+static bool
+convert_from_ssa(nir_shader *shader)
+{
+   return nir_convert_from_ssa(shader, false);
+}
+
+static const struct {
+   const char *name;
+   bool (*run)(nir_shader *);
+} passes[] = {
+#define PASS(pass) { #pass, pass }
+   PASS(nir_opt_copy_prop_vars),
+   PASS(nir_opt_dead_write_vars),
+   PASS(nir_lower_vars_to_ssa),
+   PASS(lower_alu_to_scalar),
+   PASS(nir_lower_phis_to_scalar),
+   PASS(nir_copy_prop),
+   PASS(nir_opt_remove_phis),
+   PASS(nir_opt_dce),
+   PASS(nir_opt_dead_cf),
+   PASS(nir_opt_cse),
+   PASS(opt_peephole_select),
+   PASS(nir_opt_algebraic),
+   PASS(nir_opt_constant_folding),
+   PASS(opt_if),
+   PASS(opt_loop_unroll),
+   PASS(nir_opt_undef),
+   PASS(convert_from_ssa),
+#undef PASS
+};
+
+static void
+optimize(nir_shader *shader)
+{
+   bool progress;
+
+   nir_lower_vars_to_ssa(shader);
+
+   do {
+      progress = false;
+      progress |= nir_opt_copy_prop_vars(shader);
+      progress |= nir_opt_dead_write_vars(shader);
+      progress |= nir_lower_vars_to_ssa(shader);
+      progress |= nir_copy_prop(shader);
+      progress |= nir_opt_remove_phis(shader);
+      progress |= nir_opt_dce(shader);
+      progress |= nir_opt_dead_cf(shader);
+      progress |= nir_opt_cse(shader);
+      progress |= opt_peephole_select(shader);
+      progress |= nir_opt_algebraic(shader);
+      progress |= nir_opt_constant_folding(shader);
+      progress |= opt_if(shader);
+      progress |= opt_loop_unroll(shader);
+      progress |= nir_opt_undef(shader);
+   } while (progress);
+}
+
+class nir_pass_benchmark : public ::testing::Test {
+protected:
+   nir_pass_benchmark();
+   ~nir_pass_benchmark();
+
+   nir_shader *build_alu_shader(unsigned size);
+   nir_shader *build_cf_shader(unsigned depth);
+   void load_corpus(const char *path);
+
+   void *mem_ctx;
+   nir_shader_compiler_options options;
+   std::vector<nir_shader *> corpus;
+   unsigned runs;
+};
+
+nir_pass_benchmark::nir_pass_benchmark()
+:  options()
+{
+   glsl_type_singleton_init_or_ref();
+
+   mem_ctx = ralloc_context(NULL);
+
+   options.max_unroll_iterations = 32;
+
+   const char *env = getenv("NIR_BENCHMARK_RUNS");
+   runs = env ? MAX2(atoi(env), 1) : 15;
+
+   corpus.push_back(build_alu_shader(64));
+   corpus.push_back(build_alu_shader(512));
+   corpus.push_back(build_cf_shader(4));
+   corpus.push_back(build_cf_shader(8));
+
+   env = getenv("NIR_BENCHMARK_CORPUS");
+   if (env)
+      load_corpus(env);
+}
+
+nir_pass_benchmark::~nir_pass_benchmark()
+{
+   ralloc_free(mem_ctx);
+
+   glsl_type_singleton_decref();
+}
+
+/* Straight-line arithmetic with redundant and constant expressions, going
+ * through a local array.
+ */
+nir_shader *
+nir_pass_benchmark::build_alu_shader(unsigned size)
+{
+   nir_builder b;
+   nir_builder_init_simple_shader(&b, mem_ctx, MESA_SHADER_FRAGMENT, &options);
+
+   nir_variable *in = nir_variable_create(b.shader, nir_var_shader_in,
+                                          glsl_vec4_type(), "in");
+   nir_variable *out = nir_variable_create(b.shader, nir_var_shader_out,
+                                           glsl_vec4_type(), "out");
+   nir_variable *tmp = nir_local_variable_create(b.impl,
+                                                 glsl_array_type(glsl_vec4_type(), 8, 0),
+                                                 "tmp");
+
+   nir_ssa_def *v = nir_load_var(&b, in);
+   for (unsigned i = 0; i < size; i++) {
+      nir_ssa_def *c = nir_fmul(&b, nir_imm_float(&b, i), nir_imm_float(&b, 0.5f));
+      nir_ssa_def *x = nir_fadd(&b, nir_fmul(&b, v, c), v);
+      nir_ssa_def *y = nir_fadd(&b, nir_fmul(&b, v, c), v);
+
+      nir_store_deref(&b, nir_build_deref_array_imm(&b, nir_build_deref_var(&b, tmp), i % 8),
+                      nir_fmax(&b, x, nir_fneg(&b, y)), 0xf);
+      v = nir_load_deref(&b, nir_build_deref_array_imm(&b, nir_build_deref_var(&b, tmp),
+                                                       (i + 7) % 8));
+      v = nir_ffma(&b, v, x, nir_fsat(&b, y));
+   }
+   nir_store_var(&b, out, v, 0xf);
+
+   return b.shader;
+}
+
+/* Nested loops and ifs, with values flowing through local variables. */
+nir_shader *
+nir_pass_benchmark::build_cf_shader(unsigned depth)
+{
+   nir_builder b;
+   nir_builder_init_simple_shader(&b, mem_ctx, MESA_SHADER_COMPUTE, &options);
+
+   nir_variable *acc = nir_local_variable_create(b.impl, glsl_int_type(), "acc");
+   nir_variable *result = nir_variable_create(b.shader, nir_var_mem_shared,
+                                              glsl_int_type(), "result");
+   nir_store_var(&b, acc, nir_imm_int(&b, 0), 0x1);
+
+   for (unsigned d = 0; d < depth; d++) {
+      nir_variable *i = nir_local_variable_create(b.impl, glsl_int_type(), "i");
+      nir_store_var(&b, i, nir_imm_int(&b, 0), 0x1);
+
+      nir_push_loop(&b);
+      nir_ssa_def *iv = nir_load_var(&b, i);
+      nir_push_if(&b, nir_ige(&b, iv, nir_imm_int(&b, 4)));
+      nir_jump(&b, nir_jump_break);
+      nir_pop_if(&b, NULL);
+
+      nir_ssa_def *a = nir_load_var(&b, acc);
+      nir_push_if(&b, nir_ieq(&b, nir_iand(&b, iv, nir_imm_int(&b, 1)),
+                              nir_imm_int(&b, 0)));
+      nir_store_var(&b, acc, nir_iadd(&b, a, nir_imul(&b, iv, nir_imm_int(&b, d + 1))), 0x1);
+      nir_push_else(&b, NULL);
+      nir_store_var(&b, acc, nir_ixor(&b, a, nir_ishl(&b, iv, nir_imm_int(&b, d))), 0x1);
+      nir_pop_if(&b, NULL);
+
+      nir_store_var(&b, i, nir_iadd_imm(&b, iv, 1), 0x1);
+   }
+
+   nir_store_var(&b, result, nir_load_var(&b, acc), 0x1);
+
+   for (unsigned d = 0; d < depth; d++)
+      nir_pop_loop(&b, NULL);
+
+   return b.shader;
+}
+
+void
+nir_pass_benchmark::load_corpus(const char *path)
+{
+   DIR *dir = opendir(path);
+   ASSERT_TRUE(dir != NULL) << "can't open " << path;
+
+   struct dirent *entry;
+   while ((entry = readdir(dir))) {
+      if (entry->d_name[0] == '.')
+         continue;
+
+      char *file = ralloc_asprintf(mem_ctx, "%s/%s", path, entry->d_name);
+      size_t size;
+      char *data = os_read_file(file, &size);
+      if (!data)
+         continue;
+
+      struct blob_reader reader;
+      blob_reader_init(&reader, data, size);
+      nir_shader *shader = nir_deserialize(mem_ctx, &options, &reader);
+      free(data);
+
+      EXPECT_TRUE(shader != NULL) << file << " isn't a serialized shader";
+      if (shader)
+         corpus.push_back(shader);
+   }
+
+   closedir(dir);
+}
+
+static int64_t
+median(std::vector<int64_t> &times)
+{
+   std::sort(times.begin(), times.end());
+   return times[times.size() / 2];
+}
+
+} // namespace
+
+TEST_F(nir_pass_benchmark, passes)
+{
+   const unsigned num_passes = ARRAY_SIZE(passes);
+   std::vector<std::vector<int64_t>> times(num_passes + 1,
+                                           std::vector<int64_t>(runs, 0));
+   unsigned num_instrs = 0;
+
+   for (nir_shader *shader : corpus) {
+      nir_validate_shader(shader, "benchmark corpus");
+
+      nir_foreach_function(func, shader) {
+         if (!func->impl)
+            continue;
+         nir_foreach_block(block, func->impl) {
+            nir_foreach_instr(instr, block)
+               num_instrs++;
+         }
+      }
+
+      nir_shader *state = nir_shader_clone(mem_ctx, shader);
+
+      for (unsigned p = 0; p < num_passes; p++) {
+         for (unsigned r = 0; r < runs; r++) {
+            nir_shader *clone = nir_shader_clone(NULL, state);
+            int64_t start = os_time_get_nano();
+            passes[p].run(clone);
+            times[p][r] += os_time_get_nano() - start;
+            ralloc_free(clone);
+         }
+         passes[p].run(state);
+      }
+
+      for (unsigned r = 0; r < runs; r++) {
+         nir_shader *clone = nir_shader_clone(NULL, shader);
+         int64_t start = os_time_get_nano();
+         optimize(clone);
+         times[num_passes][r] += os_time_get_nano() - start;
+         ralloc_free(clone);
+      }
+   }
+
+   printf("%u shaders, %u instructions, median of %u runs:\n",
+          (unsigned)corpus.size(), num_instrs, runs);
+   for (unsigned p = 0; p < num_passes; p++)
+      printf("%-28s %10.1f us\n", passes[p].name, median(times[p]) / 1000.0);
+   printf("%-28s %10.1f us\n", "optimization loop", median(times[num_passes]) / 1000.0);
+}
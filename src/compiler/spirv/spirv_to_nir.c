@@ -5604,24 +5604,20 @@ spirv_to_nir(const uint32_t *words, size_t word_count,
    /* Set types on all vtn_values */
    vtn_foreach_instruction(b, words, word_end, vtn_set_instruction_result_type);
 
+   assert(b->entry_point->value_type == vtn_value_type_function);
    vtn_build_cfg(b, words, word_end);
 
-   assert(b->entry_point->value_type == vtn_value_type_function);
-   b->entry_point->func->referenced = true;
-
-   bool progress;
-   do {
-      progress = false;
-      vtn_foreach_cf_node(node, &b->functions) {
-         struct vtn_function *func = vtn_cf_node_as_function(node);
-         if (func->referenced && !func->emitted) {
-            b->const_table = _mesa_pointer_hash_table_create(b);
-
-            vtn_function_emit(b, func, vtn_handle_body_instruction);
-            progress = true;
-         }
+   /* vtn_build_cfg() found all the functions the entry point may call, so
+    * a single walk emits all of them.
+    */
+   vtn_foreach_cf_node(node, &b->functions) {
+      struct vtn_function *func = vtn_cf_node_as_function(node);
+      if (func->referenced && !func->emitted) {
+         b->const_table = _mesa_pointer_hash_table_create(b);
+
+         vtn_function_emit(b, func, vtn_handle_body_instruction);
       }
-   } while (progress);
+   }
 
    vtn_assert(b->entry_point->value_type == vtn_value_type_function);
    nir_function *entry_point = b->entry_point->func->impl->function;
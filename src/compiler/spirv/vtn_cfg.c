@@ -158,6 +158,7 @@ vtn_cfg_handle_prepass_instruction(struct vtn_builder *b, SpvOp opcode,
       b->func->node.type = vtn_cf_node_type_function;
       b->func->node.parent = NULL;
       list_inithead(&b->func->body);
+      util_dynarray_init(&b->func->callees, b->func);
       b->func->control = w[3];
 
       UNUSED const struct glsl_type *result_type = vtn_get_type(b, w[1])->type;
@@ -261,6 +262,11 @@ vtn_cfg_handle_prepass_instruction(struct vtn_builder *b, SpvOp opcode,
       b->block = NULL;
       break;
 
+   case SpvOpFunctionCall:
+      /* The callee may not be declared yet, so only keep its id */
+      util_dynarray_append(&b->func->callees, uint32_t, w[3]);
+      break;
+
    default:
       /* Continue on as per normal */
       return true;
@@ -269,6 +275,37 @@ vtn_cfg_handle_prepass_instruction(struct vtn_builder *b, SpvOp opcode,
    return true;
 }
 
+/* Marks the entry point and all the functions it can call as referenced.
+ * Modules coming from translation layers or OpenCL often carry many more
+ * functions than any one entry point uses, and there is no point in
+ * structurizing or emitting those.
+ */
+static void
+vtn_mark_referenced_functions(struct vtn_builder *b)
+{
+   struct util_dynarray work;
+   util_dynarray_init(&work, NULL);
+
+   b->entry_point->func->referenced = true;
+   util_dynarray_append(&work, struct vtn_function *, b->entry_point->func);
+
+   while (util_dynarray_num_elements(&work, struct vtn_function *)) {
+      struct vtn_function *func =
+         util_dynarray_pop(&work, struct vtn_function *);
+
+      util_dynarray_foreach(&func->callees, uint32_t, id) {
+         struct vtn_function *callee =
+            vtn_value(b, *id, vtn_value_type_function)->func;
+         if (!callee->referenced) {
+            callee->referenced = true;
+            util_dynarray_append(&work, struct vtn_function *, callee);
+         }
+      }
+   }
+
+   util_dynarray_fini(&work);
+}
+
 /* This function performs a depth-first search of the cases and puts them
  * in fall-through order.
  */
@@ -818,8 +855,12 @@ vtn_build_cfg(struct vtn_builder *b, const uint32_t *words, const uint32_t *end)
    vtn_foreach_instruction(b, words, end,
                            vtn_cfg_handle_prepass_instruction);
 
+   vtn_mark_referenced_functions(b);
+
    vtn_foreach_cf_node(func_node, &b->functions) {
       struct vtn_function *func = vtn_cf_node_as_function(func_node);
+      if (!func->referenced)
+         continue;
 
       /* We build the CFG for each function by doing a breadth-first search on
        * the control-flow graph.  We keep track of our state using a worklist.
@@ -253,6 +253,9 @@ struct vtn_function {
    bool referenced;
    bool emitted;
 
+   /* SPIR-V ids of the functions called from this one */
+   struct util_dynarray callees;
+
    nir_function_impl *impl;
    struct vtn_block *start_block;
 
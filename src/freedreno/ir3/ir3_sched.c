@@ -99,6 +99,9 @@ struct ir3_sched_ctx {
 
 	int sfu_delay;
 	int tex_delay;
+
+	/* bumped for each instruction choice, see sched_node_eval(): */
+	unsigned eval_serial;
 };
 
 struct ir3_sched_node {
@@ -140,6 +143,28 @@ struct ir3_sched_node {
 	 * register pressure (or at least are neutral)
 	 */
 	bool output;
+
+	/* The heuristics below only depend on what has been scheduled so
+	 * far, so when choosing the next instruction each one is evaluated
+	 * at most once per node, and the result reused by the subsequent
+	 * passes over the ready list.  The cached values are valid if
+	 * eval_serial matches the one of the ctx.
+	 */
+	unsigned eval_serial;
+	unsigned eval_valid;   /* mask of SCHED_EVAL_x */
+	unsigned eval_delay;
+	int eval_live_effect;
+	int eval_nearest_use;
+	bool eval_would_sync;
+	bool eval_check;
+};
+
+enum {
+	SCHED_EVAL_DELAY       = 1 << 0,
+	SCHED_EVAL_LIVE_EFFECT = 1 << 1,
+	SCHED_EVAL_NEAREST_USE = 1 << 2,
+	SCHED_EVAL_WOULD_SYNC  = 1 << 3,
+	SCHED_EVAL_CHECK       = 1 << 4,
 };
 
 #define foreach_sched_node(__n, __list) \
@@ -460,6 +485,70 @@ would_sync(struct ir3_sched_ctx *ctx, struct ir3_instruction *instr)
 	return false;
 }
 
+/* Returns true if the heuristic \p bit still needs to be evaluated for
+ * node \p n in the current instruction choice, and marks it as evaluated.
+ */
+static bool
+sched_node_eval(struct ir3_sched_ctx *ctx, struct ir3_sched_node *n,
+		unsigned bit)
+{
+	if (n->eval_serial != ctx->eval_serial) {
+		n->eval_serial = ctx->eval_serial;
+		n->eval_valid = 0;
+	}
+
+	if (n->eval_valid & bit)
+		return false;
+
+	n->eval_valid |= bit;
+	return true;
+}
+
+static unsigned
+node_delay(struct ir3_sched_ctx *ctx, struct ir3_sched_node *n)
+{
+	if (sched_node_eval(ctx, n, SCHED_EVAL_DELAY))
+		n->eval_delay = ir3_delay_calc(ctx->block, n->instr, false, false);
+	return n->eval_delay;
+}
+
+static int
+node_live_effect(struct ir3_sched_ctx *ctx, struct ir3_sched_node *n)
+{
+	if (sched_node_eval(ctx, n, SCHED_EVAL_LIVE_EFFECT))
+		n->eval_live_effect = live_effect(n->instr);
+	return n->eval_live_effect;
+}
+
+static int
+node_nearest_use(struct ir3_sched_ctx *ctx, struct ir3_sched_node *n)
+{
+	if (sched_node_eval(ctx, n, SCHED_EVAL_NEAREST_USE))
+		n->eval_nearest_use = nearest_use(n->instr);
+	return n->eval_nearest_use;
+}
+
+static bool
+node_would_sync(struct ir3_sched_ctx *ctx, struct ir3_sched_node *n)
+{
+	if (sched_node_eval(ctx, n, SCHED_EVAL_WOULD_SYNC))
+		n->eval_would_sync = would_sync(ctx, n->instr);
+	return n->eval_would_sync;
+}
+
+/* Note that the notes are only filled in the first time a node is checked,
+ * which is fine since they are only used when no node passes the check, in
+ * which case they have all been checked with the same notes.
+ */
+static bool
+node_check(struct ir3_sched_ctx *ctx, struct ir3_sched_notes *notes,
+		struct ir3_sched_node *n)
+{
+	if (sched_node_eval(ctx, n, SCHED_EVAL_CHECK))
+		n->eval_check = check_instr(ctx, notes, n->instr);
+	return n->eval_check;
+}
+
 static struct ir3_sched_node *
 choose_instr_inc(struct ir3_sched_ctx *ctx, struct ir3_sched_notes *notes,
 		bool avoid_sync, bool avoid_output);
@@ -480,18 +569,18 @@ choose_instr_dec(struct ir3_sched_ctx *ctx, struct ir3_sched_notes *notes,
 
 	/* Find a ready inst with regs freed and pick the one with max cost. */
 	foreach_sched_node (n, &ctx->dag->heads) {
-		if (avoid_sync && would_sync(ctx, n->instr))
+		if (avoid_sync && node_would_sync(ctx, n))
 			continue;
 
-		unsigned d = ir3_delay_calc(ctx->block, n->instr, false, false);
+		unsigned d = node_delay(ctx, n);
 
 		if (d > 0)
 			continue;
 
-		if (live_effect(n->instr) > -1)
+		if (node_live_effect(ctx, n) > -1)
 			continue;
 
-		if (!check_instr(ctx, notes, n->instr))
+		if (!node_check(ctx, notes, n))
 			continue;
 
 		if (!chosen || chosen->max_delay < n->max_delay) {
@@ -506,13 +595,13 @@ choose_instr_dec(struct ir3_sched_ctx *ctx, struct ir3_sched_notes *notes,
 
 	/* Find a leader with regs freed and pick the one with max cost. */
 	foreach_sched_node (n, &ctx->dag->heads) {
-		if (avoid_sync && would_sync(ctx, n->instr))
+		if (avoid_sync && node_would_sync(ctx, n))
 			continue;
 
-		if (live_effect(n->instr) > -1)
+		if (node_live_effect(ctx, n) > -1)
 			continue;
 
-		if (!check_instr(ctx, notes, n->instr))
+		if (!node_check(ctx, notes, n))
 			continue;
 
 		if (!chosen || chosen->max_delay < n->max_delay) {
@@ -533,18 +622,18 @@ choose_instr_dec(struct ir3_sched_ctx *ctx, struct ir3_sched_notes *notes,
 	 * XXX: Should this prioritize ready?
 	 */
 	foreach_sched_node (n, &ctx->dag->heads) {
-		if (avoid_sync && would_sync(ctx, n->instr))
+		if (avoid_sync && node_would_sync(ctx, n))
 			continue;
 
-		unsigned d = ir3_delay_calc(ctx->block, n->instr, false, false);
+		unsigned d = node_delay(ctx, n);
 
 		if (d > 0)
 			continue;
 
-		if (live_effect(n->instr) > 0)
+		if (node_live_effect(ctx, n) > 0)
 			continue;
 
-		if (!check_instr(ctx, notes, n->instr))
+		if (!node_check(ctx, notes, n))
 			continue;
 
 		if (!chosen || chosen->max_delay < n->max_delay)
@@ -557,13 +646,13 @@ choose_instr_dec(struct ir3_sched_ctx *ctx, struct ir3_sched_notes *notes,
 	}
 
 	foreach_sched_node (n, &ctx->dag->heads) {
-		if (avoid_sync && would_sync(ctx, n->instr))
+		if (avoid_sync && node_would_sync(ctx, n))
 			continue;
 
-		if (live_effect(n->instr) > 0)
+		if (node_live_effect(ctx, n) > 0)
 			continue;
 
-		if (!check_instr(ctx, notes, n->instr))
+		if (!node_check(ctx, notes, n))
 			continue;
 
 		if (!chosen || chosen->max_delay < n->max_delay)
@@ -601,18 +690,18 @@ choose_instr_inc(struct ir3_sched_ctx *ctx, struct ir3_sched_notes *notes,
 		if (avoid_output && n->output)
 			continue;
 
-		if (avoid_sync && would_sync(ctx, n->instr))
+		if (avoid_sync && node_would_sync(ctx, n))
 			continue;
 
-		unsigned d = ir3_delay_calc(ctx->block, n->instr, false, false);
+		unsigned d = node_delay(ctx, n);
 
 		if (d > 0)
 			continue;
 
-		if (!check_instr(ctx, notes, n->instr))
+		if (!node_check(ctx, notes, n))
 			continue;
 
-		unsigned distance = nearest_use(n->instr);
+		unsigned distance = node_nearest_use(ctx, n);
 
 		if (!chosen || distance < chosen_distance) {
 			chosen = n;
@@ -630,13 +719,13 @@ choose_instr_inc(struct ir3_sched_ctx *ctx, struct ir3_sched_notes *notes,
 		if (avoid_output && n->output)
 			continue;
 
-		if (avoid_sync && would_sync(ctx, n->instr))
+		if (avoid_sync && node_would_sync(ctx, n))
 			continue;
 
-		if (!check_instr(ctx, notes, n->instr))
+		if (!node_check(ctx, notes, n))
 			continue;
 
-		unsigned distance = nearest_use(n->instr);
+		unsigned distance = node_nearest_use(ctx, n);
 
 		if (!chosen || distance < chosen_distance) {
 			chosen = n;
@@ -701,6 +790,8 @@ choose_instr(struct ir3_sched_ctx *ctx, struct ir3_sched_notes *notes)
 {
 	struct ir3_sched_node *chosen;
 
+	ctx->eval_serial++;
+
 	dump_state(ctx);
 
 	chosen = choose_instr_prio(ctx, notes);
@@ -1023,7 +1114,7 @@ sched_block(struct ir3_sched_ctx *ctx, struct ir3_block *block)
 
 		instr = choose_instr(ctx, &notes);
 		if (instr) {
-			unsigned delay = ir3_delay_calc(ctx->block, instr, false, false);
+			unsigned delay = node_delay(ctx, instr->data);
 			d("delay=%u", delay);
 
 			/* and if we run out of instructions that can be scheduled,
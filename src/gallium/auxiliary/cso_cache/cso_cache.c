@@ -31,6 +31,8 @@
 #include "util/u_debug.h"
 
 #include "util/u_memory.h"
+#define XXH_INLINE_ALL
+#include "util/xxhash.h"
 
 #include "cso_cache.h"
 #include "cso_hash.h"
@@ -44,36 +46,13 @@ struct cso_cache {
    void                 *sanitize_data;
 };
 
-#if 1
 static unsigned hash_key(const void *key, unsigned key_size)
 {
-   unsigned *ikey = (unsigned *)key;
-   unsigned hash = 0, i;
-
-   assert(key_size % 4 == 0);
-
-   /* I'm sure this can be improved on:
+   /* XOR-ing the words together made most states with a couple of flags
+    * flipped collide, which turned lookups into long memcmp chains.
     */
-   for (i = 0; i < key_size/4; i++)
-      hash ^= ikey[i];
-
-   return hash;
-}
-#else
-static unsigned hash_key(const unsigned char *p, int n)
-{
-   unsigned h = 0;
-   unsigned g;
-
-   while (n--) {
-      h = (h << 4) + *p++;
-      if ((g = (h & 0xf0000000)) != 0)
-         h ^= g >> 23;
-      h &= ~g;
-   }
-   return h;
+   return XXH32(key, key_size, 0);
 }
-#endif
 
 unsigned cso_construct_key(void *item, int item_size)
 {
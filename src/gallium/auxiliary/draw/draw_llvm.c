@@ -54,6 +54,7 @@
 #include "gallivm/lp_bld_misc.h"
 #include "tgsi/tgsi_exec.h"
 #include "tgsi/tgsi_dump.h"
+#include "tgsi/tgsi_parse.h"
 
 #include "util/u_math.h"
 #include "util/u_pointer.h"
@@ -824,7 +825,7 @@ draw_llvm_destroy(struct draw_llvm *llvm)
 }
 
 static void
-draw_get_ir_cache_key(struct nir_shader *nir,
+draw_get_ir_cache_key(const struct pipe_shader_state *state,
                       const void *key, size_t key_size,
                       uint32_t val_32bit,
                       unsigned char ir_sha1_cache_key[20])
@@ -833,10 +834,15 @@ draw_get_ir_cache_key(struct nir_shader *nir,
    unsigned ir_size;
    void *ir_binary;
 
-   blob_init(&blob);
-   nir_serialize(&blob, nir, true);
-   ir_binary = blob.data;
-   ir_size = blob.size;
+   if (state->type == PIPE_SHADER_IR_TGSI) {
+      ir_binary = (void *)state->tokens;
+      ir_size = tgsi_num_tokens(state->tokens) * sizeof(struct tgsi_token);
+   } else {
+      blob_init(&blob);
+      nir_serialize(&blob, state->ir.nir, true);
+      ir_binary = blob.data;
+      ir_size = blob.size;
+   }
 
    struct mesa_sha1 ctx;
    _mesa_sha1_init(&ctx);
@@ -877,8 +883,9 @@ draw_llvm_create_variant(struct draw_llvm *llvm,
    snprintf(module_name, sizeof(module_name), "draw_llvm_vs_variant%u",
             variant->shader->variants_cached);
 
-   if (shader->base.state.ir.nir && llvm->draw->disk_cache_cookie) {
-      draw_get_ir_cache_key(shader->base.state.ir.nir,
+   if ((shader->base.state.ir.nir || shader->base.state.tokens) &&
+       llvm->draw->disk_cache_cookie) {
+      draw_get_ir_cache_key(&shader->base.state,
                             key,
                             shader->variant_key_size,
                             num_inputs,
@@ -2911,8 +2918,9 @@ draw_gs_llvm_create_variant(struct draw_llvm *llvm,
 
    memcpy(&variant->key, key, shader->variant_key_size);
 
-   if (shader->base.state.ir.nir && llvm->draw->disk_cache_cookie) {
-      draw_get_ir_cache_key(shader->base.state.ir.nir,
+   if ((shader->base.state.ir.nir || shader->base.state.tokens) &&
+       llvm->draw->disk_cache_cookie) {
+      draw_get_ir_cache_key(&shader->base.state,
                             key,
                             shader->variant_key_size,
                             num_outputs,
@@ -3540,7 +3548,7 @@ draw_tcs_llvm_create_variant(struct draw_llvm *llvm,
    memcpy(&variant->key, key, shader->variant_key_size);
 
    if (shader->base.state.ir.nir && llvm->draw->disk_cache_cookie) {
-      draw_get_ir_cache_key(shader->base.state.ir.nir,
+      draw_get_ir_cache_key(&shader->base.state,
                             key,
                             shader->variant_key_size,
                             num_outputs,
@@ -4038,7 +4046,7 @@ draw_tes_llvm_create_variant(struct draw_llvm *llvm,
 
    memcpy(&variant->key, key, shader->variant_key_size);
    if (shader->base.state.ir.nir && llvm->draw->disk_cache_cookie) {
-      draw_get_ir_cache_key(shader->base.state.ir.nir,
+      draw_get_ir_cache_key(&shader->base.state,
                             key,
                             shader->variant_key_size,
                             num_outputs,
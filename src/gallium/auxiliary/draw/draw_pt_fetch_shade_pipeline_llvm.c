@@ -28,6 +28,8 @@
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_prim.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_queue.h"
 #include "draw/draw_context.h"
 #include "draw/draw_gs.h"
 #include "draw/draw_tess.h"
@@ -41,6 +43,28 @@
 #include "gallivm/lp_bld_debug.h"
 
 
+/* Fetch+VS runs on up to this many threads, including the calling one. */
+#define LLVM_VS_MAX_THREADS 8
+
+/* Chunks smaller than this aren't worth handing to other threads. */
+#define LLVM_VS_MIN_VERTS_PER_JOB 256
+
+DEBUG_GET_ONCE_NUM_OPTION(draw_vs_threads, "DRAW_VS_THREADS", 0)
+
+struct llvm_middle_end;
+
+struct llvm_vs_job {
+   struct llvm_middle_end *fpme;
+   struct util_queue_fence fence;
+
+   struct vertex_header *verts;
+   unsigned count;
+   unsigned start_or_maxelt;
+   unsigned vid_base;
+   const unsigned *elts;
+   boolean clipped;
+};
+
 struct llvm_middle_end {
    struct draw_pt_middle_end base;
    struct draw_context *draw;
@@ -58,6 +82,11 @@ struct llvm_middle_end {
 
    struct draw_llvm *llvm;
    struct draw_llvm_variant *current_variant;
+
+   /* Threads running fetch+VS on parts of large vertex chunks. */
+   struct util_queue vs_queue;
+   unsigned num_vs_threads; /* 0 if disabled */
+   struct llvm_vs_job vs_jobs[LLVM_VS_MAX_THREADS];
 };
 
 
@@ -560,6 +589,112 @@ emit(struct pt_emit *emit,
 }
 
 
+static void
+llvm_vs_job_run(struct llvm_vs_job *job)
+{
+   struct llvm_middle_end *fpme = job->fpme;
+   struct draw_context *draw = fpme->draw;
+
+   job->clipped = fpme->current_variant->jit_func(&fpme->llvm->jit_context,
+                                                  job->verts,
+                                                  draw->pt.user.vbuffer,
+                                                  job->count,
+                                                  job->start_or_maxelt,
+                                                  fpme->vertex_size,
+                                                  draw->pt.vertex_buffer,
+                                                  draw->instance_id,
+                                                  job->vid_base,
+                                                  draw->start_instance,
+                                                  job->elts,
+                                                  draw->pt.user.drawid);
+}
+
+
+static void
+llvm_vs_job_execute(void *data, UNUSED int thread_index)
+{
+   llvm_vs_job_run((struct llvm_vs_job *)data);
+}
+
+
+/**
+ * Run fetch+VS on a chunk of vertices, splitting it across the VS threads
+ * if it is large enough. Everything after the VS still runs on the calling
+ * thread in the original order, so primitives reach the rasterizer
+ * unchanged.
+ */
+static boolean
+llvm_vs_run(struct llvm_middle_end *fpme, struct vertex_header *verts,
+            unsigned count, unsigned start_or_maxelt, unsigned vid_base,
+            const unsigned *elts)
+{
+   const unsigned vector_length = lp_native_vector_width / 32;
+   unsigned num_jobs = MIN2(fpme->num_vs_threads + 1,
+                            count / LLVM_VS_MIN_VERTS_PER_JOB);
+   unsigned verts_per_job, first = 0;
+   boolean clipped = FALSE;
+
+   if (num_jobs <= 1) {
+      struct llvm_vs_job job = {
+         .fpme = fpme,
+         .verts = verts,
+         .count = count,
+         .start_or_maxelt = start_or_maxelt,
+         .vid_base = vid_base,
+         .elts = elts,
+      };
+
+      llvm_vs_job_run(&job);
+      return job.clipped;
+   }
+
+   /* The shader writes whole vectors of vertices, so jobs must start on a
+    * vector boundary not to overwrite each other's outputs.
+    */
+   verts_per_job = align(DIV_ROUND_UP(count, num_jobs), vector_length);
+
+   for (unsigned i = 0; i < num_jobs; i++) {
+      struct llvm_vs_job *job = &fpme->vs_jobs[i];
+
+      job->fpme = fpme;
+      job->verts = (struct vertex_header *)
+         ((char *)verts + first * fpme->vertex_size);
+      job->count = MIN2(verts_per_job, count - first);
+      job->vid_base = vid_base;
+      if (elts) {
+         job->start_or_maxelt = start_or_maxelt;
+         job->elts = elts + first;
+      } else {
+         job->start_or_maxelt = start_or_maxelt + first;
+         job->elts = NULL;
+      }
+
+      first += job->count;
+      if (first == count) {
+         num_jobs = i + 1;
+         break;
+      }
+   }
+
+   /* The last part runs on this thread. */
+   for (unsigned i = 0; i < num_jobs - 1; i++) {
+      util_queue_add_job(&fpme->vs_queue, &fpme->vs_jobs[i],
+                         &fpme->vs_jobs[i].fence, llvm_vs_job_execute,
+                         NULL, 0);
+   }
+
+   llvm_vs_job_run(&fpme->vs_jobs[num_jobs - 1]);
+
+   for (unsigned i = 0; i < num_jobs; i++) {
+      if (i < num_jobs - 1)
+         util_queue_fence_wait(&fpme->vs_jobs[i].fence);
+      clipped |= fpme->vs_jobs[i].clipped;
+   }
+
+   return clipped;
+}
+
+
 static void
 llvm_pipeline_generic(struct draw_pt_middle_end *middle,
                       const struct draw_fetch_info *fetch_info,
@@ -621,17 +756,8 @@ llvm_pipeline_generic(struct draw_pt_middle_end *middle,
       vid_base = draw->pt.user.eltBias;
       elts = fetch_info->elts;
    }
-   clipped = fpme->current_variant->jit_func(&fpme->llvm->jit_context,
-                                             llvm_vert_info.verts,
-                                             draw->pt.user.vbuffer,
-                                             fetch_info->count,
-                                             start_or_maxelt,
-                                             fpme->vertex_size,
-                                             draw->pt.vertex_buffer,
-                                             draw->instance_id,
-                                             vid_base,
-                                             draw->start_instance,
-                                             elts, draw->pt.user.drawid);
+   clipped = llvm_vs_run(fpme, llvm_vert_info.verts, fetch_info->count,
+                         start_or_maxelt, vid_base, elts);
 
    /* Finished with fetch and vs:
     */
@@ -900,6 +1026,12 @@ llvm_middle_end_destroy(struct draw_pt_middle_end *middle)
    if (fpme->post_vs)
       draw_pt_post_vs_destroy( fpme->post_vs );
 
+   if (fpme->num_vs_threads) {
+      util_queue_destroy(&fpme->vs_queue);
+      for (unsigned i = 0; i < ARRAY_SIZE(fpme->vs_jobs); i++)
+         util_queue_fence_destroy(&fpme->vs_jobs[i].fence);
+   }
+
    FREE(middle);
 }
 
@@ -948,6 +1080,25 @@ draw_pt_fetch_pipeline_or_emit_llvm(struct draw_context *draw)
 
    fpme->current_variant = NULL;
 
+   /* DRAW_VS_THREADS is the number of extra threads; -1 means one per
+    * additional CPU.
+    */
+   {
+      long num_threads = debug_get_option_draw_vs_threads();
+
+      if (num_threads < 0)
+         num_threads = util_cpu_caps.nr_cpus - 1;
+      num_threads = MIN2(num_threads, LLVM_VS_MAX_THREADS - 1);
+
+      if (num_threads > 0 &&
+          util_queue_init(&fpme->vs_queue, "draw_vs", LLVM_VS_MAX_THREADS,
+                          num_threads, 0)) {
+         fpme->num_vs_threads = num_threads;
+         for (unsigned i = 0; i < ARRAY_SIZE(fpme->vs_jobs); i++)
+            util_queue_fence_init(&fpme->vs_jobs[i].fence);
+      }
+   }
+
    return &fpme->base;
 
  fail:
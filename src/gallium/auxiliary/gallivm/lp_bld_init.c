@@ -248,6 +248,10 @@ gallivm_free_code(struct gallivm_state *gallivm)
 {
    assert(!gallivm->module);
    assert(!gallivm->engine);
+#if GALLIVM_USE_ORCJIT
+   lp_orc_destroy_dylib(gallivm->dylib);
+   gallivm->dylib = NULL;
+#endif
    lp_free_generated_code(gallivm->code);
    gallivm->code = NULL;
    lp_free_memory_manager(gallivm->memorymgr);
@@ -270,6 +274,17 @@ init_gallivm_engine(struct gallivm_state *gallivm)
          optlevel = Default;
       }
 
+#if GALLIVM_USE_ORCJIT
+      /* The optimization level is the same for all modules, and set when
+       * the shared ORC JIT is created.
+       */
+      (void) optlevel;
+      ret = lp_orc_compile_module(&gallivm->dylib,
+                                  gallivm->module_name,
+                                  gallivm->cache,
+                                  gallivm->module,
+                                  &error);
+#else
       ret = lp_build_create_jit_compiler_for_module(&gallivm->engine,
                                                     &gallivm->code,
                                                     gallivm->cache,
@@ -277,6 +292,7 @@ init_gallivm_engine(struct gallivm_state *gallivm)
                                                     gallivm->memorymgr,
                                                     (unsigned) optlevel,
                                                     &error);
+#endif
       if (ret) {
          _debug_printf("%s\n", error);
          LLVMDisposeMessage(error);
@@ -284,6 +300,7 @@ init_gallivm_engine(struct gallivm_state *gallivm)
       }
    }
 
+#if !GALLIVM_USE_ORCJIT
    if (0) {
        /*
         * Dump the data layout strings.
@@ -304,6 +321,7 @@ init_gallivm_engine(struct gallivm_state *gallivm)
        free(data_layout);
        free(engine_data_layout);
    }
+#endif
 
    return TRUE;
 
@@ -349,9 +367,11 @@ init_gallivm_state(struct gallivm_state *gallivm, const char *name,
    if (!gallivm->builder)
       goto fail;
 
+#if !GALLIVM_USE_ORCJIT
    gallivm->memorymgr = lp_get_default_memory_manager();
    if (!gallivm->memorymgr)
       goto fail;
+#endif
 
    /* FIXME: MC-JIT only allows compiling one module at a time, and it must be
     * complete when MC-JIT is created. So defer the MC-JIT engine creation for
@@ -653,13 +673,21 @@ gallivm_compile_module(struct gallivm_state *gallivm)
    if (!init_gallivm_engine(gallivm)) {
       assert(0);
    }
+#if GALLIVM_USE_ORCJIT
+   assert(gallivm->dylib);
+#else
    assert(gallivm->engine);
+#endif
 
    ++gallivm->compiled;
 
    if (gallivm->debug_printf_hook)
-      LLVMAddGlobalMapping(gallivm->engine, gallivm->debug_printf_hook, debug_printf);
+      gallivm_add_global_mapping(gallivm, gallivm->debug_printf_hook, debug_printf);
 
+#if !GALLIVM_USE_ORCJIT
+   /* With ORC the code is only linked on the first lookup, once the caller
+    * added its global mappings, so this is done in gallivm_jit_function().
+    */
    if (gallivm_debug & GALLIVM_DEBUG_ASM) {
       LLVMValueRef llvm_func = LLVMGetFirstFunction(gallivm->module);
 
@@ -690,6 +718,7 @@ gallivm_compile_module(struct gallivm_state *gallivm)
       }
    }
 #endif
+#endif /* !GALLIVM_USE_ORCJIT */
 }
 
 
@@ -703,13 +732,25 @@ gallivm_jit_function(struct gallivm_state *gallivm,
    int64_t time_begin = 0;
 
    assert(gallivm->compiled);
-   assert(gallivm->engine);
 
    if (gallivm_debug & GALLIVM_DEBUG_PERF)
       time_begin = os_time_get();
 
+#if GALLIVM_USE_ORCJIT
+   assert(gallivm->dylib);
+   code = lp_orc_lookup(gallivm->dylib, LLVMGetValueName(func));
+   assert(code);
+
+   if (gallivm_debug & GALLIVM_DEBUG_ASM)
+      lp_disassemble(func, code);
+#if defined(PROFILE)
+   lp_profile(func, code);
+#endif
+#else
+   assert(gallivm->engine);
    code = LLVMGetPointerToGlobal(gallivm->engine, func);
    assert(code);
+#endif
    jit_func = pointer_to_func(code);
 
    if (gallivm_debug & GALLIVM_DEBUG_PERF) {
@@ -722,6 +763,23 @@ gallivm_jit_function(struct gallivm_state *gallivm,
    return jit_func;
 }
 
+/**
+ * Make calls to the \p global function declaration in the compiled code
+ * go to \p addr.  To be done after gallivm_compile_module() and before
+ * gallivm_jit_function().
+ */
+void
+gallivm_add_global_mapping(struct gallivm_state *gallivm,
+                           LLVMValueRef global, void *addr)
+{
+   assert(gallivm->compiled);
+#if GALLIVM_USE_ORCJIT
+   lp_orc_add_symbol(gallivm->dylib, LLVMGetValueName(global), addr);
+#else
+   LLVMAddGlobalMapping(gallivm->engine, global, addr);
+#endif
+}
+
 unsigned gallivm_get_perf_flags(void)
 {
    return gallivm_perf;
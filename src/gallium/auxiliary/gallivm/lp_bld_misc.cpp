@@ -77,6 +77,13 @@
 #include <llvm/ExecutionEngine/JITEventListener.h>
 #endif
 
+#if GALLIVM_USE_ORCJIT
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#endif
+
 #if LLVM_VERSION_MAJOR < 7
 // Workaround http://llvm.org/PR23628
 #pragma pop_macro("DEBUG")
@@ -85,6 +92,7 @@
 #include "c11/threads.h"
 #include "os/os_thread.h"
 #include "pipe/p_config.h"
+#include "util/u_atomic.h"
 #include "util/u_debug.h"
 #include "util/u_cpu_detect.h"
 
@@ -321,61 +329,48 @@ public:
 };
 
 /**
- * Same as LLVMCreateJITCompilerForModule, but:
- * - allows using MCJIT and enabling AVX feature where available.
- * - set target options
- *
- * See also:
- * - llvm/lib/ExecutionEngine/ExecutionEngineBindings.cpp
- * - llvm/tools/lli/lli.cpp
- * - http://markmail.org/message/ttkuhvgj4cxxy2on#query:+page:1+mid:aju2dggerju3ivd3+state:results
+ * The cpu MCJIT generates code for.
  */
-extern "C"
-LLVMBool
-lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
-                                        lp_generated_code **OutCode,
-                                        struct lp_cached_code *cache_out,
-                                        LLVMModuleRef M,
-                                        LLVMMCJITMemoryManagerRef CMM,
-                                        unsigned OptLevel,
-                                        char **OutError)
+static llvm::StringRef
+lp_get_mcpu(void)
 {
-   using namespace llvm;
-
-   std::string Error;
-   EngineBuilder builder(std::unique_ptr<Module>(unwrap(M)));
-
-   /**
-    * LLVM 3.1+ haven't more "extern unsigned llvm::StackAlignmentOverride" and
-    * friends for configuring code generation options, like stack alignment.
+   llvm::StringRef MCPU = llvm::sys::getHostCPUName();
+   /*
+    * The cpu bits are no longer set automatically, so need to set mcpu manually.
+    * Note that the MAttrs set by lp_build_create_jit_compiler_for_module()
+    * will be sort of ignored (since we should not set any which would not
+    * be set by specifying the cpu anyway).
+    * It ought to be safe though since getHostCPUName() should include bits
+    * not only from the cpu but environment as well (for instance if it's safe
+    * to use avx instructions which need OS support). According to
+    * http://llvm.org/bugs/show_bug.cgi?id=19429 however if I understand this
+    * right it may be necessary to specify older cpu (or disable mattrs) though
+    * when not using MCJIT so no instructions are generated which the old JIT
+    * can't handle. Not entirely sure if we really need to do anything yet.
     */
-   TargetOptions options;
-#if defined(PIPE_ARCH_X86)
-   options.StackAlignmentOverride = 4;
-#endif
-
-   builder.setEngineKind(EngineKind::JIT)
-          .setErrorStr(&Error)
-          .setTargetOptions(options)
-          .setOptLevel((CodeGenOpt::Level)OptLevel);
 
-#ifdef _WIN32
-    /*
-     * MCJIT works on Windows, but currently only through ELF object format.
-     *
-     * XXX: We could use `LLVM_HOST_TRIPLE "-elf"` but LLVM_HOST_TRIPLE has
-     * different strings for MinGW/MSVC, so better play it safe and be
-     * explicit.
-     */
-#  ifdef _WIN64
-    LLVMSetTarget(M, "x86_64-pc-win32-elf");
-#  else
-    LLVMSetTarget(M, "i686-pc-win32-elf");
-#  endif
+#if defined(PIPE_ARCH_PPC_64) && UTIL_ARCH_LITTLE_ENDIAN
+   /*
+    * Versions of LLVM prior to 4.0 lacked a table entry for "POWER8NVL",
+    * resulting in (big-endian) "generic" being returned on
+    * little-endian Power8NVL systems.  The result was that code that
+    * attempted to load the least significant 32 bits of a 64-bit quantity
+    * from memory loaded the wrong half.  This resulted in failures in some
+    * Piglit tests, e.g.
+    * .../arb_gpu_shader_fp64/execution/conversion/frag-conversion-explicit-double-uint
+    */
+   if (MCPU == "generic")
+      MCPU = "pwr8";
 #endif
+   return MCPU;
+}
 
-   llvm::SmallVector<std::string, 16> MAttrs;
-
+/**
+ * The cpu features MCJIT generates code for, as llc -mattr options.
+ */
+static void
+lp_get_mattrs(llvm::SmallVector<std::string, 16> &MAttrs)
+{
 #if LLVM_VERSION_MAJOR >= 4 && (defined(PIPE_ARCH_X86) || defined(PIPE_ARCH_X86_64) || defined(PIPE_ARCH_ARM))
    /* llvm-3.3+ implements sys::getHostCPUFeatures for Arm
     * and llvm-3.7+ for x86, which allows us to enable/disable
@@ -385,7 +380,7 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
    llvm::StringMap<bool> features;
    llvm::sys::getHostCPUFeatures(features);
 
-   for (StringMapIterator<bool> f = features.begin();
+   for (llvm::StringMapIterator<bool> f = features.begin();
         f != features.end();
         ++f) {
       MAttrs.push_back(((*f).second ? "+" : "-") + (*f).first().str());
@@ -464,8 +459,6 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
 #endif
 #endif
 
-   builder.setMAttrs(MAttrs);
-
    if (gallivm_debug & (GALLIVM_DEBUG_IR | GALLIVM_DEBUG_ASM | GALLIVM_DEBUG_DUMP_BC)) {
       int n = MAttrs.size();
       if (n > 0) {
@@ -475,20 +468,66 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
          debug_printf("\n");
       }
    }
+}
 
-   StringRef MCPU = llvm::sys::getHostCPUName();
-   /*
-    * The cpu bits are no longer set automatically, so need to set mcpu manually.
-    * Note that the MAttrs set above will be sort of ignored (since we should
-    * not set any which would not be set by specifying the cpu anyway).
-    * It ought to be safe though since getHostCPUName() should include bits
-    * not only from the cpu but environment as well (for instance if it's safe
-    * to use avx instructions which need OS support). According to
-    * http://llvm.org/bugs/show_bug.cgi?id=19429 however if I understand this
-    * right it may be necessary to specify older cpu (or disable mattrs) though
-    * when not using MCJIT so no instructions are generated which the old JIT
-    * can't handle. Not entirely sure if we really need to do anything yet.
+
+/**
+ * Same as LLVMCreateJITCompilerForModule, but:
+ * - allows using MCJIT and enabling AVX feature where available.
+ * - set target options
+ *
+ * See also:
+ * - llvm/lib/ExecutionEngine/ExecutionEngineBindings.cpp
+ * - llvm/tools/lli/lli.cpp
+ * - http://markmail.org/message/ttkuhvgj4cxxy2on#query:+page:1+mid:aju2dggerju3ivd3+state:results
+ */
+extern "C"
+LLVMBool
+lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
+                                        lp_generated_code **OutCode,
+                                        struct lp_cached_code *cache_out,
+                                        LLVMModuleRef M,
+                                        LLVMMCJITMemoryManagerRef CMM,
+                                        unsigned OptLevel,
+                                        char **OutError)
+{
+   using namespace llvm;
+
+   std::string Error;
+   EngineBuilder builder(std::unique_ptr<Module>(unwrap(M)));
+
+   /**
+    * LLVM 3.1+ haven't more "extern unsigned llvm::StackAlignmentOverride" and
+    * friends for configuring code generation options, like stack alignment.
     */
+   TargetOptions options;
+#if defined(PIPE_ARCH_X86)
+   options.StackAlignmentOverride = 4;
+#endif
+
+   builder.setEngineKind(EngineKind::JIT)
+          .setErrorStr(&Error)
+          .setTargetOptions(options)
+          .setOptLevel((CodeGenOpt::Level)OptLevel);
+
+#ifdef _WIN32
+    /*
+     * MCJIT works on Windows, but currently only through ELF object format.
+     *
+     * XXX: We could use `LLVM_HOST_TRIPLE "-elf"` but LLVM_HOST_TRIPLE has
+     * different strings for MinGW/MSVC, so better play it safe and be
+     * explicit.
+     */
+#  ifdef _WIN64
+    LLVMSetTarget(M, "x86_64-pc-win32-elf");
+#  else
+    LLVMSetTarget(M, "i686-pc-win32-elf");
+#  endif
+#endif
+
+   llvm::SmallVector<std::string, 16> MAttrs;
+   lp_get_mattrs(MAttrs);
+   builder.setMAttrs(MAttrs);
 
 #ifdef PIPE_ARCH_PPC_64
    /*
@@ -501,21 +540,9 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
     * - change an add-immediate (addis) instruction to a load (ld).
     */
    builder.setCodeModel(CodeModel::Large);
-
-#if UTIL_ARCH_LITTLE_ENDIAN
-   /*
-    * Versions of LLVM prior to 4.0 lacked a table entry for "POWER8NVL",
-    * resulting in (big-endian) "generic" being returned on
-    * little-endian Power8NVL systems.  The result was that code that
-    * attempted to load the least significant 32 bits of a 64-bit quantity
-    * from memory loaded the wrong half.  This resulted in failures in some
-    * Piglit tests, e.g.
-    * .../arb_gpu_shader_fp64/execution/conversion/frag-conversion-explicit-double-uint
-    */
-   if (MCPU == "generic")
-      MCPU = "pwr8";
-#endif
 #endif
+
+   StringRef MCPU = lp_get_mcpu();
    builder.setMCPU(MCPU);
    if (gallivm_debug & (GALLIVM_DEBUG_IR | GALLIVM_DEBUG_ASM | GALLIVM_DEBUG_DUMP_BC)) {
       debug_printf("llc -mcpu option: %s\n", MCPU.str().c_str());
@@ -578,6 +605,18 @@ lp_free_memory_manager(LLVMMCJITMemoryManagerRef memorymgr)
    delete reinterpret_cast<BaseMemoryManager*>(memorymgr);
 }
 
+/**
+ * Copy the name of the cpu generated code is tuned for into \p name, for
+ * instance to tell apart machine code cached on disk by different hosts.
+ */
+extern "C" void
+lp_build_get_mcpu_name(char *name, size_t size)
+{
+   llvm::StringRef MCPU = lp_get_mcpu();
+
+   snprintf(name, size, "%.*s", (int)MCPU.size(), MCPU.data());
+}
+
 extern "C" void
 lp_free_objcache(void *objcache_ptr)
 {
@@ -585,6 +624,244 @@ lp_free_objcache(void *objcache_ptr)
    delete objcache;
 }
 
+#if GALLIVM_USE_ORCJIT
+
+namespace {
+
+/*
+ * A single LLJIT instance, and so a single execution session, symbol string
+ * pool and object linking layer for the whole process.  Each gallivm_state
+ * gets a JITDylib of its own in it, which is removed along with its code
+ * when the gallivm_state is destroyed.
+ */
+class LPJit {
+public:
+   static LPJit &get() {
+      static LPJit jit;
+      return jit;
+   }
+
+   llvm::orc::LLJIT *lljit() {
+      return JIT.get();
+   }
+
+   /*
+    * Target machines are expensive to create but not thread-safe, so keep
+    * one per compiling thread rather than one per module.
+    */
+   llvm::TargetMachine *targetMachine() {
+      static thread_local std::unique_ptr<llvm::TargetMachine> TM;
+
+      if (!TM) {
+         auto TMOrErr = JTMB.createTargetMachine();
+         if (!TMOrErr) {
+            llvm::consumeError(TMOrErr.takeError());
+            return NULL;
+         }
+         TM = std::move(*TMOrErr);
+      }
+      return TM.get();
+   }
+
+private:
+   LPJit() : JTMB(llvm::Triple(llvm::sys::getProcessTriple())) {
+      llvm::SmallVector<std::string, 16> MAttrs;
+      llvm::TargetOptions options;
+
+      lp_set_target_options();
+
+#if defined(PIPE_ARCH_X86)
+      options.StackAlignmentOverride = 4;
+#endif
+      lp_get_mattrs(MAttrs);
+
+      JTMB.setCPU(lp_get_mcpu().str());
+      JTMB.addFeatures(std::vector<std::string>(MAttrs.begin(), MAttrs.end()));
+      JTMB.setOptions(options);
+      JTMB.setCodeGenOptLevel((gallivm_perf & GALLIVM_PERF_NO_OPT) ?
+                              llvm::CodeGenOpt::None :
+                              llvm::CodeGenOpt::Default);
+#ifdef PIPE_ARCH_PPC_64
+      /* See lp_build_create_jit_compiler_for_module(). */
+      JTMB.setCodeModel(llvm::CodeModel::Large);
+#endif
+
+      auto JITOrErr = llvm::orc::LLJITBuilder()
+                         .setJITTargetMachineBuilder(JTMB)
+                         .create();
+      if (!JITOrErr) {
+         _debug_printf("gallivm: failed to create ORC JIT: %s\n",
+                       llvm::toString(JITOrErr.takeError()).c_str());
+         return;
+      }
+      JIT = std::move(*JITOrErr);
+
+      /* Resolve the libcalls (memcpy, sinf, ...) code may end up making. */
+      auto GenOrErr =
+         llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+            JIT->getDataLayout().getGlobalPrefix());
+      if (GenOrErr)
+         JIT->getMainJITDylib().addGenerator(std::move(*GenOrErr));
+      else
+         llvm::consumeError(GenOrErr.takeError());
+   }
+
+   llvm::orc::JITTargetMachineBuilder JTMB;
+   std::unique_ptr<llvm::orc::LLJIT> JIT;
+};
+
+}
+
+struct lp_orc_dylib {
+   llvm::orc::JITDylib *JD;
+};
+
+static char *
+lp_orc_error(llvm::Error err)
+{
+   return strdup(llvm::toString(std::move(err)).c_str());
+}
+
+/**
+ * ORC counterpart of lp_build_create_jit_compiler_for_module(): compile the
+ * module (or take the object from \p cache, if it has one) and put the code
+ * in a new JITDylib.  The module stays owned by the caller.
+ */
+extern "C" int
+lp_orc_compile_module(struct lp_orc_dylib **OutDylib,
+                      const char *name,
+                      struct lp_cached_code *cache,
+                      LLVMModuleRef M,
+                      char **OutError)
+{
+   static unsigned dylib_no = 0;
+   llvm::orc::LLJIT *J = LPJit::get().lljit();
+   std::unique_ptr<llvm::MemoryBuffer> obj;
+
+   if (!J) {
+      *OutError = strdup("no ORC JIT");
+      return 1;
+   }
+
+   /* JITDylib names must be unique within the session. */
+   std::string dylib_name = "gallivm_" +
+      std::to_string(p_atomic_inc_return(&dylib_no)) + "_" +
+      (name ? name : "");
+
+   auto JDOrErr = J->createJITDylib(dylib_name);
+   if (!JDOrErr) {
+      *OutError = lp_orc_error(JDOrErr.takeError());
+      return 1;
+   }
+   llvm::orc::JITDylib &JD = *JDOrErr;
+
+   if (cache && cache->data_size) {
+      obj = llvm::MemoryBuffer::getMemBufferCopy(
+         llvm::StringRef((const char *)cache->data, cache->data_size),
+         dylib_name);
+   } else {
+      llvm::TargetMachine *TM = LPJit::get().targetMachine();
+      llvm::Module *mod = llvm::unwrap(M);
+
+      if (!TM) {
+         llvm::consumeError(J->getExecutionSession().removeJITDylib(JD));
+         *OutError = strdup("no target machine");
+         return 1;
+      }
+
+      mod->setDataLayout(TM->createDataLayout());
+      mod->setTargetTriple(TM->getTargetTriple().str());
+
+      auto ObjOrErr = llvm::orc::SimpleCompiler(*TM)(*mod);
+      if (!ObjOrErr) {
+         llvm::consumeError(J->getExecutionSession().removeJITDylib(JD));
+         *OutError = lp_orc_error(ObjOrErr.takeError());
+         return 1;
+      }
+      obj = std::move(*ObjOrErr);
+
+      if (cache) {
+         cache->data_size = obj->getBufferSize();
+         cache->data = malloc(cache->data_size);
+         memcpy(cache->data, obj->getBufferStart(), cache->data_size);
+      }
+   }
+
+   if (llvm::Error err = J->addObjectFile(JD, std::move(obj))) {
+      llvm::consumeError(J->getExecutionSession().removeJITDylib(JD));
+      *OutError = lp_orc_error(std::move(err));
+      return 1;
+   }
+
+   *OutDylib = new lp_orc_dylib { &JD };
+   return 0;
+}
+
+/**
+ * Make \p name resolve to \p addr in the dylib's code, like
+ * LLVMAddGlobalMapping().  Must be done before the first lookup.
+ */
+extern "C" void
+lp_orc_add_symbol(struct lp_orc_dylib *dylib, const char *name, void *addr)
+{
+   llvm::orc::LLJIT *J = LPJit::get().lljit();
+   llvm::orc::SymbolMap symbols;
+
+#if LLVM_VERSION_MAJOR >= 17
+   symbols[J->mangleAndIntern(name)] =
+      llvm::orc::ExecutorSymbolDef(llvm::orc::ExecutorAddr::fromPtr(addr),
+                                   llvm::JITSymbolFlags::Exported |
+                                   llvm::JITSymbolFlags::Callable);
+#else
+   symbols[J->mangleAndIntern(name)] =
+      llvm::JITEvaluatedSymbol(llvm::pointerToJITTargetAddress(addr),
+                               llvm::JITSymbolFlags::Exported |
+                               llvm::JITSymbolFlags::Callable);
+#endif
+
+   if (llvm::Error err = dylib->JD->define(
+          llvm::orc::absoluteSymbols(std::move(symbols))))
+      llvm::consumeError(std::move(err));
+}
+
+/**
+ * Look a function up, linking the dylib's code on first use.
+ */
+extern "C" void *
+lp_orc_lookup(struct lp_orc_dylib *dylib, const char *name)
+{
+   auto SymOrErr = LPJit::get().lljit()->lookup(*dylib->JD, name);
+
+   if (!SymOrErr) {
+      _debug_printf("gallivm: %s\n",
+                    llvm::toString(SymOrErr.takeError()).c_str());
+      return NULL;
+   }
+#if LLVM_VERSION_MAJOR >= 15
+   return SymOrErr->toPtr<void *>();
+#else
+   return llvm::jitTargetAddressToPointer<void *>(SymOrErr->getAddress());
+#endif
+}
+
+/**
+ * Free all the code of a dylib.
+ */
+extern "C" void
+lp_orc_destroy_dylib(struct lp_orc_dylib *dylib)
+{
+   if (!dylib)
+      return;
+
+   llvm::orc::ExecutionSession &ES =
+      LPJit::get().lljit()->getExecutionSession();
+   if (llvm::Error err = ES.removeJITDylib(*dylib->JD))
+      llvm::consumeError(std::move(err));
+   delete dylib;
+}
+
+#endif /* GALLIVM_USE_ORCJIT */
+
 extern "C" LLVMValueRef
 lp_get_called_value(LLVMValueRef call)
 {
@@ -89,8 +89,31 @@ lp_get_called_value(LLVMValueRef call);
 extern bool
 lp_is_function(LLVMValueRef v);
 
+extern void
+lp_build_get_mcpu_name(char *name, size_t size);
+
 void
 lp_free_objcache(void *objcache);
+
+#if GALLIVM_USE_ORCJIT
+struct lp_orc_dylib;
+
+extern int
+lp_orc_compile_module(struct lp_orc_dylib **OutDylib,
+                      const char *name,
+                      struct lp_cached_code *cache,
+                      LLVMModuleRef M,
+                      char **OutError);
+
+extern void
+lp_orc_add_symbol(struct lp_orc_dylib *dylib, const char *name, void *addr);
+
+extern void *
+lp_orc_lookup(struct lp_orc_dylib *dylib, const char *name);
+
+extern void
+lp_orc_destroy_dylib(struct lp_orc_dylib *dylib);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -118,6 +118,9 @@ lp_sampler_static_texture_state(struct lp_static_texture_state *state,
    state->pot_height        = util_is_power_of_two_or_zero(texture->height0);
    state->pot_depth         = util_is_power_of_two_or_zero(texture->depth0);
    state->level_zero_only   = !view->u.tex.last_level;
+   state->width_gt1         = view->target != PIPE_BUFFER &&
+                              u_minify(texture->width0,
+                                       view->u.tex.first_level) > 1;
 
    /*
     * the layer / element / level parameters are all either dynamic
@@ -174,6 +174,7 @@ struct lp_static_texture_state
    unsigned pot_height:1;
    unsigned pot_depth:1;
    unsigned level_zero_only:1;
+   unsigned width_gt1:1;     /**< is the first level wider than 1 texel? */
 };
 
 
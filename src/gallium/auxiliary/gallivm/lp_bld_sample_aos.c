@@ -551,9 +551,97 @@ lp_build_sample_image_nearest(struct lp_build_sample_context *bld,
 }
 
 
+/**
+ * Whether bilinear filtering can fetch both texels of a row with a single
+ * 64-bit load, see lp_build_sample_fetch_texel_pair().
+ *
+ * This needs the row of the sampled level to be at least two texels wide,
+ * and clamp to edge, which unlike the other wrap modes never sends the
+ * right texel back to the start of the row.
+ */
+static boolean
+lp_build_sample_use_texel_pairs(const struct lp_build_sample_context *bld,
+                                const LLVMValueRef *offsets)
+{
+   const struct lp_static_texture_state *texture = bld->static_texture_state;
+   const struct lp_static_sampler_state *sampler = bld->static_sampler_state;
+
+   return util_format_is_rgba8_variant(bld->format_desc) &&
+          (texture->target == PIPE_TEXTURE_2D ||
+           texture->target == PIPE_TEXTURE_RECT) &&
+          texture->width_gt1 &&
+          (sampler->min_mip_filter == PIPE_TEX_MIPFILTER_NONE ||
+           texture->level_zero_only) &&
+          sampler->wrap_s == PIPE_TEX_WRAP_CLAMP_TO_EDGE &&
+          !sampler->force_nearest_s &&
+          !sampler->force_nearest_t &&
+          !offsets[0];
+}
+
+
+/**
+ * Fetch the left and right texels of bilinear filtering for rgba8 with
+ * one unaligned 64-bit load per pixel, the left texel having been clamped
+ * to [0, width - 2].  Where the clamp to edge wants the same texel twice,
+ * \p at_left or \p at_right is set and the texel at the edge is selected
+ * for both.
+ */
+static void
+lp_build_sample_fetch_texel_pair(struct lp_build_sample_context *bld,
+                                 LLVMValueRef data_ptr,
+                                 LLVMValueRef offset,
+                                 LLVMValueRef at_left,
+                                 LLVMValueRef at_right,
+                                 LLVMValueRef *left,
+                                 LLVMValueRef *right)
+{
+   struct gallivm_state *gallivm = bld->gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   struct lp_build_context *int_coord_bld = &bld->int_coord_bld;
+   const unsigned length = int_coord_bld->type.length;
+   LLVMTypeRef u8n_vec_type;
+   LLVMValueRef even[LP_MAX_VECTOR_LENGTH], odd[LP_MAX_VECTOR_LENGTH];
+   LLVMValueRef pairs, l, r;
+   unsigned i;
+
+   u8n_vec_type = lp_build_vec_type(gallivm, lp_type_unorm(8, bld->vector_width));
+
+   /*
+    * Gather the pixels as 2 x 32bit each:
+    *
+    *   rgba0l rgba0r rgba1l rgba1r rgba2l rgba2r rgba3l rgba3r
+    *
+    * and split them into the left and right texels.
+    */
+   pairs = lp_build_gather(gallivm, length, 64,
+                           lp_type_uint_vec(32, 64),
+                           FALSE, data_ptr, offset, TRUE);
+
+   for (i = 0; i < length; i++) {
+      even[i] = lp_build_const_int32(gallivm, 2 * i);
+      odd[i] = lp_build_const_int32(gallivm, 2 * i + 1);
+   }
+   l = LLVMBuildShuffleVector(builder, pairs, LLVMGetUndef(LLVMTypeOf(pairs)),
+                              LLVMConstVector(even, length), "");
+   r = LLVMBuildShuffleVector(builder, pairs, LLVMGetUndef(LLVMTypeOf(pairs)),
+                              LLVMConstVector(odd, length), "");
+   l = LLVMBuildBitCast(builder, l, int_coord_bld->vec_type, "");
+   r = LLVMBuildBitCast(builder, r, int_coord_bld->vec_type, "");
+
+   *left = lp_build_select(int_coord_bld, at_right, r, l);
+   *right = lp_build_select(int_coord_bld, at_left, l, r);
+
+   *left = LLVMBuildBitCast(builder, *left, u8n_vec_type, "");
+   *right = LLVMBuildBitCast(builder, *right, u8n_vec_type, "");
+}
+
+
 /**
  * Fetch texels for image with linear sampling.
  * Return filtered color as two vectors of 16-bit fixed point values.
+ *
+ * If \p at_left is set the texels are fetched in pairs, from the left
+ * texel offsets only, see lp_build_sample_fetch_texel_pair().
  */
 static void
 lp_build_sample_fetch_image_linear(struct lp_build_sample_context *bld,
@@ -564,6 +652,8 @@ lp_build_sample_fetch_image_linear(struct lp_build_sample_context *bld,
                                    LLVMValueRef s_fpart,
                                    LLVMValueRef t_fpart,
                                    LLVMValueRef r_fpart,
+                                   LLVMValueRef at_left,
+                                   LLVMValueRef at_right,
                                    LLVMValueRef *colors)
 {
    const unsigned dims = bld->dims;
@@ -648,6 +738,14 @@ lp_build_sample_fetch_image_linear(struct lp_build_sample_context *bld,
 
    for (k = 0; k < numk; k++) {
       for (j = 0; j < numj; j++) {
+         if (at_left) {
+            lp_build_sample_fetch_texel_pair(bld, data_ptr, offset[k][j][0],
+                                             at_left, at_right,
+                                             &neighbors[k][j][0],
+                                             &neighbors[k][j][1]);
+            continue;
+         }
+
          for (i = 0; i < 2; i++) {
             LLVMValueRef rgba8;
 
@@ -770,6 +868,7 @@ lp_build_sample_image_linear(struct lp_build_sample_context *bld,
    LLVMValueRef z_offset0, z_offset1;
    LLVMValueRef offset[2][2][2]; /* [z][y][x] */
    LLVMValueRef x_subcoord[2], y_subcoord[2], z_subcoord[2];
+   LLVMValueRef at_left = NULL, at_right = NULL;
    unsigned x, y, z;
 
    lp_build_context_init(&i32, bld->gallivm, lp_type_int_vec(32, bld->vector_width));
@@ -862,14 +961,34 @@ lp_build_sample_image_linear(struct lp_build_sample_context *bld,
    z_stride = img_stride_vec;
 
    /* do texcoord wrapping and compute texel offsets */
-   lp_build_sample_wrap_linear_int(bld,
-                                   bld->format_desc->block.width,
-                                   s_ipart, &s_fpart, s_float,
-                                   width_vec, x_stride, offsets[0],
-                                   bld->static_texture_state->pot_width,
-                                   bld->static_sampler_state->wrap_s,
-                                   &x_offset0, &x_offset1,
-                                   &x_subcoord[0], &x_subcoord[1]);
+   if (lp_build_sample_use_texel_pairs(bld, offsets)) {
+      struct lp_build_context *int_coord_bld = &bld->int_coord_bld;
+      LLVMValueRef width_minus_two;
+
+      width_minus_two = lp_build_sub(int_coord_bld, width_vec,
+                                     lp_build_const_int_vec(bld->gallivm,
+                                                            int_coord_bld->type,
+                                                            2));
+      at_left = lp_build_compare(bld->gallivm, int_coord_bld->type,
+                                 PIPE_FUNC_LESS, s_ipart, int_coord_bld->zero);
+      at_right = lp_build_compare(bld->gallivm, int_coord_bld->type,
+                                  PIPE_FUNC_GREATER, s_ipart, width_minus_two);
+      s_ipart = lp_build_clamp(int_coord_bld, s_ipart, int_coord_bld->zero,
+                               width_minus_two);
+      x_offset0 = lp_build_mul(int_coord_bld, s_ipart, x_stride);
+      x_offset1 = x_offset0;
+      x_subcoord[0] = x_subcoord[1] = int_coord_bld->zero;
+   }
+   else {
+      lp_build_sample_wrap_linear_int(bld,
+                                      bld->format_desc->block.width,
+                                      s_ipart, &s_fpart, s_float,
+                                      width_vec, x_stride, offsets[0],
+                                      bld->static_texture_state->pot_width,
+                                      bld->static_sampler_state->wrap_s,
+                                      &x_offset0, &x_offset1,
+                                      &x_subcoord[0], &x_subcoord[1]);
+   }
 
    /* add potential cube/array/mip offsets now as they are constant per pixel */
    if (has_layer_coord(bld->static_texture_state->target)) {
@@ -933,6 +1052,7 @@ lp_build_sample_image_linear(struct lp_build_sample_context *bld,
    lp_build_sample_fetch_image_linear(bld, data_ptr, offset,
                                       x_subcoord, y_subcoord,
                                       s_fpart, t_fpart, r_fpart,
+                                      at_left, at_right,
                                       colors);
 }
 
@@ -43,6 +43,7 @@
 #include "cso_cache/cso_context.h"
 #include "util/u_draw_quad.h"
 #include "util/format/u_format.h"
+#include "util/os_time.h"
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
@@ -465,7 +466,7 @@ hud_draw_results(struct hud_context *hud, struct pipe_resource *tex)
          { &hud->font_sampler_state };
    struct hud_pane *pane;
 
-   if (!huds_visible)
+   if (!huds_visible || !hud->vertices_ready)
       return;
 
    hud->fb_width = tex->width0;
@@ -631,42 +632,108 @@ hud_start_queries(struct hud_context *hud, struct pipe_context *pipe)
    }
 }
 
+/* Write the current value of every graph as one CSV record. */
+static void
+hud_export_record(struct hud_context *hud)
+{
+   struct hud_pane *pane;
+   struct hud_graph *gr;
+   FILE *fd = hud->export_fd;
+
+   if (!hud->export_values) {
+      /* The graphs are known by the first frame, write the header. */
+      const char **names;
+
+      hud->export_values = CALLOC(hud->num_graphs, sizeof(double));
+      names = CALLOC(hud->num_graphs, sizeof(*names));
+      if (!hud->export_values || !names) {
+         FREE(names);
+         fclose(hud->export_fd);
+         hud->export_fd = NULL;
+         return;
+      }
+
+      LIST_FOR_EACH_ENTRY(pane, &hud->pane_list, head) {
+         LIST_FOR_EACH_ENTRY(gr, &pane->graph_list, head) {
+            names[gr->export_index] = gr->name;
+         }
+      }
+
+      fprintf(fd, "frame,time_us");
+      for (unsigned i = 0; i < hud->num_graphs; i++)
+         fprintf(fd, ",%s", names[i]);
+      fprintf(fd, "\n");
+      FREE(names);
+
+      hud->export_start_time = os_time_get();
+   }
+
+   /* Panes can reorder their graphs, so go through the column indices. */
+   LIST_FOR_EACH_ENTRY(pane, &hud->pane_list, head) {
+      LIST_FOR_EACH_ENTRY(gr, &pane->graph_list, head) {
+         hud->export_values[gr->export_index] = gr->current_value;
+      }
+   }
+
+   fprintf(fd, "%" PRIu64 ",%" PRId64, hud->export_frame++,
+           os_time_get() - hud->export_start_time);
+   for (unsigned i = 0; i < hud->num_graphs; i++) {
+      double value = hud->export_values[i];
+
+      if (fabs(value - lround(value)) > FLT_EPSILON)
+         fprintf(fd, ",%f", value);
+      else
+         fprintf(fd, ",%" PRIu64, (uint64_t) lround(value));
+   }
+   fprintf(fd, "\n");
+}
+
 /* Stop queries, query results, and record vertices for charts. */
 static void
 hud_stop_queries(struct hud_context *hud, struct pipe_context *pipe)
 {
    struct hud_pane *pane;
    struct hud_graph *gr, *next;
+   /* Only sample the graphs if there is nothing to draw. */
+   bool draw = huds_visible && hud->cso;
 
-   /* prepare vertex buffers */
-   hud_prepare_vertices(hud, &hud->bg, 16 * 256, 2 * sizeof(float));
-   hud_prepare_vertices(hud, &hud->whitelines, 4 * 256, 2 * sizeof(float));
-   hud_prepare_vertices(hud, &hud->text, 16 * 1024, 4 * sizeof(float));
+   hud->vertices_ready = false;
 
-   /* Allocate everything once and divide the storage into 3 portions
-    * manually, because u_upload_alloc can unmap memory from previous calls.
-    */
-   u_upload_alloc(pipe->stream_uploader, 0,
-                  hud->bg.buffer_size +
-                  hud->whitelines.buffer_size +
-                  hud->text.buffer_size,
-                  16, &hud->bg.vbuf.buffer_offset, &hud->bg.vbuf.buffer.resource,
-                  (void**)&hud->bg.vertices);
-   if (!hud->bg.vertices)
-      return;
-
-   pipe_resource_reference(&hud->whitelines.vbuf.buffer.resource, hud->bg.vbuf.buffer.resource);
-   pipe_resource_reference(&hud->text.vbuf.buffer.resource, hud->bg.vbuf.buffer.resource);
+   if (draw) {
+      /* prepare vertex buffers */
+      hud_prepare_vertices(hud, &hud->bg, 16 * 256, 2 * sizeof(float));
+      hud_prepare_vertices(hud, &hud->whitelines, 4 * 256, 2 * sizeof(float));
+      hud_prepare_vertices(hud, &hud->text, 16 * 1024, 4 * sizeof(float));
 
-   hud->whitelines.vbuf.buffer_offset = hud->bg.vbuf.buffer_offset +
-                                        hud->bg.buffer_size;
-   hud->whitelines.vertices = hud->bg.vertices +
-                              hud->bg.buffer_size / sizeof(float);
-
-   hud->text.vbuf.buffer_offset = hud->whitelines.vbuf.buffer_offset +
-                                  hud->whitelines.buffer_size;
-   hud->text.vertices = hud->whitelines.vertices +
-                        hud->whitelines.buffer_size / sizeof(float);
+      /* Allocate everything once and divide the storage into 3 portions
+       * manually, because u_upload_alloc can unmap memory from previous
+       * calls.
+       */
+      u_upload_alloc(pipe->stream_uploader, 0,
+                     hud->bg.buffer_size +
+                     hud->whitelines.buffer_size +
+                     hud->text.buffer_size,
+                     16, &hud->bg.vbuf.buffer_offset,
+                     &hud->bg.vbuf.buffer.resource,
+                     (void**)&hud->bg.vertices);
+      if (!hud->bg.vertices)
+         return;
+
+      pipe_resource_reference(&hud->whitelines.vbuf.buffer.resource,
+                              hud->bg.vbuf.buffer.resource);
+      pipe_resource_reference(&hud->text.vbuf.buffer.resource,
+                              hud->bg.vbuf.buffer.resource);
+
+      hud->whitelines.vbuf.buffer_offset = hud->bg.vbuf.buffer_offset +
+                                           hud->bg.buffer_size;
+      hud->whitelines.vertices = hud->bg.vertices +
+                                 hud->bg.buffer_size / sizeof(float);
+
+      hud->text.vbuf.buffer_offset = hud->whitelines.vbuf.buffer_offset +
+                                     hud->whitelines.buffer_size;
+      hud->text.vertices = hud->whitelines.vertices +
+                           hud->whitelines.buffer_size / sizeof(float);
+   }
 
    /* prepare all graphs */
    hud_batch_query_update(hud->batch_query, pipe);
@@ -693,14 +760,23 @@ hud_stop_queries(struct hud_context *hud, struct pipe_context *pipe)
          }
       }
 
+      if (!draw)
+         continue;
+
       if (hud->simple)
          hud_pane_accumulate_vertices_simple(hud, pane);
       else
          hud_pane_accumulate_vertices(hud, pane);
    }
 
-   /* unmap the uploader's vertex buffer before drawing */
-   u_upload_unmap(pipe->stream_uploader);
+   if (hud->export_fd)
+      hud_export_record(hud);
+
+   if (draw) {
+      /* unmap the uploader's vertex buffer before drawing */
+      u_upload_unmap(pipe->stream_uploader);
+      hud->vertices_ready = true;
+   }
 }
 
 /**
@@ -937,6 +1013,7 @@ hud_pane_add_graph(struct hud_pane *pane, struct hud_graph *gr)
    gr->color[1] = colors[color][1];
    gr->color[2] = colors[color][2];
    gr->pane = pane;
+   gr->export_index = pane->hud->num_graphs++;
    list_addtail(&gr->head, &pane->graph_list);
    pane->num_graphs++;
    pane->next_color++;
@@ -1048,6 +1125,30 @@ hud_graph_set_dump_file(struct hud_graph *gr)
    }
 }
 
+/**
+ * If the GALLIUM_HUD_EXPORT env var is set, we'll append one CSV record per
+ * frame with the current values of all graphs to the given file, which can
+ * also be a pipe. Combined with GALLIUM_HUD_VISIBLE=false, nothing is drawn
+ * and only the queries are run.
+ */
+static void
+hud_open_export_file(struct hud_context *hud)
+{
+   const char *export_file = debug_get_option("GALLIUM_HUD_EXPORT", NULL);
+
+   if (!export_file || !*export_file || !hud->num_graphs)
+      return;
+
+   hud->export_fd = fopen(export_file, "w");
+   if (!hud->export_fd) {
+      fprintf(stderr, "gallium_hud: unable to open %s\n", export_file);
+      return;
+   }
+
+   /* flush output after each record is written */
+   setvbuf(hud->export_fd, NULL, _IOLBF, 0);
+}
+
 /**
  * Read a string from the environment variable.
  * The separators "+", ",", ":", and ";" terminate the string.
@@ -1904,6 +2005,7 @@ hud_create(struct cso_context *cso, struct hud_context *share)
       hud_set_draw_context(hud, cso);
 
    hud_parse_env_var(hud, screen, env);
+   hud_open_export_file(hud);
    return hud;
 }
 
@@ -1922,6 +2024,9 @@ hud_destroy(struct hud_context *hud, struct cso_context *cso)
 
    if (p_atomic_dec_zero(&hud->refcount)) {
       pipe_resource_reference(&hud->font.texture, NULL);
+      if (hud->export_fd)
+         fclose(hud->export_fd);
+      FREE(hud->export_values);
       FREE(hud);
    }
 }
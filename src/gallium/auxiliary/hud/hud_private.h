@@ -91,8 +91,16 @@ struct hud_context {
       unsigned num_vertices;
       unsigned buffer_size;
    } text, bg, whitelines;
+   bool vertices_ready; /* whether the queues above are filled for drawing */
 
    bool has_srgb;
+
+   /* GALLIUM_HUD_EXPORT: one CSV record per frame */
+   FILE *export_fd;
+   unsigned num_graphs;
+   double *export_values; /* indexed by hud_graph::export_index */
+   uint64_t export_frame;
+   int64_t export_start_time;
 };
 
 struct hud_graph {
@@ -115,6 +123,7 @@ struct hud_graph {
    unsigned index; /* vertex index being updated */
    double current_value;
    FILE *fd;
+   unsigned export_index; /* column in the GALLIUM_HUD_EXPORT records */
 };
 
 struct hud_pane {
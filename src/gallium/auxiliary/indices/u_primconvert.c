@@ -49,11 +49,48 @@
 #include "indices/u_indices.h"
 #include "indices/u_primconvert.h"
 
+/* Number of generated index buffers kept for non-indexed draws. */
+#define PRIMCONVERT_CACHE_SIZE 8
+
+/* Don't keep buffers for draws larger than this. */
+#define PRIMCONVERT_CACHE_MAX_COUNT (64 * 1024)
+
+/* Parameters of a non-indexed draw that the generated indices depend on. */
+struct primconvert_draw_key
+{
+   enum pipe_prim_type mode;
+   unsigned start;
+   unsigned count;
+   unsigned api_pv;
+};
+
+/* Index buffer generated for a non-indexed draw. It only depends on the
+ * draw parameters, so it can be reused by all identical draws.
+ */
+struct primconvert_cached_indices
+{
+   struct pipe_resource *buffer;
+   struct primconvert_draw_key key;
+
+   enum pipe_prim_type out_mode;
+   unsigned out_index_size;
+   unsigned out_count;
+};
+
 struct primconvert_context
 {
    struct pipe_context *pipe;
    uint32_t primtypes_mask;
    unsigned api_pv;
+
+   struct primconvert_cached_indices cache[PRIMCONVERT_CACHE_SIZE];
+   unsigned cache_next; /* entry to replace next */
+
+   /* Recent draws that missed the cache. Only a draw seen here again gets
+    * an immutable buffer; one-off draws go through the stream uploader.
+    */
+   struct primconvert_draw_key seen[PRIMCONVERT_CACHE_SIZE];
+   unsigned seen_next; /* entry to replace next */
 };
 
 
@@ -71,6 +108,8 @@ util_primconvert_create(struct pipe_context *pipe, uint32_t primtypes_mask)
 void
 util_primconvert_destroy(struct primconvert_context *pc)
 {
+   for (unsigned i = 0; i < PRIMCONVERT_CACHE_SIZE; i++)
+      pipe_resource_reference(&pc->cache[i].buffer, NULL);
    FREE(pc);
 }
 
@@ -86,6 +125,100 @@ util_primconvert_save_rasterizer_state(struct primconvert_context *pc,
    pc->api_pv = rast->flatshade_first ? PV_FIRST : PV_LAST;
 }
 
+static inline bool
+primconvert_draw_key_equal(const struct primconvert_draw_key *a,
+                           const struct primconvert_draw_key *b)
+{
+   return a->mode == b->mode &&
+          a->start == b->start &&
+          a->count == b->count &&
+          a->api_pv == b->api_pv;
+}
+
+/**
+ * Return the generated index buffer for a non-indexed draw. It is created
+ * the second time a draw misses the cache. Returns NULL if the draw isn't
+ * (yet) cached, in which case the caller uploads the indices itself.
+ */
+static const struct primconvert_cached_indices *
+primconvert_get_generated_indices(struct primconvert_context *pc,
+                                  const struct pipe_draw_info *info)
+{
+   struct primconvert_cached_indices *entry;
+   struct pipe_transfer *transfer;
+   u_generate_func gen_func;
+   enum pipe_prim_type mode = 0;
+   unsigned index_size, count;
+   unsigned i;
+   void *dst;
+
+   if (info->count > PRIMCONVERT_CACHE_MAX_COUNT)
+      return NULL;
+
+   const struct primconvert_draw_key key = {
+      .mode = info->mode,
+      .start = info->start,
+      .count = info->count,
+      .api_pv = pc->api_pv,
+   };
+
+   for (i = 0; i < PRIMCONVERT_CACHE_SIZE; i++) {
+      entry = &pc->cache[i];
+
+      if (entry->buffer && primconvert_draw_key_equal(&entry->key, &key))
+         return entry;
+   }
+
+   for (i = 0; i < PRIMCONVERT_CACHE_SIZE; i++) {
+      if (primconvert_draw_key_equal(&pc->seen[i], &key))
+         break;
+   }
+
+   if (i == PRIMCONVERT_CACHE_SIZE) {
+      pc->seen[pc->seen_next] = key;
+      pc->seen_next = (pc->seen_next + 1) % PRIMCONVERT_CACHE_SIZE;
+      return NULL;
+   }
+
+   /* Seen before, so it is likely to be drawn again: cache it. */
+   u_index_generator(pc->primtypes_mask,
+                     info->mode, info->start, info->count,
+                     pc->api_pv, pc->api_pv,
+                     &mode, &index_size, &count,
+                     &gen_func);
+   if (!count)
+      return NULL;
+
+   entry = &pc->cache[pc->cache_next];
+   pipe_resource_reference(&entry->buffer, NULL);
+
+   entry->buffer = pipe_buffer_create(pc->pipe->screen,
+                                      PIPE_BIND_INDEX_BUFFER,
+                                      PIPE_USAGE_IMMUTABLE,
+                                      index_size * count);
+   if (!entry->buffer)
+      return NULL;
+
+   dst = pipe_buffer_map(pc->pipe, entry->buffer,
+                         PIPE_TRANSFER_WRITE |
+                         PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE, &transfer);
+   if (!dst) {
+      pipe_resource_reference(&entry->buffer, NULL);
+      return NULL;
+   }
+
+   gen_func(info->start, count, dst);
+   pipe_buffer_unmap(pc->pipe, transfer);
+
+   entry->key = key;
+   entry->out_mode = mode;
+   entry->out_index_size = index_size;
+   entry->out_count = count;
+
+   pc->cache_next = (pc->cache_next + 1) % PRIMCONVERT_CACHE_SIZE;
+   return entry;
+}
+
 void
 util_primconvert_draw_vbo(struct primconvert_context *pc,
                           const struct pipe_draw_info *info)
@@ -106,6 +239,24 @@ util_primconvert_draw_vbo(struct primconvert_context *pc,
    new_info.instance_count = info->instance_count;
    new_info.primitive_restart = info->primitive_restart;
    new_info.restart_index = info->restart_index;
+
+   /* Generated indices don't change between frames, so reuse them. */
+   if (!info->index_size) {
+      const struct primconvert_cached_indices *cached =
+         primconvert_get_generated_indices(pc, info);
+
+      if (cached) {
+         new_info.mode = cached->out_mode;
+         new_info.index_size = cached->out_index_size;
+         new_info.count = cached->out_count;
+         new_info.index.resource = cached->buffer;
+         new_info.start = 0;
+
+         pc->pipe->draw_vbo(pc->pipe, &new_info);
+         return;
+      }
+   }
+
    if (info->index_size) {
       enum pipe_prim_type mode = 0;
       unsigned index_size;
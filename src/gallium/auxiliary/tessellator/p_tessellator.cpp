@@ -40,12 +40,67 @@ namespace pipe_tessellator_wrap
    private:
       typedef CHWTessellator SUPER;
       enum pipe_prim_type    prim_mode;
-      PIPE_ALIGN_VAR(32) float     domain_points_u[MAX_POINT_COUNT];
-      PIPE_ALIGN_VAR(32) float     domain_points_v[MAX_POINT_COUNT];
-      uint32_t               num_domain_points;
-      PIPE_ALIGN_VAR(32) uint32_t  indices[3][MAX_INDEX_COUNT / 3];
+      uint32_t               num_outer_tf;
+      uint32_t               num_inner_tf;
+
+      /// Patches of a draw often share their tessellation factors, so the
+      /// output of the last few distinct sets of factors is kept around.
+      struct cached_pattern
+      {
+         float     outer_tf[4];
+         float     inner_tf[2];
+         uint32_t  num_domain_points;
+         uint32_t  num_indices;
+         float    *domain_points_u;
+         float    *domain_points_v;
+         uint32_t *indices;
+         size_t    size;
+         uint64_t  last_use;
+      };
+
+      static const uint32_t NUM_CACHED_PATTERNS = 8;
+      cached_pattern         cache[NUM_CACHED_PATTERNS];
+      uint32_t               num_cached;
+      uint64_t               use_count;
+
+      cached_pattern *Lookup(const struct pipe_tessellation_factors *tess_factors)
+      {
+         for (uint32_t i = 0; i < num_cached; i++) {
+            cached_pattern *pattern = &cache[i];
+            if (memcmp(pattern->outer_tf, tess_factors->outer_tf,
+                       num_outer_tf * sizeof(float)) == 0 &&
+                memcmp(pattern->inner_tf, tess_factors->inner_tf,
+                       num_inner_tf * sizeof(float)) == 0)
+               return pattern;
+         }
+         return NULL;
+      }
+
+      cached_pattern *Evict()
+      {
+         if (num_cached < NUM_CACHED_PATTERNS)
+            return &cache[num_cached++];
+
+         cached_pattern *lru = &cache[0];
+         for (uint32_t i = 1; i < NUM_CACHED_PATTERNS; i++) {
+            if (cache[i].last_use < lru->last_use)
+               lru = &cache[i];
+         }
+         return lru;
+      }
 
    public:
+      pipe_ts() : num_cached(0), use_count(0)
+      {
+         memset(cache, 0, sizeof(cache));
+      }
+
+      ~pipe_ts()
+      {
+         for (uint32_t i = 0; i < num_cached; i++)
+            FREE(cache[i].domain_points_u);
+      }
+
       void Init(enum pipe_prim_type tes_prim_mode,
                 enum pipe_tess_spacing ts_spacing,
                 bool tes_vertex_order_cw, bool tes_point_mode)
@@ -70,11 +125,51 @@ namespace pipe_tessellator_wrap
                      out_prim);
 
          prim_mode          = tes_prim_mode;
-         num_domain_points = 0;
+
+         switch (tes_prim_mode)
+            {
+            case PIPE_PRIM_QUADS:
+               num_outer_tf = 4;
+               num_inner_tf = 2;
+               break;
+            case PIPE_PRIM_TRIANGLES:
+               num_outer_tf = 3;
+               num_inner_tf = 1;
+               break;
+            default:
+               num_outer_tf = 2;
+               num_inner_tf = 0;
+               break;
+            }
       }
 
       void Tessellate(const struct pipe_tessellation_factors *tess_factors,
                       struct pipe_tessellator_data *tess_data)
+      {
+         cached_pattern *pattern = Lookup(tess_factors);
+         if (!pattern) {
+            pattern = Evict();
+            if (!Generate(tess_factors, pattern)) {
+               /* Out of memory.  The slot is left zeroed, so it can only
+                * match all-zero factors, which cull the patch anyway.
+                */
+               memset(tess_data, 0, sizeof(*tess_data));
+               return;
+            }
+         }
+
+         pattern->last_use = ++use_count;
+
+         tess_data->num_domain_points = pattern->num_domain_points;
+         tess_data->domain_points_u = pattern->domain_points_u;
+         tess_data->domain_points_v = pattern->domain_points_v;
+         tess_data->num_indices = pattern->num_indices;
+         tess_data->indices = pattern->indices;
+      }
+
+   private:
+      bool Generate(const struct pipe_tessellation_factors *tess_factors,
+                    cached_pattern *pattern)
       {
          switch (prim_mode)
             {
@@ -104,23 +199,41 @@ namespace pipe_tessellator_wrap
 
             default:
                assert(0);
-               return;
+               return false;
             }
 
-         num_domain_points = (uint32_t)SUPER::GetPointCount();
+         uint32_t num_domain_points = (uint32_t)SUPER::GetPointCount();
+         uint32_t num_indices = (uint32_t)SUPER::GetIndexCount();
+
+         /* The u, v and index arrays share one allocation. */
+         size_t size = (2 * num_domain_points + num_indices) * sizeof(float);
+         if (size > pattern->size) {
+            float *data = (float *)REALLOC(pattern->domain_points_u,
+                                           pattern->size, size);
+            if (!data) {
+               FREE(pattern->domain_points_u);
+               memset(pattern, 0, sizeof(*pattern));
+               return false;
+            }
+            pattern->domain_points_u = data;
+            pattern->size = size;
+         }
+         pattern->domain_points_v = pattern->domain_points_u + num_domain_points;
+         pattern->indices = (uint32_t *)(pattern->domain_points_v + num_domain_points);
 
          DOMAIN_POINT *points = SUPER::GetPoints();
          for (uint32_t i = 0; i < num_domain_points; i++) {
-            domain_points_u[i] = points[i].u;
-            domain_points_v[i] = points[i].v;
+            pattern->domain_points_u[i] = points[i].u;
+            pattern->domain_points_v[i] = points[i].v;
          }
-         tess_data->num_domain_points = num_domain_points;
-         tess_data->domain_points_u = &domain_points_u[0];
-         tess_data->domain_points_v = &domain_points_v[0];
-
-         tess_data->num_indices = (uint32_t)SUPER::GetIndexCount();
+         memcpy(pattern->indices, SUPER::GetIndices(),
+                num_indices * sizeof(uint32_t));
 
-         tess_data->indices = (uint32_t*)SUPER::GetIndices();
+         memcpy(pattern->outer_tf, tess_factors->outer_tf, sizeof(pattern->outer_tf));
+         memcpy(pattern->inner_tf, tess_factors->inner_tf, sizeof(pattern->inner_tf));
+         pattern->num_domain_points = num_domain_points;
+         pattern->num_indices = num_indices;
+         return true;
       }
    };
 } // namespace Tessellator
@@ -756,6 +756,14 @@ void CHWTessellator::QuadGeneratePoints( const PROCESSED_TESS_FACTORS_QUAD& proc
     }
 
     // Generate interior ring points, clockwise from (U==0,V==1) (bottom-left) spiralling toward center
+    FXP fxpInsidePoints[QUAD_AXES][MAX_POINTS_PER_EDGE];
+    for(int axis = 0; axis < QUAD_AXES; axis++ )
+    {
+        SetTessellationParity(processedTessFactors.insideTessFactorParity[axis]);
+        PlacePointsIn1D(processedTessFactors.insideTessFactorCtx[axis],
+                        processedTessFactors.numPointsForInsideTessFactor[axis],
+                        fxpInsidePoints[axis]);
+    }
     static const int startRing = 1;
     int minNumPointsForTessFactor = min(processedTessFactors.numPointsForInsideTessFactor[U],processedTessFactors.numPointsForInsideTessFactor[V]);
     int numRings = (minNumPointsForTessFactor >> 1);  // note for even tess we aren't counting center point here.
@@ -769,15 +777,11 @@ void CHWTessellator::QuadGeneratePoints( const PROCESSED_TESS_FACTORS_QUAD& proc
         {
             int parity[QUAD_AXES] = {edge&0x1,((edge+1)&0x1)};
             int perpendicularAxisPoint = (edge < 2) ? startPoint : endPoint[parity[0]];
-            FXP fxpPerpParam;
-            SetTessellationParity(processedTessFactors.insideTessFactorParity[parity[0]]);
-            PlacePointIn1D(processedTessFactors.insideTessFactorCtx[parity[0]],perpendicularAxisPoint,fxpPerpParam);
-            SetTessellationParity(processedTessFactors.insideTessFactorParity[parity[1]]);
+            FXP fxpPerpParam = fxpInsidePoints[parity[0]][perpendicularAxisPoint];
             for(int p = startPoint; p < endPoint[parity[1]]; p++, pointOffset++) // don't include end: next edge starts with it.
             {
-                FXP fxpParam;
                 int q = ((edge == 1)||(edge==2)) ? p : endPoint[parity[1]] - (p - startPoint);
-                PlacePointIn1D(processedTessFactors.insideTessFactorCtx[parity[1]],q,fxpParam);
+                FXP fxpParam = fxpInsidePoints[parity[1]][q];
                 if( parity[1] )
                 {
                     DefinePoint(/*U*/fxpPerpParam,
@@ -799,12 +803,9 @@ void CHWTessellator::QuadGeneratePoints( const PROCESSED_TESS_FACTORS_QUAD& proc
     {
         int startPoint = numRings;
         int endPoint = processedTessFactors.numPointsForInsideTessFactor[U] - 1 - startPoint;
-        SetTessellationParity(processedTessFactors.insideTessFactorParity[U]);
         for( int p = startPoint; p <= endPoint; p++, pointOffset++ )
         {
-            FXP fxpParam;
-            PlacePointIn1D(processedTessFactors.insideTessFactorCtx[U],p,fxpParam);
-            DefinePoint(/*U*/fxpParam,
+            DefinePoint(/*U*/fxpInsidePoints[U][p],
                         /*V*/FXP_ONE_HALF, // middle
                         /*pointStorageOffset*/pointOffset);
         }
@@ -814,14 +815,11 @@ void CHWTessellator::QuadGeneratePoints( const PROCESSED_TESS_FACTORS_QUAD& proc
     {
         int startPoint = numRings;
         int endPoint;
-        FXP fxpParam;
         endPoint = processedTessFactors.numPointsForInsideTessFactor[V] - 1 - startPoint;
-        SetTessellationParity(processedTessFactors.insideTessFactorParity[V]);
         for( int p = endPoint; p >= startPoint; p--, pointOffset++ )
         {
-            PlacePointIn1D(processedTessFactors.insideTessFactorCtx[V],p,fxpParam);
             DefinePoint(/*U*/FXP_ONE_HALF, // middle
-                        /*V*/fxpParam,
+                        /*V*/fxpInsidePoints[V][p],
                         /*pointStorageOffset*/pointOffset);
         }
     }
@@ -1266,6 +1264,10 @@ void CHWTessellator::TriGeneratePoints( const PROCESSED_TESS_FACTORS_TRI& proces
 
     // Generate interior ring points, clockwise spiralling in
     SetTessellationParity(processedTessFactors.insideTessFactorParity);
+    FXP fxpInsidePoints[MAX_POINTS_PER_EDGE];
+    PlacePointsIn1D(processedTessFactors.insideTessFactorCtx,
+                    processedTessFactors.numPointsForInsideTessFactor,
+                    fxpInsidePoints);
     static const int startRing = 1;
     int numRings = (processedTessFactors.numPointsForInsideTessFactor >> 1);
     for(int ring = startRing; ring < numRings; ring++)
@@ -1277,20 +1279,18 @@ void CHWTessellator::TriGeneratePoints( const PROCESSED_TESS_FACTORS_TRI& proces
         {
             int parity = edge&0x1;
             int perpendicularAxisPoint = startPoint;
-            FXP fxpPerpParam;
-            PlacePointIn1D(processedTessFactors.insideTessFactorCtx,perpendicularAxisPoint,fxpPerpParam);
+            FXP fxpPerpParam = fxpInsidePoints[perpendicularAxisPoint];
             fxpPerpParam *= FXP_TWO_THIRDS; // Map location to the right size in barycentric space.
                                          // I (amarp) can draw a picture to explain.
                                          // We know this fixed point math won't over/underflow
             fxpPerpParam = (fxpPerpParam+FXP_ONE_HALF/*round*/)>>FXP_FRACTION_BITS; // get back to n.16
             for(int p = startPoint; p < endPoint; p++, pointOffset++) // don't include end: next edge starts with it.
             {
-                FXP fxpParam;
                 int q = (parity) ? p : endPoint - (p - startPoint); // whether to reverse point given we are defining V or U (W implicit):
                                                          // edge0, VW, has V decreasing, so reverse 1D points below
                                                          // edge1, WU, has U increasing, so don't reverse 1D points  below
                                                          // edge2, UV, has U decreasing, so reverse 1D points below
-                PlacePointIn1D(processedTessFactors.insideTessFactorCtx,q,fxpParam);
+                FXP fxpParam = fxpInsidePoints[q];
                 // edge0 VW, has perpendicular parameter U constant
                 // edge1 WU, has perpendicular parameter V constant
                 // edge2 UV, has perpendicular parameter W constant
@@ -1847,6 +1847,19 @@ void CHWTessellator::PlacePointIn1D( const TESS_FACTOR_CONTEXT& TessFactorCtx, i
     }
 }
 
+//---------------------------------------------------------------------------------------------------------------------------------
+// CHWTessellator::PlacePointsIn1D()
+//---------------------------------------------------------------------------------------------------------------------------------
+// The interior rings keep revisiting the same 1D locations, ring after ring, so compute all of
+// them once up front rather than once per point.
+void CHWTessellator::PlacePointsIn1D( const TESS_FACTOR_CONTEXT& TessFactorCtx, int numPoints, FXP* fxpLocations )
+{
+    for( int point = 0; point < numPoints; point++ )
+    {
+        PlacePointIn1D(TessFactorCtx,point,fxpLocations[point]);
+    }
+}
+
 //---------------------------------------------------------------------------------------------------------------------------------
 // CHWTessellator::StitchRegular
 //---------------------------------------------------------------------------------------------------------------------------------
@@ -68,6 +68,7 @@
 
 #define D3D11_TESSELLATOR_MAX_TESSELLATION_FACTOR 64 // max of even and odd tessFactors
 
+#define MAX_POINTS_PER_EDGE (D3D11_TESSELLATOR_MAX_TESSELLATION_FACTOR+1)
 #define MAX_POINT_COUNT ((D3D11_TESSELLATOR_MAX_TESSELLATION_FACTOR+1)*(D3D11_TESSELLATOR_MAX_TESSELLATION_FACTOR+1))
 #define MAX_INDEX_COUNT (D3D11_TESSELLATOR_MAX_TESSELLATION_FACTOR*D3D11_TESSELLATOR_MAX_TESSELLATION_FACTOR*2*3)
 
@@ -212,6 +213,7 @@ private:
     } TESS_FACTOR_CONTEXT;
     void ComputeTessFactorContext( FXP fxpTessFactor, TESS_FACTOR_CONTEXT& TessFactorCtx );
     void PlacePointIn1D( const TESS_FACTOR_CONTEXT& TessFactorCtx, int point, FXP& fxpLocation );
+    void PlacePointsIn1D( const TESS_FACTOR_CONTEXT& TessFactorCtx, int numPoints, FXP* fxpLocations );
 
     int NumPointsForTessFactor(FXP fxpTessFactor);
 
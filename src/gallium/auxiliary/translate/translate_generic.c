@@ -44,6 +44,8 @@ typedef void (*fetch_func)(void *dst,
                            const uint8_t *src,
                            unsigned i, unsigned j);
 typedef void (*emit_func)(const void *attrib, void *ptr);
+typedef void (*convert_func)(float *dst, const uint8_t *src,
+                             unsigned src_channels, unsigned dst_channels);
 
 
 
@@ -75,6 +77,13 @@ struct translate_generic {
        */
       int copy_size;
 
+      /* if non-NULL, converts directly from the input format to the 32-bit
+       * float output, bypassing fetch and emit
+       */
+      convert_func convert;
+      unsigned src_channels;
+      unsigned dst_channels;
+
    } attrib[TRANSLATE_MAX_ATTRIBS];
 
    unsigned nr_attrib;
@@ -586,6 +595,138 @@ get_emit_func(enum pipe_format format)
    }
 }
 
+/**
+ * Direct conversions of common vertex formats to 32-bit floats. They give
+ * the same results as the u_format fetch functions, but skip the
+ * intermediate float[4] and the emit function, and the channel loops are
+ * simple enough for the compiler to vectorize.
+ */
+#define CONVERT_ARRAY(NAME, SRCTYPE, TO)                                   \
+static void                                                               \
+convert_##NAME(float *dst, const uint8_t *src,                            \
+               unsigned src_channels, unsigned dst_channels)              \
+{                                                                         \
+   const SRCTYPE *in = (const SRCTYPE *)src;                              \
+   unsigned i;                                                            \
+                                                                          \
+   for (i = 0; i < src_channels; i++)                                     \
+      dst[i] = TO(in[i]);                                                 \
+   for (; i < dst_channels; i++)                                          \
+      dst[i] = i == 3 ? 1.0f : 0.0f;                                      \
+}
+
+#define FROM_UNORM8(x)   ubyte_to_float(x)
+#define FROM_SNORM8(x)   ((float)(x) * (1.0f / 0x7f))
+#define FROM_UNORM16(x)  ((float)(x) * (1.0f / 0xffff))
+#define FROM_SNORM16(x)  ((float)(x) * (1.0f / 0x7fff))
+#define FROM_HALF(x)     util_half_to_float(x)
+
+CONVERT_ARRAY(UNORM8, uint8_t, FROM_UNORM8)
+CONVERT_ARRAY(SNORM8, int8_t, FROM_SNORM8)
+CONVERT_ARRAY(UNORM16, uint16_t, FROM_UNORM16)
+CONVERT_ARRAY(SNORM16, int16_t, FROM_SNORM16)
+CONVERT_ARRAY(HALF, uint16_t, FROM_HALF)
+
+static void
+convert_R10G10B10A2_UNORM(float *dst, const uint8_t *src,
+                          unsigned src_channels, unsigned dst_channels)
+{
+   uint32_t value;
+   float rgba[4];
+
+   memcpy(&value, src, 4);
+   rgba[0] = (float)(value & 0x3ff) * (1.0f / 0x3ff);
+   rgba[1] = (float)((value >> 10) & 0x3ff) * (1.0f / 0x3ff);
+   rgba[2] = (float)((value >> 20) & 0x3ff) * (1.0f / 0x3ff);
+   rgba[3] = (float)(value >> 30) * (1.0f / 0x3);
+   memcpy(dst, rgba, dst_channels * sizeof(float));
+}
+
+static void
+convert_R10G10B10A2_SNORM(float *dst, const uint8_t *src,
+                          unsigned src_channels, unsigned dst_channels)
+{
+   int32_t value;
+   float rgba[4];
+
+   memcpy(&value, src, 4);
+   rgba[0] = (float)((int32_t)((uint32_t)value << 22) >> 22) * (1.0f / 0x1ff);
+   rgba[1] = (float)((int32_t)((uint32_t)value << 12) >> 22) * (1.0f / 0x1ff);
+   rgba[2] = (float)((int32_t)((uint32_t)value << 2) >> 22) * (1.0f / 0x1ff);
+   rgba[3] = (float)(value >> 30) * (1.0f / 0x1);
+   memcpy(dst, rgba, dst_channels * sizeof(float));
+}
+
+/**
+ * Return the direct conversion from "input" to "output", or NULL if there
+ * is none and the generic fetch+emit path must be used.
+ */
+static convert_func
+get_convert_func(enum pipe_format input, enum pipe_format output)
+{
+   const struct util_format_description *in_desc =
+      util_format_description(input);
+   const struct util_format_description *out_desc =
+      util_format_description(output);
+   unsigned i;
+
+   /* The output must be R32[G32[B32[A32]]]_FLOAT. */
+   if (out_desc->layout != UTIL_FORMAT_LAYOUT_PLAIN ||
+       !out_desc->is_array ||
+       out_desc->channel[0].type != UTIL_FORMAT_TYPE_FLOAT ||
+       out_desc->channel[0].size != 32)
+      return NULL;
+   for (i = 0; i < out_desc->nr_channels; i++) {
+      if (out_desc->swizzle[i] != PIPE_SWIZZLE_X + i)
+         return NULL;
+   }
+
+   switch (input) {
+   case PIPE_FORMAT_R10G10B10A2_UNORM:
+      return convert_R10G10B10A2_UNORM;
+   case PIPE_FORMAT_R10G10B10A2_SNORM:
+      return convert_R10G10B10A2_SNORM;
+   default:
+      break;
+   }
+
+   /* Otherwise the input must be an RGBA-ordered array of one type. */
+   if (in_desc->layout != UTIL_FORMAT_LAYOUT_PLAIN ||
+       !in_desc->is_array ||
+       in_desc->colorspace != UTIL_FORMAT_COLORSPACE_RGB ||
+       in_desc->channel[0].pure_integer)
+      return NULL;
+   for (i = 0; i < in_desc->nr_channels; i++) {
+      if (in_desc->swizzle[i] != PIPE_SWIZZLE_X + i)
+         return NULL;
+   }
+
+   switch (in_desc->channel[0].type) {
+   case UTIL_FORMAT_TYPE_UNSIGNED:
+      if (!in_desc->channel[0].normalized)
+         return NULL;
+      if (in_desc->channel[0].size == 8)
+         return convert_UNORM8;
+      if (in_desc->channel[0].size == 16)
+         return convert_UNORM16;
+      return NULL;
+   case UTIL_FORMAT_TYPE_SIGNED:
+      if (!in_desc->channel[0].normalized)
+         return NULL;
+      if (in_desc->channel[0].size == 8)
+         return convert_SNORM8;
+      if (in_desc->channel[0].size == 16)
+         return convert_SNORM16;
+      return NULL;
+   case UTIL_FORMAT_TYPE_FLOAT:
+      if (in_desc->channel[0].size == 16)
+         return convert_HALF;
+      return NULL;
+   default:
+      return NULL;
+   }
+}
+
 static ALWAYS_INLINE void PIPE_CDECL
 generic_run_one(struct translate_generic *tg,
                 unsigned elt,
@@ -625,6 +766,10 @@ generic_run_one(struct translate_generic *tg,
          copy_size = tg->attrib[attr].copy_size;
          if (likely(copy_size >= 0)) {
             memcpy(dst, src, copy_size);
+         } else if (tg->attrib[attr].convert) {
+            tg->attrib[attr].convert((float *)dst, src,
+                                     tg->attrib[attr].src_channels,
+                                     tg->attrib[attr].dst_channels);
          } else {
             tg->attrib[attr].fetch(data, src, 0, 0);
 
@@ -848,6 +993,16 @@ translate_generic_create(const struct translate_key *key)
          tg->attrib[i].emit = get_emit_func(key->element[i].output_format);
       else
          tg->attrib[i].emit  = NULL;
+
+      if (tg->attrib[i].copy_size < 0 &&
+          tg->attrib[i].type == TRANSLATE_ELEMENT_NORMAL) {
+         tg->attrib[i].convert =
+            get_convert_func(key->element[i].input_format,
+                             key->element[i].output_format);
+         tg->attrib[i].src_channels = format_desc->nr_channels;
+         tg->attrib[i].dst_channels =
+            util_format_get_nr_components(key->element[i].output_format);
+      }
    }
 
    tg->nr_attrib = key->nr_elements;
@@ -30,6 +30,7 @@
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
 #include "util/u_upload_mgr.h"
+#include "util/u_cpu_trace.h"
 
 /* 0 = disabled, 1 = assertions, 2 = printfs */
 #define TC_DEBUG 0
@@ -82,6 +83,7 @@ tc_debug_check(struct threaded_context *tc)
 static void
 tc_batch_execute(void *job, UNUSED int thread_index)
 {
+   UTIL_CPU_TRACE_FUNC();
    struct tc_batch *batch = job;
    struct pipe_context *pipe = batch->pipe;
    struct tc_call *last = &batch->call[batch->num_total_call_slots];
@@ -111,6 +113,20 @@ tc_batch_flush(struct threaded_context *tc)
    tc->bytes_mapped_estimate = 0;
    p_atomic_add(&tc->num_offloaded_slots, next->num_total_call_slots);
 
+   /* If no batch is waiting, the driver thread is (about to be) idle, so
+    * hand it work sooner with smaller batches. If batches pile up, the
+    * driver thread is the bottleneck, so go back to large batches to cut
+    * the per-batch overhead. Reading the count without the queue lock is
+    * fine for a heuristic.
+    */
+   int num_queued = p_atomic_read(&tc->queue.num_queued);
+   if (num_queued == 0)
+      tc->batch_call_slots = MAX2(tc->batch_call_slots / 2,
+                                  TC_MIN_CALLS_PER_BATCH);
+   else if (num_queued >= (TC_MAX_BATCHES - 2) / 2)
+      tc->batch_call_slots = MIN2(tc->batch_call_slots * 2,
+                                  TC_CALLS_PER_BATCH);
+
    if (next->token) {
       next->token->tc = NULL;
       tc_unflushed_batch_token_reference(&next->token, NULL);
@@ -136,7 +152,11 @@ tc_add_sized_call(struct threaded_context *tc, enum tc_call_id id,
 
    tc_debug_check(tc);
 
-   if (unlikely(next->num_total_call_slots + num_call_slots > TC_CALLS_PER_BATCH)) {
+   /* A call larger than the current batch size still fits into an empty
+    * batch.
+    */
+   if (unlikely(next->num_total_call_slots + num_call_slots > tc->batch_call_slots &&
+                next->num_total_call_slots)) {
       tc_batch_flush(tc);
       next = &tc->batch_slots[tc->next];
       tc_assert(next->num_total_call_slots == 0);
@@ -2671,6 +2691,8 @@ threaded_context_create(struct pipe_context *pipe,
    if (!util_queue_init(&tc->queue, "gdrv", TC_MAX_BATCHES - 2, 1, 0))
       goto fail;
 
+   tc->batch_call_slots = TC_CALLS_PER_BATCH;
+
    for (unsigned i = 0; i < TC_MAX_BATCHES; i++) {
       tc->batch_slots[i].sentinel = TC_SENTINEL;
       tc->batch_slots[i].pipe = pipe;
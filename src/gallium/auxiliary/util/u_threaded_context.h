@@ -222,6 +222,11 @@ struct tc_unflushed_batch_token;
  */
 #define TC_CALLS_PER_BATCH    768
 
+/* Batches are flushed early, down to this size, while the driver thread is
+ * waiting for work. See tc_batch_flush.
+ */
+#define TC_MIN_CALLS_PER_BATCH (TC_CALLS_PER_BATCH / 8)
+
 /* Threshold for when to use the queue or sync. */
 #define TC_MAX_STRING_MARKER_BYTES  512
 
@@ -370,6 +375,11 @@ struct threaded_context {
    struct util_queue queue;
    struct util_queue_fence *fence;
 
+   /* Number of call slots after which the current batch is flushed,
+    * between TC_MIN_CALLS_PER_BATCH and TC_CALLS_PER_BATCH.
+    */
+   unsigned batch_call_slots;
+
    unsigned last, next;
    struct tc_batch batch_slots[TC_MAX_BATCHES];
 };
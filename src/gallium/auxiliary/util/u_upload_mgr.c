@@ -37,6 +37,8 @@
 
 #include "u_upload_mgr.h"
 
+/* How many retired upload buffers are kept around for reuse. */
+#define U_UPLOAD_MAX_RECYCLED 4
 
 struct u_upload_mgr {
    struct pipe_context *pipe;
@@ -55,6 +57,10 @@ struct u_upload_mgr {
    unsigned offset; /* Aligned offset to the upload buffer, pointing
                      * at the first unused byte. */
    unsigned flushed_size; /* Size we have flushed by transfer_flush_region. */
+
+   boolean recycle; /* Whether retired buffers are reused once idle. */
+   struct pipe_resource *recycled[U_UPLOAD_MAX_RECYCLED]; /* Oldest first. */
+   unsigned num_recycled;
 };
 
 
@@ -113,6 +119,9 @@ u_upload_clone(struct pipe_context *pipe, struct u_upload_mgr *upload)
             upload->map_flags & PIPE_TRANSFER_FLUSH_EXPLICIT)
       u_upload_enable_flush_explicit(result);
 
+   if (upload->recycle)
+      u_upload_enable_recycling(result);
+
    return result;
 }
 
@@ -132,6 +141,12 @@ u_upload_disable_persistent(struct u_upload_mgr *upload)
    upload->map_flags |= PIPE_TRANSFER_FLUSH_EXPLICIT;
 }
 
+void
+u_upload_enable_recycling(struct u_upload_mgr *upload)
+{
+   upload->recycle = TRUE;
+}
+
 static void
 upload_unmap_internal(struct u_upload_mgr *upload, boolean destroying)
 {
@@ -176,10 +191,82 @@ u_upload_release_buffer(struct u_upload_mgr *upload)
 }
 
 
+/* Unmap the upload buffer and put it at the end of the recycle list,
+ * dropping the oldest buffer if the list is full.
+ */
+static void
+u_upload_retire_buffer(struct u_upload_mgr *upload)
+{
+   if (!upload->recycle || !upload->buffer ||
+       upload->buffer_size != align(upload->default_size, 4096)) {
+      u_upload_release_buffer(upload);
+      return;
+   }
+
+   upload_unmap_internal(upload, TRUE);
+
+   if (upload->num_recycled == U_UPLOAD_MAX_RECYCLED) {
+      pipe_resource_reference(&upload->recycled[0], NULL);
+      memmove(upload->recycled, upload->recycled + 1,
+              (U_UPLOAD_MAX_RECYCLED - 1) * sizeof(upload->recycled[0]));
+      upload->num_recycled--;
+   }
+
+   /* Transfer the reference. */
+   upload->recycled[upload->num_recycled++] = upload->buffer;
+   upload->buffer = NULL;
+   upload->buffer_size = 0;
+}
+
+/* Take the oldest retired buffer back if the GPU is done with it.
+ * Return the mapped size or 0 if there is no idle buffer.
+ */
+static unsigned
+u_upload_reuse_buffer(struct u_upload_mgr *upload, unsigned min_size)
+{
+   struct pipe_resource *buffer;
+   unsigned size;
+
+   if (!upload->num_recycled)
+      return 0;
+
+   buffer = upload->recycled[0];
+   size = buffer->width0;
+   if (size < min_size)
+      return 0;
+
+   /* A synchronized map that mustn't block fails if the buffer is busy. */
+   upload->map = pipe_buffer_map_range(upload->pipe, buffer, 0, size,
+                                       (upload->map_flags &
+                                        ~PIPE_TRANSFER_UNSYNCHRONIZED) |
+                                       PIPE_TRANSFER_DONTBLOCK,
+                                       &upload->transfer);
+   if (!upload->map) {
+      upload->transfer = NULL;
+      return 0;
+   }
+
+   upload->num_recycled--;
+   memmove(upload->recycled, upload->recycled + 1,
+           upload->num_recycled * sizeof(upload->recycled[0]));
+   upload->recycled[upload->num_recycled] = NULL;
+
+   /* Transfer the reference. */
+   upload->buffer = buffer;
+   upload->buffer_size = size;
+   upload->offset = 0;
+   return size;
+}
+
+
 void
 u_upload_destroy(struct u_upload_mgr *upload)
 {
    u_upload_release_buffer(upload);
+
+   for (unsigned i = 0; i < upload->num_recycled; i++)
+      pipe_resource_reference(&upload->recycled[i], NULL);
+
    FREE(upload);
 }
 
@@ -191,9 +278,24 @@ u_upload_alloc_buffer(struct u_upload_mgr *upload, unsigned min_size)
    struct pipe_resource buffer;
    unsigned size;
 
-   /* Release the old buffer, if present:
+   /* Release the old buffer, if present, or keep it for reuse:
     */
-   u_upload_release_buffer(upload);
+   if (upload->recycle) {
+      /* The buffer being retired is still in use, so only older ones are
+       * worth checking.
+       */
+      bool try_reuse = upload->num_recycled > 0;
+
+      u_upload_retire_buffer(upload);
+
+      if (try_reuse) {
+         size = u_upload_reuse_buffer(upload, min_size);
+         if (size)
+            return size;
+      }
+   } else {
+      u_upload_release_buffer(upload);
+   }
 
    /* Allocate a new one:
     */
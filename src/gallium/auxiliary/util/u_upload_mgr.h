@@ -77,6 +77,14 @@ u_upload_enable_flush_explicit(struct u_upload_mgr *upload);
 void
 u_upload_disable_persistent(struct u_upload_mgr *upload);
 
+/**
+ * Keep a few retired upload buffers and reuse the oldest one once the GPU
+ * is done with it, instead of allocating a new buffer every time the current
+ * one is full. This makes streaming uploads allocation-free in steady state.
+ */
+void
+u_upload_enable_recycling(struct u_upload_mgr *upload);
+
 /**
  * Destroy the upload manager.
  */
@@ -256,6 +256,9 @@ fd_context_destroy(struct pipe_context *pctx)
 			(uint32_t)ctx->stats.batch_total, (uint32_t)ctx->stats.batch_sysmem,
 			(uint32_t)ctx->stats.batch_gmem, (uint32_t)ctx->stats.batch_nondraw,
 			(uint32_t)ctx->stats.batch_restore);
+		printf("gmem_bins=%u, gmem_loads=%u, gmem_stores=%u\n",
+			(uint32_t)ctx->stats.gmem_bins, (uint32_t)ctx->stats.gmem_loads,
+			(uint32_t)ctx->stats.gmem_stores);
 	}
 }
 
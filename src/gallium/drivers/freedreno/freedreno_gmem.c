@@ -564,10 +564,40 @@ found:
  * GMEM render pass
  */
 
+/* Bytes per pixel moved between GMEM and system memory for the buffers
+ * in the FD_BUFFER_x mask, ignoring any compression.
+ */
+static unsigned
+gmem_bytes_per_pixel(struct fd_gmem_stateobj *gmem, unsigned buffers)
+{
+	unsigned cpp = 0;
+
+	for (unsigned i = 0; i < MAX_RENDER_TARGETS; i++)
+		if (buffers & (PIPE_CLEAR_COLOR0 << i))
+			cpp += gmem->cbuf_cpp[i];
+
+	/* A separate stencil has its own cpp, otherwise depth and stencil
+	 * share a buffer:
+	 */
+	if (gmem->zsbuf_cpp[1]) {
+		if (buffers & FD_BUFFER_DEPTH)
+			cpp += gmem->zsbuf_cpp[0];
+		if (buffers & FD_BUFFER_STENCIL)
+			cpp += gmem->zsbuf_cpp[1];
+	} else if (buffers & (FD_BUFFER_DEPTH | FD_BUFFER_STENCIL)) {
+		cpp += gmem->zsbuf_cpp[0];
+	}
+
+	return cpp;
+}
+
 static void
 render_tiles(struct fd_batch *batch, struct fd_gmem_stateobj *gmem)
 {
 	struct fd_context *ctx = batch->ctx;
+	const unsigned load_cpp = batch->restore ?
+		gmem_bytes_per_pixel(gmem, batch->restore) : 0;
+	const unsigned store_cpp = gmem_bytes_per_pixel(gmem, batch->resolve);
 	int i;
 
 	mtx_lock(&ctx->gmem_lock);
@@ -577,6 +607,8 @@ render_tiles(struct fd_batch *batch, struct fd_gmem_stateobj *gmem)
 	if (batch->restore)
 		ctx->stats.batch_restore++;
 
+	ctx->stats.gmem_bins += gmem->nbins_x * gmem->nbins_y;
+
 	for (i = 0; i < (gmem->nbins_x * gmem->nbins_y); i++) {
 		struct fd_tile *tile = &gmem->tile[i];
 
@@ -585,6 +617,9 @@ render_tiles(struct fd_batch *batch, struct fd_gmem_stateobj *gmem)
 
 		ctx->emit_tile_prep(batch, tile);
 
+		ctx->stats.gmem_loads += tile->bin_w * tile->bin_h * load_cpp;
+		ctx->stats.gmem_stores += tile->bin_w * tile->bin_h * store_cpp;
+
 		if (batch->restore) {
 			ctx->emit_tile_mem2gmem(batch, tile);
 		}
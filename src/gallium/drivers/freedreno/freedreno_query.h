@@ -64,10 +64,13 @@ fd_query(struct pipe_query *pq)
 #define FD_QUERY_SHADOW_UPLOADS  (PIPE_QUERY_DRIVER_SPECIFIC + 7)  /* texture/buffer uploads that shadowed rsc */
 #define FD_QUERY_VS_REGS         (PIPE_QUERY_DRIVER_SPECIFIC + 8)  /* avg # of VS registers (scaled up by 100x) */
 #define FD_QUERY_FS_REGS         (PIPE_QUERY_DRIVER_SPECIFIC + 9)  /* avg # of VS registers (scaled up by 100x) */
+#define FD_QUERY_GMEM_BINS       (PIPE_QUERY_DRIVER_SPECIFIC + 10) /* bins rendered by GMEM batches */
+#define FD_QUERY_GMEM_LOADS      (PIPE_QUERY_DRIVER_SPECIFIC + 11) /* bytes restored to GMEM (mem2gmem) */
+#define FD_QUERY_GMEM_STORES     (PIPE_QUERY_DRIVER_SPECIFIC + 12) /* bytes resolved from GMEM (gmem2mem) */
 /* insert any new non-perfcntr queries here, the first perfcntr index
  * needs to come last!
  */
-#define FD_QUERY_FIRST_PERFCNTR  (PIPE_QUERY_DRIVER_SPECIFIC + 10)
+#define FD_QUERY_FIRST_PERFCNTR  (PIPE_QUERY_DRIVER_SPECIFIC + 13)
 
 void fd_query_screen_init(struct pipe_screen *pscreen);
 void fd_query_context_init(struct pipe_context *pctx);
@@ -67,6 +67,12 @@ read_counter(struct fd_context *ctx, int type)
 		return ctx->stats.batch_nondraw;
 	case FD_QUERY_BATCH_RESTORE:
 		return ctx->stats.batch_restore;
+	case FD_QUERY_GMEM_BINS:
+		return ctx->stats.gmem_bins;
+	case FD_QUERY_GMEM_LOADS:
+		return ctx->stats.gmem_loads;
+	case FD_QUERY_GMEM_STORES:
+		return ctx->stats.gmem_stores;
 	case FD_QUERY_STAGING_UPLOADS:
 		return ctx->stats.staging_uploads;
 	case FD_QUERY_SHADOW_UPLOADS:
@@ -175,6 +181,9 @@ fd_sw_create_query(struct fd_context *ctx, unsigned query_type, unsigned index)
 	case FD_QUERY_BATCH_GMEM:
 	case FD_QUERY_BATCH_NONDRAW:
 	case FD_QUERY_BATCH_RESTORE:
+	case FD_QUERY_GMEM_BINS:
+	case FD_QUERY_GMEM_LOADS:
+	case FD_QUERY_GMEM_STORES:
 	case FD_QUERY_STAGING_UPLOADS:
 	case FD_QUERY_SHADOW_UPLOADS:
 	case FD_QUERY_VS_REGS:
@@ -193,6 +193,7 @@ iris_init_batch(struct iris_context *ice,
 
    util_dynarray_init(&batch->exec_fences, ralloc_context(NULL));
    util_dynarray_init(&batch->syncobjs, ralloc_context(NULL));
+   util_dynarray_init(&batch->slab_bos, ralloc_context(NULL));
 
    batch->exec_count = 0;
    batch->exec_array_size = 100;
@@ -286,6 +287,21 @@ iris_use_pinned_bo(struct iris_batch *batch,
       iris_bo_bump_seqno(bo, batch->next_seqno, access);
    }
 
+   /* Suballocated BOs are tracked here, and validated as their slab. */
+   bool new_slab_entry = false;
+   if (iris_bo_is_slab(bo)) {
+      struct iris_syncobj *syncobj = iris_batch_get_signal_syncobj(batch);
+
+      if (READ_ONCE(bo->slab.syncobj) != syncobj) {
+         iris_bo_reference(bo);
+         util_dynarray_append(&batch->slab_bos, struct iris_bo *, bo);
+         iris_bo_slab_mark_used(bo, syncobj, batch->hw_ctx_id);
+         new_slab_entry = true;
+      }
+
+      bo = bo->slab.real;
+   }
+
    struct drm_i915_gem_exec_object2 *existing_entry =
       find_validation_entry(batch, bo);
 
@@ -294,7 +310,11 @@ iris_use_pinned_bo(struct iris_batch *batch,
       if (writable)
          existing_entry->flags |= EXEC_OBJECT_WRITE;
 
-      return;
+      /* Another BO of the slab put it there, but this one may still need
+       * synchronizing with the other batches.
+       */
+      if (!new_slab_entry)
+         return;
    }
 
    if (bo != batch->bo) {
@@ -329,6 +349,9 @@ iris_use_pinned_bo(struct iris_batch *batch,
       }
    }
 
+   if (existing_entry)
+      return;
+
    /* Now, take a reference and add it to the validation list. */
    iris_bo_reference(bo);
 
@@ -421,6 +444,9 @@ iris_batch_free(struct iris_batch *batch)
       iris_bo_unreference(batch->exec_bos[i]);
    }
    free(batch->exec_bos);
+   util_dynarray_foreach(&batch->slab_bos, struct iris_bo *, bo)
+      iris_bo_unreference(*bo);
+   ralloc_free(batch->slab_bos.mem_ctx);
    free(batch->validation_list);
 
    ralloc_free(batch->exec_fences.mem_ctx);
@@ -657,6 +683,10 @@ submit_batch(struct iris_batch *batch)
       iris_bo_unreference(bo);
    }
 
+   util_dynarray_foreach(&batch->slab_bos, struct iris_bo *, bo)
+      iris_bo_unreference(*bo);
+   util_dynarray_clear(&batch->slab_bos);
+
    return ret;
 }
 
@@ -759,7 +789,10 @@ _iris_batch_flush(struct iris_batch *batch, const char *file, int line)
 bool
 iris_batch_references(struct iris_batch *batch, struct iris_bo *bo)
 {
-   return find_validation_entry(batch, bo) != NULL;
+   if (iris_bo_is_slab(bo) && !bo->slab.shared)
+      return READ_ONCE(bo->slab.syncobj) == iris_batch_get_signal_syncobj(batch);
+
+   return find_validation_entry(batch, iris_bo_get_real(bo)) != NULL;
 }
 
 /**
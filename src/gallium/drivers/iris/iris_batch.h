@@ -104,6 +104,13 @@ struct iris_batch {
    /** A list of drm_i915_exec_fences to have execbuf signal or wait on */
    struct util_dynarray exec_fences;
 
+   /**
+    * Suballocated BOs used by this batch.  The validation list only holds
+    * the real BOs backing them, so these are referenced here until the
+    * batch is submitted, to keep them from being reused early.
+    */
+   struct util_dynarray slab_bos;
+
    /** The amount of aperture space (in bytes) used by all exec_bos */
    int aperture_space;
 
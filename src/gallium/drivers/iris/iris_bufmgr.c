@@ -60,6 +60,7 @@
 #include "util/hash_table.h"
 #include "util/list.h"
 #include "util/os_file.h"
+#include "util/os_time.h"
 #include "util/u_dynarray.h"
 #include "util/vma.h"
 #include "iris_bufmgr.h"
@@ -101,6 +102,12 @@
 
 #define FILE_DEBUG_FLAG DEBUG_BUFMGR
 
+/* BO_ALLOC_SUBALLOC entries range from 256B to 64KB, and are naturally
+ * aligned within their slab.
+ */
+#define IRIS_SLAB_MIN_ORDER 8
+#define IRIS_SLAB_MAX_ORDER 16
+
 static inline int
 atomic_add_unless(int *v, int add, int unless)
 {
@@ -134,6 +141,18 @@ struct bo_cache_bucket {
    uint64_t size;
 };
 
+/**
+ * A real BO carved into many same-sized suballocated BOs.
+ */
+struct iris_slab {
+   struct pb_slab base;
+
+   /** The real BO backing the entries */
+   struct iris_bo *bo;
+
+   struct iris_bo *entries;
+};
+
 struct bo_export {
    /** File descriptor associated with a handle export. */
    int drm_fd;
@@ -172,6 +191,9 @@ struct iris_bufmgr {
 
    struct util_vma_heap vma_allocator[IRIS_MEMZONE_COUNT];
 
+   /** Suballocator for small BO_ALLOC_SUBALLOC buffers */
+   struct pb_slabs bo_slabs;
+
    bool has_llc:1;
    bool has_mmap_offset:1;
    bool has_tiling_uapi:1;
@@ -191,6 +213,15 @@ static int bo_set_tiling_internal(struct iris_bo *bo, uint32_t tiling_mode,
 
 static void bo_free(struct iris_bo *bo);
 
+static struct iris_bo *bo_alloc_internal(struct iris_bufmgr *bufmgr,
+                                         const char *name,
+                                         uint64_t size,
+                                         uint32_t alignment,
+                                         enum iris_memory_zone memzone,
+                                         unsigned flags,
+                                         uint32_t tiling_mode,
+                                         uint32_t stride);
+
 static struct iris_bo *
 find_and_ref_external_bo(struct hash_table *ht, unsigned int key)
 {
@@ -338,9 +369,85 @@ vma_free(struct iris_bufmgr *bufmgr,
    util_vma_heap_free(&bufmgr->vma_allocator[memzone], address, size);
 }
 
+static void
+slab_syncobj_unreference(struct iris_bufmgr *bufmgr,
+                         struct iris_syncobj *syncobj)
+{
+   if (syncobj && pipe_reference(&syncobj->ref, NULL)) {
+      /* As iris_syncobj_destroy(), the screen fd is the bufmgr one. */
+      struct drm_syncobj_destroy args = { .handle = syncobj->handle };
+      gen_ioctl(bufmgr->fd, DRM_IOCTL_SYNCOBJ_DESTROY, &args);
+      free(syncobj);
+   }
+}
+
+/**
+ * Records that a batch, identified by its signalling syncobj and hardware
+ * context, uses the suballocated BO.
+ */
+void
+iris_bo_slab_mark_used(struct iris_bo *bo, struct iris_syncobj *syncobj,
+                       uint32_t hw_ctx_id)
+{
+   assert(iris_bo_is_slab(bo));
+
+   uint32_t last_ctx_id = p_atomic_xchg(&bo->slab.hw_ctx_id, hw_ctx_id);
+   if (last_ctx_id && last_ctx_id != hw_ctx_id)
+      bo->slab.shared = true;
+
+   struct iris_syncobj *old;
+   pipe_reference(NULL, &syncobj->ref);
+   do {
+      old = READ_ONCE(bo->slab.syncobj);
+   } while (p_atomic_cmpxchg(&bo->slab.syncobj, old, syncobj) != old);
+   slab_syncobj_unreference(bo->bufmgr, old);
+
+   bo->idle = false;
+}
+
+/**
+ * Waits on a suballocated BO, see iris_bo_wait().
+ *
+ * The kernel only knows about the real BO, which other BOs in the slab
+ * may keep busy, so wait for the last batch using this BO instead.
+ */
+static int
+slab_entry_wait(struct iris_bo *bo, int64_t timeout_ns)
+{
+   if (bo->slab.shared) {
+      int ret = iris_bo_wait(bo->slab.real, timeout_ns);
+      if (ret == 0)
+         bo->idle = true;
+      return ret;
+   }
+
+   struct iris_syncobj *syncobj = READ_ONCE(bo->slab.syncobj);
+   if (syncobj) {
+      struct drm_syncobj_wait wait = {
+         .handles = (uintptr_t)&syncobj->handle,
+         .count_handles = 1,
+         .timeout_nsec = timeout_ns < 0 ? INT64_MAX :
+                         os_time_get_absolute_timeout(timeout_ns),
+      };
+
+      /* A batch which hasn't been submitted yet has no fence, and isn't
+       * using the BO as far as the GPU is concerned.
+       */
+      if (gen_ioctl(bo->bufmgr->fd, DRM_IOCTL_SYNCOBJ_WAIT, &wait) != 0)
+         return errno == EINVAL ? 0 : -errno;
+   }
+
+   bo->idle = true;
+
+   return 0;
+}
+
 int
 iris_bo_busy(struct iris_bo *bo)
 {
+   if (iris_bo_is_slab(bo))
+      return slab_entry_wait(bo, 0) != 0;
+
    struct iris_bufmgr *bufmgr = bo->bufmgr;
    struct drm_i915_gem_busy busy = { .handle = bo->gem_handle };
 
@@ -501,6 +608,127 @@ alloc_fresh_bo(struct iris_bufmgr *bufmgr, uint64_t bo_size)
    return bo;
 }
 
+static bool
+iris_can_reclaim_slab(void *priv, struct pb_slab_entry *entry)
+{
+   struct iris_bo *bo = NULL; /* fix container_of */
+   bo = container_of(entry, bo, slab.entry);
+
+   /* Batches hold a reference on the BOs they use until submission, so
+    * freed entries can only be in use by submitted batches.
+    */
+   return !iris_bo_busy(bo);
+}
+
+static struct pb_slab *
+iris_slab_alloc(void *priv, unsigned heap, unsigned entry_size,
+                unsigned group_index)
+{
+   struct iris_bufmgr *bufmgr = priv;
+   struct iris_slab *slab = calloc(1, sizeof(*slab));
+
+   if (!slab)
+      return NULL;
+
+   /* The slab is twice the size of the largest possible entry, like the
+    * amdgpu winsys does.
+    */
+   slab->bo = bo_alloc_internal(bufmgr, "slab", 2 << IRIS_SLAB_MAX_ORDER, 1,
+                                IRIS_MEMZONE_OTHER, 0, I915_TILING_NONE, 0);
+   if (!slab->bo)
+      goto fail;
+
+   slab->base.num_entries = slab->bo->size / entry_size;
+   slab->base.num_free = slab->base.num_entries;
+   slab->entries = calloc(slab->base.num_entries, sizeof(*slab->entries));
+   if (!slab->entries)
+      goto fail_bo;
+
+   list_inithead(&slab->base.free);
+
+   for (unsigned i = 0; i < slab->base.num_entries; i++) {
+      struct iris_bo *bo = &slab->entries[i];
+
+      bo->size = entry_size;
+      bo->bufmgr = bufmgr;
+      bo->hash = _mesa_hash_pointer(bo);
+      bo->gem_handle = slab->bo->gem_handle;
+      bo->gtt_offset = slab->bo->gtt_offset + i * entry_size;
+      bo->index = -1;
+      bo->kflags = slab->bo->kflags;
+      bo->tiling_mode = I915_TILING_NONE;
+      bo->idle = true;
+      bo->cache_coherent = slab->bo->cache_coherent;
+      list_inithead(&bo->exports);
+
+      bo->slab.real = slab->bo;
+      bo->slab.entry.slab = &slab->base;
+      bo->slab.entry.group_index = group_index;
+      list_addtail(&bo->slab.entry.head, &slab->base.free);
+   }
+
+   return &slab->base;
+
+fail_bo:
+   iris_bo_unreference(slab->bo);
+fail:
+   free(slab);
+   return NULL;
+}
+
+static void
+iris_slab_free(void *priv, struct pb_slab *pslab)
+{
+   struct iris_slab *slab = (struct iris_slab *) pslab;
+
+   for (unsigned i = 0; i < slab->base.num_entries; i++)
+      slab_syncobj_unreference(slab->bo->bufmgr, slab->entries[i].slab.syncobj);
+
+   iris_bo_unreference(slab->bo);
+   free(slab->entries);
+   free(slab);
+}
+
+static struct iris_bo *
+alloc_bo_from_slabs(struct iris_bufmgr *bufmgr,
+                    const char *name,
+                    uint64_t size,
+                    uint32_t alignment,
+                    unsigned flags)
+{
+   /* Entries are aligned to their size, which is a power of two. */
+   struct pb_slab_entry *entry =
+      pb_slab_alloc(&bufmgr->bo_slabs, MAX2(size, alignment), 0);
+   if (!entry)
+      return NULL;
+
+   struct iris_bo *bo = NULL; /* fix container_of */
+   bo = container_of(entry, bo, slab.entry);
+
+   /* Forget about the batches using the previous BO at this address. */
+   slab_syncobj_unreference(bufmgr, bo->slab.syncobj);
+   bo->slab.syncobj = NULL;
+   bo->slab.hw_ctx_id = 0;
+   bo->slab.shared = false;
+
+   bo->name = name;
+   p_atomic_set(&bo->refcount, 1);
+
+   if (flags & BO_ALLOC_ZEROED) {
+      void *map = iris_bo_map(NULL, bo, MAP_WRITE | MAP_RAW);
+      if (!map) {
+         iris_bo_unreference(bo);
+         return NULL;
+      }
+      memset(map, 0, bo->size);
+   }
+
+   DBG("bo_create: buf %d (%s) (slab) %llub\n", bo->gem_handle,
+       bo->name, (unsigned long long) size);
+
+   return bo;
+}
+
 static struct iris_bo *
 bo_alloc_internal(struct iris_bufmgr *bufmgr,
                   const char *name,
@@ -513,6 +741,15 @@ bo_alloc_internal(struct iris_bufmgr *bufmgr,
 {
    struct iris_bo *bo;
    unsigned int page_size = getpagesize();
+
+   if ((flags & BO_ALLOC_SUBALLOC) && !(flags & BO_ALLOC_COHERENT) &&
+       memzone == IRIS_MEMZONE_OTHER && tiling_mode == I915_TILING_NONE &&
+       MAX2(size, alignment) <= (1 << IRIS_SLAB_MAX_ORDER)) {
+      bo = alloc_bo_from_slabs(bufmgr, name, size, alignment, flags);
+      if (bo)
+         return bo;
+   }
+
    struct bo_cache_bucket *bucket = bucket_for_size(bufmgr, size);
 
    /* Round the size up to the bucket size, or if we don't have caching
@@ -888,6 +1125,15 @@ iris_bo_unreference(struct iris_bo *bo)
       struct iris_bufmgr *bufmgr = bo->bufmgr;
       struct timespec time;
 
+      if (iris_bo_is_slab(bo)) {
+         /* Slab entries aren't looked up by handle or name, so there's no
+          * need to hold the lock to drop the last reference.
+          */
+         if (p_atomic_dec_zero(&bo->refcount))
+            pb_slab_free(&bufmgr->bo_slabs, &bo->slab.entry);
+         return;
+      }
+
       clock_gettime(CLOCK_MONOTONIC, &time);
 
       mtx_lock(&bufmgr->lock);
@@ -1208,6 +1454,18 @@ void *
 iris_bo_map(struct pipe_debug_callback *dbg,
             struct iris_bo *bo, unsigned flags)
 {
+   if (iris_bo_is_slab(bo)) {
+      /* Wait for this BO only, not everything else in the slab. */
+      void *map = iris_bo_map(dbg, bo->slab.real, flags | MAP_ASYNC);
+      if (!map)
+         return NULL;
+
+      if (!(flags & MAP_ASYNC))
+         bo_wait_with_stall_warning(dbg, bo, "slab mapping");
+
+      return (char *) map + (bo->gtt_offset - bo->slab.real->gtt_offset);
+   }
+
    if (bo->tiling_mode != I915_TILING_NONE && !(flags & MAP_RAW))
       return iris_bo_map_gtt(dbg, bo, flags);
 
@@ -1284,6 +1542,9 @@ iris_bo_wait(struct iris_bo *bo, int64_t timeout_ns)
    if (bo->idle && !bo->external)
       return 0;
 
+   if (iris_bo_is_slab(bo))
+      return slab_entry_wait(bo, timeout_ns);
+
    struct drm_i915_gem_wait wait = {
       .bo_handle = bo->gem_handle,
       .timeout_ns = timeout_ns,
@@ -1300,6 +1561,9 @@ iris_bo_wait(struct iris_bo *bo, int64_t timeout_ns)
 static void
 iris_bufmgr_destroy(struct iris_bufmgr *bufmgr)
 {
+   /* Return the slabs to the BO cache, before the lock goes away. */
+   pb_slabs_deinit(&bufmgr->bo_slabs);
+
    /* Free aux-map buffers */
    gen_aux_map_finish(bufmgr->aux_map_ctx);
 
@@ -1483,6 +1747,8 @@ iris_bo_make_external(struct iris_bo *bo)
 {
    struct iris_bufmgr *bufmgr = bo->bufmgr;
 
+   assert(!iris_bo_is_slab(bo));
+
    if (bo->external) {
       assert(!bo->reusable);
       return;
@@ -1498,6 +1764,9 @@ iris_bo_export_dmabuf(struct iris_bo *bo, int *prime_fd)
 {
    struct iris_bufmgr *bufmgr = bo->bufmgr;
 
+   if (iris_bo_is_slab(bo))
+      return -EINVAL;
+
    iris_bo_make_external(bo);
 
    if (drmPrimeHandleToFD(bufmgr->fd, bo->gem_handle,
@@ -1520,6 +1789,9 @@ iris_bo_flink(struct iris_bo *bo, uint32_t *name)
 {
    struct iris_bufmgr *bufmgr = bo->bufmgr;
 
+   if (iris_bo_is_slab(bo))
+      return -EINVAL;
+
    if (!bo->global_name) {
       struct drm_gem_flink flink = { .handle = bo->gem_handle };
 
@@ -1548,6 +1820,10 @@ iris_bo_export_gem_handle_for_device(struct iris_bo *bo, int drm_fd,
     * times.
     */
    struct iris_bufmgr *bufmgr = bo->bufmgr;
+
+   if (iris_bo_is_slab(bo))
+      return -EINVAL;
+
    int ret = os_same_file_description(drm_fd, bufmgr->fd);
    WARN_ONCE(ret < 0,
              "Kernel has no file descriptor comparison support: %s\n",
@@ -1840,6 +2116,17 @@ iris_bufmgr_create(struct gen_device_info *devinfo, int fd, bool bo_reuse)
       return NULL;
    }
 
+   if (!pb_slabs_init(&bufmgr->bo_slabs,
+                      IRIS_SLAB_MIN_ORDER, IRIS_SLAB_MAX_ORDER, 1, bufmgr,
+                      iris_can_reclaim_slab,
+                      iris_slab_alloc,
+                      iris_slab_free)) {
+      mtx_destroy(&bufmgr->lock);
+      close(bufmgr->fd);
+      free(bufmgr);
+      return NULL;
+   }
+
    list_inithead(&bufmgr->zombie_list);
 
    bufmgr->has_llc = devinfo->has_llc;
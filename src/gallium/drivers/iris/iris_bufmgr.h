@@ -33,8 +33,10 @@
 #include "util/u_atomic.h"
 #include "util/list.h"
 #include "pipe/p_defines.h"
+#include "pipebuffer/pb_slab.h"
 
 struct iris_batch;
+struct iris_syncobj;
 struct gen_device_info;
 struct pipe_debug_callback;
 
@@ -237,10 +239,37 @@ struct iris_bo {
     * Boolean of whether this buffer points into user memory
     */
    bool userptr;
+
+   /**
+    * Suballocation state for BOs carved out of a slab, see
+    * iris_bo_is_slab().  Such BOs share the GEM handle, the mappings and
+    * the validation list entry of the real BO backing the slab.
+    */
+   struct {
+      struct pb_slab_entry entry;
+
+      /** The real BO backing the slab, NULL if this BO isn't suballocated */
+      struct iris_bo *real;
+
+      /**
+       * The signalling syncobj and hardware context of the last batch which
+       * used this BO.  Batches of a single hardware context complete in
+       * order, so waiting on the syncobj is enough unless batches from
+       * several contexts used the BO, in which case \c shared is set and
+       * the real BO is waited on instead.
+       */
+      struct iris_syncobj *syncobj;
+      uint32_t hw_ctx_id;
+      bool shared;
+   } slab;
 };
 
 #define BO_ALLOC_ZEROED     (1<<0)
 #define BO_ALLOC_COHERENT   (1<<1)
+/* Small untiled BOs in IRIS_MEMZONE_OTHER may be carved out of a larger
+ * slab BO.  These can't be exported.
+ */
+#define BO_ALLOC_SUBALLOC   (1<<2)
 
 /**
  * Allocate a buffer object.
@@ -292,6 +321,28 @@ iris_bo_reference(struct iris_bo *bo)
  */
 void iris_bo_unreference(struct iris_bo *bo);
 
+/**
+ * Returns whether the BO was suballocated out of a slab (BO_ALLOC_SUBALLOC).
+ */
+static inline bool
+iris_bo_is_slab(const struct iris_bo *bo)
+{
+   return bo->slab.real != NULL;
+}
+
+/**
+ * Returns the BO which owns the GEM handle, i.e. the slab for suballocated
+ * BOs and the BO itself otherwise.
+ */
+static inline struct iris_bo *
+iris_bo_get_real(struct iris_bo *bo)
+{
+   return iris_bo_is_slab(bo) ? bo->slab.real : bo;
+}
+
+void iris_bo_slab_mark_used(struct iris_bo *bo, struct iris_syncobj *syncobj,
+                            uint32_t hw_ctx_id);
+
 #define MAP_READ          PIPE_TRANSFER_READ
 #define MAP_WRITE         PIPE_TRANSFER_WRITE
 #define MAP_ASYNC         PIPE_TRANSFER_UNSYNCHRONIZED
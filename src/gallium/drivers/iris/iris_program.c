@@ -38,6 +38,7 @@
 #include "util/u_atomic.h"
 #include "util/u_upload_mgr.h"
 #include "util/debug.h"
+#include "util/os_time.h"
 #include "compiler/nir/nir.h"
 #include "compiler/nir/nir_builder.h"
 #include "compiler/nir/nir_serialize.h"
@@ -1002,10 +1003,33 @@ iris_setup_binding_table(const struct gen_device_info *devinfo,
    }
 }
 
+/**
+ * Report the statistics of the variants brw compiled for a shader.
+ */
+static void
+iris_debug_shader_stats(struct iris_context *ice, gl_shader_stage stage,
+                        const struct brw_compile_stats *stats)
+{
+   for (unsigned i = 0; i < 3 && stats[i].instructions; i++) {
+      const struct pipe_shader_stats s = {
+         .stage = _mesa_shader_stage_to_abbrev(stage),
+         .dispatch_width = stats[i].dispatch_width,
+         .instructions = stats[i].instructions,
+         .sends = stats[i].sends,
+         .loops = stats[i].loops,
+         .cycles = stats[i].cycles,
+         .spills = stats[i].spills,
+         .fills = stats[i].fills,
+      };
+      pipe_debug_shader_stats(&ice->dbg, &s);
+   }
+}
+
 static void
 iris_debug_recompile(struct iris_context *ice,
                      struct shader_info *info,
-                     const struct brw_base_prog_key *key)
+                     const struct brw_base_prog_key *key,
+                     uint64_t compile_time_ns)
 {
    struct iris_screen *screen = (struct iris_screen *) ice->ctx.screen;
    const struct gen_device_info *devinfo = &screen->devinfo;
@@ -1014,6 +1038,8 @@ iris_debug_recompile(struct iris_context *ice,
    if (!info)
       return;
 
+   brw_recompile_stats_add_time(c, info->stage, compile_time_ns);
+
    c->shader_perf_log(&ice->dbg, "Recompiling %s shader for program %s: %s\n",
                       _mesa_shader_stage_to_string(info->stage),
                       info->name ? info->name : "(no identifier)",
@@ -1079,6 +1105,7 @@ iris_compile_vs(struct iris_context *ice,
    const struct brw_compiler *compiler = screen->compiler;
    const struct gen_device_info *devinfo = &screen->devinfo;
    void *mem_ctx = ralloc_context(NULL);
+   const int64_t start_time = os_time_get_nano();
    struct brw_vs_prog_data *vs_prog_data =
       rzalloc(mem_ctx, struct brw_vs_prog_data);
    struct brw_vue_prog_data *vue_prog_data = &vs_prog_data->base;
@@ -1116,18 +1143,22 @@ iris_compile_vs(struct iris_context *ice,
 
    struct brw_vs_prog_key brw_key = iris_to_brw_vs_key(devinfo, key);
 
+   struct brw_compile_stats stats[3] = {};
    char *error_str = NULL;
    const unsigned *program =
       brw_compile_vs(compiler, &ice->dbg, mem_ctx, &brw_key, vs_prog_data,
-                     nir, -1, NULL, &error_str);
+                     nir, -1, stats, &error_str);
    if (program == NULL) {
       dbg_printf("Failed to compile vertex shader: %s\n", error_str);
       ralloc_free(mem_ctx);
       return false;
    }
 
+   iris_debug_shader_stats(ice, MESA_SHADER_VERTEX, stats);
+
    if (ish->compiled_once) {
-      iris_debug_recompile(ice, &nir->info, &brw_key.base);
+      iris_debug_recompile(ice, &nir->info, &brw_key.base,
+                           os_time_get_nano() - start_time);
    } else {
       ish->compiled_once = true;
    }
@@ -1263,6 +1294,7 @@ iris_compile_tcs(struct iris_context *ice,
    const struct nir_shader_compiler_options *options =
       compiler->glsl_compiler_options[MESA_SHADER_TESS_CTRL].NirOptions;
    void *mem_ctx = ralloc_context(NULL);
+   const int64_t start_time = os_time_get_nano();
    struct brw_tcs_prog_data *tcs_prog_data =
       rzalloc(mem_ctx, struct brw_tcs_prog_data);
    struct brw_vue_prog_data *vue_prog_data = &tcs_prog_data->base;
@@ -1324,19 +1356,23 @@ iris_compile_tcs(struct iris_context *ice,
       prog_data->ubo_ranges[0].length = 1;
    }
 
+   struct brw_compile_stats stats[3] = {};
    char *error_str = NULL;
    const unsigned *program =
       brw_compile_tcs(compiler, &ice->dbg, mem_ctx, &brw_key, tcs_prog_data,
-                      nir, -1, NULL, &error_str);
+                      nir, -1, stats, &error_str);
    if (program == NULL) {
       dbg_printf("Failed to compile control shader: %s\n", error_str);
       ralloc_free(mem_ctx);
       return false;
    }
 
+   iris_debug_shader_stats(ice, MESA_SHADER_TESS_CTRL, stats);
+
    if (ish) {
       if (ish->compiled_once) {
-         iris_debug_recompile(ice, &nir->info, &brw_key.base);
+         iris_debug_recompile(ice, &nir->info, &brw_key.base,
+                              os_time_get_nano() - start_time);
       } else {
          ish->compiled_once = true;
       }
@@ -1414,6 +1450,7 @@ iris_compile_tes(struct iris_context *ice,
    struct iris_screen *screen = (struct iris_screen *)ice->ctx.screen;
    const struct brw_compiler *compiler = screen->compiler;
    void *mem_ctx = ralloc_context(NULL);
+   const int64_t start_time = os_time_get_nano();
    struct brw_tes_prog_data *tes_prog_data =
       rzalloc(mem_ctx, struct brw_tes_prog_data);
    struct brw_vue_prog_data *vue_prog_data = &tes_prog_data->base;
@@ -1450,18 +1487,22 @@ iris_compile_tes(struct iris_context *ice,
 
    struct brw_tes_prog_key brw_key = iris_to_brw_tes_key(devinfo, key);
 
+   struct brw_compile_stats stats[3] = {};
    char *error_str = NULL;
    const unsigned *program =
       brw_compile_tes(compiler, &ice->dbg, mem_ctx, &brw_key, &input_vue_map,
-                      tes_prog_data, nir, -1, NULL, &error_str);
+                      tes_prog_data, nir, -1, stats, &error_str);
    if (program == NULL) {
       dbg_printf("Failed to compile evaluation shader: %s\n", error_str);
       ralloc_free(mem_ctx);
       return false;
    }
 
+   iris_debug_shader_stats(ice, MESA_SHADER_TESS_EVAL, stats);
+
    if (ish->compiled_once) {
-      iris_debug_recompile(ice, &nir->info, &brw_key.base);
+      iris_debug_recompile(ice, &nir->info, &brw_key.base,
+                           os_time_get_nano() - start_time);
    } else {
       ish->compiled_once = true;
    }
@@ -1537,6 +1578,7 @@ iris_compile_gs(struct iris_context *ice,
    const struct brw_compiler *compiler = screen->compiler;
    const struct gen_device_info *devinfo = &screen->devinfo;
    void *mem_ctx = ralloc_context(NULL);
+   const int64_t start_time = os_time_get_nano();
    struct brw_gs_prog_data *gs_prog_data =
       rzalloc(mem_ctx, struct brw_gs_prog_data);
    struct brw_vue_prog_data *vue_prog_data = &gs_prog_data->base;
@@ -1572,18 +1614,22 @@ iris_compile_gs(struct iris_context *ice,
 
    struct brw_gs_prog_key brw_key = iris_to_brw_gs_key(devinfo, key);
 
+   struct brw_compile_stats stats[3] = {};
    char *error_str = NULL;
    const unsigned *program =
       brw_compile_gs(compiler, &ice->dbg, mem_ctx, &brw_key, gs_prog_data,
-                     nir, NULL, -1, NULL, &error_str);
+                     nir, NULL, -1, stats, &error_str);
    if (program == NULL) {
       dbg_printf("Failed to compile geometry shader: %s\n", error_str);
       ralloc_free(mem_ctx);
       return false;
    }
 
+   iris_debug_shader_stats(ice, MESA_SHADER_GEOMETRY, stats);
+
    if (ish->compiled_once) {
-      iris_debug_recompile(ice, &nir->info, &brw_key.base);
+      iris_debug_recompile(ice, &nir->info, &brw_key.base,
+                           os_time_get_nano() - start_time);
    } else {
       ish->compiled_once = true;
    }
@@ -1653,6 +1699,7 @@ iris_compile_fs(struct iris_context *ice,
    struct iris_screen *screen = (struct iris_screen *)ice->ctx.screen;
    const struct brw_compiler *compiler = screen->compiler;
    void *mem_ctx = ralloc_context(NULL);
+   const int64_t start_time = os_time_get_nano();
    struct brw_wm_prog_data *fs_prog_data =
       rzalloc(mem_ctx, struct brw_wm_prog_data);
    struct brw_stage_prog_data *prog_data = &fs_prog_data->base;
@@ -1690,19 +1737,23 @@ iris_compile_fs(struct iris_context *ice,
 
    struct brw_wm_prog_key brw_key = iris_to_brw_fs_key(devinfo, key);
 
+   struct brw_compile_stats stats[3] = {};
    char *error_str = NULL;
    const unsigned *program =
       brw_compile_fs(compiler, &ice->dbg, mem_ctx, &brw_key, fs_prog_data,
                      nir, -1, -1, -1, true, false, vue_map,
-                     NULL, &error_str);
+                     stats, &error_str);
    if (program == NULL) {
       dbg_printf("Failed to compile fragment shader: %s\n", error_str);
       ralloc_free(mem_ctx);
       return false;
    }
 
+   iris_debug_shader_stats(ice, MESA_SHADER_FRAGMENT, stats);
+
    if (ish->compiled_once) {
-      iris_debug_recompile(ice, &nir->info, &brw_key.base);
+      iris_debug_recompile(ice, &nir->info, &brw_key.base,
+                           os_time_get_nano() - start_time);
    } else {
       ish->compiled_once = true;
    }
@@ -1952,6 +2003,7 @@ iris_compile_cs(struct iris_context *ice,
    struct iris_screen *screen = (struct iris_screen *)ice->ctx.screen;
    const struct brw_compiler *compiler = screen->compiler;
    void *mem_ctx = ralloc_context(NULL);
+   const int64_t start_time = os_time_get_nano();
    struct brw_cs_prog_data *cs_prog_data =
       rzalloc(mem_ctx, struct brw_cs_prog_data);
    struct brw_stage_prog_data *prog_data = &cs_prog_data->base;
@@ -1973,18 +2025,22 @@ iris_compile_cs(struct iris_context *ice,
 
    struct brw_cs_prog_key brw_key = iris_to_brw_cs_key(devinfo, key);
 
+   struct brw_compile_stats stats[3] = {};
    char *error_str = NULL;
    const unsigned *program =
       brw_compile_cs(compiler, &ice->dbg, mem_ctx, &brw_key, cs_prog_data,
-                     nir, -1, NULL, &error_str);
+                     nir, -1, stats, &error_str);
    if (program == NULL) {
       dbg_printf("Failed to compile compute shader: %s\n", error_str);
       ralloc_free(mem_ctx);
       return false;
    }
 
+   iris_debug_shader_stats(ice, MESA_SHADER_COMPUTE, stats);
+
    if (ish->compiled_once) {
-      iris_debug_recompile(ice, &nir->info, &brw_key.base);
+      iris_debug_recompile(ice, &nir->info, &brw_key.base,
+                           os_time_get_nano() - start_time);
    } else {
       ish->compiled_once = true;
    }
@@ -2162,7 +2218,10 @@ iris_create_uncompiled_shader(struct pipe_context *ctx,
               &ish->uses_atomic_load_store);
    NIR_PASS_V(nir, iris_lower_storage_image_derefs);
 
-   nir_sweep(nir);
+   /* This NIR is kept around for the lifetime of the shader, and each variant
+    * is cloned from it, so make it compact rather than merely sweeping it.
+    */
+   nir_shader_compact(nir);
 
    if (nir->constant_data_size > 0) {
       unsigned data_offset;
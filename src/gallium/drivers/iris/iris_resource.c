@@ -823,7 +823,11 @@ iris_resource_create_for_buffer(struct pipe_screen *pscreen,
       name = "dynamic state";
    }
 
-   res->bo = iris_bo_alloc(screen->bufmgr, name, templ->width0, memzone);
+   /* Small buffers share a slab BO, unless they may be exported. */
+   unsigned flags = templ->bind & PIPE_BIND_SHARED ? 0 : BO_ALLOC_SUBALLOC;
+
+   res->bo = iris_bo_alloc_tiled(screen->bufmgr, name, templ->width0, 1,
+                                 memzone, I915_TILING_NONE, 0, flags);
    if (!res->bo) {
       iris_resource_destroy(pscreen, &res->base);
       return NULL;
@@ -1355,8 +1359,10 @@ iris_invalidate_resource(struct pipe_context *ctx,
 
    struct iris_bo *old_bo = res->bo;
    struct iris_bo *new_bo =
-      iris_bo_alloc(screen->bufmgr, res->bo->name, resource->width0,
-                    iris_memzone_for_address(old_bo->gtt_offset));
+      iris_bo_alloc_tiled(screen->bufmgr, res->bo->name, resource->width0, 1,
+                          iris_memzone_for_address(old_bo->gtt_offset),
+                          I915_TILING_NONE, 0,
+                          iris_bo_is_slab(old_bo) ? BO_ALLOC_SUBALLOC : 0);
    if (!new_bo)
       return;
 
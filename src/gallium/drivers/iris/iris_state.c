@@ -96,6 +96,7 @@
 #include "util/u_upload_mgr.h"
 #include "util/u_viewport.h"
 #include "util/u_memory.h"
+#include "util/u_cpu_trace.h"
 #include "drm-uapi/i915_drm.h"
 #include "nir.h"
 #include "intel/compiler/brw_compiler.h"
@@ -5391,6 +5392,17 @@ emit_push_constant_packet_all(struct iris_context *ice,
 }
 #endif
 
+/**
+ * Return a mask of the render stages with \p vs_bit set in \p stage_dirty,
+ * where \p vs_bit is the IRIS_STAGE_DIRTY_*_VS flag of a per-stage group.
+ */
+static inline uint32_t
+render_stages_dirty(uint64_t stage_dirty, uint64_t vs_bit)
+{
+   return (stage_dirty >> (ffsll(vs_bit) - 1)) &
+          BITFIELD_MASK(MESA_SHADER_FRAGMENT + 1);
+}
+
 static void
 iris_upload_dirty_render_state(struct iris_context *ice,
                                struct iris_batch *batch,
@@ -5599,11 +5611,12 @@ iris_upload_dirty_render_state(struct iris_context *ice,
    uint32_t nobuffer_stages = 0;
 #endif
 
-   for (int stage = 0; stage <= MESA_SHADER_FRAGMENT; stage++) {
-      if (!(stage_dirty & (IRIS_STAGE_DIRTY_CONSTANTS_VS << stage)) &&
-          !emit_const_wa)
-         continue;
+   uint32_t const_stages = emit_const_wa ?
+      BITFIELD_MASK(MESA_SHADER_FRAGMENT + 1) :
+      render_stages_dirty(stage_dirty, IRIS_STAGE_DIRTY_CONSTANTS_VS);
 
+   while (const_stages) {
+      const int stage = u_bit_scan(&const_stages);
       struct iris_shader_state *shs = &ice->state.shaders[stage];
       struct iris_compiled_shader *shader = ice->shaders.prog[stage];
 
@@ -5642,18 +5655,20 @@ iris_upload_dirty_render_state(struct iris_context *ice,
       emit_push_constant_packet_all(ice, batch, nobuffer_stages, NULL);
 #endif
 
-   for (int stage = 0; stage <= MESA_SHADER_FRAGMENT; stage++) {
-      /* Gen9 requires 3DSTATE_BINDING_TABLE_POINTERS_XS to be re-emitted
-       * in order to commit constants.  TODO: Investigate "Disable Gather
-       * at Set Shader" to go back to legacy mode...
-       */
-      if (stage_dirty & ((IRIS_STAGE_DIRTY_BINDINGS_VS |
-                          (GEN_GEN == 9 ? IRIS_STAGE_DIRTY_CONSTANTS_VS : 0))
-                            << stage)) {
-         iris_emit_cmd(batch, GENX(3DSTATE_BINDING_TABLE_POINTERS_VS), ptr) {
-            ptr._3DCommandSubOpcode = 38 + stage;
-            ptr.PointertoVSBindingTable = binder->bt_offset[stage];
-         }
+   /* Gen9 requires 3DSTATE_BINDING_TABLE_POINTERS_XS to be re-emitted
+    * in order to commit constants.  TODO: Investigate "Disable Gather
+    * at Set Shader" to go back to legacy mode...
+    */
+   uint32_t btp_stages =
+      render_stages_dirty(stage_dirty, IRIS_STAGE_DIRTY_BINDINGS_VS) |
+      (GEN_GEN == 9 ?
+       render_stages_dirty(stage_dirty, IRIS_STAGE_DIRTY_CONSTANTS_VS) : 0);
+
+   while (btp_stages) {
+      const int stage = u_bit_scan(&btp_stages);
+      iris_emit_cmd(batch, GENX(3DSTATE_BINDING_TABLE_POINTERS_VS), ptr) {
+         ptr._3DCommandSubOpcode = 38 + stage;
+         ptr.PointertoVSBindingTable = binder->bt_offset[stage];
       }
    }
 
@@ -5675,15 +5690,20 @@ iris_upload_dirty_render_state(struct iris_context *ice,
                                    PIPE_CONTROL_STALL_AT_SCOREBOARD);
    }
 
-   for (int stage = 0; stage <= MESA_SHADER_FRAGMENT; stage++) {
-      if (stage_dirty & (IRIS_STAGE_DIRTY_BINDINGS_VS << stage)) {
-         iris_populate_binding_table(ice, batch, stage, false);
-      }
+   uint32_t bt_stages =
+      render_stages_dirty(stage_dirty, IRIS_STAGE_DIRTY_BINDINGS_VS);
+
+   while (bt_stages) {
+      const int stage = u_bit_scan(&bt_stages);
+      iris_populate_binding_table(ice, batch, stage, false);
    }
 
-   for (int stage = 0; stage <= MESA_SHADER_FRAGMENT; stage++) {
-      if (!(stage_dirty & (IRIS_STAGE_DIRTY_SAMPLER_STATES_VS << stage)) ||
-          !ice->shaders.prog[stage])
+   uint32_t sampler_stages =
+      render_stages_dirty(stage_dirty, IRIS_STAGE_DIRTY_SAMPLER_STATES_VS);
+
+   while (sampler_stages) {
+      const int stage = u_bit_scan(&sampler_stages);
+      if (!ice->shaders.prog[stage])
          continue;
 
       iris_upload_sampler_states(ice, stage);
@@ -5719,10 +5739,11 @@ iris_upload_dirty_render_state(struct iris_context *ice,
       }
    }
 
-   for (int stage = 0; stage <= MESA_SHADER_FRAGMENT; stage++) {
-      if (!(stage_dirty & (IRIS_STAGE_DIRTY_VS << stage)))
-         continue;
+   uint32_t shader_stages =
+      render_stages_dirty(stage_dirty, IRIS_STAGE_DIRTY_VS);
 
+   while (shader_stages) {
+      const int stage = u_bit_scan(&shader_stages);
       struct iris_compiled_shader *shader = ice->shaders.prog[stage];
 
       if (shader) {
@@ -6358,6 +6379,7 @@ iris_upload_render_state(struct iris_context *ice,
                          struct iris_batch *batch,
                          const struct pipe_draw_info *draw)
 {
+   UTIL_CPU_TRACE_FUNC();
    bool use_predicate = ice->state.predicate == IRIS_PREDICATE_STATE_USE_BIT;
 
    iris_batch_sync_region_start(batch);
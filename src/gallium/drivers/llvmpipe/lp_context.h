@@ -108,6 +108,12 @@ struct llvmpipe_context {
 
    unsigned active_primgen_queries;
 
+   /** Counters sampled by the driver specific queries, see lp_query.h */
+   struct {
+      uint64_t scenes;
+      uint64_t jit_time;   /**< in microseconds, updated atomically */
+   } counters;
+
    bool queries_disabled;
 
    unsigned dirty; /**< Mask of LP_NEW_x flags */
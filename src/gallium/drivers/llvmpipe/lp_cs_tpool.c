@@ -28,10 +28,70 @@
  * based on threadpool.c but modified heavily to be compute shader tuned.
  */
 
+#include "util/u_atomic.h"
 #include "util/u_thread.h"
+#include "util/u_math.h"
 #include "util/u_memory.h"
 #include "lp_cs_tpool.h"
 
+#if defined(PIPE_ARCH_SSE)
+#include <xmmintrin.h>
+#endif
+
+/* How long threads poll for more work before going to sleep.  Dispatches
+ * tend to come in bursts, and for short grids the wakeup would otherwise
+ * cost more than the work itself.  A few tens of microseconds.
+ */
+#define LP_CS_TPOOL_SPIN_COUNT 4096
+
+static inline void
+lp_cs_tpool_relax(void)
+{
+#if defined(PIPE_ARCH_SSE)
+   _mm_pause();
+#endif
+}
+
+/* Run chunks of the task's iterations until all have been claimed,
+ * returns how many were run.
+ */
+static unsigned
+lp_cs_tpool_run_chunks(struct lp_cs_tpool_task *task,
+                       struct lp_cs_local_mem *lmem)
+{
+   unsigned done = 0;
+
+   for (;;) {
+      unsigned start = p_atomic_add_return(&task->iter_start,
+                                           task->iter_chunk) - task->iter_chunk;
+      if (start >= task->iter_total)
+         break;
+
+      unsigned end = MIN2(start + task->iter_chunk, task->iter_total);
+      for (unsigned i = start; i < end; i++)
+         task->work(task->data, i, lmem);
+      done += end - start;
+   }
+   return done;
+}
+
+/* Called with the pool mutex held once a thread ran out of iterations. */
+static void
+lp_cs_tpool_task_done(struct lp_cs_tpool *pool,
+                      struct lp_cs_tpool_task *task, unsigned done)
+{
+   /* Everything is claimed, don't hand the task out anymore. */
+   if (!list_is_empty(&task->list)) {
+      list_delinit(&task->list);
+      p_atomic_dec(&pool->pending);
+   }
+
+   task->workers--;
+   p_atomic_add(&task->iter_finished, done);
+   if (task->iter_finished == task->iter_total && !task->workers)
+      cnd_broadcast(&task->finish);
+}
+
 static int
 lp_cs_tpool_worker(void *data)
 {
@@ -43,26 +103,29 @@ lp_cs_tpool_worker(void *data)
 
    while (!pool->shutdown) {
       struct lp_cs_tpool_task *task;
-
-      while (list_is_empty(&pool->workqueue) && !pool->shutdown)
-         cnd_wait(&pool->new_work, &pool->m);
-
-      if (pool->shutdown)
-         break;
+      unsigned done;
+
+      if (list_is_empty(&pool->workqueue)) {
+         mtx_unlock(&pool->m);
+         for (unsigned i = 0; i < LP_CS_TPOOL_SPIN_COUNT &&
+                              !p_atomic_read(&pool->pending); i++)
+            lp_cs_tpool_relax();
+         mtx_lock(&pool->m);
+
+         while (list_is_empty(&pool->workqueue) && !pool->shutdown)
+            cnd_wait(&pool->new_work, &pool->m);
+         continue;
+      }
 
       task = list_first_entry(&pool->workqueue, struct lp_cs_tpool_task,
                               list);
-      unsigned this_iter = task->iter_start++;
-
-      if (task->iter_start == task->iter_total)
-         list_del(&task->list);
+      task->workers++;
 
       mtx_unlock(&pool->m);
-      task->work(task->data, this_iter, &lmem);
+      done = lp_cs_tpool_run_chunks(task, &lmem);
       mtx_lock(&pool->m);
-      task->iter_finished++;
-      if (task->iter_finished == task->iter_total)
-         cnd_broadcast(&task->finish);
+
+      lp_cs_tpool_task_done(pool, task, done);
    }
    mtx_unlock(&pool->m);
    FREE(lmem.local_mem_ptr);
@@ -131,11 +194,16 @@ lp_cs_tpool_queue_task(struct lp_cs_tpool *pool,
    task->work = work;
    task->data = data;
    task->iter_total = num_iters;
+   /* A few chunks per thread, counting the waiting one, balances uneven
+    * groups without going back to the atomic for every one of them.
+    */
+   task->iter_chunk = MAX2(num_iters / (4 * (pool->num_threads + 1)), 1);
    cnd_init(&task->finish);
 
    mtx_lock(&pool->m);
 
    list_addtail(&task->list, &pool->workqueue);
+   p_atomic_inc(&pool->pending);
 
    cnd_broadcast(&pool->new_work);
    mtx_unlock(&pool->m);
@@ -147,12 +215,32 @@ lp_cs_tpool_wait_for_task(struct lp_cs_tpool *pool,
                           struct lp_cs_tpool_task **task_handle)
 {
    struct lp_cs_tpool_task *task = *task_handle;
+   struct lp_cs_local_mem lmem;
+   unsigned done;
 
    if (!pool || !task)
       return;
 
+   /* Rather than sleeping, help with the iterations still unclaimed. */
+   memset(&lmem, 0, sizeof(lmem));
+   mtx_lock(&pool->m);
+   task->workers++;
+   mtx_unlock(&pool->m);
+
+   done = lp_cs_tpool_run_chunks(task, &lmem);
+
+   mtx_lock(&pool->m);
+   lp_cs_tpool_task_done(pool, task, done);
+   mtx_unlock(&pool->m);
+   FREE(lmem.local_mem_ptr);
+
+   /* The last chunks are usually about to finish. */
+   for (unsigned i = 0; i < LP_CS_TPOOL_SPIN_COUNT &&
+                        p_atomic_read(&task->iter_finished) < task->iter_total; i++)
+      lp_cs_tpool_relax();
+
    mtx_lock(&pool->m);
-   while (task->iter_finished < task->iter_total)
+   while (task->iter_finished < task->iter_total || task->workers)
       cnd_wait(&task->finish, &pool->m);
    mtx_unlock(&pool->m);
 
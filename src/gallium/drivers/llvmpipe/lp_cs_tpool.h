@@ -28,6 +28,8 @@
  * The item is added to the work queue once, but it must execute
  * number of iterations times. This saves storing a bunch of queue
  * structs with just unique indexes in them.
+ * Threads claim the iterations in chunks with an atomic add, and the
+ * thread waiting for the task works on it too.
  * It also supports a local memory support struct to be passed from
  * outside the thread exec function.
  */
@@ -48,6 +50,7 @@ struct lp_cs_tpool {
    thrd_t threads[LP_MAX_THREADS];
    unsigned num_threads;
    struct list_head workqueue;
+   unsigned pending; /* tasks in workqueue, read unlocked when spinning */
    bool shutdown;
 };
 
@@ -64,8 +67,10 @@ struct lp_cs_tpool_task {
    struct list_head list;
    cnd_t finish;
    unsigned iter_total;
-   unsigned iter_start;
-   unsigned iter_finished;
+   unsigned iter_chunk;    /* iterations claimed at once */
+   unsigned iter_start;    /* next iteration to claim, atomic */
+   unsigned iter_finished; /* protected by the pool mutex */
+   unsigned workers;       /* threads on the task, protected by the mutex */
 };
 
 struct lp_cs_tpool *lp_cs_tpool_create(unsigned num_threads);
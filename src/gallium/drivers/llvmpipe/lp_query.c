@@ -32,6 +32,7 @@
 
 #include "draw/draw_context.h"
 #include "pipe/p_defines.h"
+#include "util/u_atomic.h"
 #include "util/u_memory.h"
 #include "util/os_time.h"
 #include "lp_context.h"
@@ -53,15 +54,22 @@ llvmpipe_create_query(struct pipe_context *pipe,
                       unsigned type,
                       unsigned index)
 {
+   struct llvmpipe_screen *screen = llvmpipe_screen(pipe->screen);
+   unsigned num_threads = MAX2(1, screen->num_threads);
    struct llvmpipe_query *pq;
 
-   assert(type < PIPE_QUERY_TYPES);
+   assert(type < PIPE_QUERY_TYPES ||
+          (type >= PIPE_QUERY_DRIVER_SPECIFIC && type < LP_QUERY_TYPE_END));
 
-   pq = CALLOC_STRUCT( llvmpipe_query );
+   /* The per-thread counters are stored right after the query. */
+   pq = CALLOC(1, sizeof(*pq) + 2 * num_threads * sizeof(uint64_t));
 
    if (pq) {
       pq->type = type;
       pq->index = index;
+      pq->num_threads = num_threads;
+      pq->start = (uint64_t *)(pq + 1);
+      pq->end = pq->start + num_threads;
    }
 
    return (struct pipe_query *) pq;
@@ -90,6 +98,62 @@ llvmpipe_destroy_query(struct pipe_context *pipe, struct pipe_query *q)
 }
 
 
+/**
+ * Current value of the counters of the LP_QUERY_* types which aren't
+ * counted by the rasterizer.
+ */
+static uint64_t
+llvmpipe_sample_counter(struct llvmpipe_context *llvmpipe, unsigned type)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(llvmpipe->pipe.screen);
+
+   switch (type) {
+   case LP_QUERY_SCENES:
+      return llvmpipe->counters.scenes;
+   case LP_QUERY_JIT_TIME:
+      return p_atomic_read(&llvmpipe->counters.jit_time);
+   case LP_QUERY_RAST_IDLE_TIME:
+      /* The rasterizer threads are shared by all the contexts. */
+      return lp_rast_get_idle_time(screen->rast) / 1000;
+   default:
+      assert(0);
+      return 0;
+   }
+}
+
+
+/**
+ * Result of the LP_QUERY_* types.
+ */
+static uint64_t
+llvmpipe_driver_query_result(const struct llvmpipe_query *pq)
+{
+   uint64_t value = 0;
+   unsigned i;
+
+   switch (pq->type) {
+   case LP_QUERY_TILES:
+   case LP_QUERY_FULL_BLOCKS:
+   case LP_QUERY_PARTIAL_BLOCKS:
+      for (i = 0; i < pq->num_threads; i++) {
+         value += pq->end[i];
+      }
+      break;
+   case LP_QUERY_FS_INVOCATIONS:
+      for (i = 0; i < pq->num_threads; i++) {
+         value += pq->end[i];
+      }
+      value *= LP_RASTER_BLOCK_SIZE * LP_RASTER_BLOCK_SIZE;
+      break;
+   default:
+      value = pq->end[0];
+      break;
+   }
+
+   return value;
+}
+
+
 static bool
 llvmpipe_get_query_result(struct pipe_context *pipe, 
                           struct pipe_query *q,
@@ -183,6 +247,10 @@ llvmpipe_get_query_result(struct pipe_context *pipe,
    }
       break;
    default:
+      if (pq->type >= PIPE_QUERY_DRIVER_SPECIFIC) {
+         *result = llvmpipe_driver_query_result(pq);
+         break;
+      }
       assert(0);
       break;
    }
@@ -309,6 +377,10 @@ llvmpipe_get_query_result_resource(struct pipe_context *pipe,
          }
          break;
       default:
+         if (pq->type >= PIPE_QUERY_DRIVER_SPECIFIC) {
+            value = llvmpipe_driver_query_result(pq);
+            break;
+         }
          fprintf(stderr, "Unknown query type %d\n", pq->type);
          break;
       }
@@ -360,8 +432,8 @@ llvmpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
    }
 
 
-   memset(pq->start, 0, sizeof(pq->start));
-   memset(pq->end, 0, sizeof(pq->end));
+   memset(pq->start, 0, pq->num_threads * sizeof(*pq->start));
+   memset(pq->end, 0, pq->num_threads * sizeof(*pq->end));
    lp_setup_begin_query(llvmpipe->setup, pq);
 
    switch (pq->type) {
@@ -401,6 +473,11 @@ llvmpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
       llvmpipe->active_occlusion_queries++;
       llvmpipe->dirty |= LP_NEW_OCCLUSION_QUERY;
       break;
+   case LP_QUERY_SCENES:
+   case LP_QUERY_JIT_TIME:
+   case LP_QUERY_RAST_IDLE_TIME:
+      pq->start[0] = llvmpipe_sample_counter(llvmpipe, pq->type);
+      break;
    default:
       break;
    }
@@ -480,6 +557,11 @@ llvmpipe_end_query(struct pipe_context *pipe, struct pipe_query *q)
       llvmpipe->active_occlusion_queries--;
       llvmpipe->dirty |= LP_NEW_OCCLUSION_QUERY;
       break;
+   case LP_QUERY_SCENES:
+   case LP_QUERY_JIT_TIME:
+   case LP_QUERY_RAST_IDLE_TIME:
+      pq->end[0] = llvmpipe_sample_counter(llvmpipe, pq->type) - pq->start[0];
+      break;
    default:
       break;
    }
@@ -517,6 +599,40 @@ llvmpipe_set_active_query_state(struct pipe_context *pipe, bool enable)
    llvmpipe->dirty |= LP_NEW_OCCLUSION_QUERY;
 }
 
+#define LP_QUERY_INFO(_name, _query_type, _type) {                   \
+   .name        = _name,                                            \
+   .query_type  = LP_QUERY_ ## _query_type,                         \
+   .type        = PIPE_DRIVER_QUERY_TYPE_ ## _type,                 \
+   .result_type = PIPE_DRIVER_QUERY_RESULT_TYPE_AVERAGE,            \
+   .group_id    = ~(unsigned)0,                                     \
+}
+
+static const struct pipe_driver_query_info lp_driver_queries[] = {
+   LP_QUERY_INFO("llvmpipe-tiles", TILES, UINT64),
+   LP_QUERY_INFO("llvmpipe-full-blocks", FULL_BLOCKS, UINT64),
+   LP_QUERY_INFO("llvmpipe-partial-blocks", PARTIAL_BLOCKS, UINT64),
+   LP_QUERY_INFO("llvmpipe-fs-invocations", FS_INVOCATIONS, UINT64),
+   LP_QUERY_INFO("llvmpipe-scenes", SCENES, UINT64),
+   LP_QUERY_INFO("llvmpipe-jit-time", JIT_TIME, MICROSECONDS),
+   LP_QUERY_INFO("llvmpipe-rast-idle-time", RAST_IDLE_TIME, MICROSECONDS),
+};
+
+
+int
+llvmpipe_get_driver_query_info(struct pipe_screen *screen, unsigned index,
+                               struct pipe_driver_query_info *info)
+{
+   if (!info)
+      return ARRAY_SIZE(lp_driver_queries);
+
+   if (index >= ARRAY_SIZE(lp_driver_queries))
+      return 0;
+
+   *info = lp_driver_queries[index];
+   return 1;
+}
+
+
 void llvmpipe_init_query_funcs(struct llvmpipe_context *llvmpipe )
 {
    llvmpipe->pipe.create_query = llvmpipe_create_query;
@@ -35,15 +35,53 @@
 
 #include <limits.h>
 #include "os/os_thread.h"
+#include "pipe/p_defines.h"
 #include "lp_limits.h"
 
 
 struct llvmpipe_context;
+struct pipe_screen;
+struct pipe_driver_query_info;
+
+
+/**
+ * Driver specific queries, mostly for the HUD.
+ */
+enum lp_query_type {
+   /* Counted per tile by the rasterizer threads, like occlusion queries */
+   LP_QUERY_TILES = PIPE_QUERY_DRIVER_SPECIFIC,
+   LP_QUERY_FULL_BLOCKS,
+   LP_QUERY_PARTIAL_BLOCKS,
+   LP_QUERY_FS_INVOCATIONS,
+
+   /* Sampled by the context when the query begins and ends */
+   LP_QUERY_SCENES,
+   LP_QUERY_JIT_TIME,
+   LP_QUERY_RAST_IDLE_TIME,
+
+   LP_QUERY_TYPE_END
+};
+
+
+/**
+ * Whether the query is counted by the rasterizer, with begin/end commands
+ * binned like for the occlusion queries.
+ */
+static inline boolean
+lp_query_is_binned(unsigned type)
+{
+   return type == PIPE_QUERY_OCCLUSION_COUNTER ||
+          type == PIPE_QUERY_OCCLUSION_PREDICATE ||
+          type == PIPE_QUERY_OCCLUSION_PREDICATE_CONSERVATIVE ||
+          type == PIPE_QUERY_PIPELINE_STATISTICS ||
+          (type >= LP_QUERY_TILES && type <= LP_QUERY_FS_INVOCATIONS);
+}
 
 
 struct llvmpipe_query {
-   uint64_t start[LP_MAX_THREADS];  /* start count value for each thread */
-   uint64_t end[LP_MAX_THREADS];    /* end count value for each thread */
+   uint64_t *start;                 /* start count value for each thread */
+   uint64_t *end;                   /* end count value for each thread */
+   unsigned num_threads;            /* size of the start and end arrays */
    struct lp_fence *fence;          /* fence from last scene this was binned in */
    unsigned type;                   /* PIPE_QUERY_* */
    unsigned index;
@@ -58,4 +96,8 @@ extern void llvmpipe_init_query_funcs(struct llvmpipe_context * );
 
 extern boolean llvmpipe_check_render_cond(struct llvmpipe_context *);
 
+extern int
+llvmpipe_get_driver_query_info(struct pipe_screen *screen, unsigned index,
+                               struct pipe_driver_query_info *info);
+
 #endif /* LP_QUERY_H */
@@ -33,7 +33,9 @@
 #include "util/u_pack_color.h"
 #include "util/u_string.h"
 #include "util/u_thread.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_memset.h"
+#include "util/u_atomic.h"
 #include "util/os_time.h"
 
 #include "lp_scene_queue.h"
@@ -78,12 +80,25 @@ lp_rast_begin( struct lp_rasterizer *rast,
 }
 
 
+/**
+ * Finish rasterizing a scene.
+ * Called once per scene by one thread, after all threads are done with it.
+ */
 static void
 lp_rast_end( struct lp_rasterizer *rast )
 {
-   lp_scene_end_rasterization( rast->curr_scene );
+   struct lp_scene *scene = rast->curr_scene;
+
+   lp_scene_end_rasterization( scene );
 
    rast->curr_scene = NULL;
+
+   /* The setup module may rebin the scene as soon as this is signalled,
+    * so don't touch it afterwards.
+    */
+   if (scene->fence) {
+      lp_fence_signal(scene->fence);
+   }
 }
 
 
@@ -112,6 +127,9 @@ lp_rast_tile_begin(struct lp_rasterizer_task *task,
 
    task->thread_data.vis_counter = 0;
    task->thread_data.ps_invocations = 0;
+   task->full_blocks = 0;
+   task->partial_blocks = 0;
+   task->zmax = INFINITY;
 
    for (i = 0; i < task->scene->fb.nr_cbufs; i++) {
       if (task->scene->fb.cbufs[i]) {
@@ -292,7 +310,78 @@ lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
             dst_layer += scene->zsbuf.layer_stride;
          }
       }
+
+      /* A depth clear bounds the whole tile. */
+      uint64_t zmask64 = util_pack64_mask_z(scene->fb.zsbuf->format,
+                                            0xffffffff);
+      if (zmask64 && (clear_mask64 & zmask64) == zmask64 &&
+          scene->fb_max_layer == 0) {
+         float z;
+         util_format_unpack_z_float(scene->fb.zsbuf->format, &z,
+                                    &arg.clear_zstencil.value, 1);
+         task->zmax = z;
+      }
+   }
+}
+
+
+/**
+ * Depth range of the plane of the position z across the current tile,
+ * widened by a pixel on each side to cover the rounding of the jit
+ * interpolation.
+ */
+static void
+lp_rast_tile_z_range(const struct lp_rasterizer_task *task,
+                     const struct lp_rast_shader_inputs *inputs,
+                     float *zmin, float *zmax)
+{
+   const float (*a0)[4] = (const float (*)[4]) GET_A0(inputs);
+   const float (*dadx)[4] = (const float (*)[4]) GET_DADX(inputs);
+   const float (*dady)[4] = (const float (*)[4]) GET_DADY(inputs);
+   const float x0 = (float) task->x - 1.0f;
+   const float x1 = (float) (task->x + task->width) + 1.0f;
+   const float y0 = (float) task->y - 1.0f;
+   const float y1 = (float) (task->y + task->height) + 1.0f;
+   const float dx0 = dadx[0][2] * x0, dx1 = dadx[0][2] * x1;
+   const float dy0 = dady[0][2] * y0, dy1 = dady[0][2] * y1;
+
+   *zmin = a0[0][2] + MIN2(dx0, dx1) + MIN2(dy0, dy1);
+   *zmax = a0[0][2] + MAX2(dx0, dx1) + MAX2(dy0, dy1);
+}
+
+
+/**
+ * Coarse depth test of a shading command against task->zmax.
+ *
+ * Variants which only let nearer fragments through can skip the tile when
+ * all of the command's depth values are farther than the tile's farthest
+ * stored one.  Any variant which may store farther values invalidates it.
+ *
+ * \return TRUE if the command can't touch the tile and can be skipped
+ */
+static boolean
+lp_rast_hiz_cull(struct lp_rasterizer_task *task,
+                 const struct lp_rast_shader_inputs *inputs)
+{
+   const struct lp_fragment_shader_variant *variant;
+   float zmin, zmax;
+
+   if (!task->state || inputs->disable)
+      return FALSE;
+
+   variant = task->state->variant;
+   if (variant->hiz_clobber) {
+      task->zmax = INFINITY;
+      return FALSE;
    }
+
+   if (!variant->hiz_test || task->zmax == INFINITY)
+      return FALSE;
+
+   lp_rast_tile_z_range(task, inputs, &zmin, &zmax);
+
+   /* Unorm depth is clamped to 1.0 before the test. */
+   return MIN2(zmin, 1.0f) > task->zmax + task->scene->zmax_margin;
 }
 
 
@@ -327,6 +416,17 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
    }
    variant = state->variant;
 
+   if (variant->hiz_write && scene->fb_max_layer == 0) {
+      /* Whatever passes the depth test is nearer than the plane. */
+      float zmin, zmax;
+      lp_rast_tile_z_range(task, inputs, &zmin, &zmax);
+      if (zmax < task->zmax)
+         task->zmax = zmax;
+   }
+
+   if (variant->blit && lp_rast_blit_tile(task, inputs))
+      return;
+
    /* render the whole 64x64 tile in 4x4 chunks */
    for (y = 0; y < task->height; y += 4){
       for (x = 0; x < task->width; x += 4) {
@@ -368,6 +468,8 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
          /* Propagate non-interpolated raster state. */
          task->thread_data.raster_state.viewport_index = inputs->viewport_index;
 
+         task->full_blocks++;
+
          /* run shader on 4x4 block */
          BEGIN_JIT_CALL(state, task);
          variant->jit_function[RAST_WHOLE]( &state->jit_context,
@@ -476,6 +578,8 @@ lp_rast_shade_quads_mask_sample(struct lp_rasterizer_task *task,
       /* Propagate non-interpolated raster state. */
       task->thread_data.raster_state.viewport_index = inputs->viewport_index;
 
+      task->partial_blocks++;
+
       /* run shader on 4x4 block */
       BEGIN_JIT_CALL(state, task);
       variant->jit_function[RAST_EDGE_TEST](&state->jit_context,
@@ -526,8 +630,18 @@ lp_rast_begin_query(struct lp_rasterizer_task *task,
       pq->start[task->thread_index] = task->thread_data.vis_counter;
       break;
    case PIPE_QUERY_PIPELINE_STATISTICS:
+   case LP_QUERY_FS_INVOCATIONS:
       pq->start[task->thread_index] = task->thread_data.ps_invocations;
       break;
+   case LP_QUERY_FULL_BLOCKS:
+      pq->start[task->thread_index] = task->full_blocks;
+      break;
+   case LP_QUERY_PARTIAL_BLOCKS:
+      pq->start[task->thread_index] = task->partial_blocks;
+      break;
+   case LP_QUERY_TILES:
+      /* counted when the tile or the query ends */
+      break;
    default:
       assert(0);
       break;
@@ -558,10 +672,24 @@ lp_rast_end_query(struct lp_rasterizer_task *task,
       pq->end[task->thread_index] = os_time_get_nano();
       break;
    case PIPE_QUERY_PIPELINE_STATISTICS:
+   case LP_QUERY_FS_INVOCATIONS:
       pq->end[task->thread_index] +=
          task->thread_data.ps_invocations - pq->start[task->thread_index];
       pq->start[task->thread_index] = 0;
       break;
+   case LP_QUERY_FULL_BLOCKS:
+      pq->end[task->thread_index] +=
+         task->full_blocks - pq->start[task->thread_index];
+      pq->start[task->thread_index] = 0;
+      break;
+   case LP_QUERY_PARTIAL_BLOCKS:
+      pq->end[task->thread_index] +=
+         task->partial_blocks - pq->start[task->thread_index];
+      pq->start[task->thread_index] = 0;
+      break;
+   case LP_QUERY_TILES:
+      pq->end[task->thread_index]++;
+      break;
    default:
       assert(0);
       break;
@@ -655,7 +783,24 @@ do_rasterize_bin(struct lp_rasterizer_task *task,
 
    for (block = bin->head; block; block = block->next) {
       for (k = 0; k < block->count; k++) {
-         dispatch[block->cmd[k]]( task, block->arg[k] );
+         const unsigned cmd = block->cmd[k];
+
+         if (task->depth_tile) {
+            const struct lp_rast_shader_inputs *inputs = NULL;
+
+            if (cmd == LP_RAST_OP_SHADE_TILE)
+               inputs = block->arg[k].shade_tile;
+            else if ((cmd >= LP_RAST_OP_TRIANGLE_1 &&
+                      cmd <= LP_RAST_OP_TRIANGLE_4_16) ||
+                     (cmd >= LP_RAST_OP_TRIANGLE_32_1 &&
+                      cmd <= LP_RAST_OP_MS_TRIANGLE_4_16))
+               inputs = &block->arg[k].triangle.tri->inputs;
+
+            if (inputs && lp_rast_hiz_cull(task, inputs))
+               continue;
+         }
+
+         dispatch[cmd]( task, block->arg[k] );
       }
    }
 }
@@ -755,10 +900,6 @@ rasterize_scene(struct lp_rasterizer_task *task,
    }
 #endif
 
-   if (scene->fence) {
-      lp_fence_signal(scene->fence);
-   }
-
    task->scene = NULL;
 }
 
@@ -788,8 +929,6 @@ lp_rast_queue_scene( struct lp_rasterizer *rast,
       lp_rast_end( rast );
 
       util_fpstate_set(fpstate);
-
-      rast->curr_scene = NULL;
    }
    else {
       /* threaded rendering! */
@@ -807,20 +946,14 @@ lp_rast_queue_scene( struct lp_rasterizer *rast,
 }
 
 
-void
-lp_rast_finish( struct lp_rasterizer *rast )
+/**
+ * Total time the rasterizer threads spent waiting for scenes or for each
+ * other, in nanoseconds.
+ */
+uint64_t
+lp_rast_get_idle_time( struct lp_rasterizer *rast )
 {
-   if (rast->num_threads == 0) {
-      /* nothing to do */
-   }
-   else {
-      int i;
-
-      /* wait for work to complete */
-      for (i = 0; i < rast->num_threads; i++) {
-         pipe_semaphore_wait(&rast->tasks[i].work_done);
-      }
-   }
+   return p_atomic_read(&rast->idle_time);
 }
 
 
@@ -829,7 +962,7 @@ lp_rast_finish( struct lp_rasterizer *rast )
  * It's a simple loop:
  *   1. wait for work
  *   2. do work
- *   3. signal that we're done
+ *   3. thread[0] signals the scene's fence once everybody is done
  */
 static int
 thread_function(void *init_data)
@@ -850,10 +983,14 @@ thread_function(void *init_data)
    util_fpstate_set_denorms_to_zero(fpstate);
 
    while (1) {
+      int64_t idle_start;
+
       /* wait for work */
       if (debug)
          debug_printf("thread %d waiting for work\n", task->thread_index);
+      idle_start = os_time_get_nano();
       pipe_semaphore_wait(&task->work_ready);
+      p_atomic_add(&rast->idle_time, os_time_get_nano() - idle_start);
 
       if (rast->exit_flag)
          break;
@@ -880,19 +1017,20 @@ thread_function(void *init_data)
                       rast->curr_scene);
       
       /* wait for all threads to finish with this scene */
+      idle_start = os_time_get_nano();
       util_barrier_wait( &rast->barrier );
+      p_atomic_add(&rast->idle_time, os_time_get_nano() - idle_start);
 
-      /* XXX: shouldn't be necessary:
+      /* thread[0]:
+       *  - unmap the framebuffer surfaces
+       *  - signal the scene's fence
        */
       if (task->thread_index == 0) {
          lp_rast_end( rast );
       }
 
-      /* signal done with work */
       if (debug)
          debug_printf("thread %d done working\n", task->thread_index);
-
-      pipe_semaphore_signal(&task->work_done);
    }
 
 #ifdef _WIN32
@@ -922,6 +1060,22 @@ create_rast_threads(struct lp_rasterizer *rast)
          break;
       }
    }
+
+   /* On CPUs with several L3 caches (multi-socket, AMD Zen), spread the
+    * threads evenly over them and keep each one on its cache, so the tiles
+    * it works on stay local instead of migrating between caches and nodes.
+    */
+   if (util_cpu_caps.cores_per_L3 &&
+       util_cpu_caps.cores_per_L3 < util_cpu_caps.nr_cpus &&
+       debug_get_bool_option("LP_PIN_THREADS", TRUE)) {
+      unsigned num_L3_caches = util_cpu_caps.nr_cpus /
+                               util_cpu_caps.cores_per_L3;
+
+      for (i = 0; i < rast->num_threads; i++) {
+         util_pin_thread_to_L3(rast->threads[i], i % num_L3_caches,
+                               util_cpu_caps.cores_per_L3);
+      }
+   }
 }
 
 
@@ -167,8 +167,8 @@ void
 lp_rast_queue_scene( struct lp_rasterizer *rast,
                      struct lp_scene *scene );
 
-void
-lp_rast_finish( struct lp_rasterizer *rast );
+uint64_t
+lp_rast_get_idle_time( struct lp_rasterizer *rast );
 
 
 union lp_rast_cmd_arg {
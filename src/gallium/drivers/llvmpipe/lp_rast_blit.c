@@ -0,0 +1,236 @@
+/**************************************************************************
+ *
+ * Copyright 2010-2020 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Whole tiles of blit shaders, without the jit code.
+ *
+ * See lp_state_fs_analysis.c for which shaders and state qualify.  Here we
+ * check that the texcoords map texels to pixels one to one across the tile,
+ * and if so copy (or blend) the texel rows straight into the color tile.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "util/u_math.h"
+#include "lp_debug.h"
+#include "lp_rast_priv.h"
+#include "lp_state_fs.h"
+
+#if defined(PIPE_ARCH_SSE)
+#include "util/u_sse.h"
+#endif
+
+
+/**
+ * Find the texels sampled along one axis of the tile at (x, y), given the
+ * plane of a texcoord already scaled to texels.
+ *
+ * \param vertical  whether the texcoord must follow y (t) rather than x (s)
+ * \param origin  returns the texel sampled at the tile origin
+ * \param step  returns +1 or -1, the texel increment per pixel
+ * \return FALSE unless the texcoord steps exactly one texel per pixel
+ */
+static boolean
+texel_mapping(float a0, float dadx, float dady,
+              unsigned x, unsigned y, boolean vertical,
+              int *origin, int *step)
+{
+   /* Bound the drift across the tile to 1/8 texel per axis, and keep
+    * the pixel centers within 1/4 texel of the texel centers, so that
+    * sampling can't pick any other texel than the ones we copy.
+    */
+   const float tolerance = 1.0f / (8 * TILE_SIZE);
+   const float along = vertical ? dady : dadx;
+   const float across = vertical ? dadx : dady;
+   const float a = a0 + dadx * x + dady * y;
+   const float frac = a - floorf(a);
+
+   if (fabsf(across) > tolerance || fabsf(frac - 0.5f) > 0.25f)
+      return FALSE;
+
+   if (fabsf(along - 1.0f) <= tolerance)
+      *step = 1;
+   else if (fabsf(along + 1.0f) <= tolerance)
+      *step = -1;
+   else
+      return FALSE;
+
+   *origin = (int) floorf(a);
+   return TRUE;
+}
+
+
+/**
+ * dst = src + dst * (1 - src.a) for 8bit unorm pixels with alpha last,
+ * rounded like the jit blend code (see lp_build_mul_norm()).
+ */
+static void
+blit_over_span(uint8_t *dst, const uint8_t *src, unsigned width)
+{
+   unsigned i = 0;
+
+#if defined(PIPE_ARCH_SSE)
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i half = _mm_set1_epi16(0x80);
+   const __m128i ones = _mm_set1_epi32(-1);
+
+   for (; i + 4 <= width; i += 4) {
+      __m128i s = _mm_loadu_si128((const __m128i *)(src + 4 * i));
+      __m128i d = _mm_loadu_si128((const __m128i *)(dst + 4 * i));
+      __m128i inv = _mm_xor_si128(s, ones);
+      __m128i inv_lo = _mm_unpacklo_epi8(inv, zero);
+      __m128i inv_hi = _mm_unpackhi_epi8(inv, zero);
+      __m128i lo, hi;
+
+      /* broadcast 1 - alpha to all channels of each pixel */
+      inv_lo = _mm_shufflelo_epi16(inv_lo, _MM_SHUFFLE(3, 3, 3, 3));
+      inv_lo = _mm_shufflehi_epi16(inv_lo, _MM_SHUFFLE(3, 3, 3, 3));
+      inv_hi = _mm_shufflelo_epi16(inv_hi, _MM_SHUFFLE(3, 3, 3, 3));
+      inv_hi = _mm_shufflehi_epi16(inv_hi, _MM_SHUFFLE(3, 3, 3, 3));
+
+      lo = _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv_lo);
+      hi = _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv_hi);
+      lo = _mm_add_epi16(lo, _mm_srli_epi16(lo, 8));
+      hi = _mm_add_epi16(hi, _mm_srli_epi16(hi, 8));
+      lo = _mm_srli_epi16(_mm_add_epi16(lo, half), 8);
+      hi = _mm_srli_epi16(_mm_add_epi16(hi, half), 8);
+
+      d = _mm_adds_epu8(_mm_packus_epi16(lo, hi), s);
+      _mm_storeu_si128((__m128i *)(dst + 4 * i), d);
+   }
+#endif
+
+   for (; i < width; i++) {
+      const uint8_t *s = src + 4 * i;
+      uint8_t *d = dst + 4 * i;
+      const unsigned inv = 255 - s[3];
+      unsigned c;
+
+      for (c = 0; c < 4; c++) {
+         unsigned t = d[c] * inv;
+         t = (t + (t >> 8) + 0x80) >> 8;
+         d[c] = MIN2(t + s[c], 255);
+      }
+   }
+}
+
+
+/**
+ * Try to shade the current tile of a LP_FS_BLIT_* variant without the
+ * shader.  Returns FALSE, having touched nothing, if the texcoords or the
+ * texture don't allow it.
+ */
+boolean
+lp_rast_blit_tile(struct lp_rasterizer_task *task,
+                  const struct lp_rast_shader_inputs *inputs)
+{
+   const struct lp_scene *scene = task->scene;
+   const struct lp_rast_state *state = task->state;
+   const struct lp_fragment_shader_variant *variant = state->variant;
+   const struct lp_fragment_shader *shader = variant->shader;
+   const struct lp_jit_texture *texture = &state->jit_context.textures[0];
+   const unsigned attrib = 1 + shader->blit_input;
+   float (*a0)[4] = GET_A0(inputs);
+   float (*dadx)[4] = GET_DADX(inputs);
+   float (*dady)[4] = GET_DADY(inputs);
+   const unsigned level = texture->first_level;
+   const unsigned width = u_minify(texture->width, level);
+   const unsigned height = u_minify(texture->height, level);
+   const unsigned bpp = scene->cbufs[0].format_bytes;
+   float s[3], t[3];
+   float scale_s = 1.0f, scale_t = 1.0f;
+   int s0, s_step, t0, t_step, src_stride;
+   const uint8_t *src;
+   uint8_t *dst;
+   unsigned i;
+
+   if (!texture->base || !texture->row_stride[level])
+      return FALSE;
+
+   if (variant->key.samplers[0].sampler_state.normalized_coords) {
+      scale_s = (float) width;
+      scale_t = (float) height;
+   }
+
+   if (shader->inputs[shader->blit_input].interp != LP_INTERP_LINEAR) {
+      /* Perspective divide by a constant w is just another scale. */
+      if (dadx[0][3] != 0.0f || dady[0][3] != 0.0f || a0[0][3] == 0.0f)
+         return FALSE;
+      scale_s /= a0[0][3];
+      scale_t /= a0[0][3];
+   }
+
+   s[0] = a0[attrib][0] * scale_s;
+   s[1] = dadx[attrib][0] * scale_s;
+   s[2] = dady[attrib][0] * scale_s;
+   t[0] = a0[attrib][1] * scale_t;
+   t[1] = dadx[attrib][1] * scale_t;
+   t[2] = dady[attrib][1] * scale_t;
+
+   if (!texel_mapping(s[0], s[1], s[2], task->x, task->y, FALSE,
+                      &s0, &s_step) ||
+       !texel_mapping(t[0], t[1], t[2], task->x, task->y, TRUE,
+                      &t0, &t_step))
+      return FALSE;
+
+   /* Only unmirrored rows, and nothing sampled outside the texture, where
+    * the wrap modes would kick in.
+    */
+   if (s_step != 1 ||
+       s0 < 0 || s0 + task->width > width ||
+       t0 < 0 || t0 >= (int) height ||
+       t0 + t_step * (int) (task->height - 1) < 0 ||
+       t0 + t_step * (int) (task->height - 1) >= (int) height)
+      return FALSE;
+
+   src = (const uint8_t *) texture->base + texture->mip_offsets[level] +
+         t0 * texture->row_stride[level] + s0 * bpp;
+   src_stride = t_step * (int) texture->row_stride[level];
+
+   dst = lp_rast_get_color_block_pointer(task, 0, task->x, task->y,
+                                         inputs->layer);
+
+   for (i = 0; i < task->height; i++) {
+      if (variant->blit == LP_FS_BLIT_COPY)
+         memcpy(dst, src, task->width * bpp);
+      else
+         blit_over_span(dst, src, task->width);
+      dst += scene->cbufs[0].stride;
+      src += src_stride;
+   }
+
+   /* Count invocations like the jit code does, once per 4x4 block. */
+   task->thread_data.ps_invocations +=
+      DIV_ROUND_UP(task->width, 4) * DIV_ROUND_UP(task->height, 4);
+   task->full_blocks +=
+      DIV_ROUND_UP(task->width, 4) * DIV_ROUND_UP(task->height, 4);
+
+   LP_DBG(DEBUG_RAST, "%s %ux%u\n", __FUNCTION__, task->width, task->height);
+
+   return TRUE;
+}
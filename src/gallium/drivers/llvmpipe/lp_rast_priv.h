@@ -100,6 +100,16 @@ struct lp_rasterizer_task
    /** Non-interpolated passthru state and occlude counter for visible pixels */
    struct lp_jit_thread_data thread_data;
 
+   /** Shaded 4x4 blocks in the current tile, for the driver queries */
+   uint64_t full_blocks;
+   uint64_t partial_blocks;
+
+   /**
+    * No depth value of the current tile is farther than this, or INFINITY
+    * when unknown.  Only tracked for single layer framebuffers.
+    */
+   float zmax;
+
    pipe_semaphore work_ready;
    pipe_semaphore work_done;
 };
@@ -129,6 +139,9 @@ struct lp_rasterizer
 
    /** For synchronizing the rasterization threads */
    util_barrier barrier;
+
+   /** Time the threads spent waiting for work, in nanoseconds */
+   uint64_t idle_time;
 };
 
 void
@@ -142,6 +155,10 @@ lp_rast_shade_quads_mask(struct lp_rasterizer_task *task,
                          unsigned x, unsigned y,
                          unsigned mask);
 
+boolean
+lp_rast_blit_tile(struct lp_rasterizer_task *task,
+                  const struct lp_rast_shader_inputs *inputs);
+
 
 /**
  * Get the pointer to a 4x4 color block (within a 64x64 tile).
@@ -273,6 +290,8 @@ lp_rast_shade_quads_all( struct lp_rasterizer_task *task,
       /* Propagate non-interpolated raster state. */
       task->thread_data.raster_state.viewport_index = inputs->viewport_index;
 
+      task->full_blocks++;
+
       /* run shader on 4x4 block */
       BEGIN_JIT_CALL(state, task);
       variant->jit_function[RAST_WHOLE]( &state->jit_context,
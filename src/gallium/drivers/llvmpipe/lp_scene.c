@@ -204,6 +204,17 @@ lp_scene_begin_rasterization(struct lp_scene *scene)
                                                zsbuf->u.tex.first_layer,
                                                LP_TEX_USAGE_READ_WRITE);
       scene->zsbuf.format_bytes = util_format_get_blocksize(zsbuf->format);
+
+      if (zsbuf->format == PIPE_FORMAT_Z32_FLOAT ||
+          zsbuf->format == PIPE_FORMAT_Z32_FLOAT_S8X24_UINT) {
+         scene->zmax_margin = 1.0f / (1 << 20);
+      }
+      else {
+         unsigned bits = util_format_get_component_bits(zsbuf->format,
+                                                        UTIL_FORMAT_COLORSPACE_ZS,
+                                                        0);
+         scene->zmax_margin = bits ? 2.0 / ((1ull << bits) - 1) : 0.0f;
+      }
    }
 }
 
@@ -211,12 +222,13 @@ lp_scene_begin_rasterization(struct lp_scene *scene)
 
 
 /**
- * Free all the temporary data in a scene.
+ * Unmap the framebuffer surfaces mapped by lp_scene_begin_rasterization().
+ * Called by the rasterizer once all threads are done with the scene.
  */
 void
 lp_scene_end_rasterization(struct lp_scene *scene )
 {
-   int i, j;
+   int i;
 
    /* Unmap color buffers */
    for (i = 0; i < scene->fb.nr_cbufs; i++) {
@@ -239,6 +251,19 @@ lp_scene_end_rasterization(struct lp_scene *scene )
                               zsbuf->u.tex.first_layer);
       scene->zsbuf.map = NULL;
    }
+}
+
+
+/**
+ * Free all the temporary data in a scene.
+ * The scene must not be in use by the rasterizer anymore.
+ */
+void
+lp_scene_reset(struct lp_scene *scene)
+{
+   int i, j;
+
+   lp_scene_end_rasterization(scene);
 
    /* Reset all command lists:
     */
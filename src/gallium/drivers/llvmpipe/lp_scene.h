@@ -150,6 +150,9 @@ struct lp_scene {
    /* The amount of layers in the fb (minimum of all attachments) */
    unsigned fb_max_layer;
 
+   /* Slack for the rounding of stored depth values, see lp_rast_hiz_cull() */
+   float zmax_margin;
+
    /* fixed point sample positions. */
    int32_t fixed_sample_pos[LP_MAX_SAMPLES][2];
 
@@ -411,6 +414,9 @@ lp_scene_begin_rasterization(struct lp_scene *scene);
 void
 lp_scene_end_rasterization(struct lp_scene *scene);
 
+void
+lp_scene_reset(struct lp_scene *scene);
+
 
 
 
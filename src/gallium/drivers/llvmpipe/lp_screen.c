@@ -37,6 +37,7 @@
 #include "pipe/p_screen.h"
 #include "draw/draw_context.h"
 #include "gallivm/lp_bld_type.h"
+#include "gallivm/lp_bld_misc.h"
 #include "gallivm/lp_bld_nir.h"
 #include "util/disk_cache.h"
 #include "util/os_misc.h"
@@ -49,6 +50,7 @@
 #include "lp_debug.h"
 #include "lp_public.h"
 #include "lp_limits.h"
+#include "lp_query.h"
 #include "lp_rast.h"
 #include "lp_cs_tpool.h"
 
@@ -724,6 +726,9 @@ llvmpipe_destroy_screen( struct pipe_screen *_screen )
    if (screen->cs_tpool)
       lp_cs_tpool_destroy(screen->cs_tpool);
 
+   if (util_queue_is_initialized(&screen->fs_compile_queue))
+      util_queue_destroy(&screen->fs_compile_queue);
+
    if (screen->rast)
       lp_rast_destroy(screen->rast);
 
@@ -796,6 +801,7 @@ static void lp_disk_cache_create(struct llvmpipe_screen *screen)
    unsigned gallivm_perf = gallivm_get_perf_flags();
    unsigned char sha1[20];
    char cache_id[20 * 2 + 1];
+   char mcpu[64];
    _mesa_sha1_init(&ctx);
 
    if (!disk_cache_get_function_identifier(lp_disk_cache_create, &ctx) ||
@@ -803,6 +809,17 @@ static void lp_disk_cache_create(struct llvmpipe_screen *screen)
       return;
 
    _mesa_sha1_update(&ctx, &gallivm_perf, sizeof(gallivm_perf));
+
+   /* Cached objects are machine code, only share them between hosts running
+    * the same LLVM version and generating code for the same cpu.
+    */
+   _mesa_sha1_update(&ctx, MESA_LLVM_VERSION_STRING,
+                     strlen(MESA_LLVM_VERSION_STRING));
+   lp_build_get_mcpu_name(mcpu, sizeof(mcpu));
+   _mesa_sha1_update(&ctx, mcpu, strlen(mcpu));
+   _mesa_sha1_update(&ctx, &lp_native_vector_width,
+                     sizeof(lp_native_vector_width));
+
    _mesa_sha1_final(&ctx, sha1);
    disk_cache_format_hex_id(cache_id, sha1, 20 * 2);
 
@@ -897,6 +914,7 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->base.fence_finish = llvmpipe_fence_finish;
 
    screen->base.get_timestamp = llvmpipe_get_timestamp;
+   screen->base.get_driver_query_info = llvmpipe_get_driver_query_info;
 
    screen->base.finalize_nir = llvmpipe_finalize_nir;
 
@@ -928,6 +946,14 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    }
    (void) mtx_init(&screen->cs_mutex, mtx_plain);
 
+   /* Leave most of the cpus to the rasterizer threads. */
+   if (debug_get_bool_option("LP_ASYNC_FS_COMPILE", TRUE)) {
+      util_queue_init(&screen->fs_compile_queue, "lpfs", 64,
+                      MAX2(1, MIN2(util_cpu_caps.nr_cpus / 4, 4)),
+                      UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+                      UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY);
+   }
+
    lp_disk_cache_create(screen);
    return &screen->base;
 }
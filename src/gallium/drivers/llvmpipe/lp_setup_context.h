@@ -54,9 +54,8 @@
 struct lp_setup_variant;
 
 
-/** Max number of scenes */
-/* XXX: make multiple scenes per context work, see lp_setup_rasterize_scene */
-#define MAX_SCENES 1
+/** Max number of scenes, binning of one overlaps rasterization of others */
+#define MAX_SCENES 3
 
 
 
@@ -25,6 +25,7 @@
 #include "util/u_memory.h"
 #include "util/simple_list.h"
 #include "util/os_time.h"
+#include "util/u_atomic.h"
 #include "util/u_dump.h"
 #include "util/u_string.h"
 #include "tgsi/tgsi_dump.h"
@@ -686,10 +687,16 @@ lp_cs_get_ir_cache_key(struct lp_compute_shader_variant *variant,
    unsigned ir_size;
    void *ir_binary;
 
-   blob_init(&blob);
-   nir_serialize(&blob, variant->shader->base.ir.nir, true);
-   ir_binary = blob.data;
-   ir_size = blob.size;
+   if (variant->shader->base.type == PIPE_SHADER_IR_TGSI) {
+      ir_binary = (void *)variant->shader->base.tokens;
+      ir_size = tgsi_num_tokens(variant->shader->base.tokens) *
+                sizeof(struct tgsi_token);
+   } else {
+      blob_init(&blob);
+      nir_serialize(&blob, variant->shader->base.ir.nir, true);
+      ir_binary = blob.data;
+      ir_size = blob.size;
+   }
 
    struct mesa_sha1 ctx;
    _mesa_sha1_init(&ctx);
@@ -722,7 +729,7 @@ generate_variant(struct llvmpipe_context *lp,
    variant->shader = shader;
    memcpy(&variant->key, key, shader->variant_key_size);
 
-   if (shader->base.ir.nir) {
+   if (shader->base.ir.nir || shader->base.tokens) {
       lp_cs_get_ir_cache_key(variant, ir_sha1_cache_key);
 
       lp_disk_cache_find_shader(screen, &cached, ir_sha1_cache_key);
@@ -850,6 +857,7 @@ llvmpipe_update_cs(struct llvmpipe_context *lp)
       variant = generate_variant(lp, shader, key);
       t1 = os_time_get();
       dt = t1 - t0;
+      p_atomic_add(&lp->counters.jit_time, dt);
       LP_COUNT_ADD(llvm_compile_time, dt);
       LP_COUNT_ADD(nr_llvm_compiles, 2);  /* emit vs. omit in/out test */
 
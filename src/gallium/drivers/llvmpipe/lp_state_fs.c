@@ -68,6 +68,7 @@
 #include "util/simple_list.h"
 #include "util/u_dual_blend.h"
 #include "util/os_time.h"
+#include "util/u_atomic.h"
 #include "pipe/p_shader_tokens.h"
 #include "draw/draw_context.h"
 #include "tgsi/tgsi_dump.h"
@@ -3431,6 +3432,7 @@ lp_debug_fs_variant(struct lp_fragment_shader_variant *variant)
       nir_print_shader(variant->shader->base.ir.nir, stderr);
    dump_fs_variant_key(&variant->key);
    debug_printf("variant->opaque = %u\n", variant->opaque);
+   debug_printf("variant->blit = %u\n", variant->blit);
    debug_printf("\n");
 }
 
@@ -3442,10 +3444,16 @@ lp_fs_get_ir_cache_key(struct lp_fragment_shader_variant *variant,
    unsigned ir_size;
    void *ir_binary;
 
-   blob_init(&blob);
-   nir_serialize(&blob, variant->shader->base.ir.nir, true);
-   ir_binary = blob.data;
-   ir_size = blob.size;
+   if (variant->shader->base.type == PIPE_SHADER_IR_TGSI) {
+      ir_binary = (void *)variant->shader->base.tokens;
+      ir_size = tgsi_num_tokens(variant->shader->base.tokens) *
+                sizeof(struct tgsi_token);
+   } else {
+      blob_init(&blob);
+      nir_serialize(&blob, variant->shader->base.ir.nir, true);
+      ir_binary = blob.data;
+      ir_size = blob.size;
+   }
 
    struct mesa_sha1 ctx;
    _mesa_sha1_init(&ctx);
@@ -3456,6 +3464,133 @@ lp_fs_get_ir_cache_key(struct lp_fragment_shader_variant *variant,
    blob_finish(&blob);
 }
 
+struct lp_fs_async_job
+{
+   struct llvmpipe_screen *screen;
+   struct llvmpipe_context *lp;
+   struct lp_fragment_shader_variant *variant;
+
+   /* Private copies: building LLVM IR from NIR modifies the NIR, and the
+    * variant in use keeps its own LLVM types and functions.
+    */
+   struct lp_fragment_shader shader;
+   struct lp_fragment_shader_variant *scratch;
+
+   unsigned char ir_sha1_cache_key[20];
+   bool needs_caching;
+};
+
+
+/**
+ * Build the complete variant in a module of its own on a compiler thread,
+ * then swap its specialized RAST_WHOLE function into the variant in use.
+ */
+static void
+generate_variant_async(void *data, int thread_index)
+{
+   struct lp_fs_async_job *job = (struct lp_fs_async_job *)data;
+   struct lp_fragment_shader_variant *variant = job->variant;
+   struct lp_fragment_shader_variant *scratch = job->scratch;
+   struct lp_cached_code cached = { 0 };
+   LLVMContextRef context;
+   char module_name[64];
+
+   int64_t t0 = os_time_get();
+
+   snprintf(module_name, sizeof(module_name), "fs%u_variant%u_async",
+            job->shader.no, variant->no);
+
+   context = LLVMContextCreate();
+   if (!context)
+      return;
+
+   scratch->gallivm = gallivm_create(module_name, context, &cached);
+   if (!scratch->gallivm) {
+      LLVMContextDispose(context);
+      return;
+   }
+
+   lp_jit_init_types(scratch);
+   generate_fragment(job->lp, &job->shader, scratch, RAST_EDGE_TEST);
+   generate_fragment(job->lp, &job->shader, scratch, RAST_WHOLE);
+
+   gallivm_compile_module(scratch->gallivm);
+
+   scratch->jit_function[RAST_WHOLE] = (lp_jit_frag_func)
+         gallivm_jit_function(scratch->gallivm, scratch->function[RAST_WHOLE]);
+
+   if (job->needs_caching) {
+      lp_disk_cache_insert_shader(job->screen, &cached,
+                                  job->ir_sha1_cache_key);
+   }
+
+   gallivm_free_ir(scratch->gallivm);
+
+   variant->async_gallivm = scratch->gallivm;
+   variant->async_context = context;
+   p_atomic_add(&job->lp->counters.jit_time, os_time_get() - t0);
+   p_atomic_set(&variant->jit_function[RAST_WHOLE],
+                scratch->jit_function[RAST_WHOLE]);
+}
+
+
+static void
+generate_variant_async_cleanup(void *data, int thread_index)
+{
+   struct lp_fs_async_job *job = (struct lp_fs_async_job *)data;
+
+   if (job->shader.base.type == PIPE_SHADER_IR_NIR)
+      ralloc_free(job->shader.base.ir.nir);
+   FREE(job->scratch);
+   FREE(job);
+}
+
+
+static void
+queue_variant_async(struct llvmpipe_context *lp,
+                    struct lp_fragment_shader *shader,
+                    struct lp_fragment_shader_variant *variant,
+                    const unsigned char ir_sha1_cache_key[20],
+                    bool needs_caching)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+   size_t variant_size = sizeof *variant + shader->variant_key_size -
+                         sizeof variant->key;
+   struct lp_fs_async_job *job;
+
+   job = CALLOC_STRUCT(lp_fs_async_job);
+   if (!job)
+      return;
+
+   job->scratch = MALLOC(variant_size);
+   if (!job->scratch) {
+      FREE(job);
+      return;
+   }
+
+   job->screen = screen;
+   job->lp = lp;
+   job->variant = variant;
+   job->shader = *shader;
+   if (shader->base.type == PIPE_SHADER_IR_NIR)
+      job->shader.base.ir.nir = nir_shader_clone(NULL, shader->base.ir.nir);
+   memcpy(job->ir_sha1_cache_key, ir_sha1_cache_key, 20);
+   job->needs_caching = needs_caching;
+
+   memcpy(job->scratch, variant, variant_size);
+   job->scratch->gallivm = NULL;
+   job->scratch->jit_context_ptr_type = NULL;
+   job->scratch->jit_thread_data_ptr_type = NULL;
+   job->scratch->jit_linear_context_ptr_type = NULL;
+   memset(job->scratch->function, 0, sizeof job->scratch->function);
+   memset(job->scratch->jit_function, 0, sizeof job->scratch->jit_function);
+
+   util_queue_add_job(&screen->fs_compile_queue, job, &variant->async_fence,
+                      generate_variant_async, generate_variant_async_cleanup,
+                      0);
+}
+
+
 /**
  * Generate a new fragment shader variant from the shader code and
  * other state indicated by the key.
@@ -3473,18 +3608,20 @@ generate_variant(struct llvmpipe_context *lp,
    unsigned char ir_sha1_cache_key[20];
    struct lp_cached_code cached = { 0 };
    bool needs_caching = false;
+   bool compile_async;
    variant = MALLOC(sizeof *variant + shader->variant_key_size - sizeof variant->key);
    if (!variant)
       return NULL;
 
    memset(variant, 0, sizeof(*variant));
+   util_queue_fence_init(&variant->async_fence);
    snprintf(module_name, sizeof(module_name), "fs%u_variant%u",
             shader->no, shader->variants_created);
 
    variant->shader = shader;
    memcpy(&variant->key, key, shader->variant_key_size);
 
-   if (shader->base.ir.nir) {
+   if (shader->base.ir.nir || shader->base.tokens) {
       lp_fs_get_ir_cache_key(variant, ir_sha1_cache_key);
 
       lp_disk_cache_find_shader(screen, &cached, ir_sha1_cache_key);
@@ -3493,6 +3630,7 @@ generate_variant(struct llvmpipe_context *lp,
    }
    variant->gallivm = gallivm_create(module_name, lp->context, &cached);
    if (!variant->gallivm) {
+      util_queue_fence_destroy(&variant->async_fence);
       FREE(variant);
       return NULL;
    }
@@ -3525,17 +3663,54 @@ generate_variant(struct llvmpipe_context *lp,
          !shader->info.base.writes_samplemask
       ? TRUE : FALSE;
 
+   variant->hiz_test =
+         key->depth.enabled &&
+         (key->depth.func == PIPE_FUNC_LESS ||
+          key->depth.func == PIPE_FUNC_LEQUAL) &&
+         !key->stencil[0].enabled &&
+         !key->depth_clamp &&
+         !shader->info.base.writes_z &&
+         !shader->info.base.writes_stencil &&
+         !shader->info.base.writes_memory;
+
+   variant->hiz_write =
+         variant->hiz_test &&
+         key->depth.writemask &&
+         !key->alpha.enabled &&
+         !key->multisample &&
+         !key->blend.alpha_to_coverage &&
+         !shader->info.base.uses_kill &&
+         !shader->info.base.writes_samplemask;
+
+   variant->hiz_clobber =
+         key->depth.enabled &&
+         key->depth.writemask &&
+         key->depth.func != PIPE_FUNC_NEVER &&
+         key->depth.func != PIPE_FUNC_LESS &&
+         key->depth.func != PIPE_FUNC_LEQUAL &&
+         key->depth.func != PIPE_FUNC_EQUAL;
+
+   variant->blit = llvmpipe_fs_variant_blit(shader, key);
+
    if ((LP_DEBUG & DEBUG_FS) || (gallivm_debug & GALLIVM_DEBUG_IR)) {
       lp_debug_fs_variant(variant);
    }
 
    lp_jit_init_types(variant);
-   
+
+   /* Unless the disk cache has it, don't hold up the draw with building the
+    * specialized whole tile function of opaque variants: the edge test one
+    * handles whole tiles too, if more slowly, and is used until the complete
+    * variant is compiled in the background.
+    */
+   compile_async = variant->opaque && !cached.data_size &&
+                   util_queue_is_initialized(&screen->fs_compile_queue);
+
    if (variant->jit_function[RAST_EDGE_TEST] == NULL)
       generate_fragment(lp, shader, variant, RAST_EDGE_TEST);
 
    if (variant->jit_function[RAST_WHOLE] == NULL) {
-      if (variant->opaque) {
+      if (variant->opaque && !compile_async) {
          /* Specialized shader, which doesn't need to read the color buffer. */
          generate_fragment(lp, shader, variant, RAST_WHOLE);
       }
@@ -3563,7 +3738,10 @@ generate_variant(struct llvmpipe_context *lp,
       variant->jit_function[RAST_WHOLE] = variant->jit_function[RAST_EDGE_TEST];
    }
 
-   if (needs_caching) {
+   if (compile_async) {
+      queue_variant_async(lp, shader, variant, ir_sha1_cache_key,
+                          needs_caching);
+   } else if (needs_caching) {
       lp_disk_cache_insert_shader(screen, &cached, ir_sha1_cache_key);
    }
 
@@ -3654,6 +3832,8 @@ llvmpipe_create_fs_state(struct pipe_context *pipe,
       shader->inputs[i].src_index = i+1;
    }
 
+   llvmpipe_fs_analyse(shader);
+
    if (LP_DEBUG & DEBUG_TGSI) {
       unsigned attrib;
       debug_printf("llvmpipe: Create fragment shader #%u %p:\n",
@@ -3710,6 +3890,13 @@ llvmpipe_remove_shader_variant(struct llvmpipe_context *lp,
                    lp->nr_fs_variants, variant->nr_instrs, lp->nr_fs_instrs);
    }
 
+   util_queue_fence_wait(&variant->async_fence);
+   util_queue_fence_destroy(&variant->async_fence);
+   if (variant->async_gallivm) {
+      gallivm_destroy(variant->async_gallivm);
+      LLVMContextDispose(variant->async_context);
+   }
+
    gallivm_destroy(variant->gallivm);
 
    /* remove from shader's list */
@@ -4223,6 +4410,7 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
       variant = generate_variant(lp, shader, key);
       t1 = os_time_get();
       dt = t1 - t0;
+      p_atomic_add(&lp->counters.jit_time, dt);
       LP_COUNT_ADD(llvm_compile_time, dt);
       LP_COUNT_ADD(nr_llvm_compiles, 2);  /* emit vs. omit in/out test */
 
@@ -32,6 +32,7 @@
 
 #include "pipe/p_compiler.h"
 #include "pipe/p_state.h"
+#include "util/u_queue.h"
 #include "tgsi/tgsi_scan.h" /* for tgsi_shader_info */
 #include "gallivm/lp_bld_sample.h" /* for struct lp_sampler_static_state */
 #include "gallivm/lp_bld_tgsi.h" /* for lp_tgsi_info */
@@ -118,6 +119,26 @@ lp_fs_variant_key_images(struct lp_fragment_shader_variant_key *key)
       &key->samplers[key->nr_samplers];
 }
 
+/**
+ * Fragment shaders the rasterizer can run without the jit code, see
+ * lp_state_fs_analysis.c.
+ */
+enum lp_fs_kind
+{
+   LP_FS_KIND_GENERAL = 0,
+   LP_FS_KIND_BLIT,        /**< OUT[0] = TEX(IN[blit_input].xy, SAMP[0]) */
+};
+
+
+/** How a variant of a LP_FS_KIND_BLIT shader may be rasterized */
+enum lp_fs_blit
+{
+   LP_FS_BLIT_NONE = 0,
+   LP_FS_BLIT_COPY,        /**< texels copied as is */
+   LP_FS_BLIT_OVER,        /**< premultiplied texels blended "over" */
+};
+
+
 /** doubly-linked list item */
 struct lp_fs_variant_list_item
 {
@@ -131,6 +152,19 @@ struct lp_fragment_shader_variant
 
    boolean opaque;
 
+   /**
+    * Per tile depth bounds, see lp_rast_hiz_cull():
+    * hiz_test - fragments only pass depth tests nearer than what is stored
+    * hiz_write - covering a whole tile leaves it no farther than the plane
+    * hiz_clobber - may store depth values farther than the stored ones
+    */
+   boolean hiz_test;
+   boolean hiz_write;
+   boolean hiz_clobber;
+
+   /** Whole tiles can be copied/blended by lp_rast_blit_tile() */
+   enum lp_fs_blit blit;
+
    struct gallivm_state *gallivm;
 
    LLVMTypeRef jit_context_ptr_type;
@@ -144,6 +178,13 @@ struct lp_fragment_shader_variant
    /* Total number of LLVM instructions generated */
    unsigned nr_instrs;
 
+   /* Specialized code compiled in the background, see generate_variant().
+    * Only valid once async_fence is signalled.
+    */
+   struct util_queue_fence async_fence;
+   struct gallivm_state *async_gallivm;
+   LLVMContextRef async_context;
+
    struct lp_fs_variant_list_item list_item_global, list_item_local;
    struct lp_fragment_shader *shader;
 
@@ -174,9 +215,20 @@ struct lp_fragment_shader
 
    /** Fragment shader input interpolation info */
    struct lp_shader_input inputs[PIPE_MAX_SHADER_INPUTS];
+
+   enum lp_fs_kind kind;
+   unsigned blit_input;    /**< texcoord input of LP_FS_KIND_BLIT shaders */
 };
 
 
+void
+llvmpipe_fs_analyse(struct lp_fragment_shader *shader);
+
+enum lp_fs_blit
+llvmpipe_fs_variant_blit(const struct lp_fragment_shader *shader,
+                         const struct lp_fragment_shader_variant_key *key);
+
+
 void
 lp_debug_fs_variant(struct lp_fragment_shader_variant *variant);
 
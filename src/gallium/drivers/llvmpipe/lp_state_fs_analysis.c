@@ -0,0 +1,401 @@
+/**************************************************************************
+ *
+ * Copyright 2010-2020 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Recognize fragment shaders and variants which the rasterizer can run
+ * without the jit code.
+ *
+ * Compositors and 2D toolkits draw most of their pixels with a shader that
+ * does nothing but return a texel fetched at an interpolated texcoord, onto
+ * axis-aligned rectangles that map texels to pixels one to one.  For those
+ * whole tiles are just memory copies (or a premultiplied "over" blend),
+ * see lp_rast_blit_tile().
+ */
+
+#include "pipe/p_defines.h"
+#include "pipe/p_shader_tokens.h"
+#include "util/format/u_format.h"
+#include "tgsi/tgsi_parse.h"
+#include "compiler/nir/nir.h"
+
+#include "lp_jit.h"
+#include "lp_state_fs.h"
+
+
+/**
+ * Match a single "TEX OUT[color0], IN[n].xyyy, SAMP[0], 2D" instruction.
+ */
+static boolean
+is_blit_tgsi(const struct lp_fragment_shader *shader, unsigned *input)
+{
+   struct tgsi_parse_context parse;
+   boolean seen_tex = FALSE;
+   boolean ok = TRUE;
+
+   tgsi_parse_init(&parse, shader->base.tokens);
+
+   while (ok && !tgsi_parse_end_of_tokens(&parse)) {
+      const struct tgsi_full_instruction *inst;
+      const struct tgsi_full_dst_register *dst;
+      const struct tgsi_full_src_register *src;
+
+      tgsi_parse_token(&parse);
+
+      if (parse.FullToken.Token.Type != TGSI_TOKEN_TYPE_INSTRUCTION)
+         continue;
+
+      inst = &parse.FullToken.FullInstruction;
+      if (inst->Instruction.Opcode == TGSI_OPCODE_END)
+         continue;
+
+      dst = &inst->Dst[0];
+      src = &inst->Src[0];
+
+      ok = !seen_tex &&
+           inst->Instruction.Opcode == TGSI_OPCODE_TEX &&
+           !inst->Instruction.Saturate &&
+           (inst->Texture.Texture == TGSI_TEXTURE_2D ||
+            inst->Texture.Texture == TGSI_TEXTURE_RECT) &&
+           dst->Register.File == TGSI_FILE_OUTPUT &&
+           !dst->Register.Indirect &&
+           dst->Register.WriteMask == TGSI_WRITEMASK_XYZW &&
+           shader->info.base.output_semantic_name[dst->Register.Index] ==
+              TGSI_SEMANTIC_COLOR &&
+           shader->info.base.output_semantic_index[dst->Register.Index] == 0 &&
+           src[0].Register.File == TGSI_FILE_INPUT &&
+           !src[0].Register.Indirect &&
+           !src[0].Register.Absolute &&
+           !src[0].Register.Negate &&
+           src[0].Register.SwizzleX == TGSI_SWIZZLE_X &&
+           src[0].Register.SwizzleY == TGSI_SWIZZLE_Y &&
+           src[1].Register.File == TGSI_FILE_SAMPLER &&
+           !src[1].Register.Indirect &&
+           src[1].Register.Index == 0;
+
+      if (ok) {
+         *input = src[0].Register.Index;
+         seen_tex = TRUE;
+      }
+   }
+
+   tgsi_parse_free(&parse);
+
+   return ok && seen_tex;
+}
+
+
+/**
+ * Whether \p def is the .xy of the \p coord input load, either directly or
+ * through a plain mov/vec2.
+ */
+static bool
+is_input_xy(const nir_ssa_def *def, const nir_ssa_def *coord)
+{
+   const nir_alu_instr *alu;
+
+   if (def == coord)
+      return def->num_components == 2;
+
+   if (def->num_components != 2 ||
+       def->parent_instr->type != nir_instr_type_alu)
+      return false;
+
+   alu = nir_instr_as_alu(def->parent_instr);
+   if (alu->dest.saturate)
+      return false;
+
+   for (unsigned i = 0; i < 2; i++) {
+      const nir_alu_src *src;
+      unsigned swizzle;
+
+      if (alu->op == nir_op_mov) {
+         src = &alu->src[0];
+         swizzle = src->swizzle[i];
+      } else if (alu->op == nir_op_vec2) {
+         src = &alu->src[i];
+         swizzle = src->swizzle[0];
+      } else {
+         return false;
+      }
+
+      if (!src->src.is_ssa || src->src.ssa != coord ||
+          src->abs || src->negate || swizzle != i)
+         return false;
+   }
+
+   return true;
+}
+
+
+static bool
+is_unit_zero(const nir_tex_instr *tex, nir_tex_src_type type)
+{
+   int idx = nir_tex_instr_src_index(tex, type);
+   const nir_deref_instr *deref;
+
+   if (idx < 0)
+      return true;
+
+   deref = nir_src_as_deref(tex->src[idx].src);
+   return deref->deref_type == nir_deref_type_var &&
+          deref->var->data.binding == 0;
+}
+
+
+/**
+ * NIR flavour of is_blit_tgsi(): a single block of input load, texcoord
+ * swizzle, tex and color output store, with nothing else.
+ */
+static boolean
+is_blit_nir(const struct lp_fragment_shader *shader, unsigned *input)
+{
+   nir_shader *nir = shader->base.ir.nir;
+   nir_function_impl *impl = nir_shader_get_entrypoint(nir);
+   const nir_ssa_def *coord = NULL;
+   const nir_tex_instr *tex = NULL;
+   bool stored = false;
+
+   if (!impl || !exec_list_is_singular(&impl->body))
+      return FALSE;
+
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr(instr, block) {
+         switch (instr->type) {
+         case nir_instr_type_deref:
+            /* validated by their users */
+            break;
+
+         case nir_instr_type_alu:
+            /* checked as a tex source, other uses don't matter */
+            if (nir_instr_as_alu(instr)->op != nir_op_mov &&
+                nir_instr_as_alu(instr)->op != nir_op_vec2)
+               return FALSE;
+            break;
+
+         case nir_instr_type_intrinsic: {
+            nir_intrinsic_instr *intr = nir_instr_as_intrinsic(instr);
+            nir_variable *var;
+
+            if (intr->intrinsic != nir_intrinsic_load_deref &&
+                intr->intrinsic != nir_intrinsic_store_deref)
+               return FALSE;
+
+            if (nir_src_as_deref(intr->src[0])->deref_type !=
+                nir_deref_type_var)
+               return FALSE;
+
+            var = nir_intrinsic_get_var(intr, 0);
+
+            if (intr->intrinsic == nir_intrinsic_load_deref) {
+               if (coord || var->data.mode != nir_var_shader_in ||
+                   intr->num_components < 2)
+                  return FALSE;
+               coord = &intr->dest.ssa;
+               *input = var->data.driver_location;
+            } else {
+               if (stored || !tex ||
+                   var->data.mode != nir_var_shader_out ||
+                   (var->data.location != FRAG_RESULT_COLOR &&
+                    var->data.location != FRAG_RESULT_DATA0) ||
+                   var->data.index != 0 ||
+                   nir_intrinsic_write_mask(intr) != 0xf ||
+                   !intr->src[1].is_ssa ||
+                   intr->src[1].ssa != &tex->dest.ssa)
+                  return FALSE;
+               stored = true;
+            }
+            break;
+         }
+
+         case nir_instr_type_tex: {
+            const nir_tex_instr *t = nir_instr_as_tex(instr);
+            int coord_idx = nir_tex_instr_src_index(t, nir_tex_src_coord);
+
+            if (tex || !coord ||
+                t->op != nir_texop_tex ||
+                (t->sampler_dim != GLSL_SAMPLER_DIM_2D &&
+                 t->sampler_dim != GLSL_SAMPLER_DIM_RECT) ||
+                t->is_array || t->is_shadow ||
+                nir_alu_type_get_base_type(t->dest_type) != nir_type_float ||
+                !t->dest.is_ssa || t->dest.ssa.num_components != 4 ||
+                coord_idx < 0 || !t->src[coord_idx].src.is_ssa ||
+                !is_input_xy(t->src[coord_idx].src.ssa, coord))
+               return FALSE;
+
+            for (unsigned i = 0; i < t->num_srcs; i++) {
+               if (t->src[i].src_type != nir_tex_src_coord &&
+                   t->src[i].src_type != nir_tex_src_texture_deref &&
+                   t->src[i].src_type != nir_tex_src_sampler_deref)
+                  return FALSE;
+            }
+
+            if (nir_tex_instr_src_index(t, nir_tex_src_texture_deref) < 0 &&
+                (t->texture_index != 0 || t->sampler_index != 0))
+               return FALSE;
+
+            if (!is_unit_zero(t, nir_tex_src_texture_deref) ||
+                !is_unit_zero(t, nir_tex_src_sampler_deref))
+               return FALSE;
+
+            tex = t;
+            break;
+         }
+
+         default:
+            return FALSE;
+         }
+      }
+   }
+
+   return stored;
+}
+
+
+/**
+ * Classify a fragment shader at creation time.
+ */
+void
+llvmpipe_fs_analyse(struct lp_fragment_shader *shader)
+{
+   unsigned input = 0;
+   boolean blit;
+
+   shader->kind = LP_FS_KIND_GENERAL;
+
+   if (shader->base.type == PIPE_SHADER_IR_TGSI)
+      blit = is_blit_tgsi(shader, &input);
+   else
+      blit = is_blit_nir(shader, &input);
+
+   if (!blit || input >= shader->info.base.num_inputs)
+      return;
+
+   switch (shader->inputs[input].interp) {
+   case LP_INTERP_LINEAR:
+   case LP_INTERP_PERSPECTIVE:
+   case LP_INTERP_COLOR:
+      shader->kind = LP_FS_KIND_BLIT;
+      shader->blit_input = input;
+      break;
+   default:
+      break;
+   }
+}
+
+
+/**
+ * Whether copying the texels as they are gives the same result as sampling,
+ * converting and storing them.
+ */
+static boolean
+is_copyable_format(const struct util_format_description *desc)
+{
+   unsigned i;
+
+   if (desc->layout != UTIL_FORMAT_LAYOUT_PLAIN ||
+       desc->block.width != 1 || desc->block.height != 1 ||
+       desc->colorspace != UTIL_FORMAT_COLORSPACE_RGB)
+      return FALSE;
+
+   for (i = 0; i < desc->nr_channels; i++) {
+      const struct util_format_channel_description *chan = &desc->channel[i];
+
+      /* snorm -1.0 has two encodings, don't let the sampler pick one */
+      if (chan->type != UTIL_FORMAT_TYPE_VOID &&
+          chan->type != UTIL_FORMAT_TYPE_FLOAT &&
+          !(chan->type == UTIL_FORMAT_TYPE_UNSIGNED && chan->normalized))
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+
+/**
+ * Decide whether whole tiles of this variant may bypass the jit code.
+ * The geometry (a 1:1 texel to pixel mapping) is only known at rasterization
+ * time, lp_rast_blit_tile() checks it and falls back to the shader.
+ */
+enum lp_fs_blit
+llvmpipe_fs_variant_blit(const struct lp_fragment_shader *shader,
+                         const struct lp_fragment_shader_variant_key *key)
+{
+   const struct lp_static_texture_state *texture;
+   const struct lp_static_sampler_state *sampler;
+   const struct pipe_rt_blend_state *blend = &key->blend.rt[0];
+   const struct util_format_description *desc;
+
+   if (shader->kind != LP_FS_KIND_BLIT ||
+       key->nr_cbufs != 1 ||
+       key->nr_samplers < 1 || key->nr_sampler_views < 1 ||
+       key->depth.enabled ||
+       key->stencil[0].enabled ||
+       key->alpha.enabled ||
+       key->multisample ||
+       key->occlusion_count ||
+       key->blend.logicop_enable ||
+       key->blend.alpha_to_coverage ||
+       key->cbuf_nr_samples[0] > 1 ||
+       blend->colormask != PIPE_MASK_RGBA)
+      return LP_FS_BLIT_NONE;
+
+   texture = &key->samplers[0].texture_state;
+   sampler = &key->samplers[0].sampler_state;
+
+   if (texture->format != key->cbuf_format[0] ||
+       (texture->target != PIPE_TEXTURE_2D &&
+        texture->target != PIPE_TEXTURE_RECT) ||
+       texture->swizzle_r != PIPE_SWIZZLE_X ||
+       texture->swizzle_g != PIPE_SWIZZLE_Y ||
+       texture->swizzle_b != PIPE_SWIZZLE_Z ||
+       texture->swizzle_a != PIPE_SWIZZLE_W ||
+       sampler->min_img_filter != PIPE_TEX_FILTER_NEAREST ||
+       sampler->mag_img_filter != PIPE_TEX_FILTER_NEAREST ||
+       sampler->min_mip_filter != PIPE_TEX_MIPFILTER_NONE ||
+       sampler->compare_mode != PIPE_TEX_COMPARE_NONE)
+      return LP_FS_BLIT_NONE;
+
+   desc = util_format_description(key->cbuf_format[0]);
+   if (!desc || !is_copyable_format(desc))
+      return LP_FS_BLIT_NONE;
+
+   if (!blend->blend_enable)
+      return LP_FS_BLIT_COPY;
+
+   if ((key->cbuf_format[0] == PIPE_FORMAT_B8G8R8A8_UNORM ||
+        key->cbuf_format[0] == PIPE_FORMAT_R8G8B8A8_UNORM) &&
+       blend->rgb_func == PIPE_BLEND_ADD &&
+       blend->alpha_func == PIPE_BLEND_ADD &&
+       blend->rgb_src_factor == PIPE_BLENDFACTOR_ONE &&
+       blend->alpha_src_factor == PIPE_BLENDFACTOR_ONE &&
+       blend->rgb_dst_factor == PIPE_BLENDFACTOR_INV_SRC_ALPHA &&
+       blend->alpha_dst_factor == PIPE_BLENDFACTOR_INV_SRC_ALPHA)
+      return LP_FS_BLIT_OVER;
+
+   return LP_FS_BLIT_NONE;
+}
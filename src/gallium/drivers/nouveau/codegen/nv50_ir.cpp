@@ -222,7 +222,15 @@ Value::Value()
   reg.size = 4;
 }
 
-LValue::LValue(Function *fn, DataFile file)
+Value::Value(Program *prog)
+   : defs(ArenaAllocator<ValueDef *>(&prog->mem_Containers))
+{
+  join = this;
+  memset(&reg, 0, sizeof(reg));
+  reg.size = 4;
+}
+
+LValue::LValue(Function *fn, DataFile file) : Value(fn->getProgram())
 {
    reg.file = file;
    reg.size = (file != FILE_PREDICATE) ? 4 : 1;
@@ -237,7 +245,7 @@ LValue::LValue(Function *fn, DataFile file)
    fn->add(this, this->id);
 }
 
-LValue::LValue(Function *fn, LValue *lval)
+LValue::LValue(Function *fn, LValue *lval) : Value(fn->getProgram())
 {
    assert(lval);
 
@@ -280,7 +288,7 @@ LValue::isUniform() const
    return !insn->srcExists(1) && insn->getSrc(0)->isUniform();
 }
 
-Symbol::Symbol(Program *prog, DataFile f, ubyte fidx)
+Symbol::Symbol(Program *prog, DataFile f, ubyte fidx) : Value(prog)
 {
    baseSym = NULL;
 
@@ -318,7 +326,7 @@ Symbol::isUniform() const
       reg.file != FILE_SHADER_INPUT;
 }
 
-ImmediateValue::ImmediateValue(Program *prog, uint32_t uval)
+ImmediateValue::ImmediateValue(Program *prog, uint32_t uval) : Value(prog)
 {
    memset(&reg, 0, sizeof(reg));
 
@@ -331,7 +339,7 @@ ImmediateValue::ImmediateValue(Program *prog, uint32_t uval)
    prog->add(this, this->id);
 }
 
-ImmediateValue::ImmediateValue(Program *prog, float fval)
+ImmediateValue::ImmediateValue(Program *prog, float fval) : Value(prog)
 {
    memset(&reg, 0, sizeof(reg));
 
@@ -344,7 +352,7 @@ ImmediateValue::ImmediateValue(Program *prog, float fval)
    prog->add(this, this->id);
 }
 
-ImmediateValue::ImmediateValue(Program *prog, double dval)
+ImmediateValue::ImmediateValue(Program *prog, double dval) : Value(prog)
 {
    memset(&reg, 0, sizeof(reg));
 
@@ -603,6 +611,8 @@ Instruction::Instruction()
 }
 
 Instruction::Instruction(Function *fn, operation opr, DataType ty)
+   : defs(ArenaAllocator<ValueDef>(&fn->getProgram()->mem_Containers)),
+     srcs(ArenaAllocator<ValueRef>(&fn->getProgram()->mem_Containers))
 {
    init();
 
@@ -1169,6 +1179,7 @@ FlowInstruction::clone(ClonePolicy<Function>& pol, Instruction *i) const
 Program::Program(Type type, Target *arch)
    : progType(type),
      target(arch),
+     mem_Containers(),
      mem_Instruction(sizeof(Instruction), 6),
      mem_CmpInstruction(sizeof(CmpInstruction), 4),
      mem_TexInstruction(sizeof(TexInstruction), 4),
@@ -1327,6 +1338,7 @@ nv50_ir_generate_code(struct nv50_ir_prog_info *info)
 
    prog->optimizeSSA(info->optLevel);
    prog->getTarget()->runLegalizePass(prog, nv50_ir::CG_STAGE_SSA);
+   prog->schedulePreRA(info->optLevel);
 
    if (prog->dbgFlags & NV50_IR_DEBUG_BASIC)
       prog->print();
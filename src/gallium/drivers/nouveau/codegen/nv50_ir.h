@@ -696,6 +696,7 @@ class Value
 {
 public:
    Value();
+   Value(Program *);
    virtual ~Value() { }
 
    virtual Value *clone(ClonePolicy<Function>&) const = 0;
@@ -723,12 +724,14 @@ public:
 
    static inline Value *get(Iterator&);
 
+   typedef std::list<ValueDef *, ArenaAllocator<ValueDef *> > DefList;
+
    unordered_set<ValueRef *> uses;
-   std::list<ValueDef *> defs;
+   DefList defs;
    typedef unordered_set<ValueRef *>::iterator UseIterator;
    typedef unordered_set<ValueRef *>::const_iterator UseCIterator;
-   typedef std::list<ValueDef *>::iterator DefIterator;
-   typedef std::list<ValueDef *>::const_iterator DefCIterator;
+   typedef DefList::iterator DefIterator;
+   typedef DefList::const_iterator DefCIterator;
 
    int id;
    Storage reg;
@@ -951,8 +954,8 @@ public:
    BasicBlock *bb;
 
 protected:
-   std::deque<ValueDef> defs; // no gaps !
-   std::deque<ValueRef> srcs; // no gaps !
+   std::deque<ValueDef, ArenaAllocator<ValueDef> > defs; // no gaps !
+   std::deque<ValueRef, ArenaAllocator<ValueRef> > srcs; // no gaps !
 
    // instruction specific methods:
    // (don't want to subclass, would need more constructors and memory pools)
@@ -1316,6 +1319,7 @@ public:
    bool makeFromTGSI(struct nv50_ir_prog_info *);
    bool convertToSSA();
    bool optimizeSSA(int level);
+   bool schedulePreRA(int level);
    bool optimizePostRA(int level);
    bool registerAllocation();
    bool emitBinary(struct nv50_ir_prog_info *);
@@ -1343,6 +1347,8 @@ public:
    bool fp64;
    bool persampleInvocation;
 
+   // storage of the defs, srcs and def lists of the objects below
+   MemoryArena mem_Containers;
    MemoryPool mem_Instruction;
    MemoryPool mem_CmpInstruction;
    MemoryPool mem_TexInstruction;
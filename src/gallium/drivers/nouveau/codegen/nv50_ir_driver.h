@@ -29,6 +29,7 @@
 #include "tgsi/tgsi_parse.h"
 #include "tgsi/tgsi_scan.h"
 
+struct blob;
 struct nir_shader_compiler_options;
 
 /*
@@ -60,10 +61,12 @@ struct nv50_ir_varying
 # define NV50_IR_DEBUG_BASIC     (1 << 0)
 # define NV50_IR_DEBUG_VERBOSE   (2 << 0)
 # define NV50_IR_DEBUG_REG_ALLOC (1 << 2)
+# define NV50_IR_DEBUG_PASS_TIMING (1 << 3)
 #else
 # define NV50_IR_DEBUG_BASIC     0
 # define NV50_IR_DEBUG_VERBOSE   0
 # define NV50_IR_DEBUG_REG_ALLOC 0
+# define NV50_IR_DEBUG_PASS_TIMING 0
 #endif
 
 struct nv50_ir_prog_symbol
@@ -204,6 +207,15 @@ nv50_ir_apply_fixups(void *fixupData, uint32_t *code,
                      bool force_per_sample, bool flatshade,
                      uint8_t alphatest);
 
+/* serialize the results of nv50_ir_generate_code, for shader caches */
+extern bool
+nv50_ir_prog_info_serialize(struct blob *, const struct nv50_ir_prog_info *);
+
+/* restore them, the source and the callbacks of the info are kept */
+extern bool
+nv50_ir_prog_info_deserialize(const void *data, size_t size,
+                              struct nv50_ir_prog_info *);
+
 /* obtain code that will be shared among programs */
 extern void nv50_ir_get_target_library(uint32_t chipset,
                                        const uint32_t **code, uint32_t *size);
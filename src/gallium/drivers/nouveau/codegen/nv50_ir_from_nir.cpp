@@ -29,6 +29,7 @@
 #include "codegen/nv50_ir.h"
 #include "codegen/nv50_ir_from_common.h"
 #include "codegen/nv50_ir_lowering_helper.h"
+#include "codegen/nv50_ir_target.h"
 #include "codegen/nv50_ir_util.h"
 #include "tgsi/tgsi_from_mesa.h"
 
@@ -110,6 +111,8 @@ private:
    Instruction *loadFrom(DataFile, uint8_t, DataType, Value *def, uint32_t base,
                          uint8_t c, Value *indirect0 = NULL,
                          Value *indirect1 = NULL, bool patch = false);
+   void loadVector(nir_intrinsic_instr *, DataFile, DataType, LValues &defs,
+                   uint32_t base, Value *indirect);
    void storeTo(nir_intrinsic_instr *, DataFile, operation, DataType,
                 Value *src, uint8_t idx, uint8_t c, Value *indirect0 = NULL,
                 Value *indirect1 = NULL);
@@ -1214,6 +1217,40 @@ Converter::loadFrom(DataFile file, uint8_t i, DataType ty, Value *def,
    }
 }
 
+// Load all components of @insn, using 64 and 128 bit loads where the address
+// is known to be aligned enough.
+void
+Converter::loadVector(nir_intrinsic_instr *insn, DataFile file, DataType ty,
+                      LValues &defs, uint32_t base, Value *indirect)
+{
+   const unsigned int num = nir_intrinsic_dest_components(insn);
+   const unsigned int tySize = typeSizeof(ty);
+   const unsigned int align = nir_intrinsic_align(insn);
+   unsigned int c, n;
+
+   for (c = 0; c < num; c += n) {
+      const unsigned int pos = c * tySize;
+      unsigned int size;
+
+      for (size = 16; size >= MAX2(tySize, 8u); size /= 2) {
+         if (align >= size && !(pos % size) && pos + size <= num * tySize &&
+             prog->getTarget()->isAccessSupported(file, typeOfSize(size)))
+            break;
+      }
+      if (size < MAX2(tySize, 8u)) {
+         n = 1;
+         loadFrom(file, 0, ty, defs[c], base, c, indirect);
+         continue;
+      }
+
+      const DataType vecTy = typeOfSize(size);
+      Instruction *ld =
+         mkLoad(vecTy, defs[c], mkSymbol(file, 0, vecTy, base + pos), indirect);
+      for (n = 1; n < size / tySize; ++n)
+         ld->setDef(n, defs[c + n]);
+   }
+}
+
 void
 Converter::storeTo(nir_intrinsic_instr *insn, DataFile file, operation op,
                    DataType ty, Value *src, uint8_t idx, uint8_t c,
@@ -2273,9 +2310,8 @@ Converter::visit(nir_intrinsic_instr *insn)
       Value *indirectOffset;
       uint32_t offset = getIndirect(&insn->src[0], 0, indirectOffset);
 
-      for (uint8_t i = 0u; i < dest_components; ++i)
-         loadFrom(FILE_MEMORY_SHARED, 0, dType, newDefs[i], offset, i, indirectOffset);
-
+      loadVector(insn, FILE_MEMORY_SHARED, dType, newDefs, offset,
+                 indirectOffset);
       break;
    }
    case nir_intrinsic_control_barrier: {
@@ -2312,9 +2348,8 @@ Converter::visit(nir_intrinsic_instr *insn)
       Value *indirectOffset;
       uint32_t offset = getIndirect(&insn->src[0], 0, indirectOffset);
 
-      for (auto i = 0u; i < dest_components; ++i)
-         loadFrom(FILE_MEMORY_GLOBAL, 0, dType, newDefs[i], offset, i, indirectOffset);
-
+      loadVector(insn, FILE_MEMORY_GLOBAL, dType, newDefs, offset,
+                 indirectOffset);
       info->io.globalAccess |= 0x1;
       break;
    }
@@ -3124,6 +3159,20 @@ Converter::visit(nir_tex_instr *insn)
    return true;
 }
 
+// Only loads are combined, into accesses the converter can emit as one 64 or
+// 128 bit load, see Converter::loadVector.
+static bool
+should_vectorize_mem(unsigned align, unsigned bit_size,
+                     unsigned num_components, unsigned high_offset,
+                     nir_intrinsic_instr *low, nir_intrinsic_instr *high)
+{
+   if (!nir_intrinsic_infos[low->intrinsic].has_dest)
+      return false;
+   if (bit_size < 32 || num_components * bit_size > 128)
+      return false;
+   return align >= 8;
+}
+
 bool
 Converter::run()
 {
@@ -3165,6 +3214,15 @@ Converter::run()
       NIR_PASS(progress, nir, nir_opt_dead_cf);
    } while (progress);
 
+   progress = false;
+   NIR_PASS(progress, nir, nir_opt_load_store_vectorize,
+            (nir_variable_mode)(nir_var_mem_global | nir_var_mem_shared),
+            should_vectorize_mem, (nir_variable_mode)0);
+   if (progress) {
+      NIR_PASS_V(nir, nir_copy_prop);
+      NIR_PASS_V(nir, nir_opt_dce);
+   }
+
    NIR_PASS_V(nir, nir_lower_bool_to_int32);
    NIR_PASS_V(nir, nir_lower_locals_to_regs);
    NIR_PASS_V(nir, nir_remove_dead_variables, nir_var_function_temp, NULL);
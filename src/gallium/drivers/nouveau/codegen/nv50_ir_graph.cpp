@@ -23,12 +23,13 @@
 #include "codegen/nv50_ir_graph.h"
 #include <limits>
 #include <list>
+#include <new>
 #include <stack>
 #include "codegen/nv50_ir.h"
 
 namespace nv50_ir {
 
-Graph::Graph()
+Graph::Graph() : mem_Edge(sizeof(Edge), 6)
 {
    root = NULL;
    size = 0;
@@ -70,6 +71,18 @@ void Graph::Edge::unlink()
    }
 }
 
+void Graph::Edge::destroy(Edge *edge)
+{
+   Graph *owner = edge->owner;
+
+   if (!owner) {
+      delete edge;
+      return;
+   }
+   edge->~Edge();
+   owner->mem_Edge.release(edge);
+}
+
 const char *Graph::Edge::typeStr() const
 {
    switch (type) {
@@ -93,7 +106,17 @@ Graph::Node::Node(void *priv) : data(priv),
 
 void Graph::Node::attach(Node *node, Edge::Type kind)
 {
-   Edge *edge = new Edge(this, node, kind);
+   Graph *owner = graph ? graph : node->graph;
+   void *mem = owner->mem_Edge.allocate();
+   Edge *edge;
+   if (mem) {
+      edge = new (mem) Edge(this, node, kind);
+      edge->owner = owner;
+   } else {
+      // the pool couldn't grow, fall back to the heap
+      edge = new Edge(this, node, kind);
+      edge->owner = NULL;
+   }
 
    // insert head
    if (this->out) {
@@ -135,7 +158,7 @@ bool Graph::Node::detach(Graph::Node *node)
       ERROR("no such node attached\n");
       return false;
    }
-   delete ei.getEdge();
+   Edge::destroy(ei.getEdge());
    return true;
 }
 
@@ -143,9 +166,9 @@ bool Graph::Node::detach(Graph::Node *node)
 void Graph::Node::cut()
 {
    while (out)
-      delete out;
+      Edge::destroy(out);
    while (in)
-      delete in;
+      Edge::destroy(in);
 
    if (graph) {
       if (graph->root == this)
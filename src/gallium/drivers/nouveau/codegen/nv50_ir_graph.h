@@ -52,6 +52,8 @@ public:
       Edge(Node *dst, Node *src, Type kind);
       ~Edge() { unlink(); }
 
+      static void destroy(Edge *); // release to the owning graph's pool or heap
+
       inline Node *getOrigin() const { return origin; }
       inline Node *getTarget() const { return target; }
 
@@ -66,6 +68,9 @@ public:
       Edge *next[2]; // next edge outgoing/incident from/to origin/target
       Edge *prev[2];
 
+      Graph *owner; // graph whose pool the edge was allocated from, or NULL
+                    // if it was allocated from the heap
+
       void unlink();
 
       friend class Graph;
@@ -175,6 +180,8 @@ private:
    Node *root;
    unsigned int size;
    int sequence;
+
+   MemoryPool mem_Edge;
 };
 
 int Graph::nextSequence()
@@ -24,7 +24,10 @@
 #include "codegen/nv50_ir_target.h"
 #include "codegen/nv50_ir_build_util.h"
 
+#include <algorithm>
+
 extern "C" {
+#include "util/os_time.h"
 #include "util/u_math.h"
 }
 
@@ -4032,18 +4035,624 @@ DeadCodeElim::checkSplitLoad(Instruction *ld1)
 
 // =============================================================================
 
+// Reorder the instructions of basic blocks before register allocation to hide
+// the latency of texture fetches and memory loads. Since Maxwell the hardware
+// issues the instructions in order, waiting on a barrier for a result stalls
+// the warp until the result arrives.
+// The instructions between two which must stay in place (stores, barriers,
+// flow, etc.) form a region, which is list scheduled: out of the instructions
+// whose dependencies are satisfied the one with the longest path to the end of
+// the region goes first, unless the register pressure gets high, in which case
+// the ones releasing registers are preferred.
+class ListScheduler : public Pass
+{
+public:
+   ListScheduler() : region(0) { }
+
+private:
+   struct Node
+   {
+      Instruction *insn;
+      std::vector<std::pair<int, int> > succs; // (node, latency)
+      int numPreds;
+      int height; // latency of the path to the end of the region
+      int ready; // earliest cycle at which the sources are available
+   };
+
+   struct ValueInfo
+   {
+      int region;
+      int lastDef; // node of the last def in the region, or -1
+      int lastUse; // node of the last use in the region, or -1
+      std::vector<int> usesSinceDef;
+      int remainingUses; // number of unscheduled nodes reading the value
+      bool liveOut;
+   };
+
+   virtual bool visit(Function *);
+   virtual bool visit(BasicBlock *);
+
+   bool isMovable(const Instruction *) const;
+   ValueInfo *getValueInfo(Value *);
+   void addDep(int from, int to, int latency);
+   void buildDAG(Instruction *first, Instruction *end);
+   int pressureDelta(const Node&, DataFile) const;
+   void updatePressure(const Node&);
+   bool isBetter(int a, int b, int cycle) const;
+   bool schedule(BasicBlock *, Instruction *first, Instruction *end);
+
+   // indexed by DataFile, only GPRs and predicates are considered
+   int pressure[FILE_PREDICATE + 1];
+
+   std::vector<Node> nodes;
+   std::vector<int> order;
+   std::vector<ValueInfo> values; // indexed by LValue id
+   std::vector<int> insnRegion; // indexed by Instruction id
+   int region;
+
+   // the regions of huge blocks are cut to keep the cost down
+   static const unsigned int maxRegionSize = 1024;
+   // above these, minimizing register usage takes precedence
+   static const int gprPressureLimit = 64;
+   static const int predPressureLimit = 4;
+};
+
+bool
+ListScheduler::visit(Function *fn)
+{
+   values.resize(fn->allLValues.getSize());
+   insnRegion.resize(fn->allInsns.getSize());
+   for (unsigned int i = 0; i < values.size(); ++i)
+      values[i].region = -1;
+   for (unsigned int i = 0; i < insnRegion.size(); ++i)
+      insnRegion[i] = -1;
+   return true;
+}
+
+bool
+ListScheduler::isMovable(const Instruction *insn) const
+{
+   if (insn->fixed || insn->terminator || insn->join || insn->exit ||
+       insn->asFlow() || insn->op == OP_PHI)
+      return false;
+
+   // values with fixed registers (e.g. call arguments) and the carry flag,
+   // of which there is only one, must not get longer live ranges
+   for (int s = 0; insn->srcExists(s); ++s) {
+      Value *v = insn->getSrc(s);
+      if (v->asLValue() && (v->reg.file == FILE_FLAGS || v->reg.data.id >= 0))
+         return false;
+   }
+   for (int d = 0; insn->defExists(d); ++d) {
+      Value *v = insn->getDef(d);
+      if (v->reg.file == FILE_FLAGS || v->reg.data.id >= 0)
+         return false;
+   }
+
+   switch (prog->getTarget()->getOpClass(insn->op)) {
+   case OPCLASS_MOVE:
+   case OPCLASS_ARITH:
+   case OPCLASS_SHIFT:
+   case OPCLASS_SFU:
+   case OPCLASS_LOGIC:
+   case OPCLASS_COMPARE:
+   case OPCLASS_CONVERT:
+   case OPCLASS_BITFIELD:
+   case OPCLASS_PSEUDO:
+   case OPCLASS_TEXTURE:
+      return true;
+   case OPCLASS_LOAD:
+      // volatile and locked loads stay where they are
+      return insn->cache != CACHE_CV && !insn->subOp;
+   case OPCLASS_SURFACE:
+      return insn->op == OP_SULDB || insn->op == OP_SULDP ||
+             insn->op == OP_SULEA;
+   case OPCLASS_OTHER:
+      switch (insn->op) {
+      case OP_SUBFM:
+      case OP_SUCLAMP:
+      case OP_SUEAU:
+      case OP_SUQ:
+      case OP_DFDX:
+      case OP_DFDY:
+      case OP_QUADOP:
+      case OP_PFETCH:
+      case OP_AFETCH:
+         return true;
+      case OP_RDSV:
+         return insn->getSrc(0)->reg.data.sv.sv != SV_CLOCK;
+      default:
+         return false;
+      }
+   default:
+      return false;
+   }
+}
+
+ListScheduler::ValueInfo *
+ListScheduler::getValueInfo(Value *v)
+{
+   if (!v->asLValue())
+      return NULL;
+   ValueInfo *info = &values[v->id];
+   if (info->region != region) {
+      info->region = region;
+      info->lastDef = -1;
+      info->lastUse = -1;
+      info->usesSinceDef.clear();
+      info->remainingUses = 0;
+      info->liveOut = false;
+      for (Value::UseCIterator u = v->uses.begin(); u != v->uses.end(); ++u)
+         if (insnRegion[(*u)->getInsn()->id] != region)
+            info->liveOut = true;
+   }
+   return info;
+}
+
+void
+ListScheduler::addDep(int from, int to, int latency)
+{
+   nodes[from].succs.push_back(std::make_pair(to, latency));
+   ++nodes[to].numPreds;
+}
+
+void
+ListScheduler::buildDAG(Instruction *first, Instruction *end)
+{
+   const Target *targ = prog->getTarget();
+
+   nodes.clear();
+   for (Instruction *i = first; i != end; i = i->next) {
+      Node node;
+      node.insn = i;
+      node.numPreds = 0;
+      node.height = 0;
+      node.ready = 0;
+      nodes.push_back(node);
+      insnRegion[i->id] = region;
+   }
+
+   for (int f = 0; f <= FILE_PREDICATE; ++f)
+      pressure[f] = 0;
+
+   for (int n = 0; n < (int)nodes.size(); ++n) {
+      Instruction *i = nodes[n].insn;
+
+      for (int s = 0; i->srcExists(s); ++s) {
+         Value *v = i->getSrc(s);
+         ValueInfo *info = getValueInfo(v);
+         if (!info || info->lastUse == n)
+            continue;
+         if (info->lastDef >= 0) {
+            const Instruction *def = nodes[info->lastDef].insn;
+            addDep(info->lastDef, n, targ->getResultLatency(def));
+         } else
+         if (info->lastUse < 0 && v->reg.file <= FILE_PREDICATE) {
+            pressure[v->reg.file] += v->reg.file == FILE_GPR ?
+               (v->reg.size + 3) / 4 : 1; // live-in
+         }
+         info->lastUse = n;
+         info->usesSinceDef.push_back(n);
+         ++info->remainingUses;
+      }
+      for (int d = 0; i->defExists(d); ++d) {
+         ValueInfo *info = getValueInfo(i->getDef(d));
+         if (!info)
+            continue;
+         if (info->lastDef >= 0)
+            addDep(info->lastDef, n, 1);
+         for (unsigned int u = 0; u < info->usesSinceDef.size(); ++u)
+            if (info->usesSinceDef[u] != n)
+               addDep(info->usesSinceDef[u], n, 0);
+         info->usesSinceDef.clear();
+         info->lastDef = n;
+      }
+   }
+
+   for (int n = nodes.size() - 1; n >= 0; --n) {
+      Node &node = nodes[n];
+      node.height =
+         node.insn->defExists(0) ? targ->getResultLatency(node.insn) : 1;
+      for (unsigned int s = 0; s < node.succs.size(); ++s)
+         node.height = MAX2(node.height,
+                            node.succs[s].second +
+                            nodes[node.succs[s].first].height);
+   }
+}
+
+// Change of the number of registers of file @f in use after scheduling @node.
+int
+ListScheduler::pressureDelta(const Node &node, DataFile f) const
+{
+   const Instruction *i = node.insn;
+   int delta = 0;
+
+   for (int d = 0; i->defExists(d); ++d) {
+      Value *v = i->getDef(d);
+      if (v->reg.file != f || !v->asLValue())
+         continue;
+      const ValueInfo &info = values[v->id];
+      if (info.remainingUses || info.liveOut)
+         delta += f == FILE_GPR ? (v->reg.size + 3) / 4 : 1;
+   }
+   for (int s = 0; i->srcExists(s); ++s) {
+      Value *v = i->getSrc(s);
+      if (v->reg.file != f || !v->asLValue())
+         continue;
+      int k;
+      for (k = 0; k < s && i->getSrc(k) != v; ++k);
+      if (k < s)
+         continue; // counted already
+      const ValueInfo &info = values[v->id];
+      if (info.remainingUses == 1 && !info.liveOut)
+         delta -= f == FILE_GPR ? (v->reg.size + 3) / 4 : 1;
+   }
+   return delta;
+}
+
+void
+ListScheduler::updatePressure(const Node &node)
+{
+   const Instruction *i = node.insn;
+
+   pressure[FILE_GPR] += pressureDelta(node, FILE_GPR);
+   pressure[FILE_PREDICATE] += pressureDelta(node, FILE_PREDICATE);
+
+   for (int s = 0; i->srcExists(s); ++s) {
+      Value *v = i->getSrc(s);
+      if (!v->asLValue())
+         continue;
+      int k;
+      for (k = 0; k < s && i->getSrc(k) != v; ++k);
+      if (k == s)
+         --values[v->id].remainingUses;
+   }
+}
+
+// Whether node @a should be scheduled before node @b at @cycle.
+bool
+ListScheduler::isBetter(int a, int b, int cycle) const
+{
+   const Node &na = nodes[a];
+   const Node &nb = nodes[b];
+
+   if (pressure[FILE_PREDICATE] >= predPressureLimit) {
+      const int da = pressureDelta(na, FILE_PREDICATE);
+      const int db = pressureDelta(nb, FILE_PREDICATE);
+      if (da != db)
+         return da < db;
+   }
+   if (pressure[FILE_GPR] >= gprPressureLimit) {
+      const int da = pressureDelta(na, FILE_GPR);
+      const int db = pressureDelta(nb, FILE_GPR);
+      if (da != db)
+         return da < db;
+   }
+
+   const int ra = MAX2(na.ready, cycle);
+   const int rb = MAX2(nb.ready, cycle);
+   if (ra != rb)
+      return ra < rb;
+   if (na.height != nb.height)
+      return na.height > nb.height;
+   return a < b;
+}
+
+// Schedule the instructions from @first up to (excluding) @end, returns true
+// if their order changed.
+bool
+ListScheduler::schedule(BasicBlock *bb, Instruction *first, Instruction *end)
+{
+   ++region;
+   buildDAG(first, end);
+
+   std::vector<int> ready;
+   for (int n = 0; n < (int)nodes.size(); ++n)
+      if (!nodes[n].numPreds)
+         ready.push_back(n);
+
+   order.clear();
+   for (int cycle = 0; !ready.empty(); ++cycle) {
+      unsigned int best = 0;
+      for (unsigned int r = 1; r < ready.size(); ++r)
+         if (isBetter(ready[r], ready[best], cycle))
+            best = r;
+      const int n = ready[best];
+      ready[best] = ready.back();
+      ready.pop_back();
+
+      Node &node = nodes[n];
+      cycle = MAX2(cycle, node.ready);
+      updatePressure(node);
+      order.push_back(n);
+
+      for (unsigned int s = 0; s < node.succs.size(); ++s) {
+         Node &succ = nodes[node.succs[s].first];
+         succ.ready = MAX2(succ.ready, cycle + node.succs[s].second);
+         if (!--succ.numPreds)
+            ready.push_back(node.succs[s].first);
+      }
+   }
+   assert(order.size() == nodes.size());
+
+   unsigned int n;
+   for (n = 0; n < order.size() && order[n] == (int)n; ++n);
+   if (n == order.size())
+      return false;
+
+   for (n = 0; n < nodes.size(); ++n)
+      bb->remove(nodes[n].insn);
+   for (n = 0; n < order.size(); ++n) {
+      if (end)
+         bb->insertBefore(end, nodes[order[n]].insn);
+      else
+         bb->insertTail(nodes[order[n]].insn);
+   }
+   return true;
+}
+
+bool
+ListScheduler::visit(BasicBlock *bb)
+{
+   Instruction *first = NULL;
+   unsigned int size = 0;
+
+   for (Instruction *i = bb->getEntry(); i; i = i->next) {
+      const bool movable = isMovable(i);
+      if (!movable || size == maxRegionSize) {
+         if (size > 1)
+            schedule(bb, first, i);
+         first = NULL;
+         size = 0;
+         if (!movable)
+            continue;
+      }
+      if (!first)
+         first = i;
+      ++size;
+   }
+   if (size > 1)
+      schedule(bb, first, NULL);
+
+   return true;
+}
+
+// =============================================================================
+
+// Summary of the IR used to tell what a pass changed: a hash of each
+// instruction, in CFG order, and one of the whole program.
+class IRFingerprint : public Pass
+{
+public:
+   void compute(Program *);
+
+   std::vector<uint64_t> insns;
+   uint64_t hash;
+
+private:
+   virtual bool visit(BasicBlock *);
+   virtual bool visit(Instruction *);
+
+   static inline uint64_t mix(uint64_t h, uint64_t v)
+   {
+      return (h ^ v) * 0x100000001b3ULL; // FNV-1a, a word at a time
+   }
+   static uint64_t mixValue(uint64_t h, const Value *);
+};
+
+void
+IRFingerprint::compute(Program *prog)
+{
+   insns.clear();
+   hash = 0xcbf29ce484222325ULL;
+   run(prog, true, false);
+}
+
+uint64_t
+IRFingerprint::mixValue(uint64_t h, const Value *v)
+{
+   h = mix(h, (uintptr_t)v);
+   if (v)
+      h = mix(mix(h, v->reg.data.u64),
+              v->reg.file | (v->reg.fileIndex << 8) | (v->reg.size << 16) |
+              ((uint64_t)v->reg.type << 32));
+   return h;
+}
+
+bool
+IRFingerprint::visit(BasicBlock *bb)
+{
+   hash = mix(mix(hash, bb->getId()), bb->getInsnCount());
+   return true;
+}
+
+bool
+IRFingerprint::visit(Instruction *i)
+{
+   uint64_t h = 0xcbf29ce484222325ULL;
+
+   h = mix(h, i->op | (i->dType << 16) | ((uint64_t)i->sType << 32) |
+              ((uint64_t)i->cc << 48));
+   h = mix(h, i->rnd | (i->cache << 8) | (i->subOp << 16) |
+              ((uint64_t)(uint8_t)i->postFactor << 32) |
+              ((uint64_t)(uint8_t)i->predSrc << 40) |
+              ((uint64_t)(uint8_t)i->flagsDef << 48) |
+              ((uint64_t)(uint8_t)i->flagsSrc << 56));
+   h = mix(h, i->saturate | (i->join << 1) | (i->fixed << 2) |
+              (i->terminator << 3) | (i->ftz << 4) | (i->dnz << 5) |
+              (i->perPatch << 6) | (i->exit << 7) | (i->precise << 8) |
+              (i->ipa << 12) | (i->lanes << 16) | (i->mask << 20));
+
+   for (int d = 0; i->defExists(d); ++d)
+      h = mixValue(h, i->getDef(d));
+   for (int s = 0; i->srcExists(s); ++s) {
+      const ValueRef &ref = i->src(s);
+      h = mixValue(h, ref.get());
+      h = mix(h, ref.mod.abs() | (ref.mod.neg() << 1) |
+                 ((ref.mod & Modifier(NV50_IR_MOD_SAT)) ? 4 : 0) |
+                 ((ref.mod & Modifier(NV50_IR_MOD_NOT)) ? 8 : 0) |
+                 ((uint8_t)ref.indirect[0] << 8) |
+                 ((uint8_t)ref.indirect[1] << 16));
+   }
+
+   if (const TexInstruction *tex = i->asTex())
+      h = mix(h, tex->tex.target.getEnum() | (tex->tex.mask << 8) |
+                 ((uint64_t)tex->tex.r << 16) | ((uint64_t)tex->tex.s << 40));
+   if (const FlowInstruction *flow = i->asFlow())
+      h = mix(h, (uintptr_t)flow->target.bb);
+
+   insns.push_back(h);
+   hash = mix(hash, h);
+   return true;
+}
+
+// Collects the time spent in each pass of a stage and the number of
+// instructions it removed and added, reported at the end of the stage with
+// NV50_IR_DEBUG_PASS_TIMING. Passes which didn't change anything are only
+// counted in the summary.
+class PassTimer
+{
+public:
+   PassTimer(Program *, const char *stage);
+   ~PassTimer();
+
+   void begin(const char *pass);
+   void end();
+
+private:
+   struct Entry
+   {
+      const char *pass;
+      uint64_t time;
+      unsigned int insns;
+      unsigned int removed;
+      unsigned int added;
+      bool changed;
+   };
+
+   void countChanges(Entry&, const IRFingerprint&) const;
+
+   Program *prog;
+   const char *stage;
+   const bool enabled;
+   IRFingerprint fingerprint;
+   std::vector<Entry> entries;
+   int64_t startTime;
+};
+
+PassTimer::PassTimer(Program *prog, const char *stage)
+   : prog(prog),
+     stage(stage),
+     enabled(prog->dbgFlags & NV50_IR_DEBUG_PASS_TIMING)
+{
+   if (enabled)
+      fingerprint.compute(prog);
+}
+
+PassTimer::~PassTimer()
+{
+   if (!enabled || entries.empty())
+      return;
+
+   uint64_t total = 0, unchangedTime = 0;
+   unsigned int unchanged = 0;
+
+   INFO("nv50_ir passes (%s):\n", stage);
+   for (unsigned int e = 0; e < entries.size(); ++e) {
+      const Entry &entry = entries[e];
+      total += entry.time;
+      if (!entry.changed) {
+         unchangedTime += entry.time;
+         ++unchanged;
+         continue;
+      }
+      INFO("  %-24s %9.3f ms  %6u insns  -%u +%u\n", entry.pass,
+           entry.time / 1000000.0, entry.insns, entry.removed, entry.added);
+   }
+   if (unchanged)
+      INFO("  %-24s %9.3f ms  (%u passes)\n", "no change",
+           unchangedTime / 1000000.0, unchanged);
+   INFO("  %-24s %9.3f ms\n", "total", total / 1000000.0);
+}
+
+void
+PassTimer::begin(const char *pass)
+{
+   if (!enabled)
+      return;
+
+   Entry entry;
+   entry.pass = pass;
+   entry.time = 0;
+   entry.insns = 0;
+   entry.removed = 0;
+   entry.added = 0;
+   entry.changed = false;
+   entries.push_back(entry);
+   startTime = os_time_get_nano();
+}
+
+void
+PassTimer::end()
+{
+   if (!enabled)
+      return;
+
+   Entry &entry = entries.back();
+   entry.time = os_time_get_nano() - startTime;
+
+   IRFingerprint after;
+   after.compute(prog);
+   entry.insns = after.insns.size();
+   entry.changed = after.hash != fingerprint.hash;
+   if (entry.changed)
+      countChanges(entry, after);
+   fingerprint.insns.swap(after.insns);
+   fingerprint.hash = after.hash;
+}
+
+// Instructions which got modified count as both removed and added, the ones
+// which only moved don't count at all.
+void
+PassTimer::countChanges(Entry &entry, const IRFingerprint &after) const
+{
+   std::vector<uint64_t> a(fingerprint.insns), b(after.insns);
+   std::sort(a.begin(), a.end());
+   std::sort(b.begin(), b.end());
+
+   unsigned int common = 0;
+   for (unsigned int i = 0, j = 0; i < a.size() && j < b.size();) {
+      if (a[i] < b[j]) {
+         ++i;
+      } else
+      if (b[j] < a[i]) {
+         ++j;
+      } else {
+         ++common;
+         ++i;
+         ++j;
+      }
+   }
+   entry.removed = a.size() - common;
+   entry.added = b.size() - common;
+}
+
 #define RUN_PASS(l, n, f)                       \
    if (level >= (l)) {                          \
       if (dbgFlags & NV50_IR_DEBUG_VERBOSE)     \
          INFO("PEEPHOLE: %s\n", #n);            \
       n pass;                                   \
+      timer.begin(#n);                          \
       if (!pass.f(this))                        \
          return false;                          \
+      timer.end();                              \
    }
 
 bool
 Program::optimizeSSA(int level)
 {
+   PassTimer timer(this, "SSA");
+
    RUN_PASS(1, DeadCodeElim, buryAll);
    RUN_PASS(1, CopyPropagation, run);
    RUN_PASS(1, MergeSplits, run);
@@ -4063,9 +4672,24 @@ Program::optimizeSSA(int level)
    return true;
 }
 
+bool
+Program::schedulePreRA(int level)
+{
+   if (getTarget()->getChipset() < NVISA_GM107_CHIPSET)
+      return true;
+
+   PassTimer timer(this, "pre-RA scheduling");
+
+   RUN_PASS(3, ListScheduler, run);
+
+   return true;
+}
+
 bool
 Program::optimizePostRA(int level)
 {
+   PassTimer timer(this, "post-RA");
+
    RUN_PASS(2, FlatteningPass, run);
    RUN_PASS(2, PostRaLoadPropagation, run);
 
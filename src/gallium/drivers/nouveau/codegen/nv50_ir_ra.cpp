@@ -298,11 +298,11 @@ typedef std::pair<Value *, Value *> ValuePair;
 class MergedDefs
 {
 private:
-   std::list<ValueDef *>& entry(Value *val) {
+   Value::DefList& entry(Value *val) {
       auto it = defs.find(val);
 
       if (it == defs.end()) {
-         std::list<ValueDef *> &res = defs[val];
+         Value::DefList &res = defs[val];
          res = val->defs;
          return res;
       } else {
@@ -310,16 +310,16 @@ private:
       }
    }
 
-   std::unordered_map<Value *, std::list<ValueDef *> > defs;
+   std::unordered_map<Value *, Value::DefList > defs;
 
 public:
-   std::list<ValueDef *>& operator()(Value *val) {
+   Value::DefList& operator()(Value *val) {
       return entry(val);
    }
 
-   void add(Value *val, const std::list<ValueDef *> &vals) {
+   void add(Value *val, const Value::DefList &vals) {
       assert(val);
-      std::list<ValueDef *> &valdefs = entry(val);
+      Value::DefList &valdefs = entry(val);
       valdefs.insert(valdefs.end(), vals.begin(), vals.end());
    }
 
@@ -817,8 +817,14 @@ private:
    void calculateSpillWeights();
    bool simplify();
    bool selectRegisters();
+   bool linearScan(ArrayList&);
    void cleanup(const bool success);
 
+   void collectValues(ArrayList&, std::list<RIG_Node *>&);
+   float spillWeight(RIG_Node *);
+   void setRegisterIds();
+   void spillNode(RIG_Node *);
+
    void simplifyEdge(RIG_Node *, RIG_Node *);
    void simplifyNode(RIG_Node *);
 
@@ -826,7 +832,7 @@ private:
    void resolveSplitsAndMerges();
    void makeCompound(Instruction *, bool isSplit);
 
-   inline void checkInterference(const RIG_Node *, Graph::EdgeIterator&);
+   inline void checkInterference(const RIG_Node *, const RIG_Node *);
 
    inline void insertOrderedTail(std::list<RIG_Node *>&, RIG_Node *);
    void checkList(std::list<RIG_Node *>&);
@@ -861,6 +867,10 @@ private:
 
    static const RelDegree relDegree;
 
+   // Functions with more values than this are allocated by linearScan, the
+   // interference graph would take too long to build and colour.
+   static const unsigned int linearScanThreshold = 16384;
+
    RegisterSet regs;
 
    // need to fixup register id for participants of OP_MERGE/SPLIT
@@ -874,6 +884,7 @@ private:
 };
 
 const GCRA::RelDegree GCRA::relDegree;
+const unsigned int GCRA::linearScanThreshold;
 
 GCRA::RIG_Node::RIG_Node() : Node(NULL), next(this), prev(this)
 {
@@ -1000,7 +1011,7 @@ GCRA::coalesceValues(Value *dst, Value *src, bool force)
             rep->id, rep->reg.data.id, val->id);
 
    // set join pointer of all values joined with val
-   const std::list<ValueDef *> &defs = mergedDefs(val);
+   const Value::DefList &defs = mergedDefs(val);
    for (ValueDef *def : defs)
       def->get()->join = rep;
    assert(rep->join == rep && val->join == rep);
@@ -1255,11 +1266,10 @@ GCRA::insertOrderedTail(std::list<RIG_Node *>& list, RIG_Node *node)
    list.insert(it, node);
 }
 
+// Collect the nodes with a live range, ordered by the start of their interval.
 void
-GCRA::buildRIG(ArrayList& insns)
+GCRA::collectValues(ArrayList& insns, std::list<RIG_Node *>& values)
 {
-   std::list<RIG_Node *> values, active;
-
    for (std::deque<ValueDef>::iterator it = func->ins.begin();
         it != func->ins.end(); ++it)
       insertOrderedTail(values, getNode(it->get()->asLValue()));
@@ -1271,6 +1281,14 @@ GCRA::buildRIG(ArrayList& insns)
             insertOrderedTail(values, getNode(insn->getDef(d)->asLValue()));
    }
    checkList(values);
+}
+
+void
+GCRA::buildRIG(ArrayList& insns)
+{
+   std::list<RIG_Node *> values, active;
+
+   collectValues(insns, values);
 
    while (!values.empty()) {
       RIG_Node *cur = values.front();
@@ -1306,14 +1324,7 @@ GCRA::calculateSpillWeights()
       }
       LValue *val = nodes[i].getValue();
 
-      if (!val->noSpill) {
-         int rc = 0;
-         for (ValueDef *def : mergedDefs(val))
-            rc += def->get()->refCount();
-
-         nodes[i].weight =
-            (float)rc * (float)rc / (float)nodes[i].livei.extent();
-      }
+      nodes[i].weight = spillWeight(n);
 
       if (nodes[i].degree < nodes[i].degreeLimit) {
          int l = 0;
@@ -1328,6 +1339,21 @@ GCRA::calculateSpillWeights()
       printNodeInfo();
 }
 
+float
+GCRA::spillWeight(RIG_Node *node)
+{
+   LValue *val = node->getValue();
+
+   if (val->noSpill)
+      return std::numeric_limits<float>::infinity();
+
+   int rc = 0;
+   for (ValueDef *def : mergedDefs(val))
+      rc += def->get()->refCount();
+
+   return (float)rc * (float)rc / (float)node->livei.extent();
+}
+
 void
 GCRA::simplifyEdge(RIG_Node *a, RIG_Node *b)
 {
@@ -1404,10 +1430,8 @@ GCRA::simplify()
 }
 
 void
-GCRA::checkInterference(const RIG_Node *node, Graph::EdgeIterator& ei)
+GCRA::checkInterference(const RIG_Node *node, const RIG_Node *intf)
 {
-   const RIG_Node *intf = RIG_Node::get(ei);
-
    if (intf->reg < 0)
       return;
    LValue *vA = node->getValue();
@@ -1470,9 +1494,9 @@ GCRA::selectRegisters()
                node->getValue()->id, node->colors);
 
       for (Graph::EdgeIterator ei = node->outgoing(); !ei.end(); ei.next())
-         checkInterference(node, ei);
+         checkInterference(node, RIG_Node::get(ei));
       for (Graph::EdgeIterator ei = node->incident(); !ei.end(); ei.next())
-         checkInterference(node, ei);
+         checkInterference(node, RIG_Node::get(ei));
 
       if (!node->prefRegs.empty()) {
          for (std::list<RIG_Node *>::const_iterator it = node->prefRegs.begin();
@@ -1495,22 +1519,143 @@ GCRA::selectRegisters()
          INFO_DBG(prog->dbgFlags, REG_ALLOC, "assigned reg %i\n", node->reg);
          lval->compMask = node->getCompMask();
       } else {
-         INFO_DBG(prog->dbgFlags, REG_ALLOC, "must spill: %%%i (size %u)\n",
-                  lval->id, lval->reg.size);
-         Symbol *slot = NULL;
-         if (lval->reg.file == FILE_GPR)
-            slot = spill.assignSlot(node->livei, lval->reg.size);
-         mustSpill.push_back(ValuePair(lval, slot));
+         spillNode(node);
       }
    }
    if (!mustSpill.empty())
       return false;
+   setRegisterIds();
+   return true;
+}
+
+void
+GCRA::spillNode(RIG_Node *node)
+{
+   LValue *lval = node->getValue();
+
+   INFO_DBG(prog->dbgFlags, REG_ALLOC, "must spill: %%%i (size %u)\n",
+            lval->id, lval->reg.size);
+   Symbol *slot = NULL;
+   if (lval->reg.file == FILE_GPR)
+      slot = spill.assignSlot(node->livei, lval->reg.size);
+   mustSpill.push_back(ValuePair(lval, slot));
+}
+
+void
+GCRA::setRegisterIds()
+{
    for (unsigned int i = 0; i < nodeCount; ++i) {
       LValue *lval = nodes[i].getValue();
       if (nodes[i].reg >= 0 && nodes[i].colors > 0)
          lval->reg.data.id =
             regs.unitsToId(nodes[i].f, nodes[i].reg, lval->reg.size);
    }
+}
+
+// Allocate the values in the order their live ranges start, only testing
+// them against the values which are still live at that point instead of
+// building the full interference graph.  The allocation is worse than what
+// colouring the graph gives, but the cost only grows with the number of
+// values times the register pressure, which matters for huge shaders.
+//
+// Values which don't fit take the place of the live value of the same
+// file with the lowest spill weight, if there is a cheaper one to spill.
+bool
+GCRA::linearScan(ArrayList& insns)
+{
+   std::list<RIG_Node *> values, active, fixed;
+
+   INFO_DBG(prog->dbgFlags, REG_ALLOC, "\nLINEAR SCAN phase\n");
+
+   collectValues(insns, values);
+
+   // The pre-coloured values may start after the values they interfere
+   // with, they must be checked against all of them.
+   for (std::list<RIG_Node *>::iterator it = values.begin();
+        it != values.end();) {
+      RIG_Node *node = *it;
+
+      if (!node->colors) {
+         it = values.erase(it);
+      } else if (node->reg >= 0) {
+         regs.occupy(node->f, node->reg, node->colors); // update max reg
+         fixed.push_back(node);
+         it = values.erase(it);
+      } else {
+         node->weight = spillWeight(node);
+         ++it;
+      }
+   }
+
+   for (std::list<RIG_Node *>::iterator it = values.begin();
+        it != values.end(); ++it) {
+      RIG_Node *cur = *it;
+      LValue *lval = cur->getValue();
+
+      for (std::list<RIG_Node *>::iterator a = active.begin();
+           a != active.end();) {
+         if ((*a)->livei.end() <= cur->livei.begin())
+            a = active.erase(a);
+         else
+            ++a;
+      }
+
+      INFO_DBG(prog->dbgFlags, REG_ALLOC, "\nNODE[%%%i, %u colors]\n",
+               lval->id, cur->colors);
+
+      RIG_Node *victim = NULL;
+
+      for (int pass = 0; pass < 2 && cur->reg < 0; ++pass) {
+         regs.reset(cur->f);
+
+         for (std::list<RIG_Node *>::const_iterator f = fixed.begin();
+              f != fixed.end(); ++f)
+            if ((*f)->f == cur->f && (*f)->livei.overlaps(cur->livei))
+               checkInterference(cur, *f);
+
+         for (std::list<RIG_Node *>::const_iterator a = active.begin();
+              a != active.end(); ++a) {
+            if ((*a)->f != cur->f || !(*a)->livei.overlaps(cur->livei))
+               continue;
+            if (!victim || (*a)->weight < victim->weight)
+               victim = *a;
+            checkInterference(cur, *a);
+         }
+
+         for (std::list<RIG_Node *>::const_iterator p = cur->prefRegs.begin();
+              p != cur->prefRegs.end(); ++p) {
+            if ((*p)->reg >= 0 &&
+                regs.testOccupy(cur->f, (*p)->reg, cur->colors)) {
+               cur->reg = (*p)->reg;
+               break;
+            }
+         }
+         if (cur->reg >= 0 ||
+             regs.assign(cur->reg, cur->f, cur->colors, cur->maxReg))
+            break;
+
+         if (pass || !victim || victim->weight >= cur->weight)
+            break;
+
+         INFO_DBG(prog->dbgFlags, REG_ALLOC, "evicting %%%i\n",
+                  victim->getValue()->id);
+         active.remove(victim);
+         victim->reg = -1;
+         spillNode(victim);
+      }
+
+      if (cur->reg >= 0) {
+         INFO_DBG(prog->dbgFlags, REG_ALLOC, "assigned reg %i\n", cur->reg);
+         lval->compMask = cur->getCompMask();
+         active.push_back(cur);
+      } else {
+         spillNode(cur);
+      }
+   }
+
+   if (!mustSpill.empty())
+      return false;
+   setRegisterIds();
    return true;
 }
 
@@ -1574,13 +1719,17 @@ GCRA::allocateRegisters(ArrayList& insns)
    if (func->getProgram()->dbgFlags & NV50_IR_DEBUG_REG_ALLOC)
       func->printLiveIntervals();
 
-   buildRIG(insns);
-   calculateSpillWeights();
-   ret = simplify();
-   if (!ret)
-      goto out;
+   if (nodeCount > linearScanThreshold) {
+      ret = linearScan(insns);
+   } else {
+      buildRIG(insns);
+      calculateSpillWeights();
+      ret = simplify();
+      if (!ret)
+         goto out;
 
-   ret = selectRegisters();
+      ret = selectRegisters();
+   }
    if (!ret) {
       INFO_DBG(prog->dbgFlags, REG_ALLOC,
                "selectRegisters failed, inserting spill code ...\n");
@@ -1811,7 +1960,7 @@ SpillCodeInserter::run(const std::list<ValuePair>& lst)
       // multiple destinations that all need to be spilled (like OP_SPLIT).
       unordered_set<Instruction *> to_del;
 
-      std::list<ValueDef *> &defs = mergedDefs(lval);
+      Value::DefList &defs = mergedDefs(lval);
       for (Value::DefIterator d = defs.begin(); d != defs.end();
            ++d) {
          Value *slot = mem ?
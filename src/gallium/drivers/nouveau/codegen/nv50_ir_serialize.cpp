@@ -0,0 +1,195 @@
+/*
+ * Copyright 2020 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "util/blob.h"
+#include "codegen/nv50_ir_driver.h"
+#include "codegen/nv50_ir.h"
+#include "codegen/nv50_ir_target.h"
+
+// The fixup functions are written as an index, their addresses change with
+// every run.
+enum FixupApplyFunc {
+   APPLY_NV50,
+   APPLY_NVC0,
+   APPLY_GK110,
+   APPLY_GM107,
+   APPLY_GV100,
+   FLIP_NVC0,
+   FLIP_GK110,
+   FLIP_GM107,
+   FLIP_GV100,
+   ALPHATEST_NV50,
+   NUM_FIXUP_APPLY_FUNCS
+};
+
+static const nv50_ir::FixupApply fixupApplyFuncs[NUM_FIXUP_APPLY_FUNCS] = {
+   nv50_ir::nv50_interpApply, // APPLY_NV50
+   nv50_ir::nvc0_interpApply, // APPLY_NVC0
+   nv50_ir::gk110_interpApply, // APPLY_GK110
+   nv50_ir::gm107_interpApply, // APPLY_GM107
+   nv50_ir::gv100_interpApply, // APPLY_GV100
+   nv50_ir::nvc0_selpFlip, // FLIP_NVC0
+   nv50_ir::gk110_selpFlip, // FLIP_GK110
+   nv50_ir::gm107_selpFlip, // FLIP_GM107
+   nv50_ir::gv100_selpFlip, // FLIP_GV100
+   nv50_ir::nv50_alphatestSet, // ALPHATEST_NV50
+};
+
+extern "C" {
+
+bool
+nv50_ir_prog_info_serialize(struct blob *blob,
+                            const struct nv50_ir_prog_info *info)
+{
+   const nv50_ir::RelocInfo *reloc =
+      reinterpret_cast<const nv50_ir::RelocInfo *>(info->bin.relocData);
+   const nv50_ir::FixupInfo *fixup =
+      reinterpret_cast<const nv50_ir::FixupInfo *>(info->bin.fixupData);
+
+   // the pointers are meaningless in the cache
+   struct nv50_ir_prog_info copy = *info;
+   copy.bin.code = NULL;
+   copy.bin.source = NULL;
+   copy.bin.relocData = NULL;
+   copy.bin.fixupData = NULL;
+   copy.bin.syms = NULL;
+   copy.assignSlots = NULL;
+   copy.driverPriv = NULL;
+   blob_write_bytes(blob, &copy, sizeof(copy));
+
+   blob_write_bytes(blob, info->bin.code, info->bin.codeSize);
+
+   blob_write_uint32(blob, reloc ? reloc->count : 0);
+   if (reloc) {
+      blob_write_uint32(blob, reloc->codePos);
+      blob_write_uint32(blob, reloc->libPos);
+      blob_write_uint32(blob, reloc->dataPos);
+      blob_write_bytes(blob, reloc->entry,
+                       reloc->count * sizeof(nv50_ir::RelocEntry));
+   }
+
+   blob_write_uint32(blob, fixup ? fixup->count : 0);
+   for (unsigned i = 0; fixup && i < fixup->count; ++i) {
+      unsigned f;
+      for (f = 0; f < NUM_FIXUP_APPLY_FUNCS; ++f)
+         if (fixup->entry[i].apply == fixupApplyFuncs[f])
+            break;
+      if (f == NUM_FIXUP_APPLY_FUNCS) {
+         ERROR("unhandled fixup apply function pointer\n");
+         assert(false);
+         return false;
+      }
+      blob_write_uint32(blob, f);
+      blob_write_uint32(blob, fixup->entry[i].val);
+   }
+
+   blob_write_bytes(blob, info->bin.syms,
+                    info->bin.numSyms * sizeof(*info->bin.syms));
+
+   return !blob->out_of_memory;
+}
+
+bool
+nv50_ir_prog_info_deserialize(const void *data, size_t size,
+                              struct nv50_ir_prog_info *info)
+{
+   struct nv50_ir_prog_info res;
+   struct blob_reader reader;
+   nv50_ir::RelocInfo *reloc = NULL;
+   nv50_ir::FixupInfo *fixup = NULL;
+   uint32_t *code = NULL;
+   struct nv50_ir_prog_symbol *syms = NULL;
+   uint32_t count;
+
+   blob_reader_init(&reader, data, size);
+   blob_copy_bytes(&reader, &res, sizeof(res));
+   if (reader.overrun)
+      return false;
+
+   if (res.bin.codeSize) {
+      code = (uint32_t *)MALLOC(res.bin.codeSize);
+      if (!code)
+         goto fail;
+      blob_copy_bytes(&reader, code, res.bin.codeSize);
+   }
+
+   count = blob_read_uint32(&reader);
+   if (count && !reader.overrun) {
+      reloc = (nv50_ir::RelocInfo *)
+         MALLOC(sizeof(*reloc) + count * sizeof(nv50_ir::RelocEntry));
+      if (!reloc)
+         goto fail;
+      reloc->count = count;
+      reloc->codePos = blob_read_uint32(&reader);
+      reloc->libPos = blob_read_uint32(&reader);
+      reloc->dataPos = blob_read_uint32(&reader);
+      blob_copy_bytes(&reader, reloc->entry,
+                      count * sizeof(nv50_ir::RelocEntry));
+   }
+
+   count = blob_read_uint32(&reader);
+   if (count && !reader.overrun) {
+      fixup = (nv50_ir::FixupInfo *)
+         MALLOC(sizeof(*fixup) + count * sizeof(nv50_ir::FixupEntry));
+      if (!fixup)
+         goto fail;
+      fixup->count = count;
+      for (unsigned i = 0; i < count; ++i) {
+         const uint32_t f = blob_read_uint32(&reader);
+         const uint32_t val = blob_read_uint32(&reader);
+         if (reader.overrun || f >= NUM_FIXUP_APPLY_FUNCS)
+            goto fail;
+         fixup->entry[i].apply = fixupApplyFuncs[f];
+         fixup->entry[i].val = val;
+      }
+   }
+
+   if (res.bin.numSyms) {
+      syms = (struct nv50_ir_prog_symbol *)
+         MALLOC(res.bin.numSyms * sizeof(*syms));
+      if (!syms)
+         goto fail;
+      blob_copy_bytes(&reader, syms, res.bin.numSyms * sizeof(*syms));
+   }
+
+   if (reader.overrun || reader.current != reader.end)
+      goto fail;
+
+   res.bin.code = code;
+   res.bin.relocData = reloc;
+   res.bin.fixupData = fixup;
+   res.bin.syms = syms;
+   res.bin.source = info->bin.source;
+   res.assignSlots = info->assignSlots;
+   res.driverPriv = info->driverPriv;
+   *info = res;
+   return true;
+
+fail:
+   FREE(code);
+   FREE(reloc);
+   FREE(fixup);
+   FREE(syms);
+   return false;
+}
+
+} // extern "C"
@@ -91,6 +91,18 @@ struct FixupInfo
    FixupEntry entry[0];
 };
 
+// the fixups of the code emitters, nv50_ir_serialize.cpp has to know them all
+void nv50_interpApply(const FixupEntry *, uint32_t *, const FixupData&);
+void nv50_alphatestSet(const FixupEntry *, uint32_t *, const FixupData&);
+void nvc0_interpApply(const FixupEntry *, uint32_t *, const FixupData&);
+void nvc0_selpFlip(const FixupEntry *, uint32_t *, const FixupData&);
+void gk110_interpApply(const FixupEntry *, uint32_t *, const FixupData&);
+void gk110_selpFlip(const FixupEntry *, uint32_t *, const FixupData&);
+void gm107_interpApply(const FixupEntry *, uint32_t *, const FixupData&);
+void gm107_selpFlip(const FixupEntry *, uint32_t *, const FixupData&);
+void gv100_interpApply(const FixupEntry *, uint32_t *, const FixupData&);
+void gv100_selpFlip(const FixupEntry *, uint32_t *, const FixupData&);
+
 class CodeEmitter
 {
 public:
@@ -234,6 +246,12 @@ public:
                              const Instruction *next) const { return false; }
    virtual int getLatency(const Instruction *) const { return 1; }
    virtual int getThroughput(const Instruction *) const { return 1; }
+   // estimated number of cycles until the result of an instruction can be
+   // used, including the ones waited for on a barrier (used by scheduling)
+   virtual int getResultLatency(const Instruction *i) const
+   {
+      return getLatency(i);
+   }
 
    virtual unsigned int getFileSize(DataFile) const = 0;
    virtual unsigned int getFileUnit(DataFile) const = 0;
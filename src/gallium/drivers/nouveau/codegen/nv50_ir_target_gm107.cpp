@@ -334,6 +334,33 @@ TargetGM107::getReadLatency(const Instruction *insn) const
    return 0;
 }
 
+// Return the estimated number of cycles until the result of an instruction is
+// available. Variable latency instructions are waited for on a barrier, their
+// stall counts say nothing about when the result arrives.
+int
+TargetGM107::getResultLatency(const Instruction *insn) const
+{
+   if (!isBarrierRequired(insn))
+      return getLatency(insn);
+
+   switch (getOpClass(insn->op)) {
+   case OPCLASS_SURFACE:
+   case OPCLASS_TEXTURE:
+      return 200;
+   case OPCLASS_LOAD:
+      switch (insn->src(0).getFile()) {
+      case FILE_MEMORY_CONST:
+      case FILE_MEMORY_SHARED:
+      case FILE_SHADER_INPUT:
+         return 30;
+      default:
+         return 200;
+      }
+   default:
+      return 20;
+   }
+}
+
 bool
 TargetGM107::isCS2RSV(SVSemantic sv) const
 {
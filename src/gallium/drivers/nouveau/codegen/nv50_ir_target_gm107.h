@@ -23,6 +23,7 @@ public:
    virtual bool canDualIssue(const Instruction *, const Instruction *) const;
    virtual int getLatency(const Instruction *) const;
    virtual int getReadLatency(const Instruction *) const;
+   virtual int getResultLatency(const Instruction *) const;
 
    virtual bool isCS2RSV(SVSemantic) const;
 };
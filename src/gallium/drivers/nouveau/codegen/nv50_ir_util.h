@@ -674,6 +674,160 @@ private:
    const unsigned int objStepLog2;
 };
 
+/**
+ *  Storage for the variable sized allocations of the containers in the IR.
+ *
+ *  Small blocks are carved out of large chunks and kept in per-size free
+ *  lists once released, the chunks are only returned to the system when the
+ *  arena is destroyed.  Blocks too large for a size class go directly to
+ *  MALLOC.
+ */
+class MemoryArena
+{
+private:
+   static const size_t GRANULE = 16;
+   static const size_t NUM_SIZE_CLASSES = 64;
+   static const size_t CHUNK_SIZE = 64 << 10;
+
+   static inline size_t sizeClass(size_t size)
+   {
+      return size ? (size - 1) / GRANULE : 0;
+   }
+
+   bool enlargeCapacity()
+   {
+      uint8_t *const mem = (uint8_t *)MALLOC(CHUNK_SIZE);
+      if (!mem)
+         return false;
+
+      // the first granule links the chunks together
+      *(uint8_t **)mem = chunks;
+      chunks = mem;
+      top = mem + GRANULE;
+      left = CHUNK_SIZE - GRANULE;
+      return true;
+   }
+
+public:
+   MemoryArena() : chunks(NULL), top(NULL), left(0)
+   {
+      memset(released, 0, sizeof(released));
+   }
+
+   ~MemoryArena()
+   {
+      while (chunks) {
+         uint8_t *const next = *(uint8_t **)chunks;
+         FREE(chunks);
+         chunks = next;
+      }
+   }
+
+   void *allocate(size_t size)
+   {
+      const size_t c = sizeClass(size);
+      if (c >= NUM_SIZE_CLASSES)
+         return MALLOC(size);
+
+      if (released[c]) {
+         void *ret = released[c];
+         released[c] = *(void **)ret;
+         return ret;
+      }
+
+      const size_t bytes = (c + 1) * GRANULE;
+      if (bytes > left && !enlargeCapacity())
+         return NULL;
+
+      void *ret = top;
+      top += bytes;
+      left -= bytes;
+      return ret;
+   }
+
+   void release(void *ptr, size_t size)
+   {
+      const size_t c = sizeClass(size);
+      if (c >= NUM_SIZE_CLASSES) {
+         FREE(ptr);
+         return;
+      }
+
+      *(void **)ptr = released[c];
+      released[c] = ptr;
+   }
+
+private:
+   uint8_t *chunks; // list of MALLOC allocations
+   uint8_t *top; // free space in the current chunk
+   size_t left;
+
+   void *released[NUM_SIZE_CLASSES]; // lists of released blocks per size
+};
+
+/**
+ *  STL allocator drawing from a MemoryArena, or from MALLOC for objects
+ *  which don't belong to a program.
+ */
+template<typename T>
+class ArenaAllocator
+{
+public:
+   typedef T value_type;
+   typedef T *pointer;
+   typedef const T *const_pointer;
+   typedef T &reference;
+   typedef const T &const_reference;
+   typedef size_t size_type;
+   typedef ptrdiff_t difference_type;
+
+   template<typename U> struct rebind { typedef ArenaAllocator<U> other; };
+
+   ArenaAllocator(MemoryArena *arena = NULL) : arena(arena) { }
+
+   template<typename U>
+   ArenaAllocator(const ArenaAllocator<U>& that) : arena(that.arena) { }
+
+   pointer allocate(size_type n, const void * = NULL)
+   {
+      const size_t size = n * sizeof(T);
+      void *ptr = arena ? arena->allocate(size) : MALLOC(size);
+      if (!ptr)
+         throw std::bad_alloc();
+      return reinterpret_cast<pointer>(ptr);
+   }
+
+   void deallocate(pointer ptr, size_type n)
+   {
+      if (arena)
+         arena->release(ptr, n * sizeof(T));
+      else
+         FREE(ptr);
+   }
+
+   size_type max_size() const { return ~size_type(0) / sizeof(T); }
+
+   pointer address(reference x) const { return &x; }
+   const_pointer address(const_reference x) const { return &x; }
+
+   void construct(pointer ptr, const T& val) { new ((void *)ptr) T(val); }
+   void destroy(pointer ptr) { ptr->~T(); }
+
+   template<typename U>
+   bool operator==(const ArenaAllocator<U>& that) const
+   {
+      return arena == that.arena;
+   }
+
+   template<typename U>
+   bool operator!=(const ArenaAllocator<U>& that) const
+   {
+      return arena != that.arena;
+   }
+
+   MemoryArena *arena;
+};
+
 /**
  *  Composite object cloning policy.
  *
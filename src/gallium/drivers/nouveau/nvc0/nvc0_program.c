@@ -23,7 +23,9 @@
 #include "pipe/p_defines.h"
 
 #include "compiler/nir/nir.h"
+#include "compiler/nir/nir_serialize.h"
 #include "tgsi/tgsi_ureg.h"
+#include "util/blob.h"
 
 #include "nvc0/nvc0_context.h"
 
@@ -568,12 +570,66 @@ nvc0_program_dump(struct nvc0_program *prog)
 }
 #endif
 
+/* The key covers the source and everything the driver put into the info,
+ * the cache itself is specific to the driver build.
+ */
+static bool
+nvc0_program_compute_cache_key(struct disk_cache *cache,
+                               const struct nv50_ir_prog_info *info,
+                               cache_key key)
+{
+   struct nv50_ir_prog_info copy;
+   struct blob blob;
+   bool ok;
+
+   /* whoever asked for debug output wants to see the compiler run */
+   if (info->dbgFlags)
+      return false;
+
+   memcpy(&copy, info, sizeof(copy));
+   copy.bin.source = NULL;
+   copy.assignSlots = NULL;
+   copy.driverPriv = NULL;
+
+   blob_init(&blob);
+   blob_write_bytes(&blob, &copy, sizeof(copy));
+   if (info->bin.sourceRep == PIPE_SHADER_IR_NIR) {
+      nir_serialize(&blob, info->bin.source, false);
+   } else {
+      const struct tgsi_token *tokens = info->bin.source;
+      blob_write_bytes(&blob, tokens,
+                       tgsi_num_tokens(tokens) * sizeof(*tokens));
+   }
+
+   ok = !blob.out_of_memory;
+   if (ok)
+      disk_cache_compute_key(cache, blob.data, blob.size, key);
+   blob_finish(&blob);
+
+   return ok;
+}
+
+static void
+nvc0_program_cache_store(struct disk_cache *cache, const cache_key key,
+                         const struct nv50_ir_prog_info *info)
+{
+   struct blob blob;
+
+   blob_init(&blob);
+   if (nv50_ir_prog_info_serialize(&blob, info))
+      disk_cache_put(cache, key, blob.data, blob.size, NULL);
+   blob_finish(&blob);
+}
+
 bool
 nvc0_program_translate(struct nvc0_program *prog, uint16_t chipset,
+                       struct disk_cache *disk_shader_cache,
                        struct pipe_debug_callback *debug)
 {
    struct nv50_ir_prog_info *info;
-   int ret;
+   cache_key key;
+   bool cacheable = false, cached = false;
+   int ret = 0;
 
    info = CALLOC_STRUCT(nv50_ir_prog_info);
    if (!info)
@@ -633,10 +689,25 @@ nvc0_program_translate(struct nvc0_program *prog, uint16_t chipset,
 
    info->assignSlots = nvc0_program_assign_varying_slots;
 
-   ret = nv50_ir_generate_code(info);
-   if (ret) {
-      NOUVEAU_ERR("shader translation failed: %i\n", ret);
-      goto out;
+   if (disk_shader_cache)
+      cacheable = nvc0_program_compute_cache_key(disk_shader_cache, info, key);
+   if (cacheable) {
+      size_t size;
+      void *data = disk_cache_get(disk_shader_cache, key, &size);
+      if (data) {
+         cached = nv50_ir_prog_info_deserialize(data, size, info);
+         free(data);
+      }
+   }
+
+   if (!cached) {
+      ret = nv50_ir_generate_code(info);
+      if (ret) {
+         NOUVEAU_ERR("shader translation failed: %i\n", ret);
+         goto out;
+      }
+      if (cacheable)
+         nvc0_program_cache_store(disk_shader_cache, key, info);
    }
    if (prog->type != PIPE_SHADER_COMPUTE)
       FREE(info->bin.syms);
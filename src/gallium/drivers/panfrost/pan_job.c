@@ -1156,6 +1156,21 @@ panfrost_flush_all_batches(struct panfrost_context *ctx, uint32_t out_sync)
         panfrost_gc_fences(ctx);
 }
 
+/* Submit the batch of the current framebuffer, along with the batches it
+ * depends on. Batches of other framebuffers stay open: they are ordered
+ * against this one through the BO dependency graph, and can keep
+ * accumulating draws without another round-trip through tile memory. */
+
+void
+panfrost_flush_current_batch(struct panfrost_context *ctx)
+{
+        struct panfrost_batch *batch = panfrost_get_batch_for_fbo(ctx);
+        panfrost_batch_submit(batch, 0);
+
+        /* Collect batch fences before returning */
+        panfrost_gc_fences(ctx);
+}
+
 bool
 panfrost_pending_batches_access_bo(struct panfrost_context *ctx,
                                    const struct panfrost_bo *bo)
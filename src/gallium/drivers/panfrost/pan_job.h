@@ -156,6 +156,9 @@ panfrost_batch_create_bo(struct panfrost_batch *batch, size_t size,
 void
 panfrost_flush_all_batches(struct panfrost_context *ctx, uint32_t out_sync);
 
+void
+panfrost_flush_current_batch(struct panfrost_context *ctx);
+
 bool
 panfrost_pending_batches_access_bo(struct panfrost_context *ctx,
                                    const struct panfrost_bo *bo);
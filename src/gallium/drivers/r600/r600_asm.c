@@ -332,8 +332,8 @@ static int is_nop_inst(struct r600_bytecode_alu *alu)
 	return alu->op == ALU_OP0_NOP;
 }
 
-static int assign_alu_units(struct r600_bytecode *bc, struct r600_bytecode_alu *alu_first,
-			    struct r600_bytecode_alu *assignment[5])
+static int find_alu_units(struct r600_bytecode *bc, struct r600_bytecode_alu *alu_first,
+			  struct r600_bytecode_alu *assignment[5])
 {
 	struct r600_bytecode_alu *alu;
 	unsigned i, chan, trans;
@@ -356,16 +356,12 @@ static int assign_alu_units(struct r600_bytecode *bc, struct r600_bytecode_alu *
 			trans = 0;
 
 		if (trans) {
-			if (assignment[4]) {
-				assert(0); /* ALU.Trans has already been allocated. */
-				return -1;
-			}
+			if (assignment[4])
+				return -1; /* ALU.Trans has already been allocated. */
 			assignment[4] = alu;
 		} else {
-			if (assignment[chan]) {
-				assert(0); /* ALU.chan has already been allocated. */
-				return -1;
-			}
+			if (assignment[chan])
+				return -1; /* ALU.chan has already been allocated. */
 			assignment[chan] = alu;
 		}
 
@@ -375,6 +371,14 @@ static int assign_alu_units(struct r600_bytecode *bc, struct r600_bytecode_alu *
 	return 0;
 }
 
+static int assign_alu_units(struct r600_bytecode *bc, struct r600_bytecode_alu *alu_first,
+			    struct r600_bytecode_alu *assignment[5])
+{
+	int r = find_alu_units(bc, alu_first, assignment);
+	assert(!r); /* The slot has already been allocated. */
+	return r;
+}
+
 struct alu_bank_swizzle {
 	int	hw_gpr[NUM_OF_CYCLES][NUM_OF_COMPONENTS];
 	int	hw_cfile_addr[4];
@@ -951,6 +955,56 @@ static int merge_inst_groups(struct r600_bytecode *bc, struct r600_bytecode_alu
 	return 0;
 }
 
+/* Check whether the given independent ALU instructions can be issued as one
+ * instruction group: they must fit into the slots, reference at most four
+ * literals, and a bank swizzle must exist for their sources. Instructions
+ * that must not be moved to another group are rejected too. Returns 0 if
+ * the instructions can be grouped. */
+int r600_bytecode_check_alu_group(struct r600_bytecode *bc,
+				  const struct r600_bytecode_alu *alu, unsigned count)
+{
+	struct r600_bytecode_alu group[5];
+	struct r600_bytecode_alu *slots[5];
+	struct list_head head;
+	uint32_t literal[4];
+	unsigned nliteral = 0;
+	unsigned max_slots = bc->chip_class == CAYMAN ? 4 : 5;
+	unsigned i, j;
+
+	if (!count || count > max_slots)
+		return -1;
+
+	list_inithead(&head);
+	for (i = 0; i < count; i++) {
+		struct r600_bytecode_alu *a = &group[i];
+
+		memcpy(a, &alu[i], sizeof(*a));
+		a->last = i == count - 1;
+
+		if (is_alu_once_inst(a) || is_alu_mova_inst(a) ||
+		    alu_uses_rel(a) || alu_uses_lds(a) || is_nop_inst(a) ||
+		    a->pred_sel || a->op == ALU_OP0_SET_CF_IDX0 ||
+		    a->op == ALU_OP0_SET_CF_IDX1)
+			return -1;
+
+		for (j = 0; j < 3; j++) {
+			if (a->src[j].sel == V_SQ_ALU_SRC_LITERAL)
+				r600_bytecode_special_constants(a->src[j].value,
+					&a->src[j].sel, &a->src[j].neg, a->src[j].abs);
+		}
+
+		if (r600_bytecode_alu_nliterals(a, literal, &nliteral))
+			return -1;
+
+		list_addtail(&a->list, &head);
+	}
+
+	if (find_alu_units(bc, &group[0], slots))
+		return -1;
+
+	return check_and_set_bank_swizzle(bc, slots);
+}
+
 /* we'll keep kcache sets sorted by bank & addr */
 static int r600_bytecode_alloc_kcache_line(struct r600_bytecode *bc,
 		struct r600_bytecode_kcache *kcache,
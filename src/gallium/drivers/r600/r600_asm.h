@@ -323,6 +323,8 @@ int r600_bytecode_add_alu_type(struct r600_bytecode *bc,
 		const struct r600_bytecode_alu *alu, unsigned type);
 void r600_bytecode_special_constants(uint32_t value,
 		unsigned *sel, unsigned *neg, unsigned abs);
+int r600_bytecode_check_alu_group(struct r600_bytecode *bc,
+		const struct r600_bytecode_alu *alu, unsigned count);
 void r600_bytecode_disasm(struct r600_bytecode *bc);
 void r600_bytecode_alu_read(struct r600_bytecode *bc,
 		struct r600_bytecode_alu *alu, uint32_t word0, uint32_t word1);
@@ -39,6 +39,8 @@
 #include "nir/tgsi_to_nir.h"
 #include "nir/nir_to_tgsi_info.h"
 #include "compiler/nir/nir.h"
+#include "compiler/nir/nir_serialize.h"
+#include "util/blob.h"
 #include "util/u_bitcast.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
@@ -163,6 +165,196 @@ static int store_shader(struct pipe_context *ctx,
 	return 0;
 }
 
+/* The shader cache stores the finished bytecode together with everything
+ * the state emission needs to know about the shader, so a hit skips the
+ * whole TGSI/NIR -> bytecode pipeline, sb included.
+ */
+static bool r600_shader_cache_key(struct r600_context *rctx,
+				  struct r600_pipe_shader *shader,
+				  const union r600_shader_key *key,
+				  cache_key hash)
+{
+	struct r600_screen *rscreen = rctx->screen;
+	struct r600_pipe_shader_selector *sel = shader->selector;
+	struct blob blob;
+	bool ok;
+
+	if (!rscreen->b.disk_shader_cache)
+		return false;
+
+	blob_init(&blob);
+	blob_write_uint32(&blob, sel->type);
+	blob_write_uint64(&blob, rscreen->b.debug_flags);
+	blob_write_uint8(&blob, rscreen->has_compressed_msaa_texturing);
+	blob_write_bytes(&blob, key, sizeof(*key));
+	blob_write_bytes(&blob, &sel->so, sizeof(sel->so));
+
+	/* Export shaders write the ring offsets expected by the current GS. */
+	if ((sel->type == PIPE_SHADER_VERTEX && key->vs.as_es) ||
+	    (sel->type == PIPE_SHADER_TESS_EVAL && key->tes.as_es)) {
+		struct r600_shader *gs = &rctx->gs_shader->current->shader;
+
+		blob_write_uint32(&blob, gs->ninput);
+		blob_write_bytes(&blob, gs->input, gs->ninput * sizeof(gs->input[0]));
+	}
+
+	if (rscreen->b.debug_flags & DBG_NIR)
+		nir_serialize(&blob, sel->nir, false);
+	else
+		blob_write_bytes(&blob, sel->tokens,
+				 tgsi_num_tokens(sel->tokens) * sizeof(struct tgsi_token));
+
+	ok = !blob.out_of_memory;
+	if (ok)
+		disk_cache_compute_key(rscreen->b.disk_shader_cache,
+				       blob.data, blob.size, hash);
+
+	blob_finish(&blob);
+	return ok;
+}
+
+static void r600_shader_cache_write(struct blob *blob,
+				    const struct r600_pipe_shader *shader)
+{
+	const struct r600_shader *rshader = &shader->shader;
+	struct r600_shader copy = *rshader;
+
+	/* Only the sizes of the bytecode are needed once it's built, the rest
+	 * of it are the pointers of the assembler.
+	 */
+	memset(&copy.bc, 0, sizeof(copy.bc));
+	copy.bc.type = rshader->bc.type;
+	copy.bc.ndw = rshader->bc.ndw;
+	copy.bc.ngpr = rshader->bc.ngpr;
+	copy.bc.nstack = rshader->bc.nstack;
+	copy.bc.nlds_dw = rshader->bc.nlds_dw;
+	copy.arrays = NULL;
+
+	blob_write_bytes(blob, &copy, sizeof(copy));
+	blob_write_bytes(blob, rshader->bc.bytecode,
+			 rshader->bc.ndw * sizeof(uint32_t));
+	blob_write_bytes(blob, rshader->arrays,
+			 rshader->num_arrays * sizeof(*rshader->arrays));
+	blob_write_uint32(blob, shader->scratch_space_needed);
+	blob_write_uint32(blob, shader->enabled_stream_buffers_mask);
+}
+
+static bool r600_shader_cache_read(struct r600_context *rctx,
+				   struct blob_reader *blob,
+				   struct r600_pipe_shader *shader)
+{
+	struct r600_shader *rshader = &shader->shader;
+	struct r600_shader cached;
+	const void *bytecode, *arrays;
+	unsigned scratch_space_needed, enabled_stream_buffers_mask;
+
+	blob_copy_bytes(blob, &cached, sizeof(cached));
+	if (blob->overrun)
+		return false;
+
+	bytecode = blob_read_bytes(blob, cached.bc.ndw * sizeof(uint32_t));
+	arrays = blob_read_bytes(blob, cached.num_arrays * sizeof(*cached.arrays));
+	scratch_space_needed = blob_read_uint32(blob);
+	enabled_stream_buffers_mask = blob_read_uint32(blob);
+	if (blob->overrun || !cached.bc.ndw)
+		return false;
+
+	*rshader = cached;
+	memset(&rshader->bc, 0, sizeof(rshader->bc));
+	r600_bytecode_init(&rshader->bc, rctx->b.chip_class, rctx->b.family,
+			   rctx->screen->has_compressed_msaa_texturing);
+	rshader->bc.isa = rctx->isa;
+	rshader->bc.type = cached.bc.type;
+	rshader->bc.ndw = cached.bc.ndw;
+	rshader->bc.ngpr = cached.bc.ngpr;
+	rshader->bc.nstack = cached.bc.nstack;
+	rshader->bc.nlds_dw = cached.bc.nlds_dw;
+
+	rshader->bc.bytecode = malloc(cached.bc.ndw * sizeof(uint32_t));
+	if (!rshader->bc.bytecode)
+		return false;
+	memcpy(rshader->bc.bytecode, bytecode, cached.bc.ndw * sizeof(uint32_t));
+
+	rshader->arrays = NULL;
+	rshader->max_arrays = rshader->num_arrays;
+	if (rshader->num_arrays) {
+		rshader->arrays = malloc(rshader->num_arrays * sizeof(*rshader->arrays));
+		if (!rshader->arrays)
+			return false;
+		memcpy(rshader->arrays, arrays,
+		       rshader->num_arrays * sizeof(*rshader->arrays));
+	}
+
+	shader->scratch_space_needed = scratch_space_needed;
+	shader->enabled_stream_buffers_mask = enabled_stream_buffers_mask;
+	return true;
+}
+
+/* Returns true and fills in the shader and its GS copy shader on a hit. */
+static bool r600_shader_cache_load(struct r600_context *rctx,
+				   struct r600_pipe_shader *shader,
+				   const cache_key hash)
+{
+	struct disk_cache *cache = rctx->screen->b.disk_shader_cache;
+	struct r600_pipe_shader *cshader = NULL;
+	struct blob_reader blob;
+	size_t size;
+	void *buffer;
+
+	buffer = disk_cache_get(cache, hash, &size);
+	if (!buffer)
+		return false;
+
+	blob_reader_init(&blob, buffer, size);
+
+	if (!r600_shader_cache_read(rctx, &blob, shader))
+		goto fail;
+
+	if (blob_read_uint8(&blob)) {
+		cshader = calloc(1, sizeof(struct r600_pipe_shader));
+		if (!cshader || !r600_shader_cache_read(rctx, &blob, cshader))
+			goto fail;
+	}
+
+	if (blob.overrun || blob.current != blob.end)
+		goto fail;
+
+	shader->gs_copy_shader = cshader;
+	free(buffer);
+	return true;
+
+fail:
+	if (cshader) {
+		free(cshader->shader.bc.bytecode);
+		free(cshader->shader.arrays);
+		free(cshader);
+	}
+	free(shader->shader.bc.bytecode);
+	free(shader->shader.arrays);
+	memset(&shader->shader, 0, sizeof(shader->shader));
+	free(buffer);
+	return false;
+}
+
+static void r600_shader_cache_store(struct r600_context *rctx,
+				    struct r600_pipe_shader *shader,
+				    const cache_key hash)
+{
+	struct blob blob;
+
+	blob_init(&blob);
+	r600_shader_cache_write(&blob, shader);
+	blob_write_uint8(&blob, shader->gs_copy_shader != NULL);
+	if (shader->gs_copy_shader)
+		r600_shader_cache_write(&blob, shader->gs_copy_shader);
+
+	if (!blob.out_of_memory)
+		disk_cache_put(rctx->screen->b.disk_shader_cache, hash,
+			       blob.data, blob.size, NULL);
+
+	blob_finish(&blob);
+}
+
 extern const struct nir_shader_compiler_options r600_nir_options;
 static int nshader = 0;
 int r600_pipe_shader_create(struct pipe_context *ctx,
@@ -183,11 +375,17 @@ int r600_pipe_shader_create(struct pipe_context *ctx,
 		!(rscreen->b.debug_flags & DBG_NIR);
 	unsigned sb_disasm;
 	unsigned export_shader;
+	cache_key hash;
+	bool use_cache;
 	
 	shader->shader.bc.isa = rctx->isa;
 	
 	if (!(rscreen->b.debug_flags & DBG_NIR)) {
 		assert(sel->ir_type == PIPE_SHADER_IR_TGSI);
+		use_cache = !dump && r600_shader_cache_key(rctx, shader, &key, hash);
+		if (use_cache && r600_shader_cache_load(rctx, shader, hash))
+			goto store;
+
 		r = r600_shader_from_tgsi(rctx, shader, key);
 		if (r) {
 			R600_ERR("translation from TGSI failed !\n");
@@ -207,6 +405,10 @@ int r600_pipe_shader_create(struct pipe_context *ctx,
 		}
 		nir_tgsi_scan_shader(sel->nir, &sel->info, true);
 
+		use_cache = !dump && r600_shader_cache_key(rctx, shader, &key, hash);
+		if (use_cache && r600_shader_cache_load(rctx, shader, hash))
+			goto store;
+
 		r = r600_shader_from_nir(rctx, shader, &key);
 		if (r) {
 			fprintf(stderr, "--Failed shader--------------------------------------------------\n");
@@ -300,6 +502,10 @@ int r600_pipe_shader_create(struct pipe_context *ctx,
            fclose(f);
         }
 
+	if (use_cache)
+		r600_shader_cache_store(rctx, shader, hash);
+
+store:
 	if (shader->gs_copy_shader) {
 		if (dump) {
 			// dump copy shader
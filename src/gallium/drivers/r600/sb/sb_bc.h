@@ -691,6 +691,9 @@ public:
 	static unsigned dskip_end;
 	static unsigned dskip_mode;
 
+	static unsigned time_budget;
+	static unsigned ndw_budget;
+
 	sb_context() : src_stats(), opt_stats(), isa(0),
 			hw_chip(HW_CHIP_UNKNOWN), hw_class(HW_CLASS_UNKNOWN) {}
 
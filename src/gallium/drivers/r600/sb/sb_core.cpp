@@ -67,6 +67,9 @@ sb_context *r600_sb_context_create(struct r600_context *rctx) {
 	sb_context::dskip_end = debug_get_num_option("R600_SB_DSKIP_END", 0);
 	sb_context::dskip_mode = debug_get_num_option("R600_SB_DSKIP_MODE", 0);
 
+	sb_context::time_budget = debug_get_num_option("R600_SB_TIME_BUDGET", 0);
+	sb_context::ndw_budget = debug_get_num_option("R600_SB_NDW_BUDGET", 0);
+
 	return sctx;
 }
 
@@ -101,7 +104,7 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 	}
 
 	int64_t time_start = 0;
-	if (sb_context::dump_stat) {
+	if (sb_context::dump_stat || sb_context::time_budget) {
 		time_start = os_time_get_nano();
 	}
 
@@ -157,6 +160,34 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 
 	SB_DUMP_PASS( sblog << "\n\n###### after parse\n"; sh->dump_ir(); );
 
+	/* optional budgets for the expensive passes
+	 * ndw_budget - source bytecode size in dwords, checked before the
+	 *   optimization starts
+	 * time_budget - processing time in ms, checked before if_conversion, gcm
+	 *   and ra_coalesce
+	 *
+	 * Over the budget, if_conversion is skipped and ra_coalesce only merges
+	 * the phi chunks and takes the first swizzle that fits.  gcm can't be
+	 * skipped, it is what places the instructions into the basic blocks.
+	 */
+	if (sb_context::ndw_budget && bc->ndw > sb_context::ndw_budget) {
+		sblog << "sb: shader " << shader_id << " : ndw budget exceeded ("
+				<< bc->ndw << " > " << sb_context::ndw_budget << ")\n";
+		sh->over_budget = true;
+	}
+
+#define SB_CHECK_TIME_BUDGET(n) \
+	do { \
+		if (sb_context::time_budget && !sh->over_budget && \
+				os_time_get_nano() - time_start > \
+				(int64_t)sb_context::time_budget * 1000000) { \
+			sblog << "sb: shader " << shader_id << " : time budget (" \
+					<< sb_context::time_budget << " ms) exceeded before the " \
+					<< #n << " pass\n"; \
+			sh->over_budget = true; \
+		} \
+	} while (0)
+
 #define SB_RUN_PASS(n, dump) \
 	do { \
 		r = n(*sh).run(); \
@@ -191,7 +222,9 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 
 	// if conversion breaks the dependency tracking between CF_EMIT ops when it removes
 	// the phi nodes for SV_GEOMETRY_EMIT. Just disable it for GS
-	if ((sh->target != TARGET_GS && sh->target != TARGET_HS) || pshader->needs_scratch_space)
+	SB_CHECK_TIME_BUDGET(if_conversion);
+	if (((sh->target != TARGET_GS && sh->target != TARGET_HS) ||
+			pshader->needs_scratch_space) && !sh->over_budget)
 		SB_RUN_PASS(if_conversion,		1);
 
 	// if_conversion breaks info about uses, but next pass (peephole)
@@ -216,6 +249,8 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 	// container nodes in the correct locations for code placement
 	sh->create_bbs();
 
+	SB_CHECK_TIME_BUDGET(gcm);
+
 	SB_RUN_PASS(gcm,				1);
 
 	sh->compute_interferences = true;
@@ -224,6 +259,7 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 	sh->dce_flags = DF_REMOVE_DEAD;
 	SB_RUN_PASS(dce_cleanup,		1);
 
+	SB_CHECK_TIME_BUDGET(ra_coalesce);
 	SB_RUN_PASS(ra_coalesce,		1);
 	SB_RUN_PASS(ra_init,			1);
 
@@ -142,6 +142,11 @@ void coalescer::build_chunks() {
 
 		ra_edge *e = *I;
 
+		// edges are sorted by cost, only the phi edges are worth the
+		// quadratic interference checks when we're short on time
+		if (sh.over_budget && e->cost < phi_cost)
+			break;
+
 		if (!e->a->chunk)
 			create_chunk(e->a);
 
@@ -557,7 +562,9 @@ int coalescer::color_reg_constraint(ra_constraint *c) {
 				}
 			}
 
-			if (pass == 0 && done)
+			// the lowest register is only worth searching all the swizzle
+			// permutations when we're not short on time
+			if (done && (pass == 0 || sh.over_budget))
 				break;
 
 		} while (std::next_permutation(swz, swz + 4));
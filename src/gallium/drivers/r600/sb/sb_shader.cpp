@@ -40,7 +40,7 @@ shader::shader(sb_context &sctx, shader_target t, unsigned id)
   target(t), vt(ex), ex(*this), root(),
   compute_interferences(),
   has_alu_predication(),
-  uses_gradients(), safe_math(), ngpr(), nstack(), dce_flags() {}
+  uses_gradients(), safe_math(), over_budget(), ngpr(), nstack(), dce_flags() {}
 
 bool shader::assign_slot(alu_node* n, alu_node *slots[5]) {
 
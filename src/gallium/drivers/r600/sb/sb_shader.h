@@ -305,6 +305,10 @@ public:
 
 	bool safe_math;
 
+	// set when the shader exceeded the sb budget, the rest of the passes
+	// should favor compile time over code quality
+	bool over_budget;
+
 	unsigned ngpr, nstack;
 
 	unsigned dce_flags;
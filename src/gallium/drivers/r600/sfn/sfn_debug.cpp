@@ -69,6 +69,7 @@ static const struct debug_named_value sfn_debug_options[] = {
    {"flow", SfnLog::flow, "Log Flow instructions"},
    {"merge", SfnLog::merge, "Log register merge operations"},
    {"nomerge", SfnLog::nomerge, "Skup egister merge step"},
+   {"nosched", SfnLog::nosched, "Don't pack the ALU instruction groups"},
    {"tex", SfnLog::tex, "Log texture ops"},
    {"trans", SfnLog::trans, "Log generic translation messages"},
    DEBUG_NAMED_VALUE_END
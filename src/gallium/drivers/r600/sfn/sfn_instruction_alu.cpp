@@ -125,6 +125,21 @@ void AluInstruction::replace_values(const ValueSet& candiates, PValue new_value)
    }
 }
 
+/* A MOV from one GPR to another without any modifiers */
+bool AluInstruction::is_plain_copy() const
+{
+   if (m_opcode != op1_mov || !m_flags.test(alu_write) ||
+       m_cf_type != cf_alu)
+      return false;
+
+   for (auto f: {alu_src0_neg, alu_src0_abs, alu_src0_rel, alu_dst_clamp,
+                 alu_dst_rel, alu_update_exec, alu_update_pred})
+      if (m_flags.test(f))
+         return false;
+
+   return m_dest->type() == Value::gpr && m_src[0]->type() == Value::gpr;
+}
+
 PValue AluInstruction::remap_one_registers(PValue reg, std::vector<rename_reg_pair>& map,
                                            ValueMap &values)
 {
@@ -141,6 +156,11 @@ void AluInstruction::set_flag(AluModifiers flag)
    m_flags.set(flag);
 }
 
+void AluInstruction::reset_flag(AluModifiers flag)
+{
+   m_flags.reset(flag);
+}
+
 void AluInstruction::set_bank_swizzle(AluBankSwizzle bswz)
 {
    m_bank_swizzle = bswz;
@@ -102,6 +102,7 @@ public:
 
 
    void set_flag(AluModifiers flag);
+   void reset_flag(AluModifiers flag);
    unsigned n_sources() const;
 
    PValue dest() {return m_dest;}
@@ -119,6 +120,8 @@ public:
 
    void replace_values(const ValueSet& candiates, PValue new_value) override;
 
+   bool is_plain_copy() const;
+
 private:
 
    bool is_equal_to(const Instruction& lhs) const override;
@@ -1,4 +1,5 @@
 #include "sfn_instruction_block.h"
+#include "sfn_instruction_alu.h"
 
 namespace r600 {
 
@@ -21,6 +22,38 @@ void InstructionBlock::remap_registers(ValueRemapper& map)
       i->remap_registers(map);
 }
 
+/* Remove the MOVs that copy a register component onto itself, these are
+ * left over when the register merging coalesced a copy. If such a MOV
+ * closes an instruction group, the previous instruction of the group
+ * closes it now. */
+int InstructionBlock::remove_redundant_copies()
+{
+   std::vector<PInstruction> block;
+   int removed = 0;
+
+   for (auto& i: m_block) {
+      if (i->type() == alu) {
+         auto& mov = static_cast<AluInstruction&>(*i);
+         if (mov.is_plain_copy() &&
+             mov.dest()->sel() == mov.src(0).sel() &&
+             mov.dest()->chan() == mov.src(0).chan()) {
+            if (mov.is_last() && !block.empty() &&
+                block.back()->type() == alu) {
+               auto& prev = static_cast<AluInstruction&>(*block.back());
+               if (!prev.is_last())
+                  prev.set_flag(alu_last_instr);
+            }
+            ++removed;
+            continue;
+         }
+      }
+      block.push_back(i);
+   }
+
+   m_block.swap(block);
+   return removed;
+}
+
 void InstructionBlock::do_evalue_liveness(LiverangeEvaluator& eval) const
 {
    for(auto& i: m_block)
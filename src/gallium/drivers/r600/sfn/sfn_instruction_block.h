@@ -49,6 +49,8 @@ public:
 
         void remap_registers(ValueRemapper& map);
 
+        int remove_redundant_copies();
+
         size_t size() const {
            return m_block.size();
         }
@@ -35,17 +35,36 @@
 #include "../r600_shader.h"
 #include "../r600_sq.h"
 
+#include <algorithm>
+
 namespace r600 {
 
 using std::vector;
 
+/* An ALU instruction group, and the GPR components it reads and writes */
+struct AluGroup {
+   vector<PInstruction> instr;
+   vector<int> reads;
+   vector<int> writes;
+   vector<int> kcache_lines;
+   int nliterals = 0;
+   bool fixed = false;
+   bool merged = false;
+};
+
 struct AssemblyFromShaderLegacyImpl {
 
    AssemblyFromShaderLegacyImpl(r600_shader *sh, r600_shader_key *key);
    bool emit(const Instruction::Pointer i);
    void reset_addr_register() {m_last_addr.reset();}
 
+   vector<PInstruction> schedule_alu_groups(const InstructionBlock& block);
+
 private:
+   void schedule_alu_group(vector<AluGroup>& groups, AluGroup& group);
+   void analyze_alu_group(AluGroup& group);
+   bool can_merge_alu_groups(const AluGroup& first, const AluGroup& second);
+   bool alu_group_fits(const vector<PInstruction>& instr);
    bool emit_alu(const AluInstruction& ai, ECFAluOpCode cf_op);
    bool emit_export(const ExportInstruction & exi);
    bool emit_streamout(const StreamOutIntruction& instr);
@@ -118,7 +137,7 @@ bool AssemblyFromShaderLegacy::do_lower(const std::vector<InstructionBlock>& ir)
    std::vector<Instruction::Pointer> exports;
 
    for (const auto& block : ir) {
-      for (const auto& i : block) {
+      for (const auto& i : impl->schedule_alu_groups(block)) {
          if (!impl->emit(i))
          return false;
       if (i->type() != Instruction::alu)
@@ -226,6 +245,258 @@ AssemblyFromShaderLegacyImpl::AssemblyFromShaderLegacyImpl(r600_shader *sh,
 
 extern const std::map<EAluOp, int> opcode_map;
 
+/* The ALU instructions arrive in the groups created by the translation from
+ * NIR, and a group usually only holds the components of one NIR instruction.
+ * The assembler only tries to merge a group with the one right before it, so
+ * pack the groups of a block here: each group is moved into the earliest
+ * preceding group it doesn't depend on, as long as the combined group still
+ * fits into the slots and read ports, and doesn't exceed the literal and
+ * constant cache limits. Groups that have to stay where they are, like kills,
+ * predicate updates, or anything that uses relative addressing, are never
+ * merged and none of the other groups is moved across them.
+ */
+static const int max_alu_schedule_lookback = 32;
+
+static void add_unique(vector<int>& v, int x)
+{
+   if (std::find(v.begin(), v.end(), x) == v.end())
+      v.push_back(x);
+}
+
+static bool overlaps(const vector<int>& a, const vector<int>& b)
+{
+   for (auto x: a)
+      if (std::find(b.begin(), b.end(), x) != b.end())
+         return true;
+   return false;
+}
+
+/* The literals that copy_src replaces by inline constants */
+static bool is_inline_literal(const LiteralValue& v)
+{
+   return v.value() == 0 || v.value() == 1 || v.value_float() == 1.0f ||
+         v.value_float() == 0.5f || v.value() == 0xffffffff;
+}
+
+vector<PInstruction>
+AssemblyFromShaderLegacyImpl::schedule_alu_groups(const InstructionBlock& block)
+{
+   vector<PInstruction> result;
+
+   if (sfn_log.has_debug_flag(SfnLog::nosched)) {
+      result.insert(result.end(), block.begin(), block.end());
+      return result;
+   }
+
+   vector<AluGroup> groups;
+   AluGroup group;
+   int ngroups = 0;
+
+   auto flush = [&]() {
+      for (auto& g: groups) {
+         if (g.merged) {
+            for (auto& i: g.instr)
+               static_cast<AluInstruction&>(*i).reset_flag(alu_last_instr);
+            static_cast<AluInstruction&>(*g.instr.back()).set_flag(alu_last_instr);
+         }
+         result.insert(result.end(), g.instr.begin(), g.instr.end());
+      }
+      groups.clear();
+   };
+
+   for (auto& i: block) {
+      if (i->type() == Instruction::alu) {
+         group.instr.push_back(i);
+         if (static_cast<const AluInstruction&>(*i).flag(alu_last_instr)) {
+            ++ngroups;
+            schedule_alu_group(groups, group);
+            group = AluGroup();
+         }
+         continue;
+      }
+
+      /* An unterminated group is left alone */
+      if (!group.instr.empty()) {
+         group.fixed = true;
+         groups.push_back(group);
+         group = AluGroup();
+      }
+      flush();
+      result.push_back(i);
+   }
+
+   if (!group.instr.empty()) {
+      group.fixed = true;
+      groups.push_back(group);
+   }
+   flush();
+
+   if (ngroups)
+      sfn_log << SfnLog::assembly << "Block " << block.number() << ": packed "
+              << ngroups << " ALU groups\n";
+
+   return result;
+}
+
+void AssemblyFromShaderLegacyImpl::schedule_alu_group(vector<AluGroup>& groups,
+                                                      AluGroup& group)
+{
+   analyze_alu_group(group);
+
+   int target = -1;
+   if (!group.fixed) {
+      int lookback_end = std::max(0, static_cast<int>(groups.size()) -
+                                  max_alu_schedule_lookback);
+
+      for (int k = groups.size() - 1; k >= lookback_end; --k) {
+         const auto& g = groups[k];
+
+         /* The group must come after the ones that write its sources or
+          * its destinations, and it may share the group with the ones
+          * that read its destinations, since the sources of a group are
+          * read before its results are written. */
+         if (g.fixed || overlaps(group.reads, g.writes) ||
+             overlaps(group.writes, g.writes))
+            break;
+
+         if (can_merge_alu_groups(g, group))
+            target = k;
+
+         if (overlaps(group.writes, g.reads))
+            break;
+      }
+   }
+
+   if (target < 0) {
+      groups.push_back(group);
+      return;
+   }
+
+   sfn_log << SfnLog::assembly << "Merge ALU group starting with "
+           << *group.instr[0] << " into group " << target << "\n";
+
+   auto& g = groups[target];
+   g.instr.insert(g.instr.end(), group.instr.begin(), group.instr.end());
+   for (auto r: group.reads)
+      add_unique(g.reads, r);
+   for (auto w: group.writes)
+      add_unique(g.writes, w);
+   for (auto l: group.kcache_lines)
+      add_unique(g.kcache_lines, l);
+   g.nliterals += group.nliterals;
+   g.merged = true;
+}
+
+void AssemblyFromShaderLegacyImpl::analyze_alu_group(AluGroup& group)
+{
+   for (auto& i: group.instr) {
+      const auto& ai = static_cast<const AluInstruction&>(*i);
+
+      if (ai.cf_type() != cf_alu ||
+          ai.flag(alu_update_exec) || ai.flag(alu_update_pred) ||
+          ai.flag(alu_dst_rel) || ai.flag(alu_src0_rel) ||
+          ai.flag(alu_src1_rel) || ai.flag(alu_src2_rel) ||
+          opcode_map.find(ai.opcode()) == opcode_map.end())
+         group.fixed = true;
+
+      auto dst = ai.dest();
+      if (dst && dst->type() == Value::gpr)
+         add_unique(group.writes, dst->sel() * 4 + dst->chan());
+      else
+         group.fixed = true;
+
+      for (unsigned k = 0; k < ai.n_sources(); ++k) {
+         const auto& v = ai.src(k);
+         switch (v.type()) {
+         case Value::gpr:
+            add_unique(group.reads, v.sel() * 4 + v.chan());
+            break;
+         case Value::kconst: {
+            const auto& u = static_cast<const UniformValue&>(v);
+            add_unique(group.kcache_lines,
+                       (u.kcache_bank() << 16) | ((u.sel() - 512) >> 4));
+            break;
+         }
+         case Value::literal:
+            if (!is_inline_literal(static_cast<const LiteralValue&>(v)))
+               ++group.nliterals;
+            break;
+         case Value::cinline:
+            break;
+         default:
+            group.fixed = true;
+         }
+      }
+   }
+
+   /* Kills, predicate updates, MOVA, LDS access, ... */
+   if (!group.fixed && !alu_group_fits(group.instr))
+      group.fixed = true;
+}
+
+bool AssemblyFromShaderLegacyImpl::can_merge_alu_groups(const AluGroup& first,
+                                                        const AluGroup& second)
+{
+   unsigned max_slots = m_bc->chip_class == CAYMAN ? 4 : 5;
+
+   if (first.instr.size() + second.instr.size() > max_slots)
+      return false;
+
+   /* emit_alu splits a group with more than four literals */
+   if (first.nliterals + second.nliterals > 4)
+      return false;
+
+   /* Two constant cache lines always fit into the kcache sets of a new
+    * clause, so the group will never be split at a clause boundary */
+   vector<int> kcache_lines(first.kcache_lines);
+   for (auto l: second.kcache_lines)
+      add_unique(kcache_lines, l);
+   if (kcache_lines.size() > std::max<size_t>(2, first.kcache_lines.size()))
+      return false;
+
+   vector<PInstruction> instr(first.instr);
+   instr.insert(instr.end(), second.instr.begin(), second.instr.end());
+   return alu_group_fits(instr);
+}
+
+bool AssemblyFromShaderLegacyImpl::alu_group_fits(const vector<PInstruction>& instr)
+{
+   struct r600_bytecode_alu alu[5];
+
+   if (instr.size() > 5)
+      return false;
+
+   for (unsigned n = 0; n < instr.size(); ++n) {
+      const auto& ai = static_cast<const AluInstruction&>(*instr[n]);
+      auto& a = alu[n];
+
+      memset(&a, 0, sizeof(a));
+      a.op = opcode_map.at(ai.opcode());
+      a.dst.sel = ai.dest()->sel();
+      a.dst.chan = ai.dest()->chan();
+      a.dst.write = ai.flag(alu_write);
+      a.is_op3 = ai.n_sources() == 3;
+
+      for (unsigned k = 0; k < ai.n_sources(); ++k) {
+         const auto& v = ai.src(k);
+         a.src[k].sel = v.sel();
+         a.src[k].chan = v.chan();
+         a.src[k].neg = ai.flag(AluInstruction::src_neg_flags[k]);
+         if (!a.is_op3)
+            a.src[k].abs = ai.flag(AluInstruction::src_abs_flags[k]);
+         if (v.type() == Value::literal)
+            a.src[k].value = static_cast<const LiteralValue&>(v).value();
+         else if (v.type() == Value::kconst)
+            a.src[k].kc_bank = static_cast<const UniformValue&>(v).kcache_bank();
+      }
+
+      if (ai.bank_swizzle() != alu_vec_unknown)
+         a.bank_swizzle_force = ai.bank_swizzle();
+   }
+
+   return !r600_bytecode_check_alu_group(m_bc, alu, instr.size());
+}
+
 bool AssemblyFromShaderLegacyImpl::emit_load_addr(PValue addr)
 {
    m_bc->ar_reg = addr->sel();
@@ -284,15 +284,12 @@ int prog_scope::loop_break_line() const
 
 temp_access::temp_access():
    access_mask(0),
-   needs_component_tracking(false),
    is_array_element(false)
 {
 }
 
 void temp_access::update_access_mask(int mask)
 {
-   if (access_mask && access_mask != mask)
-      needs_component_tracking = true;
    access_mask |= mask;
 }
 
@@ -337,26 +334,12 @@ inline static register_live_range make_live_range(int b, int e)
    return lt;
 }
 
-register_live_range temp_access::get_required_live_range()
+register_live_range temp_access::get_required_live_range(int chan)
 {
-   register_live_range result = make_live_range(-1, -1);
-
-   unsigned mask = access_mask;
-   while (mask) {
-      unsigned chan = u_bit_scan(&mask);
-      register_live_range lt = comp[chan].get_required_live_range();
-
-      if (lt.begin >= 0) {
-         if ((result.begin < 0) || (result.begin > lt.begin))
-            result.begin = lt.begin;
-      }
-
-      if (lt.end > result.end)
-         result.end = lt.end;
+   if (!(access_mask & (1 << chan)))
+      return make_live_range(-1, -1);
 
-      if (!needs_component_tracking)
-         break;
-   }
+   register_live_range result = comp[chan].get_required_live_range();
    result.is_array_elm = is_array_element;
    return result;
 }
@@ -720,21 +703,6 @@ register_live_range temp_comp_access::get_required_live_range()
    return make_live_range(first_write, last_read);
 }
 
-/* Helper class for sorting and searching the registers based
- * on live ranges. */
-class register_merge_record {
-public:
-   int begin;
-   int end;
-   int reg;
-   bool erase;
-   bool is_array_elm;
-
-   bool operator < (const register_merge_record& rhs) const {
-      return begin < rhs.begin;
-   }
-};
-
 LiverangeEvaluator::LiverangeEvaluator():
    line(0),
    loop_id(1),
@@ -747,7 +715,8 @@ LiverangeEvaluator::LiverangeEvaluator():
 }
 
 void LiverangeEvaluator::run(const Shader& shader,
-                             std::vector<register_live_range>& register_live_ranges)
+                             std::vector<register_comp_live_range>& register_live_ranges,
+                             std::vector<register_copy>& copies)
 {
    temp_acc.resize(register_live_ranges.size());
    fill(temp_acc.begin(), temp_acc.end(), temp_access());
@@ -788,6 +757,20 @@ void LiverangeEvaluator::run(const Shader& shader,
    for (const auto& block: shader.m_ir)
       for (const auto& ir: block)  {
          ir->evalue_liveness(*this);
+         if (ir->type() == Instruction::alu) {
+            const auto& alu = static_cast<const AluInstruction&>(*ir);
+            if (alu.is_plain_copy()) {
+               const Value& dst = *alu.dest();
+               const Value& src = alu.src(0);
+               if (dst.chan() == src.chan() && dst.chan() < 4 &&
+                   dst.sel() != src.sel() &&
+                   dst.sel() < temp_acc.size() && src.sel() < temp_acc.size())
+                  copies.push_back(register_copy{static_cast<int>(dst.sel()),
+                                                 static_cast<int>(src.sel()),
+                                                 static_cast<int>(dst.chan()),
+                                                 line});
+            }
+         }
          if (ir->type() != Instruction::alu ||
              static_cast<const AluInstruction&>(*ir).flag(alu_last_instr))
             ++line;
@@ -798,6 +781,12 @@ void LiverangeEvaluator::run(const Shader& shader,
    is_at_end = true;
 
    get_required_live_ranges(register_live_ranges);
+
+   for (auto& v: shader.m_temp) {
+      if (v.second->type() == Value::gpr &&
+          static_cast<const GPRValue&>(*v.second).is_input())
+         register_live_ranges[v.second->sel()].is_input = true;
+   }
 }
 
 
@@ -844,16 +833,33 @@ void LiverangeEvaluator::record_write(const GPRVector& dst)
    for (int i = 0; i < 4; ++i)
       if (dst.reg_i(i))
          record_write(*dst.reg_i(i));
+
+   /* The hardware writes component i of the destination register from
+    * element i of the vector, if the vector is swizzled this component
+    * is not recorded above, but another register must not claim it. */
+   for (int i = 0; i < 4; ++i) {
+      auto reg = dst.reg_i(i);
+      if (reg && reg->type() == Value::gpr && reg->chan() != static_cast<unsigned>(i)) {
+         assert(reg->sel() < temp_acc.size());
+         temp_acc[reg->sel()].record_write(line, cur_scope, 1 << i, false);
+      }
+   }
 }
 
-void LiverangeEvaluator::get_required_live_ranges(std::vector<register_live_range>& register_live_ranges)
+void LiverangeEvaluator::get_required_live_ranges(std::vector<register_comp_live_range>& register_live_ranges)
 {
    sfn_log << SfnLog::merge << "== register live ranges ==========\n";
    for(unsigned i = 0; i < register_live_ranges.size(); ++i) {
-      sfn_log << SfnLog::merge << setw(4) << i;
-      register_live_ranges[i] = temp_acc[i].get_required_live_range();
-      sfn_log << SfnLog::merge << ": [" << register_live_ranges[i].begin << ", "
-		   << register_live_ranges[i].end << "]\n";
+      auto& r = register_live_ranges[i];
+      sfn_log << SfnLog::merge << setw(4) << i << ":";
+      for (int chan = 0; chan < 4; ++chan) {
+         r.comp[chan] = temp_acc[i].get_required_live_range(chan);
+         sfn_log << SfnLog::merge << " [" << r.comp[chan].begin << ", "
+                 << r.comp[chan].end << "]";
+      }
+      r.is_array_elm = temp_acc[i].is_array_elm();
+      r.is_input = false;
+      sfn_log << SfnLog::merge << "\n";
    }
    sfn_log << SfnLog::merge << "==================================\n\n";
 }
@@ -899,91 +905,156 @@ void LiverangeEvaluator::scope_loop_break()
    cur_scope->set_loop_break_line(line);
 }
 
-/* This functions evaluates the register merges by using a binary
- * search to find suitable merge candidates. */
+/* Helper class to collect the component live ranges of the registers
+ * that were merged into one target register. */
+class register_merge_target {
+public:
+   struct range {
+      int begin;
+      int end;
+      int reg;
+   };
 
-std::vector<rename_reg_pair>
-get_temp_registers_remapping(const std::vector<register_live_range>& live_ranges)
-{
+   register_merge_target(int r):
+      reg(r) {}
 
-   std::vector<rename_reg_pair> result(live_ranges.size(), rename_reg_pair{false, false, 0});
-   std::vector<register_merge_record> reg_access;
+   void add(int r, const register_comp_live_range& lr);
 
-   for (unsigned i = 0; i < live_ranges.size(); ++i) {
-      if (live_ranges[i].begin >= 0) {
-         register_merge_record r;
-         r.begin = live_ranges[i].begin;
-         r.end = live_ranges[i].end;
-         r.is_array_elm = live_ranges[i].is_array_elm;
-         r.reg = i;
-         r.erase = false;
-         reg_access.push_back(r);
-      }
+   bool can_merge(int r, const register_comp_live_range& lr,
+                  const std::vector<register_copy>& copies) const;
+
+   int reg;
+   std::vector<range> comp[4];
+};
+
+void register_merge_target::add(int r, const register_comp_live_range& lr)
+{
+   for (int chan = 0; chan < 4; ++chan) {
+      if (lr.comp[chan].begin >= 0)
+         comp[chan].push_back(range{lr.comp[chan].begin, lr.comp[chan].end, r});
    }
+}
 
-   std::sort(reg_access.begin(), reg_access.end());
+static bool is_copy(const std::vector<register_copy>& copies,
+                    int dst, int src, int chan, int line)
+{
+   for (auto& c: copies)
+      if (c.dst == dst && c.src == src && c.chan == chan && c.line == line)
+         return true;
+   return false;
+}
 
-   for (auto& r : reg_access)
-      sfn_log << SfnLog::merge << "Use Range " <<r.reg << " ["
-              << r.begin << ", "  << r.end << "]\n";
+/* Two components interfere if their live ranges overlap. The only exception
+ * is a copy from one to the other in the line where the live range of the
+ * source ends and the one of the destination begins: within an instruction
+ * group the sources are read before the destinations are written, so both
+ * can share the component and the copy becomes a no-op. */
+bool register_merge_target::can_merge(int r, const register_comp_live_range& lr,
+                                      const std::vector<register_copy>& copies) const
+{
+   for (int chan = 0; chan < 4; ++chan) {
+      const auto& l = lr.comp[chan];
+      if (l.begin < 0)
+         continue;
 
-   auto trgt = reg_access.begin();
-   auto reg_access_end = reg_access.end();
-   auto first_erase = reg_access_end;
-   auto search_start = trgt + 1;
+      for (auto& t: comp[chan]) {
+         if (l.end < t.begin || t.end < l.begin)
+            continue;
 
-   while (trgt != reg_access_end) {
-      /* Find the next register that has a live-range starting past the
-       * search start and that is not an array element. Array elements can't
-       * be moved (Moving the whole array could be an option to be implemented later)*/
+         if (t.end == l.begin && is_copy(copies, r, t.reg, chan, l.begin))
+            continue;
 
-      sfn_log << SfnLog::merge << "Next target is "
-              << trgt->reg << "[" << trgt->begin << ", "  << trgt->end << "]\n";
+         if (l.end == t.begin && is_copy(copies, t.reg, r, chan, t.begin))
+            continue;
 
+         return false;
+      }
+   }
+   return true;
+}
 
-      auto src = upper_bound(search_start, reg_access_end, trgt->end,
-                             [](int bound, const register_merge_record& m){
-                                    return bound < m.begin && !m.is_array_elm;}
-                             );
+/* This function evaluates the register merges: The registers are visited
+ * in the order of their first write and each one is merged into the first
+ * target where all its used components are free, preferring the targets
+ * that hold the registers it is copied from or to. Since the merge is done
+ * per component, registers that use disjoint components can share a GPR,
+ * and a register that is a copy of another one can be coalesced with it. */
 
-      if (src != reg_access_end) {
-         result[src->reg].new_reg = trgt->reg;
-         result[src->reg].valid = true;
+std::vector<rename_reg_pair>
+get_temp_registers_remapping(const std::vector<register_comp_live_range>& live_ranges,
+                             const std::vector<register_copy>& copies)
+{
+   std::vector<rename_reg_pair> result(live_ranges.size(), rename_reg_pair{false, false, 0});
+   std::vector<register_merge_target> targets;
+   std::vector<int> target_of(live_ranges.size(), -1);
+   std::vector<std::pair<int, int>> movable;
+   std::vector<std::vector<int>> copy_partners(live_ranges.size());
+
+   for (auto& c: copies) {
+      copy_partners[c.dst].push_back(c.src);
+      copy_partners[c.src].push_back(c.dst);
+   }
 
-         sfn_log << SfnLog::merge << "Map "
-                 << src->reg << "[" << src->begin << ", "  << src->end << "] to  "
-                 << trgt->reg << "[" << trgt->begin << ", "  << trgt->end << ":";
-         trgt->end = src->end;
-         sfn_log << SfnLog::merge << trgt->end  << "]\n";
+   for (unsigned i = 0; i < live_ranges.size(); ++i) {
+      const auto& lr = live_ranges[i];
+      int begin = -1;
+      for (int chan = 0; chan < 4; ++chan) {
+         if (lr.comp[chan].begin >= 0 &&
+             (begin < 0 || lr.comp[chan].begin < begin))
+            begin = lr.comp[chan].begin;
+      }
+      if (begin < 0)
+         continue;
+
+      /* Array elements and inputs stay where they are, but other registers
+       * can be merged into them */
+      if (lr.is_array_elm || lr.is_input) {
+         target_of[i] = targets.size();
+         targets.push_back(register_merge_target(i));
+         targets.back().add(i, lr);
+      } else {
+         movable.push_back(std::make_pair(begin, i));
+      }
+   }
 
-         /* Since we only search forward, don't remove the renamed
-          * register just now, only mark it. */
-         src->erase = true;
+   std::stable_sort(movable.begin(), movable.end(),
+                    [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+                       return a.first < b.first;});
 
-         if (first_erase == reg_access_end)
-            first_erase = src;
+   for (auto& m: movable) {
+      int reg = m.second;
+      const auto& lr = live_ranges[reg];
+      int trgt = -1;
 
-         search_start = src + 1;
-      } else {
-         /* Moving to the next target register it is time to remove
-          * the already merged registers from the search range */
-         if (first_erase != reg_access_end) {
-	    auto outp = first_erase;
-	    auto inp = first_erase + 1;
-
-            while (inp != reg_access_end) {
-               if (!inp->erase)
-                  *outp++ = *inp;
-               ++inp;
-            }
+      for (auto partner: copy_partners[reg]) {
+         if (target_of[partner] < 0)
+            continue;
 
-            reg_access_end = outp;
-            first_erase = reg_access_end;
+         if (targets[target_of[partner]].can_merge(reg, lr, copies)) {
+            trgt = target_of[partner];
+            break;
          }
-         ++trgt;
-         search_start = trgt + 1;
       }
+
+      for (unsigned t = 0; trgt < 0 && t < targets.size(); ++t) {
+         if (targets[t].can_merge(reg, lr, copies))
+            trgt = t;
+      }
+
+      if (trgt < 0) {
+         trgt = targets.size();
+         targets.push_back(register_merge_target(reg));
+      } else {
+         result[reg].new_reg = targets[trgt].reg;
+         result[reg].valid = true;
+         sfn_log << SfnLog::merge << "Map " << reg << " to "
+                 << targets[trgt].reg << "\n";
+      }
+
+      targets[trgt].add(reg, lr);
+      target_of[reg] = trgt;
    }
+
    return result;
 }
 
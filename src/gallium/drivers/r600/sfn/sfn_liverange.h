@@ -50,6 +50,26 @@ struct register_live_range {
    bool is_array_elm;
 };
 
+/** The live ranges of the four components of a temporary register, a
+ * component with begin == -1 is not used. Array elements and shader inputs
+ * are bound to their register and can not be moved.
+ */
+struct register_comp_live_range {
+   register_live_range comp[4];
+   bool is_array_elm;
+   bool is_input;
+};
+
+/** A MOV that copies a component of register src to the same component
+ * of register dst in the given line. If both registers end up being merged
+ * the copy can be removed. */
+struct register_copy {
+   int dst;
+   int src;
+   int chan;
+   int line;
+};
+
 enum prog_scope_type {
    outer_scope,           /* Outer program scope */
    loop_body,             /* Inside a loop */
@@ -195,13 +215,13 @@ public:
    temp_access();
    void record_read(int line, prog_scope *scope, int swizzle, bool is_array_elm);
    void record_write(int line, prog_scope *scope, int writemask, bool is_array_elm);
-   register_live_range get_required_live_range();
+   register_live_range get_required_live_range(int chan);
+   bool is_array_elm() const {return is_array_element;}
 private:
    void update_access_mask(int mask);
 
    temp_comp_access comp[4];
    int access_mask;
-   bool needs_component_tracking;
    bool is_array_element;
 };
 
@@ -270,7 +290,8 @@ public:
    LiverangeEvaluator();
 
    void run(const Shader& shader,
-            std::vector<register_live_range> &register_live_ranges);
+            std::vector<register_comp_live_range>& register_live_ranges,
+            std::vector<register_copy>& copies);
 
    void scope_if();
    void scope_else();
@@ -291,7 +312,7 @@ private:
                             int lvl, int s_begin);
 
 
-   void get_required_live_ranges(std::vector<register_live_range>& register_live_ranges);
+   void get_required_live_ranges(std::vector<register_comp_live_range>& register_live_ranges);
 
    int line;
    int loop_id;
@@ -307,7 +328,8 @@ private:
 };
 
 std::vector<rename_reg_pair>
-get_temp_registers_remapping(const std::vector<register_live_range>& live_ranges);
+get_temp_registers_remapping(const std::vector<register_comp_live_range>& live_ranges,
+                             const std::vector<register_copy>& copies);
 
 } // end namespace r600
 
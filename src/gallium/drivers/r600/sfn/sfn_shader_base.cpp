@@ -192,13 +192,14 @@ void ShaderFromNirProcessor::remap_registers()
    if (!rc)
       return;
 
-   std::vector<register_live_range> register_live_ranges(rc);
+   std::vector<register_comp_live_range> register_live_ranges(rc);
+   std::vector<register_copy> copies;
 
    auto temp_register_map = get_temp_registers();
 
    Shader sh{m_output, temp_register_map};
-   LiverangeEvaluator().run(sh, register_live_ranges);
-   auto register_map = get_temp_registers_remapping(register_live_ranges);
+   LiverangeEvaluator().run(sh, register_live_ranges, copies);
+   auto register_map = get_temp_registers_remapping(register_live_ranges, copies);
 
    sfn_log << SfnLog::merge << "=========Mapping===========\n";
    for (size_t  i = 0; i < register_map.size(); ++i)
@@ -209,6 +210,11 @@ void ShaderFromNirProcessor::remap_registers()
    for (auto& block: m_output)
       block.remap_registers(vmap0);
 
+   int removed_copies = 0;
+   for (auto& block: m_output)
+      removed_copies += block.remove_redundant_copies();
+   sfn_log << SfnLog::merge << "Removed " << removed_copies << " coalesced copies\n";
+
    remap_shader_info(m_sh_info, register_map, temp_register_map);
 
    /* Mark inputs as used registers, these registers should no be remapped */
@@ -296,8 +296,10 @@ static void si_bind_compute_state(struct pipe_context *ctx, void *state)
       return;
 
    /* Wait because we need active slot usage masks. */
-   if (program->ir_type != PIPE_SHADER_IR_NATIVE)
+   if (program->ir_type != PIPE_SHADER_IR_NATIVE) {
+      util_queue_prioritize_job(&sctx->screen->shader_compiler_queue, &sel->ready);
       util_queue_fence_wait(&sel->ready);
+   }
 
    si_set_active_descriptors(sctx,
                              SI_DESCS_FIRST_COMPUTE + SI_SHADER_DESCS_CONST_AND_SHADER_BUFFERS,
@@ -1039,6 +1039,15 @@ void si_shader_dump_stats_for_shader_db(struct si_screen *screen, struct si_shad
                       conf->num_sgprs, conf->num_vgprs, si_get_shader_binary_size(screen, shader),
                       conf->lds_size, conf->scratch_bytes_per_wave, shader->info.max_simd_waves,
                       conf->spilled_sgprs, conf->spilled_vgprs, shader->info.private_mem_vgprs);
+
+   const struct pipe_shader_stats stats = {
+      .stage = _mesa_shader_stage_to_abbrev(tgsi_processor_to_shader_stage(shader->selector->type)),
+      .dispatch_width = si_get_shader_wave_size(shader),
+      .spills = conf->spilled_sgprs + conf->spilled_vgprs,
+      .registers = conf->num_vgprs,
+      .code_size = si_get_shader_binary_size(screen, shader),
+   };
+   pipe_debug_shader_stats(debug, &stats);
 }
 
 static void si_shader_dump_stats(struct si_screen *sscreen, struct si_shader *shader, FILE *file,
@@ -1325,6 +1334,16 @@ static bool si_vs_needs_prolog(const struct si_shader_selector *sel,
           (ngg_cull_shader && key->opt.ngg_culling & SI_NGG_CULL_GS_FAST_LAUNCH_ALL);
 }
 
+/* Give back a shader returned by get_nir_shader with free_nir set. The NIR->LLVM
+ * translation doesn't change the shader in ways that matter to the next
+ * variant, so keep it for the next compile instead of deserializing again.
+ */
+static void si_put_nir_shader(struct si_shader_selector *sel, struct nir_shader *nir)
+{
+   if (p_atomic_cmpxchg(&sel->nir_cache, NULL, nir) != NULL)
+      ralloc_free(nir);
+}
+
 static bool si_build_main_function(struct si_shader_context *ctx, struct si_shader *shader,
                                    struct nir_shader *nir, bool free_nir, bool ngg_cull_shader)
 {
@@ -1514,7 +1533,7 @@ static bool si_build_main_function(struct si_shader_context *ctx, struct si_shad
 
    bool success = si_nir_build_llvm(ctx, nir);
    if (free_nir)
-      ralloc_free(nir);
+      si_put_nir_shader(shader->selector, nir);
    if (!success) {
       fprintf(stderr, "Failed to translate shader from NIR to LLVM\n");
       return false;
@@ -1602,12 +1621,20 @@ static struct nir_shader *get_nir_shader(struct si_shader_selector *sel, bool *f
    if (sel->nir) {
       return sel->nir;
    } else if (sel->nir_binary) {
+      *free_nir = true;
+
+      /* Reuse the copy deserialized by a previous variant compile if no
+       * other compile is holding it.
+       */
+      struct nir_shader *nir = p_atomic_xchg(&sel->nir_cache, NULL);
+      if (nir)
+         return nir;
+
       struct pipe_screen *screen = &sel->screen->b;
       const void *options = screen->get_compiler_options(screen, PIPE_SHADER_IR_NIR, sel->type);
 
       struct blob_reader blob_reader;
       blob_reader_init(&blob_reader, sel->nir_binary, sel->nir_size);
-      *free_nir = true;
       return nir_deserialize(NULL, options, &blob_reader);
    }
    return NULL;
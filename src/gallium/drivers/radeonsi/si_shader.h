@@ -431,6 +431,9 @@ struct si_shader_selector {
    struct nir_shader *nir;
    void *nir_binary;
    unsigned nir_size;
+   /* nir_binary deserialized by a previous variant compile, or NULL while a
+    * compile is using it. */
+   struct nir_shader *nir_cache;
 
    struct pipe_stream_output_info so;
    struct si_shader_info info;
@@ -30,6 +30,7 @@
 #include "util/u_prim.h"
 #include "util/u_suballoc.h"
 #include "util/u_upload_mgr.h"
+#include "util/u_cpu_trace.h"
 
 /* special primitive types */
 #define SI_PRIM_RECTANGLE_LIST PIPE_PRIM_MAX
@@ -550,7 +551,8 @@ static unsigned si_conv_prim_to_gs_out(unsigned mode)
 }
 
 /* rast_prim is the primitive type after GS. */
-static void si_emit_rasterizer_prim_state(struct si_context *sctx)
+static ALWAYS_INLINE void si_emit_rasterizer_prim_state(struct si_context *sctx, bool HAS_GS,
+                                                         bool NGG)
 {
    struct radeon_cmdbuf *cs = sctx->gfx_cs;
    enum pipe_prim_type rast_prim = sctx->current_rast_prim;
@@ -569,7 +571,7 @@ static void si_emit_rasterizer_prim_state(struct si_context *sctx)
    }
 
    unsigned gs_out_prim = si_conv_prim_to_gs_out(rast_prim);
-   if (unlikely(gs_out_prim != sctx->last_gs_out_prim && (sctx->ngg || sctx->gs_shader.cso))) {
+   if (unlikely(gs_out_prim != sctx->last_gs_out_prim && (NGG || HAS_GS))) {
       radeon_set_context_reg(cs, R_028A6C_VGT_GS_OUT_PRIM_TYPE, gs_out_prim);
       sctx->last_gs_out_prim = gs_out_prim;
    }
@@ -577,7 +579,7 @@ static void si_emit_rasterizer_prim_state(struct si_context *sctx)
    if (initial_cdw != cs->current.cdw)
       sctx->context_roll = true;
 
-   if (sctx->ngg) {
+   if (NGG) {
       unsigned vtx_index = rs->flatshade_first ? 0 : gs_out_prim;
 
       sctx->current_vs_state &= C_VS_STATE_OUTPRIM & C_VS_STATE_PROVOKING_VTX_INDEX;
@@ -660,13 +662,14 @@ static void si_emit_ia_multi_vgt_param(struct si_context *sctx, const struct pip
 /* GFX10 removed IA_MULTI_VGT_PARAM in exchange for GE_CNTL.
  * We overload last_multi_vgt_param.
  */
-static void gfx10_emit_ge_cntl(struct si_context *sctx, unsigned num_patches)
+static ALWAYS_INLINE void gfx10_emit_ge_cntl(struct si_context *sctx, unsigned num_patches,
+                                              bool HAS_TESS, bool HAS_GS, bool NGG)
 {
    union si_vgt_param_key key = sctx->ia_multi_vgt_param_key;
    unsigned ge_cntl;
 
-   if (sctx->ngg) {
-      if (sctx->tes_shader.cso) {
+   if (NGG) {
+      if (HAS_TESS) {
          ge_cntl = S_03096C_PRIM_GRP_SIZE(num_patches) |
                    S_03096C_VERT_GRP_SIZE(0) |
                    S_03096C_BREAK_WAVE_AT_EOI(key.u.tess_uses_prim_id);
@@ -677,10 +680,10 @@ static void gfx10_emit_ge_cntl(struct si_context *sctx, unsigned num_patches)
       unsigned primgroup_size;
       unsigned vertgroup_size;
 
-      if (sctx->tes_shader.cso) {
+      if (HAS_TESS) {
          primgroup_size = num_patches; /* must be a multiple of NUM_PATCHES */
          vertgroup_size = 0;
-      } else if (sctx->gs_shader.cso) {
+      } else if (HAS_GS) {
          unsigned vgt_gs_onchip_cntl = sctx->gs_shader.current->ctx_reg.gs.vgt_gs_onchip_cntl;
          primgroup_size = G_028A44_GS_PRIMS_PER_SUBGRP(vgt_gs_onchip_cntl);
          vertgroup_size = G_028A44_ES_VERTS_PER_SUBGRP(vgt_gs_onchip_cntl);
@@ -701,15 +704,17 @@ static void gfx10_emit_ge_cntl(struct si_context *sctx, unsigned num_patches)
    }
 }
 
-static void si_emit_draw_registers(struct si_context *sctx, const struct pipe_draw_info *info,
-                                   enum pipe_prim_type prim, unsigned num_patches,
-                                   unsigned instance_count, bool primitive_restart)
+static ALWAYS_INLINE void si_emit_draw_registers(struct si_context *sctx,
+                                                  const struct pipe_draw_info *info,
+                                                  enum pipe_prim_type prim, unsigned num_patches,
+                                                  unsigned instance_count, bool primitive_restart,
+                                                  bool HAS_TESS, bool HAS_GS, bool NGG)
 {
    struct radeon_cmdbuf *cs = sctx->gfx_cs;
    unsigned vgt_prim = si_conv_pipe_prim(prim);
 
    if (sctx->chip_class >= GFX10)
-      gfx10_emit_ge_cntl(sctx, num_patches);
+      gfx10_emit_ge_cntl(sctx, num_patches, HAS_TESS, HAS_GS, NGG);
    else
       si_emit_ia_multi_vgt_param(sctx, info, prim, num_patches, instance_count, primitive_restart);
 
@@ -1474,14 +1479,16 @@ static void si_get_draw_start_count(struct si_context *sctx, const struct pipe_d
    }
 }
 
-static void si_emit_all_states(struct si_context *sctx, const struct pipe_draw_info *info,
-                               enum pipe_prim_type prim, unsigned instance_count,
-                               bool primitive_restart, unsigned skip_atom_mask)
+static ALWAYS_INLINE void si_emit_all_states(struct si_context *sctx,
+                                              const struct pipe_draw_info *info,
+                                              enum pipe_prim_type prim, unsigned instance_count,
+                                              bool primitive_restart, unsigned skip_atom_mask,
+                                              bool HAS_TESS, bool HAS_GS, bool NGG)
 {
    unsigned num_patches = 0;
 
-   si_emit_rasterizer_prim_state(sctx);
-   if (sctx->tes_shader.cso)
+   si_emit_rasterizer_prim_state(sctx, HAS_GS, NGG);
+   if (HAS_TESS)
       si_emit_derived_tess_state(sctx, info, &num_patches);
 
    /* Emit state atoms. */
@@ -1507,7 +1514,8 @@ static void si_emit_all_states(struct si_context *sctx, const struct pipe_draw_i
 
    /* Emit draw states. */
    si_emit_vs_state(sctx, info);
-   si_emit_draw_registers(sctx, info, prim, num_patches, instance_count, primitive_restart);
+   si_emit_draw_registers(sctx, info, prim, num_patches, instance_count, primitive_restart,
+                          HAS_TESS, HAS_GS, NGG);
 }
 
 static bool si_all_vs_resources_read_only(struct si_context *sctx, struct pipe_resource *indexbuf)
@@ -1599,8 +1607,14 @@ static ALWAYS_INLINE bool pd_msg(const char *s)
    return false;
 }
 
-static void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *info)
+/* si_draw_vbo is specialized for whether tessellation, a geometry shader and
+ * NGG are used, so that the checks of these fold away.  The variants are
+ * selected by si_select_draw_vbo when the shaders or NGG change.
+ */
+static ALWAYS_INLINE void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *info,
+                                      bool HAS_TESS, bool HAS_GS, bool NGG)
 {
+   UTIL_CPU_TRACE_FUNC();
    struct si_context *sctx = (struct si_context *)ctx;
    struct si_state_rasterizer *rs = sctx->queued.named.rasterizer;
    struct pipe_resource *indexbuf = info->index.resource;
@@ -1627,10 +1641,13 @@ static void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *i
          return;
    }
 
+   assert(HAS_TESS == !!sctx->tes_shader.cso && HAS_GS == !!sctx->gs_shader.cso &&
+          NGG == sctx->ngg);
+
    struct si_shader_selector *vs = sctx->vs_shader.cso;
    if (unlikely(!vs || sctx->num_vertex_elements < vs->num_vs_inputs ||
                 (!sctx->ps_shader.cso && !rs->rasterizer_discard) ||
-                (!!sctx->tes_shader.cso != (prim == PIPE_PRIM_PATCHES)))) {
+                (HAS_TESS != (prim == PIPE_PRIM_PATCHES)))) {
       assert(0);
       return;
    }
@@ -1659,10 +1676,10 @@ static void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *i
     * This must be done after si_decompress_textures, which can call
     * draw_vbo recursively, and before si_update_shaders, which uses
     * current_rast_prim for this draw_vbo call. */
-   if (sctx->gs_shader.cso) {
+   if (HAS_GS) {
       /* Only possibilities: POINTS, LINE_STRIP, TRIANGLES */
       rast_prim = sctx->gs_shader.cso->rast_prim;
-   } else if (sctx->tes_shader.cso) {
+   } else if (HAS_TESS) {
       /* Only possibilities: POINTS, LINE_STRIP, TRIANGLES */
       rast_prim = sctx->tes_shader.cso->rast_prim;
    } else if (util_rast_prim_is_triangles(prim)) {
@@ -1681,7 +1698,7 @@ static void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *i
       sctx->do_update_shaders = true;
    }
 
-   if (sctx->tes_shader.cso && sctx->screen->info.has_ls_vgpr_init_bug) {
+   if (HAS_TESS && sctx->screen->info.has_ls_vgpr_init_bug) {
       /* Determine whether the LS VGPR fix should be applied.
        *
        * It is only required when num input CPs > num output CPs,
@@ -1699,7 +1716,7 @@ static void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *i
       }
    }
 
-   if (sctx->chip_class <= GFX9 && sctx->gs_shader.cso) {
+   if (sctx->chip_class <= GFX9 && HAS_GS) {
       /* Determine whether the GS triangle strip adjacency fix should
        * be applied. Rotate every other triangle if
        * - triangle strips with adjacency are fed to the GS and
@@ -1707,7 +1724,7 @@ static void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *i
        *   when the restart occurs after an odd number of triangles).
        */
       bool gs_tri_strip_adj_fix =
-         !sctx->tes_shader.cso && prim == PIPE_PRIM_TRIANGLE_STRIP_ADJACENCY && !primitive_restart;
+         !HAS_TESS && prim == PIPE_PRIM_TRIANGLE_STRIP_ADJACENCY && !primitive_restart;
 
       if (gs_tri_strip_adj_fix != sctx->gs_tri_strip_adj_fix) {
          sctx->gs_tri_strip_adj_fix = gs_tri_strip_adj_fix;
@@ -1820,8 +1837,8 @@ static void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *i
         (!sctx->num_pipeline_stat_queries && !sctx->streamout.prims_gen_query_enabled) ||
         pd_msg("pipestat or primgen query")) &&
        (!sctx->vertex_elements->instance_divisor_is_fetched || pd_msg("loads instance divisors")) &&
-       (!sctx->tes_shader.cso || pd_msg("uses tess")) &&
-       (!sctx->gs_shader.cso || pd_msg("uses GS")) &&
+       (!HAS_TESS || pd_msg("uses tess")) &&
+       (!HAS_GS || pd_msg("uses GS")) &&
        (!sctx->ps_shader.cso->info.uses_primid || pd_msg("PS uses PrimID")) &&
        !rs->polygon_mode_enabled &&
 #if SI_PRIM_DISCARD_DEBUG /* same as cso->prim_discard_cs_allowed */
@@ -1867,16 +1884,16 @@ static void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *i
    }
 
    /* Update NGG culling settings. */
-   if (sctx->ngg && !dispatch_prim_discard_cs && rast_prim == PIPE_PRIM_TRIANGLES &&
-       !sctx->gs_shader.cso && /* GS doesn't support NGG culling. */
+   if (NGG && !dispatch_prim_discard_cs && rast_prim == PIPE_PRIM_TRIANGLES &&
+       !HAS_GS && /* GS doesn't support NGG culling. */
        (sctx->screen->always_use_ngg_culling_all ||
-        (sctx->tes_shader.cso && sctx->screen->always_use_ngg_culling_tess) ||
+        (HAS_TESS && sctx->screen->always_use_ngg_culling_tess) ||
         /* At least 1024 non-indexed vertices (8 subgroups) are needed
          * per draw call (no TES/GS) to enable NGG culling.
          */
         (!index_size && direct_count >= 1024 &&
          (prim == PIPE_PRIM_TRIANGLES || prim == PIPE_PRIM_TRIANGLE_STRIP) &&
-         !sctx->tes_shader.cso)) &&
+         !HAS_TESS)) &&
        si_get_vs(sctx)->cso->ngg_culling_allowed) {
       unsigned ngg_culling = 0;
 
@@ -1899,8 +1916,7 @@ static void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *i
       /* Use NGG fast launch for certain non-indexed primitive types.
        * A draw must have at least 1 full primitive.
        */
-      if (ngg_culling && !index_size && direct_count >= 3 && !sctx->tes_shader.cso &&
-          !sctx->gs_shader.cso) {
+      if (ngg_culling && !index_size && direct_count >= 3 && !HAS_TESS && !HAS_GS) {
          if (prim == PIPE_PRIM_TRIANGLES)
             ngg_culling |= SI_NGG_CULL_GS_FAST_LAUNCH_TRI_LIST;
          else if (prim == PIPE_PRIM_TRIANGLE_STRIP)
@@ -1976,7 +1992,8 @@ static void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *i
          goto return_cleanup;
 
       /* Emit all states except possibly render condition. */
-      si_emit_all_states(sctx, info, prim, instance_count, primitive_restart, masked_atoms);
+      si_emit_all_states(sctx, info, prim, instance_count, primitive_restart, masked_atoms,
+                         HAS_TESS, HAS_GS, NGG);
       sctx->emit_cache_flush(sctx);
       /* <-- CUs are idle here. */
 
@@ -2012,7 +2029,8 @@ static void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *i
       if (!si_upload_graphics_shader_descriptors(sctx))
          goto return_cleanup;
 
-      si_emit_all_states(sctx, info, prim, instance_count, primitive_restart, masked_atoms);
+      si_emit_all_states(sctx, info, prim, instance_count, primitive_restart, masked_atoms,
+                         HAS_TESS, HAS_GS, NGG);
 
       if (sctx->screen->info.has_gfx9_scissor_bug &&
           (sctx->context_roll || si_is_atom_dirty(sctx, &sctx->atoms.s.scissors)))
@@ -2075,6 +2093,35 @@ return_cleanup:
       pipe_resource_reference(&indexbuf, NULL);
 }
 
+#define SI_DRAW_VBO_VARIANT(tess, gs, ngg)                                                  \
+   static void si_draw_vbo_##tess##_##gs##_##ngg(struct pipe_context *ctx,                 \
+                                                 const struct pipe_draw_info *info)        \
+   {                                                                                       \
+      si_draw_vbo(ctx, info, tess, gs, ngg);                                               \
+   }
+
+SI_DRAW_VBO_VARIANT(0, 0, 0)
+SI_DRAW_VBO_VARIANT(0, 0, 1)
+SI_DRAW_VBO_VARIANT(0, 1, 0)
+SI_DRAW_VBO_VARIANT(0, 1, 1)
+SI_DRAW_VBO_VARIANT(1, 0, 0)
+SI_DRAW_VBO_VARIANT(1, 0, 1)
+SI_DRAW_VBO_VARIANT(1, 1, 0)
+SI_DRAW_VBO_VARIANT(1, 1, 1)
+
+/* Indexed by [has_tess][has_gs][ngg]. */
+static void (*const si_draw_vbo_variants[2][2][2])(struct pipe_context *,
+                                                   const struct pipe_draw_info *) = {
+   {{si_draw_vbo_0_0_0, si_draw_vbo_0_0_1}, {si_draw_vbo_0_1_0, si_draw_vbo_0_1_1}},
+   {{si_draw_vbo_1_0_0, si_draw_vbo_1_0_1}, {si_draw_vbo_1_1_0, si_draw_vbo_1_1_1}},
+};
+
+void si_select_draw_vbo(struct si_context *sctx)
+{
+   sctx->b.draw_vbo =
+      si_draw_vbo_variants[!!sctx->tes_shader.cso][!!sctx->gs_shader.cso][sctx->ngg];
+}
+
 static void si_draw_rectangle(struct blitter_context *blitter, void *vertex_elements_cso,
                               blitter_get_vs_func get_vs, int x1, int y1, int x2, int y2,
                               float depth, unsigned num_instances, enum blitter_attrib_type type,
@@ -2111,7 +2158,7 @@ static void si_draw_rectangle(struct blitter_context *blitter, void *vertex_elem
    sctx->vertex_buffer_pointer_dirty = false;
    sctx->vertex_buffer_user_sgprs_dirty = false;
 
-   si_draw_vbo(pipe, &info);
+   sctx->b.draw_vbo(pipe, &info);
 }
 
 void si_trace_emit(struct si_context *sctx)
@@ -2130,7 +2177,7 @@ void si_trace_emit(struct si_context *sctx)
 
 void si_init_draw_functions(struct si_context *sctx)
 {
-   sctx->b.draw_vbo = si_draw_vbo;
+   si_select_draw_vbo(sctx);
 
    sctx->blitter->draw_rectangle = si_draw_rectangle;
 
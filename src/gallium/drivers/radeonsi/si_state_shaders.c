@@ -35,6 +35,7 @@
 #include "util/u_async_debug.h"
 #include "util/u_memory.h"
 #include "util/u_prim.h"
+#include "util/u_cpu_trace.h"
 
 /* SHADER_CACHE */
 
@@ -2097,6 +2098,23 @@ static bool si_check_missing_main_part(struct si_screen *sscreen, struct si_shad
    return true;
 }
 
+/* Return whether the variant for the key without the "opt" flags has been
+ * compiled successfully. The selector mutex must be held.
+ */
+static bool si_has_unoptimized_variant(struct si_shader_selector *sel,
+                                       const struct si_shader_key *key)
+{
+   struct si_shader_key unopt_key = *key;
+
+   memset(&unopt_key.opt, 0, sizeof(unopt_key.opt));
+
+   for (struct si_shader *iter = sel->first_variant; iter; iter = iter->next_variant) {
+      if (memcmp(&iter->key, &unopt_key, sizeof(unopt_key)) == 0)
+         return util_queue_fence_is_signalled(&iter->ready) && !iter->compilation_failed;
+   }
+   return false;
+}
+
 /**
  * Select a shader variant according to the shader key.
  *
@@ -2142,8 +2160,10 @@ current_not_ready:
     * Only wait if we are in a draw call. Don't wait if we are
     * in a compiler thread.
     */
-   if (thread_index < 0)
+   if (thread_index < 0) {
+      util_queue_prioritize_job(&sscreen->shader_compiler_queue, &sel->ready);
       util_queue_fence_wait(&sel->ready);
+   }
 
    simple_mtx_lock(&sel->mutex);
 
@@ -2264,8 +2284,14 @@ current_not_ready:
    shader->is_monolithic =
       is_pure_monolithic || memcmp(&key->opt, &zeroed.opt, sizeof(key->opt)) != 0;
 
-   /* The prim discard CS is always optimized. */
-   shader->is_optimized = (!is_pure_monolithic || key->opt.vs_as_prim_discard_cs) &&
+   /* The prim discard CS is always optimized.
+    *
+    * Pure monolithic shaders have no generic variant to fall back to, so
+    * their optimized variants are only compiled asynchronously if the same
+    * variant without the optimizations is already available.
+    */
+   shader->is_optimized = (!is_pure_monolithic || key->opt.vs_as_prim_discard_cs ||
+                           si_has_unoptimized_variant(sel, key)) &&
                           memcmp(&key->opt, &zeroed.opt, sizeof(key->opt)) != 0;
 
    /* If it's an optimized shader, compile it asynchronously. */
@@ -2371,6 +2397,7 @@ static void si_parse_next_shader_property(const struct si_shader_info *info, boo
  */
 static void si_init_shader_selector_async(void *job, int thread_index)
 {
+   UTIL_CPU_TRACE_FUNC();
    struct si_shader_selector *sel = (struct si_shader_selector *)job;
    struct si_screen *sscreen = sel->screen;
    struct ac_llvm_compiler *compiler;
@@ -2959,6 +2986,7 @@ bool si_update_ngg(struct si_context *sctx)
 
       sctx->ngg = new_ngg;
       sctx->last_gs_out_prim = -1; /* reset this so that it gets updated */
+      si_select_draw_vbo(sctx);
       return true;
    }
    return false;
@@ -2987,6 +3015,7 @@ static void si_bind_gs_shader(struct pipe_context *ctx, void *state)
    if (ngg_changed || enable_changed)
       si_shader_change_notify(sctx);
    if (enable_changed) {
+      si_select_draw_vbo(sctx);
       if (sctx->ia_multi_vgt_param_key.u.uses_tess)
          si_update_tess_uses_prim_id(sctx);
    }
@@ -3040,8 +3069,10 @@ static void si_bind_tes_shader(struct pipe_context *ctx, void *state)
    bool ngg_changed = si_update_ngg(sctx);
    if (ngg_changed || enable_changed)
       si_shader_change_notify(sctx);
-   if (enable_changed)
+   if (enable_changed) {
       sctx->last_tes_sh_base = -1; /* invalidate derived tess state */
+      si_select_draw_vbo(sctx);
+   }
    si_update_vs_viewport_state(sctx);
    si_set_active_descriptors_for_shader(sctx, sel);
    si_update_streamout_state(sctx);
@@ -3177,6 +3208,7 @@ static void si_destroy_shader_selector(struct pipe_context *ctx, void *cso)
    util_queue_fence_destroy(&sel->ready);
    simple_mtx_destroy(&sel->mutex);
    ralloc_free(sel->nir);
+   ralloc_free(sel->nir_cache);
    free(sel->nir_binary);
    free(sel);
 }
@@ -54,6 +54,15 @@ KNOBS = [
         'category'  : 'debug_adv',
     }],
 
+    ['STREAMING_STORETILE_THRESHOLD', {
+        'type'      : 'uint32_t',
+        'default'   : '8',
+        'desc'      : ['Size in MB of linear and TileY render targets from which StoreTile',
+                       'writes macrotiles with non-temporal stores, keeping them out of the',
+                       'caches.  0 disables.'],
+        'category'  : 'perf_adv',
+    }],
+
     ['FAST_CLEAR', {
         'type'      : 'bool',
         'default'   : 'true',
@@ -108,6 +117,15 @@ KNOBS = [
         'category'  : 'perf',
     }],
 
+    ['NUMA_TILE_ROWS', {
+        'type'      : 'bool',
+        'default'   : 'false',
+        'desc'      : ['Assign whole rows of macrotiles to NUMA nodes instead of a checkerboard',
+                       'of macrotiles.  Render targets are then placed in memory so that each',
+                       'row lives on the node whose workers load and store it.'],
+        'category'  : 'perf',
+    }],
+
     ['BASE_CORE', {
         'type'      : 'uint32_t',
         'default'   : '0',
@@ -178,6 +196,15 @@ KNOBS = [
         'category'  : 'perf_adv',
     }],
 
+    ['DISPATCH_BATCH_THREADS', {
+        'type'      : 'uint32_t',
+        'default'   : '1024',
+        'desc'      : ['Number of compute shader invocations a worker takes at once.',
+                       'Thread groups smaller than this are handed out in batches of',
+                       'contiguous groups.  0 or 1 hands out one group at a time.'],
+        'category'  : 'perf_adv',
+    }],
+
 
     ['DEBUG_OUTPUT_DIR', {
         'type'      : 'std::string',
@@ -549,6 +549,12 @@ static SIMDINLINE void SIMDCALL
     _mm_stream_ps(p, a);
 }
 
+static SIMDINLINE void SIMDCALL
+                       stream_si(Integer* p, Integer a) // *p = a   (same as store_si, but doesn't keep memory in cache)
+{
+    _mm_stream_si128(&p->v, a);
+}
+
 static SIMDINLINE Float SIMDCALL set_ps(float in3, float in2, float in1, float in0)
 {
     return _mm_set_ps(in3, in2, in1, in0);
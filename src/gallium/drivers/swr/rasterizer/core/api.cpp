@@ -271,7 +271,8 @@ void QueueWork(SWR_CONTEXT* pContext)
             uint32_t curDraw[2] = {pContext->pCurDrawContext->drawId,
                                    pContext->pCurDrawContext->drawId};
             WorkOnFifoFE(pContext, 0, curDraw[0]);
-            WorkOnFifoBE(pContext, 0, curDraw[1], *pContext->pSingleThreadLockedTiles, 0, 0);
+            WorkOnFifoBE(
+                pContext, 0, curDraw[1], *pContext->pSingleThreadLockedTiles, 0, 0, 0, 1);
         }
         else
         {
@@ -332,6 +333,17 @@ DRAW_CONTEXT* GetDrawContext(SWR_CONTEXT* pContext, bool isSplitDraw = false)
             // Take this opportunity to clean-up old arena allocations
             pContext->cachingArenaAllocator.FreeOldBlocks();
 
+#if defined(KNOB_ENABLE_AR)
+            ArenaStats arenaStats = pContext->cachingArenaAllocator.GetAndResetStats();
+            ArchRast::Dispatch(pContext->pArContext[pContext->NumWorkerThreads],
+                               ArchRast::ArenaStatsEvent(uint32_t(curDraw),
+                                                         arenaStats.hitCount,
+                                                         arenaStats.missCount,
+                                                         arenaStats.trimmedSize,
+                                                         arenaStats.retainedSize,
+                                                         arenaStats.allocatedSize));
+#endif
+
             pContext->lastFrameChecked = pContext->frameCount;
             pContext->lastDrawChecked  = curDraw;
         }
@@ -1045,6 +1057,60 @@ void SetupPipeline(DRAW_CONTEXT* pDC)
 
     pState->state.colorHottileEnable = hotTileEnable;
 
+    // Attachments that don't need to be loaded before a triangle covering the whole macrotile is
+    // drawn to them: every sample passes, and the result doesn't depend on the old contents.
+    // Alpha test and alpha to coverage live in the blend jit, so any blend function disables it.
+    // User clip distances clear coverage per pixel in the backend, so they disable it too.
+    const SWR_DEPTH_STENCIL_STATE& dsState = pState->state.depthStencilState;
+    bool stencilPasses =
+        !dsState.stencilTestEnable ||
+        (dsState.stencilTestFunc == ZFUNC_ALWAYS &&
+         (!dsState.doubleSidedStencilTestEnable || dsState.backfaceStencilTestFunc == ZFUNC_ALWAYS));
+    bool depthPasses = (!dsState.depthTestEnable || dsState.depthTestFunc == ZFUNC_ALWAYS) &&
+                       !pState->state.depthBoundsState.depthBoundsTestEnable;
+    uint32_t fullSampleMask = (1 << GetNumSamples(rastState.sampleCount)) - 1;
+    uint32_t overwriteMask  = 0;
+    bool     usesBlendFunc  = false;
+
+    for (uint32_t rt = 0; rt < SWR_NUM_RENDERTARGETS; ++rt)
+    {
+        if ((hotTileEnable & (1 << rt)) && pState->state.pfnBlendFunc[rt] != nullptr)
+        {
+            usesBlendFunc = true;
+        }
+    }
+
+    if (stencilPasses && depthPasses && !psState.killsPixel && !usesBlendFunc &&
+        pState->state.backendState.clipDistanceMask == 0 &&
+        (pState->state.blendState.sampleMask & fullSampleMask) == fullSampleMask)
+    {
+        if (psState.pfnPixelShader != nullptr)
+        {
+            DWORD    rt;
+            uint32_t rtMask = hotTileEnable;
+            while (_BitScanForward(&rt, rtMask))
+            {
+                rtMask &= ~(1 << rt);
+
+                const SWR_RENDER_TARGET_BLEND_STATE& rtBlend =
+                    pState->state.blendState.renderTarget[rt];
+                if (!rtBlend.writeDisableRed && !rtBlend.writeDisableGreen &&
+                    !rtBlend.writeDisableBlue && !rtBlend.writeDisableAlpha)
+                {
+                    overwriteMask |= 1 << (SWR_ATTACHMENT_COLOR0 + rt);
+                }
+            }
+        }
+
+        if (pState->state.depthHottileEnable && dsState.depthTestEnable &&
+            dsState.depthWriteEnable)
+        {
+            overwriteMask |= SWR_ATTACHMENT_DEPTH_BIT;
+        }
+    }
+
+    pState->state.overwriteHottileMask = overwriteMask;
+
     // Setup depth quantization function
     if (pState->state.depthHottileEnable)
     {
@@ -1571,8 +1637,18 @@ void SwrDispatch(HANDLE   hContext,
 
     uint32_t totalThreadGroups = threadGroupCountX * threadGroupCountY * threadGroupCountZ;
     uint32_t dcIndex           = pDC->drawId % pContext->MAX_DRAWS_IN_FLIGHT;
-    pDC->pDispatch             = &pContext->pDispatchQueueArray[dcIndex];
-    pDC->pDispatch->initialize(totalThreadGroups, pTaskData, &ProcessComputeBE);
+
+    // Hand out small thread groups several at a time, so the atomics and the loop overhead of
+    // each dequeue are shared by roughly DISPATCH_BATCH_THREADS invocations.  Keep at least a
+    // few batches per worker so the load still balances.
+    uint32_t threadsInGroup = std::max(pDC->pState->state.totalThreadsInGroup, 1u);
+    uint32_t batchSize      = std::max(KNOB_DISPATCH_BATCH_THREADS / threadsInGroup, 1u);
+    uint32_t maxBatchSize =
+        std::max(totalThreadGroups / (std::max(pContext->NumWorkerThreads, 1u) * 4), 1u);
+    batchSize = std::min(batchSize, maxBatchSize);
+
+    pDC->pDispatch = &pContext->pDispatchQueueArray[dcIndex];
+    pDC->pDispatch->initialize(totalThreadGroups, pTaskData, &ProcessComputeBE, batchSize);
 
     QueueDispatch(pContext);
     RDTSC_END(pContext->pBucketMgr,
@@ -1734,6 +1810,17 @@ void SWR_API SwrEndFrame(HANDLE hContext)
     pContext->frameCount++;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Moves the pages of a render target to the NUMA nodes owning them
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param pSurface - Surface to place.
+void SWR_API SwrPlaceSurfaceMemory(HANDLE hContext, const SWR_SURFACE_STATE* pSurface)
+{
+    SWR_CONTEXT* pContext = GetContext(hContext);
+
+    PlaceSurfaceMemory(pContext, *pSurface);
+}
+
 void InitSimLoadTilesTable();
 void InitSimStoreTilesTable();
 void InitSimClearTilesTable();
@@ -1798,5 +1885,6 @@ void SwrGetInterface(SWR_INTERFACE& out_funcs)
     out_funcs.pfnSwrEnableStatsFE          = SwrEnableStatsFE;
     out_funcs.pfnSwrEnableStatsBE          = SwrEnableStatsBE;
     out_funcs.pfnSwrEndFrame               = SwrEndFrame;
+    out_funcs.pfnSwrPlaceSurfaceMemory     = SwrPlaceSurfaceMemory;
     out_funcs.pfnSwrInit                   = SwrInit;
 }
@@ -708,6 +708,15 @@ SWR_FUNC(void, SwrEnableStatsBE, HANDLE hContext, bool enable);
 /// @param hContext - Handle passed back from SwrCreateContext
 SWR_FUNC(void, SwrEndFrame, HANDLE hContext);
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Moves the pages of a render target to the NUMA nodes whose workers
+///        load and store its macrotiles.  Only has an effect with
+///        KNOB_NUMA_TILE_ROWS on a NUMA system.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param pSurface - Surface to place.
+struct SWR_SURFACE_STATE;
+SWR_FUNC(void, SwrPlaceSurfaceMemory, HANDLE hContext, const SWR_SURFACE_STATE* pSurface);
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Initialize swr backend and memory internal tables
 SWR_FUNC(void, SwrInit);
@@ -761,6 +770,7 @@ struct SWR_INTERFACE
     PFNSwrEnableStatsFE          pfnSwrEnableStatsFE;
     PFNSwrEnableStatsBE          pfnSwrEnableStatsBE;
     PFNSwrEndFrame               pfnSwrEndFrame;
+    PFNSwrPlaceSurfaceMemory     pfnSwrPlaceSurfaceMemory;
     PFNSwrInit                   pfnSwrInit;
 };
 
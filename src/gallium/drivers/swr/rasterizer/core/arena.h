@@ -46,6 +46,16 @@ struct ArenaBlock
 };
 static_assert(sizeof(ArenaBlock) <= ARENA_BLOCK_ALIGN, "Increase BLOCK_ALIGN size");
 
+// Caching allocator activity since the counters were last reset
+struct ArenaStats
+{
+    uint64_t hitCount      = 0; // allocations served from cached blocks
+    uint64_t missCount     = 0; // allocations which needed a new block
+    uint64_t trimmedSize   = 0; // bytes of cached blocks freed
+    uint64_t retainedSize  = 0; // bytes of unused blocks kept in the cache
+    uint64_t allocatedSize = 0; // bytes of all blocks, in use or cached
+};
+
 class DefaultAllocator
 {
 public:
@@ -77,7 +87,14 @@ struct CachingAllocatorT : DefaultAllocator
         SWR_ASSUME_ASSERT(size >= sizeof(ArenaBlock));
         SWR_ASSUME_ASSERT(size <= uint32_t(-1));
 
-        uint32_t bucket = GetBucketId(size);
+        uint32_t bucket    = GetBucketId(size);
+        size_t   allocSize = size;
+
+        if (bucket && bucket < (CACHE_NUM_BUCKETS - 1))
+        {
+            // Make all blocks in this bucket the same size
+            allocSize = size_t(1) << (bucket + 1 + CACHE_START_BUCKET_BIT);
+        }
 
         {
             // search cached blocks
@@ -105,6 +122,7 @@ struct CachingAllocatorT : DefaultAllocator
                     {
                         m_pOldLastCachedBlocks[bucket] = pPrevBlock;
                     }
+                    m_oldUnusedAge = 0;
                 }
             }
 
@@ -114,10 +132,12 @@ struct CachingAllocatorT : DefaultAllocator
                 pPrevBlock->pNext = pBlock->pNext;
                 pBlock->pNext     = nullptr;
 
+                m_stats.hitCount++;
                 return pBlock;
             }
 
-            m_totalAllocated += size;
+            m_stats.missCount++;
+            m_totalAllocated += allocSize;
 
 #if 0
             {
@@ -129,13 +149,7 @@ struct CachingAllocatorT : DefaultAllocator
 #endif
         }
 
-        if (bucket && bucket < (CACHE_NUM_BUCKETS - 1))
-        {
-            // Make all blocks in this bucket the same size
-            size = size_t(1) << (bucket + 1 + CACHE_START_BUCKET_BIT);
-        }
-
-        return this->DefaultAllocator::AllocateAligned(size, align);
+        return this->DefaultAllocator::AllocateAligned(allocSize, align);
     }
 
     void Free(ArenaBlock* pMem)
@@ -147,15 +161,24 @@ struct CachingAllocatorT : DefaultAllocator
         }
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Ages the cached blocks.  Blocks which weren't reused since the
+    ///        previous call are freed if there are too many of them, or if
+    ///        none of them were needed for MAX_UNUSED_AGE calls.
     void FreeOldBlocks()
     {
-        if (!m_cachedSize)
+        if (!m_cachedSize && !m_oldCachedSize)
         {
             return;
         }
         std::lock_guard<std::mutex> l(m_mutex);
 
-        bool doFree = (m_oldCachedSize > MAX_UNUSED_SIZE);
+        bool doFree = (m_oldCachedSize > MAX_UNUSED_SIZE) || (++m_oldUnusedAge >= MAX_UNUSED_AGE);
+        if (doFree)
+        {
+            m_stats.trimmedSize += m_oldCachedSize;
+            m_oldUnusedAge = 0;
+        }
 
         for (uint32_t i = 0; i < CACHE_NUM_BUCKETS; ++i)
         {
@@ -213,6 +236,21 @@ struct CachingAllocatorT : DefaultAllocator
         m_cachedSize = 0;
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Returns the counters accumulated since the previous call and
+    ///        resets them.
+    ArenaStats GetAndResetStats()
+    {
+        std::lock_guard<std::mutex> l(m_mutex);
+
+        ArenaStats stats    = m_stats;
+        stats.retainedSize  = m_cachedSize + m_oldCachedSize;
+        stats.allocatedSize = m_totalAllocated;
+        m_stats             = ArenaStats();
+
+        return stats;
+    }
+
     CachingAllocatorT()
     {
         for (uint32_t i = 0; i < CACHE_NUM_BUCKETS; ++i)
@@ -353,6 +391,7 @@ private:
     static const uint32_t CACHE_NUM_BUCKETS      = NumBucketsT;
     static const uint32_t CACHE_START_BUCKET_BIT = StartBucketBitT;
     static const size_t   MAX_UNUSED_SIZE        = sizeof(MEGABYTE);
+    static const uint32_t MAX_UNUSED_AGE         = 8;
 
     ArenaBlock  m_cachedBlocks[CACHE_NUM_BUCKETS];
     ArenaBlock* m_pLastCachedBlocks[CACHE_NUM_BUCKETS];
@@ -364,6 +403,11 @@ private:
 
     size_t m_cachedSize    = 0;
     size_t m_oldCachedSize = 0;
+
+    // Number of FreeOldBlocks calls since an old block was last reused
+    uint32_t m_oldUnusedAge = 0;
+
+    ArenaStats m_stats;
 };
 typedef CachingAllocatorT<> CachingAllocator;
 
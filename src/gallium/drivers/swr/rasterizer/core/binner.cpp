@@ -301,6 +301,113 @@ void TransposeVertices(simd4scalar (&dst)[16],
         reinterpret_cast<simd16scalar(&)[4]>(dst), src0, src1, src2, _simd16_setzero_ps());
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns whether a triangle covers every sample of a macrotile, so
+///        the BE doesn't need to load the attachments it overwrites.
+/// @param state - API state of the draw
+/// @param desc - triangle, with its vertices already in pTriBuffer
+/// @param macroX, macroY - macrotile coordinates
+static bool TriangleCoversMacroTile(const API_STATE&          state,
+                                    const TRIANGLE_WORK_DESC& desc,
+                                    uint32_t                  macroX,
+                                    uint32_t                  macroY)
+{
+    const SWR_RECT& scissor =
+        state.scissorsInFixedPoint[state.backendState.readViewportArrayIndex
+                                       ? desc.triFlags.viewportIndex
+                                       : 0];
+
+    int32_t x0 = macroX * KNOB_MACROTILE_X_DIM;
+    int32_t y0 = macroY * KNOB_MACROTILE_Y_DIM;
+    int32_t x1 = x0 + KNOB_MACROTILE_X_DIM;
+    int32_t y1 = y0 + KNOB_MACROTILE_Y_DIM;
+
+    if (x0 * FIXED_POINT_SCALE < scissor.xmin || x1 * FIXED_POINT_SCALE - 1 > scissor.xmax ||
+        y0 * FIXED_POINT_SCALE < scissor.ymin || y1 * FIXED_POINT_SCALE - 1 > scissor.ymax)
+    {
+        return false;
+    }
+
+    const float* pX = &desc.pTriBuffer[0];
+    const float* pY = &desc.pTriBuffer[4];
+
+    double area = double(pX[1] - pX[0]) * (pY[2] - pY[0]) - double(pX[2] - pX[0]) * (pY[1] - pY[0]);
+    if (area == 0.0)
+    {
+        return false;
+    }
+
+    // Test the corners of the tile grown by a pixel, which contains every sample position
+    // no matter the pixel center convention, strictly against each edge.
+    const double cornerX[4] = {x0 - 1.0, x1 + 1.0, x0 - 1.0, x1 + 1.0};
+    const double cornerY[4] = {y0 - 1.0, y0 - 1.0, y1 + 1.0, y1 + 1.0};
+
+    for (uint32_t e = 0; e < 3; ++e)
+    {
+        uint32_t a = e;
+        uint32_t b = (e + 1) % 3;
+
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            double edge = double(pX[b] - pX[a]) * (cornerY[c] - pY[a]) -
+                          double(pY[b] - pY[a]) * (cornerX[c] - pX[a]);
+            if ((area > 0.0) ? (edge <= 0.0) : (edge >= 0.0))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Enqueues triangles which fall in a single macrotile as one work
+///        item, in the order they were given.
+/// @param pfnRasterize - rasterizer function for each of the triangles
+/// @param macroX, macroY - macrotile coordinates
+/// @param pTris - triangles, copied into the work item
+/// @param numTris - number of triangles
+static void BinTriangleBatch(DRAW_CONTEXT*             pDC,
+                             PFN_WORK_FUNC             pfnRasterize,
+                             uint32_t                  macroX,
+                             uint32_t                  macroY,
+                             const TRIANGLE_WORK_DESC* pTris,
+                             uint32_t                  numTris)
+{
+    const API_STATE& state = GetApiState(pDC);
+
+    BE_WORK work;
+    work.type = DRAW;
+
+    if (numTris == 1)
+    {
+        work.pfnWork  = pfnRasterize;
+        work.desc.tri = pTris[0];
+    }
+    else
+    {
+        TRIANGLE_WORK_DESC* pBatchTris = (TRIANGLE_WORK_DESC*)pDC->pArena->AllocAligned(
+            numTris * sizeof(TRIANGLE_WORK_DESC), alignof(TRIANGLE_WORK_DESC));
+        memcpy(pBatchTris, pTris, numTris * sizeof(TRIANGLE_WORK_DESC));
+
+        work.pfnWork                    = RasterizeTriangleBatch;
+        work.desc.triBatch.pTris        = pBatchTris;
+        work.desc.triBatch.numTris      = numTris;
+        work.desc.triBatch.pfnRasterize = pfnRasterize;
+    }
+
+    // The hottiles are initialized for array slice 0
+    uint32_t overwriteMask = 0;
+    if (state.overwriteHottileMask && pTris[0].triFlags.renderTargetArrayIndex == 0 &&
+        TriangleCoversMacroTile(state, pTris[0], macroX, macroY))
+    {
+        overwriteMask = state.overwriteHottileMask;
+    }
+
+    pDC->pTileMgr->enqueue(macroX, macroY, &work, overwriteMask);
+}
+
 #if KNOB_ENABLE_EARLY_RAST
 
 #define ER_SIMD_TILE_X_DIM (1 << ER_SIMD_TILE_X_SHIFT)
@@ -1121,12 +1228,32 @@ endBinTriangles:
     TransposeVertices(vHorizZ, tri[0].z, tri[1].z, tri[2].z);
     TransposeVertices(vHorizW, vRecipW0, vRecipW1, vRecipW2);
 
-    // scan remaining valid triangles and bin each separately
-    while (_BitScanForward((DWORD*)&triIndex, triMask))
+    auto pArena = pDC->pArena;
+    SWR_ASSERT(pArena != nullptr);
+
+    uint32_t linkageCount     = state.backendState.numAttributes;
+    uint32_t numScalarAttribs = linkageCount * 4;
+    uint32_t numClipDist      = _mm_popcnt_u32(state.backendState.clipDistanceMask);
+    uint32_t numTris          = _mm_popcnt_u32(triMask);
+
+    // allocate the vertex data, attribs and user clip distances of all the triangles at once
+    float* pTriBuffers = (float*)pArena->AllocAligned(numTris * 4 * 4 * sizeof(float), 16);
+    float* pAttribBuffers =
+        (float*)pArena->AllocAligned(numTris * numScalarAttribs * 3 * sizeof(float), 16);
+    float* pUserClipBuffers =
+        numClipDist ? (float*)pArena->Alloc(numTris * numClipDist * 3 * sizeof(float)) : nullptr;
+
+    // Consecutive triangles which fall in the same single macrotile are binned together, as long
+    // as no other triangle touching that macrotile comes in between.  Conservative rasterization
+    // picks a rasterizer per triangle, so those are binned separately.
+    TRIANGLE_WORK_DESC batchTris[SIMD_WIDTH];
+    uint32_t           batchCount = 0;
+    uint32_t           batchX     = 0;
+    uint32_t           batchY     = 0;
+
+    // scan remaining valid triangles and bin them
+    for (uint32_t triSlot = 0; _BitScanForward((DWORD*)&triIndex, triMask); ++triSlot)
     {
-        uint32_t linkageCount     = state.backendState.numAttributes;
-        uint32_t numScalarAttribs = linkageCount * 4;
-
         BE_WORK work;
         work.type = DRAW;
 
@@ -1165,17 +1292,13 @@ endBinTriangles:
         desc.triFlags.renderTargetArrayIndex = aRTAI[triIndex];
         desc.triFlags.viewportIndex          = pViewportIndex[triIndex];
 
-        auto pArena = pDC->pArena;
-        SWR_ASSERT(pArena != nullptr);
-
         // store active attribs
-        float* pAttribs = (float*)pArena->AllocAligned(numScalarAttribs * 3 * sizeof(float), 16);
-        desc.pAttribs   = pAttribs;
+        desc.pAttribs   = &pAttribBuffers[triSlot * numScalarAttribs * 3];
         desc.numAttribs = linkageCount;
         pfnProcessAttribs(pDC, pa, triIndex, pPrimID[triIndex], desc.pAttribs);
 
         // store triangle vertex data
-        desc.pTriBuffer = (float*)pArena->AllocAligned(4 * 4 * sizeof(float), 16);
+        desc.pTriBuffer = &pTriBuffers[triSlot * 4 * 4];
 
         SIMD128::store_ps(&desc.pTriBuffer[0], vHorizX[triIndex]);
         SIMD128::store_ps(&desc.pTriBuffer[4], vHorizY[triIndex]);
@@ -1183,28 +1306,70 @@ endBinTriangles:
         SIMD128::store_ps(&desc.pTriBuffer[12], vHorizW[triIndex]);
 
         // store user clip distances
-        if (state.backendState.clipDistanceMask)
+        desc.pUserClipBuffer = nullptr;
+        if (numClipDist)
         {
-            uint32_t numClipDist = _mm_popcnt_u32(state.backendState.clipDistanceMask);
-            desc.pUserClipBuffer = (float*)pArena->Alloc(numClipDist * 3 * sizeof(float));
+            desc.pUserClipBuffer = &pUserClipBuffers[triSlot * numClipDist * 3];
             ProcessUserClipDist<3>(
                 state.backendState, pa, triIndex, &desc.pTriBuffer[12], desc.pUserClipBuffer);
         }
 
-        for (uint32_t y = aMTTop[triIndex]; y <= aMTBottom[triIndex]; ++y)
-        {
-            for (uint32_t x = aMTLeft[triIndex]; x <= aMTRight[triIndex]; ++x)
-            {
+        triMask &= ~(1 << triIndex);
+
 #if KNOB_ENABLE_TOSS_POINTS
-                if (!KNOB_TOSS_SETUP_TRIS)
+        if (KNOB_TOSS_SETUP_TRIS)
+        {
+            continue;
+        }
 #endif
-                {
-                    pTileMgr->enqueue(x, y, &work);
-                }
+
+        uint32_t left   = aMTLeft[triIndex];
+        uint32_t right  = aMTRight[triIndex];
+        uint32_t top    = aMTTop[triIndex];
+        uint32_t bottom = aMTBottom[triIndex];
+
+        bool isSingleTile = !CT::IsConservativeT::value && left == right && top == bottom;
+
+        if (batchCount)
+        {
+            bool touchesBatch = batchX >= left && batchX <= right && batchY >= top &&
+                                batchY <= bottom;
+            bool extendsBatch = isSingleTile && left == batchX && top == batchY;
+            if (touchesBatch ? !extendsBatch : isSingleTile)
+            {
+                BinTriangleBatch(pDC, pfnWork, batchX, batchY, batchTris, batchCount);
+                batchCount = 0;
             }
         }
 
-        triMask &= ~(1 << triIndex);
+        if (isSingleTile)
+        {
+            batchX                  = left;
+            batchY                  = top;
+            batchTris[batchCount++] = desc;
+            continue;
+        }
+
+        // The hottiles are initialized for array slice 0
+        uint32_t overwriteMask =
+            (desc.triFlags.renderTargetArrayIndex == 0) ? state.overwriteHottileMask : 0;
+
+        for (uint32_t y = top; y <= bottom; ++y)
+        {
+            for (uint32_t x = left; x <= right; ++x)
+            {
+                uint32_t tileOverwriteMask =
+                    (overwriteMask && TriangleCoversMacroTile(state, desc, x, y))
+                        ? overwriteMask
+                        : 0;
+                pTileMgr->enqueue(x, y, &work, tileOverwriteMask);
+            }
+        }
+    }
+
+    if (batchCount)
+    {
+        BinTriangleBatch(pDC, pfnWork, batchX, batchY, batchTris, batchCount);
     }
 
     RDTSC_END(pDC->pContext->pBucketMgr, FEBinTriangles, 1);
@@ -148,6 +148,14 @@ typedef void (*PFN_WORK_FUNC)(DRAW_CONTEXT* pDC,
                               uint32_t      macroTile,
                               void*         pDesc);
 
+// Consecutive triangles of a SIMD batch which all fall in a single macrotile
+struct TRIANGLE_BATCH_DESC
+{
+    TRIANGLE_WORK_DESC* pTris;
+    uint32_t            numTris;
+    PFN_WORK_FUNC       pfnRasterize;
+};
+
 enum WORK_TYPE
 {
     SYNC,
@@ -166,6 +174,7 @@ OSALIGNSIMD(struct) BE_WORK
     {
         SYNC_DESC                     sync;
         TRIANGLE_WORK_DESC            tri;
+        TRIANGLE_BATCH_DESC           triBatch;
         CLEAR_DESC                    clear;
         DISCARD_INVALIDATE_TILES_DESC discardInvalidateTiles;
         STORE_TILES_DESC              storeTiles;
@@ -325,6 +334,8 @@ OSALIGNLINE(struct) API_STATE
         uint32_t colorHottileEnable : 8;   // Bitmask of enabled color hottiles
         uint32_t depthHottileEnable : 1;   // Enable depth buffer hottile
         uint32_t stencilHottileEnable : 1; // Enable stencil buffer hottile
+        uint32_t overwriteHottileMask : SWR_NUM_ATTACHMENTS; // Attachments a triangle covering
+                                                             // a whole macrotile fully writes
     };
 
     PFN_QUANTIZE_DEPTH pfnQuantizeDepth;
@@ -97,21 +97,30 @@
 #define KNOB_TILE_Y_DIM 8
 #define KNOB_TILE_Y_DIM_SHIFT 3
 
-// fixed macrotile pixel dimension for now, eventually will be
-// dynamically set based on tile format and pixel size
-#define KNOB_MACROTILE_X_DIM 32
-#define KNOB_MACROTILE_Y_DIM 32
-#define KNOB_MACROTILE_X_DIM_FIXED_SHIFT 13
-#define KNOB_MACROTILE_Y_DIM_FIXED_SHIFT 13
+// macrotile pixel dimension, fixed at build time (see the swr-macrotile-size
+// meson option) since the hot tiles and the surface alignment depend on it
+#ifndef KNOB_MACROTILE_DIM_SHIFT
+#define KNOB_MACROTILE_DIM_SHIFT 5
+#endif
+#define KNOB_MACROTILE_X_DIM_SHIFT KNOB_MACROTILE_DIM_SHIFT
+#define KNOB_MACROTILE_Y_DIM_SHIFT KNOB_MACROTILE_DIM_SHIFT
+#define KNOB_MACROTILE_X_DIM (1 << KNOB_MACROTILE_X_DIM_SHIFT)
+#define KNOB_MACROTILE_Y_DIM (1 << KNOB_MACROTILE_Y_DIM_SHIFT)
+#define KNOB_MACROTILE_X_DIM_FIXED_SHIFT (KNOB_MACROTILE_X_DIM_SHIFT + 8)
+#define KNOB_MACROTILE_Y_DIM_FIXED_SHIFT (KNOB_MACROTILE_Y_DIM_SHIFT + 8)
 #define KNOB_MACROTILE_X_DIM_FIXED (KNOB_MACROTILE_X_DIM << 8)
 #define KNOB_MACROTILE_Y_DIM_FIXED (KNOB_MACROTILE_Y_DIM << 8)
 #define KNOB_MACROTILE_X_DIM_IN_TILES (KNOB_MACROTILE_X_DIM >> KNOB_TILE_X_DIM_SHIFT)
 #define KNOB_MACROTILE_Y_DIM_IN_TILES (KNOB_MACROTILE_Y_DIM >> KNOB_TILE_Y_DIM_SHIFT)
 
+#if KNOB_MACROTILE_DIM_SHIFT < 4 || KNOB_MACROTILE_DIM_SHIFT > 7
+#error "unsupported macrotile dimensions"
+#endif
+
 // total # of hot tiles available. This should be enough to
 // fully render a 16kx16k 128bpp render target
-#define KNOB_NUM_HOT_TILES_X 512
-#define KNOB_NUM_HOT_TILES_Y 512
+#define KNOB_NUM_HOT_TILES_X (16384 >> KNOB_MACROTILE_X_DIM_SHIFT)
+#define KNOB_NUM_HOT_TILES_Y (16384 >> KNOB_MACROTILE_Y_DIM_SHIFT)
 #define KNOB_COLOR_HOT_TILE_FORMAT R32G32B32A32_FLOAT
 #define KNOB_DEPTH_HOT_TILE_FORMAT R32_FLOAT
 #define KNOB_STENCIL_HOT_TILE_FORMAT R8_UINT
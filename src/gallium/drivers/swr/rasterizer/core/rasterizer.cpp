@@ -448,6 +448,18 @@ void RasterizeTriPoint(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
     pfnTriRast(pDC, workerId, macroTile, (void*)&newWorkDesc);
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Rasterizes each triangle of a batch binned as a single work item.
+void RasterizeTriangleBatch(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile, void* pData)
+{
+    const TRIANGLE_BATCH_DESC& batchDesc = *(const TRIANGLE_BATCH_DESC*)pData;
+
+    for (uint32_t i = 0; i < batchDesc.numTris; ++i)
+    {
+        batchDesc.pfnRasterize(pDC, workerId, macroTile, &batchDesc.pTris[i]);
+    }
+}
+
 void InitRasterizerFunctions()
 {
     InitRasterizerFuncs();
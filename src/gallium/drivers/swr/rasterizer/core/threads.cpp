@@ -36,6 +36,11 @@
 #include <unistd.h>
 #endif
 
+#if defined(__linux__) || defined(__gnu_linux__)
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
 #ifdef __APPLE__
 #include <sys/types.h>
 #include <sys/sysctl.h>
@@ -50,6 +55,7 @@
 #include "rdtsc_core.h"
 #include "tilemgr.h"
 #include "tileset.h"
+#include "memory/SurfaceState.h"
 
 
 // ThreadId
@@ -369,6 +375,79 @@ void bindThread(SWR_CONTEXT* pContext,
 #endif
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Moves each row of macrotiles of the top level of a surface to the
+///        NUMA node whose workers own that row, see GetMacroTileNumaNode.
+///        Only does something with NUMA_TILE_ROWS, as the rows of a
+///        checkerboard are shared by all nodes.
+void PlaceSurfaceMemory(SWR_CONTEXT* pContext, const SWR_SURFACE_STATE& surface)
+{
+#if defined(__linux__) || defined(__gnu_linux__)
+    uint32_t numaMask = pContext->threadPool.numaMask;
+    if (!KNOB_NUMA_TILE_ROWS || numaMask == 0 || surface.xpBaseAddress == 0)
+    {
+        return;
+    }
+
+    // A row of macrotiles is only contiguous in linear and TileY surfaces.
+    if (surface.tileMode != SWR_TILE_NONE && surface.tileMode != SWR_TILE_MODE_YMAJOR)
+    {
+        return;
+    }
+
+    const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t rowSize  = (size_t)surface.pitch * KNOB_MACROTILE_Y_DIM;
+    if (rowSize < pageSize)
+    {
+        return;
+    }
+
+    const uint32_t numRows    = (surface.height + KNOB_MACROTILE_Y_DIM - 1) / KNOB_MACROTILE_Y_DIM;
+    const uint32_t numSlices  = std::max(surface.depth, 1u) * std::max(surface.numSamples, 1u);
+    const size_t   heightSize = (size_t)surface.height * surface.pitch;
+
+    for (uint32_t s = 0; s < numSlices; ++s)
+    {
+        uint8_t* pSlice =
+            (uint8_t*)surface.xpBaseAddress + (size_t)s * surface.qpitch * surface.pitch;
+
+        for (uint32_t row = 0; row < numRows; ++row)
+        {
+            // Only move the pages entirely within the row, the ones straddling two rows stay
+            // wherever they were first touched.
+            uintptr_t start = (uintptr_t)(pSlice + row * rowSize);
+            uintptr_t end   = (uintptr_t)(pSlice + std::min(heightSize, (row + 1) * rowSize));
+            start           = (start + pageSize - 1) & ~(pageSize - 1);
+            end             = end & ~(pageSize - 1);
+            if (start >= end)
+            {
+                continue;
+            }
+
+            uint32_t node =
+                GetMacroTileNumaNode(0, row, numaMask) + pContext->threadInfo.BASE_NUMA_NODE;
+            if (node >= sizeof(unsigned long) * 8)
+            {
+                return;
+            }
+            unsigned long nodeMask = 1ul << node;
+
+            if (syscall(SYS_mbind,
+                        (void*)start,
+                        end - start,
+                        MPOL_PREFERRED,
+                        &nodeMask,
+                        sizeof(nodeMask) * 8,
+                        MPOL_MF_MOVE) != 0)
+            {
+                // Not supported by the kernel, or the memory isn't ours to move.
+                return;
+            }
+        }
+    }
+#endif
+}
+
 INLINE
 uint32_t GetEnqueuedDraw(SWR_CONTEXT* pContext)
 {
@@ -534,7 +613,9 @@ bool WorkOnFifoBE(SWR_CONTEXT* pContext,
                   uint32_t&    curDrawBE,
                   TileSet&     lockedTiles,
                   uint32_t     numaNode,
-                  uint32_t     numaMask)
+                  uint32_t     numaMask,
+                  uint32_t     nodeWorkerId,
+                  uint32_t     numNodeWorkers)
 {
     bool bShutdown = false;
 
@@ -552,6 +633,10 @@ bool WorkOnFifoBE(SWR_CONTEXT* pContext,
     // Reset our history for locked tiles. We'll have to re-learn which tiles are locked.
     lockedTiles.clear();
 
+    // Tiles of other numa nodes may only be stolen as long as they were visited in every
+    // earlier draw, the locked tiles can't keep the order of tiles we never looked at.
+    bool bCanSteal = (numaMask != 0);
+
     // Try to work on each draw in order of the available draws in flight.
     //   1. If we're on curDrawBE, we can work on any macrotile that is available.
     //   2. If we're trying to work on draws after curDrawBE, we are restricted to
@@ -577,92 +662,127 @@ bool WorkOnFifoBE(SWR_CONTEXT* pContext,
         }
 
         // Grab the list of all dirty macrotiles. A tile is dirty if it has work queued to it.
-        auto& macroTiles = pDC->pTileMgr->getDirtyTiles();
-
-        for (auto tile : macroTiles)
+        auto&    macroTiles = pDC->pTileMgr->getDirtyTiles();
+        uint32_t numTiles   = (uint32_t)macroTiles.size();
+
+        // Each worker of a node starts scanning in its own share of the tiles, so the workers
+        // only contend for the same tiles once their own share is exhausted.
+        uint32_t startTile =
+            numNodeWorkers > 1 ? (uint32_t)((uint64_t)numTiles * nodeWorkerId / numNodeWorkers)
+                               : 0;
+
+        // First pass works on the tiles of this numa node, the second one steals the tiles of
+        // the other nodes if there was nothing to do locally.
+        bool foundLocalWork = false;
+        bool drawComplete   = false;
+        for (uint32_t pass = 0; pass < 2; ++pass)
         {
-            uint32_t tileID = tile->mId;
-
-            // Only work on tiles for this numa node
-            uint32_t x, y;
-            pDC->pTileMgr->getTileIndices(tileID, x, y);
-            if (((x ^ y) & numaMask) != numaNode)
-            {
-                _mm_pause();
-                continue;
-            }
-
-            if (!tile->getNumQueued())
+            bool steal = (pass == 1);
+            if (steal)
             {
-                _mm_pause();
-                continue;
-            }
-
-            // can only work on this draw if it's not in use by other threads
-            if (lockedTiles.get(tileID))
-            {
-                _mm_pause();
-                continue;
+                if (!bCanSteal || foundLocalWork)
+                {
+                    // The remote tiles of this draw weren't visited, so their progress is
+                    // unknown and we can't take them from any later draw either.
+                    bCanSteal = false;
+                    break;
+                }
             }
 
-            if (tile->tryLock())
+            for (uint32_t t = 0; t < numTiles; ++t)
             {
-                BE_WORK* pWork;
+                auto*    tile   = macroTiles[(startTile + t) % numTiles];
+                uint32_t tileID = tile->mId;
 
-                RDTSC_BEGIN(pContext->pBucketMgr, WorkerFoundWork, pDC->drawId);
-
-                uint32_t numWorkItems = tile->getNumQueued();
-                SWR_ASSERT(numWorkItems);
-
-                pWork = tile->peek();
-                SWR_ASSERT(pWork);
-                if (pWork->type == DRAW)
+                uint32_t x, y;
+                pDC->pTileMgr->getTileIndices(tileID, x, y);
+                if ((GetMacroTileNumaNode(x, y, numaMask) == numaNode) == steal)
                 {
-                    pContext->pHotTileMgr->InitializeHotTiles(pContext, pDC, workerId, tileID);
+                    continue;
                 }
-                else if (pWork->type == SHUTDOWN)
+
+                if (!tile->getNumQueued())
                 {
-                    bShutdown = true;
+                    _mm_pause();
+                    continue;
                 }
 
-                while ((pWork = tile->peek()) != nullptr)
+                // can only work on this draw if it's not in use by other threads
+                if (lockedTiles.get(tileID))
                 {
-                    pWork->pfnWork(pDC, workerId, tileID, &pWork->desc);
-                    tile->dequeue();
+                    _mm_pause();
+                    continue;
                 }
-                RDTSC_END(pContext->pBucketMgr, WorkerFoundWork, numWorkItems);
 
-                _ReadWriteBarrier();
+                if (tile->tryLock())
+                {
+                    BE_WORK* pWork;
 
-                pDC->pTileMgr->markTileComplete(tileID);
+                    RDTSC_BEGIN(pContext->pBucketMgr, WorkerFoundWork, pDC->drawId);
 
-                // Optimization: If the draw is complete and we're the last one to have worked on it
-                // then we can reset the locked list as we know that all previous draws before the
-                // next are guaranteed to be complete.
-                if ((curDrawBE == i) && (bShutdown || pDC->pTileMgr->isWorkComplete()))
-                {
-                    // We can increment the current BE and safely move to next draw since we know
-                    // this draw is complete.
-                    curDrawBE++;
-                    CompleteDrawContextInl(pContext, workerId, pDC);
+                    uint32_t numWorkItems = tile->getNumQueued();
+                    SWR_ASSERT(numWorkItems);
 
-                    lastRetiredDraw++;
+                    foundLocalWork |= !steal;
 
-                    lockedTiles.clear();
-                    break;
-                }
+                    pWork = tile->peek();
+                    SWR_ASSERT(pWork);
+                    if (pWork->type == DRAW)
+                    {
+                        pContext->pHotTileMgr->InitializeHotTiles(
+                            pContext, pDC, workerId, tileID, tile->mOverwriteMask);
+                    }
+                    else if (pWork->type == SHUTDOWN)
+                    {
+                        bShutdown = true;
+                    }
+
+                    while ((pWork = tile->peek()) != nullptr)
+                    {
+                        pWork->pfnWork(pDC, workerId, tileID, &pWork->desc);
+                        tile->dequeue();
+                    }
+                    RDTSC_END(pContext->pBucketMgr, WorkerFoundWork, numWorkItems);
+
+                    _ReadWriteBarrier();
 
-                if (bShutdown)
+                    pDC->pTileMgr->markTileComplete(tileID);
+
+                    // Optimization: If the draw is complete and we're the last one to have worked
+                    // on it then we can reset the locked list as we know that all previous draws
+                    // before the next are guaranteed to be complete.
+                    if ((curDrawBE == i) && (bShutdown || pDC->pTileMgr->isWorkComplete()))
+                    {
+                        // We can increment the current BE and safely move to next draw since we
+                        // know this draw is complete.
+                        curDrawBE++;
+                        CompleteDrawContextInl(pContext, workerId, pDC);
+
+                        lastRetiredDraw++;
+
+                        lockedTiles.clear();
+                        bCanSteal    = (numaMask != 0);
+                        drawComplete = true;
+                        break;
+                    }
+
+                    if (bShutdown)
+                    {
+                        break;
+                    }
+                }
+                else
                 {
-                    break;
+                    // This tile is already locked. So let's add it to our locked tiles set. This
+                    // way we don't try locking this one again.
+                    lockedTiles.set(tileID);
+                    _mm_pause();
                 }
             }
-            else
+
+            if (drawComplete || bShutdown)
             {
-                // This tile is already locked. So let's add it to our locked tiles set. This way we
-                // don't try locking this one again.
-                lockedTiles.set(tileID);
-                _mm_pause();
+                break;
             }
         }
     }
@@ -819,10 +939,15 @@ void WorkOnCompute(SWR_CONTEXT* pContext, uint32_t workerId, uint32_t& curDrawBE
             void*    pSpillFillBuffer = nullptr;
             void*    pScratchSpace    = nullptr;
             uint32_t threadGroupId    = 0;
-            while (queue.getWork(threadGroupId))
+            uint32_t numThreadGroups  = 0;
+            while (queue.getWork(threadGroupId, numThreadGroups))
             {
-                queue.dispatch(pDC, workerId, threadGroupId, pSpillFillBuffer, pScratchSpace);
-                queue.finishedWork();
+                for (uint32_t g = 0; g < numThreadGroups; ++g)
+                {
+                    queue.dispatch(
+                        pDC, workerId, threadGroupId + g, pSpillFillBuffer, pScratchSpace);
+                }
+                queue.finishedWork(numThreadGroups);
             }
 
             // Ensure all streaming writes are globally visible before moving onto the next draw
@@ -951,7 +1076,14 @@ DWORD workerThreadMain(LPVOID pData)
         {
             RDTSC_BEGIN(pContext->pBucketMgr, WorkerWorkOnFifoBE, 0);
             bShutdown |=
-                WorkOnFifoBE(pContext, workerId, curDrawBE, lockedTiles, numaNode, numaMask);
+                WorkOnFifoBE(pContext,
+                             workerId,
+                             curDrawBE,
+                             lockedTiles,
+                             numaNode,
+                             numaMask,
+                             pThreadData->nodeWorkerId,
+                             pThreadData->numNodeWorkers);
             RDTSC_END(pContext->pBucketMgr, WorkerWorkOnFifoBE, 0);
 
             WorkOnCompute(pContext, workerId, curDrawBE);
@@ -1366,6 +1498,20 @@ void CreateThreadPool(SWR_CONTEXT* pContext, THREAD_POOL* pPool)
         }
         SWR_ASSERT(workerId == pContext->NumWorkerThreads);
     }
+
+    // Number the workers of each numa node, the BE uses it to spread them over the tiles.
+    std::vector<uint32_t> numNodeWorkers(nodes.size() + 1, 0);
+    for (uint32_t workerId = 0; workerId < pPool->numThreads; ++workerId)
+    {
+        THREAD_DATA& threadData = pPool->pThreadData[workerId];
+        SWR_ASSERT(threadData.numaId < numNodeWorkers.size());
+        threadData.nodeWorkerId = numNodeWorkers[threadData.numaId]++;
+    }
+    for (uint32_t workerId = 0; workerId < pPool->numThreads; ++workerId)
+    {
+        THREAD_DATA& threadData   = pPool->pThreadData[workerId];
+        threadData.numNodeWorkers = numNodeWorkers[threadData.numaId];
+    }
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -36,6 +36,7 @@ typedef std::thread* THREAD_PTR;
 struct SWR_CONTEXT;
 struct DRAW_CONTEXT;
 struct SWR_WORKER_PRIVATE_STATE;
+struct SWR_SURFACE_STATE;
 
 struct THREAD_DATA
 {
@@ -46,6 +47,8 @@ struct THREAD_DATA
     uint32_t     coreId;             // Core id
     uint32_t     htId;               // Hyperthread id
     uint32_t     workerId;           // index of worker in total thread data
+    uint32_t     nodeWorkerId;       // index of worker among the workers of its NUMA node
+    uint32_t     numNodeWorkers;     // number of workers on its NUMA node
     void*        clipperData;        // pointer to hang clipper-private data on
     SWR_CONTEXT* pContext;
     bool         forceBindProcGroup; // Only useful when MAX_WORKER_THREADS is set.
@@ -62,6 +65,14 @@ struct THREAD_POOL
     THREAD_DATA* pApiThreadData;
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the NUMA node, relative to BASE_NUMA_NODE, whose workers
+///        own macrotile (x, y).
+inline uint32_t GetMacroTileNumaNode(uint32_t x, uint32_t y, uint32_t numaMask)
+{
+    return (KNOB_NUMA_TILE_ROWS ? y : (x ^ y)) & numaMask;
+}
+
 struct TileSet;
 
 void CreateThreadPool(SWR_CONTEXT* pContext, THREAD_POOL* pPool);
@@ -75,8 +86,11 @@ bool    WorkOnFifoBE(SWR_CONTEXT* pContext,
                      uint32_t&    curDrawBE,
                      TileSet&     usedTiles,
                      uint32_t     numaNode,
-                     uint32_t     numaMask);
+                     uint32_t     numaMask,
+                     uint32_t     nodeWorkerId,
+                     uint32_t     numNodeWorkers);
 void    WorkOnCompute(SWR_CONTEXT* pContext, uint32_t workerId, uint32_t& curDrawBE);
 int32_t CompleteDrawContext(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC);
 
 void BindApiThread(SWR_CONTEXT* pContext, uint32_t apiThreadId);
+void PlaceSurfaceMemory(SWR_CONTEXT* pContext, const SWR_SURFACE_STATE& surface);
@@ -35,7 +35,7 @@
 
 MacroTileMgr::MacroTileMgr(CachingArena& arena) : mArena(arena) {}
 
-void MacroTileMgr::enqueue(uint32_t x, uint32_t y, BE_WORK* pWork)
+void MacroTileMgr::enqueue(uint32_t x, uint32_t y, BE_WORK* pWork, uint32_t overwriteMask)
 {
     // Should not enqueue more then what we have backing for in the hot tile manager.
     SWR_ASSERT(x < KNOB_NUM_HOT_TILES_X);
@@ -64,6 +64,7 @@ void MacroTileMgr::enqueue(uint32_t x, uint32_t y, BE_WORK* pWork)
     if (pTile->mWorkItemsFE == 1)
     {
         pTile->clear(mArena);
+        pTile->mOverwriteMask = overwriteMask;
         mDirtyTiles.push_back(pTile);
     }
 
@@ -110,7 +111,7 @@ HOTTILE* HotTileMgr::GetHotTile(SWR_CONTEXT*                pContext,
         if (create)
         {
             uint32_t size     = numSamples * mHotTileSize[attachment];
-            uint32_t numaNode = ((x ^ y) & pContext->threadPool.numaMask);
+            uint32_t numaNode = GetMacroTileNumaNode(x, y, pContext->threadPool.numaMask);
             hotTile.pBuffer =
                 (uint8_t*)AllocHotTileMem(size, 64, numaNode + pContext->threadInfo.BASE_NUMA_NODE);
             hotTile.state                  = HOTTILE_INVALID;
@@ -134,7 +135,7 @@ HOTTILE* HotTileMgr::GetHotTile(SWR_CONTEXT*                pContext,
             FreeHotTileMem(hotTile.pBuffer);
 
             uint32_t size     = numSamples * mHotTileSize[attachment];
-            uint32_t numaNode = ((x ^ y) & pContext->threadPool.numaMask);
+            uint32_t numaNode = GetMacroTileNumaNode(x, y, pContext->threadPool.numaMask);
             hotTile.pBuffer =
                 (uint8_t*)AllocHotTileMem(size, 64, numaNode + pContext->threadInfo.BASE_NUMA_NODE);
             hotTile.state      = HOTTILE_INVALID;
@@ -337,10 +338,13 @@ void HotTileMgr::ClearStencilHotTile(const HOTTILE* pHotTile)
 /// to avoid unnecessary setup every triangle
 /// @todo support deferred clear
 /// @param pCreateInfo - pointer to creation info.
+/// @param overwriteMask - attachments the first triangle of the draw covers
+///        entirely, which don't need to be loaded.
 void HotTileMgr::InitializeHotTiles(SWR_CONTEXT*  pContext,
                                     DRAW_CONTEXT* pDC,
                                     uint32_t      workerId,
-                                    uint32_t      macroID)
+                                    uint32_t      macroID,
+                                    uint32_t      overwriteMask)
 {
     const API_STATE& state    = GetApiState(pDC);
     HANDLE hWorkerPrivateData = pDC->pContext->threadPool.pThreadData[workerId].pWorkerPrivateData;
@@ -366,7 +370,13 @@ void HotTileMgr::InitializeHotTiles(SWR_CONTEXT*  pContext,
                        true,
                        numSamples);
 
-        if (pHotTile->state == HOTTILE_INVALID)
+        if (pHotTile->state == HOTTILE_INVALID &&
+            (overwriteMask & (1 << (SWR_ATTACHMENT_COLOR0 + rtSlot))))
+        {
+            // the draw replaces every sample, whatever the hottile holds is fine
+            pHotTile->state = HOTTILE_RESOLVED;
+        }
+        else if (pHotTile->state == HOTTILE_INVALID)
         {
             RDTSC_BEGIN(pContext->pBucketMgr, BELoadTiles, pDC->drawId);
             // invalid hottile before draw requires a load from surface before we can draw to it
@@ -397,7 +407,11 @@ void HotTileMgr::InitializeHotTiles(SWR_CONTEXT*  pContext,
     {
         HOTTILE* pHotTile = GetHotTile(
             pContext, pDC, hWorkerPrivateData, macroID, SWR_ATTACHMENT_DEPTH, true, numSamples);
-        if (pHotTile->state == HOTTILE_INVALID)
+        if (pHotTile->state == HOTTILE_INVALID && (overwriteMask & SWR_ATTACHMENT_DEPTH_BIT))
+        {
+            pHotTile->state = HOTTILE_DIRTY;
+        }
+        else if (pHotTile->state == HOTTILE_INVALID)
         {
             RDTSC_BEGIN(pContext->pBucketMgr, BELoadTiles, pDC->drawId);
             // invalid hottile before draw requires a load from surface before we can draw to it
@@ -79,6 +79,7 @@ struct MacroTileQueue
     void destroy() { mFifo.destroy(); }
 
     ///@todo This will all be private.
+    uint32_t mOverwriteMask = 0; // Attachments the first work item writes entirely
     uint32_t mWorkItemsFE = 0;
     uint32_t mWorkItemsBE = 0;
     uint32_t mId          = 0;
@@ -115,7 +116,7 @@ public:
 
     INLINE bool isWorkComplete() { return mWorkItemsProduced == mWorkItemsConsumed; }
 
-    void enqueue(uint32_t x, uint32_t y, BE_WORK* pWork);
+    void enqueue(uint32_t x, uint32_t y, BE_WORK* pWork, uint32_t overwriteMask = 0);
 
     static INLINE void getTileIndices(uint32_t tileID, uint32_t& x, uint32_t& y)
     {
@@ -157,7 +158,11 @@ public:
 
     //////////////////////////////////////////////////////////////////////////
     /// @brief Setup the producer consumer counts.
-    void initialize(uint32_t totalTasks, void* pTaskData, PFN_DISPATCH pfnDispatch)
+    /// @param batchSize - number of tasks a worker takes at once.
+    void initialize(uint32_t     totalTasks,
+                    void*        pTaskData,
+                    PFN_DISPATCH pfnDispatch,
+                    uint32_t     batchSize = 1)
     {
         // The available and outstanding counts start with total tasks.
         // At the start there are N tasks available and outstanding.
@@ -170,6 +175,7 @@ public:
 
         mpTaskData   = pTaskData;
         mPfnDispatch = pfnDispatch;
+        mBatchSize   = std::max(batchSize, 1u);
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -177,16 +183,18 @@ public:
     uint32_t getNumQueued() { return (mTasksAvailable > 0) ? mTasksAvailable : 0; }
 
     //////////////////////////////////////////////////////////////////////////
-    /// @brief Atomically decrement the work available count. If the result
-    //         is greater than 0 then we can on the associated thread group.
-    //         Otherwise, there is no more work to do.
-    bool getWork(uint32_t& groupId)
+    /// @brief Atomically take up to a batch of tasks off the work available
+    ///        count. If any were left then we can work on the thread groups
+    ///        groupId to groupId + numGroups - 1. Otherwise, there is no more
+    ///        work to do.
+    bool getWork(uint32_t& groupId, uint32_t& numGroups)
     {
-        long result = InterlockedDecrement(&mTasksAvailable);
+        long available = InterlockedExchangeAdd(&mTasksAvailable, -(long)mBatchSize);
 
-        if (result >= 0)
+        if (available > 0)
         {
-            groupId = result;
+            numGroups = std::min((uint32_t)available, mBatchSize);
+            groupId   = (uint32_t)available - numGroups;
             return true;
         }
 
@@ -197,9 +205,9 @@ public:
     /// @brief Atomically decrement the outstanding count. A worker is notifying
     ///        us that he just finished some work. Also, return true if we're
     ///        the last worker to complete this dispatch.
-    bool finishedWork()
+    bool finishedWork(uint32_t numGroups = 1)
     {
-        long result = InterlockedDecrement(&mTasksOutstanding);
+        long result = InterlockedExchangeAdd(&mTasksOutstanding, -(long)numGroups) - numGroups;
         SWR_ASSERT(result >= 0, "Should never oversubscribe work");
 
         return (result == 0) ? true : false;
@@ -228,6 +236,7 @@ public:
     void* mpTaskData{nullptr}; // The API thread will set this up and the callback task function
                                // will interpet this.
     PFN_DISPATCH mPfnDispatch{nullptr}; // Function to call per dispatch
+    uint32_t     mBatchSize{1};         // Number of tasks taken by getWork at once
 
     OSALIGNLINE(volatile long) mTasksAvailable{0};
     OSALIGNLINE(volatile long) mTasksOutstanding{0};
@@ -300,7 +309,8 @@ public:
     void InitializeHotTiles(SWR_CONTEXT*  pContext,
                             DRAW_CONTEXT* pDC,
                             uint32_t      workerId,
-                            uint32_t      macroID);
+                            uint32_t      macroID,
+                            uint32_t      overwriteMask);
 
     HOTTILE* GetHotTile(SWR_CONTEXT*                pContext,
                         DRAW_CONTEXT*               pDC,
@@ -48,6 +48,7 @@
 #endif // _WIN32
 
 #if defined(__APPLE__) || defined(FORCE_LINUX) || defined(__linux__) || defined(__gnu_linux__)
+#include <dlfcn.h>
 #include <pwd.h>
 #include <sys/stat.h>
 #endif
@@ -220,6 +221,58 @@ void JitManager::SetupNewModule()
     mIsModuleFinalized = false;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Look up the function jitted from pState by an earlier run in the
+///        object cache, before building any IR for it.  Must be called on a
+///        fresh module, returns nullptr on a miss.
+void* JitManager::GetCachedFunction(const char* pPrefix, const void* pState, size_t stateSize)
+{
+    if (!KNOB_JIT_ENABLE_CACHE)
+    {
+        return nullptr;
+    }
+
+    SWR_ASSERT(mIsModuleFinalized == false && "Cache lookup needs a new module!");
+
+    // Same naming as the JIT functions themselves
+    std::stringstream fnName(pPrefix, std::ios_base::in | std::ios_base::out | std::ios_base::ate);
+    fnName << ComputeCRC(0, pState, stateSize);
+
+    std::unique_ptr<MemoryBuffer> pBuf = mCache.GetObject(fnName.str(), pState, stateSize);
+    if (!pBuf)
+    {
+        return nullptr;
+    }
+
+    auto pObj = object::ObjectFile::createObjectFile(pBuf->getMemBufferRef());
+    if (!pObj)
+    {
+        consumeError(pObj.takeError());
+        return nullptr;
+    }
+
+    mpExec->addObjectFile(object::OwningBinary<object::ObjectFile>(std::move(*pObj), std::move(pBuf)));
+
+    void* pfn = (void*)mpExec->getFunctionAddress(fnName.str());
+    if (pfn)
+    {
+        mIsModuleFinalized = true;
+    }
+
+    return pfn;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Cache the current module under pState rather than its IR so
+///        GetCachedFunction can find it.
+void JitManager::SetModuleCacheKey(const void* pState, size_t stateSize)
+{
+    if (KNOB_JIT_ENABLE_CACHE)
+    {
+        mCache.SetModuleKey(pState, stateSize);
+    }
+}
+
 
 DIType*
 JitManager::CreateDebugStructType(StructType*                                          pType,
@@ -653,6 +706,21 @@ JitCache::JitCache()
         mCacheDir = KNOB_JIT_CACHE_DIR;
     }
 
+#if defined(PACKAGE_VERSION)
+    mBuildCRC = ComputeCRC(mBuildCRC, PACKAGE_VERSION, sizeof(PACKAGE_VERSION));
+#endif
+#if defined(__APPLE__) || defined(FORCE_LINUX) || defined(__linux__) || defined(__gnu_linux__)
+    // Tell rebuilds of the same version apart by the library itself
+    Dl_info     info;
+    struct stat st;
+    if (dladdr((void*)&ComputeModuleCRC, &info) && info.dli_fname &&
+        stat(info.dli_fname, &st) == 0)
+    {
+        mBuildCRC = ComputeCRC(mBuildCRC, &st.st_mtime, sizeof(st.st_mtime));
+        mBuildCRC = ComputeCRC(mBuildCRC, &st.st_size, sizeof(st.st_size));
+    }
+#endif
+
     // Create cache dir at startup to allow jitter to write debug.ll files
     // to that directory.
     if (!llvm::sys::fs::exists(mCacheDir.str()) &&
@@ -745,8 +813,31 @@ void JitCache::notifyObjectCompiled(const llvm::Module* M, llvm::MemoryBufferRef
 std::unique_ptr<llvm::MemoryBuffer> JitCache::getObject(const llvm::Module* M)
 {
     const std::string& moduleID = M->getModuleIdentifier();
-    mCurrentModuleCRC           = ComputeModuleCRC(M);
+    mCurrentModuleCRC           = mNextModuleCRC ? mNextModuleCRC : ComputeModuleCRC(M);
+    mNextModuleCRC              = 0;
+
+    return LoadObject(moduleID);
+}
 
+/// Returns the object cached for moduleID by a module keyed on the same
+/// state, or 0.  Doesn't need the module IR.
+std::unique_ptr<llvm::MemoryBuffer>
+JitCache::GetObject(const std::string& moduleID, const void* pState, size_t stateSize)
+{
+    mCurrentModuleCRC = ComputeStateCRC(pState, stateSize);
+
+    return LoadObject(moduleID);
+}
+
+uint32_t JitCache::ComputeStateCRC(const void* pState, size_t stateSize)
+{
+    // Never 0, which means the IR is the key
+    uint32_t crc = ComputeCRC(mBuildCRC, pState, stateSize);
+    return crc ? crc : 1;
+}
+
+std::unique_ptr<llvm::MemoryBuffer> JitCache::LoadObject(const std::string& moduleID)
+{
     if (!moduleID.length())
     {
         return nullptr;
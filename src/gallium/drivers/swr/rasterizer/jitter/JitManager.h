@@ -110,6 +110,18 @@ public:
     /// available.
     std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* M) override;
 
+    /// Key the next module handed to getObject by the state it is built
+    /// from instead of by its IR.
+    void SetModuleKey(const void* pState, size_t stateSize)
+    {
+        mNextModuleCRC = ComputeStateCRC(pState, stateSize);
+    }
+
+    /// Returns the object cached for moduleID by a module keyed on the
+    /// same state, or 0.  Doesn't need the module IR.
+    std::unique_ptr<llvm::MemoryBuffer>
+    GetObject(const std::string& moduleID, const void* pState, size_t stateSize);
+
     const char* GetModuleCacheDir() { return mModuleCacheDir.c_str(); }
 
 private:
@@ -117,6 +129,8 @@ private:
     llvm::SmallString<MAX_PATH> mCacheDir;
     llvm::SmallString<MAX_PATH> mModuleCacheDir;
     uint32_t                    mCurrentModuleCRC = 0;
+    uint32_t                    mNextModuleCRC    = 0;
+    uint32_t                    mBuildCRC         = 0;
     JitManager*                 mpJitMgr          = nullptr;
     llvm::CodeGenOpt::Level     mOptLevel         = llvm::CodeGenOpt::None;
 
@@ -124,6 +138,12 @@ private:
     /// This is always a subdirectory of mCacheDir.  Full absolute
     /// path name will be stored in mCurrentModuleCacheDir
     void CalcModuleCacheDir();
+
+    /// State keys are only valid for the build of the jitter that wrote
+    /// them, the IR built from a state changes with the code.
+    uint32_t ComputeStateCRC(const void* pState, size_t stateSize);
+
+    std::unique_ptr<llvm::MemoryBuffer> LoadObject(const std::string& moduleID);
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -168,6 +188,10 @@ struct JitManager
     void CreateExecEngine(std::unique_ptr<llvm::Module> M);
     void SetupNewModule();
 
+    // Object cache lookup keyed on the compile state, see JitCache::GetObject
+    void* GetCachedFunction(const char* pPrefix, const void* pState, size_t stateSize);
+    void  SetModuleCacheKey(const void* pState, size_t stateSize);
+
     void               DumpAsm(llvm::Function* pFunction, const char* fileName);
     static void        DumpToFile(llvm::Function* f, const char* fileName);
     static void        DumpToFile(llvm::Module*                   M,
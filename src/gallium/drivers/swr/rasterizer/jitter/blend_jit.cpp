@@ -913,6 +913,15 @@ extern "C" PFN_BLEND_JIT_FUNC JITCALL JitCompileBlend(HANDLE
 
     pJitMgr->SetupNewModule();
 
+    PFN_BLEND_JIT_FUNC pfnBlend =
+        (PFN_BLEND_JIT_FUNC)pJitMgr->GetCachedFunction("BLND_", &state, sizeof(state));
+    if (pfnBlend)
+    {
+        return pfnBlend;
+    }
+
+    pJitMgr->SetModuleCacheKey(&state, sizeof(state));
+
     BlendJit theJit(pJitMgr);
     HANDLE   hFunc = theJit.Create(state);
 
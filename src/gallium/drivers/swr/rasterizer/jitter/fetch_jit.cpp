@@ -2323,6 +2323,17 @@ extern "C" PFN_FETCH_FUNC JITCALL JitCompileFetch(HANDLE hJitMgr, const FETCH_CO
 
     pJitMgr->SetupNewModule();
 
+    gFetchCodegenMutex.lock();
+    PFN_FETCH_FUNC pfnFetch =
+        (PFN_FETCH_FUNC)pJitMgr->GetCachedFunction("FCH_", &state, sizeof(state));
+    gFetchCodegenMutex.unlock();
+    if (pfnFetch)
+    {
+        return pfnFetch;
+    }
+
+    pJitMgr->SetModuleCacheKey(&state, sizeof(state));
+
     FetchJit theJit(pJitMgr);
     HANDLE   hFunc = theJit.Create(state);
 
@@ -53,6 +53,7 @@
 #include "llvm/IR/IntrinsicsX86.h"
 #endif
 #include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/Object/ObjectFile.h"
 
 #include "llvm/IR/Verifier.h"
 #include "llvm/ExecutionEngine/MCJIT.h"
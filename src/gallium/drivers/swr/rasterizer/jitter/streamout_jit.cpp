@@ -370,6 +370,15 @@ extern "C" PFN_SO_FUNC JITCALL JitCompileStreamout(HANDLE
 
     pJitMgr->SetupNewModule();
 
+    PFN_SO_FUNC pfnStreamOut =
+        (PFN_SO_FUNC)pJitMgr->GetCachedFunction("SO_", &soState, sizeof(soState));
+    if (pfnStreamOut)
+    {
+        return pfnStreamOut;
+    }
+
+    pJitMgr->SetModuleCacheKey(&soState, sizeof(soState));
+
     StreamOutJit theJit(pJitMgr);
     HANDLE       hFunc = theJit.Create(soState);
 
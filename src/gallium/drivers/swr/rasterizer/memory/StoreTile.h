@@ -1817,6 +1817,129 @@ struct StoreMacroTile
 
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Returns whether the macrotile can be stored by StoreStreaming.
+    /// @param pDstSurface - Destination surface state
+    /// @param x, y - Coordinates to macro tile
+    static bool CanStoreStreaming(
+        const SWR_SURFACE_STATE* pDstSurface,
+        uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex)
+    {
+        static const uint32_t DST_BYTES_PER_PIXEL = FormatTraits<DstFormat>::bpp / 8;
+
+        if (TTraits::TileMode != SWR_TILE_NONE && TTraits::TileMode != SWR_TILE_MODE_YMAJOR)
+        {
+            return false;
+        }
+
+        // Each 16B column of the destination has to hold whole pixels
+        if (DST_BYTES_PER_PIXEL == 0 || (16 % DST_BYTES_PER_PIXEL) != 0)
+        {
+            return false;
+        }
+
+        uint64_t surfaceBytes = uint64_t(pDstSurface->pitch) * pDstSurface->height;
+        if (KNOB_STREAMING_STORETILE_THRESHOLD == 0 || KNOB_USE_GENERIC_STORETILE ||
+            surfaceBytes < (uint64_t(KNOB_STREAMING_STORETILE_THRESHOLD) << 20))
+        {
+            return false;
+        }
+
+        // Only the top level of the first slice, which is what gets resolved
+        // and presented, so rows and TileY columns are never split up.
+        if (pDstSurface->type != SURFACE_2D || pDstSurface->lod != 0 ||
+            pDstSurface->arrayIndex + renderTargetArrayIndex != 0 ||
+            pDstSurface->numSamples > 1 || pDstSurface->xpAuxBaseAddress ||
+            (pDstSurface->pitch & 0xf))
+        {
+            return false;
+        }
+
+        if (x + KNOB_MACROTILE_X_DIM > pDstSurface->width ||
+            y + KNOB_MACROTILE_Y_DIM > pDstSurface->height)
+        {
+            return false;
+        }
+
+        size_t alignMask = (TTraits::TileMode == SWR_TILE_NONE) ? 0xf : 0xfff;
+        return (pDstSurface->xpBaseAddress & alignMask) == 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Stores a macrotile to the destination surface with non-temporal
+    ///        stores.  Each row of raster tiles is converted into a linear
+    ///        scratch buffer first, which is then streamed out in 16B columns.
+    /// @param pSrc - Pointer to macro tile.
+    /// @param pDstSurface - Destination surface state
+    /// @param x, y - Coordinates to macro tile
+    static void StoreStreaming(
+        uint8_t *pSrcHotTile,
+        SWR_SURFACE_STATE* pDstSurface,
+        uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex)
+    {
+        static const uint32_t DST_BYTES_PER_PIXEL = FormatTraits<DstFormat>::bpp / 8;
+        static const uint32_t ROW_BYTES = KNOB_MACROTILE_X_DIM * DST_BYTES_PER_PIXEL;
+        static const uint32_t ROW_COLUMNS = ROW_BYTES / 16;
+        static const uint32_t COLUMN_PIXELS = 16 / std::max(DST_BYTES_PER_PIXEL, 1U);
+
+        // The rows of a raster tile are contiguous in a TileY column
+        static_assert(32 % KNOB_TILE_Y_DIM == 0, "Invalid tile y dim");
+
+        typedef OptStoreRasterTile<TilingTraits<SWR_TILE_NONE, FormatTraits<DstFormat>::bpp>, SrcFormat, DstFormat> ScratchStoreTile;
+
+        OSALIGNSIMD16(uint8_t) scratch[KNOB_TILE_Y_DIM * ROW_BYTES];
+
+        SWR_SURFACE_STATE scratchSurface = *pDstSurface;
+        scratchSurface.xpBaseAddress = (gfxptr_t)scratch;
+        scratchSurface.tileMode = SWR_TILE_NONE;
+        scratchSurface.width = KNOB_MACROTILE_X_DIM;
+        scratchSurface.height = KNOB_TILE_Y_DIM;
+        scratchSurface.depth = 1;
+        scratchSurface.pitch = ROW_BYTES;
+        scratchSurface.qpitch = KNOB_TILE_Y_DIM;
+
+        const simd4scalari *pScratch = reinterpret_cast<const simd4scalari *>(scratch);
+
+        for (uint32_t row = 0; row < KNOB_MACROTILE_Y_DIM; row += KNOB_TILE_Y_DIM)
+        {
+            for (uint32_t col = 0; col < KNOB_MACROTILE_X_DIM; col += KNOB_TILE_X_DIM)
+            {
+                ScratchStoreTile::Store(pSrcHotTile, &scratchSurface, col, 0, 0, 0);
+                pSrcHotTile += KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * (FormatTraits<SrcFormat>::bpp / 8);
+            }
+
+            if (TTraits::TileMode == SWR_TILE_NONE)
+            {
+                for (uint32_t yy = 0; yy < KNOB_TILE_Y_DIM; ++yy)
+                {
+                    simd4scalari *pDst = (simd4scalari*)ComputeSurfaceAddress<false, false>(
+                        x, y + row + yy, 0, 0, 0, 0, pDstSurface);
+
+                    for (uint32_t c = 0; c < ROW_COLUMNS; ++c)
+                    {
+                        SIMD128::stream_si(pDst + c, SIMD128::load_si(pScratch + yy * ROW_COLUMNS + c));
+                    }
+                }
+            }
+            else
+            {
+                for (uint32_t c = 0; c < ROW_COLUMNS; ++c)
+                {
+                    simd4scalari *pDst = (simd4scalari*)ComputeSurfaceAddress<false, false>(
+                        x + c * COLUMN_PIXELS, y + row, 0, 0, 0, 0, pDstSurface);
+
+                    for (uint32_t yy = 0; yy < KNOB_TILE_Y_DIM; ++yy)
+                    {
+                        SIMD128::stream_si(pDst + yy, SIMD128::load_si(pScratch + yy * ROW_COLUMNS + c));
+                    }
+                }
+            }
+        }
+
+        // Whoever reads the surface next may be on another thread
+        _mm_sfence();
+    }
+
     typedef void(*PFN_STORE_TILES_INTERNAL)(uint8_t*, SWR_SURFACE_STATE*, uint32_t, uint32_t, uint32_t, uint32_t);
     //////////////////////////////////////////////////////////////////////////
     /// @brief Stores a macrotile to the destination surface.
@@ -1828,6 +1951,11 @@ struct StoreMacroTile
         SWR_SURFACE_STATE* pDstSurface,
         uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex)
     {
+        if (CanStoreStreaming(pDstSurface, x, y, renderTargetArrayIndex))
+        {
+            return StoreStreaming(pSrcHotTile, pDstSurface, x, y, renderTargetArrayIndex);
+        }
+
         PFN_STORE_TILES_INTERNAL pfnStore[SWR_MAX_NUM_MULTISAMPLES];
 
         for (uint32_t sampleNum = 0; sampleNum < pDstSurface->numSamples; sampleNum++)
@@ -368,9 +368,48 @@ swr_store_dirty_resource(struct pipe_context *pipe,
    }
 }
 
+/*
+ * The contents of the resource are undefined from here on, so discard any
+ * hottiles bound to it rather than loading them on the next draw.
+ */
+static void
+swr_invalidate_resource(struct pipe_context *pipe,
+                        struct pipe_resource *resource)
+{
+   struct swr_context *ctx = swr_context(pipe);
+   struct swr_resource *spr = swr_resource(resource);
+   SWR_SURFACE_STATE *renderTargets = ctx->swrDC.renderTargets;
+
+   if (resource->target == PIPE_BUFFER)
+      return;
+
+   for (uint32_t i = 0; i < SWR_NUM_ATTACHMENTS; i++) {
+      SWR_SURFACE_STATE *renderTarget = &renderTargets[i];
+      if (!renderTarget->xpBaseAddress)
+         continue;
+      if (renderTarget->xpBaseAddress != spr->swr.xpBaseAddress &&
+          (!spr->secondary.xpBaseAddress ||
+           renderTarget->xpBaseAddress != spr->secondary.xpBaseAddress))
+         continue;
+
+      /* Only fully covered macrotiles are discarded, round the rect up to
+       * include the partial ones along the right and bottom edges. */
+      uint32_t width = u_minify(renderTarget->width, renderTarget->lod);
+      uint32_t height = u_minify(renderTarget->height, renderTarget->lod);
+      SWR_RECT full_rect =
+         {0, 0,
+          (int32_t)align(width, KNOB_MACROTILE_X_DIM),
+          (int32_t)align(height, KNOB_MACROTILE_Y_DIM)};
+
+      swr_update_draw_context(ctx);
+      ctx->api.pfnSwrDiscardRect(ctx->swrContext, 1 << i, full_rect);
+   }
+}
+
 void
 swr_draw_init(struct pipe_context *pipe)
 {
    pipe->draw_vbo = swr_draw_vbo;
    pipe->flush = swr_flush;
+   pipe->invalidate_resource = swr_invalidate_resource;
 }
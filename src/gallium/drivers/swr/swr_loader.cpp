@@ -103,7 +103,12 @@ swr_create_screen(struct sw_winsys *winsys)
 #endif
    }
 
-   if (util_cpu_caps.has_avx512f && util_cpu_caps.has_avx512bw) {
+   /* The SKX library is built with -march=skylake-avx512, which is free to
+    * use all of these, and runs the SIMD16 front and back end natively.
+    */
+   if (util_cpu_caps.has_avx512f && util_cpu_caps.has_avx512bw &&
+       util_cpu_caps.has_avx512dq && util_cpu_caps.has_avx512vl &&
+       util_cpu_caps.has_avx512cd) {
       swr_print_info("SWR detected SKX instruction support ");
 #ifndef HAVE_SWR_SKX
       swr_print_info("(skipping not built).\n");
@@ -58,6 +58,9 @@ struct swr_resource {
 
    /* last pipe that used (validated) this resource */
    struct pipe_context *curr_pipe;
+
+   /* memory was spread over the NUMA nodes rendering to it */
+   bool numa_placed;
 };
 
 
@@ -737,6 +737,27 @@ swr_set_viewport_states(struct pipe_context *pipe,
 }
 
 
+/*
+ * The first time a resource is rendered to, move its memory to the NUMA
+ * nodes whose workers own its macrotiles.
+ */
+static void
+swr_place_surface_memory(struct swr_context *ctx, struct pipe_surface *surf)
+{
+   if (!surf || !surf->texture)
+      return;
+
+   struct swr_resource *res = swr_resource(surf->texture);
+   if (res->numa_placed || res->display_target)
+      return;
+
+   ctx->api.pfnSwrPlaceSurfaceMemory(ctx->swrContext, &res->swr);
+   if (res->secondary.xpBaseAddress)
+      ctx->api.pfnSwrPlaceSurfaceMemory(ctx->swrContext, &res->secondary);
+
+   res->numa_placed = true;
+}
+
 static void
 swr_set_framebuffer_state(struct pipe_context *pipe,
                           const struct pipe_framebuffer_state *fb)
@@ -754,6 +775,10 @@ swr_set_framebuffer_state(struct pipe_context *pipe,
       /* 0 and 1 both indicate no msaa.  Core doesn't understand 0 samples */
       ctx->framebuffer.samples = std::max((ubyte)1, ctx->framebuffer.samples);
 
+      for (unsigned i = 0; i < fb->nr_cbufs; i++)
+         swr_place_surface_memory(ctx, fb->cbufs[i]);
+      swr_place_surface_memory(ctx, fb->zsbuf);
+
       ctx->dirty |= SWR_NEW_FRAMEBUFFER;
    }
 }
@@ -1740,7 +1765,9 @@ swr_update_derived(struct pipe_context *pipe,
       }
       SWR_PS_STATE psState = {0};
       psState.pfnPixelShader = func;
-      psState.killsPixel = ctx->fs->info.base.uses_kill;
+      /* polygon stipple is implemented as a kill in the shader */
+      psState.killsPixel =
+         ctx->fs->info.base.uses_kill || key.poly_stipple_enable;
       psState.inputCoverage = SWR_INPUT_COVERAGE_NORMAL;
       psState.writesODepth = ctx->fs->info.base.writes_z;
       psState.usesSourceDepth = ctx->fs->info.base.reads_z;
@@ -48,6 +48,14 @@ static void virgl_buffer_transfer_unmap(struct pipe_context *ctx,
 
       if (trans->copy_src_hw_res) {
          virgl_encode_copy_transfer(vctx, trans);
+
+         vctx->last_copy.hw_res = trans->hw_res;
+         vctx->last_copy.src_hw_res = trans->copy_src_hw_res;
+         vctx->last_copy.cdw = vctx->cbuf->cdw;
+         vctx->last_copy.src_offset = trans->copy_src_offset;
+         vctx->last_copy.x = transfer->box.x;
+         vctx->last_copy.width = transfer->box.width;
+
          virgl_resource_destroy_transfer(vctx, trans);
       } else {
          virgl_transfer_queue_unmap(&vctx->queue, trans);
@@ -941,6 +941,7 @@ static void virgl_flush_eq(struct virgl_context *ctx, void *closure,
     * involving staging resources.
     */
    ctx->queued_staging_res_size = 0;
+   ctx->last_copy.hw_res = NULL;
 }
 
 static void virgl_flush_from_st(struct pipe_context *ctx,
@@ -101,6 +101,19 @@ struct virgl_context {
 
    /* The total size of staging resources used in queued copy transfers. */
    uint64_t queued_staging_res_size;
+
+   /* The last buffer copy transfer encoded in cbuf.  As long as nothing was
+    * encoded after it (cdw is unchanged), uploads appending to the same
+    * buffer can be added to it instead of encoding another copy transfer.
+    * These are not references, and must only be used while cdw matches.
+    */
+   struct {
+      struct virgl_hw_res *hw_res;
+      struct virgl_hw_res *src_hw_res;
+      uint32_t cdw;
+      uint32_t src_offset;
+      uint32_t x, width;
+   } last_copy;
 };
 
 static inline struct virgl_sampler_view *
@@ -25,6 +25,7 @@
 #include "util/u_memory.h"
 #include "util/u_upload_mgr.h"
 #include "virgl_context.h"
+#include "virgl_protocol.h"
 #include "virgl_resource.h"
 #include "virgl_screen.h"
 #include "virgl_staging_mgr.h"
@@ -590,6 +591,44 @@ void virgl_init_screen_resource_functions(struct pipe_screen *screen)
     screen->resource_destroy = u_resource_destroy_vtbl;
 }
 
+/* Try to append an upload to the copy transfer encoded last, if it targets
+ * the same buffer right before offset and its staging data is right before
+ * the free space of the staging buffer.  This turns runs of small uploads to
+ * a busy buffer (e.g. glBufferSubData in a loop) into a single copy
+ * transfer, instead of one command and one host copy for each.
+ */
+static bool
+virgl_buffer_extend_copy_transfer(struct virgl_context *vctx,
+                                  struct virgl_resource *vbuf,
+                                  unsigned offset, unsigned size,
+                                  const void *data)
+{
+   struct virgl_staging_mgr *staging = &vctx->staging;
+   uint32_t *cmd;
+
+   if (!vctx->last_copy.hw_res ||
+       vctx->last_copy.cdw != vctx->cbuf->cdw ||
+       vctx->last_copy.hw_res != vbuf->hw_res ||
+       vctx->last_copy.x + vctx->last_copy.width != offset ||
+       vctx->last_copy.src_hw_res != staging->hw_res ||
+       vctx->last_copy.src_offset + vctx->last_copy.width != staging->offset ||
+       staging->offset + size > staging->size)
+      return false;
+
+   memcpy(staging->map + staging->offset, data, size);
+   staging->offset += size;
+   vctx->last_copy.width += size;
+   vctx->queued_staging_res_size += size;
+
+   /* The staging data of a buffer copy transfer is tightly packed. */
+   cmd = vctx->cbuf->buf + vctx->cbuf->cdw - (VIRGL_COPY_TRANSFER3D_SIZE + 1);
+   cmd[VIRGL_RESOURCE_IW_STRIDE] = vctx->last_copy.width;
+   cmd[VIRGL_RESOURCE_IW_LAYER_STRIDE] = vctx->last_copy.width;
+   cmd[VIRGL_RESOURCE_IW_W] = vctx->last_copy.width;
+
+   return true;
+}
+
 static void virgl_buffer_subdata(struct pipe_context *pipe,
                                  struct pipe_resource *resource,
                                  unsigned usage, unsigned offset,
@@ -612,6 +651,12 @@ static void virgl_buffer_subdata(struct pipe_context *pipe,
       return;
    }
 
+   if (likely(!(virgl_debug & VIRGL_DEBUG_XFER)) &&
+       virgl_buffer_extend_copy_transfer(vctx, vbuf, offset, size, data)) {
+      util_range_add(&vbuf->u.b, &vbuf->valid_buffer_range, offset, offset + size);
+      return;
+   }
+
    u_default_buffer_subdata(pipe, resource, usage, offset, size, data);
 }
 
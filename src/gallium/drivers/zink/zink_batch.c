@@ -54,6 +54,7 @@ void
 zink_start_batch(struct zink_context *ctx, struct zink_batch *batch)
 {
    reset_batch(ctx, batch);
+   batch->serial++;
 
    VkCommandBufferBeginInfo cbbi = {};
    cbbi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
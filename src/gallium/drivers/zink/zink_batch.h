@@ -42,6 +42,7 @@ struct zink_batch {
    VkCommandBuffer cmdbuf;
    VkDescriptorPool descpool;
    int descs_left;
+   unsigned serial; /* bumped every time the batch is started */
    struct zink_fence *fence;
 
    struct zink_render_pass *rp;
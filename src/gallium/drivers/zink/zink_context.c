@@ -374,7 +374,10 @@ zink_set_vertex_buffers(struct pipe_context *pctx,
          const struct pipe_vertex_buffer *vb = buffers + i;
          struct zink_resource *res = zink_resource(vb->buffer.resource);
 
-         ctx->gfx_pipeline_state.bindings[start_slot + i].stride = vb->stride;
+         if (ctx->gfx_pipeline_state.bindings[start_slot + i].stride != vb->stride) {
+            ctx->gfx_pipeline_state.bindings[start_slot + i].stride = vb->stride;
+            ctx->gfx_pipeline_state.dirty = true;
+         }
          if (res && res->needs_xfb_barrier) {
             /* if we're binding a previously-used xfb buffer, we need cmd buffer synchronization to ensure
              * that we use the right buffer data
@@ -674,6 +677,7 @@ zink_set_framebuffer_state(struct pipe_context *pctx,
 
    ctx->gfx_pipeline_state.rast_samples = MAX2(state->samples, 1);
    ctx->gfx_pipeline_state.num_attachments = state->nr_cbufs;
+   ctx->gfx_pipeline_state.dirty = true;
 
    struct zink_batch *batch = zink_batch_no_rp(ctx);
 
@@ -693,6 +697,7 @@ zink_set_sample_mask(struct pipe_context *pctx, unsigned sample_mask)
 {
    struct zink_context *ctx = zink_context(pctx);
    ctx->gfx_pipeline_state.sample_mask = sample_mask;
+   ctx->gfx_pipeline_state.dirty = true;
 }
 
 static VkAccessFlags
@@ -948,10 +953,16 @@ zink_flush(struct pipe_context *pctx,
     * either be swapped with the front-buffer, or blitted from. But for
     * some strange reason, neither of these things happen.
     */
-   if (flags & PIPE_FLUSH_END_OF_FRAME)
+   if (flags & PIPE_FLUSH_END_OF_FRAME) {
       pctx->screen->fence_finish(pctx->screen, pctx,
                                  (struct pipe_fence_handle *)batch->fence,
                                  PIPE_TIMEOUT_INFINITE);
+
+      /* Applications don't reliably tear down the screen, store the
+       * pipelines built so far at frame boundaries instead.
+       */
+      zink_screen_update_pipeline_cache(zink_screen(pctx->screen));
+   }
 }
 
 static void
@@ -1115,6 +1126,8 @@ zink_context_create(struct pipe_screen *pscreen, void *priv, unsigned flags)
    ctx->base.screen = pscreen;
    ctx->base.priv = priv;
 
+   ctx->gfx_pipeline_state.dirty = true;
+
    ctx->base.destroy = zink_context_destroy;
 
    zink_context_state_init(&ctx->base);
@@ -11,6 +11,93 @@
 #include "util/u_helpers.h"
 #include "util/u_inlines.h"
 #include "util/u_prim.h"
+#include "util/ralloc.h"
+
+/* Contents of a descriptor set: the buffer infos followed by the image infos
+ * of all the bindings of the program, in the order they were written.
+ */
+struct desc_set_key {
+   VkDescriptorSet desc_set;
+   size_t size;
+   uint8_t data[];
+};
+
+static uint32_t
+hash_desc_set_key(const void *key)
+{
+   const struct desc_set_key *k = key;
+   return _mesa_hash_data(k->data, k->size);
+}
+
+static bool
+equals_desc_set_key(const void *a, const void *b)
+{
+   const struct desc_set_key *ka = a, *kb = b;
+   return ka->size == kb->size && memcmp(ka->data, kb->data, ka->size) == 0;
+}
+
+static void
+free_desc_set_key(struct hash_entry *entry)
+{
+   ralloc_free((void *)entry->key);
+}
+
+/**
+ * Return the descriptor sets of the program which can be reused in this
+ * batch, dropping those of other batches.
+ */
+static struct hash_table *
+get_descriptor_sets(struct zink_batch *batch, struct zink_gfx_program *prog)
+{
+   if (!prog->desc_sets) {
+      prog->desc_sets = _mesa_hash_table_create(NULL, hash_desc_set_key,
+                                                equals_desc_set_key);
+      if (!prog->desc_sets)
+         return NULL;
+   }
+
+   /* Sets don't survive the reset of the pool they come from. */
+   if (prog->desc_sets_batch != batch ||
+       prog->desc_sets_serial != batch->serial) {
+      _mesa_hash_table_clear(prog->desc_sets, free_desc_set_key);
+      prog->desc_sets_batch = batch;
+      prog->desc_sets_serial = batch->serial;
+   }
+
+   return prog->desc_sets;
+}
+
+/**
+ * Look for a descriptor set already written with the same contents by this
+ * program in the current batch, which draws can bind again as is.
+ */
+static struct hash_entry *
+find_descriptor_set(struct zink_batch *batch, struct zink_gfx_program *prog,
+                    const struct desc_set_key *key, uint32_t hash)
+{
+   struct hash_table *desc_sets = get_descriptor_sets(batch, prog);
+   if (!desc_sets)
+      return NULL;
+
+   return _mesa_hash_table_search_pre_hashed(desc_sets, hash, key);
+}
+
+static void
+add_descriptor_set(struct zink_batch *batch, struct zink_gfx_program *prog,
+                   const struct desc_set_key *key, uint32_t hash)
+{
+   struct hash_table *desc_sets = get_descriptor_sets(batch, prog);
+   if (!desc_sets)
+      return;
+
+   struct desc_set_key *copy =
+      ralloc_size(desc_sets, sizeof(*copy) + key->size);
+   if (!copy)
+      return;
+
+   memcpy(copy, key, sizeof(*copy) + key->size);
+   _mesa_hash_table_insert_pre_hashed(desc_sets, hash, copy, copy);
+}
 
 static VkDescriptorSet
 allocate_descriptor_set(struct zink_screen *screen,
@@ -303,6 +390,8 @@ zink_draw_vbo(struct pipe_context *pctx,
                transitions[num_transitions++] = res;
                layout = VK_IMAGE_LAYOUT_GENERAL;
             }
+            /* Zero the padding, image infos are compared bytewise. */
+            memset(&image_infos[num_image_info], 0, sizeof(*image_infos));
             image_infos[num_image_info].imageLayout = layout;
             image_infos[num_image_info].imageView = sampler_view->image_view;
             image_infos[num_image_info].sampler = ctx->samplers[i][index];
@@ -342,15 +431,37 @@ zink_draw_vbo(struct pipe_context *pctx,
 
    batch = zink_batch_rp(ctx);
 
-   if (batch->descs_left < gfx_program->num_descriptors) {
-      ctx->base.flush(&ctx->base, NULL, 0);
-      batch = zink_batch_rp(ctx);
-      assert(batch->descs_left >= gfx_program->num_descriptors);
-   }
+   const size_t buffer_info_size = num_buffer_info * sizeof(*buffer_infos);
+   const size_t image_info_size = num_image_info * sizeof(*image_infos);
+   union {
+      struct desc_set_key key;
+      uint8_t storage[sizeof(struct desc_set_key) +
+                      sizeof(buffer_infos) + sizeof(image_infos)];
+   } desc_key;
+   desc_key.key.size = buffer_info_size + image_info_size;
+   memcpy(desc_key.key.data, buffer_infos, buffer_info_size);
+   memcpy(desc_key.key.data + buffer_info_size, image_infos, image_info_size);
+   uint32_t desc_hash = hash_desc_set_key(&desc_key.key);
 
-   VkDescriptorSet desc_set = allocate_descriptor_set(screen, batch,
-                                                      gfx_program);
-   assert(desc_set != VK_NULL_HANDLE);
+   VkDescriptorSet desc_set;
+   struct hash_entry *desc_entry =
+      find_descriptor_set(batch, gfx_program, &desc_key.key, desc_hash);
+   if (desc_entry) {
+      desc_set = ((struct desc_set_key *)desc_entry->data)->desc_set;
+      num_wds = 0;
+   } else {
+      if (batch->descs_left < gfx_program->num_descriptors) {
+         ctx->base.flush(&ctx->base, NULL, 0);
+         batch = zink_batch_rp(ctx);
+         assert(batch->descs_left >= gfx_program->num_descriptors);
+      }
+
+      desc_set = allocate_descriptor_set(screen, batch, gfx_program);
+      assert(desc_set != VK_NULL_HANDLE);
+
+      desc_key.key.desc_set = desc_set;
+      add_descriptor_set(batch, gfx_program, &desc_key.key, desc_hash);
+   }
 
    for (int i = 0; i < ARRAY_SIZE(ctx->gfx_stages); i++) {
       struct zink_shader *shader = ctx->gfx_stages[i];
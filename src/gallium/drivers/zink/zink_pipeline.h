@@ -51,6 +51,12 @@ struct zink_gfx_pipeline_state {
 
    VkSampleMask sample_mask;
    uint8_t rast_samples;
+
+   /* Pre-hashed value of the state above, recomputed on the next lookup
+    * when dirty is set.  Everything that changes the state must set dirty.
+    */
+   uint32_t hash;
+   bool dirty;
 };
 
 VkPipeline
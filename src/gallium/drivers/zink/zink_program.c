@@ -104,13 +104,13 @@ create_pipeline_layout(VkDevice dev, VkDescriptorSetLayout dsl)
 static uint32_t
 hash_gfx_pipeline_state(const void *key)
 {
-   return _mesa_hash_data(key, sizeof(struct zink_gfx_pipeline_state));
+   return _mesa_hash_data(key, offsetof(struct zink_gfx_pipeline_state, hash));
 }
 
 static bool
 equals_gfx_pipeline_state(const void *a, const void *b)
 {
-   return memcmp(a, b, sizeof(struct zink_gfx_pipeline_state)) == 0;
+   return memcmp(a, b, offsetof(struct zink_gfx_pipeline_state, hash)) == 0;
 }
 
 struct zink_gfx_program *
@@ -202,6 +202,9 @@ zink_destroy_gfx_program(struct zink_screen *screen,
       _mesa_hash_table_destroy(prog->pipelines[i], NULL);
    }
 
+   if (prog->desc_sets)
+      _mesa_hash_table_destroy(prog->desc_sets, NULL);
+
    FREE(prog);
 }
 
@@ -253,9 +256,14 @@ zink_get_gfx_pipeline(struct zink_screen *screen,
 {
    assert(mode <= ARRAY_SIZE(prog->pipelines));
 
-   /* TODO: use pre-hashed versions to save some time (can re-hash only when
-      state changes) */
-   struct hash_entry *entry = _mesa_hash_table_search(prog->pipelines[mode], state);
+   if (state->dirty) {
+      state->hash = hash_gfx_pipeline_state(state);
+      state->dirty = false;
+   }
+
+   struct hash_entry *entry =
+      _mesa_hash_table_search_pre_hashed(prog->pipelines[mode],
+                                         state->hash, state);
    if (!entry) {
       VkPrimitiveTopology vkmode = primitive_topology(mode);
       VkPipeline pipeline = zink_create_gfx_pipeline(screen, prog,
@@ -270,7 +278,9 @@ zink_get_gfx_pipeline(struct zink_screen *screen,
       memcpy(&pc_entry->state, state, sizeof(*state));
       pc_entry->pipeline = pipeline;
 
-      entry = _mesa_hash_table_insert(prog->pipelines[mode], &pc_entry->state, pc_entry);
+      entry = _mesa_hash_table_insert_pre_hashed(prog->pipelines[mode],
+                                                 state->hash,
+                                                 &pc_entry->state, pc_entry);
       assert(entry);
 
       reference_render_pass(screen, prog, state->render_pass);
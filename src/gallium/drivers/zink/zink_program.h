@@ -28,6 +28,7 @@
 
 #include "pipe/p_state.h"
 
+struct zink_batch;
 struct zink_context;
 struct zink_screen;
 struct zink_shader;
@@ -43,6 +44,13 @@ struct zink_gfx_program {
    unsigned num_descriptors;
    struct hash_table *pipelines[PIPE_PRIM_TRIANGLE_FAN + 1];
    struct set *render_passes;
+
+   /* Descriptor sets written for this program in the batch identified by
+    * desc_sets_batch and desc_sets_serial, keyed on their contents.
+    */
+   struct hash_table *desc_sets;
+   struct zink_batch *desc_sets_batch;
+   unsigned desc_sets_serial;
 };
 
 struct zink_gfx_program *
@@ -30,6 +30,7 @@
 #include "zink_resource.h"
 
 #include "os/os_process.h"
+#include "util/disk_cache.h"
 #include "util/u_debug.h"
 #include "util/format/u_format.h"
 #include "util/u_math.h"
@@ -595,10 +596,99 @@ zink_is_format_supported(struct pipe_screen *pscreen,
    return true;
 }
 
+static void
+pipeline_cache_init(struct zink_screen *screen)
+{
+   struct mesa_sha1 ctx;
+   unsigned char sha1[20];
+   char cache_id[20 * 2 + 1];
+   void *data = NULL;
+   size_t size = 0;
+
+   _mesa_sha1_init(&ctx);
+   if (disk_cache_get_function_identifier(pipeline_cache_init, &ctx)) {
+      _mesa_sha1_final(&ctx, sha1);
+      disk_cache_format_hex_id(cache_id, sha1, 20 * 2);
+      screen->disk_cache = disk_cache_create("zink", cache_id, 0);
+   }
+
+   if (screen->disk_cache) {
+      /* The blob is only usable with the device and Vulkan driver it was
+       * retrieved from, so key it on what identifies them.
+       */
+      struct {
+         uint32_t vendor_id;
+         uint32_t device_id;
+         uint8_t uuid[VK_UUID_SIZE];
+      } id;
+      id.vendor_id = screen->props.vendorID;
+      id.device_id = screen->props.deviceID;
+      memcpy(id.uuid, screen->props.pipelineCacheUUID, VK_UUID_SIZE);
+
+      disk_cache_compute_key(screen->disk_cache, &id, sizeof(id),
+                             screen->disk_cache_key);
+      data = disk_cache_get(screen->disk_cache, screen->disk_cache_key, &size);
+   }
+
+   VkPipelineCacheCreateInfo pcci = {};
+   pcci.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+   pcci.initialDataSize = data ? size : 0;
+   pcci.pInitialData = data;
+   if (vkCreatePipelineCache(screen->dev, &pcci, NULL,
+                             &screen->pipeline_cache) == VK_SUCCESS)
+      screen->pipeline_cache_size = pcci.initialDataSize;
+   else
+      screen->pipeline_cache = VK_NULL_HANDLE;
+
+   free(data);
+}
+
+/**
+ * Write the pipeline cache back to the disk cache if it grew since it was
+ * last loaded or stored, so that the next run doesn't have to compile the
+ * same pipelines again.
+ */
+void
+zink_screen_update_pipeline_cache(struct zink_screen *screen)
+{
+   size_t size = 0;
+
+   if (!screen->disk_cache || screen->pipeline_cache == VK_NULL_HANDLE ||
+       !screen->pipeline_cache_dirty)
+      return;
+
+   screen->pipeline_cache_dirty = false;
+
+   if (vkGetPipelineCacheData(screen->dev, screen->pipeline_cache,
+                              &size, NULL) != VK_SUCCESS ||
+       size == screen->pipeline_cache_size)
+      return;
+
+   void *data = malloc(size);
+   if (!data)
+      return;
+
+   if (vkGetPipelineCacheData(screen->dev, screen->pipeline_cache,
+                              &size, data) == VK_SUCCESS) {
+      disk_cache_put(screen->disk_cache, screen->disk_cache_key,
+                     data, size, NULL);
+      screen->pipeline_cache_size = size;
+   }
+
+   free(data);
+}
+
 static void
 zink_destroy_screen(struct pipe_screen *pscreen)
 {
    struct zink_screen *screen = zink_screen(pscreen);
+
+   if (screen->pipeline_cache != VK_NULL_HANDLE) {
+      zink_screen_update_pipeline_cache(screen);
+      vkDestroyPipelineCache(screen->dev, screen->pipeline_cache, NULL);
+   }
+   disk_cache_destroy(screen->disk_cache);
+
    slab_destroy_parent(&screen->transfer_pool);
    FREE(screen);
 }
@@ -974,6 +1064,8 @@ zink_internal_create_screen(struct sw_winsys *winsys, int fd)
    if (!load_device_extensions(screen))
       goto fail;
 
+   pipeline_cache_init(screen);
+
    screen->winsys = winsys;
 
    screen->base.get_name = zink_get_name;
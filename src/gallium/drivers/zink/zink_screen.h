@@ -25,6 +25,7 @@
 #define ZINK_SCREEN_H
 
 #include "pipe/p_screen.h"
+#include "util/disk_cache.h"
 #include "util/slab.h"
 
 #include <vulkan/vulkan.h>
@@ -42,6 +43,14 @@ struct zink_screen {
 
    struct slab_parent_pool transfer_pool;
 
+   struct disk_cache *disk_cache;
+   cache_key disk_cache_key;
+
+   VkPipelineCache pipeline_cache;
+   size_t pipeline_cache_size;
+   /* Have pipelines been created since the cache was last stored? */
+   bool pipeline_cache_dirty;
+
    VkInstance instance;
    VkPhysicalDevice pdev;
 
@@ -97,4 +106,7 @@ zink_get_format(struct zink_screen *screen, enum pipe_format format);
 bool
 zink_is_depth_format_supported(struct zink_screen *screen, VkFormat format);
 
+void
+zink_screen_update_pipeline_cache(struct zink_screen *screen);
+
 #endif
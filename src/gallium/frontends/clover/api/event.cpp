@@ -191,8 +191,8 @@ clEnqueueMarkerWithWaitList(cl_command_queue d_q, cl_uint num_deps,
    }
 
    // Create a hard event that depends on the events in the wait list:
-   // previous commands in the same queue are implicitly serialized
-   // with respect to it -- hard events always are.
+   // if the list is empty it depends on every previous command in the
+   // same queue instead, see command_queue::sequence().
    auto hev = create<hard_event>(q, CL_COMMAND_MARKER, deps);
 
    ret_object(rd_ev, hev);
@@ -204,9 +204,11 @@ clEnqueueMarkerWithWaitList(cl_command_queue d_q, cl_uint num_deps,
 
 CLOVER_API cl_int
 clEnqueueBarrier(cl_command_queue d_q) try {
-   obj(d_q);
+   auto &q = obj(d_q);
 
-   // No need to do anything, q preserves data ordering strictly.
+   // No need to do anything if q preserves data ordering strictly.
+   if (q.out_of_order())
+      create<hard_event>(q, CL_COMMAND_BARRIER, ref_vector<event> {});
 
    return CL_SUCCESS;
 
@@ -226,8 +228,8 @@ clEnqueueBarrierWithWaitList(cl_command_queue d_q, cl_uint num_deps,
    }
 
    // Create a hard event that depends on the events in the wait list:
-   // subsequent commands in the same queue will be implicitly
-   // serialized with respect to it -- hard events always are.
+   // subsequent commands in the same queue will be serialized with
+   // respect to it, see command_queue::sequence().
    auto hev = create<hard_event>(q, CL_COMMAND_BARRIER, deps);
 
    ret_object(rd_ev, hev);
@@ -296,7 +298,7 @@ clFinish(cl_command_queue d_q) try {
    auto &q = obj(d_q);
 
    // Create a temporary hard event -- it implicitly depends on all
-   // the previously queued hard events.
+   // the previously queued hard events, even on out-of-order queues.
    auto hev = create<hard_event>(q, 0, ref_vector<event> {});
 
    // And wait on it.
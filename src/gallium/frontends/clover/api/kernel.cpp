@@ -33,6 +33,8 @@ clCreateKernel(cl_program d_prog, const char *name, cl_int *r_errcode) try {
    if (!name)
       throw error(CL_INVALID_VALUE);
 
+   prog.wait();
+
    auto &sym = find(name_equals(name), prog.symbols());
 
    ret_error(r_errcode, CL_SUCCESS);
@@ -51,6 +53,8 @@ CLOVER_API cl_int
 clCreateKernelsInProgram(cl_program d_prog, cl_uint count,
                          cl_kernel *rd_kerns, cl_uint *r_count) try {
    auto &prog = obj(d_prog);
+
+   prog.wait();
    auto &syms = prog.symbols();
 
    if (rd_kerns && count < syms.size())
@@ -37,6 +37,8 @@ namespace {
       if (!pfn_notify && user_data)
          throw error(CL_INVALID_VALUE);
 
+      prog.wait();
+
       if (prog.kernel_ref_count())
          throw error(CL_INVALID_OPERATION);
 
@@ -183,7 +185,13 @@ clBuildProgram(cl_program d_prog, cl_uint num_devs,
 
    validate_build_common(prog, num_devs, d_devs, pfn_notify, user_data);
 
-   if (prog.has_source) {
+   if (prog.has_source && pfn_notify) {
+      // The application doesn't need to wait for the build to complete
+      // if it asked to be notified, only block once it uses the program.
+      prog.build_async(devs, opts, [=]() {
+            pfn_notify(d_prog, user_data);
+         });
+   } else if (prog.has_source) {
       prog.compile(devs, opts);
       prog.link(devs, opts, { prog });
    } else if (any_of([&](const device &dev){
@@ -336,6 +344,10 @@ clLinkProgram(cl_context d_ctx, cl_uint num_devs, const cl_device_id *d_devs,
    const auto opts = std::string(p_opts ? p_opts : "") + " " +
                      debug_get_option("CLOVER_EXTRA_LINK_OPTIONS", "");
    auto progs = objs(d_progs, num_progs);
+
+   for (auto &p : progs)
+      p.wait();
+
    auto all_devs =
       (d_devs ? objs(d_devs, num_devs) : ref_vector<device>(ctx.devices()));
    auto prog = create<program>(ctx, all_devs);
@@ -378,6 +390,9 @@ clGetProgramInfo(cl_program d_prog, cl_program_info param,
    property_buffer buf { r_buf, size, r_size };
    auto &prog = obj(d_prog);
 
+   if (param != CL_PROGRAM_REFERENCE_COUNT)
+      prog.wait();
+
    switch (param) {
    case CL_PROGRAM_REFERENCE_COUNT:
       buf.as_scalar<cl_uint>() = prog.ref_count();
@@ -451,6 +466,13 @@ clGetProgramBuildInfo(cl_program d_prog, cl_device_id d_dev,
    if (!count(dev, prog.context().devices()))
       return CL_INVALID_DEVICE;
 
+   if (param == CL_PROGRAM_BUILD_STATUS && prog.building()) {
+      buf.as_scalar<cl_build_status>() = CL_BUILD_IN_PROGRESS;
+      return CL_SUCCESS;
+   }
+
+   prog.wait();
+
    switch (param) {
    case CL_PROGRAM_BUILD_STATUS:
       buf.as_scalar<cl_build_status>() = prog.build(dev).status();
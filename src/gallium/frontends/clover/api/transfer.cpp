@@ -1017,9 +1017,14 @@ clover::EnqueueSVMMap(cl_command_queue d_q,
    validate_common(q, deps);
 
    if (can_emulate) {
+      // With system SVM the GPU accesses the allocation in place, so
+      // mapping it only needs to order it with respect to the commands
+      // it depends on.
       auto hev = create<hard_event>(q, cmd, deps,
          [](clover::event &) { });
 
+      if (blocking_map)
+         hev().wait();
       ret_object(event, hev);
       return CL_SUCCESS;
    }
@@ -24,9 +24,11 @@
 #include <unistd.h>
 #include "core/device.hpp"
 #include "core/platform.hpp"
+#include "llvm/util.hpp"
 #include "pipe/p_screen.h"
 #include "pipe/p_state.h"
 #include "util/bitscan.h"
+#include "util/disk_cache.h"
 #include "util/u_debug.h"
 
 using namespace clover;
@@ -42,17 +44,57 @@ namespace {
       pipe->get_compute_param(pipe, ir_format, cap, &v.front());
       return v;
    }
+
+   disk_cache *
+   create_compiler_cache(const device &dev) {
+      // Dumping is done by the compiler, which is skipped on cache hits.
+      if (llvm::debug::has_flag(llvm::debug::clc) ||
+          llvm::debug::has_flag(llvm::debug::llvm) ||
+          llvm::debug::has_flag(llvm::debug::native) ||
+          llvm::debug::has_flag(llvm::debug::spirv))
+         return NULL;
+
+      struct mesa_sha1 ctx;
+      unsigned char sha1[20];
+      char cache_id[20 * 2 + 1];
+
+      _mesa_sha1_init(&ctx);
+
+      if (!disk_cache_get_function_identifier(
+             reinterpret_cast<void *>(create_compiler_cache), &ctx))
+         return NULL;
+
+#ifdef MESA_LLVM_VERSION_STRING
+      _mesa_sha1_update(&ctx, MESA_LLVM_VERSION_STRING,
+                        strlen(MESA_LLVM_VERSION_STRING));
+#endif
+
+      const std::string target = dev.device_name() + '\n' + dev.ir_target();
+      _mesa_sha1_update(&ctx, target.data(), target.size());
+
+      const enum pipe_shader_ir ir = dev.ir_format();
+      _mesa_sha1_update(&ctx, &ir, sizeof(ir));
+
+      _mesa_sha1_final(&ctx, sha1);
+      disk_cache_format_hex_id(cache_id, sha1, 20 * 2);
+
+      return disk_cache_create("clover", cache_id, 0);
+   }
 }
 
 device::device(clover::platform &platform, pipe_loader_device *ldev) :
-   platform(platform), ldev(ldev) {
+   platform(platform), ldev(ldev), cache(NULL) {
    pipe = pipe_loader_create_screen(ldev);
    if (pipe && pipe->get_param(pipe, PIPE_CAP_COMPUTE)) {
-      if (supports_ir(PIPE_SHADER_IR_NATIVE))
+      if (supports_ir(PIPE_SHADER_IR_NATIVE)) {
+         cache = create_compiler_cache(*this);
          return;
+      }
 #ifdef HAVE_CLOVER_SPIRV
-      if (supports_ir(PIPE_SHADER_IR_NIR_SERIALIZED))
+      if (supports_ir(PIPE_SHADER_IR_NIR_SERIALIZED)) {
+         cache = create_compiler_cache(*this);
          return;
+      }
 #endif
    }
    if (pipe)
@@ -61,6 +103,8 @@ device::device(clover::platform &platform, pipe_loader_device *ldev) :
 }
 
 device::~device() {
+   if (cache)
+      disk_cache_destroy(cache);
    if (pipe)
       pipe->destroy(pipe);
    if (ldev)
@@ -341,3 +385,8 @@ const void *
 device::get_compiler_options(enum pipe_shader_ir ir) const {
    return pipe->get_compiler_options(pipe, ir, PIPE_SHADER_COMPUTE);
 }
+
+disk_cache *
+device::compiler_cache() const {
+   return cache;
+}
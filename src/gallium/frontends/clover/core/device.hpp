@@ -30,6 +30,8 @@
 #include "core/format.hpp"
 #include "pipe-loader/pipe_loader.h"
 
+struct disk_cache;
+
 namespace clover {
    class platform;
    class root_resource;
@@ -93,6 +95,7 @@ namespace clover {
       friend std::set<cl_image_format>
       supported_formats(const context &, cl_mem_object_type);
       const void *get_compiler_options(enum pipe_shader_ir ir) const;
+      disk_cache *compiler_cache() const;
 
       clover::platform &platform;
 
@@ -104,6 +107,7 @@ namespace clover {
    private:
       pipe_screen *pipe;
       pipe_loader_device *ldev;
+      disk_cache *cache;
    };
 }
 
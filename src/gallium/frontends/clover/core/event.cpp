@@ -126,13 +126,15 @@ event::wait() const {
 
 hard_event::hard_event(command_queue &q, cl_command_type command,
                        const ref_vector<event> &deps, action action) :
-   event(q.context(), deps, profile(q, action), [](event &ev){}),
+   event(q.context(), deps, serialize(q, profile(q, action)),
+         [](event &ev){}),
    _queue(q), _command(command), _fence(NULL) {
    if (q.profiling_enabled())
       _time_queued = timestamp::current(q);
 
    q.sequence(*this);
    trigger();
+   q.flush_batch();
 }
 
 hard_event::~hard_event() {
@@ -226,6 +228,14 @@ hard_event::profile(command_queue &q, const action &action) const {
    }
 }
 
+event::action
+hard_event::serialize(command_queue &q, const action &action) const {
+   return [&q, action] (event &ev) {
+      std::lock_guard<std::mutex> lock(q.pipe_mutex);
+      action(ev);
+   };
+}
+
 soft_event::soft_event(clover::context &ctx, const ref_vector<event> &deps,
                        bool _trigger, action action) :
    event(ctx, deps, action, action) {
@@ -20,9 +20,13 @@
 // OTHER DEALINGS IN THE SOFTWARE.
 //
 
+#include <iostream>
+#include <sstream>
+
 #include "core/kernel.hpp"
 #include "core/resource.hpp"
 #include "util/factor.hpp"
+#include "util/u_debug.h"
 #include "util/u_math.h"
 #include "pipe/p_context.h"
 
@@ -46,6 +50,95 @@ pad_vector(command_queue &q, const V &v, uint x) {
    return w;
 }
 
+namespace {
+   ///
+   /// Per-launch statistics printed when CLOVER_KERNEL_STATS is set.
+   /// Collecting them waits for every launch to complete, so they're
+   /// only meant for tuning work-group sizes.
+   ///
+   class launch_stats {
+   public:
+      launch_stats(pipe_context *pipe) : pipe(pipe), elapsed(NULL),
+                                         invocations(NULL) {
+         if (!enabled())
+            return;
+
+         elapsed = pipe->create_query(pipe, PIPE_QUERY_TIME_ELAPSED, 0);
+         invocations = pipe->create_query(
+            pipe, PIPE_QUERY_PIPELINE_STATISTICS_SINGLE,
+            PIPE_STAT_QUERY_CS_INVOCATIONS);
+
+         for (auto query : { elapsed, invocations }) {
+            if (query)
+               pipe->begin_query(pipe, query);
+         }
+      }
+
+      ~launch_stats() {
+         for (auto query : { elapsed, invocations }) {
+            if (query)
+               pipe->destroy_query(pipe, query);
+         }
+      }
+
+      launch_stats(const launch_stats &) = delete;
+      launch_stats &
+      operator=(const launch_stats &) = delete;
+
+      void
+      report(const std::string &name, const std::vector<size_t> &grid_size,
+             const std::vector<size_t> &block_size, size_t mem_local,
+             size_t mem_private) {
+         if (!enabled())
+            return;
+
+         for (auto query : { elapsed, invocations }) {
+            if (query)
+               pipe->end_query(pipe, query);
+         }
+
+         std::ostringstream s;
+         s << "clover: kernel " << name << ": global";
+         for (auto x : grid_size)
+            s << " " << x;
+         s << ", local";
+         for (auto x : block_size)
+            s << " " << x;
+         s << ", " << mem_local << " B local memory, "
+           << mem_private << " B private memory";
+
+         if (invocations)
+            s << ", " << result(invocations) << " invocations";
+         if (elapsed)
+            s << ", " << result(elapsed) << " ns";
+
+         std::cerr << s.str() << std::endl;
+      }
+
+   private:
+      static bool
+      enabled() {
+         static const bool stats =
+            debug_get_bool_option("CLOVER_KERNEL_STATS", false);
+         return stats;
+      }
+
+      uint64_t
+      result(pipe_query *query) {
+         pipe_query_result result;
+
+         if (!pipe->get_query_result(pipe, query, true, &result))
+            return 0;
+
+         return result.u64;
+      }
+
+      pipe_context *pipe;
+      pipe_query *elapsed;
+      pipe_query *invocations;
+   };
+}
+
 void
 kernel::launch(command_queue &q,
                const std::vector<size_t> &grid_offset,
@@ -56,6 +149,7 @@ kernel::launch(command_queue &q,
       map(divides(), grid_size, block_size);
    void *st = exec.bind(&q, grid_offset);
    struct pipe_grid_info info = {};
+   launch_stats stats(q.pipe);
 
    // The handles are created during exec_context::bind(), so we need make
    // sure to call exec_context::bind() before retrieving them.
@@ -84,6 +178,8 @@ kernel::launch(command_queue &q,
 
    q.pipe->launch_grid(q.pipe, &info);
 
+   stats.report(_name, grid_size, block_size, exec.mem_local, mem_private());
+
    q.pipe->set_global_binding(q.pipe, 0, exec.g_buffers.size(), NULL, NULL);
    q.pipe->set_compute_resources(q.pipe, 0, exec.resources.size(), NULL);
    q.pipe->set_sampler_views(q.pipe, PIPE_SHADER_COMPUTE, 0,
@@ -120,9 +216,19 @@ kernel::name() const {
 std::vector<size_t>
 kernel::optimal_block_size(const command_queue &q,
                            const std::vector<size_t> &grid_size) const {
+   const auto &dev = q.device();
+   const size_t threads = fold(multiplies(), size_t(1), grid_size);
+   size_t limit = dev.max_threads_per_block();
+
+   // Don't pick blocks so large that some of the compute units would be
+   // left idle, as long as they still fill at least one subgroup.
+   if (dev.max_compute_units() && dev.subgroup_size()) {
+      const size_t spread = threads / dev.max_compute_units();
+      limit = std::min(limit, std::max<size_t>(spread, dev.subgroup_size()));
+   }
+
    return factor::find_grid_optimal_factor<size_t>(
-      q.device().max_threads_per_block(), q.device().max_block_size(),
-      grid_size);
+      limit, dev.max_block_size(), grid_size);
 }
 
 std::vector<size_t>
@@ -150,6 +256,9 @@ kernel::exec_context::exec_context(kernel &kern) :
 }
 
 kernel::exec_context::~exec_context() {
+   if (q)
+      release();
+
    if (st)
       q->pipe->delete_compute_state(q->pipe, st);
 }
@@ -157,6 +266,11 @@ kernel::exec_context::~exec_context() {
 void *
 kernel::exec_context::bind(intrusive_ptr<command_queue> _q,
                            const std::vector<size_t> &grid_offset) {
+   // The pipe objects cached by the arguments belong to the context of
+   // the queue they were last bound to.
+   if (q && q != _q)
+      release();
+
    std::swap(q, _q);
 
    // Bind kernel arguments.
@@ -243,9 +357,6 @@ kernel::exec_context::bind(intrusive_ptr<command_queue> _q,
 
 void
 kernel::exec_context::unbind() {
-   for (auto &arg : kern.args())
-      arg.unbind(*this);
-
    input.clear();
    samplers.clear();
    sviews.clear();
@@ -255,6 +366,12 @@ kernel::exec_context::unbind() {
    mem_local = 0;
 }
 
+void
+kernel::exec_context::release() {
+   for (auto &arg : kern.args())
+      arg.unbind(*this);
+}
+
 namespace {
    template<typename T>
    std::vector<uint8_t>
@@ -361,7 +478,7 @@ kernel::argument::create(const module::argument &marg) {
    throw error(CL_INVALID_KERNEL_DEFINITION);
 }
 
-kernel::argument::argument() : _set(false) {
+kernel::argument::argument() : _set(false), _dirty(true) {
 }
 
 bool
@@ -387,6 +504,7 @@ kernel::scalar_argument::set(size_t size, const void *value) {
 
    v = { (uint8_t *)value, (uint8_t *)value + size };
    _set = true;
+   _dirty = true;
 }
 
 void
@@ -412,6 +530,7 @@ kernel::global_argument::set(size_t size, const void *value) {
    buf = pobj<buffer>(value ? *(cl_mem *)value : NULL);
    svm = nullptr;
    _set = true;
+   _dirty = true;
 }
 
 void
@@ -419,6 +538,7 @@ kernel::global_argument::set_svm(const void *value) {
    svm = value;
    buf = nullptr;
    _set = true;
+   _dirty = true;
 }
 
 void
@@ -468,6 +588,7 @@ kernel::local_argument::set(size_t size, const void *value) {
 
    _storage = size;
    _set = true;
+   _dirty = true;
 }
 
 void
@@ -494,6 +615,7 @@ kernel::constant_argument::set(size_t size, const void *value) {
 
    buf = pobj<buffer>(value ? *(cl_mem *)value : NULL);
    _set = true;
+   _dirty = true;
 }
 
 void
@@ -509,18 +631,29 @@ kernel::constant_argument::bind(exec_context &ctx,
       byteswap(v, ctx.q->device().endianness());
       insert(ctx.input, v);
 
-      st = r.bind_surface(*ctx.q, false);
+      if (_dirty)
+         unbind(ctx);
+
+      if (!st)
+         st = r.bind_surface(*ctx.q, false);
+
       ctx.resources.push_back(st);
    } else {
       // Null pointer.
       allocate(ctx.input, marg.target_size);
    }
+
+   _dirty = false;
 }
 
 void
 kernel::constant_argument::unbind(exec_context &ctx) {
-   if (buf)
-      buf->resource(*ctx.q).unbind_surface(*ctx.q, st);
+   // The surface may outlive the buffer it was created for, don't touch
+   // the buffer here.
+   if (st) {
+      ctx.q->pipe->surface_destroy(ctx.q->pipe, st);
+      st = nullptr;
+   }
 }
 
 void
@@ -533,6 +666,7 @@ kernel::image_rd_argument::set(size_t size, const void *value) {
 
    img = &obj<image>(*(cl_mem *)value);
    _set = true;
+   _dirty = true;
 }
 
 void
@@ -545,13 +679,24 @@ kernel::image_rd_argument::bind(exec_context &ctx,
    align(ctx.input, marg.target_align);
    insert(ctx.input, v);
 
-   st = img->resource(*ctx.q).bind_sampler_view(*ctx.q);
+   if (_dirty)
+      unbind(ctx);
+
+   if (!st)
+      st = img->resource(*ctx.q).bind_sampler_view(*ctx.q);
+
    ctx.sviews.push_back(st);
+   _dirty = false;
 }
 
 void
 kernel::image_rd_argument::unbind(exec_context &ctx) {
-   img->resource(*ctx.q).unbind_sampler_view(*ctx.q, st);
+   // The sampler view may outlive the image it was created for, don't
+   // touch the image here.
+   if (st) {
+      ctx.q->pipe->sampler_view_destroy(ctx.q->pipe, st);
+      st = nullptr;
+   }
 }
 
 void
@@ -564,6 +709,7 @@ kernel::image_wr_argument::set(size_t size, const void *value) {
 
    img = &obj<image>(*(cl_mem *)value);
    _set = true;
+   _dirty = true;
 }
 
 void
@@ -576,13 +722,24 @@ kernel::image_wr_argument::bind(exec_context &ctx,
    align(ctx.input, marg.target_align);
    insert(ctx.input, v);
 
-   st = img->resource(*ctx.q).bind_surface(*ctx.q, true);
+   if (_dirty)
+      unbind(ctx);
+
+   if (!st)
+      st = img->resource(*ctx.q).bind_surface(*ctx.q, true);
+
    ctx.resources.push_back(st);
+   _dirty = false;
 }
 
 void
 kernel::image_wr_argument::unbind(exec_context &ctx) {
-   img->resource(*ctx.q).unbind_surface(*ctx.q, st);
+   // The surface may outlive the image it was created for, don't touch
+   // the image here.
+   if (st) {
+      ctx.q->pipe->surface_destroy(ctx.q->pipe, st);
+      st = nullptr;
+   }
 }
 
 void
@@ -595,16 +752,28 @@ kernel::sampler_argument::set(size_t size, const void *value) {
 
    s = &obj(*(cl_sampler *)value);
    _set = true;
+   _dirty = true;
 }
 
 void
 kernel::sampler_argument::bind(exec_context &ctx,
                                const module::argument &marg) {
-   st = s->bind(*ctx.q);
+   if (_dirty)
+      unbind(ctx);
+
+   if (!st)
+      st = s->bind(*ctx.q);
+
    ctx.samplers.push_back(st);
+   _dirty = false;
 }
 
 void
 kernel::sampler_argument::unbind(exec_context &ctx) {
-   s->unbind(*ctx.q, st);
+   // The sampler state may outlive the sampler it was created for, don't
+   // touch the sampler here.
+   if (st) {
+      ctx.q->pipe->delete_sampler_state(ctx.q->pipe, st);
+      st = nullptr;
+   }
 }
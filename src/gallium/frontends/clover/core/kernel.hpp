@@ -50,6 +50,9 @@ namespace clover {
                     const std::vector<size_t> &grid_offset);
          void unbind();
 
+         /// Release the pipe objects the arguments keep across launches.
+         void release();
+
          kernel &kern;
          intrusive_ptr<command_queue> q;
 
@@ -103,6 +106,9 @@ namespace clover {
          argument();
 
          bool _set;
+
+         /// \a true if the argument has changed since the last bind().
+         bool _dirty;
       };
 
    private:
@@ -195,7 +201,7 @@ namespace clover {
 
       private:
          buffer *buf;
-         pipe_surface *st;
+         pipe_surface *st = nullptr;
       };
 
       class image_argument : public argument {
@@ -215,7 +221,7 @@ namespace clover {
          virtual void unbind(exec_context &ctx);
 
       private:
-         pipe_sampler_view *st;
+         pipe_sampler_view *st = nullptr;
       };
 
       class image_wr_argument : public image_argument {
@@ -226,7 +232,7 @@ namespace clover {
          virtual void unbind(exec_context &ctx);
 
       private:
-         pipe_surface *st;
+         pipe_surface *st = nullptr;
       };
 
       class sampler_argument : public argument {
@@ -238,7 +244,7 @@ namespace clover {
 
       private:
          sampler *s;
-         void *st;
+         void *st = nullptr;
       };
 
       std::vector<std::unique_ptr<argument>> _args;
@@ -20,14 +20,177 @@
 // OTHER DEALINGS IN THE SOFTWARE.
 //
 
+#include <mutex>
+#include <sstream>
+#include <thread>
+
 #include "core/compiler.hpp"
 #include "core/program.hpp"
+#include "util/disk_cache.h"
 
 using namespace clover;
 
+namespace {
+   void
+   append_key(std::string &key, const std::string &s) {
+      const uint64_t size = s.size();
+      key.append(reinterpret_cast<const char *>(&size), sizeof(size));
+      key.append(s);
+   }
+
+   ///
+   /// Look up the result of a previous compilation in the device's
+   /// on-disk cache.  Cache entries hold the compiler log followed by
+   /// the serialized module.
+   ///
+   bool
+   find_cached_module(const device &dev, const std::string &key_data,
+                      module &m, std::string &log) {
+      disk_cache *cache = dev.compiler_cache();
+      if (!cache)
+         return false;
+
+      cache_key key;
+      disk_cache_compute_key(cache, key_data.data(), key_data.size(), key);
+
+      size_t size;
+      char *data = (char *)disk_cache_get(cache, key, &size);
+      if (!data)
+         return false;
+
+      std::stringbuf bin({ data, size });
+      free(data);
+
+      try {
+         std::istream s(&bin);
+         s.exceptions(std::ios::failbit | std::ios::badbit);
+
+         uint64_t log_size;
+         s.read(reinterpret_cast<char *>(&log_size), sizeof(log_size));
+         std::string cached_log(log_size, '\0');
+         s.read(&cached_log[0], log_size);
+
+         m = module::deserialize(s);
+         log += cached_log;
+         return true;
+
+      } catch (std::istream::failure &e) {
+         return false;
+      }
+   }
+
+   void
+   store_cached_module(const device &dev, const std::string &key_data,
+                       const module &m, const std::string &log) {
+      disk_cache *cache = dev.compiler_cache();
+      if (!cache)
+         return;
+
+      cache_key key;
+      disk_cache_compute_key(cache, key_data.data(), key_data.size(), key);
+
+      std::stringbuf bin;
+      std::ostream s(&bin);
+      const uint64_t log_size = log.size();
+      s.write(reinterpret_cast<const char *>(&log_size), sizeof(log_size));
+      s.write(log.data(), log.size());
+      m.serialize(s);
+
+      const std::string data = bin.str();
+      disk_cache_put(cache, key, data.data(), data.size(), NULL);
+   }
+
+   module
+   cached_compile_program(const std::string &source,
+                          const header_map &headers, const device &dev,
+                          const std::string &opts, std::string &log) {
+      std::string key = "compile";
+      append_key(key, source);
+      for (const auto &header : headers) {
+         append_key(key, header.first);
+         append_key(key, header.second);
+      }
+      append_key(key, opts);
+
+      module m;
+      if (find_cached_module(dev, key, m, log))
+         return m;
+
+      const size_t log_start = log.size();
+      m = compiler::compile_program(source, headers, dev, opts, log);
+      store_cached_module(dev, key, m, log.substr(log_start));
+      return m;
+   }
+
+   module
+   cached_link_program(const std::vector<module> &ms, const device &dev,
+                       const std::string &opts, std::string &log) {
+      std::string key = "link";
+      for (const auto &m : ms) {
+         std::stringbuf bin;
+         std::ostream s(&bin);
+         m.serialize(s);
+         append_key(key, bin.str());
+      }
+      append_key(key, opts);
+
+      module m;
+      if (find_cached_module(dev, key, m, log))
+         return m;
+
+      const size_t log_start = log.size();
+      m = compiler::link_program(ms, dev, opts, log);
+      store_cached_module(dev, key, m, log.substr(log_start));
+      return m;
+   }
+
+   ///
+   /// Queue shared by all asynchronous program builds of the process.
+   /// Returns NULL if the worker threads couldn't be started.
+   ///
+   util_queue *
+   build_queue() {
+      static util_queue queue;
+      static bool valid;
+      static std::once_flag flag;
+
+      std::call_once(flag, [] {
+         valid = util_queue_init(&queue, "clbuild", 32,
+                                 std::max(std::thread::hardware_concurrency(),
+                                          1u),
+                                 UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+                                 UTIL_QUEUE_INIT_SHARED_CPU_LIMIT);
+      });
+
+      return valid ? &queue : NULL;
+   }
+
+   struct build_job {
+      intrusive_ref<program> prog;
+      std::function<void ()> build;
+      std::function<void ()> notify;
+   };
+
+   void
+   execute_build_job(void *job, int thread_index) {
+      static_cast<build_job *>(job)->build();
+   }
+
+   void
+   cleanup_build_job(void *job, int thread_index) {
+      auto j = static_cast<build_job *>(job);
+
+      // This runs after the build fence has been signalled, so the
+      // callback is free to query the program.
+      j->notify();
+      delete j;
+   }
+}
+
 program::program(clover::context &ctx, const std::string &source) :
    has_source(true), context(ctx), _devices(ctx.devices()), _source(source),
    _kernel_ref_counter(0) {
+   util_queue_fence_init(&_build_fence);
 }
 
 program::program(clover::context &ctx,
@@ -35,12 +198,18 @@ program::program(clover::context &ctx,
                  const std::vector<module> &binaries) :
    has_source(false), context(ctx),
    _devices(devs), _kernel_ref_counter(0) {
+   util_queue_fence_init(&_build_fence);
+
    for_each([&](device &dev, const module &bin) {
          _builds[&dev] = { bin };
       },
       devs, binaries);
 }
 
+program::~program() {
+   util_queue_fence_destroy(&_build_fence);
+}
+
 void
 program::compile(const ref_vector<device> &devs, const std::string &opts,
                  const header_map &headers) {
@@ -52,7 +221,7 @@ program::compile(const ref_vector<device> &devs, const std::string &opts,
 
          try {
             const module m =
-               compiler::compile_program(_source, headers, dev, opts, log);
+               cached_compile_program(_source, headers, dev, opts, log);
             _builds[&dev] = { m, opts, log };
          } catch (...) {
             _builds[&dev] = { module(), opts, log };
@@ -74,7 +243,7 @@ program::link(const ref_vector<device> &devs, const std::string &opts,
       std::string log = _builds[&dev].log;
 
       try {
-         const module m = compiler::link_program(ms, dev, opts, log);
+         const module m = cached_link_program(ms, dev, opts, log);
          _builds[&dev] = { m, opts, log };
       } catch (...) {
          _builds[&dev] = { module(), opts, log };
@@ -83,6 +252,38 @@ program::link(const ref_vector<device> &devs, const std::string &opts,
    }
 }
 
+void
+program::build_async(const ref_vector<device> &devs, const std::string &opts,
+                     std::function<void ()> notify) {
+   auto build = [=]() {
+      try {
+         compile(devs, opts);
+         link(devs, opts, { *this });
+      } catch (error &e) {
+         // The failure is recorded in the build log.
+      }
+   };
+
+   if (util_queue *queue = build_queue()) {
+      util_queue_add_job(queue, new build_job { *this, build, notify },
+                         &_build_fence, execute_build_job, cleanup_build_job,
+                         0);
+   } else {
+      build();
+      notify();
+   }
+}
+
+void
+program::wait() const {
+   util_queue_fence_wait(&_build_fence);
+}
+
+bool
+program::building() const {
+   return !util_queue_fence_is_signalled(&_build_fence);
+}
+
 const std::string &
 program::source() const {
    return _source;
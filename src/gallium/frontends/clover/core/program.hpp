@@ -23,11 +23,13 @@
 #ifndef CLOVER_CORE_PROGRAM_HPP
 #define CLOVER_CORE_PROGRAM_HPP
 
+#include <functional>
 #include <map>
 
 #include "core/object.hpp"
 #include "core/context.hpp"
 #include "core/module.hpp"
+#include "util/u_queue.h"
 
 namespace clover {
    typedef std::vector<std::pair<std::string, std::string>> header_map;
@@ -43,6 +45,7 @@ namespace clover {
       program(clover::context &ctx,
               const ref_vector<device> &devs = {},
               const std::vector<module> &binaries = {});
+      ~program();
 
       program(const program &prog) = delete;
       program &
@@ -53,6 +56,19 @@ namespace clover {
       void link(const ref_vector<device> &devs, const std::string &opts,
                 const ref_vector<program> &progs);
 
+      /// Compile and link the program for \a devs on a worker thread,
+      /// then call \a notify.  Build errors are only reported through
+      /// the build log and status.
+      void build_async(const ref_vector<device> &devs,
+                       const std::string &opts,
+                       std::function<void ()> notify);
+
+      /// Wait for any build started by build_async() to complete.
+      void wait() const;
+
+      /// \a true while a build started by build_async() is running.
+      bool building() const;
+
       const bool has_source;
       const std::string &source() const;
 
@@ -85,6 +101,7 @@ namespace clover {
       std::map<const device *, struct build> _builds;
       std::string _source;
       ref_counter _kernel_ref_counter;
+      mutable util_queue_fence _build_fence;
    };
 }
 
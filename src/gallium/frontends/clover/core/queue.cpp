@@ -25,6 +25,8 @@
 #include "pipe/p_screen.h"
 #include "pipe/p_context.h"
 #include "pipe/p_state.h"
+#include "util/os_time.h"
+#include "util/u_debug.h"
 
 using namespace clover;
 
@@ -44,7 +46,10 @@ namespace {
 
 command_queue::command_queue(clover::context &ctx, clover::device &dev,
                              cl_command_queue_properties props) :
-   context(ctx), device(dev), props(props) {
+   context(ctx), device(dev), props(props),
+   batch_size(debug_get_num_option("CLOVER_FLUSH_BATCH_SIZE", 0)),
+   batch_time(debug_get_num_option("CLOVER_FLUSH_BATCH_TIME", 0) * 1000),
+   last_flush(os_time_get_nano()) {
    pipe = dev.pipe->context_create(dev.pipe, NULL, PIPE_CONTEXT_COMPUTE_ONLY);
    if (!pipe)
       throw error(CL_INVALID_DEVICE);
@@ -65,23 +70,49 @@ command_queue::~command_queue() {
 
 void
 command_queue::flush() {
+   std::lock_guard<std::mutex> lock(queued_events_mutex);
+   flush_unlocked();
+}
+
+void
+command_queue::flush_unlocked() {
    pipe_screen *screen = device().pipe;
    pipe_fence_handle *fence = NULL;
 
-   std::lock_guard<std::mutex> lock(queued_events_mutex);
-   if (!queued_events.empty()) {
+   // Don't bother flushing and creating a fence unless something has
+   // been submitted to the pipe context since the last flush.
+   if (any_of([](hard_event &ev) { return ev.signalled(); },
+              queued_events)) {
+      std::unique_lock<std::mutex> pipe_lock(pipe_mutex);
       pipe->flush(pipe, &fence, 0);
+      pipe_lock.unlock();
 
-      while (!queued_events.empty() &&
-             queued_events.front()().signalled()) {
-         queued_events.front()().fence(fence);
-         queued_events.pop_front();
+      // Everything signalled so far has been submitted to the pipe
+      // context.  On an in-order queue those are the events at the
+      // front, otherwise they may be anywhere in the list.
+      for (auto it = queued_events.begin(); it != queued_events.end();) {
+         if ((*it)().signalled()) {
+            (*it)().fence(fence);
+            it = queued_events.erase(it);
+         } else {
+            ++it;
+         }
       }
 
       screen->fence_reference(screen, &fence, NULL);
+      last_flush = os_time_get_nano();
    }
 }
 
+void
+command_queue::flush_batch() {
+   std::lock_guard<std::mutex> lock(queued_events_mutex);
+
+   if ((batch_size && queued_events.size() >= batch_size) ||
+       (batch_time && os_time_get_nano() - last_flush >= batch_time))
+      flush_unlocked();
+}
+
 cl_command_queue_properties
 command_queue::properties() const {
    return props;
@@ -92,11 +123,38 @@ command_queue::profiling_enabled() const {
    return props & CL_QUEUE_PROFILING_ENABLE;
 }
 
+bool
+command_queue::out_of_order() const {
+   return props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+}
+
 void
 command_queue::sequence(hard_event &ev) {
    std::lock_guard<std::mutex> lock(queued_events_mutex);
-   if (!queued_events.empty())
-      queued_events.back()().chain(ev);
+
+   if (!out_of_order()) {
+      if (!queued_events.empty())
+         queued_events.back()().chain(ev);
+
+   } else if (ev.deps.empty() &&
+              (ev.command() == CL_COMMAND_MARKER ||
+               ev.command() == CL_COMMAND_BARRIER || !ev.command())) {
+      // Markers and barriers with an empty wait list, as well as the
+      // event clFinish() waits on, depend on every previous command.
+      for (hard_event &qev : queued_events)
+         qev.chain(ev);
+
+   } else {
+      // Other commands only need to wait for their explicit
+      // dependencies and for the most recent barrier.
+      for (auto it = queued_events.rbegin();
+           it != queued_events.rend(); ++it) {
+         if ((*it)().command() == CL_COMMAND_BARRIER) {
+            (*it)().chain(ev);
+            break;
+         }
+      }
+   }
 
    queued_events.push_back(ev);
 }
@@ -50,6 +50,7 @@ namespace clover {
 
       cl_command_queue_properties properties() const;
       bool profiling_enabled() const;
+      bool out_of_order() const;
 
       const intrusive_ref<clover::context> context;
       const intrusive_ref<clover::device> device;
@@ -65,13 +66,31 @@ namespace clover {
 
    private:
       /// Serialize a hardware event with respect to the previous ones,
-      /// and push it to the pending list.
+      /// and push it to the pending list.  On an out-of-order queue
+      /// only barriers, markers and clFinish() impose any ordering.
       void sequence(hard_event &ev);
 
+      /// Flush the queue if the commands accumulated since the last
+      /// flush exceed the limits set by CLOVER_FLUSH_BATCH_SIZE (number
+      /// of commands) or CLOVER_FLUSH_BATCH_TIME (microseconds).  Both
+      /// default to zero, i.e. only flush when the application asks for
+      /// it or blocks on a command.
+      void flush_batch();
+
+      void flush_unlocked();
+
       cl_command_queue_properties props;
       pipe_context *pipe;
+      /// Held while \a pipe is in use.  Commands of an out-of-order
+      /// queue may be executed by whichever thread signals their last
+      /// dependency.
+      std::mutex pipe_mutex;
       std::mutex queued_events_mutex;
       std::deque<intrusive_ref<hard_event>> queued_events;
+
+      const size_t batch_size;
+      const int64_t batch_time;
+      int64_t last_flush;
    };
 }
 
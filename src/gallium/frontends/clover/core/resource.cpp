@@ -20,12 +20,16 @@
 // OTHER DEALINGS IN THE SOFTWARE.
 //
 
+#include <cstring>
+
 #include "core/resource.hpp"
 #include "core/memory.hpp"
 #include "pipe/p_screen.h"
 #include "util/u_sampler.h"
 #include "util/format/u_format.h"
 #include "util/u_inlines.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
 
 using namespace clover;
 
@@ -125,7 +129,7 @@ resource::unbind_surface(command_queue &q, pipe_surface *st) {
 
 root_resource::root_resource(clover::device &dev, memory_obj &obj,
                              command_queue &q, const std::string &data) :
-   resource(dev, obj) {
+   resource(dev, obj), host_storage(NULL) {
    pipe_resource info {};
 
    if (image *img = dynamic_cast<image *>(&obj)) {
@@ -153,6 +157,28 @@ root_resource::root_resource(clover::device &dev, memory_obj &obj,
          return;
    }
 
+   if (obj.flags() & CL_MEM_ALLOC_HOST_PTR && !dynamic_cast<image *>(&obj) &&
+       dev.allows_user_pointers()) {
+      // Back the buffer with host memory of our own so it can be shared
+      // with the device without any staging copies.  Allocate whole pages
+      // since that's what the kernel drivers normally require.
+      const size_t align = dev.mem_base_addr_align();
+
+      host_storage = align_malloc(util_align_npot(obj.size(), align), align);
+      if (host_storage) {
+         if (!data.empty())
+            std::memcpy(host_storage, data.data(), data.size());
+
+         pipe = dev.pipe->resource_from_user_memory(dev.pipe, &info,
+                                                    host_storage);
+         if (pipe)
+            return;
+
+         align_free(host_storage);
+         host_storage = NULL;
+      }
+   }
+
    if (obj.flags() & (CL_MEM_ALLOC_HOST_PTR | CL_MEM_USE_HOST_PTR)) {
       info.usage = PIPE_USAGE_STAGING;
    }
@@ -178,12 +204,13 @@ root_resource::root_resource(clover::device &dev, memory_obj &obj,
 
 root_resource::root_resource(clover::device &dev, memory_obj &obj,
                              root_resource &r) :
-   resource(dev, obj) {
+   resource(dev, obj), host_storage(NULL) {
    assert(0); // XXX -- resource shared among dev and r.dev
 }
 
 root_resource::~root_resource() {
    pipe_resource_reference(&this->pipe, NULL);
+   align_free(host_storage);
 }
 
 sub_resource::sub_resource(resource &r, const vector &offset) :
@@ -92,6 +92,10 @@ namespace clover {
                     command_queue &q, const std::string &data);
       root_resource(clover::device &dev, memory_obj &obj, root_resource &r);
       virtual ~root_resource();
+
+   private:
+      /// Host memory backing the resource for CL_MEM_ALLOC_HOST_PTR.
+      void *host_storage;
    };
 
    ///
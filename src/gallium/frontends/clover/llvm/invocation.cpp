@@ -59,6 +59,7 @@
 #endif
 #include "util/algorithm.hpp"
 
+#include <mutex>
 
 using namespace clover;
 using namespace clover::llvm;
@@ -99,15 +100,15 @@ namespace {
 
    void
    init_targets() {
-      static bool targets_initialized = false;
-      if (!targets_initialized) {
+      // Programs may be built concurrently from the build worker threads.
+      static std::once_flag targets_initialized;
+      std::call_once(targets_initialized, [] {
          LLVMInitializeAllTargets();
          LLVMInitializeAllTargetInfos();
          LLVMInitializeAllTargetMCs();
          LLVMInitializeAllAsmParsers();
          LLVMInitializeAllAsmPrinters();
-         targets_initialized = true;
-      }
+      });
    }
 
    void
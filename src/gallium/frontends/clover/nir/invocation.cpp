@@ -33,6 +33,7 @@
 #include <compiler/glsl_types.h>
 #include <compiler/nir/nir_serialize.h>
 #include <compiler/spirv/nir_spirv.h>
+#include <util/disk_cache.h>
 #include <util/u_math.h>
 
 using namespace clover;
@@ -58,6 +59,88 @@ dev_get_nir_compiler_options(const device &dev)
    return static_cast<const nir_shader_compiler_options*>(co);
 }
 
+static void
+spirv_cache_key(const device &dev, const std::string &name,
+                const uint32_t *data, size_t num_words, cache_key key)
+{
+   std::string key_data = "spirv_to_nir";
+   key_data.append(name.c_str(), name.size() + 1);
+   key_data.append(reinterpret_cast<const char *>(data),
+                   num_words * sizeof(*data));
+   disk_cache_compute_key(dev.compiler_cache(), key_data.data(),
+                          key_data.size(), key);
+}
+
+static nir_shader *
+translate(const uint32_t *data, size_t num_words, const std::string &name,
+          const spirv_to_nir_options &spirv_options,
+          const nir_shader_compiler_options *compiler_options,
+          std::string &r_log)
+{
+   nir_shader *nir = spirv_to_nir(data, num_words, nullptr, 0,
+                                  MESA_SHADER_KERNEL, name.c_str(),
+                                  &spirv_options, compiler_options);
+   if (!nir) {
+      r_log += "Translation from SPIR-V to NIR for kernel \"" + name +
+               "\" failed.\n";
+      throw build_error();
+   }
+
+   nir->info.cs.local_size_variable = true;
+   nir_validate_shader(nir, "clover");
+
+   // Calculate input offsets.
+   unsigned offset = 0;
+   nir_foreach_shader_in_variable_safe(var, nir) {
+      offset = align(offset, glsl_get_cl_alignment(var->type));
+      var->data.driver_location = offset;
+      offset += glsl_get_cl_size(var->type);
+   }
+
+   // Inline all functions first.
+   // according to the comment on nir_inline_functions
+   NIR_PASS_V(nir, nir_lower_variable_initializers, nir_var_function_temp);
+   NIR_PASS_V(nir, nir_lower_returns);
+   NIR_PASS_V(nir, nir_inline_functions);
+   NIR_PASS_V(nir, nir_copy_prop);
+   NIR_PASS_V(nir, nir_opt_deref);
+
+   // Pick off the single entrypoint that we want.
+   foreach_list_typed_safe(nir_function, func, node, &nir->functions) {
+      if (!func->is_entrypoint)
+         exec_node_remove(&func->node);
+   }
+   assert(exec_list_length(&nir->functions) == 1);
+
+   nir_validate_shader(nir, "clover after function inlining");
+
+   NIR_PASS_V(nir, nir_lower_variable_initializers,
+              static_cast<nir_variable_mode>(~nir_var_function_temp));
+
+   // copy propagate to prepare for lower_explicit_io
+   NIR_PASS_V(nir, nir_split_var_copies);
+   NIR_PASS_V(nir, nir_opt_copy_prop_vars);
+   NIR_PASS_V(nir, nir_lower_var_copies);
+   NIR_PASS_V(nir, nir_lower_vars_to_ssa);
+   NIR_PASS_V(nir, nir_opt_dce);
+
+   NIR_PASS_V(nir, nir_lower_explicit_io, nir_var_shader_in, nir_address_format_32bit_offset);
+   nir_variable_mode modes = (nir_variable_mode)(
+      nir_var_mem_global |
+      nir_var_mem_shared);
+   nir_address_format format = nir->info.cs.ptr_size == 64 ?
+      nir_address_format_64bit_global : nir_address_format_32bit_global;
+   NIR_PASS_V(nir, nir_lower_explicit_io, modes, format);
+
+   NIR_PASS_V(nir, nir_lower_system_values);
+   if (compiler_options->lower_int64_options)
+      NIR_PASS_V(nir, nir_lower_int64);
+
+   NIR_PASS_V(nir, nir_opt_dce);
+
+   return nir;
+}
+
 module clover::nir::spirv_to_nir(const module &mod, const device &dev,
                                  std::string &r_log)
 {
@@ -84,79 +167,46 @@ module clover::nir::spirv_to_nir(const module &mod, const device &dev,
          reinterpret_cast<const pipe_binary_program_header *>(section.data.data());
       const uint32_t *data = reinterpret_cast<const uint32_t *>(binary->blob);
       const size_t num_words = binary->num_bytes / 4;
-      const char *name = sym.name.c_str();
       auto *compiler_options = dev_get_nir_compiler_options(dev);
-
-      nir_shader *nir = spirv_to_nir(data, num_words, nullptr, 0,
-                                     MESA_SHADER_KERNEL, name,
-                                     &spirv_options, compiler_options);
-      if (!nir) {
-         r_log += "Translation from SPIR-V to NIR for kernel \"" + sym.name +
-                  "\" failed.\n";
-         throw build_error();
-      }
-
-      nir->info.cs.local_size_variable = true;
-      nir_validate_shader(nir, "clover");
-
-      // Calculate input offsets.
-      unsigned offset = 0;
-      nir_foreach_shader_in_variable_safe(var, nir) {
-         offset = align(offset, glsl_get_cl_alignment(var->type));
-         var->data.driver_location = offset;
-         offset += glsl_get_cl_size(var->type);
-      }
-
-      // Inline all functions first.
-      // according to the comment on nir_inline_functions
-      NIR_PASS_V(nir, nir_lower_variable_initializers, nir_var_function_temp);
-      NIR_PASS_V(nir, nir_lower_returns);
-      NIR_PASS_V(nir, nir_inline_functions);
-      NIR_PASS_V(nir, nir_copy_prop);
-      NIR_PASS_V(nir, nir_opt_deref);
-
-      // Pick off the single entrypoint that we want.
-      foreach_list_typed_safe(nir_function, func, node, &nir->functions) {
-         if (!func->is_entrypoint)
-            exec_node_remove(&func->node);
+      std::vector<char> serialized;
+
+      // Translating the whole SPIR-V module for every kernel adds up
+      // quickly for large kernel libraries, so look the result up in the
+      // device's cache first.
+      cache_key key;
+      size_t size = 0;
+      char *cached = NULL;
+
+      if (dev.compiler_cache()) {
+         spirv_cache_key(dev, sym.name, data, num_words, key);
+         cached = (char *)disk_cache_get(dev.compiler_cache(), key, &size);
       }
-      assert(exec_list_length(&nir->functions) == 1);
-
-      nir_validate_shader(nir, "clover after function inlining");
 
-      NIR_PASS_V(nir, nir_lower_variable_initializers,
-                 static_cast<nir_variable_mode>(~nir_var_function_temp));
+      if (cached) {
+         serialized.assign(cached, cached + size);
+         free(cached);
+      } else {
+         nir_shader *nir = translate(data, num_words, sym.name,
+                                     spirv_options, compiler_options, r_log);
 
-      // copy propagate to prepare for lower_explicit_io
-      NIR_PASS_V(nir, nir_split_var_copies);
-      NIR_PASS_V(nir, nir_opt_copy_prop_vars);
-      NIR_PASS_V(nir, nir_lower_var_copies);
-      NIR_PASS_V(nir, nir_lower_vars_to_ssa);
-      NIR_PASS_V(nir, nir_opt_dce);
+         struct blob blob;
+         blob_init(&blob);
+         nir_serialize(&blob, nir, false);
+         ralloc_free(nir);
 
-      NIR_PASS_V(nir, nir_lower_explicit_io, nir_var_shader_in, nir_address_format_32bit_offset);
-      nir_variable_mode modes = (nir_variable_mode)(
-         nir_var_mem_global |
-         nir_var_mem_shared);
-      nir_address_format format = nir->info.cs.ptr_size == 64 ?
-         nir_address_format_64bit_global : nir_address_format_32bit_global;
-      NIR_PASS_V(nir, nir_lower_explicit_io, modes, format);
+         serialized.assign(blob.data, blob.data + blob.size);
+         blob_finish(&blob);
 
-      NIR_PASS_V(nir, nir_lower_system_values);
-      if (compiler_options->lower_int64_options)
-         NIR_PASS_V(nir, nir_lower_int64);
-
-      NIR_PASS_V(nir, nir_opt_dce);
-
-      struct blob blob;
-      blob_init(&blob);
-      nir_serialize(&blob, nir, false);
+         if (dev.compiler_cache())
+            disk_cache_put(dev.compiler_cache(), key, serialized.data(),
+                           serialized.size(), NULL);
+      }
 
-      const pipe_binary_program_header header { uint32_t(blob.size) };
+      const pipe_binary_program_header header { uint32_t(serialized.size()) };
       module::section text { section_id, module::section::text_executable, header.num_bytes, {} };
       text.data.insert(text.data.end(), reinterpret_cast<const char *>(&header),
                        reinterpret_cast<const char *>(&header) + sizeof(header));
-      text.data.insert(text.data.end(), blob.data, blob.data + blob.size);
+      text.data.insert(text.data.end(), serialized.begin(), serialized.end());
 
       m.syms.emplace_back(sym.name, section_id, 0, sym.args);
       m.secs.push_back(text);
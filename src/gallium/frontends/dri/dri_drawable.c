@@ -37,6 +37,7 @@
 #include "util/format/u_format.h"
 #include "util/u_memory.h"
 #include "util/u_inlines.h"
+#include "util/u_cpu_trace.h"
 
 static uint32_t drifb_ID = 0;
 
@@ -479,6 +480,9 @@ dri_flush(__DRIcontext *cPriv,
       return;
    }
 
+   if (reason == __DRI2_THROTTLE_SWAPBUFFER)
+      UTIL_CPU_TRACE_FRAME();
+
    st = ctx->st;
    if (st->thread_finish)
       st->thread_finish(st);
@@ -3353,6 +3353,35 @@ NineDevice9_GetVertexShader( struct NineDevice9 *This,
     return D3D_OK;
 }
 
+/* Shrink the range of registers to the ones differing from the current
+ * values, so that only those are copied through the CSMT queue.
+ * Games often rewrite the whole constant block with few changes.
+ * Returns FALSE if no register changes. */
+static inline boolean
+nine_trim_constant_range( const float *current,
+                          const float **pConstantData,
+                          UINT *StartRegister,
+                          UINT *Vector4fCount )
+{
+    const float *data = *pConstantData;
+    const float *cur = &current[*StartRegister * 4];
+    UINT first = 0, last = *Vector4fCount;
+
+    while (first < last &&
+           !memcmp(&cur[first * 4], &data[first * 4], sizeof(float[4])))
+        first++;
+    if (first == last)
+        return FALSE;
+
+    while (!memcmp(&cur[(last - 1) * 4], &data[(last - 1) * 4], sizeof(float[4])))
+        last--;
+
+    *pConstantData = &data[first * 4];
+    *StartRegister += first;
+    *Vector4fCount = last - first;
+    return TRUE;
+}
+
 HRESULT NINE_WINAPI
 NineDevice9_SetVertexShaderConstantF( struct NineDevice9 *This,
                                       UINT StartRegister,
@@ -3386,8 +3415,8 @@ NineDevice9_SetVertexShaderConstantF( struct NineDevice9 *This,
         return D3D_OK;
     }
 
-    if (!memcmp(&vs_const_f[StartRegister * 4], pConstantData,
-                Vector4fCount * 4 * sizeof(state->vs_const_f[0])))
+    if (!nine_trim_constant_range(vs_const_f, &pConstantData,
+                                  &StartRegister, &Vector4fCount))
         return D3D_OK;
 
     memcpy(&vs_const_f[StartRegister * 4],
@@ -3800,8 +3829,8 @@ NineDevice9_SetPixelShaderConstantF( struct NineDevice9 *This,
         return D3D_OK;
     }
 
-    if (!memcmp(&state->ps_const_f[StartRegister * 4], pConstantData,
-                Vector4fCount * 4 * sizeof(state->ps_const_f[0])))
+    if (!nine_trim_constant_range(state->ps_const_f, &pConstantData,
+                                  &StartRegister, &Vector4fCount))
         return D3D_OK;
 
     memcpy(&state->ps_const_f[StartRegister * 4],
@@ -30,6 +30,8 @@
 
 #include "util/u_memory.h"
 #include "util/u_handle_table.h"
+#include "util/u_box.h"
+#include "util/u_inlines.h"
 #include "util/u_surface.h"
 #include "util/u_video.h"
 
@@ -346,6 +348,39 @@ vlVaSetImagePalette(VADriverContextP ctx, VAImageID image, unsigned char *palett
    return VA_STATUS_ERROR_UNIMPLEMENTED;
 }
 
+/* Return a staging resource matching the given plane of the surface,
+ * reusing the one from the previous call when possible.
+ */
+static struct pipe_resource *
+vlVaGetStagingResource(vlVaDriver *drv, vlVaSurface *surf, unsigned plane,
+                       struct pipe_resource *tex)
+{
+   struct pipe_screen *screen = drv->pipe->screen;
+   struct pipe_resource *staging = surf->staging[plane];
+   struct pipe_resource templ;
+
+   if (staging && staging->target == tex->target &&
+       staging->format == tex->format &&
+       staging->width0 == tex->width0 &&
+       staging->height0 == tex->height0 &&
+       staging->array_size == tex->array_size)
+      return staging;
+
+   pipe_resource_reference(&surf->staging[plane], NULL);
+
+   memset(&templ, 0, sizeof(templ));
+   templ.target = tex->target;
+   templ.format = tex->format;
+   templ.width0 = tex->width0;
+   templ.height0 = tex->height0;
+   templ.depth0 = 1;
+   templ.array_size = tex->array_size;
+   templ.usage = PIPE_USAGE_STAGING;
+
+   surf->staging[plane] = screen->resource_create(screen, &templ);
+   return surf->staging[plane];
+}
+
 VAStatus
 vlVaGetImage(VADriverContextP ctx, VASurfaceID surface, int x, int y,
              unsigned int width, unsigned int height, VAImageID image)
@@ -355,8 +390,11 @@ vlVaGetImage(VADriverContextP ctx, VASurfaceID surface, int x, int y,
    vlVaBuffer *img_buf;
    VAImage *vaimage;
    struct pipe_sampler_view **views;
+   struct pipe_resource *src[3];
+   struct pipe_box boxes[3];
    enum pipe_format format;
    bool convert = false;
+   bool use_staging;
    void *data[3];
    unsigned pitches[3], i, j;
 
@@ -448,11 +486,20 @@ vlVaGetImage(VADriverContextP ctx, VASurfaceID surface, int x, int y,
       pitches[2] = tmp_p;
    }
 
+   /* Reading tiled video memory through transfer_map is slow and stalls
+    * once per plane. Unless the GPU shares system memory, copy all planes
+    * to linear staging resources first, so that a single wait covers them
+    * and the CPU reads from cached memory.
+    */
+   use_staging = !drv->pipe->screen->get_param(drv->pipe->screen,
+                                               PIPE_CAP_UMA);
+
    for (i = 0; i < vaimage->num_planes; i++) {
       unsigned box_w = align(width, 2);
       unsigned box_h = align(height, 2);
       unsigned box_x = x & ~1;
       unsigned box_y = y & ~1;
+      src[i] = NULL;
       if (!views[i]) continue;
       vl_video_buffer_adjust_size(&box_w, &box_h, i,
                                   pipe_format_to_chroma_format(surf->templat.buffer_format),
@@ -460,11 +507,31 @@ vlVaGetImage(VADriverContextP ctx, VASurfaceID surface, int x, int y,
       vl_video_buffer_adjust_size(&box_x, &box_y, i,
                                   pipe_format_to_chroma_format(surf->templat.buffer_format),
                                   surf->templat.interlaced);
-      for (j = 0; j < views[i]->texture->array_size; ++j) {
-         struct pipe_box box = {box_x, box_y, j, box_w, box_h, 1};
+      u_box_3d(box_x, box_y, 0, box_w, box_h, views[i]->texture->array_size,
+               &boxes[i]);
+
+      src[i] = views[i]->texture;
+      if (use_staging) {
+         struct pipe_resource *staging =
+            vlVaGetStagingResource(drv, surf, i, views[i]->texture);
+         if (staging) {
+            drv->pipe->resource_copy_region(drv->pipe, staging, 0,
+                                            box_x, box_y, 0,
+                                            views[i]->texture, 0, &boxes[i]);
+            src[i] = staging;
+         }
+      }
+   }
+
+   for (i = 0; i < vaimage->num_planes; i++) {
+      if (!src[i]) continue;
+      for (j = 0; j < src[i]->array_size; ++j) {
+         struct pipe_box box = boxes[i];
          struct pipe_transfer *transfer;
          uint8_t *map;
-         map = drv->pipe->transfer_map(drv->pipe, views[i]->texture, 0,
+         box.z = j;
+         box.depth = 1;
+         map = drv->pipe->transfer_map(drv->pipe, src[i], 0,
                   PIPE_TRANSFER_READ, &box, &transfer);
          if (!map) {
             mtx_unlock(&drv->mutex);
@@ -473,12 +540,12 @@ vlVaGetImage(VADriverContextP ctx, VASurfaceID surface, int x, int y,
 
          if (i == 1 && convert) {
             u_copy_nv12_to_yv12(data, pitches, i, j,
-               transfer->stride, views[i]->texture->array_size,
+               transfer->stride, src[i]->array_size,
                map, box.width, box.height);
          } else {
             util_copy_rect(data[i] + pitches[i] * j,
-               views[i]->texture->format,
-               pitches[i] * views[i]->texture->array_size, 0, 0,
+               src[i]->format,
+               pitches[i] * src[i]->array_size, 0, 0,
                box.width, box.height, map, transfer->stride, 0, 0);
          }
          pipe_transfer_unmap(drv->pipe, transfer);
@@ -33,6 +33,7 @@
 
 #include "util/u_memory.h"
 #include "util/u_handle_table.h"
+#include "util/u_inlines.h"
 #include "util/u_rect.h"
 #include "util/u_sampler.h"
 #include "util/u_surface.h"
@@ -79,6 +80,8 @@ vlVaDestroySurfaces(VADriverContextP ctx, VASurfaceID *surface_list, int num_sur
       }
       if (surf->buffer)
          surf->buffer->destroy(surf->buffer);
+      for (unsigned j = 0; j < VL_NUM_COMPONENTS; ++j)
+         pipe_resource_reference(&surf->staging[j], NULL);
       util_dynarray_fini(&surf->subpics);
       FREE(surf);
       handle_table_remove(drv->htab, surface_list[i]);
@@ -42,6 +42,7 @@
 
 #include "vl/vl_compositor.h"
 #include "vl/vl_csc.h"
+#include "vl/vl_defines.h"
 
 #include "util/u_dynarray.h"
 #include "os/os_thread.h"
@@ -324,6 +325,8 @@ typedef struct {
    void *feedback;
    unsigned int frame_num_cnt;
    bool force_flushed;
+   /* Linear copies of the planes for vaGetImage, kept between calls. */
+   struct pipe_resource *staging[VL_NUM_COMPONENTS];
 } vlVaSurface;
 
 // Public functions:
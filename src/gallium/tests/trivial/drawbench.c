@@ -0,0 +1,381 @@
+/**************************************************************************
+ *
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/*
+ * Measures the CPU time a driver spends per draw, and per state change or
+ * bind in between draws.  Nothing is ever read back, so this is meant to be
+ * run against a drm-shim, for example:
+ *
+ *   LD_PRELOAD=$build/src/intel/tools/libintel_noop_drm_shim.so ./drawbench
+ *
+ * The optional argument is the number of draws per test.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* pipe_*_state structs */
+#include "pipe/p_state.h"
+/* pipe_context */
+#include "pipe/p_context.h"
+/* pipe_screen */
+#include "pipe/p_screen.h"
+/* PIPE_* */
+#include "pipe/p_defines.h"
+/* TGSI_SEMANTIC_{POSITION|GENERIC} */
+#include "pipe/p_shader_tokens.h"
+/* pipe_buffer_* helpers */
+#include "util/u_inlines.h"
+/* u_sampler_view_default_template */
+#include "util/u_sampler.h"
+/* FREE & CALLOC_STRUCT */
+#include "util/u_memory.h"
+/* util_make_[fragment|vertex]_passthrough_shader */
+#include "util/u_simple_shaders.h"
+/* os_time_get_nano */
+#include "util/os_time.h"
+/* to get a hardware pipe driver */
+#include "pipe-loader/pipe_loader.h"
+
+#define WIDTH 256
+#define HEIGHT 256
+
+/* Draws between flushes, roughly a frame worth of them. */
+#define DRAWS_PER_FLUSH 500
+
+struct program
+{
+	struct pipe_loader_device *dev;
+	struct pipe_screen *screen;
+	struct pipe_context *pipe;
+
+	void *blend[2];
+	void *dsa;
+	void *rasterizer;
+	void *velem;
+	void *vs;
+	void *fs[2];
+
+	struct pipe_resource *vbuf[2];
+	struct pipe_resource *target;
+	struct pipe_resource *tex[2];
+	struct pipe_surface *cbuf;
+	struct pipe_sampler_view *view[2];
+
+	unsigned num_draws;
+	double draw_ns;
+};
+
+static struct pipe_resource *create_texture(struct program *p, unsigned bind)
+{
+	struct pipe_resource tmplt;
+
+	memset(&tmplt, 0, sizeof(tmplt));
+	tmplt.target = PIPE_TEXTURE_2D;
+	tmplt.format = PIPE_FORMAT_B8G8R8A8_UNORM; /* All drivers support this */
+	tmplt.width0 = WIDTH;
+	tmplt.height0 = HEIGHT;
+	tmplt.depth0 = 1;
+	tmplt.array_size = 1;
+	tmplt.bind = bind;
+
+	return p->screen->resource_create(p->screen, &tmplt);
+}
+
+static void init_prog(struct program *p)
+{
+	struct pipe_surface surf_tmpl;
+	struct pipe_framebuffer_state framebuffer;
+	struct pipe_viewport_state viewport;
+	struct pipe_blend_state blend;
+	struct pipe_depth_stencil_alpha_state dsa;
+	struct pipe_rasterizer_state rasterizer;
+	struct pipe_vertex_element velems[2];
+	struct pipe_vertex_buffer vbuf;
+	int ret;
+
+	/* find a hardware device */
+	ret = pipe_loader_probe(&p->dev, 1);
+	assert(ret);
+
+	/* init a pipe screen */
+	p->screen = pipe_loader_create_screen(p->dev);
+	assert(p->screen);
+
+	/* create the pipe driver context */
+	p->pipe = p->screen->context_create(p->screen, NULL, 0);
+
+	/* two vertex buffers with the same triangle */
+	for (unsigned i = 0; i < 2; i++) {
+		float vertices[3][2][4] = {
+			{ { 0.0f, -0.9f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f } },
+			{ { -0.9f, 0.9f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f, 1.0f } },
+			{ { 0.9f, 0.9f, 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f, 1.0f } },
+		};
+
+		p->vbuf[i] = pipe_buffer_create(p->screen, PIPE_BIND_VERTEX_BUFFER,
+						PIPE_USAGE_DEFAULT, sizeof(vertices));
+		pipe_buffer_write(p->pipe, p->vbuf[i], 0, sizeof(vertices), vertices);
+	}
+
+	/* render target, and two textures to bind */
+	p->target = create_texture(p, PIPE_BIND_RENDER_TARGET);
+	for (unsigned i = 0; i < 2; i++) {
+		struct pipe_sampler_view view_tmpl;
+
+		p->tex[i] = create_texture(p, PIPE_BIND_SAMPLER_VIEW);
+		u_sampler_view_default_template(&view_tmpl, p->tex[i],
+						p->tex[i]->format);
+		p->view[i] = p->pipe->create_sampler_view(p->pipe, p->tex[i],
+							  &view_tmpl);
+	}
+
+	/* blending disabled or enabled */
+	for (unsigned i = 0; i < 2; i++) {
+		memset(&blend, 0, sizeof(blend));
+		blend.rt[0].colormask = PIPE_MASK_RGBA;
+		blend.rt[0].blend_enable = i;
+		blend.rt[0].rgb_func = PIPE_BLEND_ADD;
+		blend.rt[0].rgb_src_factor = PIPE_BLENDFACTOR_SRC_ALPHA;
+		blend.rt[0].rgb_dst_factor = PIPE_BLENDFACTOR_INV_SRC_ALPHA;
+		blend.rt[0].alpha_func = PIPE_BLEND_ADD;
+		blend.rt[0].alpha_src_factor = PIPE_BLENDFACTOR_ONE;
+		blend.rt[0].alpha_dst_factor = PIPE_BLENDFACTOR_ZERO;
+		p->blend[i] = p->pipe->create_blend_state(p->pipe, &blend);
+	}
+
+	/* no-op depth/stencil/alpha */
+	memset(&dsa, 0, sizeof(dsa));
+	p->dsa = p->pipe->create_depth_stencil_alpha_state(p->pipe, &dsa);
+
+	/* rasterizer */
+	memset(&rasterizer, 0, sizeof(rasterizer));
+	rasterizer.cull_face = PIPE_FACE_NONE;
+	rasterizer.half_pixel_center = 1;
+	rasterizer.bottom_edge_rule = 1;
+	rasterizer.depth_clip_near = 1;
+	rasterizer.depth_clip_far = 1;
+	p->rasterizer = p->pipe->create_rasterizer_state(p->pipe, &rasterizer);
+
+	/* vertex elements state */
+	memset(velems, 0, sizeof(velems));
+	velems[0].src_offset = 0 * 4 * sizeof(float);
+	velems[0].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+	velems[1].src_offset = 1 * 4 * sizeof(float);
+	velems[1].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+	p->velem = p->pipe->create_vertex_elements_state(p->pipe, 2, velems);
+
+	/* vertex shader */
+	{
+		const enum tgsi_semantic semantic_names[] =
+			{ TGSI_SEMANTIC_POSITION, TGSI_SEMANTIC_COLOR };
+		const uint semantic_indexes[] = { 0, 0 };
+		p->vs = util_make_vertex_passthrough_shader(p->pipe, 2, semantic_names, semantic_indexes, FALSE);
+	}
+
+	/* two fragment shaders */
+	p->fs[0] = util_make_fragment_passthrough_shader(p->pipe,
+		TGSI_SEMANTIC_COLOR, TGSI_INTERPOLATE_PERSPECTIVE, TRUE);
+	p->fs[1] = util_make_fragment_passthrough_shader(p->pipe,
+		TGSI_SEMANTIC_COLOR, TGSI_INTERPOLATE_LINEAR, TRUE);
+
+	/* bind everything once */
+	surf_tmpl.format = PIPE_FORMAT_B8G8R8A8_UNORM;
+	surf_tmpl.u.tex.level = 0;
+	surf_tmpl.u.tex.first_layer = 0;
+	surf_tmpl.u.tex.last_layer = 0;
+	p->cbuf = p->pipe->create_surface(p->pipe, p->target, &surf_tmpl);
+
+	memset(&framebuffer, 0, sizeof(framebuffer));
+	framebuffer.width = WIDTH;
+	framebuffer.height = HEIGHT;
+	framebuffer.nr_cbufs = 1;
+	framebuffer.cbufs[0] = p->cbuf;
+	p->pipe->set_framebuffer_state(p->pipe, &framebuffer);
+
+	memset(&viewport, 0, sizeof(viewport));
+	viewport.scale[0] = WIDTH / 2.0f;
+	viewport.scale[1] = HEIGHT / 2.0f;
+	viewport.scale[2] = 0.5f;
+	viewport.translate[0] = WIDTH / 2.0f;
+	viewport.translate[1] = HEIGHT / 2.0f;
+	viewport.translate[2] = 0.5f;
+	p->pipe->set_viewport_states(p->pipe, 0, 1, &viewport);
+
+	p->pipe->bind_blend_state(p->pipe, p->blend[0]);
+	p->pipe->bind_depth_stencil_alpha_state(p->pipe, p->dsa);
+	p->pipe->bind_rasterizer_state(p->pipe, p->rasterizer);
+	p->pipe->bind_vertex_elements_state(p->pipe, p->velem);
+	p->pipe->bind_vs_state(p->pipe, p->vs);
+	p->pipe->bind_fs_state(p->pipe, p->fs[0]);
+
+	memset(&vbuf, 0, sizeof(vbuf));
+	vbuf.stride = 2 * 4 * sizeof(float);
+	vbuf.buffer.resource = p->vbuf[0];
+	p->pipe->set_vertex_buffers(p->pipe, 0, 1, &vbuf);
+}
+
+static void close_prog(struct program *p)
+{
+	p->pipe->bind_fs_state(p->pipe, NULL);
+	p->pipe->bind_vs_state(p->pipe, NULL);
+	p->pipe->set_vertex_buffers(p->pipe, 0, 1, NULL);
+
+	for (unsigned i = 0; i < 2; i++) {
+		p->pipe->delete_blend_state(p->pipe, p->blend[i]);
+		p->pipe->delete_fs_state(p->pipe, p->fs[i]);
+		pipe_sampler_view_reference(&p->view[i], NULL);
+		pipe_resource_reference(&p->tex[i], NULL);
+		pipe_resource_reference(&p->vbuf[i], NULL);
+	}
+	p->pipe->delete_depth_stencil_alpha_state(p->pipe, p->dsa);
+	p->pipe->delete_rasterizer_state(p->pipe, p->rasterizer);
+	p->pipe->delete_vertex_elements_state(p->pipe, p->velem);
+	p->pipe->delete_vs_state(p->pipe, p->vs);
+
+	pipe_surface_reference(&p->cbuf, NULL);
+	pipe_resource_reference(&p->target, NULL);
+
+	p->pipe->destroy(p->pipe);
+	p->screen->destroy(p->screen);
+	pipe_loader_release(&p->dev, 1);
+
+	FREE(p);
+}
+
+enum test {
+	TEST_DRAW,
+	TEST_BLEND,
+	TEST_FS,
+	TEST_VERTEX_BUFFER,
+	TEST_CONSTANT_BUFFER,
+	TEST_SAMPLER_VIEW,
+};
+
+static const char *test_names[] = {
+	"draw",
+	"blend state change",
+	"fragment shader bind",
+	"vertex buffer bind",
+	"constant buffer upload",
+	"sampler view bind",
+};
+
+/* Runs num_draws draws, with the change a test is about before each one,
+ * and prints the time per draw.  The draws are flushed regularly like
+ * frames would be, the flushes count in the time.
+ */
+static void run_test(struct program *p, enum test test)
+{
+	struct pipe_draw_info info;
+	struct pipe_vertex_buffer vbuf;
+	struct pipe_constant_buffer cbuf;
+	float constants[16] = { 0 };
+	int64_t start;
+	double ns;
+
+	memset(&info, 0, sizeof(info));
+	info.mode = PIPE_PRIM_TRIANGLES;
+	info.count = 3;
+	info.instance_count = 1;
+
+	memset(&vbuf, 0, sizeof(vbuf));
+	vbuf.stride = 2 * 4 * sizeof(float);
+
+	memset(&cbuf, 0, sizeof(cbuf));
+	cbuf.buffer_size = sizeof(constants);
+	cbuf.user_buffer = constants;
+
+	p->pipe->flush(p->pipe, NULL, 0);
+
+	start = os_time_get_nano();
+	for (unsigned i = 0; i < p->num_draws; i++) {
+		switch (test) {
+		case TEST_DRAW:
+			break;
+		case TEST_BLEND:
+			p->pipe->bind_blend_state(p->pipe, p->blend[i & 1]);
+			break;
+		case TEST_FS:
+			p->pipe->bind_fs_state(p->pipe, p->fs[i & 1]);
+			break;
+		case TEST_VERTEX_BUFFER:
+			vbuf.buffer.resource = p->vbuf[i & 1];
+			p->pipe->set_vertex_buffers(p->pipe, 0, 1, &vbuf);
+			break;
+		case TEST_CONSTANT_BUFFER:
+			constants[0] = i;
+			p->pipe->set_constant_buffer(p->pipe, PIPE_SHADER_FRAGMENT, 0, &cbuf);
+			break;
+		case TEST_SAMPLER_VIEW:
+			p->pipe->set_sampler_views(p->pipe, PIPE_SHADER_FRAGMENT, 0, 1,
+						   &p->view[i & 1]);
+			break;
+		}
+
+		p->pipe->draw_vbo(p->pipe, &info);
+
+		if (i % DRAWS_PER_FLUSH == DRAWS_PER_FLUSH - 1)
+			p->pipe->flush(p->pipe, NULL, 0);
+	}
+	p->pipe->flush(p->pipe, NULL, 0);
+
+	ns = (double)(os_time_get_nano() - start) / p->num_draws;
+
+	if (test == TEST_DRAW) {
+		p->draw_ns = ns;
+		printf("%-24s %8.1f ns\n", test_names[test], ns);
+	} else {
+		printf("%-24s %8.1f ns per draw, %8.1f ns over a plain draw\n",
+		       test_names[test], ns, ns - p->draw_ns);
+	}
+
+	/* back to the initial state */
+	p->pipe->bind_blend_state(p->pipe, p->blend[0]);
+	p->pipe->bind_fs_state(p->pipe, p->fs[0]);
+	vbuf.buffer.resource = p->vbuf[0];
+	p->pipe->set_vertex_buffers(p->pipe, 0, 1, &vbuf);
+	p->pipe->set_constant_buffer(p->pipe, PIPE_SHADER_FRAGMENT, 0, NULL);
+	p->pipe->set_sampler_views(p->pipe, PIPE_SHADER_FRAGMENT, 0, 1, NULL);
+}
+
+int main(int argc, char** argv)
+{
+	struct program *p = CALLOC_STRUCT(program);
+
+	p->num_draws = argc > 1 ? MAX2(atoi(argv[1]), 1) : 100000;
+
+	init_prog(p);
+
+	printf("%s, %u draws per test\n",
+	       p->screen->get_name(p->screen), p->num_draws);
+	for (unsigned t = 0; t < ARRAY_SIZE(test_names); t++)
+		run_test(p, (enum test)t);
+
+	close_prog(p);
+
+	return 0;
+}
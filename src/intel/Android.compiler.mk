@@ -56,6 +56,16 @@ $(intermediates)/compiler/brw_nir_trig_workarounds.c: $(brw_nir_trig_workarounds
 	@mkdir -p $(dir $@)
 	$(hide) $(MESA_PYTHON2) $< -p $(MESA_TOP)/src/compiler/nir > $@
 
+brw_latency_tables_deps := \
+	$(LOCAL_PATH)/compiler/brw_latency_tables.py \
+	$(LOCAL_PATH)/compiler/brw_eu_defines.h
+
+$(intermediates)/compiler/brw_latency_tables.h: $(brw_latency_tables_deps)
+	@mkdir -p $(dir $@)
+	$(hide) $(MESA_PYTHON2) $< $(LOCAL_PATH)/compiler/brw_eu_defines.h > $@
+
+LOCAL_C_INCLUDES += $(intermediates)/compiler
+
 LOCAL_STATIC_LIBRARIES = libmesa_genxml
 
 LOCAL_GENERATED_SOURCES += $(addprefix $(intermediates)/, \
@@ -467,6 +467,51 @@ cfg_t::remove_block(bblock_t *block)
    this->num_blocks--;
 }
 
+/**
+ * Insert an empty block right in front of \p block and redirect to it all
+ * the edges coming into \p block from earlier blocks, so that the back-edges
+ * of a loop starting at \p block are the only edges left into it.
+ */
+bblock_t *
+cfg_t::insert_block_before(bblock_t *block)
+{
+   bblock_t *entry = new_block();
+
+   entry->start_ip = block->start_ip;
+   entry->end_ip = block->start_ip - 1;
+
+   foreach_list_typed_safe (bblock_link, predecessor, link, &block->parents) {
+      if (predecessor->block->num >= block->num)
+         continue;
+
+      foreach_list_typed (bblock_link, successor, link,
+                          &predecessor->block->children) {
+         if (successor->block == block)
+            successor->block = entry;
+      }
+
+      predecessor->link.remove();
+      entry->parents.push_tail(&predecessor->link);
+   }
+
+   entry->add_successor(mem_ctx, block, bblock_link_logical);
+   block->link.insert_before(&entry->link);
+
+   this->blocks = reralloc(mem_ctx, this->blocks, bblock_t *,
+                           this->num_blocks + 1);
+
+   for (int b = this->num_blocks; b > block->num; b--) {
+      this->blocks[b] = this->blocks[b - 1];
+      this->blocks[b]->num = b;
+   }
+
+   entry->num = block->num - 1;
+   this->blocks[entry->num] = entry;
+   this->num_blocks++;
+
+   return entry;
+}
+
 bblock_t *
 cfg_t::new_block()
 {
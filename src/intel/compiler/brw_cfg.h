@@ -307,6 +307,7 @@ struct cfg_t {
    ~cfg_t();
 
    void remove_block(bblock_t *block);
+   bblock_t *insert_block_before(bblock_t *block);
 
    bblock_t *first_block();
    const bblock_t *first_block() const;
@@ -0,0 +1,281 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * @file brw_compile_cache.c
+ *
+ * A cache of compiled programs below the drivers, see
+ * brw_compiler::compile_cache.
+ *
+ * The drivers have their own caches, but each of them hashes its own view of
+ * the shader (the GLSL source in iris, the SPIR-V and pipeline layout in
+ * anv), so the same NIR compiled with the same key by both GL and Vulkan
+ * applications is compiled twice.  This cache is keyed on what the back-end
+ * compiler actually consumes instead: the serialized NIR, the program key,
+ * the incoming prog_data and the compiler settings.
+ */
+
+#include <string.h>
+
+#include "brw_compiler.h"
+#include "brw_shader.h"
+#include "dev/gen_debug.h"
+#include "compiler/nir/nir_serialize.h"
+#include "util/bitscan.h"
+#include "util/blob.h"
+#include "util/disk_cache.h"
+
+#include "git_sha1.h"
+
+#ifdef ENABLE_SHADER_CACHE
+static void
+destroy_compile_cache(void *mem_ctx)
+{
+   struct brw_compiler *compiler = mem_ctx;
+
+   disk_cache_destroy(compiler->compile_cache);
+}
+#endif
+
+void
+brw_compile_cache_init(struct brw_compiler *compiler)
+{
+#ifdef ENABLE_SHADER_CACHE
+   if (INTEL_DEBUG & DEBUG_DISK_CACHE_DISABLE_MASK)
+      return;
+
+   /* array length = print length + nul char + 1 extra to verify it's unused */
+   char renderer[10];
+   UNUSED int len = snprintf(renderer, sizeof(renderer), "brw_%04x",
+                             compiler->devinfo->chipset_id);
+   assert(len == sizeof(renderer) - 2);
+
+   /* The build-id of the driver can't be used here: the compiler is linked
+    * into every driver separately, so it would be different for each of
+    * them and nothing would ever be shared.
+    */
+   const char *timestamp = PACKAGE_VERSION MESA_GIT_SHA1;
+
+   compiler->compile_cache =
+      disk_cache_create(renderer, timestamp,
+                        brw_get_compiler_config_value(compiler));
+   if (compiler->compile_cache)
+      ralloc_set_destructor(compiler, destroy_compile_cache);
+#endif
+}
+
+static unsigned
+num_stats(gl_shader_stage stage, const struct brw_stage_prog_data *prog_data)
+{
+   switch (stage) {
+   case MESA_SHADER_FRAGMENT: {
+      const struct brw_wm_prog_data *wm_prog_data = (const void *)prog_data;
+      return wm_prog_data->dispatch_8 + wm_prog_data->dispatch_16 +
+             wm_prog_data->dispatch_32;
+   }
+   case MESA_SHADER_COMPUTE: {
+      const struct brw_cs_prog_data *cs_prog_data = (const void *)prog_data;
+      return util_bitcount(cs_prog_data->prog_mask);
+   }
+   default:
+      return 1;
+   }
+}
+
+/**
+ * Compute the cache key of a compile.
+ *
+ * \p extra points to any other input of the stage's compile function which
+ * affects the generated code.  Returns false if the program shouldn't be
+ * cached at all.
+ */
+bool
+brw_compile_cache_compute_key(const struct brw_compiler *compiler,
+                              gl_shader_stage stage,
+                              const void *orig_key,
+                              const struct brw_stage_prog_data *orig_prog_data,
+                              const nir_shader *nir,
+                              const void *extra, size_t extra_size,
+                              cache_key hash)
+{
+   if (compiler->compile_cache == NULL)
+      return false;
+
+   /* Someone trying to look at the compiler output wants to see it. */
+   if (INTEL_DEBUG & intel_debug_flag_for_shader_stage(stage))
+      return false;
+
+   struct blob blob;
+   blob_init(&blob);
+
+   blob_write_uint32(&blob, stage);
+
+   /* The driver flags cover the settings coming from the environment, these
+    * are decided by each driver after the compiler was created.
+    */
+   blob_write_uint8(&blob, compiler->constant_buffer_0_is_relative);
+   blob_write_uint8(&blob, compiler->supports_pull_constants);
+   blob_write_uint8(&blob, compiler->supports_shader_constants);
+   blob_write_uint8(&blob, compiler->compact_params);
+   blob_write_uint8(&blob, compiler->lower_variable_group_size);
+
+   /* program_string_id is essentially random data which we don't want to
+    * include in our hashing.
+    */
+   union brw_any_prog_key key;
+   memcpy(&key, orig_key, brw_prog_key_size(stage));
+   key.base.program_string_id = 0;
+   blob_write_bytes(&blob, &key, brw_prog_key_size(stage));
+
+   /* The driver fills in the binding table and the push parameters before
+    * compiling, the pointers themselves are meaningless.
+    */
+   union brw_any_prog_data prog_data;
+   memcpy(&prog_data, orig_prog_data, brw_prog_data_size(stage));
+   prog_data.base.param = NULL;
+   prog_data.base.pull_param = NULL;
+   blob_write_bytes(&blob, &prog_data, brw_prog_data_size(stage));
+   blob_write_bytes(&blob, orig_prog_data->param,
+                    orig_prog_data->nr_params * sizeof(uint32_t));
+   blob_write_bytes(&blob, orig_prog_data->pull_param,
+                    orig_prog_data->nr_pull_params * sizeof(uint32_t));
+
+   if (extra_size)
+      blob_write_bytes(&blob, extra, extra_size);
+
+   nir_serialize(&blob, nir, false);
+
+   bool ok = !blob.out_of_memory;
+   if (ok)
+      disk_cache_compute_key(compiler->compile_cache, blob.data, blob.size,
+                             hash);
+
+   blob_finish(&blob);
+
+   return ok;
+}
+
+static uint32_t *
+copy_params(void *mem_ctx, uint32_t *old_param, const void *data,
+            unsigned nr_params)
+{
+   if (nr_params == 0)
+      return NULL;
+
+   /* Keep the array where the driver expects to find it. */
+   void *parent = old_param ? ralloc_parent(old_param) : mem_ctx;
+   uint32_t *param = reralloc(parent, old_param, uint32_t, nr_params);
+   memcpy(param, data, nr_params * sizeof(uint32_t));
+
+   return param;
+}
+
+/**
+ * Look up a previously compiled program.
+ *
+ * On a hit, prog_data and stats are filled in as the compile function would
+ * have and the assembly, allocated in mem_ctx, is returned.  Returns NULL
+ * otherwise.
+ */
+const unsigned *
+brw_compile_cache_search(const struct brw_compiler *compiler, void *mem_ctx,
+                         gl_shader_stage stage, const cache_key hash,
+                         struct brw_stage_prog_data *prog_data,
+                         struct brw_compile_stats *stats)
+{
+   size_t size;
+   void *buffer = disk_cache_get(compiler->compile_cache, hash, &size);
+   if (buffer == NULL)
+      return NULL;
+
+   const unsigned prog_data_size = brw_prog_data_size(stage);
+   union brw_any_prog_data cached;
+
+   struct blob_reader blob;
+   blob_reader_init(&blob, buffer, size);
+   blob_copy_bytes(&blob, &cached, prog_data_size);
+
+   const unsigned program_size = cached.base.program_size;
+   const void *assembly_data = blob_read_bytes(&blob, program_size);
+   const void *param_data =
+      blob_read_bytes(&blob, cached.base.nr_params * sizeof(uint32_t));
+   const void *pull_param_data =
+      blob_read_bytes(&blob, cached.base.nr_pull_params * sizeof(uint32_t));
+   const unsigned cached_num_stats = blob_read_uint32(&blob);
+   const void *stats_data =
+      blob_read_bytes(&blob, cached_num_stats * sizeof(*stats));
+
+   if (blob.overrun || blob.current != blob.end) {
+      free(buffer);
+      return NULL;
+   }
+
+   uint32_t *old_param = prog_data->param;
+   uint32_t *old_pull_param = prog_data->pull_param;
+
+   memcpy(prog_data, &cached, prog_data_size);
+   prog_data->param = copy_params(mem_ctx, old_param, param_data,
+                                  cached.base.nr_params);
+   prog_data->pull_param = copy_params(mem_ctx, old_pull_param,
+                                       pull_param_data,
+                                       cached.base.nr_pull_params);
+
+   if (stats)
+      memcpy(stats, stats_data, cached_num_stats * sizeof(*stats));
+
+   unsigned *assembly = ralloc_size(mem_ctx, program_size);
+   memcpy(assembly, assembly_data, program_size);
+
+   free(buffer);
+
+   return assembly;
+}
+
+void
+brw_compile_cache_store(const struct brw_compiler *compiler,
+                        gl_shader_stage stage, const cache_key hash,
+                        const struct brw_stage_prog_data *prog_data,
+                        const unsigned *assembly,
+                        const struct brw_compile_stats *stats)
+{
+   struct blob blob;
+   blob_init(&blob);
+
+   blob_write_bytes(&blob, prog_data, brw_prog_data_size(stage));
+   blob_write_bytes(&blob, assembly, prog_data->program_size);
+   blob_write_bytes(&blob, prog_data->param,
+                    prog_data->nr_params * sizeof(uint32_t));
+   blob_write_bytes(&blob, prog_data->pull_param,
+                    prog_data->nr_pull_params * sizeof(uint32_t));
+
+   const unsigned n = num_stats(stage, prog_data);
+   blob_write_uint32(&blob, n);
+   blob_write_bytes(&blob, stats, n * sizeof(*stats));
+
+   if (!blob.out_of_memory) {
+      disk_cache_put(compiler->compile_cache, hash, blob.data, blob.size,
+                     NULL);
+   }
+
+   blob_finish(&blob);
+}
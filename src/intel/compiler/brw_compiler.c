@@ -105,6 +105,16 @@ brw_compiler_create(void *mem_ctx, const struct gen_device_info *devinfo)
    brw_init_compaction_tables(devinfo);
 
    compiler->precise_trig = env_var_as_boolean("INTEL_PRECISE_TRIG", false);
+   /* Clamped to the 8 bits brw_get_compiler_config_value() has for it. */
+   compiler->spilling_rate =
+      MIN2(env_var_as_unsigned("INTEL_SPILLING_RATE", 0), 255);
+   compiler->hybrid_scheduling =
+      env_var_as_boolean("INTEL_HYBRID_SCHEDULING", false);
+
+   const char *recompile_stats = getenv("INTEL_RECOMPILE_STATS");
+   if (recompile_stats)
+      compiler->recompile_stats =
+         brw_recompile_stats_create(compiler, recompile_stats);
 
    compiler->use_tcs_8_patch =
       devinfo->gen >= 12 ||
@@ -207,6 +217,9 @@ brw_compiler_create(void *mem_ctx, const struct gen_device_info *devinfo)
    if (compiler->scalar_stage[MESA_SHADER_GEOMETRY])
       compiler->glsl_compiler_options[MESA_SHADER_GEOMETRY].EmitNoIndirectInput = false;
 
+   if (env_var_as_boolean("INTEL_SHARED_SHADER_CACHE", false))
+      brw_compile_cache_init(compiler);
+
    return compiler;
 }
 
@@ -221,6 +234,9 @@ brw_get_compiler_config_value(const struct brw_compiler *compiler)
 {
    uint64_t config = 0;
    insert_u64_bit(&config, compiler->precise_trig);
+   for (unsigned i = 0; i < 8; i++)
+      insert_u64_bit(&config, compiler->spilling_rate & (1u << i));
+   insert_u64_bit(&config, compiler->hybrid_scheduling);
    if (compiler->devinfo->gen >= 8 && compiler->devinfo->gen < 10) {
       insert_u64_bit(&config, compiler->scalar_stage[MESA_SHADER_VERTEX]);
       insert_u64_bit(&config, compiler->scalar_stage[MESA_SHADER_TESS_CTRL]);
@@ -35,6 +35,8 @@ extern "C" {
 #endif
 
 struct ra_regs;
+struct brw_recompile_stats;
+struct disk_cache;
 struct nir_shader;
 struct brw_program;
 
@@ -131,6 +133,38 @@ struct brw_compiler {
     * back-end compiler.
     */
    bool lower_variable_group_size;
+
+   /**
+    * If non-zero, the FS register allocator spills one more register per
+    * allocation attempt for every spilling_rate registers spilled so far,
+    * instead of spilling a single register per attempt.  This trades some
+    * extra spilling for far fewer register allocation attempts in shaders
+    * with very high register pressure.
+    */
+   unsigned spilling_rate;
+
+   /**
+    * Whether the FS backend schedules instructions before register
+    * allocation with a single heuristic that follows the critical path while
+    * register pressure is low and switches to reducing pressure as it grows,
+    * instead of trying each of the pre-RA heuristics in turn.
+    */
+   bool hybrid_scheduling;
+
+   /**
+    * Counters of the key fields causing shader recompiles, the number of
+    * variants per program and the time spent recompiling, collected when
+    * INTEL_RECOMPILE_STATS names a file to write them to when the compiler
+    * is destroyed.  NULL otherwise.
+    */
+   struct brw_recompile_stats *recompile_stats;
+
+   /**
+    * Cache of compiled programs keyed on the NIR, program key and compiler
+    * settings, shared by all the drivers using this compiler, created when
+    * INTEL_SHARED_SHADER_CACHE is set.  NULL otherwise.
+    */
+   struct disk_cache *compile_cache;
 };
 
 /**
@@ -1329,6 +1363,14 @@ struct brw_compile_stats {
    uint32_t cycles;
    uint32_t spills;
    uint32_t fills;
+   /** Estimated invocations per cycle, see brw::performance::throughput. */
+   float throughput;
+   /**
+    * Mask of the dispatch widths (8, 16 or 32) that compiled successfully
+    * but were dropped because the static cost model estimated them to be
+    * slower than the programs that were kept.
+    */
+   uint32_t rejected_simd;
 };
 
 /** @} */
@@ -1491,6 +1533,12 @@ void brw_debug_key_recompile(const struct brw_compiler *c, void *log,
                              const struct brw_base_prog_key *old_key,
                              const struct brw_base_prog_key *key);
 
+struct brw_recompile_stats *
+brw_recompile_stats_create(void *mem_ctx, const char *filename);
+
+void brw_recompile_stats_add_time(const struct brw_compiler *c,
+                                  gl_shader_stage stage, uint64_t time_ns);
+
 static inline uint32_t
 encode_slm_size(unsigned gen, uint32_t bytes)
 {
@@ -27,6 +27,123 @@
 #include <stdio.h>
 
 #include "brw_compiler.h"
+#include "util/hash_table.h"
+#include "util/simple_mtx.h"
+
+/**
+ * Recompile counters, see brw_compiler::recompile_stats.
+ */
+struct brw_recompile_stats {
+   simple_mtx_t mutex;
+
+   /** File the counters are written to when the compiler is destroyed. */
+   char *filename;
+
+   /** Stage of the recompile being recorded, only valid with mutex held. */
+   gl_shader_stage stage;
+
+   struct {
+      unsigned recompiles;
+      uint64_t compile_time_ns;
+
+      /** Map from key field name to the number of recompiles it caused. */
+      struct hash_table *fields;
+
+      /** Map from program_string_id to the number of recompiles. */
+      struct hash_table *programs;
+   } stages[MESA_SHADER_STAGES];
+};
+
+static void
+record_key_field(const struct brw_compiler *c, const char *name)
+{
+   struct brw_recompile_stats *stats = c->recompile_stats;
+
+   if (!stats)
+      return;
+
+   struct hash_table *fields = stats->stages[stats->stage].fields;
+   struct hash_entry *entry = _mesa_hash_table_search(fields, name);
+   if (entry)
+      entry->data = (void *)((uintptr_t)entry->data + 1);
+   else
+      _mesa_hash_table_insert(fields, name, (void *)(uintptr_t)1);
+}
+
+static void
+write_recompile_stats(void *mem)
+{
+   struct brw_recompile_stats *stats = mem;
+
+   FILE *f = fopen(stats->filename, "w");
+   if (f) {
+      for (unsigned s = 0; s < MESA_SHADER_STAGES; s++) {
+         if (!stats->stages[s].recompiles)
+            continue;
+
+         unsigned programs = 0, max_variants = 0;
+         hash_table_foreach(stats->stages[s].programs, entry) {
+            const unsigned variants = (uintptr_t)entry->data + 1;
+            max_variants = MAX2(max_variants, variants);
+            programs++;
+         }
+
+         fprintf(f, "%s: %u recompiles, %.3f ms, %u programs recompiled, "
+                 "up to %u variants per program\n",
+                 _mesa_shader_stage_to_abbrev(s),
+                 stats->stages[s].recompiles,
+                 stats->stages[s].compile_time_ns / 1000000.0,
+                 programs, max_variants);
+
+         hash_table_foreach(stats->stages[s].fields, entry) {
+            fprintf(f, "  %s: %u\n", (const char *)entry->key,
+                    (unsigned)(uintptr_t)entry->data);
+         }
+      }
+      fclose(f);
+   } else {
+      fprintf(stderr, "Failed to open %s for writing recompile stats\n",
+              stats->filename);
+   }
+
+   simple_mtx_destroy(&stats->mutex);
+}
+
+struct brw_recompile_stats *
+brw_recompile_stats_create(void *mem_ctx, const char *filename)
+{
+   struct brw_recompile_stats *stats =
+      rzalloc(mem_ctx, struct brw_recompile_stats);
+
+   simple_mtx_init(&stats->mutex, mtx_plain);
+   stats->filename = ralloc_strdup(stats, filename);
+
+   for (unsigned s = 0; s < MESA_SHADER_STAGES; s++) {
+      stats->stages[s].fields =
+         _mesa_hash_table_create(stats, _mesa_hash_string,
+                                 _mesa_key_string_equal);
+      stats->stages[s].programs =
+         _mesa_hash_table_create(stats, _mesa_hash_u32, _mesa_key_u32_equal);
+   }
+
+   ralloc_set_destructor(stats, write_recompile_stats);
+
+   return stats;
+}
+
+void
+brw_recompile_stats_add_time(const struct brw_compiler *c,
+                             gl_shader_stage stage, uint64_t time_ns)
+{
+   struct brw_recompile_stats *stats = c->recompile_stats;
+
+   if (!stats)
+      return;
+
+   simple_mtx_lock(&stats->mutex);
+   stats->stages[stage].compile_time_ns += time_ns;
+   simple_mtx_unlock(&stats->mutex);
+}
 
 static bool
 key_debug(const struct brw_compiler *c, void *log,
@@ -34,6 +151,7 @@ key_debug(const struct brw_compiler *c, void *log,
 {
    if (a != b) {
       c->shader_perf_log(log, "  %s %d->%d\n", name, a, b);
+      record_key_field(c, name);
       return true;
    }
    return false;
@@ -45,6 +163,7 @@ key_debug_float(const struct brw_compiler *c, void *log,
 {
    if (a != b) {
       c->shader_perf_log(log, "  %s %f->%f\n", name, a, b);
+      record_key_field(c, name);
       return true;
    }
    return false;
@@ -112,6 +231,7 @@ debug_vs_recompile(const struct brw_compiler *c, void *log,
 
    if (!found) {
       c->shader_perf_log(log, "  something else\n");
+      record_key_field(c, "something else");
    }
 }
 
@@ -130,6 +250,7 @@ debug_tcs_recompile(const struct brw_compiler *c, void *log,
 
    if (!found) {
       c->shader_perf_log(log, "  something else\n");
+      record_key_field(c, "something else");
    }
 }
 
@@ -145,6 +266,7 @@ debug_tes_recompile(const struct brw_compiler *c, void *log,
 
    if (!found) {
       c->shader_perf_log(log, "  something else\n");
+      record_key_field(c, "something else");
    }
 }
 
@@ -157,6 +279,7 @@ debug_gs_recompile(const struct brw_compiler *c, void *log,
 
    if (!found) {
       c->shader_perf_log(log, "  something else\n");
+      record_key_field(c, "something else");
    }
 }
 
@@ -191,6 +314,7 @@ debug_fs_recompile(const struct brw_compiler *c, void *log,
 
    if (!found) {
       c->shader_perf_log(log, "  something else\n");
+      record_key_field(c, "something else");
    }
 }
 
@@ -203,20 +327,16 @@ debug_cs_recompile(const struct brw_compiler *c, void *log,
 
    if (!found) {
       c->shader_perf_log(log, "  something else\n");
+      record_key_field(c, "something else");
    }
 }
 
-void
-brw_debug_key_recompile(const struct brw_compiler *c, void *log,
-                        gl_shader_stage stage,
-                        const struct brw_base_prog_key *old_key,
-                        const struct brw_base_prog_key *key)
+static void
+debug_key_recompile(const struct brw_compiler *c, void *log,
+                    gl_shader_stage stage,
+                    const struct brw_base_prog_key *old_key,
+                    const struct brw_base_prog_key *key)
 {
-   if (!old_key) {
-      c->shader_perf_log(log, "  No previous compile found...\n");
-      return;
-   }
-
    switch (stage) {
    case MESA_SHADER_VERTEX:
       debug_vs_recompile(c, log, (const struct brw_vs_prog_key *)old_key,
@@ -246,3 +366,39 @@ brw_debug_key_recompile(const struct brw_compiler *c, void *log,
       break;
    }
 }
+
+void
+brw_debug_key_recompile(const struct brw_compiler *c, void *log,
+                        gl_shader_stage stage,
+                        const struct brw_base_prog_key *old_key,
+                        const struct brw_base_prog_key *key)
+{
+   struct brw_recompile_stats *stats = c->recompile_stats;
+
+   if (stats) {
+      simple_mtx_lock(&stats->mutex);
+      stats->stage = stage;
+      stats->stages[stage].recompiles++;
+
+      struct hash_table *programs = stats->stages[stage].programs;
+      struct hash_entry *entry =
+         _mesa_hash_table_search(programs, &key->program_string_id);
+      if (entry) {
+         entry->data = (void *)((uintptr_t)entry->data + 1);
+      } else {
+         uint32_t *id = ralloc(stats, uint32_t);
+         *id = key->program_string_id;
+         _mesa_hash_table_insert(programs, id, (void *)(uintptr_t)1);
+      }
+   }
+
+   if (!old_key) {
+      c->shader_perf_log(log, "  No previous compile found...\n");
+      record_key_field(c, "no previous compile");
+   } else {
+      debug_key_recompile(c, log, stage, old_key, key);
+   }
+
+   if (stats)
+      simple_mtx_unlock(&stats->mutex);
+}
@@ -40,7 +40,9 @@
 #include "compiler/glsl_types.h"
 #include "compiler/nir/nir_builder.h"
 #include "program/prog_parameter.h"
+#include "util/u_dynarray.h"
 #include "util/u_math.h"
+#include "c11/threads.h"
 
 using namespace brw;
 
@@ -7505,6 +7507,14 @@ fs_visitor::optimize()
       OPT(opt_peephole_sel);
    }
 
+   /* The lowering passes above leave plenty of loop-invariant address
+    * calculations and payload setup behind.
+    */
+   if (OPT(opt_loop_invariant_code_motion)) {
+      OPT(opt_cse);
+      OPT(dead_code_eliminate);
+   }
+
    OPT(opt_redundant_discard_jumps);
 
    if (OPT(lower_load_payload)) {
@@ -7777,15 +7787,30 @@ fs_visitor::allocate_registers(bool allow_spilling)
       "lifo"
    };
 
+   static const enum instruction_scheduler_mode hybrid_pre_modes[] = {
+      SCHEDULE_PRE_HYBRID,
+      SCHEDULE_PRE_LIFO,
+   };
+
+   static const char *hybrid_scheduler_mode_name[] = {
+      "hybrid",
+      "lifo"
+   };
+
+   const bool hybrid = compiler->hybrid_scheduling;
+   const unsigned num_pre_modes = hybrid ? ARRAY_SIZE(hybrid_pre_modes) :
+                                           ARRAY_SIZE(pre_modes);
+
    bool spill_all = allow_spilling && (INTEL_DEBUG & DEBUG_SPILL_FS);
 
    /* Try each scheduling heuristic to see if it can successfully register
     * allocate without spilling.  They should be ordered by decreasing
     * performance but increasing likelihood of allocating.
     */
-   for (unsigned i = 0; i < ARRAY_SIZE(pre_modes); i++) {
-      schedule_instructions(pre_modes[i]);
-      this->shader_stats.scheduler_mode = scheduler_mode_name[i];
+   for (unsigned i = 0; i < num_pre_modes; i++) {
+      schedule_instructions(hybrid ? hybrid_pre_modes[i] : pre_modes[i]);
+      this->shader_stats.scheduler_mode =
+         hybrid ? hybrid_scheduler_mode_name[i] : scheduler_mode_name[i];
 
       if (0) {
          assign_regs_trivial();
@@ -7811,7 +7836,7 @@ fs_visitor::allocate_registers(bool allow_spilling)
       }
 
       bool can_spill = allow_spilling &&
-                       (i == ARRAY_SIZE(pre_modes) - 1);
+                       (i == num_pre_modes - 1);
 
       /* We should only spill registers on the last scheduling. */
       assert(!spilled_any_registers);
@@ -8582,17 +8607,88 @@ brw_register_blocks(int reg_count)
    return ALIGN(reg_count, 16) / 16 - 1;
 }
 
-const unsigned *
-brw_compile_fs(const struct brw_compiler *compiler, void *log_data,
-               void *mem_ctx,
-               const struct brw_wm_prog_key *key,
-               struct brw_wm_prog_data *prog_data,
-               nir_shader *shader,
-               int shader_time_index8, int shader_time_index16,
-               int shader_time_index32, bool allow_spilling,
-               bool use_rep_send, struct brw_vue_map *vue_map,
-               struct brw_compile_stats *stats,
-               char **error_str)
+struct brw_fs_log_msg {
+   bool debug;
+   char *str;
+};
+
+struct brw_fs_simd_job {
+   fs_visitor *v;
+   bool allow_spilling;
+   bool use_rep_send;
+   bool success;
+
+   /**
+    * Copy of the compiler given to the visitor, with log callbacks which
+    * only append to \c log.  The driver callbacks aren't thread-safe, so
+    * the messages are passed on by the calling thread once the job is done.
+    */
+   struct brw_compiler compiler;
+   struct util_dynarray log;
+};
+
+static void
+brw_fs_simd_job_vlog(void *data, bool debug, const char *fmt, va_list args)
+{
+   struct brw_fs_simd_job *job = (struct brw_fs_simd_job *) data;
+   struct brw_fs_log_msg msg;
+
+   msg.debug = debug;
+   msg.str = ralloc_vasprintf(job->log.mem_ctx, fmt, args);
+   util_dynarray_append(&job->log, struct brw_fs_log_msg, msg);
+}
+
+static void
+brw_fs_simd_job_debug_log(void *data, const char *fmt, ...)
+{
+   va_list args;
+
+   va_start(args, fmt);
+   brw_fs_simd_job_vlog(data, true, fmt, args);
+   va_end(args);
+}
+
+static void
+brw_fs_simd_job_perf_log(void *data, const char *fmt, ...)
+{
+   va_list args;
+
+   va_start(args, fmt);
+   brw_fs_simd_job_vlog(data, false, fmt, args);
+   va_end(args);
+}
+
+static void
+brw_fs_simd_job_flush_log(const struct brw_compiler *compiler, void *log_data,
+                          struct brw_fs_simd_job *job)
+{
+   util_dynarray_foreach(&job->log, struct brw_fs_log_msg, msg) {
+      if (msg->debug)
+         compiler->shader_debug_log(log_data, "%s", msg->str);
+      else
+         compiler->shader_perf_log(log_data, "%s", msg->str);
+   }
+}
+
+static int
+brw_run_fs_simd_job(void *data)
+{
+   struct brw_fs_simd_job *job = (struct brw_fs_simd_job *) data;
+   job->success = job->v->run_fs(job->allow_spilling, job->use_rep_send);
+   return 0;
+}
+
+static const unsigned *
+compile_fs(const struct brw_compiler *compiler, void *log_data,
+           void *mem_ctx,
+           const struct brw_wm_prog_key *key,
+           struct brw_wm_prog_data *prog_data,
+           nir_shader *shader,
+           int shader_time_index8, int shader_time_index16,
+           int shader_time_index32, bool allow_spilling,
+           bool use_rep_send, struct brw_vue_map *vue_map,
+           struct brw_compile_stats *stats,
+           char **error_str)
 {
    const struct gen_device_info *devinfo = compiler->devinfo;
    const unsigned max_subgroup_size = compiler->devinfo->gen >= 6 ? 32 : 16;
@@ -8626,7 +8722,8 @@ brw_compile_fs(const struct brw_compiler *compiler, void *log_data,
 
    fs_visitor *v8 = NULL, *v16 = NULL, *v32 = NULL;
    cfg_t *simd8_cfg = NULL, *simd16_cfg = NULL, *simd32_cfg = NULL;
-   float throughput = 0;
+   float throughput8 = 0, throughput16 = 0;
+   unsigned rejected_simd = 0;
    bool has_spilled = false;
 
    v8 = new fs_visitor(compiler, log_data, mem_ctx, &key->base,
@@ -8642,7 +8739,7 @@ brw_compile_fs(const struct brw_compiler *compiler, void *log_data,
       prog_data->base.dispatch_grf_start_reg = v8->payload.num_regs;
       prog_data->reg_blocks_8 = brw_register_blocks(v8->grf_used);
       const performance &perf = v8->performance_analysis.require();
-      throughput = MAX2(throughput, perf.throughput);
+      throughput8 = perf.throughput;
       has_spilled = v8->spilled_any_registers;
       allow_spilling = false;
    }
@@ -8657,9 +8754,71 @@ brw_compile_fs(const struct brw_compiler *compiler, void *log_data,
                                "using SIMD8 when dual src blending.\n");
    }
 
-   if (!has_spilled &&
-       v8->max_dispatch_width >= 16 &&
-       likely(!(INTEL_DEBUG & DEBUG_NO16) || use_rep_send)) {
+   const bool try_simd16 =
+      !has_spilled &&
+      v8->max_dispatch_width >= 16 &&
+      likely(!(INTEL_DEBUG & DEBUG_NO16) || use_rep_send);
+
+   /* Currently, the compiler only supports SIMD32 on SNB+ */
+   const bool try_simd32 =
+      !has_spilled &&
+      v8->max_dispatch_width >= 32 && !use_rep_send &&
+      devinfo->gen >= 6 &&
+      !(INTEL_DEBUG & DEBUG_NO32);
+
+   /* The SIMD16 and SIMD32 compiles only read the NIR, the key and the
+    * uniform layout of the SIMD8 compile, so run the SIMD32 compile on its
+    * own thread while the SIMD16 one runs on this one.  It gets its own
+    * ralloc context and its own copy of the prog_data, which are merged back
+    * afterwards if the SIMD32 program is used.  Whether SIMD32 is used still
+    * depends on the result of the SIMD16 compile, exactly as if they had
+    * been compiled one after the other.
+    *
+    * Its log messages are buffered in the job.  The INTEL_DEBUG dumps can't
+    * be, so when they are enabled everything stays on this thread.
+    */
+   struct brw_wm_prog_data prog_data32;
+   void *mem_ctx32 = NULL;
+   struct brw_fs_simd_job job32 = {};
+   thrd_t thread32;
+   bool threaded32 = false;
+
+   if (try_simd32) {
+      const bool concurrent32 =
+         try_simd16 && !(INTEL_DEBUG & (DEBUG_WM | DEBUG_OPTIMIZER));
+
+      prog_data32 = *prog_data;
+      mem_ctx32 = ralloc_context(NULL);
+
+      if (concurrent32) {
+         job32.compiler = *compiler;
+         job32.compiler.shader_debug_log = brw_fs_simd_job_debug_log;
+         job32.compiler.shader_perf_log = brw_fs_simd_job_perf_log;
+         util_dynarray_init(&job32.log, mem_ctx32);
+
+         v32 = new fs_visitor(&job32.compiler, &job32, mem_ctx32, &key->base,
+                              &prog_data32.base, shader, 32,
+                              shader_time_index32);
+      } else {
+         v32 = new fs_visitor(compiler, log_data, mem_ctx32, &key->base,
+                              &prog_data32.base, shader, 32,
+                              shader_time_index32);
+      }
+      v32->import_uniforms(v8);
+
+      job32.v = v32;
+      /* Only the first successful compile is allowed to spill. */
+      job32.allow_spilling = allow_spilling && !try_simd16;
+      job32.use_rep_send = false;
+
+      threaded32 = concurrent32 &&
+                   thrd_create(&thread32, brw_run_fs_simd_job,
+                               &job32) == thrd_success;
+      if (!threaded32)
+         brw_run_fs_simd_job(&job32);
+   }
+
+   if (try_simd16) {
       /* Try a SIMD16 compile */
       v16 = new fs_visitor(compiler, log_data, mem_ctx, &key->base,
                            &prog_data->base, shader, 16, shader_time_index16);
@@ -8673,7 +8832,7 @@ brw_compile_fs(const struct brw_compiler *compiler, void *log_data,
          prog_data->dispatch_grf_start_reg_16 = v16->payload.num_regs;
          prog_data->reg_blocks_16 = brw_register_blocks(v16->grf_used);
          const performance &perf = v16->performance_analysis.require();
-         throughput = MAX2(throughput, perf.throughput);
+         throughput16 = perf.throughput;
          has_spilled = v16->spilled_any_registers;
          allow_spilling = false;
       }
@@ -8681,33 +8840,71 @@ brw_compile_fs(const struct brw_compiler *compiler, void *log_data,
 
    const bool simd16_failed = v16 && !simd16_cfg;
 
-   /* Currently, the compiler only supports SIMD32 on SNB+ */
-   if (!has_spilled &&
-       v8->max_dispatch_width >= 32 && !use_rep_send &&
-       devinfo->gen >= 6 && !simd16_failed &&
-       !(INTEL_DEBUG & DEBUG_NO32)) {
-      /* Try a SIMD32 compile */
-      v32 = new fs_visitor(compiler, log_data, mem_ctx, &key->base,
-                           &prog_data->base, shader, 32, shader_time_index32);
-      v32->import_uniforms(v8);
-      if (!v32->run_fs(allow_spilling, false)) {
+   if (threaded32)
+      thrd_join(thread32, NULL);
+
+   if (v32) {
+      /* The SIMD32 program is owned by the caller's context from now on. */
+      ralloc_steal(mem_ctx, mem_ctx32);
+
+      /* A sequential compile would not have tried SIMD32 at all. */
+      const bool skip32 = has_spilled || simd16_failed;
+
+      if (!skip32)
+         brw_fs_simd_job_flush_log(compiler, log_data, &job32);
+
+      if (skip32) {
+         /* Drop the result and the messages of the speculative compile. */
+      } else if (!job32.success) {
          compiler->shader_perf_log(log_data,
                                    "SIMD32 shader failed to compile: %s",
                                    v32->fail_msg);
       } else {
          const performance &perf = v32->performance_analysis.require();
+         const float throughput = MAX2(throughput8, throughput16);
 
-         if (!(INTEL_DEBUG & DEBUG_DO32) && throughput >= perf.throughput) {
-            compiler->shader_perf_log(log_data, "SIMD32 shader inefficient\n");
+         /* SIMD32 halves the number of threads available to hide latency
+          * behind and the estimate doesn't model that, so only use it when
+          * it is expected to be a clear win over the narrower programs.
+          * This matters for loops bound by a shared function like the
+          * sampler, where the wider program barely helps throughput.
+          */
+         if (!(INTEL_DEBUG & DEBUG_DO32) &&
+             perf.throughput < throughput * (1.0f + 1.0f / 16)) {
+            compiler->shader_perf_log(log_data,
+                                      "SIMD32 shader inefficient: "
+                                      "%f vs. %f invocations/cycle\n",
+                                      perf.throughput, throughput);
+            rejected_simd |= 32;
          } else {
             simd32_cfg = v32->cfg;
             prog_data->dispatch_grf_start_reg_32 = v32->payload.num_regs;
             prog_data->reg_blocks_32 = brw_register_blocks(v32->grf_used);
-            throughput = MAX2(throughput, perf.throughput);
+            prog_data->base.total_scratch =
+               MAX2(prog_data->base.total_scratch,
+                    prog_data32.base.total_scratch);
+            prog_data->base.has_ubo_pull |= prog_data32.base.has_ubo_pull;
+            prog_data->has_side_effects |= prog_data32.has_side_effects;
+            prog_data->pulls_bary |= prog_data32.pulls_bary;
          }
       }
    }
 
+   /* The SIMD8 and SIMD16 programs are both dispatched when available and
+    * the hardware picks between them, so drop the SIMD16 one if it is
+    * estimated to be slower than SIMD8.  Keep it alongside SIMD32 though,
+    * since some platforms require it in that case.
+    */
+   if (simd8_cfg && simd16_cfg && !simd32_cfg && !use_rep_send &&
+       devinfo->gen >= 5 && throughput16 < throughput8) {
+      compiler->shader_perf_log(log_data,
+                                "SIMD16 shader inefficient: "
+                                "%f vs. %f invocations/cycle\n",
+                                throughput16, throughput8);
+      simd16_cfg = NULL;
+      rejected_simd |= 16;
+   }
+
    /* When the caller requests a repclear shader, they want SIMD16-only */
    if (use_rep_send)
       simd8_cfg = NULL;
@@ -8776,6 +8973,8 @@ brw_compile_fs(const struct brw_compiler *compiler, void *log_data,
       prog_data->dispatch_8 = true;
       g.generate_code(simd8_cfg, 8, v8->shader_stats,
                       v8->performance_analysis.require(), stats);
+      if (stats)
+         stats->rejected_simd = rejected_simd;
       stats = stats ? stats + 1 : NULL;
    }
 
@@ -8784,6 +8983,8 @@ brw_compile_fs(const struct brw_compiler *compiler, void *log_data,
       prog_data->prog_offset_16 = g.generate_code(
          simd16_cfg, 16, v16->shader_stats,
          v16->performance_analysis.require(), stats);
+      if (stats)
+         stats->rejected_simd = rejected_simd;
       stats = stats ? stats + 1 : NULL;
    }
 
@@ -8792,6 +8993,8 @@ brw_compile_fs(const struct brw_compiler *compiler, void *log_data,
       prog_data->prog_offset_32 = g.generate_code(
          simd32_cfg, 32, v32->shader_stats,
          v32->performance_analysis.require(), stats);
+      if (stats)
+         stats->rejected_simd = rejected_simd;
       stats = stats ? stats + 1 : NULL;
    }
 
@@ -8802,6 +9005,63 @@ brw_compile_fs(const struct brw_compiler *compiler, void *log_data,
    return g.get_assembly();
 }
 
+const unsigned *
+brw_compile_fs(const struct brw_compiler *compiler, void *log_data,
+               void *mem_ctx,
+               const struct brw_wm_prog_key *key,
+               struct brw_wm_prog_data *prog_data,
+               nir_shader *shader,
+               int shader_time_index8, int shader_time_index16,
+               int shader_time_index32, bool allow_spilling,
+               bool use_rep_send, struct brw_vue_map *vue_map,
+               struct brw_compile_stats *stats,
+               char **error_str)
+{
+   /* Go through brw_compiler::compile_cache, if there is one. */
+   struct {
+      bool allow_spilling;
+      bool use_rep_send;
+      struct brw_vue_map vue_map;
+   } extra;
+   memset(&extra, 0, sizeof(extra));
+   extra.allow_spilling = allow_spilling;
+   extra.use_rep_send = use_rep_send;
+   if (vue_map)
+      extra.vue_map = *vue_map;
+
+   cache_key hash;
+   const bool use_cache =
+      shader_time_index8 < 0 && shader_time_index16 < 0 &&
+      shader_time_index32 < 0 &&
+      brw_compile_cache_compute_key(compiler, MESA_SHADER_FRAGMENT, key,
+                                    &prog_data->base, shader,
+                                    &extra, sizeof(extra), hash);
+
+   struct brw_compile_stats cache_stats[3];
+   if (use_cache) {
+      const unsigned *assembly =
+         brw_compile_cache_search(compiler, mem_ctx, MESA_SHADER_FRAGMENT,
+                                  hash, &prog_data->base, stats);
+      if (assembly)
+         return assembly;
+
+      if (stats == NULL)
+         stats = cache_stats;
+   }
+
+   const unsigned *assembly =
+      compile_fs(compiler, log_data, mem_ctx, key, prog_data, shader,
+                 shader_time_index8, shader_time_index16, shader_time_index32,
+                 allow_spilling, use_rep_send, vue_map, stats, error_str);
+
+   if (use_cache && assembly) {
+      brw_compile_cache_store(compiler, MESA_SHADER_FRAGMENT, hash,
+                              &prog_data->base, assembly, stats);
+   }
+
+   return assembly;
+}
+
 fs_reg *
 fs_visitor::emit_cs_work_group_id_setup()
 {
@@ -8946,15 +9206,15 @@ compile_cs_to_nir(const struct brw_compiler *compiler,
    return shader;
 }
 
-const unsigned *
-brw_compile_cs(const struct brw_compiler *compiler, void *log_data,
-               void *mem_ctx,
-               const struct brw_cs_prog_key *key,
-               struct brw_cs_prog_data *prog_data,
-               const nir_shader *src_shader,
-               int shader_time_index,
-               struct brw_compile_stats *stats,
-               char **error_str)
+static const unsigned *
+compile_cs(const struct brw_compiler *compiler, void *log_data,
+           void *mem_ctx,
+           const struct brw_cs_prog_key *key,
+           struct brw_cs_prog_data *prog_data,
+           const nir_shader *src_shader,
+           int shader_time_index,
+           struct brw_compile_stats *stats,
+           char **error_str)
 {
    prog_data->base.total_shared = src_shader->info.cs.shared_size;
    prog_data->slm_size = src_shader->num_shared;
@@ -9187,6 +9447,48 @@ brw_compile_cs(const struct brw_compiler *compiler, void *log_data,
    return ret;
 }
 
+const unsigned *
+brw_compile_cs(const struct brw_compiler *compiler, void *log_data,
+               void *mem_ctx,
+               const struct brw_cs_prog_key *key,
+               struct brw_cs_prog_data *prog_data,
+               const nir_shader *src_shader,
+               int shader_time_index,
+               struct brw_compile_stats *stats,
+               char **error_str)
+{
+   /* Go through brw_compiler::compile_cache, if there is one. */
+   cache_key hash;
+   const bool use_cache =
+      shader_time_index < 0 &&
+      brw_compile_cache_compute_key(compiler, MESA_SHADER_COMPUTE, key,
+                                    &prog_data->base, src_shader,
+                                    NULL, 0, hash);
+
+   struct brw_compile_stats cache_stats[3];
+   if (use_cache) {
+      const unsigned *assembly =
+         brw_compile_cache_search(compiler, mem_ctx, MESA_SHADER_COMPUTE,
+                                  hash, &prog_data->base, stats);
+      if (assembly)
+         return assembly;
+
+      if (stats == NULL)
+         stats = cache_stats;
+   }
+
+   const unsigned *assembly =
+      compile_cs(compiler, log_data, mem_ctx, key, prog_data, src_shader,
+                 shader_time_index, stats, error_str);
+
+   if (use_cache && assembly) {
+      brw_compile_cache_store(compiler, MESA_SHADER_COMPUTE, hash,
+                              &prog_data->base, assembly, stats);
+   }
+
+   return assembly;
+}
+
 unsigned
 brw_cs_simd_size_for_group_size(const struct gen_device_info *devinfo,
                                 const struct brw_cs_prog_data *cs_prog_data,
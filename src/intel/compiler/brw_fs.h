@@ -219,6 +219,7 @@ public:
    bool opt_peephole_sel();
    bool opt_peephole_predicated_break();
    bool opt_saturate_propagation();
+   bool opt_loop_invariant_code_motion();
    bool opt_cmod_propagation();
    bool opt_zero_samples();
 
@@ -2629,6 +2629,8 @@ fs_generator::generate_code(const cfg_t *cfg, int dispatch_width,
       stats->cycles = perf.latency;
       stats->spills = spill_count;
       stats->fills = fill_count;
+      stats->throughput = perf.throughput;
+      stats->rejected_simd = 0;
    }
 
    return start_offset;
@@ -0,0 +1,289 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "brw_fs.h"
+#include "brw_fs_live_variables.h"
+#include "brw_cfg.h"
+
+using namespace brw;
+
+/** @file brw_fs_licm.cpp
+ *
+ * Implements loop-invariant code motion: instructions in the body of a loop
+ * which compute the same value on every iteration are moved into the block
+ * preceding the DO instruction.  This mostly catches the address
+ * calculations, uniform MOVs and message payload setup that are created by
+ * the lowering passes after NIR had its chance to do the same.
+ *
+ * Only instructions at the top level of the loop body are considered, and
+ * their destination must be the only definition of the VGRF in the whole
+ * program, so moving it can't change the value seen by any other
+ * instruction.
+ */
+
+namespace {
+   struct loop_info {
+      bblock_t *do_block;
+      fs_inst *while_inst;
+
+      /** Enclosing loop or -1. */
+      int parent;
+
+      /** Estimated number of GRFs live at the busiest point of the loop. */
+      unsigned max_pressure;
+   };
+
+   bool
+   can_hoist_opcode(const fs_inst *inst)
+   {
+      switch (inst->opcode) {
+      case BRW_OPCODE_MOV:
+      case BRW_OPCODE_SEL:
+      case BRW_OPCODE_NOT:
+      case BRW_OPCODE_AND:
+      case BRW_OPCODE_OR:
+      case BRW_OPCODE_XOR:
+      case BRW_OPCODE_SHR:
+      case BRW_OPCODE_SHL:
+      case BRW_OPCODE_ASR:
+      case BRW_OPCODE_ADD:
+      case BRW_OPCODE_MUL:
+      case BRW_OPCODE_MAD:
+      case BRW_OPCODE_LRP:
+      case BRW_OPCODE_AVG:
+      case BRW_OPCODE_FRC:
+      case BRW_OPCODE_RNDU:
+      case BRW_OPCODE_RNDD:
+      case BRW_OPCODE_RNDE:
+      case BRW_OPCODE_RNDZ:
+      case BRW_OPCODE_BFREV:
+      case BRW_OPCODE_BFE:
+      case BRW_OPCODE_BFI1:
+      case BRW_OPCODE_BFI2:
+      case BRW_OPCODE_CBIT:
+      case BRW_OPCODE_FBH:
+      case BRW_OPCODE_FBL:
+      case BRW_OPCODE_LZD:
+      case SHADER_OPCODE_LOAD_PAYLOAD:
+         return true;
+      default:
+         return false;
+      }
+   }
+
+   bool
+   is_invariant_candidate(const fs_visitor *v, const fs_inst *inst,
+                          const unsigned *defs)
+   {
+      if (!can_hoist_opcode(inst) ||
+          inst->predicate || inst->saturate ||
+          inst->writes_accumulator ||
+          inst->reads_accumulator_implicitly() ||
+          inst->flags_written() ||
+          inst->flags_read(v->devinfo) ||
+          inst->has_side_effects() ||
+          inst->is_volatile())
+         return false;
+
+      /* The instruction must be the one and only write of the whole VGRF. */
+      if (inst->dst.file != VGRF ||
+          inst->dst.offset != 0 ||
+          inst->is_partial_write() ||
+          defs[inst->dst.nr] != 1 ||
+          regs_written(inst) != v->alloc.sizes[inst->dst.nr])
+         return false;
+
+      for (int i = 0; i < inst->sources; i++) {
+         switch (inst->src[i].file) {
+         case BAD_FILE:
+         case IMM:
+         case UNIFORM:
+         case VGRF:
+         case ATTR:
+            break;
+         default:
+            return false;
+         }
+      }
+
+      return true;
+   }
+
+   /**
+    * Return the block the code hoisted out of the loop can be appended to.
+    * The DO block itself is the target of the back-edge of a predicated
+    * WHILE, so this must be a separate block falling through into it,
+    * which is created if the previous block ends with control flow.
+    */
+   bblock_t *
+   get_preheader(cfg_t *cfg, bblock_t *do_block)
+   {
+      bblock_t *block = do_block->prev();
+
+      if (block && !block->ends_with_control_flow() &&
+          block->end()->opcode != BRW_OPCODE_DO)
+         return block;
+
+      return cfg->insert_block_before(do_block);
+   }
+}
+
+bool
+fs_visitor::opt_loop_invariant_code_motion()
+{
+   const register_pressure &rp = regpressure_analysis.require();
+   void *mem_ctx = ralloc_context(NULL);
+   bool progress = false;
+
+   /* Number of definitions of each VGRF in the whole program and in the
+    * loop being processed.
+    */
+   unsigned *defs = rzalloc_array(mem_ctx, unsigned, alloc.count);
+   unsigned *loop_defs = rzalloc_array(mem_ctx, unsigned, alloc.count);
+
+   /* Gather the loops of the program.  order[] lists them in the order
+    * their WHILE appears, so the instructions hoisted out of an inner loop
+    * get a chance to be hoisted out of the enclosing loops too.
+    */
+   loop_info *loops = ralloc_array(mem_ctx, loop_info, cfg->num_blocks);
+   int *loop_stack = ralloc_array(mem_ctx, int, cfg->num_blocks);
+   unsigned *order = ralloc_array(mem_ctx, unsigned, cfg->num_blocks);
+   unsigned num_loops = 0, num_ordered = 0, stack_depth = 0;
+   unsigned *pressure = ralloc_array(mem_ctx, unsigned, cfg->num_blocks);
+   int ip = 0;
+
+   foreach_block_and_inst(block, fs_inst, inst, cfg) {
+      if (inst->dst.file == VGRF)
+         defs[inst->dst.nr]++;
+
+      for (unsigned i = 0; i < stack_depth; i++)
+         pressure[i] = MAX2(pressure[i], rp.regs_live_at_ip[ip]);
+
+      if (inst->opcode == BRW_OPCODE_DO) {
+         loops[num_loops].do_block = block;
+         pressure[stack_depth] = rp.regs_live_at_ip[ip];
+         loop_stack[stack_depth++] = num_loops++;
+      } else if (inst->opcode == BRW_OPCODE_WHILE) {
+         assert(stack_depth > 0);
+         stack_depth--;
+         loop_info &loop = loops[loop_stack[stack_depth]];
+         loop.while_inst = inst;
+         loop.max_pressure = pressure[stack_depth];
+         loop.parent = stack_depth ? loop_stack[stack_depth - 1] : -1;
+         order[num_ordered++] = loop_stack[stack_depth];
+      }
+
+      ip++;
+   }
+
+   assert(num_ordered == num_loops);
+
+   /* The register allocator has BRW_MAX_GRF registers to work with, leave
+    * some headroom for the payload and allocation inefficiencies.
+    */
+   const unsigned max_pressure = BRW_MAX_GRF * 3 / 4;
+
+   for (unsigned l = 0; l < num_loops; l++) {
+      loop_info &loop = loops[order[l]];
+
+      memset(loop_defs, 0, alloc.count * sizeof(*loop_defs));
+
+      for (bblock_t *block = loop.do_block->next();; block = block->next()) {
+         foreach_inst_in_block(fs_inst, inst, block) {
+            if (inst->dst.file == VGRF)
+               loop_defs[inst->dst.nr]++;
+         }
+
+         if (block->end() == loop.while_inst)
+            break;
+      }
+
+      bblock_t *preheader = NULL;
+      int depth = 0;
+      bool reached_while = false;
+
+      for (bblock_t *block = loop.do_block->next(), *next_block;
+           !reached_while; block = next_block) {
+         /* Hoisting the last instruction of a block removes the block. */
+         next_block = block->next();
+
+         foreach_inst_in_block_safe(fs_inst, inst, block) {
+            if (inst == loop.while_inst) {
+               reached_while = true;
+               break;
+            }
+
+            switch (inst->opcode) {
+            case BRW_OPCODE_DO:
+            case BRW_OPCODE_IF:
+               depth++;
+               continue;
+            case BRW_OPCODE_WHILE:
+            case BRW_OPCODE_ENDIF:
+               depth--;
+               continue;
+            default:
+               break;
+            }
+
+            if (depth != 0 || !is_invariant_candidate(this, inst, defs))
+               continue;
+
+            bool invariant = true;
+            for (int i = 0; i < inst->sources; i++) {
+               if (inst->src[i].file == VGRF && loop_defs[inst->src[i].nr]) {
+                  invariant = false;
+                  break;
+               }
+            }
+
+            const unsigned size = regs_written(inst);
+            if (!invariant || loop.max_pressure + size > max_pressure)
+               continue;
+
+            /* The value is now live throughout this loop and any loop it
+             * might be hoisted out of later.
+             */
+            for (int p = order[l]; p >= 0; p = loops[p].parent)
+               loops[p].max_pressure += size;
+
+            if (!preheader)
+               preheader = get_preheader(cfg, loop.do_block);
+
+            loop_defs[inst->dst.nr]--;
+            inst->remove(block);
+            /* A newly created preheader is still empty. */
+            fs_inst *last = (fs_inst *)preheader->instructions.get_tail_raw();
+            last->insert_after(preheader, inst);
+            progress = true;
+         }
+      }
+   }
+
+   ralloc_free(mem_ctx);
+
+   if (progress)
+      invalidate_analysis(DEPENDENCY_INSTRUCTIONS | DEPENDENCY_BLOCKS);
+
+   return progress;
+}
@@ -145,84 +145,135 @@ fs_live_variables::setup_def_use()
    }
 }
 
+/**
+ * Simple LIFO worklist of blocks, each of which is present at most once.
+ */
+struct block_worklist {
+   block_worklist(void *mem_ctx, const cfg_t *cfg)
+      : count(0)
+   {
+      blocks = ralloc_array(mem_ctx, bblock_t *, cfg->num_blocks);
+      present = rzalloc_array(mem_ctx, BITSET_WORD,
+                              BITSET_WORDS(cfg->num_blocks));
+   }
+
+   void
+   push(bblock_t *block)
+   {
+      if (!BITSET_TEST(present, block->num)) {
+         BITSET_SET(present, block->num);
+         blocks[count++] = block;
+      }
+   }
+
+   bblock_t *
+   pop()
+   {
+      bblock_t *block = blocks[--count];
+      BITSET_CLEAR(present, block->num);
+      return block;
+   }
+
+   bool
+   empty() const
+   {
+      return count == 0;
+   }
+
+   bblock_t **blocks;
+   BITSET_WORD *present;
+   unsigned count;
+};
+
 /**
  * The algorithm incrementally sets bits in liveout and livein,
  * propagating it through control flow.  It will eventually terminate
- * because it only ever adds bits, and stops when no bits are added in
- * a pass.
+ * because it only ever adds bits.
+ *
+ * Rather than iterating over the whole program until nothing changes, only
+ * the blocks whose inputs may have changed are revisited, which keeps the
+ * cost down for programs with many blocks where only a few carry values
+ * around loops.
  */
 void
 fs_live_variables::compute_live_variables()
 {
-   bool cont = true;
-
-   while (cont) {
-      cont = false;
-
-      foreach_block_reverse (block, cfg) {
-         struct block_data *bd = &block_data[block->num];
-
-	 /* Update liveout */
-	 foreach_list_typed(bblock_link, child_link, link, &block->children) {
-       struct block_data *child_bd = &block_data[child_link->block->num];
-
-	    for (int i = 0; i < bitset_words; i++) {
-               BITSET_WORD new_liveout = (child_bd->livein[i] &
-                                          ~bd->liveout[i]);
-               if (new_liveout) {
-                  bd->liveout[i] |= new_liveout;
-                  cont = true;
-               }
-	    }
-            BITSET_WORD new_liveout = (child_bd->flag_livein[0] &
-                                       ~bd->flag_liveout[0]);
-            if (new_liveout) {
-               bd->flag_liveout[0] |= new_liveout;
-               cont = true;
-            }
-	 }
+   void *worklist_ctx = ralloc_context(NULL);
+   block_worklist worklist(worklist_ctx, cfg);
 
-         /* Update livein */
-         for (int i = 0; i < bitset_words; i++) {
-            BITSET_WORD new_livein = (bd->use[i] |
-                                      (bd->liveout[i] &
-                                       ~bd->def[i]));
-            if (new_livein & ~bd->livein[i]) {
-               bd->livein[i] |= new_livein;
-               cont = true;
-            }
-         }
-         BITSET_WORD new_livein = (bd->flag_use[0] |
-                                   (bd->flag_liveout[0] &
-                                    ~bd->flag_def[0]));
-         if (new_livein & ~bd->flag_livein[0]) {
-            bd->flag_livein[0] |= new_livein;
-            cont = true;
+   /* Blocks are popped in reverse order for the backwards pass. */
+   foreach_block (block, cfg)
+      worklist.push(block);
+
+   while (!worklist.empty()) {
+      bblock_t *block = worklist.pop();
+      struct block_data *bd = &block_data[block->num];
+
+      /* Update liveout */
+      foreach_list_typed(bblock_link, child_link, link, &block->children) {
+         const struct block_data *child_bd =
+            &block_data[child_link->block->num];
+
+         for (int i = 0; i < bitset_words; i++)
+            bd->liveout[i] |= child_bd->livein[i];
+
+         bd->flag_liveout[0] |= child_bd->flag_livein[0];
+      }
+
+      /* Update livein */
+      bool progress = false;
+
+      for (int i = 0; i < bitset_words; i++) {
+         BITSET_WORD new_livein = (bd->use[i] |
+                                   (bd->liveout[i] &
+                                    ~bd->def[i]));
+         if (new_livein & ~bd->livein[i]) {
+            bd->livein[i] |= new_livein;
+            progress = true;
          }
       }
+      BITSET_WORD new_livein = (bd->flag_use[0] |
+                                (bd->flag_liveout[0] &
+                                 ~bd->flag_def[0]));
+      if (new_livein & ~bd->flag_livein[0]) {
+         bd->flag_livein[0] |= new_livein;
+         progress = true;
+      }
+
+      if (progress) {
+         foreach_list_typed(bblock_link, parent_link, link, &block->parents)
+            worklist.push(parent_link->block);
+      }
    }
 
    /* Propagate defin and defout down the CFG to calculate the union of live
     * variables potentially defined along any possible control flow path.
+    * Blocks are popped in program order for the forwards pass.
     */
-   do {
-      cont = false;
+   foreach_block_reverse (block, cfg)
+      worklist.push(block);
 
-      foreach_block (block, cfg) {
-         const struct block_data *bd = &block_data[block->num];
+   while (!worklist.empty()) {
+      bblock_t *block = worklist.pop();
+      const struct block_data *bd = &block_data[block->num];
 
-	 foreach_list_typed(bblock_link, child_link, link, &block->children) {
-       struct block_data *child_bd = &block_data[child_link->block->num];
+      foreach_list_typed(bblock_link, child_link, link, &block->children) {
+         struct block_data *child_bd = &block_data[child_link->block->num];
+         BITSET_WORD progress = 0;
 
-	    for (int i = 0; i < bitset_words; i++) {
-               const BITSET_WORD new_def = bd->defout[i] & ~child_bd->defin[i];
-               child_bd->defin[i] |= new_def;
-               child_bd->defout[i] |= new_def;
-               cont |= new_def;
-	    }
-	 }
+         for (int i = 0; i < bitset_words; i++) {
+            const BITSET_WORD new_def = bd->defout[i] & ~child_bd->defin[i];
+            child_bd->defin[i] |= new_def;
+            child_bd->defout[i] |= new_def;
+            progress |= new_def;
+         }
+
+         if (progress)
+            worklist.push(child_link->block);
       }
-   } while (cont);
+   }
+
+   ralloc_free(worklist_ctx);
 }
 
 /**
@@ -291,14 +342,20 @@ fs_live_variables::fs_live_variables(const backend_shader *s)
 
    block_data = rzalloc_array(mem_ctx, struct block_data, cfg->num_blocks);
 
+   /* Carve all the per-block sets out of a single allocation, this analysis
+    * is recalculated often enough for the allocator overhead to matter.
+    */
    bitset_words = BITSET_WORDS(num_vars);
+   BITSET_WORD *sets = rzalloc_array(mem_ctx, BITSET_WORD,
+                                     6 * bitset_words * cfg->num_blocks);
    for (int i = 0; i < cfg->num_blocks; i++) {
-      block_data[i].def = rzalloc_array(mem_ctx, BITSET_WORD, bitset_words);
-      block_data[i].use = rzalloc_array(mem_ctx, BITSET_WORD, bitset_words);
-      block_data[i].livein = rzalloc_array(mem_ctx, BITSET_WORD, bitset_words);
-      block_data[i].liveout = rzalloc_array(mem_ctx, BITSET_WORD, bitset_words);
-      block_data[i].defin = rzalloc_array(mem_ctx, BITSET_WORD, bitset_words);
-      block_data[i].defout = rzalloc_array(mem_ctx, BITSET_WORD, bitset_words);
+      block_data[i].def = sets;
+      block_data[i].use = sets + bitset_words;
+      block_data[i].livein = sets + 2 * bitset_words;
+      block_data[i].liveout = sets + 3 * bitset_words;
+      block_data[i].defin = sets + 4 * bitset_words;
+      block_data[i].defout = sets + 5 * bitset_words;
+      sets += 6 * bitset_words;
 
       block_data[i].flag_def[0] = 0;
       block_data[i].flag_use[0] = 0;
@@ -451,6 +451,7 @@ private:
 
    void set_spill_costs();
    int choose_spill_reg();
+   unsigned choose_spill_regs(unsigned max_count, int *regs);
    fs_reg alloc_spill_reg(unsigned size, int ip);
    void spill_reg(unsigned spill_reg);
 
@@ -983,6 +984,62 @@ fs_reg_alloc::choose_spill_reg()
    return node - first_vgrf_node;
 }
 
+/**
+ * Picks up to max_count registers to spill at once, in order of decreasing
+ * benefit.  Registers which interfere with an already picked one are
+ * skipped: they most likely relieve the same point of register pressure,
+ * so spilling only one of them and trying again is better.
+ */
+unsigned
+fs_reg_alloc::choose_spill_regs(unsigned max_count, int *regs)
+{
+   if (!have_spill_costs)
+      set_spill_costs();
+
+   const unsigned max_skipped = max_count * 8;
+   unsigned count = 0;
+   int *skipped = ralloc_array(mem_ctx, int, max_skipped);
+   float *skipped_cost = ralloc_array(mem_ctx, float, max_skipped);
+   unsigned skipped_count = 0;
+
+   while (count < max_count) {
+      int node = ra_get_best_spill_node(g);
+      if (node < 0)
+         break;
+
+      assert(node >= first_vgrf_node);
+      int reg = node - first_vgrf_node;
+
+      bool interferes = false;
+      for (unsigned i = 0; i < count; i++) {
+         if (live.vgrfs_interfere(reg, regs[i])) {
+            interferes = true;
+            break;
+         }
+      }
+
+      if (!interferes) {
+         regs[count++] = reg;
+      } else if (skipped_count == max_skipped) {
+         break;
+      } else {
+         skipped[skipped_count] = node;
+         skipped_cost[skipped_count++] = ra_get_node_spill_cost(g, node);
+      }
+
+      /* Hide the node from ra_get_best_spill_node() for now. */
+      ra_set_node_spill_cost(g, node, 0);
+   }
+
+   for (unsigned i = 0; i < skipped_count; i++)
+      ra_set_node_spill_cost(g, skipped[i], skipped_cost[i]);
+
+   ralloc_free(skipped);
+   ralloc_free(skipped_cost);
+
+   return count;
+}
+
 fs_reg
 fs_reg_alloc::alloc_spill_reg(unsigned size, int ip)
 {
@@ -1168,7 +1225,7 @@ fs_reg_alloc::assign_regs(bool allow_spilling, bool spill_all)
 {
    build_interference_graph(fs->spilled_any_registers || spill_all);
 
-   bool spilled = false;
+   unsigned spilled = 0;
    while (1) {
       /* Debug of register spilling: Go spill everything. */
       if (unlikely(spill_all)) {
@@ -1185,12 +1242,21 @@ fs_reg_alloc::assign_regs(bool allow_spilling, bool spill_all)
       if (!allow_spilling)
          return false;
 
-      /* Failed to allocate registers.  Spill a reg, and the caller will
-       * loop back into here to try again.
+      /* Failed to allocate registers.  Spill some regs, and the caller will
+       * loop back into here to try again.  Every ra_allocate() is expensive,
+       * so with a spilling rate set, spill more registers at once the more
+       * we have spilled already.
        */
-      int reg = choose_spill_reg();
-      if (reg == -1)
+      unsigned nr_spills = 1;
+      if (compiler->spilling_rate)
+         nr_spills = MAX2(1, spilled / compiler->spilling_rate);
+
+      int *regs = ralloc_array(mem_ctx, int, nr_spills);
+      nr_spills = choose_spill_regs(nr_spills, regs);
+      if (nr_spills == 0) {
+         ralloc_free(regs);
          return false;
+      }
 
       /* If we're going to spill but we've never spilled before, we need to
        * re-build the interference graph with MRFs enabled to allow spilling.
@@ -1200,9 +1266,11 @@ fs_reg_alloc::assign_regs(bool allow_spilling, bool spill_all)
          build_interference_graph(true);
       }
 
-      spilled = true;
+      for (unsigned i = 0; i < nr_spills; i++)
+         spill_reg(regs[i]);
 
-      spill_reg(reg);
+      ralloc_free(regs);
+      spilled += nr_spills;
    }
 
    if (spilled)
@@ -30,6 +30,7 @@
 #include "brw_vec4.h"
 #include "brw_cfg.h"
 #include "brw_shader.h"
+#include "brw_latency_tables.h"
 
 using namespace brw;
 
@@ -63,8 +64,7 @@ class schedule_node : public exec_node
 {
 public:
    schedule_node(backend_instruction *inst, instruction_scheduler *sched);
-   void set_latency_gen4();
-   void set_latency_gen7(bool is_haswell);
+   void set_latency(const struct gen_device_info *devinfo);
 
    backend_instruction *inst;
    schedule_node **children;
@@ -114,420 +114,29 @@ exit_unblocked_time(const schedule_node *n)
    return n->exit ? n->exit->unblocked_time : INT_MAX;
 }
 
+/**
+ * Look up the latency of the instruction in the tables generated from
+ * brw_latency_tables.py.
+ */
 void
-schedule_node::set_latency_gen4()
-{
-   int chans = 8;
-   int math_latency = 22;
-
-   switch (inst->opcode) {
-   case SHADER_OPCODE_RCP:
-      this->latency = 1 * chans * math_latency;
-      break;
-   case SHADER_OPCODE_RSQ:
-      this->latency = 2 * chans * math_latency;
-      break;
-   case SHADER_OPCODE_INT_QUOTIENT:
-   case SHADER_OPCODE_SQRT:
-   case SHADER_OPCODE_LOG2:
-      /* full precision log.  partial is 2. */
-      this->latency = 3 * chans * math_latency;
-      break;
-   case SHADER_OPCODE_INT_REMAINDER:
-   case SHADER_OPCODE_EXP2:
-      /* full precision.  partial is 3, same throughput. */
-      this->latency = 4 * chans * math_latency;
-      break;
-   case SHADER_OPCODE_POW:
-      this->latency = 8 * chans * math_latency;
-      break;
-   case SHADER_OPCODE_SIN:
-   case SHADER_OPCODE_COS:
-      /* minimum latency, max is 12 rounds. */
-      this->latency = 5 * chans * math_latency;
-      break;
-   default:
-      this->latency = 2;
-      break;
-   }
-}
-
-void
-schedule_node::set_latency_gen7(bool is_haswell)
+schedule_node::set_latency(const struct gen_device_info *devinfo)
 {
-   switch (inst->opcode) {
-   case BRW_OPCODE_MAD:
-      /* 2 cycles
-       *  (since the last two src operands are in different register banks):
-       * mad(8) g4<1>F g2.2<4,4,1>F.x  g2<4,4,1>F.x g3.1<4,4,1>F.x { align16 WE_normal 1Q };
-       *
-       * 3 cycles on IVB, 4 on HSW
-       *  (since the last two src operands are in the same register bank):
-       * mad(8) g4<1>F g2.2<4,4,1>F.x  g2<4,4,1>F.x g2.1<4,4,1>F.x { align16 WE_normal 1Q };
-       *
-       * 18 cycles on IVB, 16 on HSW
-       *  (since the last two src operands are in different register banks):
-       * mad(8) g4<1>F g2.2<4,4,1>F.x  g2<4,4,1>F.x g3.1<4,4,1>F.x { align16 WE_normal 1Q };
-       * mov(8) null   g4<4,5,1>F                     { align16 WE_normal 1Q };
-       *
-       * 20 cycles on IVB, 18 on HSW
-       *  (since the last two src operands are in the same register bank):
-       * mad(8) g4<1>F g2.2<4,4,1>F.x  g2<4,4,1>F.x g2.1<4,4,1>F.x { align16 WE_normal 1Q };
-       * mov(8) null   g4<4,4,1>F                     { align16 WE_normal 1Q };
-       */
-
-      /* Our register allocator doesn't know about register banks, so use the
-       * higher latency.
-       */
-      latency = is_haswell ? 16 : 18;
-      break;
-
-   case BRW_OPCODE_LRP:
-      /* 2 cycles
-       *  (since the last two src operands are in different register banks):
-       * lrp(8) g4<1>F g2.2<4,4,1>F.x  g2<4,4,1>F.x g3.1<4,4,1>F.x { align16 WE_normal 1Q };
-       *
-       * 3 cycles on IVB, 4 on HSW
-       *  (since the last two src operands are in the same register bank):
-       * lrp(8) g4<1>F g2.2<4,4,1>F.x  g2<4,4,1>F.x g2.1<4,4,1>F.x { align16 WE_normal 1Q };
-       *
-       * 16 cycles on IVB, 14 on HSW
-       *  (since the last two src operands are in different register banks):
-       * lrp(8) g4<1>F g2.2<4,4,1>F.x  g2<4,4,1>F.x g3.1<4,4,1>F.x { align16 WE_normal 1Q };
-       * mov(8) null   g4<4,4,1>F                     { align16 WE_normal 1Q };
-       *
-       * 16 cycles
-       *  (since the last two src operands are in the same register bank):
-       * lrp(8) g4<1>F g2.2<4,4,1>F.x  g2<4,4,1>F.x g2.1<4,4,1>F.x { align16 WE_normal 1Q };
-       * mov(8) null   g4<4,4,1>F                     { align16 WE_normal 1Q };
-       */
-
-      /* Our register allocator doesn't know about register banks, so use the
-       * higher latency.
-       */
-      latency = 14;
-      break;
-
-   case SHADER_OPCODE_RCP:
-   case SHADER_OPCODE_RSQ:
-   case SHADER_OPCODE_SQRT:
-   case SHADER_OPCODE_LOG2:
-   case SHADER_OPCODE_EXP2:
-   case SHADER_OPCODE_SIN:
-   case SHADER_OPCODE_COS:
-      /* 2 cycles:
-       * math inv(8) g4<1>F g2<0,1,0>F      null       { align1 WE_normal 1Q };
-       *
-       * 18 cycles:
-       * math inv(8) g4<1>F g2<0,1,0>F      null       { align1 WE_normal 1Q };
-       * mov(8)      null   g4<8,8,1>F                 { align1 WE_normal 1Q };
-       *
-       * Same for exp2, log2, rsq, sqrt, sin, cos.
-       */
-      latency = is_haswell ? 14 : 16;
-      break;
-
-   case SHADER_OPCODE_POW:
-      /* 2 cycles:
-       * math pow(8) g4<1>F g2<0,1,0>F   g2.1<0,1,0>F  { align1 WE_normal 1Q };
-       *
-       * 26 cycles:
-       * math pow(8) g4<1>F g2<0,1,0>F   g2.1<0,1,0>F  { align1 WE_normal 1Q };
-       * mov(8)      null   g4<8,8,1>F                 { align1 WE_normal 1Q };
-       */
-      latency = is_haswell ? 22 : 24;
-      break;
-
-   case SHADER_OPCODE_TEX:
-   case SHADER_OPCODE_TXD:
-   case SHADER_OPCODE_TXF:
-   case SHADER_OPCODE_TXF_LZ:
-   case SHADER_OPCODE_TXL:
-   case SHADER_OPCODE_TXL_LZ:
-      /* 18 cycles:
-       * mov(8)  g115<1>F   0F                         { align1 WE_normal 1Q };
-       * mov(8)  g114<1>F   0F                         { align1 WE_normal 1Q };
-       * send(8) g4<1>UW    g114<8,8,1>F
-       *   sampler (10, 0, 0, 1) mlen 2 rlen 4         { align1 WE_normal 1Q };
-       *
-       * 697 +/-49 cycles (min 610, n=26):
-       * mov(8)  g115<1>F   0F                         { align1 WE_normal 1Q };
-       * mov(8)  g114<1>F   0F                         { align1 WE_normal 1Q };
-       * send(8) g4<1>UW    g114<8,8,1>F
-       *   sampler (10, 0, 0, 1) mlen 2 rlen 4         { align1 WE_normal 1Q };
-       * mov(8)  null       g4<8,8,1>F                 { align1 WE_normal 1Q };
-       *
-       * So the latency on our first texture load of the batchbuffer takes
-       * ~700 cycles, since the caches are cold at that point.
-       *
-       * 840 +/- 92 cycles (min 720, n=25):
-       * mov(8)  g115<1>F   0F                         { align1 WE_normal 1Q };
-       * mov(8)  g114<1>F   0F                         { align1 WE_normal 1Q };
-       * send(8) g4<1>UW    g114<8,8,1>F
-       *   sampler (10, 0, 0, 1) mlen 2 rlen 4         { align1 WE_normal 1Q };
-       * mov(8)  null       g4<8,8,1>F                 { align1 WE_normal 1Q };
-       * send(8) g4<1>UW    g114<8,8,1>F
-       *   sampler (10, 0, 0, 1) mlen 2 rlen 4         { align1 WE_normal 1Q };
-       * mov(8)  null       g4<8,8,1>F                 { align1 WE_normal 1Q };
-       *
-       * On the second load, it takes just an extra ~140 cycles, and after
-       * accounting for the 14 cycles of the MOV's latency, that makes ~130.
-       *
-       * 683 +/- 49 cycles (min = 602, n=47):
-       * mov(8)  g115<1>F   0F                         { align1 WE_normal 1Q };
-       * mov(8)  g114<1>F   0F                         { align1 WE_normal 1Q };
-       * send(8) g4<1>UW    g114<8,8,1>F
-       *   sampler (10, 0, 0, 1) mlen 2 rlen 4         { align1 WE_normal 1Q };
-       * send(8) g50<1>UW   g114<8,8,1>F
-       *   sampler (10, 0, 0, 1) mlen 2 rlen 4         { align1 WE_normal 1Q };
-       * mov(8)  null       g4<8,8,1>F                 { align1 WE_normal 1Q };
-       *
-       * The unit appears to be pipelined, since this matches up with the
-       * cache-cold case, despite there being two loads here.  If you replace
-       * the g4 in the MOV to null with g50, it's still 693 +/- 52 (n=39).
-       *
-       * So, take some number between the cache-hot 140 cycles and the
-       * cache-cold 700 cycles.  No particular tuning was done on this.
-       *
-       * I haven't done significant testing of the non-TEX opcodes.  TXL at
-       * least looked about the same as TEX.
-       */
-      latency = 200;
-      break;
-
-   case SHADER_OPCODE_TXS:
-      /* Testing textureSize(sampler2D, 0), one load was 420 +/- 41
-       * cycles (n=15):
-       * mov(8)   g114<1>UD  0D                        { align1 WE_normal 1Q };
-       * send(8)  g6<1>UW    g114<8,8,1>F
-       *   sampler (10, 0, 10, 1) mlen 1 rlen 4        { align1 WE_normal 1Q };
-       * mov(16)  g6<1>F     g6<8,8,1>D                { align1 WE_normal 1Q };
-       *
-       *
-       * Two loads was 535 +/- 30 cycles (n=19):
-       * mov(16)   g114<1>UD  0D                       { align1 WE_normal 1H };
-       * send(16)  g6<1>UW    g114<8,8,1>F
-       *   sampler (10, 0, 10, 2) mlen 2 rlen 8        { align1 WE_normal 1H };
-       * mov(16)   g114<1>UD  0D                       { align1 WE_normal 1H };
-       * mov(16)   g6<1>F     g6<8,8,1>D               { align1 WE_normal 1H };
-       * send(16)  g8<1>UW    g114<8,8,1>F
-       *   sampler (10, 0, 10, 2) mlen 2 rlen 8        { align1 WE_normal 1H };
-       * mov(16)   g8<1>F     g8<8,8,1>D               { align1 WE_normal 1H };
-       * add(16)   g6<1>F     g6<8,8,1>F   g8<8,8,1>F  { align1 WE_normal 1H };
-       *
-       * Since the only caches that should matter are just the
-       * instruction/state cache containing the surface state, assume that we
-       * always have hot caches.
-       */
-      latency = 100;
-      break;
-
-   case FS_OPCODE_VARYING_PULL_CONSTANT_LOAD_GEN4:
-   case FS_OPCODE_UNIFORM_PULL_CONSTANT_LOAD:
-   case FS_OPCODE_UNIFORM_PULL_CONSTANT_LOAD_GEN7:
-   case VS_OPCODE_PULL_CONSTANT_LOAD:
-      /* testing using varying-index pull constants:
-       *
-       * 16 cycles:
-       * mov(8)  g4<1>D  g2.1<0,1,0>F                  { align1 WE_normal 1Q };
-       * send(8) g4<1>F  g4<8,8,1>D
-       *   data (9, 2, 3) mlen 1 rlen 1                { align1 WE_normal 1Q };
-       *
-       * ~480 cycles:
-       * mov(8)  g4<1>D  g2.1<0,1,0>F                  { align1 WE_normal 1Q };
-       * send(8) g4<1>F  g4<8,8,1>D
-       *   data (9, 2, 3) mlen 1 rlen 1                { align1 WE_normal 1Q };
-       * mov(8)  null    g4<8,8,1>F                    { align1 WE_normal 1Q };
-       *
-       * ~620 cycles:
-       * mov(8)  g4<1>D  g2.1<0,1,0>F                  { align1 WE_normal 1Q };
-       * send(8) g4<1>F  g4<8,8,1>D
-       *   data (9, 2, 3) mlen 1 rlen 1                { align1 WE_normal 1Q };
-       * mov(8)  null    g4<8,8,1>F                    { align1 WE_normal 1Q };
-       * send(8) g4<1>F  g4<8,8,1>D
-       *   data (9, 2, 3) mlen 1 rlen 1                { align1 WE_normal 1Q };
-       * mov(8)  null    g4<8,8,1>F                    { align1 WE_normal 1Q };
-       *
-       * So, if it's cache-hot, it's about 140.  If it's cache cold, it's
-       * about 460.  We expect to mostly be cache hot, so pick something more
-       * in that direction.
-       */
-      latency = 200;
-      break;
-
-   case SHADER_OPCODE_GEN7_SCRATCH_READ:
-      /* Testing a load from offset 0, that had been previously written:
-       *
-       * send(8) g114<1>UW g0<8,8,1>F data (0, 0, 0) mlen 1 rlen 1 { align1 WE_normal 1Q };
-       * mov(8)  null      g114<8,8,1>F { align1 WE_normal 1Q };
-       *
-       * The cycles spent seemed to be grouped around 40-50 (as low as 38),
-       * then around 140.  Presumably this is cache hit vs miss.
-       */
-      latency = 50;
-      break;
-
-   case VEC4_OPCODE_UNTYPED_ATOMIC:
-      /* See GEN7_DATAPORT_DC_UNTYPED_ATOMIC_OP */
-      latency = 14000;
-      break;
-
-   case VEC4_OPCODE_UNTYPED_SURFACE_READ:
-   case VEC4_OPCODE_UNTYPED_SURFACE_WRITE:
-      /* See also GEN7_DATAPORT_DC_UNTYPED_SURFACE_READ */
-      latency = is_haswell ? 300 : 600;
-      break;
-
-   case SHADER_OPCODE_SEND:
-      switch (inst->sfid) {
-      case BRW_SFID_SAMPLER: {
-         unsigned msg_type = (inst->desc >> 12) & 0x1f;
-         switch (msg_type) {
-         case GEN5_SAMPLER_MESSAGE_SAMPLE_RESINFO:
-         case GEN6_SAMPLER_MESSAGE_SAMPLE_SAMPLEINFO:
-            /* See also SHADER_OPCODE_TXS */
-            latency = 100;
-            break;
-
-         default:
-            /* See also SHADER_OPCODE_TEX */
-            latency = 200;
-            break;
-         }
-         break;
-      }
-
-      case GEN6_SFID_DATAPORT_RENDER_CACHE:
-         switch ((inst->desc >> 14) & 0x1f) {
-         case GEN7_DATAPORT_RC_TYPED_SURFACE_WRITE:
-         case GEN7_DATAPORT_RC_TYPED_SURFACE_READ:
-            /* See also SHADER_OPCODE_TYPED_SURFACE_READ */
-            assert(!is_haswell);
-            latency = 600;
-            break;
-
-         case GEN7_DATAPORT_RC_TYPED_ATOMIC_OP:
-            /* See also SHADER_OPCODE_TYPED_ATOMIC */
-            assert(!is_haswell);
-            latency = 14000;
-            break;
-
-         case GEN6_DATAPORT_WRITE_MESSAGE_RENDER_TARGET_WRITE:
-            /* completely fabricated number */
-            latency = 600;
-            break;
-
-         default:
-            unreachable("Unknown render cache message");
-         }
-         break;
-
-      case GEN7_SFID_DATAPORT_DATA_CACHE:
-         switch ((inst->desc >> 14) & 0x1f) {
-         case GEN7_DATAPORT_DC_DWORD_SCATTERED_READ:
-         case GEN6_DATAPORT_WRITE_MESSAGE_DWORD_SCATTERED_WRITE:
-         case HSW_DATAPORT_DC_PORT0_BYTE_SCATTERED_READ:
-         case HSW_DATAPORT_DC_PORT0_BYTE_SCATTERED_WRITE:
-            /* We have no data for this but assume it's roughly the same as
-             * untyped surface read/write.
-             */
-            latency = 300;
-            break;
-
-         case GEN7_DATAPORT_DC_UNTYPED_SURFACE_READ:
-         case GEN7_DATAPORT_DC_UNTYPED_SURFACE_WRITE:
-            /* Test code:
-             *   mov(8)    g112<1>UD       0x00000000UD       { align1 WE_all 1Q };
-             *   mov(1)    g112.7<1>UD     g1.7<0,1,0>UD      { align1 WE_all };
-             *   mov(8)    g113<1>UD       0x00000000UD       { align1 WE_normal 1Q };
-             *   send(8)   g4<1>UD         g112<8,8,1>UD
-             *             data (38, 6, 5) mlen 2 rlen 1      { align1 WE_normal 1Q };
-             *   .
-             *   . [repeats 8 times]
-             *   .
-             *   mov(8)    g112<1>UD       0x00000000UD       { align1 WE_all 1Q };
-             *   mov(1)    g112.7<1>UD     g1.7<0,1,0>UD      { align1 WE_all };
-             *   mov(8)    g113<1>UD       0x00000000UD       { align1 WE_normal 1Q };
-             *   send(8)   g4<1>UD         g112<8,8,1>UD
-             *             data (38, 6, 5) mlen 2 rlen 1      { align1 WE_normal 1Q };
-             *
-             * Running it 100 times as fragment shader on a 128x128 quad
-             * gives an average latency of 583 cycles per surface read,
-             * standard deviation 0.9%.
-             */
-            assert(!is_haswell);
-            latency = 600;
-            break;
-
-         case GEN7_DATAPORT_DC_UNTYPED_ATOMIC_OP:
-            /* Test code:
-             *   mov(8)    g112<1>ud       0x00000000ud       { align1 WE_all 1Q };
-             *   mov(1)    g112.7<1>ud     g1.7<0,1,0>ud      { align1 WE_all };
-             *   mov(8)    g113<1>ud       0x00000000ud       { align1 WE_normal 1Q };
-             *   send(8)   g4<1>ud         g112<8,8,1>ud
-             *             data (38, 5, 6) mlen 2 rlen 1      { align1 WE_normal 1Q };
-             *
-             * Running it 100 times as fragment shader on a 128x128 quad
-             * gives an average latency of 13867 cycles per atomic op,
-             * standard deviation 3%.  Note that this is a rather
-             * pessimistic estimate, the actual latency in cases with few
-             * collisions between threads and favorable pipelining has been
-             * seen to be reduced by a factor of 100.
-             */
-            assert(!is_haswell);
-            latency = 14000;
-            break;
-
-         default:
-            unreachable("Unknown data cache message");
-         }
-         break;
-
-      case HSW_SFID_DATAPORT_DATA_CACHE_1:
-         switch ((inst->desc >> 14) & 0x1f) {
-         case HSW_DATAPORT_DC_PORT1_UNTYPED_SURFACE_READ:
-         case HSW_DATAPORT_DC_PORT1_UNTYPED_SURFACE_WRITE:
-         case HSW_DATAPORT_DC_PORT1_TYPED_SURFACE_READ:
-         case HSW_DATAPORT_DC_PORT1_TYPED_SURFACE_WRITE:
-         case GEN8_DATAPORT_DC_PORT1_A64_UNTYPED_SURFACE_WRITE:
-         case GEN8_DATAPORT_DC_PORT1_A64_UNTYPED_SURFACE_READ:
-         case GEN8_DATAPORT_DC_PORT1_A64_SCATTERED_WRITE:
-         case GEN9_DATAPORT_DC_PORT1_A64_SCATTERED_READ:
-            /* See also GEN7_DATAPORT_DC_UNTYPED_SURFACE_READ */
-            latency = 300;
-            break;
-
-         case HSW_DATAPORT_DC_PORT1_UNTYPED_ATOMIC_OP:
-         case HSW_DATAPORT_DC_PORT1_UNTYPED_ATOMIC_OP_SIMD4X2:
-         case HSW_DATAPORT_DC_PORT1_TYPED_ATOMIC_OP_SIMD4X2:
-         case HSW_DATAPORT_DC_PORT1_TYPED_ATOMIC_OP:
-         case GEN9_DATAPORT_DC_PORT1_UNTYPED_ATOMIC_FLOAT_OP:
-         case GEN8_DATAPORT_DC_PORT1_A64_UNTYPED_ATOMIC_OP:
-         case GEN9_DATAPORT_DC_PORT1_A64_UNTYPED_ATOMIC_FLOAT_OP:
-            /* See also GEN7_DATAPORT_DC_UNTYPED_ATOMIC_OP */
-            latency = 14000;
-            break;
-
-         default:
-            unreachable("Unknown data cache message");
-         }
-         break;
-
-      default:
-         unreachable("Unknown SFID");
-      }
-      break;
-
-   default:
-      /* 2 cycles:
-       * mul(8) g4<1>F g2<0,1,0>F      0.5F            { align1 WE_normal 1Q };
-       *
-       * 16 cycles:
-       * mul(8) g4<1>F g2<0,1,0>F      0.5F            { align1 WE_normal 1Q };
-       * mov(8) null   g4<8,8,1>F                      { align1 WE_normal 1Q };
-       */
-      latency = 14;
-      break;
+   /* We can't measure Gen6 timings directly but expect them to be much
+    * closer to Gen7 than Gen4.
+    */
+   const enum brw_latency_class c =
+      devinfo->gen < 6 ? BRW_LATENCY_GEN4 :
+      devinfo->is_haswell ? BRW_LATENCY_HSW : BRW_LATENCY_GEN7;
+
+   if (inst->opcode == SHADER_OPCODE_SEND) {
+      assert(inst->sfid < BRW_LATENCY_NUM_SFIDS);
+      const unsigned msg_type =
+         (inst->desc >> brw_send_msg_type_shift[inst->sfid]) & 0x1f;
+      latency = brw_send_latency[c][inst->sfid][msg_type];
+      assert(latency != 0 && "Unknown SEND message");
+   } else {
+      assert(inst->opcode < BRW_LATENCY_NUM_OPCODES);
+      latency = brw_opcode_latency[c][inst->opcode];
    }
 }
 
@@ -904,15 +513,10 @@ schedule_node::schedule_node(backend_instruction *inst,
    this->delay = 0;
    this->exit = NULL;
 
-   /* We can't measure Gen6 timings directly but expect them to be much
-    * closer to Gen7 than Gen4.
-    */
    if (!sched->post_reg_alloc)
       this->latency = 1;
-   else if (devinfo->gen >= 6)
-      set_latency_gen7(devinfo->is_haswell);
    else
-      set_latency_gen4();
+      set_latency(devinfo);
 }
 
 void
@@ -1510,6 +1114,16 @@ schedule_node *
 fs_instruction_scheduler::choose_instruction_to_schedule()
 {
    schedule_node *chosen = NULL;
+   instruction_scheduler_mode mode = this->mode;
+
+   /* The hybrid mode follows the critical path until register pressure gets
+    * close to the size of the register file, and then does its best to
+    * bring it back down.
+    */
+   if (mode == SCHEDULE_PRE_HYBRID) {
+      mode = reg_pressure < (int)(BRW_MAX_GRF * 3 / 4) ?
+             SCHEDULE_PRE : SCHEDULE_PRE_LIFO;
+   }
 
    if (mode == SCHEDULE_PRE || mode == SCHEDULE_POST) {
       int chosen_time = 0;
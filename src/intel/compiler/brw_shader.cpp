@@ -1252,17 +1252,17 @@ backend_shader::invalidate_analysis(brw::analysis_dependency_class c)
    idom_analysis.invalidate(c);
 }
 
-extern "C" const unsigned *
-brw_compile_tes(const struct brw_compiler *compiler,
-                void *log_data,
-                void *mem_ctx,
-                const struct brw_tes_prog_key *key,
-                const struct brw_vue_map *input_vue_map,
-                struct brw_tes_prog_data *prog_data,
-                nir_shader *nir,
-                int shader_time_index,
-                struct brw_compile_stats *stats,
-                char **error_str)
+static const unsigned *
+compile_tes(const struct brw_compiler *compiler,
+            void *log_data,
+            void *mem_ctx,
+            const struct brw_tes_prog_key *key,
+            const struct brw_vue_map *input_vue_map,
+            struct brw_tes_prog_data *prog_data,
+            nir_shader *nir,
+            int shader_time_index,
+            struct brw_compile_stats *stats,
+            char **error_str)
 {
    const struct gen_device_info *devinfo = compiler->devinfo;
    const bool is_scalar = compiler->scalar_stage[MESA_SHADER_TESS_EVAL];
@@ -1395,3 +1395,48 @@ brw_compile_tes(const struct brw_compiler *compiler,
 
    return assembly;
 }
+
+extern "C" const unsigned *
+brw_compile_tes(const struct brw_compiler *compiler,
+                void *log_data,
+                void *mem_ctx,
+                const struct brw_tes_prog_key *key,
+                const struct brw_vue_map *input_vue_map,
+                struct brw_tes_prog_data *prog_data,
+                nir_shader *nir,
+                int shader_time_index,
+                struct brw_compile_stats *stats,
+                char **error_str)
+{
+   /* Go through brw_compiler::compile_cache, if there is one. */
+   cache_key hash;
+   const bool use_cache =
+      shader_time_index < 0 &&
+      brw_compile_cache_compute_key(compiler, MESA_SHADER_TESS_EVAL, key,
+                                    &prog_data->base.base, nir,
+                                    input_vue_map, sizeof(*input_vue_map),
+                                    hash);
+
+   struct brw_compile_stats cache_stats;
+   if (use_cache) {
+      const unsigned *assembly =
+         brw_compile_cache_search(compiler, mem_ctx, MESA_SHADER_TESS_EVAL,
+                                  hash, &prog_data->base.base, stats);
+      if (assembly)
+         return assembly;
+
+      if (stats == NULL)
+         stats = &cache_stats;
+   }
+
+   const unsigned *assembly =
+      compile_tes(compiler, log_data, mem_ctx, key, input_vue_map, prog_data,
+                  nir, shader_time_index, stats, error_str);
+
+   if (use_cache && assembly) {
+      brw_compile_cache_store(compiler, MESA_SHADER_TESS_EVAL, hash,
+                              &prog_data->base.base, assembly, stats);
+   }
+
+   return assembly;
+}
@@ -28,6 +28,7 @@
 #include "brw_cfg.h"
 #include "brw_compiler.h"
 #include "compiler/nir/nir.h"
+#include "util/disk_cache.h"
 
 #ifdef __cplusplus
 #include "brw_ir_analysis.h"
@@ -37,6 +38,7 @@ enum instruction_scheduler_mode {
    SCHEDULE_PRE,
    SCHEDULE_PRE_NON_LIFO,
    SCHEDULE_PRE_LIFO,
+   SCHEDULE_PRE_HYBRID,
    SCHEDULE_POST,
 };
 
@@ -114,6 +116,29 @@ void brw_fs_alloc_reg_sets(struct brw_compiler *compiler);
 /* brw_vec4_reg_allocate.cpp */
 void brw_vec4_alloc_reg_set(struct brw_compiler *compiler);
 
+/* brw_compile_cache.c */
+void brw_compile_cache_init(struct brw_compiler *compiler);
+
+bool brw_compile_cache_compute_key(const struct brw_compiler *compiler,
+                                   gl_shader_stage stage,
+                                   const void *key,
+                                   const struct brw_stage_prog_data *prog_data,
+                                   const nir_shader *nir,
+                                   const void *extra, size_t extra_size,
+                                   cache_key hash);
+
+const unsigned *
+brw_compile_cache_search(const struct brw_compiler *compiler, void *mem_ctx,
+                         gl_shader_stage stage, const cache_key hash,
+                         struct brw_stage_prog_data *prog_data,
+                         struct brw_compile_stats *stats);
+
+void brw_compile_cache_store(const struct brw_compiler *compiler,
+                             gl_shader_stage stage, const cache_key hash,
+                             const struct brw_stage_prog_data *prog_data,
+                             const unsigned *assembly,
+                             const struct brw_compile_stats *stats);
+
 /* brw_disasm.c */
 extern const char *const conditional_modifier[16];
 extern const char *const pred_ctrl_align16[16];
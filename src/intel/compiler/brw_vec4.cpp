@@ -2848,15 +2848,15 @@ extern "C" {
  *
  * Returns the final assembly and the program's size.
  */
-const unsigned *
-brw_compile_vs(const struct brw_compiler *compiler, void *log_data,
-               void *mem_ctx,
-               const struct brw_vs_prog_key *key,
-               struct brw_vs_prog_data *prog_data,
-               nir_shader *shader,
-               int shader_time_index,
-               struct brw_compile_stats *stats,
-               char **error_str)
+static const unsigned *
+compile_vs(const struct brw_compiler *compiler, void *log_data,
+           void *mem_ctx,
+           const struct brw_vs_prog_key *key,
+           struct brw_vs_prog_data *prog_data,
+           nir_shader *shader,
+           int shader_time_index,
+           struct brw_compile_stats *stats,
+           char **error_str)
 {
    const bool is_scalar = compiler->scalar_stage[MESA_SHADER_VERTEX];
    brw_nir_apply_key(shader, compiler, &key->base, 8, is_scalar);
@@ -3026,4 +3026,46 @@ brw_compile_vs(const struct brw_compiler *compiler, void *log_data,
    return assembly;
 }
 
+const unsigned *
+brw_compile_vs(const struct brw_compiler *compiler, void *log_data,
+               void *mem_ctx,
+               const struct brw_vs_prog_key *key,
+               struct brw_vs_prog_data *prog_data,
+               nir_shader *shader,
+               int shader_time_index,
+               struct brw_compile_stats *stats,
+               char **error_str)
+{
+   /* Go through brw_compiler::compile_cache, if there is one. */
+   cache_key hash;
+   const bool use_cache =
+      shader_time_index < 0 &&
+      brw_compile_cache_compute_key(compiler, MESA_SHADER_VERTEX, key,
+                                    &prog_data->base.base, shader,
+                                    NULL, 0, hash);
+
+   struct brw_compile_stats cache_stats;
+   if (use_cache) {
+      const unsigned *assembly =
+         brw_compile_cache_search(compiler, mem_ctx, MESA_SHADER_VERTEX,
+                                  hash, &prog_data->base.base, stats);
+      if (assembly)
+         return assembly;
+
+      if (stats == NULL)
+         stats = &cache_stats;
+   }
+
+   const unsigned *assembly =
+      compile_vs(compiler, log_data, mem_ctx, key, prog_data, shader,
+                 shader_time_index, stats, error_str);
+
+   if (use_cache && assembly) {
+      brw_compile_cache_store(compiler, MESA_SHADER_VERTEX, hash,
+                              &prog_data->base.base, assembly, stats);
+   }
+
+   return assembly;
+}
+
 } /* extern "C" */
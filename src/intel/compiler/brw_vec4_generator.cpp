@@ -2261,6 +2261,8 @@ generate_code(struct brw_codegen *p,
       stats->cycles = perf.latency;
       stats->spills = spill_count;
       stats->fills = fill_count;
+      stats->throughput = perf.throughput;
+      stats->rejected_simd = 0;
    }
 }
 
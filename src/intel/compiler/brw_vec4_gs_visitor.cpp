@@ -610,16 +610,16 @@ static const GLuint gl_prim_to_hw_prim[GL_TRIANGLE_STRIP_ADJACENCY+1] = {
    [GL_TRIANGLE_STRIP_ADJACENCY] = _3DPRIM_TRISTRIP_ADJ,
 };
 
-extern "C" const unsigned *
-brw_compile_gs(const struct brw_compiler *compiler, void *log_data,
-               void *mem_ctx,
-               const struct brw_gs_prog_key *key,
-               struct brw_gs_prog_data *prog_data,
-               nir_shader *shader,
-               struct gl_program *prog,
-               int shader_time_index,
-               struct brw_compile_stats *stats,
-               char **error_str)
+static const unsigned *
+compile_gs(const struct brw_compiler *compiler, void *log_data,
+           void *mem_ctx,
+           const struct brw_gs_prog_key *key,
+           struct brw_gs_prog_data *prog_data,
+           nir_shader *shader,
+           struct gl_program *prog,
+           int shader_time_index,
+           struct brw_compile_stats *stats,
+           char **error_str)
 {
    struct brw_gs_compile c;
    memset(&c, 0, sizeof(c));
@@ -972,5 +972,48 @@ brw_compile_gs(const struct brw_compiler *compiler, void *log_data,
    return ret;
 }
 
+extern "C" const unsigned *
+brw_compile_gs(const struct brw_compiler *compiler, void *log_data,
+               void *mem_ctx,
+               const struct brw_gs_prog_key *key,
+               struct brw_gs_prog_data *prog_data,
+               nir_shader *shader,
+               struct gl_program *prog,
+               int shader_time_index,
+               struct brw_compile_stats *stats,
+               char **error_str)
+{
+   /* Go through brw_compiler::compile_cache, if there is one. */
+   cache_key hash;
+   const bool use_cache =
+      prog == NULL && shader_time_index < 0 &&
+      brw_compile_cache_compute_key(compiler, MESA_SHADER_GEOMETRY, key,
+                                    &prog_data->base.base, shader,
+                                    NULL, 0, hash);
+
+   struct brw_compile_stats cache_stats;
+   if (use_cache) {
+      const unsigned *assembly =
+         brw_compile_cache_search(compiler, mem_ctx, MESA_SHADER_GEOMETRY,
+                                  hash, &prog_data->base.base, stats);
+      if (assembly)
+         return assembly;
+
+      if (stats == NULL)
+         stats = &cache_stats;
+   }
+
+   const unsigned *assembly =
+      compile_gs(compiler, log_data, mem_ctx, key, prog_data, shader, prog,
+                 shader_time_index, stats, error_str);
+
+   if (use_cache && assembly) {
+      brw_compile_cache_store(compiler, MESA_SHADER_GEOMETRY, hash,
+                              &prog_data->base.base, assembly, stats);
+   }
+
+   return assembly;
+}
+
 
 } /* namespace brw */
@@ -352,16 +352,16 @@ get_patch_count_threshold(int input_control_points)
    return 1;
 }
 
-extern "C" const unsigned *
-brw_compile_tcs(const struct brw_compiler *compiler,
-                void *log_data,
-                void *mem_ctx,
-                const struct brw_tcs_prog_key *key,
-                struct brw_tcs_prog_data *prog_data,
-                nir_shader *nir,
-                int shader_time_index,
-                struct brw_compile_stats *stats,
-                char **error_str)
+static const unsigned *
+compile_tcs(const struct brw_compiler *compiler,
+            void *log_data,
+            void *mem_ctx,
+            const struct brw_tcs_prog_key *key,
+            struct brw_tcs_prog_data *prog_data,
+            nir_shader *nir,
+            int shader_time_index,
+            struct brw_compile_stats *stats,
+            char **error_str)
 {
    const struct gen_device_info *devinfo = compiler->devinfo;
    struct brw_vue_prog_data *vue_prog_data = &prog_data->base;
@@ -506,5 +506,48 @@ brw_compile_tcs(const struct brw_compiler *compiler,
    return assembly;
 }
 
+extern "C" const unsigned *
+brw_compile_tcs(const struct brw_compiler *compiler,
+                void *log_data,
+                void *mem_ctx,
+                const struct brw_tcs_prog_key *key,
+                struct brw_tcs_prog_data *prog_data,
+                nir_shader *nir,
+                int shader_time_index,
+                struct brw_compile_stats *stats,
+                char **error_str)
+{
+   /* Go through brw_compiler::compile_cache, if there is one. */
+   cache_key hash;
+   const bool use_cache =
+      shader_time_index < 0 &&
+      brw_compile_cache_compute_key(compiler, MESA_SHADER_TESS_CTRL, key,
+                                    &prog_data->base.base, nir,
+                                    NULL, 0, hash);
+
+   struct brw_compile_stats cache_stats;
+   if (use_cache) {
+      const unsigned *assembly =
+         brw_compile_cache_search(compiler, mem_ctx, MESA_SHADER_TESS_CTRL,
+                                  hash, &prog_data->base.base, stats);
+      if (assembly)
+         return assembly;
+
+      if (stats == NULL)
+         stats = &cache_stats;
+   }
+
+   const unsigned *assembly =
+      compile_tcs(compiler, log_data, mem_ctx, key, prog_data, nir,
+                  shader_time_index, stats, error_str);
+
+   if (use_cache && assembly) {
+      brw_compile_cache_store(compiler, MESA_SHADER_TESS_CTRL, hash,
+                              &prog_data->base.base, assembly, stats);
+   }
+
+   return assembly;
+}
+
 
 } /* namespace brw */
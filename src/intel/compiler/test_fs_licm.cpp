@@ -0,0 +1,325 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include "brw_fs.h"
+#include "brw_cfg.h"
+#include "program/program.h"
+
+using namespace brw;
+
+class licm_test : public ::testing::Test {
+   virtual void SetUp();
+
+public:
+   struct brw_compiler *compiler;
+   struct gen_device_info *devinfo;
+   struct gl_context *ctx;
+   struct brw_wm_prog_data *prog_data;
+   struct gl_shader_program *shader_prog;
+   fs_visitor *v;
+};
+
+class licm_fs_visitor : public fs_visitor
+{
+public:
+   licm_fs_visitor(struct brw_compiler *compiler,
+                   struct brw_wm_prog_data *prog_data,
+                   nir_shader *shader)
+      : fs_visitor(compiler, NULL, NULL, NULL,
+                   &prog_data->base, shader, 16, -1) {}
+};
+
+
+void licm_test::SetUp()
+{
+   ctx = (struct gl_context *)calloc(1, sizeof(*ctx));
+   compiler = (struct brw_compiler *)calloc(1, sizeof(*compiler));
+   devinfo = (struct gen_device_info *)calloc(1, sizeof(*devinfo));
+   compiler->devinfo = devinfo;
+
+   prog_data = ralloc(NULL, struct brw_wm_prog_data);
+   nir_shader *shader =
+      nir_shader_create(NULL, MESA_SHADER_FRAGMENT, NULL, NULL);
+
+   v = new licm_fs_visitor(compiler, prog_data, shader);
+
+   devinfo->gen = 9;
+}
+
+static fs_inst *
+instruction(bblock_t *block, int num)
+{
+   fs_inst *inst = (fs_inst *)block->start();
+   for (int i = 0; i < num; i++) {
+      inst = (fs_inst *)inst->next;
+   }
+   return inst;
+}
+
+static bool
+loop_invariant_code_motion(fs_visitor *v)
+{
+   const bool print = false;
+
+   if (print) {
+      fprintf(stderr, "= Before =\n");
+      v->cfg->dump();
+   }
+
+   bool ret = v->opt_loop_invariant_code_motion();
+
+   if (print) {
+      fprintf(stderr, "\n= After =\n");
+      v->cfg->dump();
+   }
+
+   return ret;
+}
+
+TEST_F(licm_test, basic)
+{
+   const fs_builder &bld = v->bld;
+   fs_reg dst0 = v->vgrf(glsl_type::float_type);
+   fs_reg dst1 = v->vgrf(glsl_type::float_type);
+   fs_reg dst2 = v->vgrf(glsl_type::float_type);
+   fs_reg src0 = v->vgrf(glsl_type::float_type);
+   fs_reg src1 = v->vgrf(glsl_type::float_type);
+   bld.emit(BRW_OPCODE_DO);
+   bld.ADD(dst0, src0, src1);
+   bld.MUL(dst1, dst0, src0);
+   bld.ADD(dst2, dst2, dst1);
+   bld.emit(BRW_OPCODE_WHILE);
+
+   /* = Before =
+    *
+    * 0: do
+    * 1: add(16)       dst0  src0  src1
+    * 2: mul(16)       dst1  dst0  src0
+    * 3: add(16)       dst2  dst2  dst1
+    * 4: while
+    *
+    * = After =
+    * 0: add(16)       dst0  src0  src1
+    * 1: mul(16)       dst1  dst0  src0
+    * 2: do
+    * 3: add(16)       dst2  dst2  dst1
+    * 4: while
+    */
+
+   v->calculate_cfg();
+   const int num_blocks = v->cfg->num_blocks;
+   bblock_t *block0 = v->cfg->blocks[0];
+   bblock_t *block1 = v->cfg->blocks[1];
+
+   EXPECT_EQ(0, block0->start_ip);
+   EXPECT_EQ(0, block0->end_ip);
+   EXPECT_EQ(1, block1->start_ip);
+   EXPECT_EQ(4, block1->end_ip);
+
+   EXPECT_TRUE(loop_invariant_code_motion(v));
+
+   /* The DO is the first instruction, so a preheader block was created. */
+   EXPECT_EQ(num_blocks + 1, v->cfg->num_blocks);
+   bblock_t *preheader = v->cfg->blocks[0];
+   EXPECT_EQ(block0, v->cfg->blocks[1]);
+   EXPECT_EQ(block1, v->cfg->blocks[2]);
+   EXPECT_TRUE(preheader->is_predecessor_of(block0, bblock_link_logical));
+
+   EXPECT_EQ(0, preheader->start_ip);
+   EXPECT_EQ(1, preheader->end_ip);
+   EXPECT_EQ(2, block0->start_ip);
+   EXPECT_EQ(2, block0->end_ip);
+   EXPECT_EQ(3, block1->start_ip);
+   EXPECT_EQ(4, block1->end_ip);
+   EXPECT_EQ(BRW_OPCODE_ADD, instruction(preheader, 0)->opcode);
+   EXPECT_EQ(BRW_OPCODE_MUL, instruction(preheader, 1)->opcode);
+   EXPECT_EQ(BRW_OPCODE_DO, instruction(block0, 0)->opcode);
+   EXPECT_EQ(BRW_OPCODE_ADD, instruction(block1, 0)->opcode);
+   EXPECT_EQ(BRW_OPCODE_WHILE, instruction(block1, 1)->opcode);
+}
+
+TEST_F(licm_test, existing_preheader)
+{
+   const fs_builder &bld = v->bld;
+   fs_reg dst0 = v->vgrf(glsl_type::float_type);
+   fs_reg dst1 = v->vgrf(glsl_type::float_type);
+   fs_reg src0 = v->vgrf(glsl_type::float_type);
+   fs_reg src1 = v->vgrf(glsl_type::float_type);
+   bld.MOV(src0, src1);
+   bld.emit(BRW_OPCODE_DO);
+   bld.ADD(dst0, src0, src1);
+   bld.ADD(dst1, dst1, dst0);
+   bld.emit(BRW_OPCODE_WHILE);
+
+   /* = Before =
+    *
+    * 0: mov(16)       src0  src1
+    * 1: do
+    * 2: add(16)       dst0  src0  src1
+    * 3: add(16)       dst1  dst1  dst0
+    * 4: while
+    *
+    * = After =
+    * 0: mov(16)       src0  src1
+    * 1: add(16)       dst0  src0  src1
+    * 2: do
+    * 3: add(16)       dst1  dst1  dst0
+    * 4: while
+    */
+
+   v->calculate_cfg();
+   const int num_blocks = v->cfg->num_blocks;
+   bblock_t *block0 = v->cfg->blocks[0];
+   bblock_t *block1 = v->cfg->blocks[1];
+   bblock_t *block2 = v->cfg->blocks[2];
+
+   EXPECT_TRUE(loop_invariant_code_motion(v));
+   EXPECT_EQ(num_blocks, v->cfg->num_blocks);
+   EXPECT_EQ(0, block0->start_ip);
+   EXPECT_EQ(1, block0->end_ip);
+   EXPECT_EQ(2, block1->start_ip);
+   EXPECT_EQ(2, block1->end_ip);
+   EXPECT_EQ(3, block2->start_ip);
+   EXPECT_EQ(4, block2->end_ip);
+   EXPECT_EQ(BRW_OPCODE_MOV, instruction(block0, 0)->opcode);
+   EXPECT_EQ(BRW_OPCODE_ADD, instruction(block0, 1)->opcode);
+   EXPECT_EQ(BRW_OPCODE_DO, instruction(block1, 0)->opcode);
+}
+
+TEST_F(licm_test, source_written_in_loop)
+{
+   const fs_builder &bld = v->bld;
+   fs_reg dst0 = v->vgrf(glsl_type::float_type);
+   fs_reg src0 = v->vgrf(glsl_type::float_type);
+   fs_reg src1 = v->vgrf(glsl_type::float_type);
+   bld.emit(BRW_OPCODE_DO);
+   bld.ADD(dst0, src0, src1);
+   bld.MOV(src0, dst0);
+   bld.emit(BRW_OPCODE_WHILE);
+
+   /* = Before =
+    *
+    * 0: do
+    * 1: add(16)       dst0  src0  src1
+    * 2: mov(16)       src0  dst0
+    * 3: while
+    *
+    * = After =
+    * (no changes)
+    */
+
+   v->calculate_cfg();
+   bblock_t *block0 = v->cfg->blocks[0];
+   bblock_t *block1 = v->cfg->blocks[1];
+
+   EXPECT_FALSE(loop_invariant_code_motion(v));
+   EXPECT_EQ(0, block0->start_ip);
+   EXPECT_EQ(0, block0->end_ip);
+   EXPECT_EQ(1, block1->start_ip);
+   EXPECT_EQ(3, block1->end_ip);
+}
+
+TEST_F(licm_test, multiple_definitions)
+{
+   const fs_builder &bld = v->bld;
+   fs_reg dst0 = v->vgrf(glsl_type::float_type);
+   fs_reg src0 = v->vgrf(glsl_type::float_type);
+   fs_reg src1 = v->vgrf(glsl_type::float_type);
+   bld.MOV(dst0, src0);
+   bld.emit(BRW_OPCODE_DO);
+   bld.ADD(dst0, src0, src1);
+   bld.emit(BRW_OPCODE_WHILE);
+   bld.MOV(src1, dst0);
+
+   /* = Before =
+    *
+    * 0: mov(16)       dst0  src0
+    * 1: do
+    * 2: add(16)       dst0  src0  src1
+    * 3: while
+    * 4: mov(16)       src1  dst0
+    *
+    * = After =
+    * (no changes)
+    */
+
+   v->calculate_cfg();
+
+   EXPECT_FALSE(loop_invariant_code_motion(v));
+}
+
+TEST_F(licm_test, inside_if)
+{
+   const fs_builder &bld = v->bld;
+   fs_reg dst0 = v->vgrf(glsl_type::float_type);
+   fs_reg src0 = v->vgrf(glsl_type::float_type);
+   fs_reg src1 = v->vgrf(glsl_type::float_type);
+   bld.emit(BRW_OPCODE_DO);
+   bld.emit(BRW_OPCODE_IF)->predicate = BRW_PREDICATE_NORMAL;
+   bld.ADD(dst0, src0, src1);
+   bld.emit(BRW_OPCODE_ENDIF);
+   bld.emit(BRW_OPCODE_WHILE);
+
+   /* = Before =
+    *
+    * 0: do
+    * 1: (+f0) if
+    * 2: add(16)       dst0  src0  src1
+    * 3: endif
+    * 4: while
+    *
+    * = After =
+    * (no changes)
+    */
+
+   v->calculate_cfg();
+
+   EXPECT_FALSE(loop_invariant_code_motion(v));
+}
+
+TEST_F(licm_test, predicated_instruction)
+{
+   const fs_builder &bld = v->bld;
+   fs_reg dst0 = v->vgrf(glsl_type::float_type);
+   fs_reg src0 = v->vgrf(glsl_type::float_type);
+   fs_reg src1 = v->vgrf(glsl_type::float_type);
+   bld.emit(BRW_OPCODE_DO);
+   bld.ADD(dst0, src0, src1)
+      ->predicate = BRW_PREDICATE_NORMAL;
+   bld.emit(BRW_OPCODE_WHILE);
+
+   /* = Before =
+    *
+    * 0: do
+    * 1: (+f0) add(16) dst0  src0  src1
+    * 2: while
+    *
+    * = After =
+    * (no changes)
+    */
+
+   v->calculate_cfg();
+
+   EXPECT_FALSE(loop_invariant_code_motion(v));
+}
@@ -35,6 +35,7 @@
 #include "isl_gen9.h"
 #include "isl_gen12.h"
 #include "isl_priv.h"
+#include "util/u_cpu_detect.h"
 
 void
 isl_memcpy_linear_to_tiled(uint32_t xt1, uint32_t xt2,
@@ -47,6 +48,23 @@ isl_memcpy_linear_to_tiled(uint32_t xt1, uint32_t xt2,
 {
 #ifdef USE_SSE41
    if (copy_type == ISL_MEMCPY_STREAMING_LOAD) {
+      util_cpu_detect();
+#ifdef USE_AVX512
+      if (util_cpu_caps.has_avx512f) {
+         _isl_memcpy_linear_to_tiled_avx512(
+            xt1, xt2, yt1, yt2, dst, src, dst_pitch, src_pitch, has_swizzling,
+            tiling, copy_type);
+         return;
+      }
+#endif
+#ifdef USE_AVX2
+      if (util_cpu_caps.has_avx2) {
+         _isl_memcpy_linear_to_tiled_avx2(
+            xt1, xt2, yt1, yt2, dst, src, dst_pitch, src_pitch, has_swizzling,
+            tiling, copy_type);
+         return;
+      }
+#endif
       _isl_memcpy_linear_to_tiled_sse41(
          xt1, xt2, yt1, yt2, dst, src, dst_pitch, src_pitch, has_swizzling,
          tiling, copy_type);
@@ -70,6 +88,23 @@ isl_memcpy_tiled_to_linear(uint32_t xt1, uint32_t xt2,
 {
 #ifdef USE_SSE41
    if (copy_type == ISL_MEMCPY_STREAMING_LOAD) {
+      util_cpu_detect();
+#ifdef USE_AVX512
+      if (util_cpu_caps.has_avx512f) {
+         _isl_memcpy_tiled_to_linear_avx512(
+            xt1, xt2, yt1, yt2, dst, src, dst_pitch, src_pitch, has_swizzling,
+            tiling, copy_type);
+         return;
+      }
+#endif
+#ifdef USE_AVX2
+      if (util_cpu_caps.has_avx2) {
+         _isl_memcpy_tiled_to_linear_avx2(
+            xt1, xt2, yt1, yt2, dst, src, dst_pitch, src_pitch, has_swizzling,
+            tiling, copy_type);
+         return;
+      }
+#endif
       _isl_memcpy_tiled_to_linear_sse41(
          xt1, xt2, yt1, yt2, dst, src, dst_pitch, src_pitch, has_swizzling,
          tiling, copy_type);
@@ -0,0 +1,296 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "common/gen_gem.h"
+
+#include "dev/gen_debug.h"
+#include "dev/gen_device_info.h"
+
+#include "perf/gen_perf.h"
+#include "perf/gen_perf_private.h"
+#include "perf/gen_perf_stream.h"
+
+#include "drm-uapi/i915_drm.h"
+
+#include "c11/threads.h"
+#include "util/u_atomic.h"
+
+#define FILE_DEBUG_FLAG DEBUG_PERFMON
+
+/* Largest OA report we can be handed, in dwords. */
+#define MAX_OA_REPORT_DWORDS 64
+
+struct gen_perf_stream {
+   const struct gen_perf_query_info *query;
+   int fd;
+
+   thrd_t thread;
+   bool quit;
+
+   /* Only used by the thread. */
+   uint32_t last_report[MAX_OA_REPORT_DWORDS];
+   bool has_last_report;
+
+   /* Protects everything below. */
+   mtx_t mutex;
+
+   /* Counters accumulated since the end of the last frame. */
+   struct gen_perf_query_result current;
+
+   /* Ring of the last frames. */
+   struct gen_perf_query_result *frames;
+   unsigned n_frames;
+   unsigned first_frame;
+   unsigned frame_count;
+};
+
+static void
+accumulate_records(struct gen_perf_stream *stream,
+                   const uint8_t *buf, int len)
+{
+   int offset = 0;
+
+   mtx_lock(&stream->mutex);
+
+   while (offset < len) {
+      const struct drm_i915_perf_record_header *header =
+         (const struct drm_i915_perf_record_header *) &buf[offset];
+      const uint32_t *report = (const uint32_t *) (header + 1);
+      const unsigned report_dwords =
+         (header->size - sizeof(*header)) / sizeof(uint32_t);
+
+      if (header->size == 0) {
+         DBG("Spurious empty i915 perf record\n");
+         break;
+      }
+
+      switch (header->type) {
+      case DRM_I915_PERF_RECORD_SAMPLE:
+         if (report_dwords > MAX_OA_REPORT_DWORDS)
+            break;
+
+         if (stream->has_last_report) {
+            gen_perf_query_result_accumulate(&stream->current, stream->query,
+                                             stream->last_report, report);
+         }
+         memcpy(stream->last_report, report, report_dwords * sizeof(uint32_t));
+         stream->has_last_report = true;
+         break;
+
+      case DRM_I915_PERF_RECORD_OA_BUFFER_LOST:
+      case DRM_I915_PERF_RECORD_OA_REPORT_LOST:
+         /* We can't compute deltas across the lost reports. */
+         DBG("i915 perf: OA reports lost\n");
+         stream->has_last_report = false;
+         stream->current.query_disjoint = true;
+         break;
+
+      default:
+         break;
+      }
+
+      offset += header->size;
+   }
+
+   mtx_unlock(&stream->mutex);
+}
+
+static int
+stream_thread(void *data)
+{
+   struct gen_perf_stream *stream = data;
+   uint8_t buf[32 * 1024];
+
+   while (!p_atomic_read(&stream->quit)) {
+      struct pollfd pollfd = {
+         .fd = stream->fd,
+         .events = POLLIN,
+      };
+      int len;
+
+      /* Wake up regularly to check whether we're asked to quit. */
+      if (poll(&pollfd, 1, 100) <= 0)
+         continue;
+
+      while ((len = read(stream->fd, buf, sizeof(buf))) < 0 && errno == EINTR)
+         ;
+
+      if (len < 0) {
+         if (errno != EAGAIN)
+            DBG("Error reading i915 perf samples: %m\n");
+         continue;
+      }
+
+      accumulate_records(stream, buf, len);
+   }
+
+   return 0;
+}
+
+static int
+period_exponent(const struct gen_device_info *devinfo, uint64_t period_ns)
+{
+   /* sample_period = timestamp_period * 2^(period_exponent + 1), see
+    * gen_perf_begin_query().
+    */
+   for (int e = 0; e < 31; e++) {
+      if (1000000000ull * (2ull << e) / devinfo->timestamp_frequency >= period_ns)
+         return e;
+   }
+
+   return 31;
+}
+
+struct gen_perf_stream *
+gen_perf_stream_open(struct gen_perf_config *perf_cfg,
+                     const struct gen_device_info *devinfo,
+                     int drm_fd, uint32_t hw_ctx,
+                     const struct gen_perf_query_info *query,
+                     uint64_t period_ns,
+                     unsigned n_frames)
+{
+   struct gen_perf_stream *stream;
+
+   if (query->kind != GEN_PERF_QUERY_TYPE_OA || query->oa_metrics_set_id == 0 ||
+       n_frames == 0)
+      return NULL;
+
+   stream = calloc(1, sizeof(*stream));
+   if (!stream)
+      return NULL;
+
+   stream->frames = calloc(n_frames, sizeof(*stream->frames));
+   if (!stream->frames) {
+      free(stream);
+      return NULL;
+   }
+
+   stream->query = query;
+   stream->n_frames = n_frames;
+   gen_perf_query_result_clear(&stream->current);
+
+   uint64_t properties[DRM_I915_PERF_PROP_MAX * 2];
+   int p = 0;
+
+   properties[p++] = DRM_I915_PERF_PROP_SAMPLE_OA;
+   properties[p++] = true;
+
+   properties[p++] = DRM_I915_PERF_PROP_OA_METRICS_SET;
+   properties[p++] = query->oa_metrics_set_id;
+
+   properties[p++] = DRM_I915_PERF_PROP_OA_FORMAT;
+   properties[p++] = query->oa_format;
+
+   properties[p++] = DRM_I915_PERF_PROP_OA_EXPONENT;
+   properties[p++] = period_exponent(devinfo, period_ns);
+
+   if (hw_ctx) {
+      properties[p++] = DRM_I915_PERF_PROP_CTX_HANDLE;
+      properties[p++] = hw_ctx;
+   }
+
+   if (perf_cfg->i915_perf_version >= 4) {
+      properties[p++] = DRM_I915_PERF_PROP_GLOBAL_SSEU;
+      properties[p++] = to_user_pointer(&perf_cfg->sseu);
+   }
+
+   struct drm_i915_perf_open_param param = {
+      .flags = I915_PERF_FLAG_FD_CLOEXEC |
+               I915_PERF_FLAG_FD_NONBLOCK,
+      .num_properties = p / 2,
+      .properties_ptr = (uintptr_t) properties,
+   };
+   stream->fd = gen_ioctl(drm_fd, DRM_IOCTL_I915_PERF_OPEN, &param);
+   if (stream->fd == -1) {
+      DBG("Error opening gen perf OA stream: %m\n");
+      free(stream->frames);
+      free(stream);
+      return NULL;
+   }
+
+   mtx_init(&stream->mutex, mtx_plain);
+
+   if (thrd_create(&stream->thread, stream_thread, stream) != thrd_success) {
+      mtx_destroy(&stream->mutex);
+      close(stream->fd);
+      free(stream->frames);
+      free(stream);
+      return NULL;
+   }
+
+   return stream;
+}
+
+void
+gen_perf_stream_close(struct gen_perf_stream *stream)
+{
+   p_atomic_set(&stream->quit, true);
+   thrd_join(stream->thread, NULL);
+
+   mtx_destroy(&stream->mutex);
+   close(stream->fd);
+   free(stream->frames);
+   free(stream);
+}
+
+void
+gen_perf_stream_end_frame(struct gen_perf_stream *stream)
+{
+   mtx_lock(&stream->mutex);
+
+   unsigned idx = (stream->first_frame + stream->frame_count) % stream->n_frames;
+   if (stream->frame_count == stream->n_frames)
+      stream->first_frame = (stream->first_frame + 1) % stream->n_frames;
+   else
+      stream->frame_count++;
+
+   stream->frames[idx] = stream->current;
+   gen_perf_query_result_clear(&stream->current);
+
+   mtx_unlock(&stream->mutex);
+}
+
+bool
+gen_perf_stream_read_frame(struct gen_perf_stream *stream,
+                           struct gen_perf_query_result *result)
+{
+   bool ret = false;
+
+   mtx_lock(&stream->mutex);
+
+   if (stream->frame_count > 0) {
+      *result = stream->frames[stream->first_frame];
+      stream->first_frame = (stream->first_frame + 1) % stream->n_frames;
+      stream->frame_count--;
+      ret = true;
+   }
+
+   mtx_unlock(&stream->mutex);
+
+   return ret;
+}
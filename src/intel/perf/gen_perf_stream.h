@@ -0,0 +1,73 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef GEN_PERF_STREAM_H
+#define GEN_PERF_STREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct gen_device_info;
+
+struct gen_perf_config;
+struct gen_perf_query_info;
+struct gen_perf_query_result;
+struct gen_perf_stream;
+
+/**
+ * Continuous sampling of an OA metric set.
+ *
+ * The OA unit writes a report every period, which a background thread reads
+ * and accumulates, so that the caller only has to mark the end of its frames
+ * with gen_perf_stream_end_frame().  The accumulated counters of the last
+ * frames are kept in a ring and can be read with
+ * gen_perf_stream_read_frame(), e.g. by an overlay or a monitoring thread,
+ * and turned into counter values with the oa_counter_read_* callbacks of
+ * the metric set, like query results.
+ *
+ * With hw_ctx = 0, the stream samples the whole system, which requires
+ * the dev.i915.perf_stream_paranoid sysctl to be 0 or CAP_SYS_ADMIN.
+ */
+struct gen_perf_stream *
+gen_perf_stream_open(struct gen_perf_config *perf_cfg,
+                     const struct gen_device_info *devinfo,
+                     int drm_fd, uint32_t hw_ctx,
+                     const struct gen_perf_query_info *query,
+                     uint64_t period_ns,
+                     unsigned n_frames);
+
+void gen_perf_stream_close(struct gen_perf_stream *stream);
+
+/**
+ * Push the counters accumulated since the previous call in the ring of
+ * frames, dropping the oldest frame if it's full.
+ */
+void gen_perf_stream_end_frame(struct gen_perf_stream *stream);
+
+/**
+ * Pop the oldest frame from the ring.  Returns false if it's empty.
+ */
+bool gen_perf_stream_read_frame(struct gen_perf_stream *stream,
+                                struct gen_perf_query_result *result);
+
+#endif /* GEN_PERF_STREAM_H */
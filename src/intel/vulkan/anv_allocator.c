@@ -314,16 +314,15 @@ anv_state_table_add(struct anv_state_table *table, uint32_t *idx,
    }
 }
 
-void
-anv_free_list_push(union anv_free_list *list,
-                   struct anv_state_table *table,
-                   uint32_t first, uint32_t count)
+/* Pushes the entries first to last, already linked together through their
+ * next fields.
+ */
+static void
+anv_free_list_push_chain(union anv_free_list *list,
+                         struct anv_state_table *table,
+                         uint32_t first, uint32_t last)
 {
    union anv_free_list current, old, new;
-   uint32_t last = first;
-
-   for (uint32_t i = 1; i < count; i++, last++)
-      table->map[last].next = last + 1;
 
    old = *list;
    do {
@@ -335,6 +334,19 @@ anv_free_list_push(union anv_free_list *list,
    } while (old.u64 != current.u64);
 }
 
+void
+anv_free_list_push(union anv_free_list *list,
+                   struct anv_state_table *table,
+                   uint32_t first, uint32_t count)
+{
+   uint32_t last = first;
+
+   for (uint32_t i = 1; i < count; i++, last++)
+      table->map[last].next = last + 1;
+
+   anv_free_list_push_chain(list, table, first, last);
+}
+
 struct anv_state *
 anv_free_list_pop(union anv_free_list *list,
                   struct anv_state_table *table)
@@ -1186,6 +1198,80 @@ struct anv_state_stream_block {
 #endif
 };
 
+void
+anv_state_cache_init(struct anv_state_cache *cache,
+                     struct anv_state_pool *pool, uint32_t size)
+{
+   assert(util_is_power_of_two_nonzero(size) && size >= PAGE_SIZE);
+
+   cache->pool = pool;
+   cache->size = size;
+   cache->count = 0;
+}
+
+/* Returns the first count cached states to the pool in one go. */
+static void
+anv_state_cache_flush(struct anv_state_cache *cache, uint32_t count)
+{
+   struct anv_state_pool *pool = cache->pool;
+   unsigned bucket = anv_state_pool_get_bucket(cache->size);
+
+   if (count == 0)
+      return;
+
+   for (uint32_t i = 0; i + 1 < count; i++)
+      pool->table.map[cache->states[i].idx].next = cache->states[i + 1].idx;
+
+   anv_free_list_push_chain(&pool->buckets[bucket].free_list, &pool->table,
+                            cache->states[0].idx,
+                            cache->states[count - 1].idx);
+
+   cache->count -= count;
+   memmove(cache->states, cache->states + count,
+           cache->count * sizeof(cache->states[0]));
+}
+
+void
+anv_state_cache_finish(struct anv_state_cache *cache)
+{
+   anv_state_cache_flush(cache, cache->count);
+}
+
+static struct anv_state
+anv_state_cache_alloc(struct anv_state_cache *cache)
+{
+   if (cache->count == 0) {
+      struct anv_state_pool *pool = cache->pool;
+      unsigned bucket = anv_state_pool_get_bucket(cache->size);
+      struct anv_state *state;
+
+      /* Take a batch of free states while the free list's cache line is
+       * ours anyway.
+       */
+      while (cache->count < ANV_STATE_CACHE_SIZE / 2 &&
+             (state = anv_free_list_pop(&pool->buckets[bucket].free_list,
+                                        &pool->table)))
+         cache->states[cache->count++] = *state;
+
+      if (cache->count == 0)
+         return anv_state_pool_alloc_no_vg(pool, cache->size, PAGE_SIZE);
+   }
+
+   return cache->states[--cache->count];
+}
+
+static void
+anv_state_cache_free(struct anv_state_cache *cache, struct anv_state state)
+{
+   assert(state.alloc_size == cache->size);
+   assert(state.offset >= cache->pool->start_offset);
+
+   if (cache->count == ANV_STATE_CACHE_SIZE)
+      anv_state_cache_flush(cache, ANV_STATE_CACHE_SIZE / 2);
+
+   cache->states[cache->count++] = state;
+}
+
 /* The state stream allocator is a one-shot, single threaded allocator for
  * variable sized blocks.  We use it for allocating dynamic state.
  */
@@ -1195,6 +1281,7 @@ anv_state_stream_init(struct anv_state_stream *stream,
                       uint32_t block_size)
 {
    stream->state_pool = state_pool;
+   stream->cache = NULL;
    stream->block_size = block_size;
 
    stream->block = ANV_STATE_NULL;
@@ -1209,13 +1296,27 @@ anv_state_stream_init(struct anv_state_stream *stream,
    VG(VALGRIND_CREATE_MEMPOOL(stream, 0, false));
 }
 
+/* Same as anv_state_stream_init(), with blocks of the cache's size going
+ * through the cache.
+ */
+void
+anv_state_stream_init_cached(struct anv_state_stream *stream,
+                             struct anv_state_cache *cache)
+{
+   anv_state_stream_init(stream, cache->pool, cache->size);
+   stream->cache = cache;
+}
+
 void
 anv_state_stream_finish(struct anv_state_stream *stream)
 {
    util_dynarray_foreach(&stream->all_blocks, struct anv_state, block) {
       VG(VALGRIND_MEMPOOL_FREE(stream, block->map));
       VG(VALGRIND_MAKE_MEM_NOACCESS(block->map, block->alloc_size));
-      anv_state_pool_free_no_vg(stream->state_pool, *block);
+      if (stream->cache && block->alloc_size == stream->cache->size)
+         anv_state_cache_free(stream->cache, *block);
+      else
+         anv_state_pool_free_no_vg(stream->state_pool, *block);
    }
    util_dynarray_fini(&stream->all_blocks);
 
@@ -1237,8 +1338,12 @@ anv_state_stream_alloc(struct anv_state_stream *stream,
       if (block_size < size)
          block_size = round_to_power_of_two(size);
 
-      stream->block = anv_state_pool_alloc_no_vg(stream->state_pool,
-                                                 block_size, PAGE_SIZE);
+      if (stream->cache && block_size == stream->cache->size) {
+         stream->block = anv_state_cache_alloc(stream->cache);
+      } else {
+         stream->block = anv_state_pool_alloc_no_vg(stream->state_pool,
+                                                    block_size, PAGE_SIZE);
+      }
       util_dynarray_append(&stream->all_blocks,
                            struct anv_state, stream->block);
       VG(VALGRIND_MAKE_MEM_NOACCESS(stream->block.map, block_size));
@@ -1256,6 +1256,161 @@ anv_execbuf_add_bo_bitset(struct anv_device *device,
    return VK_SUCCESS;
 }
 
+static VkResult
+anv_residency_set_add_bo(struct anv_device *device,
+                         struct anv_residency_set *set,
+                         struct anv_bo *bo)
+{
+   bo = anv_bo_unwrap(bo);
+
+   /* Several memory objects may share an imported BO. */
+   if (bo->index < set->count && set->bos[bo->index] == bo)
+      return VK_SUCCESS;
+
+   if (set->count >= set->array_length) {
+      uint32_t new_len = MAX2(64, set->array_length * 2);
+
+      struct drm_i915_gem_exec_object2 *new_objects =
+         vk_realloc(&device->vk.alloc, set->objects,
+                    new_len * sizeof(*new_objects), 8,
+                    VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+      if (new_objects == NULL)
+         return vk_error(VK_ERROR_OUT_OF_HOST_MEMORY);
+      set->objects = new_objects;
+
+      struct anv_bo **new_bos =
+         vk_realloc(&device->vk.alloc, set->bos,
+                    new_len * sizeof(*new_bos), 8,
+                    VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+      if (new_bos == NULL)
+         return vk_error(VK_ERROR_OUT_OF_HOST_MEMORY);
+      set->bos = new_bos;
+
+      set->array_length = new_len;
+   }
+
+   bo->index = set->count++;
+   set->bos[bo->index] = bo;
+   set->objects[bo->index] = (struct drm_i915_gem_exec_object2) {
+      .handle = bo->gem_handle,
+      .offset = bo->offset,
+      .flags = bo->flags,
+   };
+
+   return VK_SUCCESS;
+}
+
+static uint32_t
+anv_residency_set_pool_bo_count(struct anv_device *device)
+{
+   return device->surface_state_pool.block_pool.nbos +
+          device->dynamic_state_pool.block_pool.nbos +
+          device->instruction_state_pool.block_pool.nbos +
+          device->binding_table_pool.block_pool.nbos;
+}
+
+/* Brings the residency set up to date, walking the state pools and memory
+ * objects only if one of them changed since the last submission.
+ */
+static VkResult
+anv_residency_set_update(struct anv_device *device)
+{
+   struct anv_residency_set *set = &device->residency;
+   const uint32_t pool_bo_count = anv_residency_set_pool_bo_count(device);
+   VkResult result;
+
+   if (set->memory_objects_generation == device->memory_objects_generation &&
+       set->pool_bo_count == pool_bo_count) {
+      if (!set->bo_index_valid) {
+         for (uint32_t i = 0; i < set->count; i++)
+            set->bos[i]->index = i;
+         set->bo_index_valid = true;
+      }
+      return VK_SUCCESS;
+   }
+
+   /* Block pools only ever grow, so if one of them does while we walk it,
+    * the count read above just makes the next submission rebuild the set.
+    */
+   set->count = 0;
+   set->memory_objects_generation = 0;
+   set->bo_index_valid = false;
+
+   struct anv_block_pool *pools[] = {
+      &device->surface_state_pool.block_pool,
+      &device->dynamic_state_pool.block_pool,
+      &device->instruction_state_pool.block_pool,
+      &device->binding_table_pool.block_pool,
+   };
+   for (uint32_t i = 0; i < ARRAY_SIZE(pools); i++) {
+      anv_block_pool_foreach_bo(bo, pools[i]) {
+         result = anv_residency_set_add_bo(device, set, bo);
+         if (result != VK_SUCCESS)
+            return result;
+      }
+   }
+
+   list_for_each_entry(struct anv_device_memory, mem,
+                       &device->memory_objects, link) {
+      result = anv_residency_set_add_bo(device, set, mem->bo);
+      if (result != VK_SUCCESS)
+         return result;
+   }
+
+   set->memory_objects_generation = device->memory_objects_generation;
+   set->pool_bo_count = pool_bo_count;
+   set->bo_index_valid = true;
+
+   return VK_SUCCESS;
+}
+
+/* Puts the residency set at the start of an empty execbuf.  Because the BOs
+ * keep their position in the set as their index, this is two memcpy()s and
+ * later anv_execbuf_add_bo() calls still find them.
+ */
+static VkResult
+anv_execbuf_add_residency_set(struct anv_device *device,
+                              struct anv_execbuf *exec)
+{
+   struct anv_residency_set *set = &device->residency;
+
+   assert(exec->bo_count == 0 && exec->objects == NULL);
+
+   VkResult result = anv_residency_set_update(device);
+   if (result != VK_SUCCESS)
+      return result;
+
+   /* Leave some room for the batch BOs and whatever else the submission
+    * references.
+    */
+   uint32_t new_len = set->count + 64;
+
+   exec->objects = vk_alloc(exec->alloc, new_len * sizeof(*exec->objects),
+                            8, exec->alloc_scope);
+   if (exec->objects == NULL)
+      return vk_error(VK_ERROR_OUT_OF_HOST_MEMORY);
+
+   exec->bos = vk_alloc(exec->alloc, new_len * sizeof(*exec->bos),
+                        8, exec->alloc_scope);
+   if (exec->bos == NULL)
+      return vk_error(VK_ERROR_OUT_OF_HOST_MEMORY);
+
+   exec->array_length = new_len;
+
+   memcpy(exec->objects, set->objects, set->count * sizeof(*exec->objects));
+   memcpy(exec->bos, set->bos, set->count * sizeof(*exec->bos));
+   exec->bo_count = set->count;
+
+   return VK_SUCCESS;
+}
+
+void
+anv_residency_set_finish(struct anv_device *device)
+{
+   vk_free(&device->vk.alloc, device->residency.objects);
+   vk_free(&device->vk.alloc, device->residency.bos);
+}
+
 static void
 anv_cmd_buffer_process_relocs(struct anv_cmd_buffer *cmd_buffer,
                               struct anv_reloc_list *list)
@@ -1443,50 +1598,14 @@ setup_execbuf_for_cmd_buffer(struct anv_execbuf *execbuf,
                                       cmd_buffer->last_ss_pool_center);
    VkResult result;
    if (cmd_buffer->device->physical->use_softpin) {
-      anv_block_pool_foreach_bo(bo, &ss_pool->block_pool) {
-         result = anv_execbuf_add_bo(cmd_buffer->device, execbuf,
-                                     bo, NULL, 0);
-         if (result != VK_SUCCESS)
-            return result;
-      }
-      /* Add surface dependencies (BOs) to the execbuf */
+      /* The state pool and memory object BOs are already in the execbuf,
+       * see anv_execbuf_add_residency_set().
+       *
+       * Add surface dependencies (BOs) to the execbuf
+       */
       anv_execbuf_add_bo_bitset(cmd_buffer->device, execbuf,
                                 cmd_buffer->surface_relocs.dep_words,
                                 cmd_buffer->surface_relocs.deps, 0);
-
-      /* Add the BOs for all memory objects */
-      list_for_each_entry(struct anv_device_memory, mem,
-                          &cmd_buffer->device->memory_objects, link) {
-         result = anv_execbuf_add_bo(cmd_buffer->device, execbuf,
-                                     mem->bo, NULL, 0);
-         if (result != VK_SUCCESS)
-            return result;
-      }
-
-      struct anv_block_pool *pool;
-      pool = &cmd_buffer->device->dynamic_state_pool.block_pool;
-      anv_block_pool_foreach_bo(bo, pool) {
-         result = anv_execbuf_add_bo(cmd_buffer->device, execbuf,
-                                     bo, NULL, 0);
-         if (result != VK_SUCCESS)
-            return result;
-      }
-
-      pool = &cmd_buffer->device->instruction_state_pool.block_pool;
-      anv_block_pool_foreach_bo(bo, pool) {
-         result = anv_execbuf_add_bo(cmd_buffer->device, execbuf,
-                                     bo, NULL, 0);
-         if (result != VK_SUCCESS)
-            return result;
-      }
-
-      pool = &cmd_buffer->device->binding_table_pool.block_pool;
-      anv_block_pool_foreach_bo(bo, pool) {
-         result = anv_execbuf_add_bo(cmd_buffer->device, execbuf,
-                                     bo, NULL, 0);
-         if (result != VK_SUCCESS)
-            return result;
-      }
    } else {
       /* Since we aren't in the softpin case, all of our STATE_BASE_ADDRESS BOs
        * will get added automatically by processing relocations on the batch
@@ -1681,11 +1800,20 @@ anv_queue_execbuf_locked(struct anv_queue *queue,
    execbuf.alloc_scope = submit->alloc_scope;
    execbuf.perf_query_pass = submit->perf_query_pass;
 
+   VkResult result;
+   if (submit->cmd_buffer && device->physical->use_softpin) {
+      result = anv_execbuf_add_residency_set(device, &execbuf);
+      if (result != VK_SUCCESS)
+         goto error;
+   } else {
+      device->residency.bo_index_valid = false;
+   }
+
    /* Always add the workaround BO as it includes a driver identifier for the
     * error_state.
     */
-   VkResult result =
-      anv_execbuf_add_bo(device, &execbuf, device->workaround_bo, NULL, 0);
+   result = anv_execbuf_add_bo(device, &execbuf, device->workaround_bo,
+                               NULL, 0);
    if (result != VK_SUCCESS)
       goto error;
 
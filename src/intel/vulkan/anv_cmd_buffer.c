@@ -236,6 +236,25 @@ anv_cmd_state_reset(struct anv_cmd_buffer *cmd_buffer)
    anv_cmd_state_init(cmd_buffer);
 }
 
+static void
+anv_cmd_buffer_init_state_streams(struct anv_cmd_buffer *cmd_buffer)
+{
+   struct anv_cmd_pool *pool = cmd_buffer->pool;
+   struct anv_device *device = cmd_buffer->device;
+
+   if (pool) {
+      anv_state_stream_init_cached(&cmd_buffer->surface_state_stream,
+                                   &pool->surface_state_cache);
+      anv_state_stream_init_cached(&cmd_buffer->dynamic_state_stream,
+                                   &pool->dynamic_state_cache);
+   } else {
+      anv_state_stream_init(&cmd_buffer->surface_state_stream,
+                            &device->surface_state_pool, 4096);
+      anv_state_stream_init(&cmd_buffer->dynamic_state_stream,
+                            &device->dynamic_state_pool, 16384);
+   }
+}
+
 static VkResult anv_create_cmd_buffer(
     struct anv_device *                         device,
     struct anv_cmd_pool *                       pool,
@@ -263,10 +282,7 @@ static VkResult anv_create_cmd_buffer(
    if (result != VK_SUCCESS)
       goto fail;
 
-   anv_state_stream_init(&cmd_buffer->surface_state_stream,
-                         &device->surface_state_pool, 4096);
-   anv_state_stream_init(&cmd_buffer->dynamic_state_stream,
-                         &device->dynamic_state_pool, 16384);
+   anv_cmd_buffer_init_state_streams(cmd_buffer);
 
    anv_cmd_state_init(cmd_buffer);
 
@@ -358,12 +374,8 @@ anv_cmd_buffer_reset(struct anv_cmd_buffer *cmd_buffer)
    anv_cmd_state_reset(cmd_buffer);
 
    anv_state_stream_finish(&cmd_buffer->surface_state_stream);
-   anv_state_stream_init(&cmd_buffer->surface_state_stream,
-                         &cmd_buffer->device->surface_state_pool, 4096);
-
    anv_state_stream_finish(&cmd_buffer->dynamic_state_stream);
-   anv_state_stream_init(&cmd_buffer->dynamic_state_stream,
-                         &cmd_buffer->device->dynamic_state_pool, 16384);
+   anv_cmd_buffer_init_state_streams(cmd_buffer);
    return VK_SUCCESS;
 }
 
@@ -1133,6 +1145,11 @@ VkResult anv_CreateCommandPool(
 
    list_inithead(&pool->cmd_buffers);
 
+   anv_state_cache_init(&pool->surface_state_cache,
+                        &device->surface_state_pool, 4096);
+   anv_state_cache_init(&pool->dynamic_state_cache,
+                        &device->dynamic_state_pool, 16384);
+
    *pCmdPool = anv_cmd_pool_to_handle(pool);
 
    return VK_SUCCESS;
@@ -1154,6 +1171,9 @@ void anv_DestroyCommandPool(
       anv_cmd_buffer_destroy(cmd_buffer);
    }
 
+   anv_state_cache_finish(&pool->surface_state_cache);
+   anv_state_cache_finish(&pool->dynamic_state_cache);
+
    vk_object_base_finish(&pool->base);
    vk_free2(&device->vk.alloc, pAllocator, pool);
 }
@@ -1178,7 +1198,11 @@ void anv_TrimCommandPool(
     VkCommandPool                               commandPool,
     VkCommandPoolTrimFlags                      flags)
 {
-   /* Nothing for us to do here.  Our pools stay pretty tidy. */
+   ANV_FROM_HANDLE(anv_cmd_pool, pool, commandPool);
+
+   /* Give the cached state blocks back to the device. */
+   anv_state_cache_finish(&pool->surface_state_cache);
+   anv_state_cache_finish(&pool->dynamic_state_cache);
 }
 
 /**
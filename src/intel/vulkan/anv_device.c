@@ -38,6 +38,7 @@
 #include "util/os_file.h"
 #include "util/os_misc.h"
 #include "util/u_atomic.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_string.h"
 #include "util/driconf.h"
 #include "git_sha1.h"
@@ -2822,6 +2823,8 @@ VkResult anv_CreateDevice(
    }
 
    list_inithead(&device->memory_objects);
+   device->memory_objects_generation = 1;
+   memset(&device->residency, 0, sizeof(device->residency));
 
    /* As per spec, the driver implementation may deny requests to acquire
     * a priority above the default priority (MEDIUM) if the caller does not
@@ -3017,6 +3020,21 @@ VkResult anv_CreateDevice(
    anv_pipeline_cache_init(&device->default_pipeline_cache, device,
                            true /* cache_enabled */, false /* external_sync */);
 
+   /* The calling thread always creates one of the pipelines, so leave it
+    * one CPU.  If the queue can't be created, pipelines are simply created
+    * one after the other.
+    */
+   util_cpu_detect();
+   const unsigned num_pipeline_threads = MIN2(util_cpu_caps.nr_cpus - 1, 8);
+   memset(&device->pipeline_create_queue, 0,
+          sizeof(device->pipeline_create_queue));
+   if (num_pipeline_threads > 0) {
+      util_queue_init(&device->pipeline_create_queue, "anv_pipe", 16,
+                      num_pipeline_threads,
+                      UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+                      UTIL_QUEUE_INIT_SHARED_CPU_LIMIT);
+   }
+
    anv_device_init_blorp(device);
 
    anv_device_init_border_colors(device);
@@ -3085,6 +3103,9 @@ void anv_DestroyDevice(
    if (!device)
       return;
 
+   if (util_queue_is_initialized(&device->pipeline_create_queue))
+      util_queue_destroy(&device->pipeline_create_queue);
+
    anv_device_finish_blorp(device);
 
    anv_pipeline_cache_finish(&device->default_pipeline_cache);
@@ -3121,6 +3142,8 @@ void anv_DestroyDevice(
 
    anv_bo_pool_finish(&device->batch_bo_pool);
 
+   anv_residency_set_finish(device);
+
    anv_bo_cache_finish(&device->bo_cache);
 
    if (device->physical->use_softpin) {
@@ -3643,6 +3666,7 @@ VkResult anv_AllocateMemory(
 
    pthread_mutex_lock(&device->mutex);
    list_addtail(&mem->link, &device->memory_objects);
+   device->memory_objects_generation++;
    pthread_mutex_unlock(&device->mutex);
 
    *pMem = anv_device_memory_to_handle(mem);
@@ -3735,6 +3759,7 @@ void anv_FreeMemory(
 
    pthread_mutex_lock(&device->mutex);
    list_del(&mem->link);
+   device->memory_objects_generation++;
    pthread_mutex_unlock(&device->mutex);
 
    if (mem->map)
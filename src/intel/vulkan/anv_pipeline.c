@@ -2388,6 +2388,27 @@ VkResult anv_GetPipelineExecutableStatisticsKHR(
       stat->value.u64 = exe->stats.fills;
    }
 
+   vk_outarray_append(&out, stat) {
+      WRITE_STR(stat->name, "Estimated Throughput");
+      WRITE_STR(stat->description,
+                "Number of invocations per cycle the compiler estimates "
+                "the generated shader executable can process.");
+      stat->format = VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_FLOAT64_KHR;
+      stat->value.f64 = exe->stats.throughput;
+   }
+
+   if (exe->stage == MESA_SHADER_FRAGMENT) {
+      vk_outarray_append(&out, stat) {
+         WRITE_STR(stat->name, "Rejected SIMD Widths");
+         WRITE_STR(stat->description,
+                   "Mask of the dispatch widths that compiled successfully "
+                   "but were dropped because they were estimated to be "
+                   "slower than the ones that were kept.");
+         stat->format = VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_UINT64_KHR;
+         stat->value.u64 = exe->stats.rejected_simd;
+      }
+   }
+
    vk_outarray_append(&out, stat) {
       WRITE_STR(stat->name, "Scratch Memory Size");
       WRITE_STR(stat->description,
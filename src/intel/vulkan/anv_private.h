@@ -58,6 +58,7 @@
 #include "util/u_atomic.h"
 #include "util/u_vector.h"
 #include "util/u_math.h"
+#include "util/u_queue.h"
 #include "util/vma.h"
 #include "util/xmlconfig.h"
 #include "vk_alloc.h"
@@ -911,9 +912,26 @@ struct anv_state_reserved_pool {
    uint32_t count;
 };
 
+#define ANV_STATE_CACHE_SIZE 16
+
+/* A small cache of free states of a single size, for use by one thread at a
+ * time.  It is refilled from and flushed to the state pool in batches, so
+ * that the pool's free lists are touched once per batch rather than once per
+ * state.
+ */
+struct anv_state_cache {
+   struct anv_state_pool *pool;
+   uint32_t size;
+   uint32_t count;
+   struct anv_state states[ANV_STATE_CACHE_SIZE];
+};
+
 struct anv_state_stream {
    struct anv_state_pool *state_pool;
 
+   /* Optional cache for blocks of block_size */
+   struct anv_state_cache *cache;
+
    /* The size of blocks to allocate from the state pool */
    uint32_t block_size;
 
@@ -952,9 +970,14 @@ struct anv_state anv_state_pool_alloc(struct anv_state_pool *pool,
                                       uint32_t state_size, uint32_t alignment);
 struct anv_state anv_state_pool_alloc_back(struct anv_state_pool *pool);
 void anv_state_pool_free(struct anv_state_pool *pool, struct anv_state state);
+void anv_state_cache_init(struct anv_state_cache *cache,
+                          struct anv_state_pool *pool, uint32_t size);
+void anv_state_cache_finish(struct anv_state_cache *cache);
 void anv_state_stream_init(struct anv_state_stream *stream,
                            struct anv_state_pool *state_pool,
                            uint32_t block_size);
+void anv_state_stream_init_cached(struct anv_state_stream *stream,
+                                  struct anv_state_cache *cache);
 void anv_state_stream_finish(struct anv_state_stream *stream);
 struct anv_state anv_state_stream_alloc(struct anv_state_stream *stream,
                                         uint32_t size, uint32_t alignment);
@@ -1316,6 +1339,31 @@ struct anv_address {
    uint32_t offset;
 };
 
+/* The BOs which every command buffer execbuf references when softpinning:
+ * those of the state pools and of all memory objects.  The list is only
+ * rebuilt when one of those changes, and is otherwise copied as is at the
+ * start of the execbuf.  Protected by the device mutex.
+ */
+struct anv_residency_set {
+   struct drm_i915_gem_exec_object2 *objects;
+   struct anv_bo **bos;
+   uint32_t count;
+   uint32_t array_length;
+
+   /* device->memory_objects_generation and the total number of state pool
+    * BOs when the list was built.
+    */
+   uint32_t memory_objects_generation;
+   uint32_t pool_bo_count;
+
+   /* Whether bo->index of every BO is still its position in the list.
+    * Building any other execbuf may reassign them.
+    */
+   bool bo_index_valid;
+};
+
+void anv_residency_set_finish(struct anv_device *device);
+
 struct anv_device {
     struct vk_device                            vk;
 
@@ -1338,6 +1386,11 @@ struct anv_device {
     /** List of all anv_device_memory objects */
     struct list_head                            memory_objects;
 
+    /** Bumped whenever memory_objects changes */
+    uint32_t                                    memory_objects_generation;
+
+    struct anv_residency_set                    residency;
+
     struct anv_bo_pool                          batch_bo_pool;
 
     struct anv_bo_cache                         bo_cache;
@@ -1366,6 +1419,11 @@ struct anv_device {
     struct anv_state                            null_surface_state;
 
     struct anv_pipeline_cache                   default_pipeline_cache;
+
+    /** Worker threads creating the pipelines of a single
+     * vkCreateGraphicsPipelines() call in parallel
+     */
+    struct util_queue                           pipeline_create_queue;
     struct blorp_context                        blorp;
 
     struct anv_state                            border_colors;
@@ -2932,6 +2990,12 @@ struct anv_cmd_pool {
    struct vk_object_base                        base;
    VkAllocationCallbacks                        alloc;
    struct list_head                             cmd_buffers;
+
+   /* Blocks for the state streams of the command buffers.  Command buffers
+    * of a pool aren't recorded concurrently, so these don't need locking.
+    */
+   struct anv_state_cache                       surface_state_cache;
+   struct anv_state_cache                       dynamic_state_cache;
 };
 
 #define ANV_CMD_BUFFER_BATCH_SIZE 8192
@@ -2491,6 +2491,93 @@ compute_pipeline_create(
    return pipeline->base.batch.status;
 }
 
+struct graphics_pipeline_create_job {
+   VkDevice device;
+   struct anv_pipeline_cache *cache;
+   const VkGraphicsPipelineCreateInfo *create_info;
+   const VkAllocationCallbacks *alloc;
+   VkPipeline *pipeline;
+
+   VkResult result;
+   struct util_queue_fence fence;
+};
+
+static void
+graphics_pipeline_create_job_execute(void *data, int thread_index)
+{
+   struct graphics_pipeline_create_job *job = data;
+
+   job->result = genX(graphics_pipeline_create)(job->device, job->cache,
+                                                job->create_info,
+                                                job->alloc, job->pipeline);
+}
+
+/* Creates all the pipelines on the device's pipeline queue, the calling
+ * thread taking the last one, and then returns what creating them one after
+ * the other would have.
+ */
+static VkResult
+create_graphics_pipelines_parallel(struct anv_device *device,
+                                   struct anv_pipeline_cache *cache,
+                                   uint32_t count,
+                                   const VkGraphicsPipelineCreateInfo *pCreateInfos,
+                                   const VkAllocationCallbacks *pAllocator,
+                                   VkPipeline *pPipelines,
+                                   struct graphics_pipeline_create_job *jobs)
+{
+   VkResult result = VK_SUCCESS;
+   bool bail_out = false;
+
+   for (uint32_t i = 0; i < count; i++) {
+      pPipelines[i] = VK_NULL_HANDLE;
+
+      jobs[i] = (struct graphics_pipeline_create_job) {
+         .device = anv_device_to_handle(device),
+         .cache = cache,
+         .create_info = &pCreateInfos[i],
+         .alloc = pAllocator,
+         .pipeline = &pPipelines[i],
+      };
+      util_queue_fence_init(&jobs[i].fence);
+
+      if (i < count - 1) {
+         util_queue_add_job(&device->pipeline_create_queue,
+                            &jobs[i], &jobs[i].fence,
+                            graphics_pipeline_create_job_execute, NULL, 0);
+      }
+   }
+
+   graphics_pipeline_create_job_execute(&jobs[count - 1], 0);
+   util_queue_fence_signal(&jobs[count - 1].fence);
+
+   for (uint32_t i = 0; i < count; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+
+      /* Pipelines after the one we bail out on have been created in the
+       * meantime, but must not be returned.
+       */
+      if (bail_out) {
+         anv_DestroyPipeline(anv_device_to_handle(device),
+                             pPipelines[i], pAllocator);
+         pPipelines[i] = VK_NULL_HANDLE;
+         continue;
+      }
+
+      if (jobs[i].result == VK_SUCCESS)
+         continue;
+
+      result = jobs[i].result;
+      pPipelines[i] = VK_NULL_HANDLE;
+
+      if (result != VK_PIPELINE_COMPILE_REQUIRED_EXT ||
+          (pCreateInfos[i].flags & VK_PIPELINE_CREATE_EARLY_RETURN_ON_FAILURE_BIT_EXT))
+         bail_out = true;
+   }
+
+   return result;
+}
+
 VkResult genX(CreateGraphicsPipelines)(
     VkDevice                                    _device,
     VkPipelineCache                             pipelineCache,
@@ -2499,10 +2586,28 @@ VkResult genX(CreateGraphicsPipelines)(
     const VkAllocationCallbacks*                pAllocator,
     VkPipeline*                                 pPipelines)
 {
+   ANV_FROM_HANDLE(anv_device, device, _device);
    ANV_FROM_HANDLE(anv_pipeline_cache, pipeline_cache, pipelineCache);
 
    VkResult result = VK_SUCCESS;
 
+   /* An externally synchronized cache can't be used from several threads. */
+   if (count > 1 &&
+       util_queue_is_initialized(&device->pipeline_create_queue) &&
+       !(pipeline_cache && pipeline_cache->external_sync)) {
+      struct graphics_pipeline_create_job *jobs =
+         vk_alloc2(&device->vk.alloc, pAllocator, count * sizeof(*jobs), 8,
+                   VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+      if (jobs) {
+         result = create_graphics_pipelines_parallel(device, pipeline_cache,
+                                                     count, pCreateInfos,
+                                                     pAllocator, pPipelines,
+                                                     jobs);
+         vk_free2(&device->vk.alloc, pAllocator, jobs);
+         return result;
+      }
+   }
+
    unsigned i;
    for (i = 0; i < count; i++) {
       VkResult res = genX(graphics_pipeline_create)(_device,
@@ -0,0 +1,110 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <pthread.h>
+
+#include "anv_private.h"
+#include "test_common.h"
+
+#define NUM_THREADS 8
+#define NUM_ROUNDS 64
+#define BLOCKS_PER_ROUND 37
+#define BLOCK_SIZE 4096
+
+struct job {
+   struct anv_state_pool *pool;
+   unsigned id;
+   pthread_t thread;
+} jobs[NUM_THREADS];
+
+pthread_barrier_t barrier;
+
+/* Each thread records streams through its own cache, like command buffers
+ * of different command pools, and checks that no other thread got the same
+ * blocks.
+ */
+static void *stream_blocks(void *void_job)
+{
+   struct job *job = void_job;
+   struct anv_state_cache cache;
+   struct anv_state states[BLOCKS_PER_ROUND];
+
+   anv_state_cache_init(&cache, job->pool, BLOCK_SIZE);
+
+   pthread_barrier_wait(&barrier);
+
+   for (unsigned r = 0; r < NUM_ROUNDS; r++) {
+      struct anv_state_stream stream;
+
+      anv_state_stream_init_cached(&stream, &cache);
+
+      for (unsigned i = 0; i < BLOCKS_PER_ROUND; i++) {
+         states[i] = anv_state_stream_alloc(&stream, BLOCK_SIZE, 64);
+         ASSERT(states[i].offset != 0);
+         memset(states[i].map, job->id + 1, BLOCK_SIZE);
+      }
+
+      for (unsigned i = 0; i < BLOCKS_PER_ROUND; i++) {
+         const uint8_t *map = states[i].map;
+         for (unsigned j = 0; j < BLOCK_SIZE; j += 512)
+            ASSERT(map[j] == job->id + 1);
+      }
+
+      anv_state_stream_finish(&stream);
+   }
+
+   anv_state_cache_finish(&cache);
+   ASSERT(cache.count == 0);
+
+   return NULL;
+}
+
+int main(void)
+{
+   struct anv_physical_device physical_device = { };
+   struct anv_device device = {
+      .physical = &physical_device,
+   };
+   struct anv_state_pool state_pool;
+
+   pthread_mutex_init(&device.mutex, NULL);
+   anv_bo_cache_init(&device.bo_cache);
+   anv_state_pool_init(&state_pool, &device, 4096, 0, 4096);
+
+   /* Grab one so a zero offset is impossible */
+   anv_state_pool_alloc(&state_pool, 16, 16);
+
+   pthread_barrier_init(&barrier, NULL, NUM_THREADS);
+
+   for (unsigned i = 0; i < NUM_THREADS; i++) {
+      jobs[i].pool = &state_pool;
+      jobs[i].id = i;
+      pthread_create(&jobs[i].thread, NULL, stream_blocks, &jobs[i]);
+   }
+
+   for (unsigned i = 0; i < NUM_THREADS; i++)
+      pthread_join(jobs[i].thread, NULL);
+
+   anv_state_pool_finish(&state_pool);
+   pthread_mutex_destroy(&device.mutex);
+}
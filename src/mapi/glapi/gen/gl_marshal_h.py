@@ -60,7 +60,7 @@ class PrintCode(gl_XML.gl_print_base):
         print('{')
         for func in api.functionIterateAll():
             flavor = func.marshal_flavor()
-            if flavor in ('skip', 'sync'):
+            if flavor in ('skip', 'sync', 'custom_sync'):
                 continue
             print('   DISPATCH_CMD_{0},'.format(func.name))
         print('   NUM_DISPATCH_CMD,')
@@ -74,7 +74,7 @@ class PrintCode(gl_XML.gl_print_base):
                 print(('void _mesa_unmarshal_{0}(struct gl_context *ctx, '
                        'const struct marshal_cmd_{0} *cmd);').format(func.name))
                 print('void GLAPIENTRY _mesa_marshal_{0}({1});'.format(func.name, func.get_parameter_string()))
-            elif flavor == 'sync':
+            elif flavor in ('sync', 'custom_sync'):
                 print('{0} GLAPIENTRY _mesa_marshal_{1}({2});'.format(func.return_type, func.name, func.get_parameter_string()))
 
 
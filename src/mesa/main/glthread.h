@@ -134,6 +134,13 @@ struct glthread_state
    /** Whether GLThread is inside a display list generation. */
    bool inside_dlist;
 
+   /**
+    * Whether the context may be inside glBegin/glEnd. This is also set when
+    * it can't be known, such as after glCallList, and refreshed whenever a
+    * getter has to sync anyway.
+    */
+   bool inside_begin_end;
+
    /** The ring of batches in memory. */
    struct glthread_batch batches[MARSHAL_MAX_BATCHES];
 
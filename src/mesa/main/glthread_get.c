@@ -0,0 +1,84 @@
+/*
+ * Copyright © 2020 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+/* This answers the getters for the state glthread tracks itself without
+ * syncing with the server thread. Anything else is executed synchronously.
+ */
+
+#include "main/glthread_marshal.h"
+#include "main/context.h"
+#include "main/dispatch.h"
+
+/**
+ * Return whether pname can be answered by glthread, and if so, store the
+ * value into *value.
+ */
+static bool
+get_tracked_integer(struct gl_context *ctx, GLenum pname, GLint *value)
+{
+   struct glthread_state *glthread = &ctx->GLThread;
+
+   /* Buffer and vertex array bindings are only tracked in compatibility
+    * contexts, where binding any name is valid.
+    */
+   if (ctx->API == API_OPENGL_CORE)
+      return false;
+
+   switch (pname) {
+   case GL_ARRAY_BUFFER_BINDING:
+      *value = glthread->CurrentArrayBufferName;
+      return true;
+   case GL_ELEMENT_ARRAY_BUFFER_BINDING:
+      *value = glthread->CurrentVAO->CurrentElementBufferName;
+      return true;
+   case GL_VERTEX_ARRAY_BINDING:
+      *value = glthread->CurrentVAO->Name;
+      return true;
+   case GL_DRAW_INDIRECT_BUFFER_BINDING:
+      if (!ctx->Extensions.ARB_draw_indirect ||
+          !(_mesa_is_desktop_gl(ctx) || _mesa_is_gles31(ctx)))
+         return false;
+      *value = glthread->CurrentDrawIndirectBufferName;
+      return true;
+   default:
+      return false;
+   }
+}
+
+void GLAPIENTRY
+_mesa_marshal_GetIntegerv(GLenum pname, GLint *params)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   /* Getters inside glBegin/glEnd must generate GL_INVALID_OPERATION, so
+    * leave that to the server.
+    */
+   if (!ctx->GLThread.inside_begin_end &&
+       get_tracked_integer(ctx, pname, params))
+      return;
+
+   _mesa_glthread_finish_before(ctx, "GetIntegerv");
+   ctx->GLThread.inside_begin_end = _mesa_inside_begin_end(ctx);
+   CALL_GetIntegerv(ctx->CurrentServerDispatch, (pname, params));
+}
@@ -61,6 +61,7 @@ _mesa_NewHashTable(void)
       }
 
       _mesa_hash_table_set_deleted_key(table->ht, uint_key(DELETED_KEY_VALUE));
+      util_sparse_array_init(&table->direct, sizeof(void *), 1024);
       /*
        * Needs to be recursive, since the callback in _mesa_HashWalk()
        * is allowed to call _mesa_HashRemove().
@@ -94,6 +95,7 @@ _mesa_DeleteHashTable(struct _mesa_HashTable *table)
    }
 
    _mesa_hash_table_destroy(table->ht, NULL);
+   util_sparse_array_finish(&table->direct);
 
    mtx_destroy(&table->Mutex);
    free(table);
@@ -126,6 +128,20 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
 }
 
 
+/**
+ * Update the copy of the data of key in table->direct, if any.  The mutex
+ * must be held.
+ */
+static inline void
+hash_set_direct(struct _mesa_HashTable *table, GLuint key, void *data)
+{
+   if (key < HASH_DIRECT_KEYS) {
+      void **slot = util_sparse_array_get(&table->direct, key);
+      p_atomic_set(slot, data);
+   }
+}
+
+
 /**
  * Lookup an entry in the hash table.
  * 
@@ -138,6 +154,19 @@ void *
 _mesa_HashLookup(struct _mesa_HashTable *table, GLuint key)
 {
    void *res;
+
+   assert(table);
+   assert(key);
+
+   /* Small names are looked up in the direct array without locking.  Keys
+    * above MaxKey were never inserted, don't let them grow the array.
+    */
+   if (key < HASH_DIRECT_KEYS) {
+      if (key > p_atomic_read(&table->MaxKey))
+         return NULL;
+      return p_atomic_read((void **)util_sparse_array_get(&table->direct, key));
+   }
+
    _mesa_HashLockMutex(table);
    res = _mesa_HashLookup_unlocked(table, key);
    _mesa_HashUnlockMutex(table);
@@ -172,8 +201,11 @@ _mesa_HashInsert_unlocked(struct _mesa_HashTable *table, GLuint key, void *data)
    assert(table);
    assert(key);
 
+   /* Set the data before raising MaxKey, for lockless lookups. */
+   hash_set_direct(table, key, data);
+
    if (key > table->MaxKey)
-      table->MaxKey = key;
+      p_atomic_set(&table->MaxKey, key);
 
    if (key == DELETED_KEY_VALUE) {
       table->deleted_key_data = data;
@@ -245,6 +277,8 @@ _mesa_HashRemove_unlocked(struct _mesa_HashTable *table, GLuint key)
     */
    assert(!table->InDeleteAll);
 
+   hash_set_direct(table, key, NULL);
+
    if (key == DELETED_KEY_VALUE) {
       table->deleted_key_data = NULL;
    } else {
@@ -288,10 +322,12 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
    _mesa_HashLockMutex(table);
    table->InDeleteAll = GL_TRUE;
    hash_table_foreach(table->ht, entry) {
+      hash_set_direct(table, (uintptr_t)entry->key, NULL);
       callback((uintptr_t)entry->key, entry->data, userData);
       _mesa_hash_table_remove(table->ht, entry);
    }
    if (table->deleted_key_data) {
+      hash_set_direct(table, DELETED_KEY_VALUE, NULL);
       callback(DELETED_KEY_VALUE, table->deleted_key_data, userData);
       table->deleted_key_data = NULL;
    }
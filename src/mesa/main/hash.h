@@ -37,6 +37,7 @@
 #include "glheader.h"
 
 #include "c11/threads.h"
+#include "util/sparse_array.h"
 
 /**
  * Magic GLuint object name that gets stored outside of the struct hash_table.
@@ -95,6 +96,12 @@ uint_key(GLuint id)
 }
 /** @} */
 
+/**
+ * Keys below this are also stored in _mesa_HashTable::direct, which
+ * _mesa_HashLookup() reads without taking the mutex.
+ */
+#define HASH_DIRECT_KEYS (1 << 16)
+
 /**
  * The hash table data structure.
  */
@@ -105,6 +112,13 @@ struct _mesa_HashTable {
    GLboolean InDeleteAll;                /**< Debug check */
    /** Value that would be in the table for DELETED_KEY_VALUE. */
    void *deleted_key_data;
+   /**
+    * Copy of the data of keys below HASH_DIRECT_KEYS, indexed by key.
+    *
+    * Entries are only written with the mutex held, but the array never
+    * moves its elements when growing, so they can be read without it.
+    */
+   struct util_sparse_array direct;
 };
 
 extern struct _mesa_HashTable *_mesa_NewHashTable(void);
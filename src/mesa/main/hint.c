@@ -137,6 +137,7 @@ _mesa_MaxShaderCompilerThreadsKHR(GLuint count)
    GET_CURRENT_CONTEXT(ctx);
 
    ctx->Hint.MaxShaderCompilerThreads = count;
+   ctx->ShaderCompilerThreadsRequested = true;
 
    if (ctx->Driver.SetMaxShaderCompilerThreads)
       ctx->Driver.SetMaxShaderCompilerThreads(ctx, count);
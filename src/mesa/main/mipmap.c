@@ -41,6 +41,8 @@
 #include "util/half_float.h"
 #include "util/format_rgb9e5.h"
 #include "util/format_r11g11b10f.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_queue.h"
 
 
 /**
@@ -171,6 +173,32 @@ bytes_per_pixel(GLenum datatype, GLuint comps)
  * \param datatype  GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_FLOAT, etc.
  * \param comps  number of components per pixel (1..4)
  */
+/**
+ * Average 2x2 blocks of 4 x GLubyte texels.
+ * Each texel is handled as one 32-bit word, with the even and odd bytes
+ * summed in separate 16-bit lanes, which gives the same results as the
+ * per-channel code in do_row() for a fraction of the operations.
+ */
+static void
+do_row_ubyte4_2x(const GLuint *rowA, const GLuint *rowB,
+                 GLint dstWidth, GLuint *dst)
+{
+   const GLuint mask = 0x00ff00ff;
+   GLint i;
+
+   for (i = 0; i < dstWidth; i++) {
+      const GLuint a0 = rowA[2 * i], a1 = rowA[2 * i + 1];
+      const GLuint b0 = rowB[2 * i], b1 = rowB[2 * i + 1];
+      const GLuint even = (a0 & mask) + (a1 & mask) +
+                          (b0 & mask) + (b1 & mask);
+      const GLuint odd = ((a0 >> 8) & mask) + ((a1 >> 8) & mask) +
+                         ((b0 >> 8) & mask) + ((b1 >> 8) & mask);
+
+      dst[i] = ((even >> 2) & mask) | (((odd >> 2) & mask) << 8);
+   }
+}
+
+
 static void
 do_row(GLenum datatype, GLuint comps, GLint srcWidth,
        const GLvoid *srcRowA, const GLvoid *srcRowB,
@@ -186,7 +214,13 @@ do_row(GLenum datatype, GLuint comps, GLint srcWidth,
    assert(srcWidth == dstWidth || srcWidth == 2 * dstWidth);
    */
 
-   if (datatype == GL_UNSIGNED_BYTE && comps == 4) {
+   if (datatype == GL_UNSIGNED_BYTE && comps == 4 && colStride == 2 &&
+       (((uintptr_t) srcRowA | (uintptr_t) srcRowB | (uintptr_t) dstRow) &
+        (sizeof(GLuint) - 1)) == 0) {
+      do_row_ubyte4_2x((const GLuint *) srcRowA, (const GLuint *) srcRowB,
+                       dstWidth, (GLuint *) dstRow);
+   }
+   else if (datatype == GL_UNSIGNED_BYTE && comps == 4) {
       GLuint i, j, k;
       const GLubyte(*rowA)[4] = (const GLubyte(*)[4]) srcRowA;
       const GLubyte(*rowB)[4] = (const GLubyte(*)[4]) srcRowB;
@@ -1467,6 +1501,61 @@ make_1d_mipmap(GLenum datatype, GLuint comps, GLint border,
 }
 
 
+/* Levels with fewer destination texels than this are downsampled on the
+ * calling thread.
+ */
+#define MIPMAP_MIN_TEXELS_PER_JOB (64 * 1024)
+#define MIPMAP_MAX_JOBS 8
+
+static struct util_queue mipmap_queue;
+static bool mipmap_queue_ready;
+static once_flag mipmap_queue_once = ONCE_FLAG_INIT;
+
+static void
+init_mipmap_queue(void)
+{
+   util_cpu_detect();
+
+   unsigned num_threads = MIN2(util_cpu_caps.nr_cpus, MIPMAP_MAX_JOBS) - 1;
+   if (num_threads)
+      mipmap_queue_ready = util_queue_init(&mipmap_queue, "mipmap",
+                                           MIPMAP_MAX_JOBS, num_threads, 0);
+}
+
+struct mipmap_rows_job
+{
+   GLenum datatype;
+   GLuint comps;
+   GLint srcWidth, dstWidth;
+   const GLubyte *srcA, *srcB;
+   GLint srcRowStep;            /* in bytes */
+   GLubyte *dst;
+   GLint dstRowStride;
+   GLint numRows;
+   struct util_queue_fence fence;
+};
+
+static void
+make_2d_mipmap_rows(void *data, UNUSED int thread_index)
+{
+   const struct mipmap_rows_job *job = data;
+   const GLubyte *srcA = job->srcA, *srcB = job->srcB;
+   GLubyte *dst = job->dst;
+   GLint row;
+
+   for (row = 0; row < job->numRows; row++) {
+      do_row(job->datatype, job->comps, job->srcWidth, srcA, srcB,
+             job->dstWidth, dst);
+      srcA += job->srcRowStep;
+      srcB += job->srcRowStep;
+      dst += job->dstRowStride;
+   }
+}
+
+
+/**
+ * Large levels are split in bands of rows downsampled in parallel.
+ */
 static void
 make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
                GLint srcWidth, GLint srcHeight,
@@ -1481,6 +1570,8 @@ make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
    const GLubyte *srcA, *srcB;
    GLubyte *dst;
    GLint row, srcRowStep;
+   struct mipmap_rows_job jobs[MIPMAP_MAX_JOBS];
+   unsigned i, num_jobs;
 
    /* Compute src and dst pointers, skipping any border */
    srcA = srcPtr + border * ((srcWidth + 1) * bpt);
@@ -1497,12 +1588,45 @@ make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
 
    dst = dstPtr + border * ((dstWidth + 1) * bpt);
 
-   for (row = 0; row < dstHeightNB; row++) {
-      do_row(datatype, comps, srcWidthNB, srcA, srcB,
-             dstWidthNB, dst);
-      srcA += srcRowStep * srcRowStride;
-      srcB += srcRowStep * srcRowStride;
-      dst += dstRowStride;
+   num_jobs = MIN2(dstWidthNB * dstHeightNB / MIPMAP_MIN_TEXELS_PER_JOB,
+                   MIN2(dstHeightNB, MIPMAP_MAX_JOBS));
+   if (num_jobs > 1) {
+      call_once(&mipmap_queue_once, init_mipmap_queue);
+      if (!mipmap_queue_ready)
+         num_jobs = 1;
+      else
+         num_jobs = MIN2(num_jobs, mipmap_queue.num_threads + 1);
+   }
+   num_jobs = MAX2(num_jobs, 1);
+
+   for (i = 0; i < num_jobs; i++) {
+      struct mipmap_rows_job *job = &jobs[i];
+      const GLint first = dstHeightNB * i / num_jobs;
+
+      job->datatype = datatype;
+      job->comps = comps;
+      job->srcWidth = srcWidthNB;
+      job->dstWidth = dstWidthNB;
+      job->srcA = srcA + first * srcRowStep * srcRowStride;
+      job->srcB = srcB + first * srcRowStep * srcRowStride;
+      job->srcRowStep = srcRowStep * srcRowStride;
+      job->dst = dst + first * dstRowStride;
+      job->dstRowStride = dstRowStride;
+      job->numRows = dstHeightNB * (i + 1) / num_jobs - first;
+      util_queue_fence_init(&job->fence);
+   }
+
+   /* Downsample the first band here while the queue does the others. */
+   for (i = 1; i < num_jobs; i++) {
+      util_queue_add_job(&mipmap_queue, &jobs[i], &jobs[i].fence,
+                         make_2d_mipmap_rows, NULL, 0);
+   }
+
+   make_2d_mipmap_rows(&jobs[0], 0);
+
+   for (i = 0; i < num_jobs; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
    }
 
    /* This is ugly but probably won't be used much */
@@ -1381,6 +1381,9 @@ struct gl_buffer_object
    unsigned MinMaxCacheHitIndices;
    unsigned MinMaxCacheMissIndices;
    bool MinMaxCacheDirty;
+   /** Range written since the cache was last used, if not all dirty */
+   GLintptr MinMaxCacheDirtyStart;
+   GLintptr MinMaxCacheDirtyEnd;
 
    bool HandleAllocated; /**< GL_ARB_bindless_texture */
 };
@@ -2630,6 +2633,13 @@ struct gl_shader
 
    enum gl_compile_status CompileStatus;
 
+   /**
+    * Signalled once a glCompileShader() handed to
+    * gl_context::ShaderCompilerQueue has finished.  Must be waited on
+    * before CompileStatus, InfoLog, ir or Source are accessed.
+    */
+   struct util_queue_fence CompileFence;
+
 #ifdef DEBUG
    unsigned SourceChecksum;       /**< for debug/logging purposes */
 #endif
@@ -5296,6 +5306,19 @@ struct gl_context
    /*@}*/
 
    bool shader_builtin_ref;
+
+   /**
+    * Threads running the GLSL front end for glCompileShader() in the
+    * background (GL_KHR_parallel_shader_compile).  Created on first use.
+    */
+   struct util_queue ShaderCompilerQueue;
+
+   /**
+    * Whether the application has called glMaxShaderCompilerThreadsKHR().
+    * Hint.MaxShaderCompilerThreads starts out as 0xffffffff as the spec
+    * requires, but background compiles are only used once asked for.
+    */
+   bool ShaderCompilerThreadsRequested;
 };
 
 /**
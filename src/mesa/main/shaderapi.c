@@ -38,6 +38,7 @@
 
 #include "main/glheader.h"
 #include "main/context.h"
+#include "main/debug_output.h"
 #include "main/enums.h"
 #include "main/glspirv.h"
 #include "main/hash.h"
@@ -63,6 +64,7 @@
 #include "util/crc32.h"
 #include "util/os_file.h"
 #include "util/simple_list.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_string.h"
 
 /**
@@ -158,6 +160,11 @@ _mesa_init_shader_state(struct gl_context *ctx)
 void
 _mesa_free_shader_state(struct gl_context *ctx)
 {
+   if (util_queue_is_initialized(&ctx->ShaderCompilerQueue)) {
+      util_queue_finish(&ctx->ShaderCompilerQueue);
+      util_queue_destroy(&ctx->ShaderCompilerQueue);
+   }
+
    for (int i = 0; i < MESA_SHADER_STAGES; i++) {
       _mesa_reference_program(ctx, &ctx->Shader.CurrentProgram[i], NULL);
       _mesa_reference_shader_program(ctx,
@@ -1027,13 +1034,14 @@ get_shaderiv(struct gl_context *ctx, GLuint name, GLenum pname, GLint *params)
       *params = shader->DeletePending;
       break;
    case GL_COMPLETION_STATUS_ARB:
-      /* _mesa_glsl_compile_shader is not offloaded to other threads. */
-      *params = GL_TRUE;
+      *params = util_queue_fence_is_signalled(&shader->CompileFence);
       return;
    case GL_COMPILE_STATUS:
+      util_queue_fence_wait(&shader->CompileFence);
       *params = shader->CompileStatus ? GL_TRUE : GL_FALSE;
       break;
    case GL_INFO_LOG_LENGTH:
+      util_queue_fence_wait(&shader->CompileFence);
       *params = (shader->InfoLog && shader->InfoLog[0] != '\0') ?
          strlen(shader->InfoLog) + 1 : 0;
       break;
@@ -1099,6 +1107,8 @@ get_shader_info_log(struct gl_context *ctx, GLuint shader, GLsizei bufSize,
       return;
    }
 
+   util_queue_fence_wait(&sh->CompileFence);
+
    _mesa_copy_string(infoLog, bufSize, length, sh->InfoLog);
 }
 
@@ -1134,6 +1144,9 @@ set_shader_source(struct gl_shader *sh, const GLchar *source)
 {
    assert(sh);
 
+   /* A queued compile may still be reading the old source. */
+   util_queue_fence_wait(&sh->CompileFence);
+
    /* The GL_ARB_gl_spirv spec adds the following to the end of the description
     * of ShaderSource:
     *
@@ -1171,33 +1184,22 @@ ensure_builtin_types(struct gl_context *ctx)
 }
 
 /**
- * Compile a shader.
+ * Run the GLSL front end on a shader's source.  This is either called
+ * directly from glCompileShader() or from a ShaderCompilerQueue thread,
+ * so \p flags is the GLSL_x debug flags as they were at glCompileShader()
+ * time rather than whatever ctx->_Shader holds now.
  */
-void
-_mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
+static void
+compile_shader_source(struct gl_context *ctx, struct gl_shader *sh,
+                      GLbitfield flags)
 {
-   if (!sh)
-      return;
-
-   /* The GL_ARB_gl_spirv spec says:
-    *
-    *    "Add a new error for the CompileShader command:
-    *
-    *      An INVALID_OPERATION error is generated if the SPIR_V_BINARY_ARB
-    *      state of <shader> is TRUE."
-    */
-   if (sh->spirv_data) {
-      _mesa_error(ctx, GL_INVALID_OPERATION, "glCompileShader(SPIR-V)");
-      return;
-   }
-
    if (!sh->Source) {
       /* If the user called glCompileShader without first calling
        * glShaderSource, we should fail to compile, but not raise a GL_ERROR.
        */
       sh->CompileStatus = COMPILE_FAILURE;
    } else {
-      if (ctx->_Shader->Flags & GLSL_DUMP) {
+      if (flags & GLSL_DUMP) {
          _mesa_log("GLSL source for %s shader %d:\n",
                  _mesa_shader_stage_to_string(sh->Stage), sh->Name);
          _mesa_log("%s\n", sh->Source);
@@ -1208,13 +1210,13 @@ _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
       /* this call will set the shader->CompileStatus field to indicate if
        * compilation was successful.
        */
-      _mesa_glsl_compile_shader(ctx, sh, false, false, false);
+      _mesa_glsl_compile_shader(ctx, sh, false, false, false, flags);
 
-      if (ctx->_Shader->Flags & GLSL_LOG) {
+      if (flags & GLSL_LOG) {
          _mesa_write_shader_to_file(sh);
       }
 
-      if (ctx->_Shader->Flags & GLSL_DUMP) {
+      if (flags & GLSL_DUMP) {
          if (sh->CompileStatus) {
             if (sh->ir) {
                _mesa_log("GLSL IR for shader %d:\n", sh->Name);
@@ -1235,14 +1237,14 @@ _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
    }
 
    if (!sh->CompileStatus) {
-      if (ctx->_Shader->Flags & GLSL_DUMP_ON_ERROR) {
+      if (flags & GLSL_DUMP_ON_ERROR) {
          _mesa_log("GLSL source for %s shader %d:\n",
                  _mesa_shader_stage_to_string(sh->Stage), sh->Name);
          _mesa_log("%s\n", sh->Source);
          _mesa_log("Info Log:\n%s\n", sh->InfoLog);
       }
 
-      if (ctx->_Shader->Flags & GLSL_REPORT_ERRORS) {
+      if (flags & GLSL_REPORT_ERRORS) {
          _mesa_debug(ctx, "Error compiling shader %u:\n%s\n",
                      sh->Name, sh->InfoLog);
       }
@@ -1250,6 +1252,129 @@ _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
 }
 
 
+struct compile_shader_job
+{
+   struct gl_context *ctx;
+   struct gl_shader *sh;
+   GLbitfield flags;
+};
+
+static void
+compile_shader_job_execute(void *data, int thread_index)
+{
+   struct compile_shader_job *job = (struct compile_shader_job *) data;
+
+   compile_shader_source(job->ctx, job->sh, job->flags);
+}
+
+static void
+compile_shader_job_cleanup(void *data, int thread_index)
+{
+   free(data);
+}
+
+/**
+ * Whether glCompileShader() may return before \p sh has been compiled.
+ *
+ * The shader objects themselves are only touched again after waiting on
+ * CompileFence, but a few pieces of context state read by the compiler
+ * have no such protection, so keep those cases on the API thread.
+ */
+static bool
+can_compile_in_background(struct gl_context *ctx, struct gl_shader *sh)
+{
+   /* Background compiles are opt-in through glMaxShaderCompilerThreadsKHR(),
+    * since applications not using GL_KHR_parallel_shader_compile may not
+    * expect glCompileShader() to leave work running behind them.
+    */
+   if (!ctx->ShaderCompilerThreadsRequested ||
+       ctx->Hint.MaxShaderCompilerThreads == 0 || !sh->Source)
+      return false;
+
+   /* Compiler messages are reported through GL_KHR_debug, which must
+    * then happen before glCompileShader() returns.
+    */
+   if (ctx->Debug &&
+       _mesa_get_debug_state_int(ctx, GL_DEBUG_OUTPUT_SYNCHRONOUS))
+      return false;
+
+   /* Named strings may be changed by glNamedStringARB() at any time, and
+    * the include paths only exist during glCompileShaderIncludeARB().
+    */
+   if (strstr(sh->Source, "GL_ARB_shading_language_include"))
+      return false;
+
+   util_cpu_detect();
+   if (util_cpu_caps.nr_cpus < 2)
+      return false;
+
+   /* Leave one CPU for the application thread. */
+   unsigned num_threads = MIN2(ctx->Hint.MaxShaderCompilerThreads,
+                               util_cpu_caps.nr_cpus - 1);
+
+   if (!util_queue_is_initialized(&ctx->ShaderCompilerQueue) &&
+       !util_queue_init(&ctx->ShaderCompilerQueue, "glsl", 64,
+                        util_cpu_caps.nr_cpus - 1,
+                        UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+                        UTIL_QUEUE_INIT_SET_FULL_THREAD_AFFINITY))
+      return false;
+
+   /* glMaxShaderCompilerThreadsKHR() may have changed the limit. */
+   util_queue_adjust_num_threads(&ctx->ShaderCompilerQueue, num_threads);
+   return true;
+}
+
+static void
+compile_shader(struct gl_context *ctx, struct gl_shader *sh, bool background)
+{
+   if (!sh)
+      return;
+
+   /* The GL_ARB_gl_spirv spec says:
+    *
+    *    "Add a new error for the CompileShader command:
+    *
+    *      An INVALID_OPERATION error is generated if the SPIR_V_BINARY_ARB
+    *      state of <shader> is TRUE."
+    */
+   if (sh->spirv_data) {
+      _mesa_error(ctx, GL_INVALID_OPERATION, "glCompileShader(SPIR-V)");
+      return;
+   }
+
+   /* Recompiling a shader which is still being compiled. */
+   util_queue_fence_wait(&sh->CompileFence);
+
+   if (background && can_compile_in_background(ctx, sh)) {
+      struct compile_shader_job *job = malloc(sizeof(*job));
+
+      if (job) {
+         /* Take the built-in functions reference on this thread. */
+         ensure_builtin_types(ctx);
+
+         job->ctx = ctx;
+         job->sh = sh;
+         job->flags = ctx->_Shader->Flags;
+         util_queue_add_job(&ctx->ShaderCompilerQueue, job,
+                            &sh->CompileFence, compile_shader_job_execute,
+                            compile_shader_job_cleanup, 0);
+         return;
+      }
+   }
+
+   compile_shader_source(ctx, sh, ctx->_Shader->Flags);
+}
+
+/**
+ * Compile a shader.  The shader is fully compiled on return.
+ */
+void
+_mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
+{
+   compile_shader(ctx, sh, false);
+}
+
+
 struct update_programs_in_pipeline_params
 {
    struct gl_context *ctx;
@@ -1307,6 +1432,9 @@ link_program(struct gl_context *ctx, struct gl_shader_program *shProg,
 
    ensure_builtin_types(ctx);
 
+   for (unsigned i = 0; i < shProg->NumShaders; i++)
+      util_queue_fence_wait(&shProg->Shaders[i]->CompileFence);
+
    FLUSH_VERTICES(ctx, 0);
    _mesa_glsl_link_shader(ctx, shProg);
 
@@ -1611,8 +1739,8 @@ _mesa_CompileShader(GLuint shaderObj)
    GET_CURRENT_CONTEXT(ctx);
    if (MESA_VERBOSE & VERBOSE_API)
       _mesa_debug(ctx, "glCompileShader %u\n", shaderObj);
-   _mesa_compile_shader(ctx, _mesa_lookup_shader_err(ctx, shaderObj,
-                                                     "glCompileShader"));
+   compile_shader(ctx, _mesa_lookup_shader_err(ctx, shaderObj,
+                                               "glCompileShader"), true);
 }
 
 
@@ -2297,6 +2425,10 @@ _mesa_ReleaseShaderCompiler(void)
 {
    GET_CURRENT_CONTEXT(ctx);
 
+   /* Queued compiles still need the built-in functions. */
+   if (util_queue_is_initialized(&ctx->ShaderCompilerQueue))
+      util_queue_finish(&ctx->ShaderCompilerQueue);
+
    if (ctx->shader_builtin_ref) {
       _mesa_glsl_builtin_functions_decref();
       ctx->shader_builtin_ref = false;
@@ -2346,6 +2478,9 @@ _mesa_ShaderBinary(GLint n, const GLuint* shaders, GLenum binaryformat,
          return;
    }
 
+   for (int i = 0; i < n; ++i)
+      util_queue_fence_wait(&sh[i]->CompileFence);
+
    if (binaryformat == GL_SHADER_BINARY_FORMAT_SPIR_V_ARB) {
       if (!ctx->Extensions.ARB_gl_spirv) {
          _mesa_error(ctx, GL_INVALID_OPERATION, "glShaderBinary(SPIR-V)");
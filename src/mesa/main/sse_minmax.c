@@ -26,69 +26,103 @@
  */
 
 #include "main/sse_minmax.h"
-#include <smmintrin.h>
+#include "util/macros.h"
+#include <immintrin.h>
 #include <stdint.h>
 
-void
-_mesa_uint_array_min_max(const unsigned *ui_indices, unsigned *min_index,
-                         unsigned *max_index, const unsigned count)
-{
-   unsigned max_ui = 0;
-   unsigned min_ui = ~0U;
-   unsigned i = 0;
-   unsigned aligned_count = count;
-
-   /* handle the first few values without SSE until the pointer is aligned */
-   while (((uintptr_t)ui_indices & 15) && aligned_count) {
-      if (*ui_indices > max_ui)
-         max_ui = *ui_indices;
-      if (*ui_indices < min_ui)
-         min_ui = *ui_indices;
-
-      aligned_count--;
-      ui_indices++;
-   }
-
-   /* TODO: The actual threshold for SSE begin useful may be higher than 8.
-    * Some careful microbenchmarks and measurement are required to
-    * find the actual tipping point.
-    */
-   if (aligned_count >= 8) {
-      unsigned max_arr[4] __attribute__ ((aligned (16)));
-      unsigned min_arr[4] __attribute__ ((aligned (16)));
-      unsigned vec_count;
-      __m128i max_ui4 = _mm_setzero_si128();
-      __m128i min_ui4 = _mm_set1_epi32(~0U);
-      __m128i ui_indices4;
-      __m128i *ui_indices_ptr;
-
-      vec_count = aligned_count & ~0x3;
-      ui_indices_ptr = (__m128i *)ui_indices;
-      for (i = 0; i < vec_count / 4; i++) {
-         ui_indices4 = _mm_load_si128(&ui_indices_ptr[i]);
-         max_ui4 = _mm_max_epu32(ui_indices4, max_ui4);
-         min_ui4 = _mm_min_epu32(ui_indices4, min_ui4);
-      }
-
-      _mm_store_si128((__m128i *)max_arr, max_ui4);
-      _mm_store_si128((__m128i *)min_arr, min_ui4);
+/* Compute the min and max of an index array, skipping the primitive
+ * restart index if restart is true.  In the vector loop, the lanes equal to
+ * the restart index are replaced by values which can't affect the result:
+ * all ones for the minimum and zero for the maximum.
+ *
+ * If all indices are restart indices, the minimum is ~0 and the maximum 0,
+ * like the scalar code does.
+ *
+ * simd and si are the intrinsic prefix and suffix of the vector width,
+ * e.g. _mm and si128.
+ */
+#define INDEX_ARRAY_MIN_MAX(name, attr, type, bits, simd, vec, si, bytes)     \
+attr void                                                                    \
+name(const type *indices, unsigned count, bool restart,                      \
+     unsigned restart_index, unsigned *min_index, unsigned *max_index)       \
+{                                                                            \
+   const unsigned lanes = bytes / sizeof(type);                              \
+   type min_val = (type)~0u;                                                 \
+   type max_val = 0;                                                         \
+   bool found = false;                                                       \
+   unsigned i = 0;                                                           \
+                                                                             \
+   /* A restart index which doesn't fit in the type never matches. */        \
+   if (restart_index > (type)~0u)                                            \
+      restart = false;                                                       \
+                                                                             \
+   /* handle the first few values without SIMD until the pointer is aligned */\
+   for (; ((uintptr_t)&indices[i] & (bytes - 1)) && i < count; i++) {        \
+      if (restart && indices[i] == restart_index)                            \
+         continue;                                                           \
+      min_val = MIN2(min_val, indices[i]);                                   \
+      max_val = MAX2(max_val, indices[i]);                                   \
+      found = true;                                                          \
+   }                                                                         \
+                                                                             \
+   if (count - i >= 2 * lanes) {                                             \
+      const vec restart_v = simd##_set1_epi##bits((type)restart_index);      \
+      const vec enable_v = simd##_set1_epi32(restart ? ~0 : 0);              \
+      vec min_v = simd##_set1_epi32(~0);                                     \
+      vec max_v = simd##_setzero_##si();                                     \
+      type min_arr[bytes / sizeof(type)] __attribute__ ((aligned (bytes)));  \
+      type max_arr[bytes / sizeof(type)] __attribute__ ((aligned (bytes)));  \
+      unsigned vec_end = i + ((count - i) & ~(lanes - 1));                   \
+                                                                             \
+      for (; i < vec_end; i += lanes) {                                      \
+         vec v = simd##_load_##si((const vec *)&indices[i]);                 \
+         vec skip = simd##_and_##si(simd##_cmpeq_epi##bits(v, restart_v),    \
+                                    enable_v);                               \
+                                                                             \
+         min_v = simd##_min_epu##bits(min_v, simd##_or_##si(v, skip));       \
+         max_v = simd##_max_epu##bits(max_v, simd##_andnot_##si(skip, v));   \
+      }                                                                      \
+                                                                             \
+      simd##_store_##si((vec *)min_arr, min_v);                              \
+      simd##_store_##si((vec *)max_arr, max_v);                              \
+                                                                             \
+      for (unsigned j = 0; j < lanes; j++) {                                 \
+         /* A lane only saw restart indices if its min is above its max. */  \
+         if (min_arr[j] > max_arr[j])                                        \
+            continue;                                                        \
+         min_val = MIN2(min_val, min_arr[j]);                                \
+         max_val = MAX2(max_val, max_arr[j]);                                \
+         found = true;                                                       \
+      }                                                                      \
+   }                                                                         \
+                                                                             \
+   for (; i < count; i++) {                                                  \
+      if (restart && indices[i] == restart_index)                            \
+         continue;                                                           \
+      min_val = MIN2(min_val, indices[i]);                                   \
+      max_val = MAX2(max_val, indices[i]);                                   \
+      found = true;                                                          \
+   }                                                                         \
+                                                                             \
+   *min_index = found ? min_val : ~0u;                                       \
+   *max_index = max_val;                                                     \
+}
 
-      for (i = 0; i < 4; i++) {
-         if (max_arr[i] > max_ui)
-            max_ui = max_arr[i];
-         if (min_arr[i] < min_ui)
-            min_ui = min_arr[i];
-      }
-      i = vec_count;
-   }
+INDEX_ARRAY_MIN_MAX(_mesa_ubyte_array_min_max_restart, ,
+                    uint8_t, 8, _mm, __m128i, si128, 16)
+INDEX_ARRAY_MIN_MAX(_mesa_ushort_array_min_max_restart, ,
+                    uint16_t, 16, _mm, __m128i, si128, 16)
+INDEX_ARRAY_MIN_MAX(_mesa_uint_array_min_max_restart, ,
+                    uint32_t, 32, _mm, __m128i, si128, 16)
 
-   for (; i < aligned_count; i++) {
-      if (ui_indices[i] > max_ui)
-         max_ui = ui_indices[i];
-      if (ui_indices[i] < min_ui)
-         min_ui = ui_indices[i];
-   }
+/* AVX2 variants, selected at runtime.  Only this file is built with SSE4.1
+ * enabled, so enable AVX2 per function.
+ */
+#define AVX2 __attribute__((target("avx2")))
 
-   *min_index = min_ui;
-   *max_index = max_ui;
-}
+INDEX_ARRAY_MIN_MAX(_mesa_ubyte_array_min_max_restart_avx2, AVX2,
+                    uint8_t, 8, _mm256, __m256i, si256, 32)
+INDEX_ARRAY_MIN_MAX(_mesa_ushort_array_min_max_restart_avx2, AVX2,
+                    uint16_t, 16, _mm256, __m256i, si256, 32)
+INDEX_ARRAY_MIN_MAX(_mesa_uint_array_min_max_restart_avx2, AVX2,
+                    uint32_t, 32, _mm256, __m256i, si256, 32)
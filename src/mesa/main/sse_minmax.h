@@ -28,8 +28,37 @@
 #ifndef SSE_MINMAX_H
 #define SSE_MINMAX_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
+void
+_mesa_ubyte_array_min_max_restart(const uint8_t *indices, unsigned count,
+                                  bool restart, unsigned restart_index,
+                                  unsigned *min_index, unsigned *max_index);
+
+void
+_mesa_ushort_array_min_max_restart(const uint16_t *indices, unsigned count,
+                                   bool restart, unsigned restart_index,
+                                   unsigned *min_index, unsigned *max_index);
+
+void
+_mesa_uint_array_min_max_restart(const uint32_t *indices, unsigned count,
+                                 bool restart, unsigned restart_index,
+                                 unsigned *min_index, unsigned *max_index);
+
+void
+_mesa_ubyte_array_min_max_restart_avx2(const uint8_t *indices, unsigned count,
+                                       bool restart, unsigned restart_index,
+                                       unsigned *min_index, unsigned *max_index);
+
+void
+_mesa_ushort_array_min_max_restart_avx2(const uint16_t *indices, unsigned count,
+                                        bool restart, unsigned restart_index,
+                                        unsigned *min_index, unsigned *max_index);
+
 void
-_mesa_uint_array_min_max(const unsigned *ui_indices, unsigned *min_index,
-                         unsigned *max_index, const unsigned count);
+_mesa_uint_array_min_max_restart_avx2(const uint32_t *indices, unsigned count,
+                                      bool restart, unsigned restart_index,
+                                      unsigned *min_index, unsigned *max_index);
 
 #endif /* SSE_MINMAX_H */
@@ -36,6 +36,8 @@
 #include "texcompress_astc.h"
 #include "macros.h"
 #include "util/half_float.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_queue.h"
 #include <stdio.h>
 #include <cstdlib>  // for abort() on windows
 
@@ -632,6 +634,7 @@ struct Block
    decode_error::type decode(const Decoder &decoder, InputBitVector in);
 
    decode_error::type decode_block_mode(InputBitVector in);
+   decode_error::type decode_block_mode_uncached(InputBitVector in);
    decode_error::type decode_void_extent(InputBitVector in);
    void decode_cem(InputBitVector in);
    void unpack_colour_endpoints(InputBitVector in);
@@ -710,7 +713,99 @@ decode_error::type Block::decode_void_extent(InputBitVector block)
    return decode_error::ok;
 }
 
+/**
+ * Everything decode_block_mode() and calculate_from_weights() compute only
+ * depends on the 11 bits of block mode, so they are looked up in a table
+ * filled once for all the modes.
+ */
+struct block_mode_info
+{
+   uint8_t err; /* decode_error::type */
+   bool is_void_extent;
+   uint8_t dual_plane;
+   uint8_t high_prec;
+   uint8_t wt_range;
+   uint8_t wt_w, wt_h;
+   uint8_t wt_trits, wt_quints, wt_bits, wt_max;
+   uint16_t num_weights;
+   uint16_t weight_bits;
+};
+
+static block_mode_info block_modes[1 << 11];
+static once_flag block_modes_once = ONCE_FLAG_INIT;
+
+static void init_block_modes(void)
+{
+   for (unsigned mode = 0; mode < ARRAY_SIZE(block_modes); ++mode) {
+      block_mode_info *info = &block_modes[mode];
+      InputBitVector in;
+      Block blk;
+
+      memset(&in.data, 0, sizeof(in.data));
+      in.data[0] = mode;
+      blk.is_void_extent = false;
+      blk.wt_d = 1;
+
+      decode_error::type err = blk.decode_block_mode_uncached(in);
+
+      /* The void extent itself depends on the other bits of the block,
+       * it is decoded again when looking the mode up.
+       */
+      info->is_void_extent = blk.is_void_extent;
+      info->err = blk.is_void_extent ? decode_error::ok : err;
+      if (err != decode_error::ok || blk.is_void_extent)
+         continue;
+
+      blk.calculate_from_weights();
+
+      info->dual_plane = blk.dual_plane;
+      info->high_prec = blk.high_prec;
+      info->wt_range = blk.wt_range;
+      info->wt_w = blk.wt_w;
+      info->wt_h = blk.wt_h;
+      info->wt_trits = blk.wt_trits;
+      info->wt_quints = blk.wt_quints;
+      info->wt_bits = blk.wt_bits;
+      info->wt_max = blk.wt_max;
+      info->num_weights = blk.num_weights;
+      info->weight_bits = blk.weight_bits;
+   }
+}
+
 decode_error::type Block::decode_block_mode(InputBitVector in)
+{
+   if (VERBOSE_DECODE) {
+      decode_error::type err = decode_block_mode_uncached(in);
+      if (err == decode_error::ok && !is_void_extent)
+         calculate_from_weights();
+      return err;
+   }
+
+   call_once(&block_modes_once, init_block_modes);
+
+   const block_mode_info *info = &block_modes[in.get_bits(0, 11)];
+
+   if (info->is_void_extent)
+      return decode_void_extent(in);
+
+   if (info->err != decode_error::ok)
+      return (decode_error::type)info->err;
+
+   dual_plane = info->dual_plane;
+   high_prec = info->high_prec;
+   wt_range = info->wt_range;
+   wt_w = info->wt_w;
+   wt_h = info->wt_h;
+   wt_trits = info->wt_trits;
+   wt_quints = info->wt_quints;
+   wt_bits = info->wt_bits;
+   wt_max = info->wt_max;
+   num_weights = info->num_weights;
+   weight_bits = info->weight_bits;
+   return decode_error::ok;
+}
+
+decode_error::type Block::decode_block_mode_uncached(InputBitVector in)
 {
    dual_plane = in.get_bits(10, 1);
    high_prec = in.get_bits(9, 1);
@@ -1465,8 +1560,6 @@ decode_error::type Block::decode(const Decoder &decoder, InputBitVector in)
 
    /* TODO: 3D */
 
-   calculate_from_weights();
-
    if (VERBOSE_DECODE)
       printf("weights_grid=%dx%dx%d dual_plane=%d num_weights=%d high_prec=%d r=%d range=0..%d (%dt %dq %db) weight_bits=%d\n",
              wt_w, wt_h, wt_d, dual_plane, num_weights, high_prec, wt_range, wt_max, wt_trits, wt_quints, wt_bits, weight_bits);
@@ -1814,9 +1907,87 @@ decode_error::type Block::calculate_colour_endpoints_size()
    return decode_error::invalid_colour_endpoints_size;
 }
 
+/**
+ * A band of block rows of an ASTC 2D LDR image to decode.
+ */
+struct astc_decode_job
+{
+   const Decoder *dec;
+   uint8_t *dst_row;
+   unsigned dst_stride;
+   const uint8_t *src_row;
+   unsigned src_stride;
+   unsigned src_width;
+   unsigned src_height;
+   unsigned y_begin, y_end; /* in blocks */
+   struct util_queue_fence fence;
+};
+
+static void
+decode_astc_rows(void *data, int thread_index)
+{
+   const astc_decode_job *job = (const astc_decode_job *)data;
+   const Decoder &dec = *job->dec;
+   const unsigned blk_w = dec.block_w;
+   const unsigned blk_h = dec.block_h;
+   const unsigned block_size = 16;
+   unsigned x_blocks = (job->src_width + blk_w - 1) / blk_w;
+   const uint8_t *src_row = job->src_row + job->y_begin * job->src_stride;
+   uint8_t *dst_row = job->dst_row + job->y_begin * job->dst_stride * blk_h;
+
+   for (unsigned y = job->y_begin; y < job->y_end; ++y) {
+      for (unsigned x = 0; x < x_blocks; ++x) {
+         /* Same size as the largest block. */
+         uint16_t block_out[12 * 12 * 4];
+
+         dec.decode(src_row + x * block_size, block_out);
+
+         /* This can be smaller with NPOT dimensions. */
+         unsigned dst_blk_w = MIN2(blk_w, job->src_width  - x*blk_w);
+         unsigned dst_blk_h = MIN2(blk_h, job->src_height - y*blk_h);
+
+         for (unsigned sub_y = 0; sub_y < dst_blk_h; ++sub_y) {
+            for (unsigned sub_x = 0; sub_x < dst_blk_w; ++sub_x) {
+               uint8_t *dst = dst_row + sub_y * job->dst_stride +
+                              (x * blk_w + sub_x) * 4;
+               const uint16_t *src = &block_out[(sub_y * blk_w + sub_x) * 4];
+
+               dst[0] = src[0];
+               dst[1] = src[1];
+               dst[2] = src[2];
+               dst[3] = src[3];
+            }
+         }
+      }
+      src_row += job->src_stride;
+      dst_row += job->dst_stride * blk_h;
+   }
+}
+
+/* Images with fewer blocks than this are decoded on the calling thread. */
+#define ASTC_MIN_BLOCKS_PER_JOB 1024
+#define ASTC_MAX_JOBS 8
+
+static struct util_queue astc_queue;
+static bool astc_queue_ready;
+static once_flag astc_queue_once = ONCE_FLAG_INIT;
+
+static void
+init_astc_queue(void)
+{
+   util_cpu_detect();
+
+   unsigned num_threads = MIN2(util_cpu_caps.nr_cpus, ASTC_MAX_JOBS) - 1;
+   if (num_threads)
+      astc_queue_ready = util_queue_init(&astc_queue, "astc", ASTC_MAX_JOBS,
+                                         num_threads, 0);
+}
+
 /**
  * Decode ASTC 2D LDR texture data.
  *
+ * Large images are split in bands of block rows decoded in parallel.
+ *
  * \param src_width in pixels
  * \param src_height in pixels
  * \param dst_stride in bytes
@@ -1836,37 +2007,48 @@ _mesa_unpack_astc_2d_ldr(uint8_t *dst_row,
    unsigned blk_w, blk_h;
    _mesa_get_format_block_size(format, &blk_w, &blk_h);
 
-   const unsigned block_size = 16;
    unsigned x_blocks = (src_width + blk_w - 1) / blk_w;
    unsigned y_blocks = (src_height + blk_h - 1) / blk_h;
 
    Decoder dec(blk_w, blk_h, 1, srgb, true);
 
-   for (unsigned y = 0; y < y_blocks; ++y) {
-      for (unsigned x = 0; x < x_blocks; ++x) {
-         /* Same size as the largest block. */
-         uint16_t block_out[12 * 12 * 4];
+   unsigned num_jobs = MIN2(x_blocks * y_blocks / ASTC_MIN_BLOCKS_PER_JOB,
+                            MIN2(y_blocks, ASTC_MAX_JOBS));
+   if (num_jobs > 1) {
+      call_once(&astc_queue_once, init_astc_queue);
+      if (!astc_queue_ready)
+         num_jobs = 1;
+      else
+         num_jobs = MIN2(num_jobs, astc_queue.num_threads + 1);
+   }
+   num_jobs = MAX2(num_jobs, 1);
+
+   astc_decode_job jobs[ASTC_MAX_JOBS];
+   for (unsigned i = 0; i < num_jobs; ++i) {
+      astc_decode_job *job = &jobs[i];
+
+      job->dec = &dec;
+      job->dst_row = dst_row;
+      job->dst_stride = dst_stride;
+      job->src_row = src_row;
+      job->src_stride = src_stride;
+      job->src_width = src_width;
+      job->src_height = src_height;
+      job->y_begin = y_blocks * i / num_jobs;
+      job->y_end = y_blocks * (i + 1) / num_jobs;
+      util_queue_fence_init(&job->fence);
+   }
 
-         dec.decode(src_row + x * block_size, block_out);
+   /* Decode the first band here while the queue decodes the others. */
+   for (unsigned i = 1; i < num_jobs; ++i) {
+      util_queue_add_job(&astc_queue, &jobs[i], &jobs[i].fence,
+                         decode_astc_rows, NULL, 0);
+   }
 
-         /* This can be smaller with NPOT dimensions. */
-         unsigned dst_blk_w = MIN2(blk_w, src_width  - x*blk_w);
-         unsigned dst_blk_h = MIN2(blk_h, src_height - y*blk_h);
+   decode_astc_rows(&jobs[0], 0);
 
-         for (unsigned sub_y = 0; sub_y < dst_blk_h; ++sub_y) {
-            for (unsigned sub_x = 0; sub_x < dst_blk_w; ++sub_x) {
-               uint8_t *dst = dst_row + sub_y * dst_stride +
-                              (x * blk_w + sub_x) * 4;
-               const uint16_t *src = &block_out[(sub_y * blk_w + sub_x) * 4];
-
-               dst[0] = src[0];
-               dst[1] = src[1];
-               dst[2] = src[2];
-               dst[3] = src[3];
-            }
-         }
-      }
-      src_row += src_stride;
-      dst_row += dst_stride * blk_h;
+   for (unsigned i = 0; i < num_jobs; ++i) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
    }
 }
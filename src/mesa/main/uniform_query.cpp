@@ -1035,41 +1035,77 @@ _mesa_flush_vertices_for_uniforms(struct gl_context *ctx,
    ctx->NewDriverState |= new_driver_state;
 }
 
-static void
+/**
+ * Copy the values of a glUniform*() call to the uniform storage.
+ *
+ * Only the values which differ from the current ones are written, and if
+ * \p flush is set the vertices are flushed before the first write.
+ *
+ * \return true if any value was changed.
+ */
+static bool
 copy_uniforms_to_storage(gl_constant_value *storage,
                          struct gl_uniform_storage *uni,
                          struct gl_context *ctx, GLsizei count,
                          const GLvoid *values, const int size_mul,
                          const unsigned offset, const unsigned components,
-                         enum glsl_base_type basicType)
+                         enum glsl_base_type basicType, bool flush)
 {
    bool copy_as_uint64 = uni->is_bindless &&
                          (uni->type->is_sampler() || uni->type->is_image());
    if (!uni->type->is_boolean() && !copy_as_uint64) {
-      memcpy(storage, values,
-             sizeof(storage[0]) * components * count * size_mul);
+      const unsigned size = sizeof(storage[0]) * components * count * size_mul;
+
+      if (!memcmp(storage, values, size))
+         return false;
+
+      if (flush)
+         _mesa_flush_vertices_for_uniforms(ctx, uni);
+
+      memcpy(storage, values, size);
+      return true;
    } else if (copy_as_uint64) {
       const union gl_constant_value *src =
          (const union gl_constant_value *) values;
       GLuint64 *dst = (GLuint64 *)&storage->i;
       const unsigned elems = components * count;
+      bool changed = false;
 
       for (unsigned i = 0; i < elems; i++) {
-         dst[i] = src[i].i;
+         const GLuint64 value = src[i].i;
+
+         if (dst[i] != value) {
+            if (flush && !changed)
+               _mesa_flush_vertices_for_uniforms(ctx, uni);
+            dst[i] = value;
+            changed = true;
+         }
       }
+      return changed;
    } else {
       const union gl_constant_value *src =
          (const union gl_constant_value *) values;
       union gl_constant_value *dst = storage;
       const unsigned elems = components * count;
+      bool changed = false;
 
       for (unsigned i = 0; i < elems; i++) {
+         int value;
+
          if (basicType == GLSL_TYPE_FLOAT) {
-            dst[i].i = src[i].f != 0.0f ? ctx->Const.UniformBooleanTrue : 0;
+            value = src[i].f != 0.0f ? ctx->Const.UniformBooleanTrue : 0;
          } else {
-            dst[i].i = src[i].i != 0    ? ctx->Const.UniformBooleanTrue : 0;
+            value = src[i].i != 0    ? ctx->Const.UniformBooleanTrue : 0;
+         }
+
+         if (dst[i].i != value) {
+            if (flush && !changed)
+               _mesa_flush_vertices_for_uniforms(ctx, uni);
+            dst[i].i = value;
+            changed = true;
          }
       }
+      return changed;
    }
 }
 
@@ -1130,9 +1166,8 @@ _mesa_uniform(GLint location, GLsizei count, const GLvoid *values,
    /* We check samplers for changes and flush if needed in the sampler
     * handling code further down, so just skip them here.
     */
-   if (!uni->type->is_sampler()) {
-       _mesa_flush_vertices_for_uniforms(ctx, uni);
-   }
+   bool flush = !uni->type->is_sampler();
+   bool changed = false;
 
    /* Store the data in the "actual type" backing storage for the uniform.
     */
@@ -1143,15 +1178,19 @@ _mesa_uniform(GLint location, GLsizei count, const GLvoid *values,
          storage = (gl_constant_value *)
             uni->driver_storage[s].data + (size_mul * offset * components);
 
-         copy_uniforms_to_storage(storage, uni, ctx, count, values, size_mul,
-                                  offset, components, basicType);
+         if (copy_uniforms_to_storage(storage, uni, ctx, count, values,
+                                      size_mul, offset, components, basicType,
+                                      flush && !changed))
+            changed = true;
       }
    } else {
       storage = &uni->storage[size_mul * components * offset];
-      copy_uniforms_to_storage(storage, uni, ctx, count, values, size_mul,
-                               offset, components, basicType);
+      changed = copy_uniforms_to_storage(storage, uni, ctx, count, values,
+                                         size_mul, offset, components,
+                                         basicType, flush);
 
-      _mesa_propagate_uniforms_to_driver_storage(uni, offset, count);
+      if (changed)
+         _mesa_propagate_uniforms_to_driver_storage(uni, offset, count);
    }
 
    /* If the uniform is a sampler, do the extra magic necessary to propagate
@@ -1243,20 +1282,34 @@ _mesa_uniform(GLint location, GLsizei count, const GLvoid *values,
 }
 
 
-static void
-copy_uniform_matrix_to_storage(gl_constant_value *storage,
+/**
+ * Like copy_uniforms_to_storage(), for glUniformMatrix*().
+ */
+static bool
+copy_uniform_matrix_to_storage(struct gl_context *ctx,
+                               gl_constant_value *storage,
+                               struct gl_uniform_storage *const uni,
                                GLsizei count, const void *values,
                                const unsigned size_mul, const unsigned offset,
                                const unsigned components,
                                const unsigned vectors, bool transpose,
                                unsigned cols, unsigned rows,
-                               enum glsl_base_type basicType)
+                               enum glsl_base_type basicType, bool flush)
 {
    const unsigned elements = components * vectors;
+   bool changed = false;
 
    if (!transpose) {
-      memcpy(storage, values,
-             sizeof(storage[0]) * elements * count * size_mul);
+      const unsigned size = sizeof(storage[0]) * elements * count * size_mul;
+
+      if (!memcmp(storage, values, size))
+         return false;
+
+      if (flush)
+         _mesa_flush_vertices_for_uniforms(ctx, uni);
+
+      memcpy(storage, values, size);
+      return true;
    } else if (basicType == GLSL_TYPE_FLOAT) {
       /* Copy and transpose the matrix.
        */
@@ -1266,7 +1319,15 @@ copy_uniform_matrix_to_storage(gl_constant_value *storage,
       for (int i = 0; i < count; i++) {
          for (unsigned r = 0; r < rows; r++) {
             for (unsigned c = 0; c < cols; c++) {
-               dst[(c * components) + r] = src[c + (r * vectors)];
+               unsigned dst_index = (c * components) + r;
+               unsigned src_index = c + (r * vectors);
+
+               if (memcmp(&dst[dst_index], &src[src_index], sizeof(float))) {
+                  if (flush && !changed)
+                     _mesa_flush_vertices_for_uniforms(ctx, uni);
+                  dst[dst_index] = src[src_index];
+                  changed = true;
+               }
             }
          }
 
@@ -1281,7 +1342,15 @@ copy_uniform_matrix_to_storage(gl_constant_value *storage,
       for (int i = 0; i < count; i++) {
          for (unsigned r = 0; r < rows; r++) {
             for (unsigned c = 0; c < cols; c++) {
-               dst[(c * components) + r] = src[c + (r * vectors)];
+               unsigned dst_index = (c * components) + r;
+               unsigned src_index = c + (r * vectors);
+
+               if (memcmp(&dst[dst_index], &src[src_index], sizeof(double))) {
+                  if (flush && !changed)
+                     _mesa_flush_vertices_for_uniforms(ctx, uni);
+                  dst[dst_index] = src[src_index];
+                  changed = true;
+               }
             }
          }
 
@@ -1289,6 +1358,8 @@ copy_uniform_matrix_to_storage(gl_constant_value *storage,
          src += elements;
       }
    }
+
+   return changed;
 }
 
 
@@ -1387,28 +1458,30 @@ _mesa_uniform_matrix(GLint location, GLsizei count,
       count = MIN2(count, (int) (uni->array_elements - offset));
    }
 
-   _mesa_flush_vertices_for_uniforms(ctx, uni);
-
    /* Store the data in the "actual type" backing storage for the uniform.
     */
    gl_constant_value *storage;
    const unsigned elements = components * vectors;
    if (ctx->Const.PackedDriverUniformStorage) {
+      bool flushed = false;
+
       for (unsigned s = 0; s < uni->num_driver_storage; s++) {
          storage = (gl_constant_value *)
             uni->driver_storage[s].data + (size_mul * offset * elements);
 
-         copy_uniform_matrix_to_storage(storage, count, values, size_mul,
-                                        offset, components, vectors,
-                                        transpose, cols, rows, basicType);
+         if (copy_uniform_matrix_to_storage(ctx, storage, uni, count, values,
+                                            size_mul, offset, components,
+                                            vectors, transpose, cols, rows,
+                                            basicType, !flushed))
+            flushed = true;
       }
    } else {
       storage =  &uni->storage[size_mul * elements * offset];
-      copy_uniform_matrix_to_storage(storage, count, values, size_mul, offset,
-                                     components, vectors, transpose, cols,
-                                     rows, basicType);
-
-      _mesa_propagate_uniforms_to_driver_storage(uni, offset, count);
+      if (copy_uniform_matrix_to_storage(ctx, storage, uni, count, values,
+                                         size_mul, offset, components,
+                                         vectors, transpose, cols, rows,
+                                         basicType, true))
+         _mesa_propagate_uniforms_to_driver_storage(uni, offset, count);
    }
 }
 
@@ -32,6 +32,7 @@
 #include "main/context.h"
 
 #include "pipe/p_defines.h"
+#include "util/u_cpu_trace.h"
 #include "st_context.h"
 #include "st_atom.h"
 #include "st_program.h"
@@ -172,6 +173,7 @@ static void check_attrib_edgeflag(struct st_context *st)
 
 void st_validate_state( struct st_context *st, enum st_pipeline pipeline )
 {
+   UTIL_CPU_TRACE_FUNC();
    struct gl_context *ctx = st->ctx;
    uint64_t dirty, pipeline_mask;
    uint32_t dirty_lo, dirty_hi;
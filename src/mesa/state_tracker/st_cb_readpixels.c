@@ -93,8 +93,73 @@ needs_integer_signed_unsigned_conversion(const struct gl_context *ctx,
    return FALSE;
 }
 
+/**
+ * Resolve the region of a multisampled renderbuffer which is read into a
+ * single-sampled texture of the same size, so that the PBO download shader
+ * can sample it.  Only winsys framebuffers can be multisampled here.
+ */
+static struct pipe_resource *
+resolve_for_pbo_readpixels(struct st_context *st, struct st_renderbuffer *strb,
+                           bool invert_y,
+                           GLint x, GLint y, GLsizei width, GLsizei height,
+                           GLenum format, enum pipe_format src_format)
+{
+   struct pipe_screen *screen = st->pipe->screen;
+   struct pipe_surface *surface = strb->surface;
+   struct pipe_resource templ;
+   struct pipe_resource *resolved;
+   struct pipe_blit_info blit;
+
+   if (!screen->is_format_supported(screen, src_format, PIPE_TEXTURE_2D, 0, 0,
+                                    PIPE_BIND_SAMPLER_VIEW |
+                                    PIPE_BIND_RENDER_TARGET))
+      return NULL;
+
+   memset(&templ, 0, sizeof(templ));
+   templ.target = PIPE_TEXTURE_2D;
+   templ.format = src_format;
+   templ.width0 = surface->width;
+   templ.height0 = surface->height;
+   templ.depth0 = 1;
+   templ.array_size = 1;
+   templ.bind = PIPE_BIND_SAMPLER_VIEW | PIPE_BIND_RENDER_TARGET;
+   templ.usage = PIPE_USAGE_DEFAULT;
+
+   resolved = screen->resource_create(screen, &templ);
+   if (!resolved)
+      return NULL;
+
+   memset(&blit, 0, sizeof(blit));
+   blit.src.resource = strb->texture;
+   blit.src.level = surface->u.tex.level;
+   blit.src.format = src_format;
+   blit.dst.resource = resolved;
+   blit.dst.level = 0;
+   blit.dst.format = src_format;
+   blit.src.box.x = blit.dst.box.x = x;
+   blit.src.box.y = blit.dst.box.y =
+      invert_y ? (int) surface->height - y - height : y;
+   blit.src.box.z = surface->u.tex.first_layer;
+   blit.dst.box.z = 0;
+   blit.src.box.width = blit.dst.box.width = width;
+   blit.src.box.height = blit.dst.box.height = height;
+   blit.src.box.depth = blit.dst.box.depth = 1;
+   blit.mask = st_get_blit_mask(strb->Base._BaseFormat, format);
+   blit.filter = PIPE_TEX_FILTER_NEAREST;
+
+   st->pipe->blit(st->pipe, &blit);
+
+   return resolved;
+}
+
+/**
+ * Write the pixels into the pack PBO with the download shader, entirely on
+ * the GPU.  texture, level and layer are where the pixels are read from.
+ */
 static bool
-try_pbo_readpixels(struct st_context *st, struct st_renderbuffer *strb,
+try_pbo_readpixels(struct st_context *st, struct pipe_resource *texture,
+                   unsigned level, unsigned layer,
+                   unsigned surface_width, unsigned surface_height,
                    bool invert_y,
                    GLint x, GLint y, GLsizei width, GLsizei height,
                    enum pipe_format src_format, enum pipe_format dst_format,
@@ -103,16 +168,13 @@ try_pbo_readpixels(struct st_context *st, struct st_renderbuffer *strb,
    struct pipe_context *pipe = st->pipe;
    struct pipe_screen *screen = pipe->screen;
    struct cso_context *cso = st->cso_context;
-   struct pipe_surface *surface = strb->surface;
-   struct pipe_resource *texture = strb->texture;
    const struct util_format_description *desc;
    struct st_pbo_addresses addr;
    struct pipe_framebuffer_state fb;
    enum pipe_texture_target view_target;
    bool success = false;
 
-   if (texture->nr_samples > 1)
-      return false;
+   assert(texture->nr_samples <= 1);
 
    if (!screen->is_format_supported(screen, dst_format, PIPE_BUFFER, 0, 0,
                                     PIPE_BIND_SHADER_IMAGE))
@@ -172,14 +234,14 @@ try_pbo_readpixels(struct st_context *st, struct st_renderbuffer *strb,
       }
 
       templ.target = view_target;
-      templ.u.tex.first_level = surface->u.tex.level;
+      templ.u.tex.first_level = level;
       templ.u.tex.last_level = templ.u.tex.first_level;
 
       if (view_target != PIPE_TEXTURE_3D) {
-         templ.u.tex.first_layer = surface->u.tex.first_layer;
+         templ.u.tex.first_layer = layer;
          templ.u.tex.last_layer = templ.u.tex.first_layer;
       } else {
-         addr.constants.layer_offset = surface->u.tex.first_layer;
+         addr.constants.layer_offset = layer;
       }
 
       sampler_view = pipe->create_sampler_view(pipe, texture, &templ);
@@ -211,8 +273,8 @@ try_pbo_readpixels(struct st_context *st, struct st_renderbuffer *strb,
 
    /* Set up no-attachment framebuffer */
    memset(&fb, 0, sizeof(fb));
-   fb.width = surface->width;
-   fb.height = surface->height;
+   fb.width = surface_width;
+   fb.height = surface_height;
    fb.samples = 1;
    fb.layers = 1;
    cso_set_framebuffer(cso, &fb);
@@ -471,11 +533,33 @@ st_ReadPixels(struct gl_context *ctx, GLint x, GLint y,
    }
 
    if (st->pbo.download_enabled && pack->BufferObj) {
-      if (try_pbo_readpixels(st, strb,
-                             st_fb_orientation(ctx->ReadBuffer) == Y_0_TOP,
-                             x, y, width, height,
-                             src_format, dst_format,
-                             pack, pixels))
+      bool invert_y = st_fb_orientation(ctx->ReadBuffer) == Y_0_TOP;
+      struct pipe_resource *resolved = NULL;
+      bool success = false;
+
+      if (src->nr_samples > 1) {
+         resolved = resolve_for_pbo_readpixels(st, strb, invert_y,
+                                               x, y, width, height,
+                                               format, src_format);
+         if (resolved) {
+            success = try_pbo_readpixels(st, resolved, 0, 0,
+                                         resolved->width0, resolved->height0,
+                                         invert_y, x, y, width, height,
+                                         src_format, dst_format,
+                                         pack, pixels);
+            pipe_resource_reference(&resolved, NULL);
+         }
+      } else {
+         success = try_pbo_readpixels(st, src, strb->surface->u.tex.level,
+                                      strb->surface->u.tex.first_layer,
+                                      strb->surface->width,
+                                      strb->surface->height,
+                                      invert_y, x, y, width, height,
+                                      src_format, dst_format,
+                                      pack, pixels);
+      }
+
+      if (success)
          return;
    }
 
@@ -1260,20 +1260,16 @@ reinterpret_formats(enum pipe_format *src_format, enum pipe_format *dst_format)
 }
 
 static bool
-try_pbo_upload_common(struct gl_context *ctx,
-                      struct pipe_surface *surface,
-                      const struct st_pbo_addresses *addr,
-                      enum pipe_format src_format)
+pbo_upload_draw(struct gl_context *ctx,
+                struct pipe_surface *surface,
+                const struct st_pbo_addresses *addr,
+                enum pipe_format src_format,
+                void *fs)
 {
    struct st_context *st = st_context(ctx);
    struct cso_context *cso = st->cso_context;
    struct pipe_context *pipe = st->pipe;
    bool success = false;
-   void *fs;
-
-   fs = st_pbo_get_upload_fs(st, src_format, surface->format);
-   if (!fs)
-      return false;
 
    cso_save_state(cso, (CSO_BIT_FRAGMENT_SAMPLER_VIEWS |
                         CSO_BIT_VERTEX_ELEMENTS |
@@ -1356,6 +1352,20 @@ fail:
    return success;
 }
 
+static bool
+try_pbo_upload_common(struct gl_context *ctx,
+                      struct pipe_surface *surface,
+                      const struct st_pbo_addresses *addr,
+                      enum pipe_format src_format)
+{
+   void *fs = st_pbo_get_upload_fs(st_context(ctx), src_format,
+                                   surface->format);
+   if (!fs)
+      return false;
+
+   return pbo_upload_draw(ctx, surface, addr, src_format, fs);
+}
+
 
 static bool
 try_pbo_upload(struct gl_context *ctx, GLuint dims,
@@ -1778,6 +1788,146 @@ st_TexImage(struct gl_context * ctx, GLuint dims,
 }
 
 
+/**
+ * Decode an ETC1 or ETC2 RGB8 upload from client memory with a fragment
+ * shader, for drivers which lack the formats, instead of decoding it on the
+ * CPU when the image is unmapped.  The compressed data is still kept, as
+ * the CPU path does.
+ */
+static bool
+try_etc_decode_upload(struct gl_context *ctx, GLuint dims,
+                      struct gl_texture_image *texImage,
+                      GLint x, GLint y, GLint z,
+                      GLsizei w, GLsizei h, GLsizei d,
+                      const void *data)
+{
+   struct st_context *st = st_context(ctx);
+   struct st_texture_image *stImage = st_texture_image(texImage);
+   struct st_texture_object *stObj = st_texture_object(texImage->TexObject);
+   struct pipe_resource *texture = stImage->pt;
+   struct pipe_context *pipe = st->pipe;
+   struct pipe_screen *screen = pipe->screen;
+   const enum pipe_format copy_format = PIPE_FORMAT_R16G16B16A16_UINT;
+   struct pipe_resource *buf;
+   struct pipe_surface *surface;
+   struct compressed_pixelstore store;
+   struct st_pbo_addresses addr;
+   unsigned size;
+   bool success;
+   void *fs;
+
+   if (texImage->TexFormat != MESA_FORMAT_ETC1_RGB8 &&
+       texImage->TexFormat != MESA_FORMAT_ETC2_RGB8 &&
+       texImage->TexFormat != MESA_FORMAT_ETC2_SRGB8)
+      return false;
+
+   if (!st->prefer_blit_based_texture_transfer || !st->pbo.upload_enabled ||
+       !texture || ctx->Unpack.BufferObj || !data)
+      return false;
+
+   if (texImage->TexObject->MinLevel || texImage->TexObject->MinLayer)
+      return false;
+
+   if (d != 1 && !st->pbo.layers)
+      return false;
+
+   if (!screen->is_format_supported(screen, copy_format, PIPE_BUFFER, 0, 0,
+                                    PIPE_BIND_SAMPLER_VIEW) ||
+       !screen->is_format_supported(screen, util_format_linear(texture->format),
+                                    texture->target, texture->nr_samples,
+                                    texture->nr_storage_samples,
+                                    PIPE_BIND_RENDER_TARGET))
+      return false;
+
+   fs = st_pbo_get_etc_decode_fs(st);
+   if (!fs)
+      return false;
+
+   _mesa_compute_compressed_pixelstore(dims, texImage->TexFormat, w, h, d,
+                                       &ctx->Unpack, &store);
+   data = (const GLubyte *) data + store.SkipBytes;
+   size = ((d - 1) * store.TotalRowsPerSlice + store.CopyRowsPerSlice - 1) *
+          store.TotalBytesPerRow + store.CopyBytesPerRow;
+
+   buf = pipe_buffer_create_with_data(pipe, PIPE_BIND_SAMPLER_VIEW,
+                                      PIPE_USAGE_STREAM, size, data);
+   if (!buf)
+      return false;
+
+   /* Address the blocks like a compressed PBO upload does... */
+   addr.bytes_per_pixel = 8;
+   addr.xoffset = x / 4;
+   addr.yoffset = y / 4;
+   addr.width = store.CopyBytesPerRow / 8;
+   addr.height = store.CopyRowsPerSlice;
+   addr.depth = d;
+   addr.pixels_per_row = store.TotalBytesPerRow / 8;
+   addr.image_height = store.TotalRowsPerSlice;
+
+   if (!st_pbo_addresses_setup(st, buf, 0, &addr)) {
+      pipe_resource_reference(&buf, NULL);
+      return false;
+   }
+
+   /* ...but draw the pixels. */
+   addr.xoffset = x;
+   addr.yoffset = y;
+   addr.width = w;
+   addr.height = h;
+
+   /* Set up the surface. */
+   {
+      unsigned level = stObj->pt != stImage->pt ? 0 : texImage->Level;
+      unsigned max_layer = util_max_layer(texture, level);
+      unsigned layer = z + texImage->Face;
+
+      struct pipe_surface templ;
+      memset(&templ, 0, sizeof(templ));
+      templ.format = util_format_linear(texture->format);
+      templ.u.tex.level = level;
+      templ.u.tex.first_layer = MIN2(layer, max_layer);
+      templ.u.tex.last_layer = MIN2(layer + d - 1, max_layer);
+
+      surface = pipe->create_surface(pipe, texture, &templ);
+      if (!surface) {
+         pipe_resource_reference(&buf, NULL);
+         return false;
+      }
+   }
+
+   success = pbo_upload_draw(ctx, surface, &addr, copy_format, fs);
+
+   pipe_surface_reference(&surface, NULL);
+   pipe_resource_reference(&buf, NULL);
+
+   if (!success)
+      return false;
+
+   /* Keep the compressed data for glGetCompressedTexImage and image
+    * copies, see st_MapTextureImage.
+    */
+   {
+      unsigned y_blocks = DIV_ROUND_UP(texImage->Height2, 4);
+      unsigned stride = _mesa_format_row_stride(texImage->TexFormat,
+                                                texImage->Width2);
+
+      for (unsigned slice = 0; slice < d; slice++) {
+         for (unsigned row = 0; row < store.CopyRowsPerSlice; row++) {
+            memcpy(stImage->compressed_data->ptr +
+                   ((z + texImage->Face + slice) * y_blocks + y / 4 + row) *
+                   stride + (x / 4) * 8,
+                   (const GLubyte *) data +
+                   (slice * store.TotalRowsPerSlice + row) *
+                   store.TotalBytesPerRow,
+                   store.CopyBytesPerRow);
+         }
+      }
+   }
+
+   return true;
+}
+
+
 static void
 st_CompressedTexSubImage(struct gl_context *ctx, GLuint dims,
                          struct gl_texture_image *texImage,
@@ -1800,6 +1950,10 @@ st_CompressedTexSubImage(struct gl_context *ctx, GLuint dims,
    intptr_t buf_offset;
    bool success = false;
 
+   if (st_compressed_format_fallback(st, texImage->TexFormat) &&
+       try_etc_decode_upload(ctx, dims, texImage, x, y, z, w, h, d, data))
+      return;
+
    /* Check basic pre-conditions for PBO upload */
    if (!st->prefer_blit_based_texture_transfer) {
       goto fallback;
@@ -468,6 +468,9 @@ st_destroy_context_priv(struct st_context *st, bool destroy_pipe)
 
    cso_destroy_context(st->cso_context);
 
+   if (util_queue_is_initialized(&st->link_queue))
+      util_queue_destroy(&st->link_queue);
+
    if (st->pipe && destroy_pipe)
       st->pipe->destroy(st->pipe);
 
@@ -608,6 +611,12 @@ st_create_context_priv(struct gl_context *ctx, struct pipe_context *pipe,
 
    st->cso_context = cso_create_context(pipe, cso_flags);
 
+   /* Vertex and constant data are streamed through the same few buffers
+    * every frame, so reuse them instead of allocating new ones.
+    */
+   if (pipe->stream_uploader)
+      u_upload_enable_recycling(pipe->stream_uploader);
+
    st_init_atoms(st);
    st_init_clear(st);
    st_init_pbo_helpers(st);
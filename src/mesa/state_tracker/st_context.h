@@ -319,6 +319,7 @@ struct st_context
       void *gs;
       void *upload_fs[3];
       void *download_fs[3][PIPE_MAX_TEXTURE_TYPES];
+      void *etc_decode_fs;
       bool upload_enabled;
       bool download_enabled;
       bool rgba_only;
@@ -377,6 +378,10 @@ struct st_context
       simple_mtx_t mutex;
    } zombie_shaders;
 
+   /* Threads finalizing the stages of a program in st_link_nir.  Created on
+    * first use.
+    */
+   struct util_queue link_queue;
 };
 
 
@@ -123,6 +123,11 @@ st_debug_message(void *data,
       type = MESA_DEBUG_TYPE_OTHER;
       severity = MESA_DEBUG_SEVERITY_NOTIFICATION;
       break;
+   case PIPE_DEBUG_TYPE_SHADER_STATS:
+      source = MESA_DEBUG_SOURCE_SHADER_COMPILER;
+      type = MESA_DEBUG_TYPE_OTHER;
+      severity = MESA_DEBUG_SEVERITY_NOTIFICATION;
+      break;
    default:
       unreachable("invalid debug type");
    }
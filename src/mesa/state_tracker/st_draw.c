@@ -65,6 +65,7 @@
 #include "util/u_prim.h"
 #include "util/u_draw.h"
 #include "util/u_upload_mgr.h"
+#include "util/u_cpu_trace.h"
 #include "draw/draw_context.h"
 #include "cso_cache/cso_context.h"
 
@@ -176,6 +177,7 @@ st_draw_vbo(struct gl_context *ctx,
             struct gl_transform_feedback_object *tfb_vertcount,
             unsigned stream)
 {
+   UTIL_CPU_TRACE_FUNC();
    struct st_context *st = st_context(ctx);
    struct pipe_draw_info info;
    unsigned i;
@@ -51,6 +51,7 @@
 #include "compiler/glsl/ir.h"
 #include "compiler/glsl/ir_optimization.h"
 #include "compiler/glsl/string_to_uint_map.h"
+#include "util/u_cpu_detect.h"
 
 static int
 type_size(const struct glsl_type *type)
@@ -250,49 +251,53 @@ st_nir_assign_uniform_locations(struct gl_context *ctx,
 void
 st_nir_opts(nir_shader *nir)
 {
+   struct set *skip = _mesa_pointer_set_create(NULL);
    bool progress;
 
    do {
       progress = false;
 
-      NIR_PASS_V(nir, nir_lower_vars_to_ssa);
+      NIR_LOOP_PASS_V(skip, nir, nir_lower_vars_to_ssa);
       
       /* Linking deals with unused inputs/outputs, but here we can remove
        * things local to the shader in the hopes that we can cleanup other
        * things. This pass will also remove variables with only stores, so we
        * might be able to make progress after it.
        */
-      NIR_PASS(progress, nir, nir_remove_dead_variables,
-               (nir_variable_mode)(nir_var_function_temp |
-                                   nir_var_shader_temp |
-                                   nir_var_mem_shared),
-               NULL);
+      NIR_LOOP_PASS(progress, skip, nir, nir_remove_dead_variables,
+                    (nir_variable_mode)(nir_var_function_temp |
+                                        nir_var_shader_temp |
+                                        nir_var_mem_shared),
+                    NULL);
 
-      NIR_PASS(progress, nir, nir_opt_copy_prop_vars);
-      NIR_PASS(progress, nir, nir_opt_dead_write_vars);
+      NIR_LOOP_PASS(progress, skip, nir, nir_opt_copy_prop_vars);
+      NIR_LOOP_PASS(progress, skip, nir, nir_opt_dead_write_vars);
 
       if (nir->options->lower_to_scalar) {
-         NIR_PASS_V(nir, nir_lower_alu_to_scalar, NULL, NULL);
-         NIR_PASS_V(nir, nir_lower_phis_to_scalar);
+         NIR_LOOP_PASS_V(skip, nir, nir_lower_alu_to_scalar, NULL, NULL);
+         NIR_LOOP_PASS_V(skip, nir, nir_lower_phis_to_scalar);
       }
 
-      NIR_PASS_V(nir, nir_lower_alu);
-      NIR_PASS_V(nir, nir_lower_pack);
-      NIR_PASS(progress, nir, nir_copy_prop);
-      NIR_PASS(progress, nir, nir_opt_remove_phis);
-      NIR_PASS(progress, nir, nir_opt_dce);
-      if (nir_opt_trivial_continues(nir)) {
+      NIR_LOOP_PASS_V(skip, nir, nir_lower_alu);
+      NIR_LOOP_PASS_V(skip, nir, nir_lower_pack);
+      NIR_LOOP_PASS(progress, skip, nir, nir_copy_prop);
+      NIR_LOOP_PASS(progress, skip, nir, nir_opt_remove_phis);
+      NIR_LOOP_PASS(progress, skip, nir, nir_opt_dce);
+      bool trivial_continues_progress = false;
+      NIR_LOOP_PASS(trivial_continues_progress, skip, nir,
+                    nir_opt_trivial_continues);
+      if (trivial_continues_progress) {
          progress = true;
-         NIR_PASS(progress, nir, nir_copy_prop);
-         NIR_PASS(progress, nir, nir_opt_dce);
+         NIR_LOOP_PASS(progress, skip, nir, nir_copy_prop);
+         NIR_LOOP_PASS(progress, skip, nir, nir_opt_dce);
       }
-      NIR_PASS(progress, nir, nir_opt_if, false);
-      NIR_PASS(progress, nir, nir_opt_dead_cf);
-      NIR_PASS(progress, nir, nir_opt_cse);
-      NIR_PASS(progress, nir, nir_opt_peephole_select, 8, true, true);
+      NIR_LOOP_PASS(progress, skip, nir, nir_opt_if, false);
+      NIR_LOOP_PASS(progress, skip, nir, nir_opt_dead_cf);
+      NIR_LOOP_PASS(progress, skip, nir, nir_opt_cse);
+      NIR_LOOP_PASS(progress, skip, nir, nir_opt_peephole_select, 8, true, true);
 
-      NIR_PASS(progress, nir, nir_opt_algebraic);
-      NIR_PASS(progress, nir, nir_opt_constant_folding);
+      NIR_LOOP_PASS(progress, skip, nir, nir_opt_algebraic);
+      NIR_LOOP_PASS(progress, skip, nir, nir_opt_constant_folding);
 
       if (!nir->info.flrp_lowered) {
          unsigned lower_flrp =
@@ -303,13 +308,13 @@ st_nir_opts(nir_shader *nir)
          if (lower_flrp) {
             bool lower_flrp_progress = false;
 
-            NIR_PASS(lower_flrp_progress, nir, nir_lower_flrp,
-                     lower_flrp,
-                     false /* always_precise */,
-                     nir->options->lower_ffma);
+            NIR_LOOP_PASS(lower_flrp_progress, skip, nir, nir_lower_flrp,
+                          lower_flrp,
+                          false /* always_precise */,
+                          nir->options->lower_ffma);
             if (lower_flrp_progress) {
-               NIR_PASS(progress, nir,
-                        nir_opt_constant_folding);
+               NIR_LOOP_PASS(progress, skip, nir,
+                             nir_opt_constant_folding);
                progress = true;
             }
          }
@@ -320,12 +325,14 @@ st_nir_opts(nir_shader *nir)
          nir->info.flrp_lowered = true;
       }
 
-      NIR_PASS(progress, nir, nir_opt_undef);
-      NIR_PASS(progress, nir, nir_opt_conditional_discard);
+      NIR_LOOP_PASS(progress, skip, nir, nir_opt_undef);
+      NIR_LOOP_PASS(progress, skip, nir, nir_opt_conditional_discard);
       if (nir->options->max_unroll_iterations) {
-         NIR_PASS(progress, nir, nir_opt_loop_unroll, (nir_variable_mode)0);
+         NIR_LOOP_PASS(progress, skip, nir, nir_opt_loop_unroll, (nir_variable_mode)0);
       }
    } while (progress);
+
+   _mesa_set_destroy(skip, NULL);
 }
 
 static void
@@ -477,6 +484,16 @@ st_glsl_to_nir_post_opts(struct st_context *st, struct gl_program *prog,
    _mesa_associate_uniform_storage(st->ctx, shader_program, prog);
 
    st_set_prog_affected_state_flags(prog);
+}
+
+/* Lowering of a linked stage that only touches \p prog and its NIR, so
+ * st_link_nir can run it for all stages at the same time.
+ */
+static void
+st_finalize_linked_nir(struct st_context *st, struct gl_program *prog,
+                       struct gl_shader_program *shader_program)
+{
+   nir_shader *nir = prog->nir;
 
    /* None of the builtins being lowered here can be produced by SPIR-V.  See
     * _mesa_builtin_uniform_desc. Also drivers that support packed uniform
@@ -515,15 +532,38 @@ st_glsl_to_nir_post_opts(struct st_context *st, struct gl_program *prog,
 
    if (st->allow_st_finalize_nir_twice)
       st_finalize_nir(st, prog, shader_program, nir, true);
+}
 
-   if (st->ctx->_Shader->Flags & GLSL_DUMP) {
-      _mesa_log("\n");
-      _mesa_log("NIR IR for linked %s program %d:\n",
-             _mesa_shader_stage_to_string(prog->info.stage),
-             shader_program->Name);
-      nir_print_shader(nir, _mesa_get_log_file());
-      _mesa_log("\n\n");
-   }
+struct st_link_job {
+   struct st_context *st;
+   struct gl_program *prog;
+   struct gl_shader_program *shader_program;
+   struct util_queue_fence fence;
+};
+
+static void
+st_finalize_linked_nir_job(void *data, int thread_index)
+{
+   struct st_link_job *job = (struct st_link_job *)data;
+
+   st_finalize_linked_nir(job->st, job->prog, job->shader_program);
+}
+
+static bool
+st_init_link_queue(struct st_context *st)
+{
+   if (util_queue_is_initialized(&st->link_queue))
+      return true;
+
+   util_cpu_detect();
+   if (util_cpu_caps.nr_cpus < 2)
+      return false;
+
+   /* The calling thread finalizes one of the stages itself. */
+   return util_queue_init(&st->link_queue, "st_link", MESA_SHADER_STAGES,
+                          MIN2(util_cpu_caps.nr_cpus - 1,
+                               MESA_SHADER_STAGES - 1),
+                          UTIL_QUEUE_INIT_RESIZE_IF_FULL);
 }
 
 static void
@@ -817,11 +857,47 @@ st_link_nir(struct gl_context *ctx,
       prev_info = info;
    }
 
+   for (unsigned i = 0; i < num_shaders; i++)
+      st_glsl_to_nir_post_opts(st, linked_shader[i]->Program, shader_program);
+
+   /* From here on, the stages don't depend on each other anymore. */
+   struct st_link_job jobs[MESA_SHADER_STAGES];
+   unsigned num_jobs = 0;
+
+   if (num_shaders > 1 && st_init_link_queue(st)) {
+      for (; num_jobs < num_shaders - 1; num_jobs++) {
+         struct st_link_job *job = &jobs[num_jobs];
+
+         job->st = st;
+         job->prog = linked_shader[num_jobs]->Program;
+         job->shader_program = shader_program;
+         util_queue_fence_init(&job->fence);
+         util_queue_add_job(&st->link_queue, job, &job->fence,
+                            st_finalize_linked_nir_job, NULL, 0);
+      }
+   }
+
+   for (unsigned i = num_jobs; i < num_shaders; i++)
+      st_finalize_linked_nir(st, linked_shader[i]->Program, shader_program);
+
+   for (unsigned i = 0; i < num_jobs; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+
    for (unsigned i = 0; i < num_shaders; i++) {
       struct gl_linked_shader *shader = linked_shader[i];
       struct gl_program *prog = shader->Program;
       struct st_program *stp = st_program(prog);
-      st_glsl_to_nir_post_opts(st, prog, shader_program);
+
+      if (ctx->_Shader->Flags & GLSL_DUMP) {
+         _mesa_log("\n");
+         _mesa_log("NIR IR for linked %s program %d:\n",
+                   _mesa_shader_stage_to_string(prog->info.stage),
+                   shader_program->Name);
+         nir_print_shader(prog->nir, _mesa_get_log_file());
+         _mesa_log("\n\n");
+      }
 
       /* Initialize st_vertex_program members. */
       if (shader->Stage == MESA_SHADER_VERTEX)
@@ -782,6 +782,372 @@ st_pbo_get_download_fs(struct st_context *st, enum pipe_texture_target target,
    return st->pbo.download_fs[conversion][target];
 }
 
+/* Helpers for the ETC2 RGB decoding shader below, which implements the
+ * same decoding as texcompress_etc.c.
+ */
+static nir_ssa_def *
+etc_bits(nir_builder *b, nir_ssa_def *v, unsigned offset, unsigned count)
+{
+   return nir_iand(b, nir_ushr(b, v, nir_imm_int(b, offset)),
+                   nir_imm_int(b, (1u << count) - 1));
+}
+
+/* Extend a color component to 8 bits by replicating its top bits. */
+static nir_ssa_def *
+etc_extend(nir_builder *b, nir_ssa_def *v, unsigned bits)
+{
+   return nir_ior(b, nir_ishl(b, v, nir_imm_int(b, 8 - bits)),
+                  nir_ushr(b, v, nir_imm_int(b, 2 * bits - 8)));
+}
+
+static nir_ssa_def *
+etc_clamp(nir_builder *b, nir_ssa_def *v)
+{
+   return nir_imin(b, nir_imax(b, v, nir_imm_int(b, 0)), nir_imm_int(b, 255));
+}
+
+/* Look idx up in a table of 8 bytes. */
+static nir_ssa_def *
+etc_lookup(nir_builder *b, const uint8_t table[8], nir_ssa_def *idx)
+{
+   uint32_t lo = table[0] | table[1] << 8 | table[2] << 16 | table[3] << 24;
+   uint32_t hi = table[4] | table[5] << 8 | table[6] << 16 | table[7] << 24;
+   nir_ssa_def *word = nir_bcsel(b, nir_ult(b, idx, nir_imm_int(b, 4)),
+                                 nir_imm_int(b, lo), nir_imm_int(b, hi));
+   nir_ssa_def *shift = nir_ishl(b, nir_iand(b, idx, nir_imm_int(b, 3)),
+                                 nir_imm_int(b, 3));
+
+   return nir_iand(b, nir_ushr(b, word, shift), nir_imm_int(b, 0xff));
+}
+
+static nir_ssa_def *
+etc_bswap16(nir_builder *b, nir_ssa_def *v)
+{
+   return nir_ior(b, nir_ishl(b, nir_iand(b, v, nir_imm_int(b, 0xff)),
+                              nir_imm_int(b, 8)),
+                  nir_ushr(b, v, nir_imm_int(b, 8)));
+}
+
+/**
+ * Decode the texel at (x, y) of an ETC2 RGB8 block, given as the four
+ * 16-bit words it is made of.  ETC1 blocks decode the same.
+ */
+static void
+build_etc2_rgb8_decode(nir_builder *b, nir_ssa_def *words[4],
+                       nir_ssa_def *x, nir_ssa_def *y, nir_ssa_def *rgb[3])
+{
+   static const uint8_t modifier_a[8] = { 2, 5, 9, 13, 18, 24, 33, 47 };
+   static const uint8_t modifier_b[8] = { 8, 17, 29, 42, 60, 80, 106, 183 };
+   static const uint8_t distance[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+   nir_ssa_def *zero = nir_imm_int(b, 0);
+
+   /* The block is stored big-endian, bit 63 is the top bit of byte 0. */
+   nir_ssa_def *hi = nir_ior(b, nir_ishl(b, etc_bswap16(b, words[0]),
+                                         nir_imm_int(b, 16)),
+                             etc_bswap16(b, words[1]));
+   nir_ssa_def *lo = nir_ior(b, nir_ishl(b, etc_bswap16(b, words[2]),
+                                         nir_imm_int(b, 16)),
+                             etc_bswap16(b, words[3]));
+
+   /* Pixel index */
+   nir_ssa_def *bit = nir_iadd(b, y, nir_ishl(b, x, nir_imm_int(b, 2)));
+   nir_ssa_def *lsb = nir_iand(b, nir_ushr(b, lo, bit), nir_imm_int(b, 1));
+   nir_ssa_def *msb = nir_iand(b, nir_ushr(b, lo, nir_iadd(b, bit,
+                                                             nir_imm_int(b, 16))),
+                               nir_imm_int(b, 1));
+   nir_ssa_def *idx = nir_ior(b, nir_ishl(b, msb, nir_imm_int(b, 1)), lsb);
+
+   nir_ssa_def *diff = nir_ine(b, etc_bits(b, hi, 1, 1), zero);
+   nir_ssa_def *flip = nir_ine(b, etc_bits(b, hi, 0, 1), zero);
+
+   /* Individual and differential modes */
+   nir_ssa_def *sub = nir_bcsel(b, flip, nir_uge(b, y, nir_imm_int(b, 2)),
+                                nir_uge(b, x, nir_imm_int(b, 2)));
+   nir_ssa_def *table = nir_bcsel(b, sub, etc_bits(b, hi, 2, 3),
+                                  etc_bits(b, hi, 5, 3));
+   nir_ssa_def *modifier =
+      nir_bcsel(b, nir_ine(b, lsb, zero), etc_lookup(b, modifier_b, table),
+                etc_lookup(b, modifier_a, table));
+   modifier = nir_bcsel(b, nir_ine(b, msb, zero), nir_ineg(b, modifier),
+                        modifier);
+
+   nir_ssa_def *overflow[3];
+   nir_ssa_def *etc1[3];
+   for (unsigned c = 0; c < 3; c++) {
+      nir_ssa_def *base = etc_bits(b, hi, 27 - 8 * c, 5);
+      nir_ssa_def *delta = etc_bits(b, hi, 24 - 8 * c, 3);
+      /* sign extend the 3-bit delta */
+      delta = nir_isub(b, delta, nir_ishl(b, nir_iand(b, delta,
+                                                       nir_imm_int(b, 4)),
+                                          nir_imm_int(b, 1)));
+      nir_ssa_def *sum = nir_iadd(b, base, delta);
+      overflow[c] = nir_ult(b, nir_imm_int(b, 31), sum);
+
+      nir_ssa_def *ind =
+         etc_extend(b, nir_bcsel(b, sub, etc_bits(b, hi, 24 - 8 * c, 4),
+                                 etc_bits(b, hi, 28 - 8 * c, 4)), 4);
+      nir_ssa_def *dif = etc_extend(b, nir_bcsel(b, sub, sum, base), 5);
+
+      etc1[c] = etc_clamp(b, nir_iadd(b, nir_bcsel(b, diff, dif, ind),
+                                      modifier));
+   }
+
+   /* T and H modes */
+   nir_ssa_def *t_base[2][3] = {
+      {
+         nir_ior(b, nir_ishl(b, etc_bits(b, hi, 27, 2), nir_imm_int(b, 2)),
+                 etc_bits(b, hi, 24, 2)),
+         etc_bits(b, hi, 20, 4),
+         etc_bits(b, hi, 16, 4),
+      }, {
+         etc_bits(b, hi, 12, 4),
+         etc_bits(b, hi, 8, 4),
+         etc_bits(b, hi, 4, 4),
+      },
+   };
+   nir_ssa_def *h_base[2][3] = {
+      {
+         etc_bits(b, hi, 27, 4),
+         nir_ior(b, nir_ishl(b, etc_bits(b, hi, 24, 3), nir_imm_int(b, 1)),
+                 etc_bits(b, hi, 20, 1)),
+         nir_ior(b, nir_ior(b, nir_ishl(b, etc_bits(b, hi, 19, 1),
+                                        nir_imm_int(b, 3)),
+                            nir_ishl(b, etc_bits(b, hi, 16, 2),
+                                     nir_imm_int(b, 1))),
+                 etc_bits(b, hi, 15, 1)),
+      }, {
+         etc_bits(b, hi, 11, 4),
+         nir_ior(b, nir_ishl(b, etc_bits(b, hi, 8, 3), nir_imm_int(b, 1)),
+                 etc_bits(b, hi, 7, 1)),
+         etc_bits(b, hi, 3, 4),
+      },
+   };
+
+   nir_ssa_def *t_distance =
+      etc_lookup(b, distance,
+                 nir_ior(b, nir_ishl(b, etc_bits(b, hi, 2, 2),
+                                     nir_imm_int(b, 1)),
+                         etc_bits(b, hi, 0, 1)));
+
+   nir_ssa_def *h_value[2];
+   for (unsigned i = 0; i < 2; i++) {
+      h_value[i] = nir_ior(b, nir_ior(b, nir_ishl(b, h_base[i][0],
+                                                  nir_imm_int(b, 8)),
+                                      nir_ishl(b, h_base[i][1],
+                                               nir_imm_int(b, 4))),
+                           h_base[i][2]);
+   }
+   nir_ssa_def *h_distance =
+      etc_lookup(b, distance,
+                 nir_ior(b, nir_ior(b, nir_ishl(b, etc_bits(b, hi, 2, 1),
+                                                nir_imm_int(b, 2)),
+                                    nir_ishl(b, etc_bits(b, hi, 0, 1),
+                                             nir_imm_int(b, 1))),
+                         nir_b2i32(b, nir_uge(b, h_value[0], h_value[1]))));
+
+   /* T: paint colors are c0, c1 + d, c1, c1 - d.
+    * H: paint colors are c0 + d, c0 - d, c1 + d, c1 - d.
+    */
+   nir_ssa_def *idx_odd = nir_ine(b, lsb, zero);
+   nir_ssa_def *t_offset =
+      nir_bcsel(b, idx_odd,
+                nir_bcsel(b, nir_ine(b, msb, zero), nir_ineg(b, t_distance),
+                          t_distance),
+                zero);
+   nir_ssa_def *h_offset =
+      nir_bcsel(b, idx_odd, nir_ineg(b, h_distance), h_distance);
+   nir_ssa_def *t_first = nir_ieq(b, idx, zero);
+   nir_ssa_def *h_first = nir_ieq(b, msb, zero);
+
+   /* Planar mode */
+   nir_ssa_def *planar[3][3] = {
+      {
+         etc_extend(b, etc_bits(b, hi, 25, 6), 6),
+         etc_extend(b, nir_ior(b, nir_ishl(b, etc_bits(b, hi, 24, 1),
+                                           nir_imm_int(b, 6)),
+                               etc_bits(b, hi, 17, 6)), 7),
+         etc_extend(b, nir_ior(b, nir_ior(b, nir_ishl(b, etc_bits(b, hi, 16, 1),
+                                                      nir_imm_int(b, 5)),
+                                          nir_ishl(b, etc_bits(b, hi, 11, 2),
+                                                   nir_imm_int(b, 3))),
+                               nir_ior(b, nir_ishl(b, etc_bits(b, hi, 8, 2),
+                                                   nir_imm_int(b, 1)),
+                                       etc_bits(b, hi, 7, 1))), 6),
+      }, {
+         etc_extend(b, nir_ior(b, nir_ishl(b, etc_bits(b, hi, 2, 5),
+                                           nir_imm_int(b, 1)),
+                               etc_bits(b, hi, 0, 1)), 6),
+         etc_extend(b, etc_bits(b, lo, 25, 7), 7),
+         etc_extend(b, nir_ior(b, nir_ishl(b, etc_bits(b, lo, 24, 1),
+                                           nir_imm_int(b, 5)),
+                               etc_bits(b, lo, 19, 5)), 6),
+      }, {
+         etc_extend(b, nir_ior(b, nir_ishl(b, etc_bits(b, lo, 16, 3),
+                                           nir_imm_int(b, 3)),
+                               etc_bits(b, lo, 13, 3)), 6),
+         etc_extend(b, nir_ior(b, nir_ishl(b, etc_bits(b, lo, 8, 5),
+                                           nir_imm_int(b, 2)),
+                               etc_bits(b, lo, 6, 2)), 7),
+         etc_extend(b, etc_bits(b, lo, 0, 6), 6),
+      },
+   };
+
+   nir_ssa_def *any_overflow =
+      nir_ior(b, nir_ior(b, overflow[0], overflow[1]), overflow[2]);
+   nir_ssa_def *etc2_mode = nir_iand(b, diff, any_overflow);
+
+   for (unsigned c = 0; c < 3; c++) {
+      nir_ssa_def *t =
+         etc_clamp(b, nir_iadd(b, etc_extend(b, nir_bcsel(b, t_first,
+                                                          t_base[0][c],
+                                                          t_base[1][c]), 4),
+                               t_offset));
+      nir_ssa_def *h =
+         etc_clamp(b, nir_iadd(b, etc_extend(b, nir_bcsel(b, h_first,
+                                                          h_base[0][c],
+                                                          h_base[1][c]), 4),
+                               h_offset));
+
+      /* (x * (H - O) + y * (V - O) + 4 * O + 2) >> 2 */
+      nir_ssa_def *o = planar[0][c];
+      nir_ssa_def *p =
+         nir_iadd(b, nir_imul(b, x, nir_isub(b, planar[1][c], o)),
+                  nir_imul(b, y, nir_isub(b, planar[2][c], o)));
+      p = nir_iadd(b, p, nir_iadd(b, nir_ishl(b, o, nir_imm_int(b, 2)),
+                                  nir_imm_int(b, 2)));
+      p = etc_clamp(b, nir_ishr(b, p, nir_imm_int(b, 2)));
+
+      nir_ssa_def *etc2 = nir_bcsel(b, overflow[0], t,
+                                    nir_bcsel(b, overflow[1], h, p));
+      rgb[c] = nir_bcsel(b, etc2_mode, etc2, etc1[c]);
+   }
+}
+
+static void *
+create_etc_decode_fs(struct st_context *st)
+{
+   struct pipe_screen *screen = st->pipe->screen;
+   struct nir_builder b;
+   const nir_shader_compiler_options *options =
+      st->ctx->Const.ShaderCompilerOptions[MESA_SHADER_FRAGMENT].NirOptions;
+   bool pos_is_sysval =
+      screen->get_param(screen, PIPE_CAP_TGSI_FS_POSITION_IS_SYSVAL);
+
+   nir_builder_init_simple_shader(&b, NULL, MESA_SHADER_FRAGMENT, options);
+
+   /* param = [ -xoffset + skip_blocks, -yoffset, stride, image_height ],
+    * all in blocks.
+    */
+   nir_variable *param_var =
+      nir_variable_create(b.shader, nir_var_uniform, glsl_vec4_type(), "param");
+   b.shader->num_uniforms += 4;
+   nir_ssa_def *param = nir_load_var(&b, param_var);
+
+   nir_variable *fragcoord =
+      nir_variable_create(b.shader, pos_is_sysval ? nir_var_system_value :
+                          nir_var_shader_in, glsl_vec4_type(), "gl_FragCoord");
+   fragcoord->data.location = pos_is_sysval ? SYSTEM_VALUE_FRAG_COORD
+                                            : VARYING_SLOT_POS;
+   nir_ssa_def *coord =
+      nir_f2i32(&b, nir_channels(&b, nir_load_var(&b, fragcoord),
+                                 TGSI_WRITEMASK_XY));
+
+   /* block_pos = param.xy + (coord.xy >> 2) */
+   nir_ssa_def *block_pos =
+      nir_iadd(&b, nir_channels(&b, param, TGSI_WRITEMASK_XY),
+               nir_ushr(&b, coord, nir_imm_int(&b, 2)));
+
+   /* addr = block_pos.x + block_pos.y * stride */
+   nir_ssa_def *block_addr =
+      nir_iadd(&b, nir_channel(&b, block_pos, 0),
+               nir_imul(&b, nir_channel(&b, block_pos, 1),
+                        nir_channel(&b, param, 2)));
+   if (st->pbo.layers) {
+      nir_variable *var = nir_variable_create(b.shader, nir_var_shader_in,
+                                              glsl_int_type(), "gl_Layer");
+      var->data.location = VARYING_SLOT_LAYER;
+      var->data.interpolation = INTERP_MODE_FLAT;
+
+      /* addr += image_height * layer */
+      block_addr = nir_iadd(&b, block_addr,
+                            nir_imul(&b, nir_load_var(&b, var),
+                                     nir_channel(&b, param, 3)));
+   }
+
+   /* The block, as R16G16B16A16_UINT */
+   nir_variable *tex_var =
+      nir_variable_create(b.shader, nir_var_uniform,
+                          glsl_sampler_type(GLSL_SAMPLER_DIM_BUF, false,
+                                            false, GLSL_TYPE_UINT), "tex");
+   tex_var->data.explicit_binding = true;
+   tex_var->data.binding = 0;
+
+   nir_deref_instr *tex_deref = nir_build_deref_var(&b, tex_var);
+
+   nir_tex_instr *tex = nir_tex_instr_create(b.shader, 3);
+   tex->op = nir_texop_txf;
+   tex->sampler_dim = GLSL_SAMPLER_DIM_BUF;
+   tex->coord_components = 1;
+   tex->dest_type = nir_type_uint;
+   tex->src[0].src_type = nir_tex_src_texture_deref;
+   tex->src[0].src = nir_src_for_ssa(&tex_deref->dest.ssa);
+   tex->src[1].src_type = nir_tex_src_sampler_deref;
+   tex->src[1].src = nir_src_for_ssa(&tex_deref->dest.ssa);
+   tex->src[2].src_type = nir_tex_src_coord;
+   tex->src[2].src = nir_src_for_ssa(block_addr);
+   nir_ssa_dest_init(&tex->instr, &tex->dest, 4, 32, NULL);
+   nir_builder_instr_insert(&b, &tex->instr);
+
+   nir_ssa_def *words[4];
+   for (unsigned i = 0; i < 4; i++)
+      words[i] = nir_channel(&b, &tex->dest.ssa, i);
+
+   nir_ssa_def *rgb[3];
+   nir_ssa_def *texel = nir_iand(&b, coord, nir_imm_int(&b, 3));
+   build_etc2_rgb8_decode(&b, words, nir_channel(&b, texel, 0),
+                          nir_channel(&b, texel, 1), rgb);
+
+   nir_ssa_def *result =
+      nir_vec4(&b,
+               nir_fmul_imm(&b, nir_u2f32(&b, rgb[0]), 1.0 / 255.0),
+               nir_fmul_imm(&b, nir_u2f32(&b, rgb[1]), 1.0 / 255.0),
+               nir_fmul_imm(&b, nir_u2f32(&b, rgb[2]), 1.0 / 255.0),
+               nir_imm_float(&b, 1.0));
+
+   nir_variable *color =
+      nir_variable_create(b.shader, nir_var_shader_out, glsl_vec4_type(),
+                          "gl_FragColor");
+   color->data.location = FRAG_RESULT_COLOR;
+
+   nir_store_var(&b, color, result, TGSI_WRITEMASK_XYZW);
+
+   return st_nir_finish_builtin_shader(st, b.shader, "st/pbo ETC2 decode FS");
+}
+
+/**
+ * Return a fragment shader which decodes ETC1 and ETC2 RGB8 blocks from a
+ * buffer into a UNORM color buffer, for drivers which lack these formats.
+ * The blocks are read as R16G16B16A16_UINT, and addressed like a PBO upload
+ * in blocks, except that the rectangle drawn is in pixels.
+ *
+ * Returns NULL for drivers which prefer TGSI, the CPU path is used then.
+ */
+void *
+st_pbo_get_etc_decode_fs(struct st_context *st)
+{
+   struct pipe_screen *screen = st->pipe->screen;
+
+   if (PIPE_SHADER_IR_NIR !=
+       screen->get_shader_param(screen, PIPE_SHADER_FRAGMENT,
+                                PIPE_SHADER_CAP_PREFERRED_IR))
+      return NULL;
+
+   if (!st->pbo.etc_decode_fs)
+      st->pbo.etc_decode_fs = create_etc_decode_fs(st);
+
+   return st->pbo.etc_decode_fs;
+}
+
 void
 st_init_pbo_helpers(struct st_context *st)
 {
@@ -844,6 +1210,11 @@ st_destroy_pbo_helpers(struct st_context *st)
       }
    }
 
+   if (st->pbo.etc_decode_fs) {
+      st->pipe->delete_fs_state(st->pipe, st->pbo.etc_decode_fs);
+      st->pbo.etc_decode_fs = NULL;
+   }
+
    if (st->pbo.gs) {
       st->pipe->delete_gs_state(st->pipe, st->pbo.gs);
       st->pbo.gs = NULL;
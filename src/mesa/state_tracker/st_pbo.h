@@ -94,6 +94,9 @@ st_pbo_get_download_fs(struct st_context *st, enum pipe_texture_target target,
                        enum pipe_format src_format,
                        enum pipe_format dst_format);
 
+void *
+st_pbo_get_etc_decode_fs(struct st_context *st);
+
 extern void
 st_init_pbo_helpers(struct st_context *st);
 
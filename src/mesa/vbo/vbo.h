@@ -219,6 +219,10 @@ vbo_save_EndCallList(struct gl_context *ctx);
 void
 vbo_delete_minmax_cache(struct gl_buffer_object *bufferObj);
 
+void
+vbo_minmax_cache_invalidate_range(struct gl_buffer_object *bufferObj,
+                                  GLintptr offset, GLsizeiptr size);
+
 void
 vbo_get_minmax_index_mapped(unsigned count, unsigned index_size,
                             unsigned restartIndex, bool restart,
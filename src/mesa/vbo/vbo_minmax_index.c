@@ -33,6 +33,7 @@
 #include "main/sse_minmax.h"
 #include "x86/common_x86_asm.h"
 #include "util/hash_table.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_memory.h"
 
 
@@ -101,6 +102,51 @@ vbo_delete_minmax_cache(struct gl_buffer_object *bufferObj)
 }
 
 
+/**
+ * Record that a range of the buffer was written. Only the cached ranges
+ * overlapping it will be dropped the next time the cache is used.
+ */
+void
+vbo_minmax_cache_invalidate_range(struct gl_buffer_object *bufferObj,
+                                  GLintptr offset, GLsizeiptr size)
+{
+   /* Nothing is cached for buffers never used for indices. */
+   if (!bufferObj->MinMaxCache)
+      return;
+
+   simple_mtx_lock(&bufferObj->MinMaxCacheMutex);
+
+   if (bufferObj->MinMaxCacheDirtyStart >= bufferObj->MinMaxCacheDirtyEnd) {
+      bufferObj->MinMaxCacheDirtyStart = offset;
+      bufferObj->MinMaxCacheDirtyEnd = offset + size;
+   } else {
+      bufferObj->MinMaxCacheDirtyStart =
+         MIN2(bufferObj->MinMaxCacheDirtyStart, offset);
+      bufferObj->MinMaxCacheDirtyEnd =
+         MAX2(bufferObj->MinMaxCacheDirtyEnd, offset + size);
+   }
+
+   simple_mtx_unlock(&bufferObj->MinMaxCacheMutex);
+}
+
+
+static void
+vbo_minmax_cache_remove_range(struct hash_table *cache,
+                              GLintptr start, GLintptr end)
+{
+   hash_table_foreach(cache, table_entry) {
+      struct minmax_cache_entry *entry = table_entry->data;
+      GLintptr entry_end = entry->key.offset +
+                           (GLintptr)entry->key.count * entry->key.index_size;
+
+      if (entry->key.offset < end && start < entry_end) {
+         _mesa_hash_table_remove(cache, table_entry);
+         free(entry);
+      }
+   }
+}
+
+
 static GLboolean
 vbo_get_minmax_cached(struct gl_buffer_object *bufferObj,
                       unsigned index_size, GLintptr offset, GLuint count,
@@ -118,7 +164,8 @@ vbo_get_minmax_cached(struct gl_buffer_object *bufferObj,
 
    simple_mtx_lock(&bufferObj->MinMaxCacheMutex);
 
-   if (bufferObj->MinMaxCacheDirty) {
+   if (bufferObj->MinMaxCacheDirty ||
+       bufferObj->MinMaxCacheDirtyStart < bufferObj->MinMaxCacheDirtyEnd) {
       /* Disable the cache permanently for this BO if the number of hits
        * is asymptotically less than the number of misses. This happens when
        * applications use the BO for streaming.
@@ -134,9 +181,20 @@ vbo_get_minmax_cached(struct gl_buffer_object *bufferObj,
          goto out_disable;
       }
 
-      _mesa_hash_table_clear(bufferObj->MinMaxCache, vbo_minmax_cache_delete_entry);
-      bufferObj->MinMaxCacheDirty = false;
-      goto out_invalidate;
+      if (bufferObj->MinMaxCacheDirty) {
+         _mesa_hash_table_clear(bufferObj->MinMaxCache, vbo_minmax_cache_delete_entry);
+         bufferObj->MinMaxCacheDirty = false;
+         bufferObj->MinMaxCacheDirtyStart = 0;
+         bufferObj->MinMaxCacheDirtyEnd = 0;
+         goto out_invalidate;
+      }
+
+      /* Partial updates keep the ranges they didn't touch. */
+      vbo_minmax_cache_remove_range(bufferObj->MinMaxCache,
+                                    bufferObj->MinMaxCacheDirtyStart,
+                                    bufferObj->MinMaxCacheDirtyEnd);
+      bufferObj->MinMaxCacheDirtyStart = 0;
+      bufferObj->MinMaxCacheDirtyEnd = 0;
    }
 
    key.index_size = index_size;
@@ -234,6 +292,49 @@ vbo_get_minmax_index_mapped(unsigned count, unsigned index_size,
                             const void *indices,
                             unsigned *min_index, unsigned *max_index)
 {
+#if defined(USE_SSE41)
+   /* This also runs on the application thread with glthread, for draws with
+    * user indices, so use SIMD for all index sizes and with primitive
+    * restart too.
+    */
+   if (util_cpu_caps.has_avx2) {
+      switch (index_size) {
+      case 4:
+         _mesa_uint_array_min_max_restart_avx2(indices, count, restart,
+                                               restartIndex, min_index,
+                                               max_index);
+         return;
+      case 2:
+         _mesa_ushort_array_min_max_restart_avx2(indices, count, restart,
+                                                 restartIndex, min_index,
+                                                 max_index);
+         return;
+      case 1:
+         _mesa_ubyte_array_min_max_restart_avx2(indices, count, restart,
+                                                restartIndex, min_index,
+                                                max_index);
+         return;
+      }
+   }
+
+   if (cpu_has_sse4_1) {
+      switch (index_size) {
+      case 4:
+         _mesa_uint_array_min_max_restart(indices, count, restart,
+                                          restartIndex, min_index, max_index);
+         return;
+      case 2:
+         _mesa_ushort_array_min_max_restart(indices, count, restart,
+                                            restartIndex, min_index, max_index);
+         return;
+      case 1:
+         _mesa_ubyte_array_min_max_restart(indices, count, restart,
+                                           restartIndex, min_index, max_index);
+         return;
+      }
+   }
+#endif
+
    switch (index_size) {
    case 4: {
       const GLuint *ui_indices = (const GLuint *)indices;
@@ -248,16 +349,10 @@ vbo_get_minmax_index_mapped(unsigned count, unsigned index_size,
          }
       }
       else {
-#if defined(USE_SSE41)
-         if (cpu_has_sse4_1) {
-            _mesa_uint_array_min_max(ui_indices, &min_ui, &max_ui, count);
+         for (unsigned i = 0; i < count; i++) {
+            if (ui_indices[i] > max_ui) max_ui = ui_indices[i];
+            if (ui_indices[i] < min_ui) min_ui = ui_indices[i];
          }
-         else
-#endif
-            for (unsigned i = 0; i < count; i++) {
-               if (ui_indices[i] > max_ui) max_ui = ui_indices[i];
-               if (ui_indices[i] < min_ui) min_ui = ui_indices[i];
-            }
       }
       *min_index = min_ui;
       *max_index = max_ui;
@@ -569,7 +569,6 @@ compile_vertex_list(struct gl_context *ctx)
       ctx->ListState.CurrentList->Flags |= DLIST_DANGLING_REFS;
 
    save->vertex_store->used += save->vertex_size * node->vertex_count;
-   save->prim_store->used += node->prim_count;
 
    /* Copy duplicated vertices
     */
@@ -581,6 +580,11 @@ compile_vertex_list(struct gl_context *ctx)
 
    merge_prims(ctx, node->prims, &node->prim_count);
 
+   /* Only account for the primitives left after merging, the dropped ones
+    * were at the end of the node's range of the store.
+    */
+   save->prim_store->used += node->prim_count;
+
    /* Correct the primitive starts, we can only do this here as copy_vertices
     * and convert_line_loop_to_strip above consume the uncorrected starts.
     * On the other hand the _vbo_loopback_vertex_list call below needs the
@@ -1182,7 +1186,18 @@ _save_End(void)
    save->prims[i].end = 1;
    save->prims[i].count = (save->vert_count - save->prims[i].start);
 
-   if (i == (GLint) save->prim_max - 1) {
+   /* Merge this primitive into the previous one if possible, like
+    * vbo_exec_End does.  This keeps lists made of many small glBegin/glEnd
+    * pairs from filling up the primitive store and being split into one
+    * vertex list node (and thus one draw) per VBO_SAVE_PRIM_SIZE primitives.
+    */
+   vbo_try_prim_conversion(&save->prims[i]);
+
+   if (i > 0 && vbo_merge_draws(ctx, true, &save->prims[i - 1],
+                                &save->prims[i]))
+      save->prim_count--;
+
+   if (save->prim_count == save->prim_max) {
       compile_vertex_list(ctx);
       assert(save->copied.nr == 0);
    }
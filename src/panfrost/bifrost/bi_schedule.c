@@ -158,11 +158,196 @@ bi_back_to_back(bi_block *block)
         return (count == 1);
 }
 
-/* Eventually, we'll need a proper scheduling, grouping instructions
- * into clauses and ordering/assigning grouped instructions to the
- * appropriate FMA/ADD slots. Right now we do the dumbest possible
- * thing just to have the scheduler stubbed out so we can focus on
- * codegen */
+/* Decides the unit an instruction goes to when scheduled. FMA is preferred
+ * whenever the class and its quirks allow it. */
+
+static bool
+bi_can_fma(bi_instruction *ins)
+{
+        bool can_fma = bi_class_props[ins->type] & BI_SCHED_FMA;
+
+        can_fma &= !bi_ambiguous_abs(ins);
+        can_fma &= !bi_icmp(ins);
+        can_fma &= !bi_imath_small(ins);
+
+        return can_fma;
+}
+
+/* Only plain ALU instructions are moved around and paired. Message-passing
+ * and control flow instructions stay in a bundle of their own, in program
+ * order, as do the _FAST ops which need the whole cycle. */
+
+static bool
+bi_is_pairable(bi_instruction *ins)
+{
+        unsigned props = bi_class_props[ins->type];
+
+        if (props & (BI_SCHED_HI_LATENCY | BI_SCHED_SLOW | BI_DATA_REG_SRC | BI_DATA_REG_DEST))
+                return false;
+
+        return props & BI_SCHED_ALL;
+}
+
+static bool
+bi_reads_index(bi_instruction *ins, unsigned index)
+{
+        if (!index)
+                return false;
+
+        bi_foreach_src(ins, s) {
+                if (ins->src[s] == index)
+                        return true;
+        }
+
+        return false;
+}
+
+/* Whether two instructions can't be reordered or executed in the same
+ * bundle, which reads all sources before writing any destination */
+
+static bool
+bi_depends(bi_instruction *a, bi_instruction *b)
+{
+        return bi_reads_index(b, a->dest) || bi_reads_index(a, b->dest) ||
+                (a->dest && a->dest == b->dest);
+}
+
+/* Mirrors bi_assign_uniform_constant_single: FMA reads zero from its fast
+ * zero port, while ADD needs the uniform/constant slot for it. */
+
+static bool
+bi_reads_constant_slot(bi_instruction *ins, bool fma)
+{
+        bi_foreach_src(ins, s) {
+                if (ins->src[s] & BIR_INDEX_CONSTANT)
+                        return true;
+
+                if (!fma && (ins->src[s] & BIR_INDEX_ZERO))
+                        return true;
+        }
+
+        return false;
+}
+
+static bool
+bi_reads_constant(bi_instruction *ins)
+{
+        bi_foreach_src(ins, s) {
+                if (ins->src[s] & BIR_INDEX_CONSTANT)
+                        return true;
+        }
+
+        return false;
+}
+
+/* Counts the register read ports a bundle needs. A source is a register
+ * unless it is special, and RA splits the index into 32-bit registers
+ * according to the swizzle, so we key on both (see bi_adjust_src_ra) */
+
+static unsigned
+bi_count_read_ports(bi_instruction **ins, unsigned count)
+{
+        unsigned keys[2 * BIR_SRC_COUNT][2];
+        unsigned ports = 0;
+
+        for (unsigned i = 0; i < count; ++i) {
+                bi_foreach_src(ins[i], s) {
+                        unsigned src = ins[i]->src[s];
+
+                        if (!src || (src & (BIR_SPECIAL & ~BIR_INDEX_REGISTER)))
+                                continue;
+
+                        unsigned size = nir_alu_type_get_type_size(ins[i]->src_types[s]);
+                        unsigned components_per_word = MAX2(32 / MAX2(size, 1), 1);
+                        unsigned offset = ins[i]->swizzle[s][0] / components_per_word;
+
+                        bool found = false;
+
+                        for (unsigned j = 0; j < ports; ++j)
+                                found |= keys[j][0] == src && keys[j][1] == offset;
+
+                        if (!found) {
+                                keys[ports][0] = src;
+                                keys[ports][1] = offset;
+                                ports++;
+                        }
+                }
+        }
+
+        return ports;
+}
+
+/* Checks the constraints bi_pack places on a bundle holding both an FMA and
+ * an ADD instruction */
+
+static bool
+bi_can_bundle(bi_instruction *fma, bi_instruction *add)
+{
+        if (bi_depends(fma, add))
+                return false;
+
+        /* One uniform/constant slot per bundle */
+        if (bi_reads_constant_slot(fma, true) && bi_reads_constant_slot(add, false))
+                return false;
+
+        /* Three read ports, but writing both units takes over port 3 */
+        bi_instruction *both[] = { fma, add };
+        unsigned max_reads = (fma->dest && add->dest) ? 2 : 3;
+
+        return bi_count_read_ports(both, 2) <= max_reads;
+}
+
+/* Looks ahead for an instruction which can share a bundle with ins, in the
+ * unit ins leaves free, and which can be moved up to it. */
+
+#define BI_PAIR_WINDOW 16
+
+static bi_instruction *
+bi_find_partner(bi_block *block, bi_instruction *ins)
+{
+        if (!bi_is_pairable(ins))
+                return NULL;
+
+        bool ins_fma = bi_can_fma(ins);
+        unsigned distance = 0;
+
+        bi_foreach_instr_in_block_from(block, cand, bi_next_op(ins)) {
+                if (++distance > BI_PAIR_WINDOW || !bi_is_pairable(cand))
+                        break;
+
+                if (bi_can_fma(cand) != ins_fma) {
+                        bi_instruction *fma = ins_fma ? ins : cand;
+                        bi_instruction *add = ins_fma ? cand : ins;
+
+                        /* Everything in between stays put, so the candidate
+                         * must be independent of it */
+                        bool blocked = false;
+
+                        bi_foreach_instr_in_block_from(block, mid, bi_next_op(ins)) {
+                                if (mid == cand)
+                                        break;
+
+                                if (bi_depends(mid, cand)) {
+                                        blocked = true;
+                                        break;
+                                }
+                        }
+
+                        if (!blocked && bi_can_bundle(fma, add))
+                                return cand;
+                }
+        }
+
+        return NULL;
+}
+
+/* Groups instructions into single-bundle clauses, pairing an FMA and an ADD
+ * instruction in the bundle where possible. A partner found further down the
+ * block is moved up next to the instruction it is paired with, so that
+ * liveness (and hence RA) sees the order the bundle actually executes in.
+ *
+ * Clauses of several bundles would save more, but that needs bi_pack to
+ * learn the multi-instruction clause formats first. */
 
 void
 bi_schedule(bi_context *ctx)
@@ -176,31 +361,38 @@ bi_schedule(bi_context *ctx)
 
                 list_inithead(&bblock->clauses);
 
-                bi_foreach_instr_in_block(bblock, ins) {
-                        /* Convenient time to lower */
+                /* Convenient time to lower */
+                bi_foreach_instr_in_block(bblock, ins)
                         bi_lower_fmov(ins);
 
-                        unsigned props = bi_class_props[ins->type];
-
+                bi_foreach_instr_in_block(bblock, ins) {
                         bi_clause *u = rzalloc(ctx, bi_clause);
                         u->bundle_count = 1;
 
                         /* Check for scheduling restrictions */
 
-                        bool can_fma = props & BI_SCHED_FMA;
-                        bool can_add = props & BI_SCHED_ADD;
-
-                        can_fma &= !bi_ambiguous_abs(ins);
-                        can_fma &= !bi_icmp(ins);
-                        can_fma &= !bi_imath_small(ins);
+                        bool can_fma = bi_can_fma(ins);
+                        bool can_add = bi_class_props[ins->type] & BI_SCHED_ADD;
 
                         assert(can_fma || can_add);
 
+                        bi_instruction *partner = bi_find_partner(bblock, ins);
+
                         if (can_fma)
                                 u->bundles[0].fma = ins;
                         else
                                 u->bundles[0].add = ins;
 
+                        if (partner) {
+                                if (can_fma)
+                                        u->bundles[0].add = partner;
+                                else
+                                        u->bundles[0].fma = partner;
+
+                                list_del(&partner->link);
+                                list_add(&partner->link, &ins->link);
+                        }
+
                         u->scoreboard_id = ids++;
 
                         if (is_first)
@@ -223,8 +415,18 @@ bi_schedule(bi_context *ctx)
                         /* Let's be optimistic, we'll fix up later */
                         u->back_to_back = true;
 
-                        u->constant_count = 1;
-                        u->constants[0] = ins->constant.u64;
+                        /* ALU bundles only need a constant quadword if they
+                         * read an immediate, and at most one of the pair does */
+                        if (!bi_is_pairable(ins)) {
+                                u->constant_count = 1;
+                                u->constants[0] = ins->constant.u64;
+                        } else if (bi_reads_constant(ins)) {
+                                u->constant_count = 1;
+                                u->constants[0] = ins->constant.u64;
+                        } else if (partner && bi_reads_constant(partner)) {
+                                u->constant_count = 1;
+                                u->constants[0] = partner->constant.u64;
+                        }
 
                         /* No indirect jumps yet */
                         if (ins->type == BI_BRANCH) {
@@ -237,6 +439,10 @@ bi_schedule(bi_context *ctx)
                         u->block = (struct bi_block *) block;
 
                         list_addtail(&u->link, &bblock->clauses);
+
+                        /* Skip over the partner we just moved */
+                        if (partner)
+                                ins = partner;
                 }
 
                 /* Back-to-back bit affects only the last clause of a block,
@@ -745,18 +745,31 @@ mir_choose_instruction(
         return instructions[best_index];
 }
 
+/* Number of bundles we try to put between a texture or load/store
+ * instruction and the first use of its result, so the latency is covered by
+ * ALU work rather than a stall. Early Midgards can't run texture
+ * instructions out-of-order, so everything after one waits on it there. */
+
+#define MIDGARD_LATENCY_BUNDLES 3
+#define MIDGARD_LATENCY_BUNDLES_NO_OOO 6
+
 /* Still, we don't choose instructions in a vacuum. We need a way to choose the
- * best bundle type (ALU, load/store, texture). Nondestructive. */
+ * best bundle type (ALU, load/store, texture). Nondestructive.
+ *
+ * ready_at[i] is the (backwards) bundle index at which instruction i entered
+ * the worklist, that is the bundle of its first consumer, and bundle_index
+ * the bundle being chosen. */
 
 static unsigned
 mir_choose_bundle(
+                compiler_context *ctx,
                 midgard_instruction **instructions,
                 uint16_t *liveness,
-                BITSET_WORD *worklist, unsigned count)
+                BITSET_WORD *worklist, unsigned count,
+                signed *ready_at, signed bundle_index)
 {
-        /* At the moment, our algorithm is very simple - use the bundle of the
-         * best instruction, regardless of what else could be scheduled
-         * alongside it. This is not optimal but it works okay for in-order */
+        /* Use the bundle of the best instruction, regardless of what else
+         * could be scheduled alongside it... */
 
         struct midgard_predicate predicate = {
                 .tag = ~0,
@@ -766,10 +779,35 @@ mir_choose_bundle(
 
         midgard_instruction *chosen = mir_choose_instruction(instructions, liveness, worklist, count, &predicate);
 
-        if (chosen)
-                return chosen->type;
-        else
+        if (!chosen)
                 return ~0;
+
+        if (chosen->type != TAG_TEXTURE_4 && chosen->type != TAG_LOAD_STORE_4)
+                return chosen->type;
+
+        /* ...unless it is a high latency instruction whose result would be
+         * consumed right away, and there's ALU work to fill the gap */
+
+        signed latency = (ctx->quirks & MIDGARD_NO_OOO) ?
+                MIDGARD_LATENCY_BUNDLES_NO_OOO : MIDGARD_LATENCY_BUNDLES;
+
+        unsigned i;
+        BITSET_FOREACH_SET(i, worklist, count) {
+                if (instructions[i] != chosen)
+                        continue;
+
+                if ((bundle_index - ready_at[i]) >= latency)
+                        return chosen->type;
+
+                break;
+        }
+
+        predicate.tag = TAG_ALU_4;
+
+        if (mir_choose_instruction(instructions, liveness, worklist, count, &predicate))
+                return TAG_ALU_4;
+
+        return chosen->type;
 }
 
 /* We want to choose an ALU instruction filling a given unit */
@@ -1368,6 +1406,16 @@ schedule_block(compiler_context *ctx, midgard_block *block)
         uint16_t *liveness = calloc(node_count, 2);
         mir_initialize_worklist(worklist, instructions, len);
 
+        /* Instructions without consumers in the block have no latency for us
+         * to hide, so they count as ready for long enough already */
+        BITSET_WORD *prev_worklist = malloc(sz);
+        signed *ready_at = malloc(len * sizeof(signed));
+
+        for (unsigned i = 0; i < len; ++i)
+                ready_at[i] = -MIDGARD_LATENCY_BUNDLES_NO_OOO;
+
+        signed bundle_index = 0;
+
         struct util_dynarray bundles;
         util_dynarray_init(&bundles, NULL);
 
@@ -1375,9 +1423,11 @@ schedule_block(compiler_context *ctx, midgard_block *block)
         unsigned blend_offset = 0;
 
         for (;;) {
-                unsigned tag = mir_choose_bundle(instructions, liveness, worklist, len);
+                unsigned tag = mir_choose_bundle(ctx, instructions, liveness, worklist, len, ready_at, bundle_index);
                 midgard_bundle bundle;
 
+                memcpy(prev_worklist, worklist, sz);
+
                 if (tag == TAG_TEXTURE_4)
                         bundle = mir_schedule_texture(instructions, liveness, worklist, len, ctx->stage != MESA_SHADER_FRAGMENT);
                 else if (tag == TAG_LOAD_STORE_4)
@@ -1389,6 +1439,15 @@ schedule_block(compiler_context *ctx, midgard_block *block)
 
                 util_dynarray_append(&bundles, midgard_bundle, bundle);
 
+                /* Note what this bundle made ready */
+                unsigned i;
+                BITSET_FOREACH_SET(i, worklist, len) {
+                        if (!BITSET_TEST(prev_worklist, i))
+                                ready_at[i] = bundle_index;
+                }
+
+                bundle_index++;
+
                 if (bundle.has_blend_constant)
                         blend_offset = block->quadword_count;
 
@@ -1428,6 +1487,8 @@ schedule_block(compiler_context *ctx, midgard_block *block)
 
 	free(instructions); /* Allocated by flatten_mir() */
 	free(worklist);
+        free(prev_worklist);
+        free(ready_at);
         free(liveness);
 }
 
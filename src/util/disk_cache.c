@@ -46,6 +46,7 @@
 
 #include "util/crc32.h"
 #include "util/debug.h"
+#include "util/os_file.h"
 #include "util/rand_xor.h"
 #include "util/u_atomic.h"
 #include "util/u_queue.h"
@@ -54,6 +55,7 @@
 #include "util/compiler.h"
 
 #include "disk_cache.h"
+#include "disk_cache_pack.h"
 
 /* Number of bits to mask off from a cache key to get an index. */
 #define CACHE_INDEX_KEY_BITS 16
@@ -89,6 +91,16 @@ struct disk_cache {
    /* Thread queue for compressing and writing cache entries to disk */
    struct util_queue cache_queue;
 
+   /* Single file storage, used instead of one file per entry when
+    * MESA_DISK_CACHE_SINGLE_FILE is set.
+    */
+   struct disk_cache_pack *pack;
+
+   /* Prebuilt pack file from MESA_DISK_CACHE_RO_DIR, looked up before the
+    * writeable cache.
+    */
+   struct disk_cache_pack *ro_pack;
+
    /* Seed for rand, which is used to pick a random directory */
    uint64_t seed_xorshift128plus[2];
 
@@ -105,6 +117,13 @@ struct disk_cache {
    /* Maximum size of all cached objects (in bytes). */
    uint64_t max_size;
 
+#ifdef HAVE_ZSTD
+   /* Compression level, and optional dictionary shared by all entries. */
+   int zstd_level;
+   ZSTD_CDict *zstd_cdict;
+   ZSTD_DDict *zstd_ddict;
+#endif
+
    /* Driver cache keys. */
    uint8_t *driver_keys_blob;
    size_t driver_keys_blob_size;
@@ -230,6 +249,16 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
    /* Assume failure. */
    cache->path_init_failed = true;
 
+   /* The read-only layer doesn't depend on the writeable cache being
+    * usable.
+    */
+   const char *ro_dir = getenv("MESA_DISK_CACHE_RO_DIR");
+   if (ro_dir) {
+      char *ro_path = ralloc_asprintf(local, "%s/pack", ro_dir);
+      if (ro_path)
+         cache->ro_pack = disk_cache_pack_open_read_only(cache, ro_path);
+   }
+
    /* Determine path for cache based on the first defined name as follows:
     *
     *   $MESA_GLSL_CACHE_DIR
@@ -298,6 +327,12 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
    if (cache->path == NULL)
       goto path_fail;
 
+   if (env_var_as_boolean("MESA_DISK_CACHE_SINGLE_FILE", false)) {
+      cache->pack = disk_cache_pack_open(cache, cache->path);
+      if (cache->pack == NULL)
+         goto path_fail;
+   }
+
    path = ralloc_asprintf(local, "%s/index", cache->path);
    if (path == NULL)
       goto path_fail;
@@ -375,6 +410,43 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
 
    cache->max_size = max_size;
 
+#ifdef HAVE_ZSTD
+   cache->zstd_level = env_var_as_unsigned("MESA_DISK_CACHE_ZSTD_LEVEL",
+                                           ZSTD_COMPRESSION_LEVEL);
+   cache->zstd_level = CLAMP(cache->zstd_level, 1, ZSTD_maxCLevel());
+
+   /* Shader binaries of a given driver have a lot in common, so a dictionary
+    * trained on them makes entries both smaller and faster to decompress.
+    * Entries record the ID of the dictionary they were compressed with, and
+    * fail to decompress with a different one.
+    */
+   const char *dict_path = getenv("MESA_DISK_CACHE_ZSTD_DICT");
+   if (dict_path) {
+      size_t dict_size;
+      char *dict = os_read_file(dict_path, &dict_size);
+
+      /* Raw content dictionaries have no ID, so their entries couldn't be
+       * told apart from ones compressed without a dictionary.  Only accept
+       * trained ones, as made by `zstd --train`.
+       */
+      if (dict && ZSTD_getDictID_fromDict(dict, dict_size)) {
+         cache->zstd_cdict = ZSTD_createCDict(dict, dict_size,
+                                              cache->zstd_level);
+         cache->zstd_ddict = ZSTD_createDDict(dict, dict_size);
+         free(dict);
+      }
+
+      if (!cache->zstd_cdict || !cache->zstd_ddict) {
+         fprintf(stderr, "Failed to load shader cache dictionary %s, "
+                 "ignoring.\n", dict_path);
+         ZSTD_freeCDict(cache->zstd_cdict);
+         ZSTD_freeDDict(cache->zstd_ddict);
+         cache->zstd_cdict = NULL;
+         cache->zstd_ddict = NULL;
+      }
+   }
+#endif
+
    /* 4 threads were chosen below because just about all modern CPUs currently
     * available that run Mesa have *at least* 4 cores. For these CPUs allowing
     * more threads can result in the queue being processed faster, thus
@@ -388,7 +460,8 @@ disk_cache_create(const char *gpu_name, const char *driver_id,
    util_queue_init(&cache->cache_queue, "disk$", 32, 4,
                    UTIL_QUEUE_INIT_RESIZE_IF_FULL |
                    UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY |
-                   UTIL_QUEUE_INIT_SET_FULL_THREAD_AFFINITY);
+                   UTIL_QUEUE_INIT_SET_FULL_THREAD_AFFINITY |
+                   UTIL_QUEUE_INIT_SHARED_CPU_LIMIT);
 
    cache->path_init_failed = false;
 
@@ -449,8 +522,19 @@ disk_cache_destroy(struct disk_cache *cache)
       util_queue_finish(&cache->cache_queue);
       util_queue_destroy(&cache->cache_queue);
       munmap(cache->index_mmap, cache->index_mmap_size);
+      disk_cache_pack_close(cache->pack);
    }
 
+   if (cache)
+      disk_cache_pack_close(cache->ro_pack);
+
+#ifdef HAVE_ZSTD
+   if (cache) {
+      ZSTD_freeCDict(cache->zstd_cdict);
+      ZSTD_freeDDict(cache->zstd_ddict);
+   }
+#endif
+
    ralloc_free(cache);
 }
 
@@ -689,6 +773,11 @@ disk_cache_remove(struct disk_cache *cache, const cache_key key)
 {
    struct stat sb;
 
+   if (cache->pack) {
+      disk_cache_pack_remove(cache->pack, key);
+      return;
+   }
+
    char *filename = get_cache_file(cache, key);
    if (filename == NULL) {
       return;
@@ -742,12 +831,41 @@ write_all(int fd, const void *buf, size_t count)
  */
 #define BUFSIZE 256 * 1024
 
+#ifdef HAVE_ZSTD
+/**
+ * Compresses \in_data with the cache's level and dictionary. Returns the
+ * compressed size, or 0 on failure.
+ */
+static size_t
+zstd_compress(struct disk_cache *cache, void *out, size_t out_size,
+              const void *in_data, size_t in_data_size)
+{
+   size_t ret;
+
+   if (cache->zstd_cdict) {
+      ZSTD_CCtx *cctx = ZSTD_createCCtx();
+      if (!cctx)
+         return 0;
+
+      ret = ZSTD_compress_usingCDict(cctx, out, out_size, in_data,
+                                     in_data_size, cache->zstd_cdict);
+      ZSTD_freeCCtx(cctx);
+   } else {
+      ret = ZSTD_compress(out, out_size, in_data, in_data_size,
+                          cache->zstd_level);
+   }
+
+   return ZSTD_isError(ret) ? 0 : ret;
+}
+#endif
+
 /**
  * Compresses cache entry in memory and writes it to disk. Returns the size
  * of the data written to disk.
  */
 static size_t
-deflate_and_write_to_disk(const void *in_data, size_t in_data_size, int dest,
+deflate_and_write_to_disk(struct disk_cache *cache,
+                          const void *in_data, size_t in_data_size, int dest,
                           const char *filename)
 {
 #ifdef HAVE_ZSTD
@@ -757,9 +875,8 @@ deflate_and_write_to_disk(const void *in_data, size_t in_data_size, int dest,
    size_t out_size = ZSTD_compressBound(in_data_size);
    void * out = malloc(out_size);
 
-   size_t ret = ZSTD_compress(out, out_size, in_data, in_data_size,
-                              ZSTD_COMPRESSION_LEVEL);
-   if (ZSTD_isError(ret)) {
+   size_t ret = zstd_compress(cache, out, out_size, in_data, in_data_size);
+   if (ret == 0) {
       free(out);
       return 0;
    }
@@ -895,6 +1012,93 @@ struct cache_entry_file_data {
    uint32_t uncompressed_size;
 };
 
+/**
+ * Compresses \in_data into a newly allocated buffer, returns NULL on failure.
+ */
+static void *
+deflate_to_memory(struct disk_cache *cache, const void *in_data,
+                  size_t in_data_size, size_t *out_size)
+{
+#ifdef HAVE_ZSTD
+   size_t bound = ZSTD_compressBound(in_data_size);
+   void *out = malloc(bound);
+   if (!out)
+      return NULL;
+
+   size_t ret = zstd_compress(cache, out, bound, in_data, in_data_size);
+   if (ret == 0) {
+      free(out);
+      return NULL;
+   }
+   *out_size = ret;
+   return out;
+#else
+   uLongf bound = compressBound(in_data_size);
+   void *out = malloc(bound);
+   if (!out)
+      return NULL;
+
+   if (compress2(out, &bound, in_data, in_data_size,
+                 Z_BEST_COMPRESSION) != Z_OK) {
+      free(out);
+      return NULL;
+   }
+   *out_size = bound;
+   return out;
+#endif
+}
+
+/* Entries in the single file storage have the same layout as regular cache
+ * files, so that a cache directory can be converted into a pack file by
+ * copying them.
+ */
+static void
+cache_put_pack(struct disk_cache_put_job *dc_job)
+{
+   struct disk_cache *cache = dc_job->cache;
+   struct cache_entry_file_data cf_data;
+   size_t compressed_size;
+
+   void *compressed = deflate_to_memory(cache, dc_job->data, dc_job->size,
+                                        &compressed_size);
+   if (!compressed)
+      return;
+
+   cf_data.crc32 = util_hash_crc32(dc_job->data, dc_job->size);
+   cf_data.uncompressed_size = dc_job->size;
+
+   const struct cache_item_metadata *md = &dc_job->cache_item_metadata;
+   size_t ck_size = cache->driver_keys_blob_size;
+   size_t md_size = sizeof(uint32_t);
+   if (md->type == CACHE_ITEM_TYPE_GLSL)
+      md_size += sizeof(uint32_t) + md->num_keys * sizeof(cache_key);
+
+   size_t entry_size = ck_size + md_size + sizeof(cf_data) + compressed_size;
+   uint8_t *entry = malloc(entry_size);
+   if (entry) {
+      uint8_t *p = entry;
+      memcpy(p, cache->driver_keys_blob, ck_size);
+      p += ck_size;
+      memcpy(p, &md->type, sizeof(uint32_t));
+      p += sizeof(uint32_t);
+      if (md->type == CACHE_ITEM_TYPE_GLSL) {
+         memcpy(p, &md->num_keys, sizeof(uint32_t));
+         p += sizeof(uint32_t);
+         memcpy(p, md->keys, md->num_keys * sizeof(cache_key));
+         p += md->num_keys * sizeof(cache_key);
+      }
+      memcpy(p, &cf_data, sizeof(cf_data));
+      p += sizeof(cf_data);
+      memcpy(p, compressed, compressed_size);
+
+      disk_cache_pack_write(cache->pack, dc_job->key, entry, entry_size,
+                            cache->max_size);
+      free(entry);
+   }
+
+   free(compressed);
+}
+
 static void
 cache_put(void *job, int thread_index)
 {
@@ -905,6 +1109,11 @@ cache_put(void *job, int thread_index)
    char *filename = NULL, *filename_tmp = NULL;
    struct disk_cache_put_job *dc_job = (struct disk_cache_put_job *) job;
 
+   if (dc_job->cache->pack) {
+      cache_put_pack(dc_job);
+      return;
+   }
+
    filename = get_cache_file(dc_job->cache, dc_job->key);
    if (filename == NULL)
       goto done;
@@ -1030,7 +1239,8 @@ cache_put(void *job, int thread_index)
     * rename them atomically to the destination filename, and also
     * perform an atomic increment of the total cache size.
     */
-   size_t file_size = deflate_and_write_to_disk(dc_job->data, dc_job->size,
+   size_t file_size = deflate_and_write_to_disk(dc_job->cache,
+                                                dc_job->data, dc_job->size,
                                                 fd, filename_tmp);
    if (file_size == 0) {
       unlink(filename_tmp);
@@ -1090,10 +1300,24 @@ disk_cache_put(struct disk_cache *cache, const cache_key key,
  * Decompresses cache entry, returns true if successful.
  */
 static bool
-inflate_cache_data(uint8_t *in_data, size_t in_data_size,
+inflate_cache_data(struct disk_cache *cache,
+                   uint8_t *in_data, size_t in_data_size,
                    uint8_t *out_data, size_t out_data_size)
 {
 #ifdef HAVE_ZSTD
+   /* Entries written without a dictionary stay readable after one is set. */
+   if (cache->zstd_ddict && ZSTD_getDictID_fromFrame(in_data, in_data_size)) {
+      ZSTD_DCtx *dctx = ZSTD_createDCtx();
+      if (!dctx)
+         return false;
+
+      size_t ret = ZSTD_decompress_usingDDict(dctx, out_data, out_data_size,
+                                              in_data, in_data_size,
+                                              cache->zstd_ddict);
+      ZSTD_freeDCtx(dctx);
+      return !ZSTD_isError(ret);
+   }
+
    size_t ret = ZSTD_decompress(out_data, out_data_size, in_data, in_data_size);
    return !ZSTD_isError(ret);
 #else
@@ -1130,6 +1354,76 @@ inflate_cache_data(uint8_t *in_data, size_t in_data_size,
 #endif
 }
 
+static void *
+cache_get_pack(struct disk_cache *cache, struct disk_cache_pack *pack,
+               const cache_key key, size_t *size)
+{
+   struct cache_entry_file_data cf_data;
+   uint8_t *uncompressed_data = NULL;
+   size_t entry_size;
+   uint32_t md_type;
+
+   uint8_t *entry = disk_cache_pack_read(pack, key, &entry_size);
+   if (!entry)
+      return NULL;
+
+   size_t ck_size = cache->driver_keys_blob_size;
+   size_t header_size = ck_size + sizeof(uint32_t);
+   if (entry_size < header_size)
+      goto fail;
+
+   /* Check for extremely unlikely hash collisions */
+   if (memcmp(cache->driver_keys_blob, entry, ck_size) != 0) {
+      assert(!"Mesa cache keys mismatch!");
+      goto fail;
+   }
+
+   /* Skip the cache item metadata, like disk_cache_get() does. */
+   memcpy(&md_type, entry + ck_size, sizeof(uint32_t));
+   if (md_type == CACHE_ITEM_TYPE_GLSL) {
+      uint32_t num_keys;
+
+      if (entry_size < header_size + sizeof(uint32_t))
+         goto fail;
+
+      memcpy(&num_keys, entry + header_size, sizeof(uint32_t));
+      header_size += sizeof(uint32_t) + (size_t)num_keys * sizeof(cache_key);
+   }
+
+   if (entry_size < header_size + sizeof(cf_data))
+      goto fail;
+
+   memcpy(&cf_data, entry + header_size, sizeof(cf_data));
+   header_size += sizeof(cf_data);
+
+   uncompressed_data = malloc(cf_data.uncompressed_size);
+   if (!uncompressed_data)
+      goto fail;
+
+   if (!inflate_cache_data(cache, entry + header_size,
+                           entry_size - header_size,
+                           uncompressed_data, cf_data.uncompressed_size))
+      goto fail;
+
+   /* Check the data for corruption */
+   if (cf_data.crc32 != util_hash_crc32(uncompressed_data,
+                                        cf_data.uncompressed_size))
+      goto fail;
+
+   free(entry);
+
+   if (size)
+      *size = cf_data.uncompressed_size;
+
+   return uncompressed_data;
+
+ fail:
+   free(uncompressed_data);
+   free(entry);
+
+   return NULL;
+}
+
 void *
 disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
 {
@@ -1165,6 +1459,18 @@ disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
       return blob;
    }
 
+   if (cache->ro_pack) {
+      void *data = cache_get_pack(cache, cache->ro_pack, key, size);
+      if (data)
+         return data;
+   }
+
+   if (cache->path_init_failed)
+      return NULL;
+
+   if (cache->pack)
+      return cache_get_pack(cache, cache->pack, key, size);
+
    filename = get_cache_file(cache, key);
    if (filename == NULL)
       goto fail;
@@ -1239,7 +1545,7 @@ disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
 
    /* Uncompress the cache data */
    uncompressed_data = malloc(cf_data.uncompressed_size);
-   if (!inflate_cache_data(data, cache_data_size, uncompressed_data,
+   if (!inflate_cache_data(cache, data, cache_data_size, uncompressed_data,
                            cf_data.uncompressed_size))
       goto fail;
 
@@ -1312,6 +1618,9 @@ disk_cache_has_key(struct disk_cache *cache, const cache_key key)
       return cache->blob_get_cb(key, CACHE_KEY_SIZE, &blob, sizeof(uint32_t));
    }
 
+   if (cache->ro_pack && disk_cache_pack_contains(cache->ro_pack, key))
+      return true;
+
    if (cache->path_init_failed)
       return false;
 
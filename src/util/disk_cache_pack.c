@@ -0,0 +1,705 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifdef ENABLE_SHADER_CACHE
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "c11/threads.h"
+#include "util/macros.h"
+#include "util/ralloc.h"
+#include "util/u_atomic.h"
+
+#include "disk_cache_pack.h"
+
+#define PACK_FILE_NAME "pack"
+
+#define PACK_MAGIC "MESAPACK"
+
+/* Bump whenever the layout of the file changes.  Files with a different
+ * version are discarded.
+ */
+#define PACK_VERSION 1
+
+/* Number of slots in the hash index.  This leaves room for a few hundred
+ * thousand entries at a reasonable load factor, and the index is a sparse
+ * file so unused slots don't take any disk space.
+ */
+#define PACK_INDEX_SLOTS (1 << 18)
+
+/* How many slots to probe from the home slot of a key before giving up. */
+#define PACK_INDEX_MAX_PROBES 64
+
+/* Slot offsets for free and removed slots.  Neither can be the offset of an
+ * entry, since the header and the index come first in the file.
+ */
+#define PACK_SLOT_EMPTY 0
+#define PACK_SLOT_REMOVED UINT64_MAX
+
+/* Upper bound on the number of writes to skip compaction for after it
+ * failed, see disk_cache_pack::compact_backoff.
+ */
+#define PACK_MAX_COMPACT_BACKOFF 1024
+
+struct pack_header {
+   char magic[8];
+   uint32_t version;
+   uint32_t num_slots;
+
+   /* Set once compaction has replaced this file with a new one. */
+   uint32_t obsolete;
+   uint32_t padding;
+};
+
+struct pack_slot {
+   uint8_t key[CACHE_KEY_SIZE];
+   uint32_t size;
+   uint64_t offset;
+};
+
+/* Header preceding the data of every entry.  Readers look up the index
+ * without taking any lock, so they check this against the slot they found
+ * to detect racing with a writer.
+ */
+struct pack_entry {
+   uint8_t key[CACHE_KEY_SIZE];
+   uint32_t size;
+};
+
+#define PACK_DATA_START (sizeof(struct pack_header) + \
+                         PACK_INDEX_SLOTS * sizeof(struct pack_slot))
+
+struct disk_cache_pack {
+   char *path;
+   int fd;
+
+   /* Opened with disk_cache_pack_open_read_only(). */
+   bool read_only;
+
+   /* Shared mapping of the header and the index. */
+   struct pack_header *header;
+   struct pack_slot *slots;
+
+   /* Serializes the threads of this process.  Writers of different
+    * processes are serialized by locking the file.
+    */
+   mtx_t mutex;
+
+   /* After a failed compaction, the number of writes to wait for before
+    * trying again, and how many of them are left.  Doubles on every
+    * failure so that e.g. a full disk doesn't make every write copy the
+    * whole file.
+    */
+   unsigned compact_backoff;
+   unsigned compact_skip;
+};
+
+struct live_entry {
+   uint64_t offset;
+   uint32_t size;
+};
+
+static bool
+pread_all(int fd, void *buf, size_t count, uint64_t offset)
+{
+   char *in = buf;
+   ssize_t read_ret;
+   size_t done;
+
+   for (done = 0; done < count; done += read_ret) {
+      read_ret = pread(fd, in + done, count - done, offset + done);
+      if (read_ret == -1 || read_ret == 0)
+         return false;
+   }
+   return true;
+}
+
+static bool
+pwrite_all(int fd, const void *buf, size_t count, uint64_t offset)
+{
+   const char *out = buf;
+   ssize_t written;
+   size_t done;
+
+   for (done = 0; done < count; done += written) {
+      written = pwrite(fd, out + done, count - done, offset + done);
+      if (written == -1)
+         return false;
+   }
+   return true;
+}
+
+static int
+lock_pack_file(int fd)
+{
+#ifdef HAVE_FLOCK
+   return flock(fd, LOCK_EX);
+#else
+   struct flock lock = {
+      .l_start = 0,
+      .l_len = 0, /* entire file */
+      .l_type = F_WRLCK,
+      .l_whence = SEEK_SET
+   };
+   return fcntl(fd, F_SETLKW, &lock);
+#endif
+}
+
+static void
+unlock_pack_file(int fd)
+{
+#ifdef HAVE_FLOCK
+   flock(fd, LOCK_UN);
+#else
+   struct flock lock = {
+      .l_start = 0,
+      .l_len = 0, /* entire file */
+      .l_type = F_UNLCK,
+      .l_whence = SEEK_SET
+   };
+   fcntl(fd, F_SETLK, &lock);
+#endif
+}
+
+/* Truncate the file to an empty header and index. */
+static bool
+init_pack_file(int fd)
+{
+   struct pack_header header = {
+      .version = PACK_VERSION,
+      .num_slots = PACK_INDEX_SLOTS,
+   };
+
+   memcpy(header.magic, PACK_MAGIC, sizeof(header.magic));
+
+   if (ftruncate(fd, 0) == -1 || ftruncate(fd, PACK_DATA_START) == -1)
+      return false;
+
+   return pwrite_all(fd, &header, sizeof(header), 0);
+}
+
+static bool
+is_valid_header(const struct pack_header *header)
+{
+   return memcmp(header->magic, PACK_MAGIC, sizeof(header->magic)) == 0 &&
+          header->version == PACK_VERSION &&
+          header->num_slots == PACK_INDEX_SLOTS;
+}
+
+static bool
+open_read_only_pack_file(struct disk_cache_pack *pack)
+{
+   struct pack_header header;
+   struct stat sb;
+   void *map;
+
+   pack->fd = open(pack->path, O_RDONLY | O_CLOEXEC);
+   if (pack->fd == -1)
+      return false;
+
+   if (fstat(pack->fd, &sb) == -1 ||
+       sb.st_size < (off_t)PACK_DATA_START ||
+       !pread_all(pack->fd, &header, sizeof(header), 0) ||
+       !is_valid_header(&header))
+      goto fail;
+
+   map = mmap(NULL, PACK_DATA_START, PROT_READ, MAP_SHARED, pack->fd, 0);
+   if (map == MAP_FAILED)
+      goto fail;
+
+   pack->header = map;
+   pack->slots = (struct pack_slot *)(pack->header + 1);
+   return true;
+
+ fail:
+   close(pack->fd);
+   pack->fd = -1;
+   return false;
+}
+
+static bool
+open_pack_file(struct disk_cache_pack *pack)
+{
+   struct pack_header header;
+   struct stat sb;
+   void *map;
+
+   if (pack->read_only)
+      return open_read_only_pack_file(pack);
+
+   pack->fd = open(pack->path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+   if (pack->fd == -1)
+      return false;
+
+   /* Initialize the file if it's new or was written by an incompatible
+    * version of Mesa.
+    */
+   if (lock_pack_file(pack->fd) == -1)
+      goto fail;
+
+   if (fstat(pack->fd, &sb) == -1) {
+      unlock_pack_file(pack->fd);
+      goto fail;
+   }
+
+   if (sb.st_size < (off_t)PACK_DATA_START ||
+       !pread_all(pack->fd, &header, sizeof(header), 0) ||
+       !is_valid_header(&header)) {
+      if (!init_pack_file(pack->fd)) {
+         unlock_pack_file(pack->fd);
+         goto fail;
+      }
+   }
+
+   unlock_pack_file(pack->fd);
+
+   /* We map this shared so that other processes see the entries we add. */
+   map = mmap(NULL, PACK_DATA_START, PROT_READ | PROT_WRITE, MAP_SHARED,
+              pack->fd, 0);
+   if (map == MAP_FAILED)
+      goto fail;
+
+   pack->header = map;
+   pack->slots = (struct pack_slot *)(pack->header + 1);
+   return true;
+
+ fail:
+   close(pack->fd);
+   pack->fd = -1;
+   return false;
+}
+
+static void
+close_pack_file(struct disk_cache_pack *pack)
+{
+   if (pack->fd == -1)
+      return;
+
+   munmap(pack->header, PACK_DATA_START);
+   close(pack->fd);
+   pack->fd = -1;
+   pack->header = NULL;
+   pack->slots = NULL;
+}
+
+/* Switch to the file that replaced ours, if compaction happened since we
+ * opened it.
+ */
+static bool
+reopen_if_obsolete(struct disk_cache_pack *pack)
+{
+   if (pack->read_only)
+      return pack->fd != -1;
+
+   if (pack->fd != -1 && !p_atomic_read(&pack->header->obsolete))
+      return true;
+
+   close_pack_file(pack);
+   return open_pack_file(pack);
+}
+
+/* Take the file lock on the current file. */
+static bool
+lock_current_file(struct disk_cache_pack *pack)
+{
+   while (true) {
+      if (!reopen_if_obsolete(pack))
+         return false;
+
+      if (lock_pack_file(pack->fd) == -1)
+         return false;
+
+      if (!p_atomic_read(&pack->header->obsolete))
+         return true;
+
+      unlock_pack_file(pack->fd);
+   }
+}
+
+static uint32_t
+home_slot(const uint8_t *key)
+{
+   return (key[0] | key[1] << 8 | key[2] << 16 | (uint32_t)key[3] << 24) &
+          (PACK_INDEX_SLOTS - 1);
+}
+
+static struct pack_slot *
+find_slot(struct pack_slot *slots, const uint8_t *key)
+{
+   const uint32_t home = home_slot(key);
+
+   for (unsigned i = 0; i < PACK_INDEX_MAX_PROBES; i++) {
+      struct pack_slot *slot = &slots[(home + i) & (PACK_INDEX_SLOTS - 1)];
+
+      if (slot->offset == PACK_SLOT_EMPTY)
+         return NULL;
+
+      if (slot->offset != PACK_SLOT_REMOVED &&
+          memcmp(slot->key, key, CACHE_KEY_SIZE) == 0)
+         return slot;
+   }
+
+   return NULL;
+}
+
+static void
+insert_slot(struct pack_slot *slots, const uint8_t *key, uint32_t size,
+            uint64_t offset)
+{
+   const uint32_t home = home_slot(key);
+   struct pack_slot *slot = &slots[home];
+
+   /* If there's no free slot close enough, the entry in the home slot is
+    * dropped from the index.  Its data is discarded by the next compaction.
+    */
+   for (unsigned i = 0; i < PACK_INDEX_MAX_PROBES; i++) {
+      struct pack_slot *s = &slots[(home + i) & (PACK_INDEX_SLOTS - 1)];
+
+      if (s->offset == PACK_SLOT_EMPTY || s->offset == PACK_SLOT_REMOVED) {
+         slot = s;
+         break;
+      }
+   }
+
+   memcpy(slot->key, key, CACHE_KEY_SIZE);
+   slot->size = size;
+   slot->offset = offset;
+}
+
+static int
+compare_live_entries(const void *a, const void *b)
+{
+   const struct live_entry *ea = a, *eb = b;
+
+   /* Most recently written, i.e. highest offset, first. */
+   return ea->offset < eb->offset ? 1 : ea->offset > eb->offset ? -1 : 0;
+}
+
+/* Write the most recently added entries that fit in \budget bytes to a new
+ * file and atomically replace the current one with it.  Must be called with
+ * the file lock held.  Returns false if the file couldn't be replaced.
+ */
+static bool
+compact_pack_file(struct disk_cache_pack *pack, uint64_t budget)
+{
+   struct live_entry *entries = NULL;
+   struct pack_slot *slots = NULL;
+   char *tmp_path = NULL;
+   unsigned count = 0, keep = 0;
+   uint64_t total = 0, dst = PACK_DATA_START;
+   bool compacted = false;
+   int fd = -1;
+
+   entries = malloc(PACK_INDEX_SLOTS * sizeof(*entries));
+   slots = calloc(PACK_INDEX_SLOTS, sizeof(*slots));
+   if (!entries || !slots)
+      goto out;
+
+   for (unsigned i = 0; i < PACK_INDEX_SLOTS; i++) {
+      const uint64_t offset = pack->slots[i].offset;
+
+      if (offset != PACK_SLOT_EMPTY && offset != PACK_SLOT_REMOVED) {
+         entries[count].offset = offset;
+         entries[count].size = pack->slots[i].size;
+         count++;
+      }
+   }
+
+   qsort(entries, count, sizeof(*entries), compare_live_entries);
+
+   while (keep < count &&
+          total + sizeof(struct pack_entry) + entries[keep].size <= budget)
+      total += sizeof(struct pack_entry) + entries[keep++].size;
+
+   if (asprintf(&tmp_path, "%s.tmp", pack->path) == -1) {
+      tmp_path = NULL;
+      goto out;
+   }
+
+   fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+   if (fd == -1)
+      goto out;
+
+   if (!init_pack_file(fd))
+      goto fail;
+
+   /* Copy the entries oldest first to preserve their order. */
+   for (unsigned i = keep; i-- > 0;) {
+      const size_t entry_size = sizeof(struct pack_entry) + entries[i].size;
+      struct pack_entry *entry = malloc(entry_size);
+
+      if (!entry ||
+          !pread_all(pack->fd, entry, entry_size, entries[i].offset)) {
+         free(entry);
+         goto fail;
+      }
+
+      /* Skip anything a racing writer left half updated. */
+      if (entry->size == entries[i].size &&
+          !find_slot(slots, entry->key)) {
+         if (!pwrite_all(fd, entry, entry_size, dst)) {
+            free(entry);
+            goto fail;
+         }
+
+         insert_slot(slots, entry->key, entry->size, dst);
+         dst += entry_size;
+      }
+
+      free(entry);
+   }
+
+   if (!pwrite_all(fd, slots, PACK_INDEX_SLOTS * sizeof(*slots),
+                   sizeof(struct pack_header)))
+      goto fail;
+
+   /* Make sure the new file is complete on disk before it replaces the
+    * old one, or a crash could leave us with a truncated cache.
+    */
+   if (fsync(fd) == -1)
+      goto fail;
+
+   /* Replace the file, then let everyone who still has the old one open
+    * know they should switch.
+    */
+   if (rename(tmp_path, pack->path) == -1)
+      goto fail;
+
+   p_atomic_set(&pack->header->obsolete, 1);
+   compacted = true;
+   goto out;
+
+ fail:
+   unlink(tmp_path);
+ out:
+   if (fd != -1)
+      close(fd);
+   free(tmp_path);
+   free(slots);
+   free(entries);
+   return compacted;
+}
+
+struct disk_cache_pack *
+disk_cache_pack_open(void *mem_ctx, const char *cache_dir)
+{
+   STATIC_ASSERT(sizeof(struct pack_slot) == 32);
+
+   struct disk_cache_pack *pack = rzalloc(mem_ctx, struct disk_cache_pack);
+   if (!pack)
+      return NULL;
+
+   pack->path = ralloc_asprintf(pack, "%s/%s", cache_dir, PACK_FILE_NAME);
+   if (!pack->path || !open_pack_file(pack)) {
+      ralloc_free(pack);
+      return NULL;
+   }
+
+   mtx_init(&pack->mutex, mtx_plain);
+   return pack;
+}
+
+struct disk_cache_pack *
+disk_cache_pack_open_read_only(void *mem_ctx, const char *path)
+{
+   struct disk_cache_pack *pack = rzalloc(mem_ctx, struct disk_cache_pack);
+   if (!pack)
+      return NULL;
+
+   pack->read_only = true;
+   pack->path = ralloc_strdup(pack, path);
+   if (!pack->path || !open_pack_file(pack)) {
+      ralloc_free(pack);
+      return NULL;
+   }
+
+   mtx_init(&pack->mutex, mtx_plain);
+   return pack;
+}
+
+void
+disk_cache_pack_close(struct disk_cache_pack *pack)
+{
+   if (!pack)
+      return;
+
+   close_pack_file(pack);
+   mtx_destroy(&pack->mutex);
+   ralloc_free(pack);
+}
+
+void *
+disk_cache_pack_read(struct disk_cache_pack *pack, const cache_key key,
+                     size_t *size)
+{
+   struct pack_entry *entry = NULL;
+   struct pack_slot *slot;
+   size_t entry_size;
+   uint64_t offset;
+
+   mtx_lock(&pack->mutex);
+
+   if (!reopen_if_obsolete(pack))
+      goto fail;
+
+   slot = find_slot(pack->slots, key);
+   if (!slot)
+      goto fail;
+
+   offset = slot->offset;
+   entry_size = sizeof(*entry) + slot->size;
+
+   entry = malloc(entry_size);
+   if (!entry || !pread_all(pack->fd, entry, entry_size, offset))
+      goto fail;
+
+   mtx_unlock(&pack->mutex);
+
+   if (memcmp(entry->key, key, CACHE_KEY_SIZE) != 0 ||
+       entry->size != entry_size - sizeof(*entry)) {
+      free(entry);
+      return NULL;
+   }
+
+   *size = entry->size;
+   memmove(entry, entry + 1, entry->size);
+   return entry;
+
+ fail:
+   mtx_unlock(&pack->mutex);
+   free(entry);
+   return NULL;
+}
+
+bool
+disk_cache_pack_contains(struct disk_cache_pack *pack, const cache_key key)
+{
+   bool found;
+
+   mtx_lock(&pack->mutex);
+   found = reopen_if_obsolete(pack) && find_slot(pack->slots, key) != NULL;
+   mtx_unlock(&pack->mutex);
+
+   return found;
+}
+
+void
+disk_cache_pack_write(struct disk_cache_pack *pack, const cache_key key,
+                      const void *data, size_t size, uint64_t max_size)
+{
+   const uint64_t entry_size = sizeof(struct pack_entry) + size;
+   struct pack_entry entry;
+   struct stat sb;
+
+   if (pack->read_only || size > UINT32_MAX)
+      return;
+
+   memcpy(entry.key, key, CACHE_KEY_SIZE);
+   entry.size = size;
+
+   mtx_lock(&pack->mutex);
+
+   if (!lock_current_file(pack))
+      goto out;
+
+   /* Another process may have beaten us to it. */
+   if (find_slot(pack->slots, key))
+      goto out_unlock;
+
+   if (fstat(pack->fd, &sb) == -1)
+      goto out_unlock;
+
+   if (sb.st_size > (off_t)PACK_DATA_START &&
+       sb.st_size - PACK_DATA_START + entry_size > max_size) {
+      if (pack->compact_skip) {
+         /* Compaction failed recently, keep growing the file for now. */
+         pack->compact_skip--;
+         goto write;
+      }
+
+      /* Only keep up to half of the maximum size so that we don't have to
+       * compact again on the very next write.
+       */
+      if (compact_pack_file(pack, max_size / 2 > entry_size ?
+                            max_size / 2 - entry_size : 0)) {
+         pack->compact_backoff = 0;
+      } else {
+         pack->compact_backoff = MIN2(MAX2(pack->compact_backoff * 2, 1),
+                                      PACK_MAX_COMPACT_BACKOFF);
+         pack->compact_skip = pack->compact_backoff;
+         goto write;
+      }
+
+      unlock_pack_file(pack->fd);
+      if (!lock_current_file(pack))
+         goto out;
+
+      if (fstat(pack->fd, &sb) == -1)
+         goto out_unlock;
+   }
+
+ write:
+   if (!pwrite_all(pack->fd, &entry, sizeof(entry), sb.st_size) ||
+       !pwrite_all(pack->fd, data, size, sb.st_size + sizeof(entry))) {
+      if (ftruncate(pack->fd, sb.st_size) == -1) {
+         /* Nothing references the partial entry, leave it alone. */
+      }
+      goto out_unlock;
+   }
+
+   insert_slot(pack->slots, key, size, sb.st_size);
+
+ out_unlock:
+   unlock_pack_file(pack->fd);
+ out:
+   mtx_unlock(&pack->mutex);
+}
+
+void
+disk_cache_pack_remove(struct disk_cache_pack *pack, const cache_key key)
+{
+   if (pack->read_only)
+      return;
+
+   mtx_lock(&pack->mutex);
+
+   if (lock_current_file(pack)) {
+      struct pack_slot *slot = find_slot(pack->slots, key);
+      if (slot)
+         slot->offset = PACK_SLOT_REMOVED;
+
+      unlock_pack_file(pack->fd);
+   }
+
+   mtx_unlock(&pack->mutex);
+}
+
+#endif /* ENABLE_SHADER_CACHE */
@@ -0,0 +1,79 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef DISK_CACHE_PACK_H
+#define DISK_CACHE_PACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util/disk_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Single file storage backend for the disk cache.
+ *
+ * All entries live in one file made of a header, a fixed-size hash index
+ * that is mmapped and shared between processes, and the entries themselves,
+ * which are only ever appended.  Looking an entry up costs a single pread()
+ * rather than an open()/fstat()/read() per entry file.
+ *
+ * Once the file grows past the cache's maximum size, the most recently
+ * written entries are copied to a new file which atomically replaces the
+ * old one.
+ */
+struct disk_cache_pack;
+
+struct disk_cache_pack *
+disk_cache_pack_open(void *mem_ctx, const char *cache_dir);
+
+/* Opens an existing pack file at \path for lookups only. */
+struct disk_cache_pack *
+disk_cache_pack_open_read_only(void *mem_ctx, const char *path);
+
+void
+disk_cache_pack_close(struct disk_cache_pack *pack);
+
+/* Returns a malloc'ed copy of the data stored for \key, or NULL. */
+void *
+disk_cache_pack_read(struct disk_cache_pack *pack, const cache_key key,
+                     size_t *size);
+
+bool
+disk_cache_pack_contains(struct disk_cache_pack *pack, const cache_key key);
+
+void
+disk_cache_pack_write(struct disk_cache_pack *pack, const cache_key key,
+                      const void *data, size_t size, uint64_t max_size);
+
+void
+disk_cache_pack_remove(struct disk_cache_pack *pack, const cache_key key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DISK_CACHE_PACK_H */
@@ -0,0 +1,324 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "util/format/u_format_sse2.h"
+
+#if defined(PIPE_ARCH_SSE)
+
+#include <emmintrin.h>
+
+#include "util/u_math.h"
+
+/* Swaps the first and third byte of each 32-bit pixel, i.e. RGBA <-> BGRA. */
+static inline __m128i
+swap_rb(__m128i pixels)
+{
+   const __m128i ga = _mm_set1_epi32(0xff00ff00);
+   __m128i rb = _mm_andnot_si128(ga, pixels);
+
+   rb = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+   return _mm_or_si128(_mm_and_si128(pixels, ga), rb);
+}
+
+static inline uint32_t
+swap_rb_scalar(uint32_t pixel)
+{
+   return (pixel & 0xff00ff00) | ((pixel & 0xff) << 16) | ((pixel >> 16) & 0xff);
+}
+
+/* Converts 4 RGBA8 pixels to 16 floats, the same way as ubyte_to_float(). */
+static inline void
+unpack_4x8unorm(float *dst, __m128i pixels)
+{
+   const __m128i zero = _mm_setzero_si128();
+   const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+   __m128i lo = _mm_unpacklo_epi8(pixels, zero);
+   __m128i hi = _mm_unpackhi_epi8(pixels, zero);
+
+   _mm_storeu_ps(dst + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+   _mm_storeu_ps(dst + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+   _mm_storeu_ps(dst + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+   _mm_storeu_ps(dst + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+}
+
+static inline void
+unpack_8unorm_scalar(float *dst, uint32_t pixel)
+{
+   dst[0] = ubyte_to_float(pixel & 0xff);
+   dst[1] = ubyte_to_float((pixel >> 8) & 0xff);
+   dst[2] = ubyte_to_float((pixel >> 16) & 0xff);
+   dst[3] = ubyte_to_float(pixel >> 24);
+}
+
+/* Converts one pixel worth of floats to 8 bit unorms in the low byte of each
+ * lane, the same way as float_to_ubyte(): after clamping (which also turns
+ * NaN into 0), adding 32768 leaves the rounded result in the low mantissa
+ * bits.
+ */
+static inline __m128i
+float_to_8unorm(const float *src)
+{
+   __m128 v = _mm_loadu_ps(src);
+
+   v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+   v = _mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(255.0f / 256.0f)),
+                  _mm_set1_ps(32768.0f));
+   return _mm_and_si128(_mm_castps_si128(v), _mm_set1_epi32(0xff));
+}
+
+static inline __m128i
+pack_4x8unorm(const float *src)
+{
+   __m128i p01 = _mm_packs_epi32(float_to_8unorm(src + 0), float_to_8unorm(src + 4));
+   __m128i p23 = _mm_packs_epi32(float_to_8unorm(src + 8), float_to_8unorm(src + 12));
+
+   return _mm_packus_epi16(p01, p23);
+}
+
+static inline uint32_t
+pack_8unorm_scalar(const float *src)
+{
+   return (uint32_t)float_to_ubyte(src[0]) |
+          (uint32_t)float_to_ubyte(src[1]) << 8 |
+          (uint32_t)float_to_ubyte(src[2]) << 16 |
+          (uint32_t)float_to_ubyte(src[3]) << 24;
+}
+
+static inline void
+unpack_rgba8_float(void *dst_row, unsigned dst_stride,
+                   const uint8_t *src_row, unsigned src_stride,
+                   unsigned width, unsigned height, bool bgra)
+{
+   for (unsigned y = 0; y < height; y++) {
+      float *dst = dst_row;
+      const uint8_t *src = src_row;
+      unsigned x = 0;
+
+      for (; x + 4 <= width; x += 4) {
+         __m128i pixels = _mm_loadu_si128((const __m128i *)src);
+
+         unpack_4x8unorm(dst, bgra ? swap_rb(pixels) : pixels);
+         src += 16;
+         dst += 16;
+      }
+
+      for (; x < width; x++) {
+         uint32_t pixel = *(const uint32_t *)src;
+
+         unpack_8unorm_scalar(dst, bgra ? swap_rb_scalar(pixel) : pixel);
+         src += 4;
+         dst += 4;
+      }
+
+      src_row += src_stride;
+      dst_row = (uint8_t *)dst_row + dst_stride;
+   }
+}
+
+static inline void
+pack_rgba8_float(uint8_t *dst_row, unsigned dst_stride,
+                 const float *src_row, unsigned src_stride,
+                 unsigned width, unsigned height, bool bgra)
+{
+   for (unsigned y = 0; y < height; y++) {
+      const float *src = src_row;
+      uint8_t *dst = dst_row;
+      unsigned x = 0;
+
+      for (; x + 4 <= width; x += 4) {
+         __m128i pixels = pack_4x8unorm(src);
+
+         _mm_storeu_si128((__m128i *)dst, bgra ? swap_rb(pixels) : pixels);
+         src += 16;
+         dst += 16;
+      }
+
+      for (; x < width; x++) {
+         uint32_t pixel = pack_8unorm_scalar(src);
+
+         *(uint32_t *)dst = bgra ? swap_rb_scalar(pixel) : pixel;
+         src += 4;
+         dst += 4;
+      }
+
+      dst_row += dst_stride;
+      src_row += src_stride / sizeof(*src_row);
+   }
+}
+
+void
+util_format_r8g8b8a8_unorm_unpack_rgba_float_sse2(void *dst_row, unsigned dst_stride,
+                                                  const uint8_t *src_row, unsigned src_stride,
+                                                  unsigned width, unsigned height)
+{
+   unpack_rgba8_float(dst_row, dst_stride, src_row, src_stride,
+                      width, height, false);
+}
+
+void
+util_format_r8g8b8a8_unorm_pack_rgba_float_sse2(uint8_t *dst_row, unsigned dst_stride,
+                                                const float *src_row, unsigned src_stride,
+                                                unsigned width, unsigned height)
+{
+   pack_rgba8_float(dst_row, dst_stride, src_row, src_stride,
+                    width, height, false);
+}
+
+void
+util_format_b8g8r8a8_unorm_unpack_rgba_float_sse2(void *dst_row, unsigned dst_stride,
+                                                  const uint8_t *src_row, unsigned src_stride,
+                                                  unsigned width, unsigned height)
+{
+   unpack_rgba8_float(dst_row, dst_stride, src_row, src_stride,
+                      width, height, true);
+}
+
+void
+util_format_b8g8r8a8_unorm_pack_rgba_float_sse2(uint8_t *dst_row, unsigned dst_stride,
+                                                const float *src_row, unsigned src_stride,
+                                                unsigned width, unsigned height)
+{
+   pack_rgba8_float(dst_row, dst_stride, src_row, src_stride,
+                    width, height, true);
+}
+
+/* BGRA8 <-> RGBA8 is the same swizzle both ways. */
+static void
+swap_rb_rows(uint8_t *dst_row, unsigned dst_stride,
+             const uint8_t *src_row, unsigned src_stride,
+             unsigned width, unsigned height)
+{
+   for (unsigned y = 0; y < height; y++) {
+      uint8_t *dst = dst_row;
+      const uint8_t *src = src_row;
+      unsigned x = 0;
+
+      for (; x + 4 <= width; x += 4) {
+         __m128i pixels = _mm_loadu_si128((const __m128i *)src);
+
+         _mm_storeu_si128((__m128i *)dst, swap_rb(pixels));
+         src += 16;
+         dst += 16;
+      }
+
+      for (; x < width; x++) {
+         *(uint32_t *)dst = swap_rb_scalar(*(const uint32_t *)src);
+         src += 4;
+         dst += 4;
+      }
+
+      src_row += src_stride;
+      dst_row += dst_stride;
+   }
+}
+
+void
+util_format_b8g8r8a8_unorm_unpack_rgba_8unorm_sse2(uint8_t *dst_row, unsigned dst_stride,
+                                                   const uint8_t *src_row, unsigned src_stride,
+                                                   unsigned width, unsigned height)
+{
+   swap_rb_rows(dst_row, dst_stride, src_row, src_stride, width, height);
+}
+
+void
+util_format_b8g8r8a8_unorm_pack_rgba_8unorm_sse2(uint8_t *dst_row, unsigned dst_stride,
+                                                 const uint8_t *src_row, unsigned src_stride,
+                                                 unsigned width, unsigned height)
+{
+   swap_rb_rows(dst_row, dst_stride, src_row, src_stride, width, height);
+}
+
+/* Unpacks the pixel in the lowest lane.  Each channel is masked in place,
+ * converted, and scaled down by a power of two, which is exact, so the final
+ * multiply gives the same result as the scalar r * (1.0f / 0x3ff).
+ */
+static inline __m128
+unpack_r10g10b10a2(__m128i pixel)
+{
+   const __m128i rgb_mask = _mm_setr_epi32(0x3ff, 0x3ff << 10, 0x3ff << 20, 0);
+   const __m128i a_mask = _mm_setr_epi32(0, 0, 0, 0x3);
+   const __m128 shift = _mm_setr_ps(1.0f, 1.0f / (1 << 10), 1.0f / (1 << 20), 1.0f);
+   const __m128 scale = _mm_setr_ps(1.0f / 0x3ff, 1.0f / 0x3ff, 1.0f / 0x3ff, 1.0f / 0x3);
+   __m128i v = _mm_shuffle_epi32(pixel, _MM_SHUFFLE(0, 0, 0, 0));
+   __m128i channels = _mm_or_si128(_mm_and_si128(v, rgb_mask),
+                                   _mm_and_si128(_mm_srli_epi32(v, 30), a_mask));
+
+   return _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(channels), shift), scale);
+}
+
+void
+util_format_r10g10b10a2_unorm_unpack_rgba_float_sse2(void *dst_row, unsigned dst_stride,
+                                                     const uint8_t *src_row, unsigned src_stride,
+                                                     unsigned width, unsigned height)
+{
+   for (unsigned y = 0; y < height; y++) {
+      float *dst = dst_row;
+      const uint8_t *src = src_row;
+      unsigned x = 0;
+
+      for (; x + 4 <= width; x += 4) {
+         __m128i pixels = _mm_loadu_si128((const __m128i *)src);
+
+         _mm_storeu_ps(dst + 0, unpack_r10g10b10a2(pixels));
+         _mm_storeu_ps(dst + 4, unpack_r10g10b10a2(_mm_srli_si128(pixels, 4)));
+         _mm_storeu_ps(dst + 8, unpack_r10g10b10a2(_mm_srli_si128(pixels, 8)));
+         _mm_storeu_ps(dst + 12, unpack_r10g10b10a2(_mm_srli_si128(pixels, 12)));
+         src += 16;
+         dst += 16;
+      }
+
+      for (; x < width; x++) {
+         _mm_storeu_ps(dst, unpack_r10g10b10a2(_mm_cvtsi32_si128(*(const uint32_t *)src)));
+         src += 4;
+         dst += 4;
+      }
+
+      src_row += src_stride;
+      dst_row = (uint8_t *)dst_row + dst_stride;
+   }
+}
+
+/* Unpacks the depth of one row of Z24 in the low bits of 32-bit pixels,
+ * computing in double like z24_unorm_to_z32_float().
+ */
+void
+util_format_z24_unorm_unpack_z_float_sse2(float *dst, const uint32_t *src,
+                                          unsigned width)
+{
+   const __m128i mask = _mm_set1_epi32(0xffffff);
+   const __m128d scale = _mm_set1_pd(1.0 / 0xffffff);
+   unsigned x = 0;
+
+   for (; x + 4 <= width; x += 4) {
+      __m128i z = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + x)), mask);
+      __m128 lo = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtepi32_pd(z), scale));
+      __m128 hi = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(z, 8)), scale));
+
+      _mm_storeu_ps(dst + x, _mm_movelh_ps(lo, hi));
+   }
+
+   for (; x < width; x++)
+      dst[x] = (float)((src[x] & 0xffffff) * (1.0 / 0xffffff));
+}
+
+#endif /* PIPE_ARCH_SSE */
@@ -0,0 +1,87 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* SSE2 versions of the row pack/unpack functions of some of the most
+ * commonly converted formats.  u_format_table.py points the format
+ * descriptions at these instead of the generated scalar code when
+ * PIPE_ARCH_SSE is defined.  They produce bit-identical results.
+ */
+
+#ifndef U_FORMAT_SSE2_H
+#define U_FORMAT_SSE2_H
+
+#include "pipe/p_config.h"
+#include "util/format/u_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(PIPE_ARCH_SSE)
+
+void
+util_format_r8g8b8a8_unorm_unpack_rgba_float_sse2(void *dst_row, unsigned dst_stride,
+                                                  const uint8_t *src_row, unsigned src_stride,
+                                                  unsigned width, unsigned height);
+
+void
+util_format_r8g8b8a8_unorm_pack_rgba_float_sse2(uint8_t *dst_row, unsigned dst_stride,
+                                                const float *src_row, unsigned src_stride,
+                                                unsigned width, unsigned height);
+
+void
+util_format_b8g8r8a8_unorm_unpack_rgba_float_sse2(void *dst_row, unsigned dst_stride,
+                                                  const uint8_t *src_row, unsigned src_stride,
+                                                  unsigned width, unsigned height);
+
+void
+util_format_b8g8r8a8_unorm_pack_rgba_float_sse2(uint8_t *dst_row, unsigned dst_stride,
+                                                const float *src_row, unsigned src_stride,
+                                                unsigned width, unsigned height);
+
+void
+util_format_b8g8r8a8_unorm_unpack_rgba_8unorm_sse2(uint8_t *dst_row, unsigned dst_stride,
+                                                   const uint8_t *src_row, unsigned src_stride,
+                                                   unsigned width, unsigned height);
+
+void
+util_format_b8g8r8a8_unorm_pack_rgba_8unorm_sse2(uint8_t *dst_row, unsigned dst_stride,
+                                                 const uint8_t *src_row, unsigned src_stride,
+                                                 unsigned width, unsigned height);
+
+void
+util_format_r10g10b10a2_unorm_unpack_rgba_float_sse2(void *dst_row, unsigned dst_stride,
+                                                     const uint8_t *src_row, unsigned src_stride,
+                                                     unsigned width, unsigned height);
+
+void
+util_format_z24_unorm_unpack_z_float_sse2(float *dst, const uint32_t *src,
+                                          unsigned width);
+
+#endif /* PIPE_ARCH_SSE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_FORMAT_SSE2_H */
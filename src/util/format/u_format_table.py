@@ -79,6 +79,31 @@ swizzle_map = {
 }
 
 
+# Formats and functions that have a hand-written SSE2 version in
+# u_format_sse2.c.
+sse2_functions = {
+    ('r8g8b8a8_unorm', 'unpack_rgba_float'),
+    ('r8g8b8a8_unorm', 'pack_rgba_float'),
+    ('b8g8r8a8_unorm', 'unpack_rgba_float'),
+    ('b8g8r8a8_unorm', 'pack_rgba_float'),
+    ('b8g8r8a8_unorm', 'unpack_rgba_8unorm'),
+    ('b8g8r8a8_unorm', 'pack_rgba_8unorm'),
+    ('r10g10b10a2_unorm', 'unpack_rgba_float'),
+}
+
+
+def print_function(member, sn, function):
+    name = "util_format_%s_%s" % (sn, function)
+    if (sn, function) in sse2_functions:
+        print("#if defined(PIPE_ARCH_SSE)")
+        print("   .%s = &%s_sse2," % (member, name))
+        print("#else")
+        print("   .%s = &%s," % (member, name))
+        print("#endif")
+    else:
+        print("   .%s = &%s," % (member, name))
+
+
 def write_format_table(formats):
     print('/* This file is autogenerated by u_format_table.py from u_format.csv. Do not edit directly. */')
     print()
@@ -91,6 +116,7 @@ def write_format_table(formats):
     print('#include "u_format_rgtc.h"')
     print('#include "u_format_latc.h"')
     print('#include "u_format_etc.h"')
+    print('#include "u_format_sse2.h"')
     print()
     
     u_format_pack.generate(formats)
@@ -175,12 +201,12 @@ def write_format_table(formats):
         if format.layout == 'etc' and sn != 'etc1_rgb8':
             access = False
         if format.colorspace != ZS and not format.is_pure_color() and access:
-            print("   .unpack_rgba_8unorm = &util_format_%s_unpack_rgba_8unorm," % sn)
-            print("   .pack_rgba_8unorm = &util_format_%s_pack_rgba_8unorm," % sn)
+            print_function("unpack_rgba_8unorm", sn, "unpack_rgba_8unorm")
+            print_function("pack_rgba_8unorm", sn, "pack_rgba_8unorm")
             if format.layout == 's3tc' or format.layout == 'rgtc':
                 print("   .fetch_rgba_8unorm = &util_format_%s_fetch_rgba_8unorm," % sn)
-            print("   .unpack_rgba = &util_format_%s_unpack_rgba_float," % sn)
-            print("   .pack_rgba_float = &util_format_%s_pack_rgba_float," % sn)
+            print_function("unpack_rgba", sn, "unpack_rgba_float")
+            print_function("pack_rgba_float", sn, "pack_rgba_float")
             print("   .fetch_rgba_float = &util_format_%s_fetch_rgba_float," % sn)
 
         if format.has_depth():
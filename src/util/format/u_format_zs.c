@@ -27,6 +27,7 @@
 
 
 #include "util/format/u_format_zs.h"
+#include "util/format/u_format_sse2.h"
 #include "util/u_math.h"
 
 
@@ -95,6 +96,20 @@ z24_unorm_to_z32_float(uint32_t z)
    return (float)(z * scale);
 }
 
+static inline void
+z24_unorm_unpack_z_float_row(float *dst, const uint32_t *src, unsigned width)
+{
+#if defined(PIPE_ARCH_SSE)
+   util_format_z24_unorm_unpack_z_float_sse2(dst, src, width);
+#else
+   unsigned x;
+   for(x = 0; x < width; ++x) {
+      uint32_t value = util_cpu_to_le32(*src++);
+      *dst++ = z24_unorm_to_z32_float(value & 0xffffff);
+   }
+#endif
+}
+
 static inline uint32_t
 z32_float_to_z32_unorm(float z)
 {
@@ -386,14 +401,9 @@ util_format_z24_unorm_s8_uint_unpack_z_float(float *dst_row, unsigned dst_stride
                                                 const uint8_t *src_row, unsigned src_stride,
                                                 unsigned width, unsigned height)
 {
-   unsigned x, y;
+   unsigned y;
    for(y = 0; y < height; ++y) {
-      float *dst = dst_row;
-      const uint32_t *src = (const uint32_t *)src_row;
-      for(x = 0; x < width; ++x) {
-         uint32_t value =  util_cpu_to_le32(*src++);
-         *dst++ = z24_unorm_to_z32_float(value & 0xffffff);
-      }
+      z24_unorm_unpack_z_float_row(dst_row, (const uint32_t *)src_row, width);
       src_row += src_stride/sizeof(*src_row);
       dst_row += dst_stride/sizeof(*dst_row);
    }
@@ -634,14 +644,9 @@ util_format_z24x8_unorm_unpack_z_float(float *dst_row, unsigned dst_stride,
                                        const uint8_t *src_row, unsigned src_stride,
                                        unsigned width, unsigned height)
 {
-   unsigned x, y;
+   unsigned y;
    for(y = 0; y < height; ++y) {
-      float *dst = dst_row;
-      const uint32_t *src = (const uint32_t *)src_row;
-      for(x = 0; x < width; ++x) {
-         uint32_t value = util_cpu_to_le32(*src++);
-         *dst++ = z24_unorm_to_z32_float(value & 0xffffff);
-      }
+      z24_unorm_unpack_z_float_row(dst_row, (const uint32_t *)src_row, width);
       src_row += src_stride/sizeof(*src_row);
       dst_row += dst_stride/sizeof(*dst_row);
    }
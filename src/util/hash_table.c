@@ -121,28 +121,39 @@ static const struct {
    ENTRY(2147483648ul, 2362232233ul, 2362232231ul )
 };
 
-ASSERTED static inline bool
-key_pointer_is_reserved(const struct hash_table *ht, const void *key)
+/**
+ * Each entry has a control byte in ht->ctrl, which is either free, deleted,
+ * or 7 bits of the entry's hash with the top bit set.  Probing compares the
+ * control bytes first, so entries that can't match are skipped without
+ * touching them.
+ */
+#define CTRL_FREE    0x00
+#define CTRL_DELETED 0x01
+#define CTRL_PRESENT 0x80
+
+static inline uint8_t
+hash_ctrl(uint32_t hash)
 {
-   return key == NULL || key == ht->deleted_key;
+   /* Multiply to fold all the bits of the hash into the top 7. */
+   return CTRL_PRESENT | ((hash * 0x9e3779b1u) >> 25);
 }
 
-static int
-entry_is_free(const struct hash_entry *entry)
+static inline uint8_t *
+entry_ctrl(struct hash_table *ht, struct hash_entry *entry)
 {
-   return entry->key == NULL;
+   return &ht->ctrl[entry - ht->table];
 }
 
-static int
-entry_is_deleted(const struct hash_table *ht, struct hash_entry *entry)
+ASSERTED static inline bool
+key_pointer_is_reserved(const struct hash_table *ht, const void *key)
 {
-   return entry->key == ht->deleted_key;
+   return key == NULL || key == ht->deleted_key;
 }
 
 static int
-entry_is_present(const struct hash_table *ht, struct hash_entry *entry)
+entry_is_present(struct hash_table *ht, struct hash_entry *entry)
 {
-   return entry->key != NULL && entry->key != ht->deleted_key;
+   return *entry_ctrl(ht, entry) & CTRL_PRESENT;
 }
 
 bool
@@ -161,10 +172,16 @@ _mesa_hash_table_init(struct hash_table *ht,
    ht->key_hash_function = key_hash_function;
    ht->key_equals_function = key_equals_function;
    ht->table = rzalloc_array(mem_ctx, struct hash_entry, ht->size);
+   ht->ctrl = ht->table ? rzalloc_array(ht->table, uint8_t, ht->size) : NULL;
    ht->entries = 0;
    ht->deleted_entries = 0;
    ht->deleted_key = &deleted_key_value;
 
+   if (ht->ctrl == NULL) {
+      ralloc_free(ht->table);
+      ht->table = NULL;
+   }
+
    return ht->table != NULL;
 }
 
@@ -210,6 +227,14 @@ _mesa_hash_table_clone(struct hash_table *src, void *dst_mem_ctx)
 
    memcpy(ht->table, src->table, ht->size * sizeof(struct hash_entry));
 
+   ht->ctrl = ralloc_array(ht->table, uint8_t, ht->size);
+   if (ht->ctrl == NULL) {
+      ralloc_free(ht);
+      return NULL;
+   }
+
+   memcpy(ht->ctrl, src->ctrl, ht->size);
+
    return ht;
 }
 
@@ -256,6 +281,7 @@ _mesa_hash_table_clear(struct hash_table *ht,
       entry->key = NULL;
    }
 
+   memset(ht->ctrl, CTRL_FREE, ht->size);
    ht->entries = 0;
    ht->deleted_entries = 0;
 }
@@ -286,16 +312,16 @@ hash_table_search(struct hash_table *ht, uint32_t hash, const void *key)
    uint32_t double_hash = 1 + util_fast_urem32(hash, ht->rehash,
                                                ht->rehash_magic);
    uint32_t hash_address = start_hash_address;
+   const uint8_t ctrl = hash_ctrl(hash);
 
    do {
-      struct hash_entry *entry = ht->table + hash_address;
-
-      if (entry_is_free(entry)) {
+      if (ht->ctrl[hash_address] == CTRL_FREE) {
          return NULL;
-      } else if (entry_is_present(ht, entry) && entry->hash == hash) {
-         if (ht->key_equals_function(key, entry->key)) {
+      } else if (ht->ctrl[hash_address] == ctrl) {
+         struct hash_entry *entry = ht->table + hash_address;
+
+         if (entry->hash == hash && ht->key_equals_function(key, entry->key))
             return entry;
-         }
       }
 
       hash_address += double_hash;
@@ -341,9 +367,10 @@ hash_table_insert_rehash(struct hash_table *ht, uint32_t hash,
                                                ht->rehash_magic);
    uint32_t hash_address = start_hash_address;
    do {
-      struct hash_entry *entry = ht->table + hash_address;
+      if (likely(ht->ctrl[hash_address] == CTRL_FREE)) {
+         struct hash_entry *entry = ht->table + hash_address;
 
-      if (likely(entry->key == NULL)) {
+         ht->ctrl[hash_address] = hash_ctrl(hash);
          entry->hash = hash;
          entry->key = key;
          entry->data = data;
@@ -361,6 +388,7 @@ _mesa_hash_table_rehash(struct hash_table *ht, unsigned new_size_index)
 {
    struct hash_table old_ht;
    struct hash_entry *table;
+   uint8_t *ctrl;
 
    if (new_size_index >= ARRAY_SIZE(hash_sizes))
       return;
@@ -370,9 +398,16 @@ _mesa_hash_table_rehash(struct hash_table *ht, unsigned new_size_index)
    if (table == NULL)
       return;
 
+   ctrl = rzalloc_array(table, uint8_t, hash_sizes[new_size_index].size);
+   if (ctrl == NULL) {
+      ralloc_free(table);
+      return;
+   }
+
    old_ht = *ht;
 
    ht->table = table;
+   ht->ctrl = ctrl;
    ht->size_index = new_size_index;
    ht->size = hash_sizes[ht->size_index].size;
    ht->rehash = hash_sizes[ht->size_index].rehash;
@@ -410,14 +445,15 @@ hash_table_insert(struct hash_table *ht, uint32_t hash,
    uint32_t double_hash = 1 + util_fast_urem32(hash, ht->rehash,
                                                ht->rehash_magic);
    uint32_t hash_address = start_hash_address;
+   const uint8_t ctrl = hash_ctrl(hash);
    do {
       struct hash_entry *entry = ht->table + hash_address;
 
-      if (!entry_is_present(ht, entry)) {
+      if (ht->ctrl[hash_address] < CTRL_PRESENT) {
          /* Stash the first available entry we find */
          if (available_entry == NULL)
             available_entry = entry;
-         if (entry_is_free(entry))
+         if (ht->ctrl[hash_address] == CTRL_FREE)
             break;
       }
 
@@ -432,7 +468,7 @@ hash_table_insert(struct hash_table *ht, uint32_t hash,
        * required to avoid memory leaks, perform a search
        * before inserting.
        */
-      if (!entry_is_deleted(ht, entry) &&
+      if (ht->ctrl[hash_address] == ctrl &&
           entry->hash == hash &&
           ht->key_equals_function(key, entry->key)) {
          entry->key = key;
@@ -446,8 +482,9 @@ hash_table_insert(struct hash_table *ht, uint32_t hash,
    } while (hash_address != start_hash_address);
 
    if (available_entry) {
-      if (entry_is_deleted(ht, available_entry))
+      if (*entry_ctrl(ht, available_entry) == CTRL_DELETED)
          ht->deleted_entries--;
+      *entry_ctrl(ht, available_entry) = ctrl;
       available_entry->hash = hash;
       available_entry->key = key;
       available_entry->data = data;
@@ -495,6 +532,7 @@ _mesa_hash_table_remove(struct hash_table *ht,
    if (!entry)
       return;
 
+   *entry_ctrl(ht, entry) = CTRL_DELETED;
    entry->key = ht->deleted_key;
    ht->entries--;
    ht->deleted_entries++;
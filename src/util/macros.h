@@ -347,6 +347,7 @@ enum pipe_debug_type
    PIPE_DEBUG_TYPE_INFO,
    PIPE_DEBUG_TYPE_FALLBACK,
    PIPE_DEBUG_TYPE_CONFORMANCE,
+   PIPE_DEBUG_TYPE_SHADER_STATS,
 };
 
 #endif /* UTIL_MACROS_H */
@@ -0,0 +1,191 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Builds a read-only shader cache layer, to be used with
+ * MESA_DISK_CACHE_RO_DIR, out of an existing cache directory such as
+ * ~/.cache/mesa_shader_cache.
+ *
+ * Entries of the directory are copied as is into <output dir>/pack, and the
+ * keys recorded with disk_cache_put_key() become empty entries, so that
+ * disk_cache_has_key() finds them in the read-only layer too.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "util/disk_cache_pack.h"
+#include "util/os_file.h"
+
+static unsigned num_entries;
+static unsigned num_keys;
+
+static bool
+parse_key(const char *dir_name, const char *file_name, cache_key key)
+{
+   char hex[2 * CACHE_KEY_SIZE + 1];
+
+   if (strlen(dir_name) != 2 || strlen(file_name) != 2 * CACHE_KEY_SIZE - 2)
+      return false;
+
+   memcpy(hex, dir_name, 2);
+   memcpy(hex + 2, file_name, 2 * CACHE_KEY_SIZE - 1);
+
+   for (unsigned i = 0; i < CACHE_KEY_SIZE; i++) {
+      char byte[3] = { hex[2 * i], hex[2 * i + 1], '\0' };
+      char *end;
+
+      key[i] = strtoul(byte, &end, 16);
+      if (*end != '\0')
+         return false;
+   }
+
+   return true;
+}
+
+static void
+add_entries(struct disk_cache_pack *pack, const char *cache_dir,
+            const char *dir_name)
+{
+   char *dir_path;
+   struct dirent *entry;
+   DIR *dir;
+
+   if (asprintf(&dir_path, "%s/%s", cache_dir, dir_name) == -1)
+      return;
+
+   dir = opendir(dir_path);
+   if (!dir) {
+      free(dir_path);
+      return;
+   }
+
+   while ((entry = readdir(dir)) != NULL) {
+      cache_key key;
+      char *path;
+      size_t size;
+
+      if (!parse_key(dir_name, entry->d_name, key))
+         continue;
+
+      if (asprintf(&path, "%s/%s", dir_path, entry->d_name) == -1)
+         continue;
+
+      char *data = os_read_file(path, &size);
+      if (data) {
+         disk_cache_pack_write(pack, key, data, size, UINT64_MAX);
+         num_entries++;
+         free(data);
+      } else {
+         fprintf(stderr, "failed to read %s: %s\n", path, strerror(errno));
+      }
+
+      free(path);
+   }
+
+   closedir(dir);
+   free(dir_path);
+}
+
+static void
+add_index_keys(struct disk_cache_pack *pack, const char *cache_dir)
+{
+   static const cache_key zero_key;
+   char *path;
+   size_t size;
+
+   if (asprintf(&path, "%s/index", cache_dir) == -1)
+      return;
+
+   /* The index is the total size of the cache followed by the keys. */
+   char *index = os_read_file(path, &size);
+   free(path);
+   if (!index || size < sizeof(uint64_t)) {
+      free(index);
+      return;
+   }
+
+   for (size_t offset = sizeof(uint64_t); offset + CACHE_KEY_SIZE <= size;
+        offset += CACHE_KEY_SIZE) {
+      const uint8_t *key = (const uint8_t *)index + offset;
+
+      if (memcmp(key, zero_key, CACHE_KEY_SIZE) == 0)
+         continue;
+
+      disk_cache_pack_write(pack, key, NULL, 0, UINT64_MAX);
+      num_keys++;
+   }
+
+   free(index);
+}
+
+int
+main(int argc, char **argv)
+{
+   struct disk_cache_pack *pack;
+   struct dirent *entry;
+   DIR *dir;
+
+   if (argc != 3) {
+      fprintf(stderr, "usage: %s <cache dir> <output dir>\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   dir = opendir(argv[1]);
+   if (!dir) {
+      fprintf(stderr, "failed to open %s: %s\n", argv[1], strerror(errno));
+      return EXIT_FAILURE;
+   }
+
+   if (mkdir(argv[2], 0755) == -1 && errno != EEXIST) {
+      fprintf(stderr, "failed to create %s: %s\n", argv[2], strerror(errno));
+      closedir(dir);
+      return EXIT_FAILURE;
+   }
+
+   pack = disk_cache_pack_open(NULL, argv[2]);
+   if (!pack) {
+      fprintf(stderr, "failed to create %s/pack\n", argv[2]);
+      closedir(dir);
+      return EXIT_FAILURE;
+   }
+
+   while ((entry = readdir(dir)) != NULL) {
+      if (strlen(entry->d_name) == 2 && entry->d_name[0] != '.')
+         add_entries(pack, argv[1], entry->d_name);
+   }
+   closedir(dir);
+
+   add_index_keys(pack, argv[1]);
+
+   disk_cache_pack_close(pack);
+
+   printf("%u entries and %u keys written to %s/pack\n",
+          num_entries, num_keys, argv[2]);
+
+   return EXIT_SUCCESS;
+}
@@ -80,10 +80,32 @@ __declspec(align(16))
    struct ralloc_header *next;
 
    void (*destructor)(void *);
+
+   /* The arena this block was carved from, or, with ARENA_OWNER set, the
+    * arena that this block's children are carved from (see ralloc_reserve).
+    * This fits in the alignment padding of release builds.
+    */
+   uintptr_t arena;
 };
 
 typedef struct ralloc_header ralloc_header;
 
+#define ARENA_OWNER 1
+#define ARENA_ALIGN 16
+
+struct ralloc_arena {
+   /* Number of live blocks carved from the arena, plus one while the owner
+    * is alive.
+    */
+   unsigned refcount;
+   bool owned;
+   char *next;
+   char *end;
+};
+
+#define ARENA_DATA_OFFSET \
+   ((sizeof(struct ralloc_arena) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
 static void unlink_block(ralloc_header *info);
 static void unsafe_free(ralloc_header *info);
 
@@ -117,17 +139,60 @@ ralloc_context(const void *ctx)
    return ralloc_size(ctx, 0);
 }
 
+static struct ralloc_arena *
+get_arena(const ralloc_header *info)
+{
+   return (struct ralloc_arena *) (info->arena & ~(uintptr_t)ARENA_OWNER);
+}
+
+static void
+arena_unref(struct ralloc_arena *arena)
+{
+   if (--arena->refcount == 0) {
+      free(arena);
+   } else if (arena->refcount == 1 && arena->owned) {
+      /* Everything carved from the arena is gone, so the owner can reuse it
+       * from the start.
+       */
+      arena->next = (char *) arena + ARENA_DATA_OFFSET;
+   }
+}
+
+static ralloc_header *
+arena_alloc(struct ralloc_arena *arena, size_t size)
+{
+   size_t total = (size + sizeof(ralloc_header) + ARENA_ALIGN - 1) &
+                  ~(size_t)(ARENA_ALIGN - 1);
+
+   if (total > (size_t)(arena->end - arena->next))
+      return NULL;
+
+   ralloc_header *info = (ralloc_header *) arena->next;
+   arena->next += total;
+   arena->refcount++;
+   info->arena = (uintptr_t) arena;
+   return info;
+}
+
 void *
 ralloc_size(const void *ctx, size_t size)
 {
-   void *block = malloc(size + sizeof(ralloc_header));
-   ralloc_header *info;
+   ralloc_header *info = NULL;
    ralloc_header *parent;
 
-   if (unlikely(block == NULL))
-      return NULL;
+   parent = ctx != NULL ? get_header(ctx) : NULL;
+
+   if (parent != NULL && (parent->arena & ARENA_OWNER))
+      info = arena_alloc(get_arena(parent), size);
+
+   if (info == NULL) {
+      info = malloc(size + sizeof(ralloc_header));
+      if (unlikely(info == NULL))
+         return NULL;
+
+      info->arena = 0;
+   }
 
-   info = (ralloc_header *) block;
    /* measurements have shown that calloc is slower (because of
     * the multiplication overflow checking?), so clear things
     * manually
@@ -138,8 +203,6 @@ ralloc_size(const void *ctx, size_t size)
    info->next = NULL;
    info->destructor = NULL;
 
-   parent = ctx != NULL ? get_header(ctx) : NULL;
-
    add_child(parent, info);
 
 #ifndef NDEBUG
@@ -167,7 +230,24 @@ resize(void *ptr, size_t size)
    ralloc_header *child, *old, *info;
 
    old = get_header(ptr);
-   info = realloc(old, size + sizeof(ralloc_header));
+
+   if (old->arena != 0 && !(old->arena & ARENA_OWNER)) {
+      /* Blocks carved from an arena don't know their size, but anything up
+       * to the end of the arena is safe to copy.
+       */
+      struct ralloc_arena *arena = get_arena(old);
+      size_t copy = MIN2(size, (size_t)(arena->end - (char *)ptr));
+
+      info = malloc(size + sizeof(ralloc_header));
+      if (info == NULL)
+         return NULL;
+
+      memcpy(info, old, sizeof(ralloc_header) + copy);
+      info->arena = 0;
+      arena_unref(arena);
+   } else {
+      info = realloc(old, size + sizeof(ralloc_header));
+   }
 
    if (info == NULL)
       return NULL;
@@ -300,7 +380,40 @@ unsafe_free(ralloc_header *info)
    if (info->destructor != NULL)
       info->destructor(PTR_FROM_HEADER(info));
 
-   free(info);
+   if (info->arena == 0) {
+      free(info);
+   } else if (info->arena & ARENA_OWNER) {
+      get_arena(info)->owned = false;
+      arena_unref(get_arena(info));
+      free(info);
+   } else {
+      arena_unref(get_arena(info));
+   }
+}
+
+bool
+ralloc_reserve(const void *ctx, size_t size, unsigned count)
+{
+   ralloc_header *info = get_header(ctx);
+   struct ralloc_arena *arena;
+   size_t total;
+
+   /* An arena can only be attached once, and not to a carved block, which
+    * couldn't keep it alive.
+    */
+   assert(info->arena == 0);
+
+   total = size + (size_t)count * (sizeof(ralloc_header) + ARENA_ALIGN - 1);
+   arena = malloc(ARENA_DATA_OFFSET + total);
+   if (arena == NULL)
+      return false;
+
+   arena->refcount = 1;
+   arena->owned = true;
+   arena->next = (char *) arena + ARENA_DATA_OFFSET;
+   arena->end = arena->next + total;
+   info->arena = (uintptr_t) arena | ARENA_OWNER;
+   return true;
 }
 
 void
@@ -313,6 +313,24 @@ void *ralloc_parent(const void *ptr);
  */
 void ralloc_set_destructor(const void *ptr, void(*destructor)(void *));
 
+/**
+ * Reserve memory for future allocations out of \p ctx.
+ *
+ * Reserves a single block large enough for \p count allocations totalling
+ * \p size bytes.  Later allocations whose parent is \p ctx itself are carved
+ * out of it, until it runs out, after which they fall back to malloc.
+ * Carved allocations behave like any other: they can be stolen, reallocated
+ * and freed individually.  Once everything carved from the block has been
+ * freed, it is reused from the start, and it is released together with
+ * \p ctx.
+ *
+ * This is meant for building large trees of known size at once, such as
+ * when deserializing.  It can only be done once per context.
+ *
+ * \return false if the memory couldn't be allocated.
+ */
+bool ralloc_reserve(const void *ctx, size_t size, unsigned count);
+
 /// \defgroup array String Functions @{
 /**
  * Duplicate a string, allocating the memory from the given context.
@@ -119,11 +119,24 @@ struct ra_class {
    unsigned int *q;
 };
 
+/**
+ * Degree from which a node gets an adjacency bitset in addition to its
+ * adjacency list.
+ *
+ * Below it, scanning the list is about as fast as testing a bit, and most
+ * nodes never get there, so a graph only pays the O(nodes) bitset for its
+ * few high degree nodes rather than O(nodes²) overall.
+ */
+#define RA_ADJACENCY_BITSET_DEGREE 64
+
 struct ra_node {
    /** @{
     *
     * List of which nodes this node interferes with.  This should be
     * symmetric with the other node.
+    *
+    * adjacency is the same set as a bitset, NULL until the node reaches
+    * RA_ADJACENCY_BITSET_DEGREE.
     */
    BITSET_WORD *adjacency;
 
@@ -186,6 +199,13 @@ struct ra_graph {
       /** Bit-set indicating, for each register, the value of the pq test */
       BITSET_WORD *pq_test;
 
+      /**
+       * Bit-set indicating, for each BITSET_WORD of pq_test, if it may have
+       * bits set for nodes which are neither in the stack nor assigned, so
+       * that ra_simplify() doesn't have to look at all of them every time.
+       */
+      BITSET_WORD *pq_words;
+
       /** For each BITSET_WORD, the minimum q value or ~0 if unknown */
       unsigned int *min_q_total;
 
@@ -484,24 +504,60 @@ ra_set_deserialize(void *mem_ctx, struct blob_reader *blob)
    return regs;
 }
 
+static bool
+ra_nodes_interfere(struct ra_graph *g, unsigned int n1, unsigned int n2)
+{
+   if (g->nodes[n1].adjacency)
+      return BITSET_TEST(g->nodes[n1].adjacency, n2);
+   if (g->nodes[n2].adjacency)
+      return BITSET_TEST(g->nodes[n2].adjacency, n1);
+
+   /* Both are below RA_ADJACENCY_BITSET_DEGREE, look through the shorter
+    * list.
+    */
+   if (util_dynarray_num_elements(&g->nodes[n1].adjacency_list, unsigned int) >
+       util_dynarray_num_elements(&g->nodes[n2].adjacency_list, unsigned int)) {
+      unsigned int tmp = n1;
+      n1 = n2;
+      n2 = tmp;
+   }
+
+   util_dynarray_foreach(&g->nodes[n1].adjacency_list, unsigned int, n2p) {
+      if (*n2p == n2)
+         return true;
+   }
+
+   return false;
+}
+
 static void
 ra_add_node_adjacency(struct ra_graph *g, unsigned int n1, unsigned int n2)
 {
-   BITSET_SET(g->nodes[n1].adjacency, n2);
+   struct ra_node *node = &g->nodes[n1];
 
    assert(n1 != n2);
 
-   int n1_class = g->nodes[n1].class;
+   int n1_class = node->class;
    int n2_class = g->nodes[n2].class;
-   g->nodes[n1].q_total += g->regs->classes[n1_class]->q[n2_class];
+   node->q_total += g->regs->classes[n1_class]->q[n2_class];
 
-   util_dynarray_append(&g->nodes[n1].adjacency_list, unsigned int, n2);
+   util_dynarray_append(&node->adjacency_list, unsigned int, n2);
+
+   if (node->adjacency) {
+      BITSET_SET(node->adjacency, n2);
+   } else if (util_dynarray_num_elements(&node->adjacency_list, unsigned int) >=
+              RA_ADJACENCY_BITSET_DEGREE) {
+      node->adjacency = rzalloc_array(g, BITSET_WORD, BITSET_WORDS(g->alloc));
+      util_dynarray_foreach(&node->adjacency_list, unsigned int, n2p)
+         BITSET_SET(node->adjacency, *n2p);
+   }
 }
 
 static void
 ra_node_remove_adjacency(struct ra_graph *g, unsigned int n1, unsigned int n2)
 {
-   BITSET_CLEAR(g->nodes[n1].adjacency, n2);
+   if (g->nodes[n1].adjacency)
+      BITSET_CLEAR(g->nodes[n1].adjacency, n2);
 
    assert(n1 != n2);
 
@@ -531,15 +587,16 @@ ra_realloc_interference_graph(struct ra_graph *g, unsigned int alloc)
    unsigned bitset_count = BITSET_WORDS(alloc);
    /* For nodes already in the graph, we just have to grow the adjacency set */
    for (unsigned i = 0; i < g->alloc; i++) {
-      assert(g->nodes[i].adjacency != NULL);
-      g->nodes[i].adjacency = rerzalloc(g, g->nodes[i].adjacency, BITSET_WORD,
-                                        g_bitset_count, bitset_count);
+      if (g->nodes[i].adjacency) {
+         g->nodes[i].adjacency = rerzalloc(g, g->nodes[i].adjacency,
+                                           BITSET_WORD, g_bitset_count,
+                                           bitset_count);
+      }
    }
 
    /* For new nodes, we have to fully initialize them */
    for (unsigned i = g->alloc; i < alloc; i++) {
       memset(&g->nodes[i], 0, sizeof(g->nodes[i]));
-      g->nodes[i].adjacency = rzalloc_array(g, BITSET_WORD, bitset_count);
       util_dynarray_init(&g->nodes[i].adjacency_list, g);
       g->nodes[i].q_total = 0;
 
@@ -556,6 +613,8 @@ ra_realloc_interference_graph(struct ra_graph *g, unsigned int alloc)
    g->tmp.reg_assigned = reralloc(g, g->tmp.reg_assigned, BITSET_WORD,
                                   bitset_count);
    g->tmp.pq_test = reralloc(g, g->tmp.pq_test, BITSET_WORD, bitset_count);
+   g->tmp.pq_words = reralloc(g, g->tmp.pq_words, BITSET_WORD,
+                              BITSET_WORDS(bitset_count));
    g->tmp.min_q_total = reralloc(g, g->tmp.min_q_total, unsigned int,
                                  bitset_count);
    g->tmp.min_q_node = reralloc(g, g->tmp.min_q_node, unsigned int,
@@ -623,7 +682,7 @@ ra_add_node_interference(struct ra_graph *g,
                          unsigned int n1, unsigned int n2)
 {
    assert(n1 < g->count && n2 < g->count);
-   if (n1 != n2 && !BITSET_TEST(g->nodes[n1].adjacency, n2)) {
+   if (n1 != n2 && !ra_nodes_interfere(g, n1, n2)) {
       ra_add_node_adjacency(g, n1, n2);
       ra_add_node_adjacency(g, n2, n1);
    }
@@ -636,8 +695,8 @@ ra_reset_node_interference(struct ra_graph *g, unsigned int n)
       ra_node_remove_adjacency(g, *n2p, n);
    }
 
-   memset(g->nodes[n].adjacency, 0,
-          BITSET_WORDS(g->count) * sizeof(BITSET_WORD));
+   ralloc_free(g->nodes[n].adjacency);
+   g->nodes[n].adjacency = NULL;
    util_dynarray_clear(&g->nodes[n].adjacency_list);
 }
 
@@ -648,6 +707,7 @@ update_pq_info(struct ra_graph *g, unsigned int n)
    int n_class = g->nodes[n].class;
    if (g->nodes[n].tmp.q_total < g->regs->classes[n_class]->p) {
       BITSET_SET(g->tmp.pq_test, n);
+      BITSET_SET(g->tmp.pq_words, i);
    } else if (g->tmp.min_q_total[i] != UINT_MAX) {
       /* Only update min_q_total and min_q_node if min_q_total != UINT_MAX so
        * that we don't update while we have stale data and accidentally mark
@@ -714,6 +774,8 @@ ra_simplify(struct ra_graph *g)
 
    /* Do a quick pre-pass to set things up */
    g->tmp.stack_count = 0;
+   memset(g->tmp.pq_words, 0,
+          BITSET_WORDS(BITSET_WORDS(g->count)) * sizeof(BITSET_WORD));
    for (int i = BITSET_WORDS(g->count) - 1, high_bit = top_word_high_bit;
         i >= 0; i--, high_bit = BITSET_WORDBITS - 1) {
       g->tmp.in_stack[i] = 0;
@@ -737,16 +799,22 @@ ra_simplify(struct ra_graph *g)
 
       progress = false;
 
-      for (int i = BITSET_WORDS(g->count) - 1, high_bit = top_word_high_bit;
-           i >= 0; i--, high_bit = BITSET_WORDBITS - 1) {
-         BITSET_WORD mask = ~(BITSET_WORD)0 >> (31 - high_bit);
+      /* Only visit the words of pq_test which may have something for us,
+       * highest first, like a walk over all of them would.  Taking nodes off
+       * may set bits in words we haven't visited yet, so pq_words has to be
+       * reloaded as we go.
+       */
+      for (int w = BITSET_WORDS(BITSET_WORDS(g->count)) - 1; w >= 0; w--) {
+         BITSET_WORD words = g->tmp.pq_words[w];
+         while (words) {
+            const int b = util_last_bit(words) - 1;
+            const unsigned int i = w * BITSET_WORDBITS + b;
+            const int high_bit = i == BITSET_WORDS(g->count) - 1 ?
+                                 top_word_high_bit : BITSET_WORDBITS - 1;
 
-         BITSET_WORD skip = g->tmp.in_stack[i] | g->tmp.reg_assigned[i];
-         if (skip == mask)
-            continue;
+            BITSET_WORD skip = g->tmp.in_stack[i] | g->tmp.reg_assigned[i];
+            BITSET_WORD pq = g->tmp.pq_test[i] & ~skip;
 
-         BITSET_WORD pq = g->tmp.pq_test[i] & ~skip;
-         if (pq) {
             /* In this case, we have stuff we can immediately take off the
              * stack.  This also means that we're guaranteed to make progress
              * and we don't need to bother updating lowest_q_total because we
@@ -765,28 +833,49 @@ ra_simplify(struct ra_graph *g)
                   progress = true;
                }
             }
-         } else if (!progress) {
-            if (g->tmp.min_q_total[i] == UINT_MAX) {
-               /* The min_q_total and min_q_node are dirty because we added
-                * one of these nodes to the stack.  It needs to be
-                * recalculated.
-                */
-               for (int j = high_bit; j >= 0; j--) {
-                  if (skip & BITSET_BIT(j))
-                     continue;
 
-                  unsigned int n = i * BITSET_WORDBITS + j;
-                  assert(n < g->count);
-                  if (g->nodes[n].tmp.q_total < g->tmp.min_q_total[i]) {
-                     g->tmp.min_q_total[i] = g->nodes[n].tmp.q_total;
-                     g->tmp.min_q_node[i] = n;
-                  }
+            /* Nodes above the ones we took off may have passed the pq test
+             * in the meantime, those are left for the next iteration.
+             */
+            skip = g->tmp.in_stack[i] | g->tmp.reg_assigned[i];
+            if (!(g->tmp.pq_test[i] & ~skip))
+               BITSET_CLEAR(g->tmp.pq_words, i);
+
+            words = g->tmp.pq_words[w] & (BITSET_BIT(b) - 1);
+         }
+      }
+
+      if (progress)
+         continue;
+
+      for (int i = BITSET_WORDS(g->count) - 1, high_bit = top_word_high_bit;
+           i >= 0; i--, high_bit = BITSET_WORDBITS - 1) {
+         BITSET_WORD mask = ~(BITSET_WORD)0 >> (31 - high_bit);
+
+         BITSET_WORD skip = g->tmp.in_stack[i] | g->tmp.reg_assigned[i];
+         if (skip == mask)
+            continue;
+
+         if (g->tmp.min_q_total[i] == UINT_MAX) {
+            /* The min_q_total and min_q_node are dirty because we added
+             * one of these nodes to the stack.  It needs to be
+             * recalculated.
+             */
+            for (int j = high_bit; j >= 0; j--) {
+               if (skip & BITSET_BIT(j))
+                  continue;
+
+               unsigned int n = i * BITSET_WORDBITS + j;
+               assert(n < g->count);
+               if (g->nodes[n].tmp.q_total < g->tmp.min_q_total[i]) {
+                  g->tmp.min_q_total[i] = g->nodes[n].tmp.q_total;
+                  g->tmp.min_q_node[i] = n;
                }
             }
-            if (g->tmp.min_q_total[i] < min_q_total) {
-               min_q_node = g->tmp.min_q_node[i];
-               min_q_total = g->tmp.min_q_total[i];
-            }
+         }
+         if (g->tmp.min_q_total[i] < min_q_total) {
+            min_q_node = g->tmp.min_q_node[i];
+            min_q_total = g->tmp.min_q_total[i];
          }
       }
 
@@ -1028,3 +1117,9 @@ ra_set_node_spill_cost(struct ra_graph *g, unsigned int n, float cost)
 {
    g->nodes[n].spill_cost = cost;
 }
+
+float
+ra_get_node_spill_cost(struct ra_graph *g, unsigned int n)
+{
+   return g->nodes[n].spill_cost;
+}
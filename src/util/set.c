@@ -98,22 +98,30 @@ key_pointer_is_reserved(const void *key)
    return key == NULL || key == deleted_key;
 }
 
-static int
-entry_is_free(struct set_entry *entry)
+/**
+ * Control bytes, as in hash_table.c: each entry has one in ht->ctrl holding
+ * either free, deleted, or 7 bits of the entry's hash with the top bit set.
+ */
+#define CTRL_FREE    0x00
+#define CTRL_DELETED 0x01
+#define CTRL_PRESENT 0x80
+
+static inline uint8_t
+hash_ctrl(uint32_t hash)
 {
-   return entry->key == NULL;
+   return CTRL_PRESENT | ((hash * 0x9e3779b1u) >> 25);
 }
 
-static int
-entry_is_deleted(struct set_entry *entry)
+static inline uint8_t *
+entry_ctrl(const struct set *ht, const struct set_entry *entry)
 {
-   return entry->key == deleted_key;
+   return &ht->ctrl[entry - ht->table];
 }
 
 static int
-entry_is_present(struct set_entry *entry)
+entry_is_present(const struct set *ht, const struct set_entry *entry)
 {
-   return entry->key != NULL && entry->key != deleted_key;
+   return *entry_ctrl(ht, entry) & CTRL_PRESENT;
 }
 
 struct set *
@@ -137,10 +145,11 @@ _mesa_set_create(void *mem_ctx,
    ht->key_hash_function = key_hash_function;
    ht->key_equals_function = key_equals_function;
    ht->table = rzalloc_array(ht, struct set_entry, ht->size);
+   ht->ctrl = rzalloc_array(ht, uint8_t, ht->size);
    ht->entries = 0;
    ht->deleted_entries = 0;
 
-   if (ht->table == NULL) {
+   if (ht->table == NULL || ht->ctrl == NULL) {
       ralloc_free(ht);
       return NULL;
    }
@@ -167,6 +176,14 @@ _mesa_set_clone(struct set *set, void *dst_mem_ctx)
 
    memcpy(clone->table, set->table, clone->size * sizeof(struct set_entry));
 
+   clone->ctrl = ralloc_array(clone, uint8_t, clone->size);
+   if (clone->ctrl == NULL) {
+      ralloc_free(clone);
+      return NULL;
+   }
+
+   memcpy(clone->ctrl, set->ctrl, clone->size);
+
    return clone;
 }
 
@@ -188,6 +205,7 @@ _mesa_set_destroy(struct set *ht, void (*delete_function)(struct set_entry *entr
       }
    }
    ralloc_free(ht->table);
+   ralloc_free(ht->ctrl);
    ralloc_free(ht);
 }
 
@@ -206,12 +224,14 @@ _mesa_set_clear(struct set *set, void (*delete_function)(struct set_entry *entry
    struct set_entry *entry;
 
    for (entry = set->table; entry != set->table + set->size; entry++) {
-      if (entry_is_present(entry) && delete_function != NULL)
+      if (entry_is_present(set, entry) && delete_function != NULL)
          delete_function(entry);
 
       entry->key = NULL;
    }
 
+   memset(set->ctrl, CTRL_FREE, set->size);
+
    set->entries = 0;
    set->deleted_entries = 0;
 }
@@ -231,15 +251,15 @@ set_search(const struct set *ht, uint32_t hash, const void *key)
    uint32_t double_hash = util_fast_urem32(hash, ht->rehash,
                                            ht->rehash_magic) + 1;
    uint32_t hash_address = start_address;
+   const uint8_t ctrl = hash_ctrl(hash);
    do {
-      struct set_entry *entry = ht->table + hash_address;
-
-      if (entry_is_free(entry)) {
+      if (ht->ctrl[hash_address] == CTRL_FREE) {
          return NULL;
-      } else if (entry_is_present(entry) && entry->hash == hash) {
-         if (ht->key_equals_function(key, entry->key)) {
+      } else if (ht->ctrl[hash_address] == ctrl) {
+         struct set_entry *entry = ht->table + hash_address;
+
+         if (entry->hash == hash && ht->key_equals_function(key, entry->key))
             return entry;
-         }
       }
 
       hash_address += double_hash;
@@ -275,8 +295,10 @@ set_add_rehash(struct set *ht, uint32_t hash, const void *key)
                                            ht->rehash_magic) + 1;
    uint32_t hash_address = start_address;
    do {
-      struct set_entry *entry = ht->table + hash_address;
-      if (likely(entry->key == NULL)) {
+      if (likely(ht->ctrl[hash_address] == CTRL_FREE)) {
+         struct set_entry *entry = ht->table + hash_address;
+
+         ht->ctrl[hash_address] = hash_ctrl(hash);
          entry->hash = hash;
          entry->key = key;
          return;
@@ -293,6 +315,7 @@ set_rehash(struct set *ht, unsigned new_size_index)
 {
    struct set old_ht;
    struct set_entry *table;
+   uint8_t *ctrl;
 
    if (new_size_index >= ARRAY_SIZE(hash_sizes))
       return;
@@ -302,9 +325,16 @@ set_rehash(struct set *ht, unsigned new_size_index)
    if (table == NULL)
       return;
 
+   ctrl = rzalloc_array(ht, uint8_t, hash_sizes[new_size_index].size);
+   if (ctrl == NULL) {
+      ralloc_free(table);
+      return;
+   }
+
    old_ht = *ht;
 
    ht->table = table;
+   ht->ctrl = ctrl;
    ht->size_index = new_size_index;
    ht->size = hash_sizes[ht->size_index].size;
    ht->rehash = hash_sizes[ht->size_index].rehash;
@@ -321,6 +351,7 @@ set_rehash(struct set *ht, unsigned new_size_index)
    ht->entries = old_ht.entries;
 
    ralloc_free(old_ht.table);
+   ralloc_free(old_ht.ctrl);
 }
 
 void
@@ -362,18 +393,19 @@ set_search_or_add(struct set *ht, uint32_t hash, const void *key, bool *found)
    uint32_t double_hash = util_fast_urem32(hash, ht->rehash,
                                            ht->rehash_magic) + 1;
    uint32_t hash_address = start_address;
+   const uint8_t ctrl = hash_ctrl(hash);
    do {
       struct set_entry *entry = ht->table + hash_address;
 
-      if (!entry_is_present(entry)) {
+      if (ht->ctrl[hash_address] < CTRL_PRESENT) {
          /* Stash the first available entry we find */
          if (available_entry == NULL)
             available_entry = entry;
-         if (entry_is_free(entry))
+         if (ht->ctrl[hash_address] == CTRL_FREE)
             break;
       }
 
-      if (!entry_is_deleted(entry) &&
+      if (ht->ctrl[hash_address] == ctrl &&
           entry->hash == hash &&
           ht->key_equals_function(key, entry->key)) {
          if (found)
@@ -388,8 +420,9 @@ set_search_or_add(struct set *ht, uint32_t hash, const void *key, bool *found)
 
    if (available_entry) {
       /* There is no matching entry, create it. */
-      if (entry_is_deleted(available_entry))
+      if (*entry_ctrl(ht, available_entry) == CTRL_DELETED)
          ht->deleted_entries--;
+      *entry_ctrl(ht, available_entry) = ctrl;
       available_entry->hash = hash;
       available_entry->key = key;
       ht->entries++;
@@ -501,6 +534,7 @@ _mesa_set_remove(struct set *ht, struct set_entry *entry)
    if (!entry)
       return;
 
+   *entry_ctrl(ht, entry) = CTRL_DELETED;
    entry->key = deleted_key;
    ht->entries--;
    ht->deleted_entries++;
@@ -530,7 +564,7 @@ _mesa_set_next_entry(const struct set *ht, struct set_entry *entry)
       entry = entry + 1;
 
    for (; entry != ht->table + ht->size; entry++) {
-      if (entry_is_present(entry)) {
+      if (entry_is_present(ht, entry)) {
          return entry;
       }
    }
@@ -549,14 +583,14 @@ _mesa_set_random_entry(struct set *ht,
       return NULL;
 
    for (entry = ht->table + i; entry != ht->table + ht->size; entry++) {
-      if (entry_is_present(entry) &&
+      if (entry_is_present(ht, entry) &&
           (!predicate || predicate(entry))) {
          return entry;
       }
    }
 
    for (entry = ht->table; entry != ht->table + i; entry++) {
-      if (entry_is_present(entry) &&
+      if (entry_is_present(ht, entry) &&
           (!predicate || predicate(entry))) {
          return entry;
       }
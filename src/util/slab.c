@@ -106,10 +106,11 @@ slab_create_parent(struct slab_parent_pool *parent,
                    unsigned item_size,
                    unsigned num_items)
 {
-   mtx_init(&parent->mutex, mtx_plain);
    parent->element_size = ALIGN_POT(sizeof(struct slab_element_header) + item_size,
                                     sizeof(intptr_t));
    parent->num_elements = num_items;
+   parent->children = NULL;
+   (void) mtx_init(&parent->mutex, mtx_plain);
 }
 
 void
@@ -128,6 +129,12 @@ void slab_create_child(struct slab_child_pool *pool,
    pool->pages = NULL;
    pool->free = NULL;
    pool->migrated = NULL;
+   pool->migrating_to = NULL;
+
+   mtx_lock(&parent->mutex);
+   pool->next_sibling = parent->children;
+   parent->children = pool;
+   mtx_unlock(&parent->mutex);
 }
 
 /**
@@ -141,8 +148,6 @@ void slab_destroy_child(struct slab_child_pool *pool)
    if (!pool->parent)
       return; /* the slab probably wasn't even created */
 
-   mtx_lock(&pool->parent->mutex);
-
    while (pool->pages) {
       struct slab_page_header *page = pool->pages;
       pool->pages = page->u.next;
@@ -150,18 +155,39 @@ void slab_destroy_child(struct slab_child_pool *pool)
 
       for (unsigned i = 0; i < pool->parent->num_elements; ++i) {
          struct slab_element_header *elt = slab_get_element(pool->parent, page, i);
-         p_atomic_set(&elt->owner, (intptr_t)page | 1);
+         p_atomic_xchg(&elt->owner, (intptr_t)page | 1);
       }
    }
 
-   while (pool->migrated) {
-      struct slab_element_header *elt = pool->migrated;
-      pool->migrated = elt->next;
-      slab_free_orphaned(elt);
-   }
+   /* Wait for slab_free calls on sibling pools that may have seen this
+    * pool as the owner before the pages were orphaned. Anyone arriving
+    * later sees the orphaned owner and doesn't touch the pool. Both sides
+    * access elt->owner and migrating_to with read-modify-writes, so a
+    * slab_free that still saw this pool as the owner has its migrating_to
+    * visible here.
+    */
+   mtx_lock(&pool->parent->mutex);
+   struct slab_child_pool **link = &pool->parent->children;
+   for (struct slab_child_pool *sibling = pool->parent->children; sibling;
+        sibling = sibling->next_sibling) {
+      if (sibling == pool) {
+         *link = pool->next_sibling;
+         continue;
+      }
+      link = &sibling->next_sibling;
 
+      while (p_atomic_cmpxchg(&sibling->migrating_to, pool, pool) == pool)
+         thrd_yield();
+   }
    mtx_unlock(&pool->parent->mutex);
 
+   struct slab_element_header *migrated = p_atomic_xchg(&pool->migrated, NULL);
+   while (migrated) {
+      struct slab_element_header *elt = migrated;
+      migrated = elt->next;
+      slab_free_orphaned(elt);
+   }
+
    while (pool->free) {
       struct slab_element_header *elt = pool->free;
       pool->free = elt->next;
@@ -209,12 +235,11 @@ slab_alloc(struct slab_child_pool *pool)
 
    if (!pool->free) {
       /* First, collect elements that belong to us but were freed from a
-       * different child pool.
+       * different child pool. The whole list is taken at once, so this
+       * doesn't need to synchronize with the other pools.
        */
-      mtx_lock(&pool->parent->mutex);
-      pool->free = pool->migrated;
-      pool->migrated = NULL;
-      mtx_unlock(&pool->parent->mutex);
+      if (p_atomic_read(&pool->migrated))
+         pool->free = p_atomic_xchg(&pool->migrated, NULL);
 
       /* Now allocate a new page. */
       if (!pool->free && !slab_add_new_page(pool))
@@ -237,7 +262,8 @@ slab_alloc(struct slab_child_pool *pool)
  *
  * Freeing an object in a different child pool from the one where it was
  * allocated is allowed, as long the pool belong to the same parent. No
- * additional locking is required in this case.
+ * additional locking is required in this case, and the element is pushed
+ * onto the owner's migrated list without taking any lock.
  */
 void slab_free(struct slab_child_pool *pool, void *ptr)
 {
@@ -257,23 +283,36 @@ void slab_free(struct slab_child_pool *pool, void *ptr)
    }
 
    /* The slow case: migration or an orphaned page. */
-   mtx_lock(&pool->parent->mutex);
-
-   /* Note: we _must_ re-read elt->owner here because the owning child pool
-    * may have been destroyed by another thread in the meantime.
-    */
    owner_int = p_atomic_read(&elt->owner);
 
    if (!(owner_int & 1)) {
       struct slab_child_pool *owner = (struct slab_child_pool *)owner_int;
-      elt->next = owner->migrated;
-      owner->migrated = elt;
-      mtx_unlock(&pool->parent->mutex);
-   } else {
-      mtx_unlock(&pool->parent->mutex);
+      struct slab_element_header *head, *old;
 
-      slab_free_orphaned(elt);
+      /* Announce the owner we are about to touch, then re-read elt->owner:
+       * the owning child pool may have been destroyed by another thread in
+       * the meantime. If it is unchanged, slab_destroy_child on the owner
+       * waits for us before it releases the migrated list.
+       */
+      p_atomic_cmpxchg(&pool->migrating_to, NULL, owner);
+      owner_int = p_atomic_add_return(&elt->owner, 0);
+
+      if (owner_int == (intptr_t)owner) {
+         head = p_atomic_read(&owner->migrated);
+         do {
+            old = head;
+            elt->next = old;
+            head = p_atomic_cmpxchg(&owner->migrated, old, elt);
+         } while (head != old);
+      }
+
+      p_atomic_cmpxchg(&pool->migrating_to, owner, NULL);
+
+      if (owner_int == (intptr_t)owner)
+         return;
    }
+
+   slab_free_orphaned(elt);
 }
 
 /**
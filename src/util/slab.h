@@ -48,7 +48,12 @@ struct slab_element_header;
 struct slab_page_header;
 
 struct slab_parent_pool {
+   /* Protects the list of child pools. Only taken when a child pool is
+    * created or destroyed.
+    */
    mtx_t mutex;
+   struct slab_child_pool *children;
+
    unsigned element_size;
    unsigned num_elements;
 };
@@ -64,9 +69,19 @@ struct slab_child_pool {
    /* Elements that are owned by this pool but were freed with a different
     * pool as the argument to slab_free.
     *
-    * This list is protected by the parent mutex.
+    * Other pools push onto this list atomically, and the owner takes the
+    * whole list at once when it runs out of free elements.
     */
    struct slab_element_header *migrated;
+
+   /* The pool whose migrated list slab_free on this pool is pushing onto,
+    * or NULL. slab_destroy_child waits until no sibling points at the pool
+    * being destroyed.
+    */
+   struct slab_child_pool *migrating_to;
+
+   /* Next child pool of the same parent. */
+   struct slab_child_pool *next_sibling;
 };
 
 void slab_create_parent(struct slab_parent_pool *parent,
@@ -0,0 +1,131 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Times insertion, successful and failed lookups, and removal for the
+ * pointer-keyed hash table and set, which is what most of the compiler uses
+ * them for.
+ */
+
+#undef NDEBUG
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "hash_table.h"
+#include "set.h"
+#include "os_time.h"
+
+#define SIZE 100000
+#define ROUNDS 20
+
+static void
+report(const char *name, int64_t start)
+{
+   int64_t ns = os_time_get_nano() - start;
+
+   printf("%-24s %8.2f ns/op\n", name, (double)ns / (SIZE * ROUNDS));
+}
+
+int
+main(int argc, char **argv)
+{
+   uintptr_t *keys = malloc(2 * SIZE * sizeof(*keys));
+   int64_t start;
+   unsigned found = 0;
+
+   (void) argc;
+   (void) argv;
+
+   /* The upper half of the keys is never inserted, for failed lookups. */
+   for (unsigned i = 0; i < 2 * SIZE; i++)
+      keys[i] = (uintptr_t)(i + 1) * 64;
+
+   struct hash_table *ht = _mesa_pointer_hash_table_create(NULL);
+
+   start = os_time_get_nano();
+   for (unsigned r = 0; r < ROUNDS; r++) {
+      _mesa_hash_table_clear(ht, NULL);
+      for (unsigned i = 0; i < SIZE; i++)
+         _mesa_hash_table_insert(ht, (void *)keys[i], NULL);
+   }
+   report("hash_table insert", start);
+
+   start = os_time_get_nano();
+   for (unsigned r = 0; r < ROUNDS; r++) {
+      for (unsigned i = 0; i < SIZE; i++)
+         found += _mesa_hash_table_search(ht, (void *)keys[i]) != NULL;
+   }
+   report("hash_table search hit", start);
+
+   start = os_time_get_nano();
+   for (unsigned r = 0; r < ROUNDS; r++) {
+      for (unsigned i = SIZE; i < 2 * SIZE; i++)
+         found += _mesa_hash_table_search(ht, (void *)keys[i]) != NULL;
+   }
+   report("hash_table search miss", start);
+
+   assert(found == SIZE * ROUNDS);
+   found = 0;
+
+   start = os_time_get_nano();
+   for (unsigned r = 0; r < ROUNDS; r++) {
+      for (unsigned i = 0; i < SIZE; i++)
+         _mesa_hash_table_remove_key(ht, (void *)keys[i]);
+      for (unsigned i = 0; i < SIZE; i++)
+         _mesa_hash_table_insert(ht, (void *)keys[i], NULL);
+   }
+   report("hash_table remove+insert", start);
+
+   _mesa_hash_table_destroy(ht, NULL);
+
+   struct set *set = _mesa_pointer_set_create(NULL);
+
+   start = os_time_get_nano();
+   for (unsigned r = 0; r < ROUNDS; r++) {
+      _mesa_set_clear(set, NULL);
+      for (unsigned i = 0; i < SIZE; i++)
+         _mesa_set_add(set, (void *)keys[i]);
+   }
+   report("set add", start);
+
+   start = os_time_get_nano();
+   for (unsigned r = 0; r < ROUNDS; r++) {
+      for (unsigned i = 0; i < SIZE; i++)
+         found += _mesa_set_search(set, (void *)keys[i]) != NULL;
+   }
+   report("set search hit", start);
+
+   start = os_time_get_nano();
+   for (unsigned r = 0; r < ROUNDS; r++) {
+      for (unsigned i = SIZE; i < 2 * SIZE; i++)
+         found += _mesa_set_search(set, (void *)keys[i]) != NULL;
+   }
+   report("set search miss", start);
+
+   assert(found == SIZE * ROUNDS);
+
+   _mesa_set_destroy(set, NULL);
+   free(keys);
+
+   return EXIT_SUCCESS;
+}
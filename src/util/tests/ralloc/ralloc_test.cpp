@@ -0,0 +1,201 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "util/ralloc.h"
+#include "gtest/gtest.h"
+
+/* Whether [p, p + size) lies within size bytes of [first, first + size).
+ * Carved blocks are laid out one after the other, so with a generous bound
+ * this tells them apart from malloc'ed ones.
+ */
+static bool
+is_near(const void *first, const void *p, size_t size)
+{
+   uintptr_t a = (uintptr_t)first, b = (uintptr_t)p;
+   return b > a ? b - a < size : a - b < size;
+}
+
+TEST(ralloc_reserve, carves_children_in_order)
+{
+   void *ctx = ralloc_context(NULL);
+   ASSERT_TRUE(ralloc_reserve(ctx, 4 * 64, 4));
+
+   char *blocks[4];
+   for (unsigned i = 0; i < 4; i++) {
+      blocks[i] = (char *)ralloc_size(ctx, 64);
+      ASSERT_NE(blocks[i], nullptr);
+      memset(blocks[i], i + 1, 64);
+      EXPECT_EQ(ralloc_parent(blocks[i]), ctx);
+   }
+
+   for (unsigned i = 1; i < 4; i++) {
+      EXPECT_GT(blocks[i], blocks[i - 1]);
+      EXPECT_TRUE(is_near(blocks[0], blocks[i], 4096));
+   }
+
+   /* Writing one block must not have clobbered its neighbours. */
+   for (unsigned i = 0; i < 4; i++) {
+      for (unsigned j = 0; j < 64; j++)
+         ASSERT_EQ(blocks[i][j], (char)(i + 1));
+   }
+
+   ralloc_free(ctx);
+}
+
+TEST(ralloc_reserve, falls_back_when_full)
+{
+   void *ctx = ralloc_context(NULL);
+   ASSERT_TRUE(ralloc_reserve(ctx, 64, 1));
+
+   char *carved = (char *)ralloc_size(ctx, 64);
+   ASSERT_NE(carved, nullptr);
+
+   /* The reservation is used up, these come from malloc. */
+   char *big = (char *)ralloc_size(ctx, 1 << 20);
+   ASSERT_NE(big, nullptr);
+   memset(big, 0xaa, 1 << 20);
+
+   char *small = (char *)ralloc_size(ctx, 16);
+   ASSERT_NE(small, nullptr);
+   memset(small, 0xbb, 16);
+
+   EXPECT_EQ(ralloc_parent(big), ctx);
+   EXPECT_EQ(ralloc_parent(small), ctx);
+
+   ralloc_free(ctx);
+}
+
+TEST(ralloc_reserve, grow_carved_block)
+{
+   void *ctx = ralloc_context(NULL);
+   ASSERT_TRUE(ralloc_reserve(ctx, 2 * 32, 2));
+
+   char *a = (char *)ralloc_size(ctx, 32);
+   char *b = (char *)ralloc_size(ctx, 32);
+   ASSERT_NE(a, nullptr);
+   ASSERT_NE(b, nullptr);
+   for (unsigned i = 0; i < 32; i++) {
+      a[i] = i;
+      b[i] = 100 + i;
+   }
+
+   /* Growing a carved block moves it out of the reservation, keeping its
+    * contents and its place in the tree.
+    */
+   a = (char *)reralloc_size(ctx, a, 4096);
+   ASSERT_NE(a, nullptr);
+   EXPECT_EQ(ralloc_parent(a), ctx);
+   for (unsigned i = 0; i < 32; i++)
+      EXPECT_EQ(a[i], (char)i);
+   memset(a + 32, 0xcc, 4096 - 32);
+
+   for (unsigned i = 0; i < 32; i++)
+      EXPECT_EQ(b[i], (char)(100 + i));
+
+   /* ralloc_strcat grows through the same path. */
+   char *str = ralloc_strdup(ctx, "carved");
+   ASSERT_NE(str, nullptr);
+   ASSERT_TRUE(ralloc_strcat(&str, " and then grown well past its size"));
+   EXPECT_STREQ(str, "carved and then grown well past its size");
+
+   ralloc_free(ctx);
+}
+
+TEST(ralloc_reserve, reuse_after_children_freed)
+{
+   void *ctx = ralloc_context(NULL);
+   ASSERT_TRUE(ralloc_reserve(ctx, 3 * 48, 3));
+
+   void *first = ralloc_size(ctx, 48);
+   void *second = ralloc_size(ctx, 48);
+   ASSERT_NE(first, nullptr);
+   ASSERT_NE(second, nullptr);
+
+   /* The reservation is only rewound once nothing carved from it is left. */
+   ralloc_free(first);
+   void *third = ralloc_size(ctx, 48);
+   ASSERT_NE(third, nullptr);
+   EXPECT_NE(third, first);
+   EXPECT_GT(third, second);
+
+   ralloc_free(second);
+   ralloc_free(third);
+
+   void *again = ralloc_size(ctx, 48);
+   EXPECT_EQ(again, first);
+
+   ralloc_free(ctx);
+}
+
+TEST(ralloc_reserve, stolen_block_outlives_owner)
+{
+   void *ctx = ralloc_context(NULL);
+   void *other = ralloc_context(NULL);
+   ASSERT_TRUE(ralloc_reserve(ctx, 2 * 64, 2));
+
+   char *kept = (char *)ralloc_size(ctx, 64);
+   char *dropped = (char *)ralloc_size(ctx, 64);
+   ASSERT_NE(kept, nullptr);
+   ASSERT_NE(dropped, nullptr);
+   memset(kept, 0x5a, 64);
+
+   ralloc_steal(other, kept);
+   EXPECT_EQ(ralloc_parent(kept), other);
+
+   /* The reservation stays alive for as long as the stolen block does. */
+   ralloc_free(ctx);
+   for (unsigned i = 0; i < 64; i++)
+      ASSERT_EQ(kept[i], 0x5a);
+
+   /* Growing it afterwards releases the last reference to the reservation. */
+   kept = (char *)reralloc_size(other, kept, 1024);
+   ASSERT_NE(kept, nullptr);
+   for (unsigned i = 0; i < 64; i++)
+      ASSERT_EQ(kept[i], 0x5a);
+
+   ralloc_free(other);
+}
+
+TEST(ralloc_reserve, free_carved_block_with_children)
+{
+   void *ctx = ralloc_context(NULL);
+   ASSERT_TRUE(ralloc_reserve(ctx, 256, 4));
+
+   /* Only direct children of ctx are carved; grandchildren use malloc, but
+    * are still freed along with their carved parent.
+    */
+   void *parent = ralloc_size(ctx, 32);
+   ASSERT_NE(parent, nullptr);
+   for (unsigned i = 0; i < 8; i++)
+      ASSERT_NE(ralloc_size(parent, 128), nullptr);
+
+   ralloc_free(parent);
+
+   void *again = ralloc_size(ctx, 32);
+   EXPECT_EQ(again, parent);
+
+   ralloc_free(ctx);
+}
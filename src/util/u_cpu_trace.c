@@ -0,0 +1,213 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifdef HAVE_UTIL_CPU_TRACE
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#include "c11/threads.h"
+#include "util/os_time.h"
+#include "util/u_atomic.h"
+#include "util/u_cpu_trace.h"
+#include "util/u_debug.h"
+#include "util/u_thread.h"
+
+#define EVENTS_PER_BUFFER 4096
+
+struct cpu_trace_event {
+   const char *name; /* NULL for frame markers */
+   int64_t start;
+   int64_t duration;
+   int64_t thread_start;
+   int64_t thread_duration;
+   unsigned frame;
+};
+
+/* Events are collected per thread and written out in batches. */
+struct cpu_trace_buffer {
+   unsigned tid;
+   unsigned num_events;
+   struct cpu_trace_event events[EVENTS_PER_BUFFER];
+};
+
+int util_cpu_trace_state = -1;
+
+static once_flag init_once_flag = ONCE_FLAG_INIT;
+static mtx_t file_lock = _MTX_INITIALIZER_NP;
+static FILE *file;
+static tss_t buffer_key;
+static unsigned next_tid;
+static unsigned frame;
+
+static void
+flush_buffer(struct cpu_trace_buffer *buffer)
+{
+   int pid = getpid();
+
+   mtx_lock(&file_lock);
+   for (unsigned i = 0; i < buffer->num_events; i++) {
+      const struct cpu_trace_event *event = &buffer->events[i];
+
+      if (!event->name) {
+         fprintf(file,
+                 "{\"name\":\"frame\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,"
+                 "\"pid\":%d,\"tid\":%u,\"args\":{\"frame\":%u}},\n",
+                 event->start / 1000.0, pid, buffer->tid, event->frame);
+         continue;
+      }
+
+      fprintf(file,
+              "{\"name\":\"%s\",\"cat\":\"mesa\",\"ph\":\"X\",\"ts\":%.3f,"
+              "\"dur\":%.3f,\"tts\":%.3f,\"tdur\":%.3f,\"pid\":%d,\"tid\":%u},\n",
+              event->name, event->start / 1000.0, event->duration / 1000.0,
+              event->thread_start / 1000.0, event->thread_duration / 1000.0,
+              pid, buffer->tid);
+   }
+   fflush(file);
+   mtx_unlock(&file_lock);
+
+   buffer->num_events = 0;
+}
+
+static void
+destroy_buffer(void *data)
+{
+   struct cpu_trace_buffer *buffer = data;
+
+   flush_buffer(buffer);
+   free(buffer);
+}
+
+static void
+flush_at_exit(void)
+{
+   struct cpu_trace_buffer *buffer = tss_get(buffer_key);
+
+   if (buffer)
+      flush_buffer(buffer);
+}
+
+static void
+cpu_trace_init(void)
+{
+   const char *path = getenv("MESA_CPU_TRACE");
+
+   if (path) {
+      file = fopen(path, "w");
+      if (!file)
+         debug_printf("MESA_CPU_TRACE: failed to open %s\n", path);
+   }
+
+   if (file && tss_create(&buffer_key, destroy_buffer) != thrd_success) {
+      fclose(file);
+      file = NULL;
+   }
+
+   if (file) {
+      /* The closing bracket is optional in this format, which keeps the
+       * file valid no matter how the process ends.
+       */
+      fprintf(file, "[\n");
+      atexit(flush_at_exit);
+   }
+
+   p_atomic_set(&util_cpu_trace_state, file != NULL);
+}
+
+static struct cpu_trace_event *
+add_event(void)
+{
+   struct cpu_trace_buffer *buffer = tss_get(buffer_key);
+
+   if (!buffer) {
+      buffer = malloc(sizeof(*buffer));
+      if (!buffer)
+         return NULL;
+
+      buffer->tid = p_atomic_inc_return(&next_tid);
+      buffer->num_events = 0;
+      tss_set(buffer_key, buffer);
+   }
+
+   if (buffer->num_events == EVENTS_PER_BUFFER)
+      flush_buffer(buffer);
+
+   return &buffer->events[buffer->num_events++];
+}
+
+void
+util_cpu_trace_begin_slow(struct util_cpu_trace_scope *scope, const char *name)
+{
+   call_once(&init_once_flag, cpu_trace_init);
+   if (!util_cpu_trace_state)
+      return;
+
+   scope->name = name;
+   scope->thread_start = u_thread_get_time_nano(thrd_current());
+   scope->start = os_time_get_nano();
+}
+
+void
+util_cpu_trace_end_slow(struct util_cpu_trace_scope *scope)
+{
+   int64_t end = os_time_get_nano();
+   int64_t thread_end = u_thread_get_time_nano(thrd_current());
+   struct cpu_trace_event *event = add_event();
+
+   if (!event)
+      return;
+
+   event->name = scope->name;
+   event->start = scope->start;
+   event->duration = end - scope->start;
+   event->thread_start = scope->thread_start;
+   event->thread_duration = thread_end - scope->thread_start;
+}
+
+void
+util_cpu_trace_frame(void)
+{
+   struct cpu_trace_event *event;
+
+   call_once(&init_once_flag, cpu_trace_init);
+   if (!util_cpu_trace_state)
+      return;
+
+   event = add_event();
+   if (!event)
+      return;
+
+   event->name = NULL;
+   event->start = os_time_get_nano();
+   event->frame = p_atomic_inc_return(&frame);
+}
+
+#endif
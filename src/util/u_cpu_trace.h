@@ -0,0 +1,114 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Scoped CPU trace points.
+ *
+ * Build with -Dcpu-trace=true and run with MESA_CPU_TRACE=<file> to record
+ * the wall and thread CPU time spent in every trace scope, along with frame
+ * boundaries, to <file> in the Chrome trace event JSON format.  The result
+ * can be loaded in chrome://tracing or ui.perfetto.dev.
+ *
+ * Without the build option all of this compiles to nothing.  With it but
+ * without the environment variable, each scope costs one predictable branch.
+ *
+ * Scope names must be string literals (or outlive the thread recording
+ * them), because they are only written out later.
+ */
+
+#ifndef U_CPU_TRACE_H
+#define U_CPU_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util/macros.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef HAVE_UTIL_CPU_TRACE
+
+struct util_cpu_trace_scope {
+   const char *name;
+   int64_t start;
+   int64_t thread_start;
+};
+
+/* -1 until MESA_CPU_TRACE has been looked at, then 0 or 1. */
+extern int util_cpu_trace_state;
+
+void
+util_cpu_trace_begin_slow(struct util_cpu_trace_scope *scope, const char *name);
+
+void
+util_cpu_trace_end_slow(struct util_cpu_trace_scope *scope);
+
+void
+util_cpu_trace_frame(void);
+
+static inline struct util_cpu_trace_scope
+util_cpu_trace_begin(const char *name)
+{
+   struct util_cpu_trace_scope scope = { NULL, 0, 0 };
+
+   if (unlikely(util_cpu_trace_state != 0))
+      util_cpu_trace_begin_slow(&scope, name);
+
+   return scope;
+}
+
+static inline void
+util_cpu_trace_end(struct util_cpu_trace_scope *scope)
+{
+   if (unlikely(scope->name))
+      util_cpu_trace_end_slow(scope);
+}
+
+#define _UTIL_CPU_TRACE_CONCAT2(a, b) a ## b
+#define _UTIL_CPU_TRACE_CONCAT(a, b) _UTIL_CPU_TRACE_CONCAT2(a, b)
+
+/* Records the time from here to the end of the enclosing block. */
+#define UTIL_CPU_TRACE_SCOPE(name) \
+   struct util_cpu_trace_scope \
+      _UTIL_CPU_TRACE_CONCAT(_cpu_trace_scope_, __LINE__) \
+      __attribute__((cleanup(util_cpu_trace_end))) = \
+      util_cpu_trace_begin(name)
+
+/* Marks the end of a frame, e.g. on SwapBuffers or vkQueuePresentKHR. */
+#define UTIL_CPU_TRACE_FRAME() util_cpu_trace_frame()
+
+#else
+
+#define UTIL_CPU_TRACE_SCOPE(name)
+#define UTIL_CPU_TRACE_FRAME() do { } while (0)
+
+#endif
+
+#define UTIL_CPU_TRACE_FUNC() UTIL_CPU_TRACE_SCOPE(__func__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_CPU_TRACE_H */
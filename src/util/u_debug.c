@@ -79,6 +79,31 @@ _pipe_debug_message(struct pipe_debug_callback *cb,
 }
 
 
+/**
+ * Report the statistics of a shader binary as a
+ * PIPE_DEBUG_TYPE_SHADER_STATS message.  Unlike the SHADER_INFO messages,
+ * the format is the same for all drivers, and all of them use the same id,
+ * so that applications can pick them out of the debug output and parse
+ * them:
+ *
+ *    stage=FS simd=16 instructions=120 sends=4 loops=0 cycles=530 spills=0 fills=0 registers=0 code_size=0
+ */
+void
+pipe_debug_shader_stats(struct pipe_debug_callback *cb,
+                        const struct pipe_shader_stats *stats)
+{
+   static unsigned id = 0;
+
+   _pipe_debug_message(cb, &id, PIPE_DEBUG_TYPE_SHADER_STATS,
+                       "stage=%s simd=%u instructions=%u sends=%u loops=%u "
+                       "cycles=%u spills=%u fills=%u registers=%u code_size=%u",
+                       stats->stage, stats->dispatch_width,
+                       stats->instructions, stats->sends, stats->loops,
+                       stats->cycles, stats->spills, stats->fills,
+                       stats->registers, stats->code_size);
+}
+
+
 void
 debug_disable_error_message_boxes(void)
 {
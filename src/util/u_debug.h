@@ -280,6 +280,27 @@ _pipe_debug_message(
    enum pipe_debug_type type,
    const char *fmt, ...) _util_printf_format(4, 5);
 
+/**
+ * Compiler statistics of a shader binary, 0 when a driver doesn't know.
+ */
+struct pipe_shader_stats
+{
+   const char *stage;        /**< "VS", "FS", ... */
+   unsigned dispatch_width;  /**< SIMD width or wave size */
+   unsigned instructions;
+   unsigned sends;           /**< memory & message instructions */
+   unsigned loops;
+   unsigned cycles;          /**< estimated */
+   unsigned spills;
+   unsigned fills;
+   unsigned registers;       /**< general purpose registers used */
+   unsigned code_size;       /**< in bytes */
+};
+
+void
+pipe_debug_shader_stats(struct pipe_debug_callback *cb,
+                        const struct pipe_shader_stats *stats);
+
 
 /**
  * Used by debug_dump_enum and debug_dump_flags to describe symbols.
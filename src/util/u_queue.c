@@ -29,6 +29,8 @@
 #include "c11/threads.h"
 
 #include "util/os_time.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_cpu_trace.h"
 #include "util/u_string.h"
 #include "util/u_thread.h"
 #include "u_process.h"
@@ -47,6 +49,9 @@ static void
 util_queue_kill_threads(struct util_queue *queue, unsigned keep_num_threads,
                         bool finish_locked);
 
+static void
+util_queue_finish_execute(void *data, int num_thread);
+
 /****************************************************************************
  * Wait for all queues to assert idle when exit() is called.
  *
@@ -103,6 +108,70 @@ remove_from_atexit_list(struct util_queue *queue)
    mtx_unlock(&exit_mutex);
 }
 
+/****************************************************************************
+ * Process-wide limit of running jobs for UTIL_QUEUE_INIT_SHARED_CPU_LIMIT
+ */
+
+static once_flag cpu_limit_once_flag = ONCE_FLAG_INIT;
+static mtx_t cpu_limit_mutex = _MTX_INITIALIZER_NP;
+static cnd_t cpu_limit_cond;
+static int cpu_limit_available;
+
+/* Set in threads while they run a limited job. */
+static tss_t cpu_limit_held;
+
+static void
+cpu_limit_init(void)
+{
+   util_cpu_detect();
+   cpu_limit_available = MAX2(util_cpu_caps.nr_cpus, 1);
+   cnd_init(&cpu_limit_cond);
+   tss_create(&cpu_limit_held, NULL);
+}
+
+static void
+cpu_limit_acquire(void)
+{
+   call_once(&cpu_limit_once_flag, cpu_limit_init);
+
+   mtx_lock(&cpu_limit_mutex);
+   while (cpu_limit_available == 0)
+      cnd_wait(&cpu_limit_cond, &cpu_limit_mutex);
+   cpu_limit_available--;
+   mtx_unlock(&cpu_limit_mutex);
+}
+
+static void
+cpu_limit_release(void)
+{
+   mtx_lock(&cpu_limit_mutex);
+   cpu_limit_available++;
+   cnd_signal(&cpu_limit_cond);
+   mtx_unlock(&cpu_limit_mutex);
+}
+
+/* A limited job that waits for a fence gives its slot back while it sleeps,
+ * in case the job it waits for needs that slot to run.
+ */
+static bool
+cpu_limit_suspend(void)
+{
+   call_once(&cpu_limit_once_flag, cpu_limit_init);
+
+   if (!tss_get(cpu_limit_held))
+      return false;
+
+   cpu_limit_release();
+   return true;
+}
+
+static void
+cpu_limit_resume(bool suspended)
+{
+   if (suspended)
+      cpu_limit_acquire();
+}
+
 /****************************************************************************
  * util_queue_fence
  */
@@ -139,14 +208,19 @@ do_futex_fence_wait(struct util_queue_fence *fence,
 void
 _util_queue_fence_wait(struct util_queue_fence *fence)
 {
+   bool suspended = cpu_limit_suspend();
    do_futex_fence_wait(fence, false, 0);
+   cpu_limit_resume(suspended);
 }
 
 bool
 _util_queue_fence_wait_timeout(struct util_queue_fence *fence,
                                int64_t abs_timeout)
 {
-   return do_futex_fence_wait(fence, true, abs_timeout);
+   bool suspended = cpu_limit_suspend();
+   bool signalled = do_futex_fence_wait(fence, true, abs_timeout);
+   cpu_limit_resume(suspended);
+   return signalled;
 }
 
 #endif
@@ -164,10 +238,12 @@ util_queue_fence_signal(struct util_queue_fence *fence)
 void
 _util_queue_fence_wait(struct util_queue_fence *fence)
 {
+   bool suspended = cpu_limit_suspend();
    mtx_lock(&fence->mutex);
    while (!fence->signalled)
       cnd_wait(&fence->cond, &fence->mutex);
    mtx_unlock(&fence->mutex);
+   cpu_limit_resume(suspended);
 }
 
 bool
@@ -192,12 +268,14 @@ _util_queue_fence_wait_timeout(struct util_queue_fence *fence,
          ts.tv_nsec -= (1000*1000*1000);
       }
 
+      bool suspended = cpu_limit_suspend();
       mtx_lock(&fence->mutex);
       while (!fence->signalled) {
          if (cnd_timedwait(&fence->cond, &fence->mutex, &ts) != thrd_success)
             break;
       }
       mtx_unlock(&fence->mutex);
+      cpu_limit_resume(suspended);
    }
 
    return fence->signalled;
@@ -299,13 +377,35 @@ util_queue_thread_func(void *input)
       queue->read_idx = (queue->read_idx + 1) % queue->max_jobs;
 
       queue->num_queued--;
+      if (queue->num_queued_high)
+         queue->num_queued_high--;
       cnd_signal(&queue->has_space_cond);
       if (job.job)
          queue->total_jobs_size -= job.job_size;
       mtx_unlock(&queue->lock);
 
       if (job.job) {
-         job.execute(job.job, thread_index);
+         /* util_queue_finish() needs all threads of the queue at the same
+          * time, so it can't be limited.
+          */
+         bool limited = queue->flags & UTIL_QUEUE_INIT_SHARED_CPU_LIMIT &&
+                        job.execute != util_queue_finish_execute;
+
+         if (limited) {
+            cpu_limit_acquire();
+            tss_set(cpu_limit_held, (void *)1);
+         }
+
+         {
+            UTIL_CPU_TRACE_SCOPE(queue->name);
+            job.execute(job.job, thread_index);
+         }
+
+         if (limited) {
+            tss_set(cpu_limit_held, NULL);
+            cpu_limit_release();
+         }
+
          util_queue_fence_signal(job.fence);
          if (job.cleanup)
             job.cleanup(job.job, thread_index);
@@ -324,6 +424,7 @@ util_queue_thread_func(void *input)
       }
       queue->read_idx = queue->write_idx;
       queue->num_queued = 0;
+      queue->num_queued_high = 0;
    }
    mtx_unlock(&queue->lock);
    return 0;
@@ -528,6 +629,26 @@ util_queue_destroy(struct util_queue *queue)
    free(queue->threads);
 }
 
+/* Move the job at ring index "idx" to the end of the high priority jobs,
+ * shifting the normal priority jobs in front of it back by one.
+ * Called with the queue lock held.
+ */
+static void
+util_queue_move_to_high_priority(struct util_queue *queue, unsigned idx)
+{
+   unsigned dst = (queue->read_idx + queue->num_queued_high) % queue->max_jobs;
+   struct util_queue_job job = queue->jobs[idx];
+
+   while (idx != dst) {
+      unsigned prev = (idx + queue->max_jobs - 1) % queue->max_jobs;
+      queue->jobs[idx] = queue->jobs[prev];
+      idx = prev;
+   }
+
+   queue->jobs[dst] = job;
+   queue->num_queued_high++;
+}
+
 void
 util_queue_add_job(struct util_queue *queue,
                    void *job,
@@ -535,6 +656,19 @@ util_queue_add_job(struct util_queue *queue,
                    util_queue_execute_func execute,
                    util_queue_execute_func cleanup,
                    const size_t job_size)
+{
+   util_queue_add_job_with_priority(queue, job, fence, execute, cleanup,
+                                    job_size, UTIL_QUEUE_PRIORITY_NORMAL);
+}
+
+void
+util_queue_add_job_with_priority(struct util_queue *queue,
+                                 void *job,
+                                 struct util_queue_fence *fence,
+                                 util_queue_execute_func execute,
+                                 util_queue_execute_func cleanup,
+                                 const size_t job_size,
+                                 enum util_queue_priority priority)
 {
    struct util_queue_job *ptr;
 
@@ -594,9 +728,12 @@ util_queue_add_job(struct util_queue *queue,
    ptr->cleanup = cleanup;
    ptr->job_size = job_size;
 
-   queue->write_idx = (queue->write_idx + 1) % queue->max_jobs;
    queue->total_jobs_size += ptr->job_size;
 
+   if (priority == UTIL_QUEUE_PRIORITY_HIGH)
+      util_queue_move_to_high_priority(queue, queue->write_idx);
+
+   queue->write_idx = (queue->write_idx + 1) % queue->max_jobs;
    queue->num_queued++;
    cnd_signal(&queue->has_queued_cond);
    mtx_unlock(&queue->lock);
@@ -641,6 +778,30 @@ util_queue_drop_job(struct util_queue *queue, struct util_queue_fence *fence)
       util_queue_fence_wait(fence);
 }
 
+/**
+ * Make a queued job high priority, so that it runs before all normal priority
+ * jobs. Call this before waiting for a job that was queued speculatively.
+ * Nothing happens if the job has already started execution.
+ */
+void
+util_queue_prioritize_job(struct util_queue *queue,
+                          struct util_queue_fence *fence)
+{
+   if (util_queue_fence_is_signalled(fence))
+      return;
+
+   mtx_lock(&queue->lock);
+   for (int n = queue->num_queued_high; n < queue->num_queued; n++) {
+      unsigned i = (queue->read_idx + n) % queue->max_jobs;
+
+      if (queue->jobs[i].fence == fence) {
+         util_queue_move_to_high_priority(queue, i);
+         break;
+      }
+   }
+   mtx_unlock(&queue->lock);
+}
+
 static void
 util_queue_finish_execute(void *data, int num_thread)
 {
@@ -49,6 +49,11 @@ extern "C" {
 #define UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY      (1 << 0)
 #define UTIL_QUEUE_INIT_RESIZE_IF_FULL            (1 << 1)
 #define UTIL_QUEUE_INIT_SET_FULL_THREAD_AFFINITY  (1 << 2)
+/* Jobs of all queues created with this flag share a process-wide limit of
+ * one running job per CPU, so that several screens or devices compiling at
+ * the same time don't oversubscribe the CPU.
+ */
+#define UTIL_QUEUE_INIT_SHARED_CPU_LIMIT          (1 << 3)
 
 #if UTIL_FUTEX_SUPPORTED
 #define UTIL_QUEUE_FENCE_FUTEX
@@ -191,6 +196,14 @@ util_queue_fence_wait_timeout(struct util_queue_fence *fence,
 
 typedef void (*util_queue_execute_func)(void *job, int thread_index);
 
+enum util_queue_priority {
+   UTIL_QUEUE_PRIORITY_NORMAL,
+   /* Something is or will soon be blocked on the job, e.g. a draw call
+    * waiting for a shader. High priority jobs run before all normal ones.
+    */
+   UTIL_QUEUE_PRIORITY_HIGH,
+};
+
 struct util_queue_job {
    void *job;
    size_t job_size;
@@ -213,6 +226,7 @@ struct util_queue {
    unsigned num_threads; /* decreasing this number will terminate threads */
    int max_jobs;
    int write_idx, read_idx; /* ring buffer pointers */
+   int num_queued_high; /* high priority jobs, at the front of the ring */
    size_t total_jobs_size;  /* memory use of all jobs in the queue */
    struct util_queue_job *jobs;
 
@@ -234,8 +248,17 @@ void util_queue_add_job(struct util_queue *queue,
                         util_queue_execute_func execute,
                         util_queue_execute_func cleanup,
                         const size_t job_size);
+void util_queue_add_job_with_priority(struct util_queue *queue,
+                                      void *job,
+                                      struct util_queue_fence *fence,
+                                      util_queue_execute_func execute,
+                                      util_queue_execute_func cleanup,
+                                      const size_t job_size,
+                                      enum util_queue_priority priority);
 void util_queue_drop_job(struct util_queue *queue,
                          struct util_queue_fence *fence);
+void util_queue_prioritize_job(struct util_queue *queue,
+                               struct util_queue_fence *fence);
 
 void util_queue_finish(struct util_queue *queue);
 
@@ -21,6 +21,7 @@
  * IN THE SOFTWARE.
  */
 
+#include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>
@@ -34,13 +35,16 @@
 
 #include "overlay_params.h"
 
+#include "util/bitscan.h"
 #include "util/debug.h"
-#include "util/hash_table.h"
 #include "util/list.h"
 #include "util/ralloc.h"
 #include "util/os_time.h"
 #include "util/os_socket.h"
 #include "util/simple_mtx.h"
+#include "util/u_atomic.h"
+#include "util/u_math.h"
+#include "util/u_queue.h"
 
 #include "vk_enum_to_str.h"
 #include "vk_util.h"
@@ -54,6 +58,7 @@ struct instance_data {
    bool pipeline_statistics_enabled;
 
    bool first_line_printed;
+   bool draw_timing_first_line_printed;
 
    int control_client;
 
@@ -68,6 +73,19 @@ struct frame_stat {
    uint64_t stats[OVERLAY_PARAM_ENABLED_MAX];
 };
 
+/* Intervals timed by draw_timing per command buffer, further render passes
+ * or draws are not timed.
+ */
+#define OVERLAY_DRAW_TIMING_INTERVALS 64
+
+/* Histogram buckets of draw_timing : <1us, 1-2us, 2-4us, ..., >=16ms */
+#define OVERLAY_DRAW_TIMING_BUCKETS 16
+
+struct draw_timing_stat {
+   uint64_t gpu_time; /* ns */
+   uint32_t buckets[OVERLAY_DRAW_TIMING_BUCKETS];
+};
+
 /* Mapped from VkDevice */
 struct queue_data;
 struct device_data {
@@ -88,6 +106,13 @@ struct device_data {
 
    /* For a single frame */
    struct frame_stat frame_stats;
+
+   /* Command buffers with draw_timing results not read yet */
+   simple_mtx_t draw_timing_mtx;
+   struct list_head draw_timing_pending;
+
+   /* draw_timing results read since the last frame */
+   struct draw_timing_stat draw_timing;
 };
 
 /* Mapped from VkCommandBuffer */
@@ -101,9 +126,17 @@ struct command_buffer_data {
    VkQueryPool timestamp_query_pool;
    uint32_t query_index;
 
+   /* draw_timing, 2 timestamps per interval */
+   VkQueryPool draw_timing_query_pool;
+   uint32_t draw_timing_intervals;
+   uint32_t draw_timing_draws; /* Draws in the interval being timed */
+   bool draw_timing_open;
+   uint64_t draw_timing_mask; /* Timestamp mask of the queue submitted to */
+
    struct frame_stat stats;
 
    struct list_head link; /* link into queue_data::running_command_buffer */
+   struct list_head draw_timing_link; /* link into device_data::draw_timing_pending */
 };
 
 /* Mapped from VkQueue */
@@ -196,6 +229,10 @@ struct swapchain_data {
 
    /* Over fps_sampling_period */
    struct frame_stat accumulated_stats;
+
+   /* Builds the ImGui draw data off the present path */
+   struct util_queue display_queue;
+   struct util_queue_fence display_fence;
 };
 
 static const VkQueryPipelineStatisticFlags overlay_query_flags =
@@ -212,41 +249,199 @@ static const VkQueryPipelineStatisticFlags overlay_query_flags =
    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
 #define OVERLAY_QUERY_COUNT (11)
 
-static struct hash_table_u64 *vk_object_to_data = NULL;
+/* Vulkan handles to our data.  Lookups happen on every intercepted call, so
+ * they don't take any lock : the table uses open addressing and removed
+ * entries just get a NULL data, leaving their key in place so that probing
+ * goes past them.  Such a removed entry is reused by the next insertion
+ * probing through it.  Insertions & removals are serialized by
+ * vk_object_to_data_mutex.
+ *
+ * A table replaced by a new one can still be looked at by other threads.
+ * Lookups are counted per epoch in vk_object_readers.  The replaced tables
+ * are handed over to the other epoch, and freed once no lookup of the epoch
+ * which could still see them is left.
+ */
+struct object_map_entry {
+   uint64_t key;
+   void *data;
+};
+
+struct object_map {
+   unsigned bits; /* log2 of the number of entries */
+   uint32_t used; /* entries with a key, removed or not */
+   struct object_map_entry *entries;
+   struct object_map *retired_next;
+};
+
+static struct object_map *vk_object_to_data = NULL;
+static struct object_map *vk_object_to_data_retired = NULL;
+static struct object_map *vk_object_to_data_draining = NULL;
+static uint32_t vk_object_count = 0;
+static uint32_t vk_object_epoch = 0;
+static uint32_t vk_object_readers[2] = { 0, 0 };
 static simple_mtx_t vk_object_to_data_mutex = _SIMPLE_MTX_INITIALIZER_NP;
 
 thread_local ImGuiContext* __MesaImGui;
 
-static inline void ensure_vk_object_map(void)
+#define HKEY(obj) ((uint64_t)(obj))
+#define FIND(type, obj) ((type *)find_object_data(HKEY(obj)))
+
+static inline uint32_t object_map_hash(const struct object_map *map, uint64_t obj)
 {
-   if (!vk_object_to_data)
-      vk_object_to_data = _mesa_hash_table_u64_create(NULL);
+   /* Fibonacci hashing, handles are often aligned pointers. */
+   return (obj * 0x9e3779b97f4a7c15ull) >> (64 - map->bits);
 }
 
-#define HKEY(obj) ((uint64_t)(obj))
-#define FIND(type, obj) ((type *)find_object_data(HKEY(obj)))
+static struct object_map_entry *object_map_search(const struct object_map *map,
+                                                  uint64_t obj)
+{
+   uint32_t mask = (1u << map->bits) - 1;
+   for (uint32_t i = object_map_hash(map, obj);; i = (i + 1) & mask) {
+      uint64_t key = p_atomic_read(&map->entries[i].key);
+      if (key == obj || key == 0)
+         return &map->entries[i];
+   }
+}
+
+/* Returns the entry of obj if it's in the table, otherwise the first removed
+ * entry on its probe sequence, or the empty entry ending it.
+ */
+static struct object_map_entry *object_map_slot(const struct object_map *map,
+                                                uint64_t obj)
+{
+   uint32_t mask = (1u << map->bits) - 1;
+   struct object_map_entry *removed = NULL;
+   for (uint32_t i = object_map_hash(map, obj);; i = (i + 1) & mask) {
+      struct object_map_entry *entry = &map->entries[i];
+      if (entry->key == obj)
+         return entry;
+      if (entry->key == 0)
+         return removed ? removed : entry;
+      if (!removed && !entry->data)
+         removed = entry;
+   }
+}
+
+static struct object_map *object_map_create(unsigned bits)
+{
+   struct object_map *map = (struct object_map *)calloc(1, sizeof(*map));
+   map->bits = bits;
+   map->entries = (struct object_map_entry *)
+      calloc(1u << bits, sizeof(*map->entries));
+   return map;
+}
+
+static void object_map_insert(struct object_map *map, uint64_t obj, void *data)
+{
+   struct object_map_entry *entry = object_map_slot(map, obj);
+   if (entry->key == 0)
+      map->used++;
+   /* A reused entry keeps a NULL data until it has its new key. */
+   if (entry->key != obj)
+      p_atomic_set(&entry->key, obj);
+   p_atomic_set(&entry->data, data);
+}
 
 static void *find_object_data(uint64_t obj)
 {
-   simple_mtx_lock(&vk_object_to_data_mutex);
-   ensure_vk_object_map();
-   void *data = _mesa_hash_table_u64_search(vk_object_to_data, obj);
-   simple_mtx_unlock(&vk_object_to_data_mutex);
+   if (obj == 0)
+      return NULL;
+
+   void *data = NULL;
+   uint32_t epoch = p_atomic_read(&vk_object_epoch) & 1;
+
+   p_atomic_inc(&vk_object_readers[epoch]);
+
+   struct object_map *map = p_atomic_read(&vk_object_to_data);
+   if (map) {
+      struct object_map_entry *entry = object_map_search(map, obj);
+      if (entry->key)
+         data = p_atomic_read(&entry->data);
+   }
+
+   p_atomic_dec(&vk_object_readers[epoch]);
+
    return data;
 }
 
+static void free_retired_object_maps(void)
+{
+   /* The draining tables were replaced before the last epoch change, only
+    * lookups of the previous epoch may still see them.
+    */
+   if (vk_object_to_data_draining &&
+       p_atomic_read(&vk_object_readers[(vk_object_epoch + 1) & 1]) != 0)
+      return;
+
+   while (vk_object_to_data_draining) {
+      struct object_map *retired = vk_object_to_data_draining;
+      vk_object_to_data_draining = retired->retired_next;
+      free(retired->entries);
+      free(retired);
+   }
+
+   if (vk_object_to_data_retired) {
+      vk_object_to_data_draining = vk_object_to_data_retired;
+      vk_object_to_data_retired = NULL;
+      /* Full barrier, lookups counted in the new epoch see the new table. */
+      p_atomic_inc(&vk_object_epoch);
+   }
+}
+
 static void map_object(uint64_t obj, void *data)
 {
    simple_mtx_lock(&vk_object_to_data_mutex);
-   ensure_vk_object_map();
-   _mesa_hash_table_u64_insert(vk_object_to_data, obj, data);
+
+   struct object_map *map = vk_object_to_data;
+   struct object_map_entry *entry = map ? object_map_slot(map, obj) : NULL;
+
+   if (!entry || entry->key != obj || !entry->data)
+      vk_object_count++;
+
+   /* Keep the table at most half full.  The replacement is sized for the
+    * live objects and doesn't have the removed entries.
+    */
+   if (!entry || (entry->key == 0 && (map->used + 1) * 2 > (1u << map->bits))) {
+      struct object_map *new_map =
+         object_map_create(MAX2(util_logbase2_ceil(vk_object_count) + 2, 6));
+
+      if (map) {
+         for (uint32_t i = 0; i < (1u << map->bits); i++) {
+            if (map->entries[i].data)
+               object_map_insert(new_map, map->entries[i].key, map->entries[i].data);
+         }
+         map->retired_next = vk_object_to_data_retired;
+         vk_object_to_data_retired = map;
+      }
+
+      /* Full barrier, lookups starting after the readers count is checked
+       * must see the new table.  Only this thread can change the pointer.
+       */
+      p_atomic_cmpxchg(&vk_object_to_data, map, new_map);
+      map = new_map;
+   }
+
+   object_map_insert(map, obj, data);
+
+   free_retired_object_maps();
+
    simple_mtx_unlock(&vk_object_to_data_mutex);
 }
 
 static void unmap_object(uint64_t obj)
 {
    simple_mtx_lock(&vk_object_to_data_mutex);
-   _mesa_hash_table_u64_remove(vk_object_to_data, obj);
+
+   struct object_map *map = vk_object_to_data;
+   struct object_map_entry *entry = map ? object_map_search(map, obj) : NULL;
+
+   if (entry && entry->key && entry->data) {
+      p_atomic_set(&entry->data, (void *)NULL);
+      vk_object_count--;
+   }
+
+   free_retired_object_maps();
+
    simple_mtx_unlock(&vk_object_to_data_mutex);
 }
 
@@ -369,6 +564,8 @@ static struct device_data *new_device_data(VkDevice device, struct instance_data
    struct device_data *data = rzalloc(NULL, struct device_data);
    data->instance = instance;
    data->device = device;
+   simple_mtx_init(&data->draw_timing_mtx, mtx_plain);
+   list_inithead(&data->draw_timing_pending);
    map_object(HKEY(data->device), data);
    return data;
 }
@@ -456,6 +653,7 @@ static void device_unmap_queues(struct device_data *data)
 static void destroy_device_data(struct device_data *data)
 {
    unmap_object(HKEY(data->device));
+   simple_mtx_destroy(&data->draw_timing_mtx);
    ralloc_free(data);
 }
 
@@ -464,6 +662,7 @@ static struct command_buffer_data *new_command_buffer_data(VkCommandBuffer cmd_b
                                                            VkCommandBufferLevel level,
                                                            VkQueryPool pipeline_query_pool,
                                                            VkQueryPool timestamp_query_pool,
+                                                           VkQueryPool draw_timing_query_pool,
                                                            uint32_t query_index,
                                                            struct device_data *device_data)
 {
@@ -473,8 +672,10 @@ static struct command_buffer_data *new_command_buffer_data(VkCommandBuffer cmd_b
    data->level = level;
    data->pipeline_query_pool = pipeline_query_pool;
    data->timestamp_query_pool = timestamp_query_pool;
+   data->draw_timing_query_pool = draw_timing_query_pool;
    data->query_index = query_index;
    list_inithead(&data->link);
+   list_inithead(&data->draw_timing_link);
    map_object(HKEY(data->cmd_buffer), data);
    return data;
 }
@@ -483,6 +684,7 @@ static void destroy_command_buffer_data(struct command_buffer_data *data)
 {
    unmap_object(HKEY(data->cmd_buffer));
    list_delinit(&data->link);
+   list_delinit(&data->draw_timing_link);
    ralloc_free(data);
 }
 
@@ -766,6 +968,28 @@ static void process_control_socket(struct instance_data *instance_data)
    }
 }
 
+static void write_draw_timing(struct swapchain_data *data)
+{
+   struct device_data *device_data = data->device;
+   struct instance_data *instance_data = device_data->instance;
+   FILE *f = instance_data->params.output_file;
+
+   if (!instance_data->draw_timing_first_line_printed) {
+      instance_data->draw_timing_first_line_printed = true;
+
+      fprintf(f, "draw_timing, frame, gpu_time(ns), <1us");
+      for (unsigned b = 1; b < OVERLAY_DRAW_TIMING_BUCKETS - 1; b++)
+         fprintf(f, ", <%uus", 1u << b);
+      fprintf(f, ", >=%uus\n", 1u << (OVERLAY_DRAW_TIMING_BUCKETS - 2));
+   }
+
+   fprintf(f, "draw_timing, %" PRIu64 ", %" PRIu64,
+           data->n_frames, device_data->draw_timing.gpu_time);
+   for (unsigned b = 0; b < OVERLAY_DRAW_TIMING_BUCKETS; b++)
+      fprintf(f, ", %u", device_data->draw_timing.buckets[b]);
+   fprintf(f, "\n");
+}
+
 static void snapshot_swapchain_frame(struct swapchain_data *data)
 {
    struct device_data *device_data = data->device;
@@ -789,6 +1013,9 @@ static void snapshot_swapchain_frame(struct swapchain_data *data)
       data->accumulated_stats.stats[s] += device_data->frame_stats.stats[s] + data->frame_stats.stats[s];
    }
 
+   if (instance_data->params.draw_timing && instance_data->capture_started)
+      write_draw_timing(data);
+
    /* If capture has been enabled but it hasn't started yet, it means we are on
     * the first snapshot after it has been enabled. At this point we want to
     * use the stats captured so far to update the display, but we don't want
@@ -856,6 +1083,7 @@ static void snapshot_swapchain_frame(struct swapchain_data *data)
    }
 
    memset(&device_data->frame_stats, 0, sizeof(device_data->frame_stats));
+   memset(&device_data->draw_timing, 0, sizeof(device_data->draw_timing));
    memset(&data->frame_stats, 0, sizeof(device_data->frame_stats));
 
    data->last_present_time = now;
@@ -1157,7 +1385,7 @@ static struct overlay_draw *render_swapchain_display(struct swapchain_data *data
                                                      unsigned image_index)
 {
    ImDrawData* draw_data = ImGui::GetDrawData();
-   if (draw_data->TotalVtxCount == 0)
+   if (!draw_data || draw_data->TotalVtxCount == 0)
       return NULL;
 
    struct device_data *device_data = data->device;
@@ -1681,6 +1909,11 @@ static void setup_swapchain_data(struct swapchain_data *data,
    ImGui::GetIO().IniFilename = NULL;
    ImGui::GetIO().DisplaySize = ImVec2((float)data->width, (float)data->height);
 
+   if (!data->device->instance->params.no_display) {
+      util_queue_fence_init(&data->display_fence);
+      util_queue_init(&data->display_queue, "overlay", 1, 1, 0);
+   }
+
    struct device_data *device_data = data->device;
 
    /* Render pass */
@@ -1782,6 +2015,12 @@ static void shutdown_swapchain_data(struct swapchain_data *data)
 {
    struct device_data *device_data = data->device;
 
+   if (!device_data->instance->params.no_display) {
+      util_queue_fence_wait(&data->display_fence);
+      util_queue_destroy(&data->display_queue);
+      util_queue_fence_destroy(&data->display_fence);
+   }
+
    list_for_each_entry_safe(struct overlay_draw, draw, &data->draws, link) {
       device_data->vtable.DestroySemaphore(device_data->device, draw->cross_engine_semaphore, NULL);
       device_data->vtable.DestroySemaphore(device_data->device, draw->semaphore, NULL);
@@ -1820,6 +2059,11 @@ static void shutdown_swapchain_data(struct swapchain_data *data)
    ImGui::DestroyContext(data->imgui_context);
 }
 
+static void compute_swapchain_display_job(void *job, int thread_index)
+{
+   compute_swapchain_display((struct swapchain_data *)job);
+}
+
 static struct overlay_draw *before_present(struct swapchain_data *swapchain_data,
                                            struct queue_data *present_queue,
                                            const VkSemaphore *wait_semaphores,
@@ -1829,13 +2073,25 @@ static struct overlay_draw *before_present(struct swapchain_data *swapchain_data
    struct instance_data *instance_data = swapchain_data->device->instance;
    struct overlay_draw *draw = NULL;
 
+   /* The display built during the previous frame reads the stats, wait for
+    * it before updating them.
+    */
+   if (!instance_data->params.no_display)
+      util_queue_fence_wait(&swapchain_data->display_fence);
+
    snapshot_swapchain_frame(swapchain_data);
 
    if (!instance_data->params.no_display && swapchain_data->n_frames > 0) {
-      compute_swapchain_display(swapchain_data);
+      /* Draw what was built for the previous frame and build the display of
+       * this one while the application works on the next frame.
+       */
+      ImGui::SetCurrentContext(swapchain_data->imgui_context);
       draw = render_swapchain_display(swapchain_data, present_queue,
                                       wait_semaphores, n_wait_semaphores,
                                       imageIndex);
+      util_queue_add_job(&swapchain_data->display_queue, swapchain_data,
+                         &swapchain_data->display_fence,
+                         compute_swapchain_display_job, NULL, 0);
    }
 
    return draw;
@@ -1875,6 +2131,40 @@ static void overlay_DestroySwapchainKHR(
    destroy_swapchain_data(swapchain_data);
 }
 
+/* Adds the draw_timing intervals of a command buffer to the device stats,
+ * returns false if the results are not available yet.
+ */
+static bool read_draw_timing(struct command_buffer_data *cmd_buffer_data)
+{
+   struct device_data *device_data = cmd_buffer_data->device;
+   uint64_t timestamps[OVERLAY_DRAW_TIMING_INTERVALS * 2];
+   uint64_t mask = cmd_buffer_data->draw_timing_mask;
+
+   VkResult result =
+      device_data->vtable.GetQueryPoolResults(device_data->device,
+                                              cmd_buffer_data->draw_timing_query_pool,
+                                              cmd_buffer_data->query_index * OVERLAY_DRAW_TIMING_INTERVALS * 2,
+                                              cmd_buffer_data->draw_timing_intervals * 2,
+                                              sizeof(timestamps), timestamps, sizeof(uint64_t),
+                                              VK_QUERY_RESULT_64_BIT);
+   if (result == VK_NOT_READY)
+      return false;
+   VK_CHECK(result);
+
+   for (uint32_t i = 0; i < cmd_buffer_data->draw_timing_intervals; i++) {
+      uint64_t gpu_time =
+         ((timestamps[i * 2 + 1] - timestamps[i * 2]) & mask) *
+         device_data->properties.limits.timestampPeriod;
+      unsigned bucket = MIN2(util_last_bit64(gpu_time / 1000),
+                             OVERLAY_DRAW_TIMING_BUCKETS - 1);
+
+      device_data->draw_timing.gpu_time += gpu_time;
+      device_data->draw_timing.buckets[bucket]++;
+   }
+
+   return true;
+}
+
 static VkResult overlay_QueuePresentKHR(
     VkQueue                                     queue,
     const VkPresentInfoKHR*                     pPresentInfo)
@@ -1932,6 +2222,17 @@ static VkResult overlay_QueuePresentKHR(
       }
    }
 
+   /* Only read the draw_timing results of the command buffers which have
+    * completed, the others will be looked at on the next present.
+    */
+   simple_mtx_lock(&device_data->draw_timing_mtx);
+   list_for_each_entry_safe(struct command_buffer_data, cmd_buffer_data,
+                            &device_data->draw_timing_pending, draw_timing_link) {
+      if (read_draw_timing(cmd_buffer_data))
+         list_delinit(&cmd_buffer_data->draw_timing_link);
+   }
+   simple_mtx_unlock(&device_data->draw_timing_mtx);
+
    /* Otherwise we need to add our overlay drawing semaphore to the list of
     * semaphores to wait on. If we don't do that the presented picture might
     * be have incomplete overlay drawings.
@@ -1983,10 +2284,13 @@ static VkResult overlay_QueuePresentKHR(
          /* Because the submission of the overlay draw waits on the semaphores
           * handed for present, we don't need to have this present operation
           * wait on them as well, we can just wait on the overlay submission
-          * semaphore.
+          * semaphore.  There is nothing to draw until the display of the
+          * first frame has been built.
           */
-         present_info.pWaitSemaphores = &draw->semaphore;
-         present_info.waitSemaphoreCount = 1;
+         if (draw) {
+            present_info.pWaitSemaphores = &draw->semaphore;
+            present_info.waitSemaphoreCount = 1;
+         }
 
          uint64_t ts0 = os_time_get();
          VkResult chain_result = queue_data->device->vtable.QueuePresentKHR(queue, &present_info);
@@ -2043,6 +2347,57 @@ static VkResult overlay_AcquireNextImage2KHR(
    return result;
 }
 
+static void draw_timing_write(struct command_buffer_data *cmd_buffer_data,
+                              VkPipelineStageFlagBits stage, uint32_t query)
+{
+   struct device_data *device_data = cmd_buffer_data->device;
+   device_data->vtable.CmdWriteTimestamp(cmd_buffer_data->cmd_buffer, stage,
+                                         cmd_buffer_data->draw_timing_query_pool,
+                                         cmd_buffer_data->query_index * OVERLAY_DRAW_TIMING_INTERVALS * 2 +
+                                         cmd_buffer_data->draw_timing_intervals * 2 + query);
+}
+
+static void draw_timing_begin_interval(struct command_buffer_data *cmd_buffer_data)
+{
+   if (!cmd_buffer_data->draw_timing_query_pool ||
+       cmd_buffer_data->draw_timing_open ||
+       cmd_buffer_data->draw_timing_intervals == OVERLAY_DRAW_TIMING_INTERVALS)
+      return;
+
+   draw_timing_write(cmd_buffer_data, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+   cmd_buffer_data->draw_timing_open = true;
+   cmd_buffer_data->draw_timing_draws = 0;
+}
+
+static void draw_timing_end_interval(struct command_buffer_data *cmd_buffer_data)
+{
+   if (!cmd_buffer_data->draw_timing_open)
+      return;
+
+   draw_timing_write(cmd_buffer_data, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+   cmd_buffer_data->draw_timing_open = false;
+   cmd_buffer_data->draw_timing_intervals++;
+}
+
+/* Wrapped around each draw & dispatch, to time them in groups of
+ * draw_timing unless render passes are timed.
+ */
+static void draw_timing_before_draw(struct command_buffer_data *cmd_buffer_data)
+{
+   const struct overlay_params *params = &cmd_buffer_data->device->instance->params;
+   if (params->draw_timing != OVERLAY_DRAW_TIMING_RENDER_PASS)
+      draw_timing_begin_interval(cmd_buffer_data);
+}
+
+static void draw_timing_after_draw(struct command_buffer_data *cmd_buffer_data)
+{
+   const struct overlay_params *params = &cmd_buffer_data->device->instance->params;
+   if (cmd_buffer_data->draw_timing_open &&
+       params->draw_timing != OVERLAY_DRAW_TIMING_RENDER_PASS &&
+       ++cmd_buffer_data->draw_timing_draws >= params->draw_timing)
+      draw_timing_end_interval(cmd_buffer_data);
+}
+
 static void overlay_CmdDraw(
     VkCommandBuffer                             commandBuffer,
     uint32_t                                    vertexCount,
@@ -2054,8 +2409,10 @@ static void overlay_CmdDraw(
       FIND(struct command_buffer_data, commandBuffer);
    cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_draw]++;
    struct device_data *device_data = cmd_buffer_data->device;
+   draw_timing_before_draw(cmd_buffer_data);
    device_data->vtable.CmdDraw(commandBuffer, vertexCount, instanceCount,
                                firstVertex, firstInstance);
+   draw_timing_after_draw(cmd_buffer_data);
 }
 
 static void overlay_CmdDrawIndexed(
@@ -2070,8 +2427,10 @@ static void overlay_CmdDrawIndexed(
       FIND(struct command_buffer_data, commandBuffer);
    cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_draw_indexed]++;
    struct device_data *device_data = cmd_buffer_data->device;
+   draw_timing_before_draw(cmd_buffer_data);
    device_data->vtable.CmdDrawIndexed(commandBuffer, indexCount, instanceCount,
                                       firstIndex, vertexOffset, firstInstance);
+   draw_timing_after_draw(cmd_buffer_data);
 }
 
 static void overlay_CmdDrawIndirect(
@@ -2085,7 +2444,9 @@ static void overlay_CmdDrawIndirect(
       FIND(struct command_buffer_data, commandBuffer);
    cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_draw_indirect]++;
    struct device_data *device_data = cmd_buffer_data->device;
+   draw_timing_before_draw(cmd_buffer_data);
    device_data->vtable.CmdDrawIndirect(commandBuffer, buffer, offset, drawCount, stride);
+   draw_timing_after_draw(cmd_buffer_data);
 }
 
 static void overlay_CmdDrawIndexedIndirect(
@@ -2099,7 +2460,9 @@ static void overlay_CmdDrawIndexedIndirect(
       FIND(struct command_buffer_data, commandBuffer);
    cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_draw_indexed_indirect]++;
    struct device_data *device_data = cmd_buffer_data->device;
+   draw_timing_before_draw(cmd_buffer_data);
    device_data->vtable.CmdDrawIndexedIndirect(commandBuffer, buffer, offset, drawCount, stride);
+   draw_timing_after_draw(cmd_buffer_data);
 }
 
 static void overlay_CmdDrawIndirectCount(
@@ -2115,9 +2478,11 @@ static void overlay_CmdDrawIndirectCount(
       FIND(struct command_buffer_data, commandBuffer);
    cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_draw_indirect_count]++;
    struct device_data *device_data = cmd_buffer_data->device;
+   draw_timing_before_draw(cmd_buffer_data);
    device_data->vtable.CmdDrawIndirectCount(commandBuffer, buffer, offset,
                                             countBuffer, countBufferOffset,
                                             maxDrawCount, stride);
+   draw_timing_after_draw(cmd_buffer_data);
 }
 
 static void overlay_CmdDrawIndexedIndirectCount(
@@ -2133,9 +2498,11 @@ static void overlay_CmdDrawIndexedIndirectCount(
       FIND(struct command_buffer_data, commandBuffer);
    cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_draw_indexed_indirect_count]++;
    struct device_data *device_data = cmd_buffer_data->device;
+   draw_timing_before_draw(cmd_buffer_data);
    device_data->vtable.CmdDrawIndexedIndirectCount(commandBuffer, buffer, offset,
                                                    countBuffer, countBufferOffset,
                                                    maxDrawCount, stride);
+   draw_timing_after_draw(cmd_buffer_data);
 }
 
 static void overlay_CmdDispatch(
@@ -2148,7 +2515,9 @@ static void overlay_CmdDispatch(
       FIND(struct command_buffer_data, commandBuffer);
    cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_dispatch]++;
    struct device_data *device_data = cmd_buffer_data->device;
+   draw_timing_before_draw(cmd_buffer_data);
    device_data->vtable.CmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+   draw_timing_after_draw(cmd_buffer_data);
 }
 
 static void overlay_CmdDispatchIndirect(
@@ -2160,7 +2529,59 @@ static void overlay_CmdDispatchIndirect(
       FIND(struct command_buffer_data, commandBuffer);
    cmd_buffer_data->stats.stats[OVERLAY_PARAM_ENABLED_dispatch_indirect]++;
    struct device_data *device_data = cmd_buffer_data->device;
+   draw_timing_before_draw(cmd_buffer_data);
    device_data->vtable.CmdDispatchIndirect(commandBuffer, buffer, offset);
+   draw_timing_after_draw(cmd_buffer_data);
+}
+
+static void overlay_CmdBeginRenderPass(
+    VkCommandBuffer                             commandBuffer,
+    const VkRenderPassBeginInfo*                pRenderPassBegin,
+    VkSubpassContents                           contents)
+{
+   struct command_buffer_data *cmd_buffer_data =
+      FIND(struct command_buffer_data, commandBuffer);
+   struct device_data *device_data = cmd_buffer_data->device;
+   if (device_data->instance->params.draw_timing == OVERLAY_DRAW_TIMING_RENDER_PASS)
+      draw_timing_begin_interval(cmd_buffer_data);
+   device_data->vtable.CmdBeginRenderPass(commandBuffer, pRenderPassBegin, contents);
+}
+
+static void overlay_CmdBeginRenderPass2(
+    VkCommandBuffer                             commandBuffer,
+    const VkRenderPassBeginInfo*                pRenderPassBegin,
+    const VkSubpassBeginInfo*                   pSubpassBeginInfo)
+{
+   struct command_buffer_data *cmd_buffer_data =
+      FIND(struct command_buffer_data, commandBuffer);
+   struct device_data *device_data = cmd_buffer_data->device;
+   if (device_data->instance->params.draw_timing == OVERLAY_DRAW_TIMING_RENDER_PASS)
+      draw_timing_begin_interval(cmd_buffer_data);
+   device_data->vtable.CmdBeginRenderPass2(commandBuffer, pRenderPassBegin,
+                                           pSubpassBeginInfo);
+}
+
+static void overlay_CmdEndRenderPass(
+    VkCommandBuffer                             commandBuffer)
+{
+   struct command_buffer_data *cmd_buffer_data =
+      FIND(struct command_buffer_data, commandBuffer);
+   struct device_data *device_data = cmd_buffer_data->device;
+   device_data->vtable.CmdEndRenderPass(commandBuffer);
+   if (device_data->instance->params.draw_timing == OVERLAY_DRAW_TIMING_RENDER_PASS)
+      draw_timing_end_interval(cmd_buffer_data);
+}
+
+static void overlay_CmdEndRenderPass2(
+    VkCommandBuffer                             commandBuffer,
+    const VkSubpassEndInfo*                     pSubpassEndInfo)
+{
+   struct command_buffer_data *cmd_buffer_data =
+      FIND(struct command_buffer_data, commandBuffer);
+   struct device_data *device_data = cmd_buffer_data->device;
+   device_data->vtable.CmdEndRenderPass2(commandBuffer, pSubpassEndInfo);
+   if (device_data->instance->params.draw_timing == OVERLAY_DRAW_TIMING_RENDER_PASS)
+      draw_timing_end_interval(cmd_buffer_data);
 }
 
 static void overlay_CmdBindPipeline(
@@ -2235,6 +2656,24 @@ static VkResult overlay_BeginCommandBuffer(
                                                cmd_buffer_data->pipeline_query_pool,
                                                cmd_buffer_data->query_index, 1);
       }
+      if (cmd_buffer_data->draw_timing_query_pool) {
+         /* The application waited for the previous recording to complete,
+          * read its results if we haven't already.
+          */
+         simple_mtx_lock(&device_data->draw_timing_mtx);
+         if (!list_is_empty(&cmd_buffer_data->draw_timing_link)) {
+            read_draw_timing(cmd_buffer_data);
+            list_delinit(&cmd_buffer_data->draw_timing_link);
+         }
+         simple_mtx_unlock(&device_data->draw_timing_mtx);
+
+         device_data->vtable.CmdResetQueryPool(commandBuffer,
+                                               cmd_buffer_data->draw_timing_query_pool,
+                                               cmd_buffer_data->query_index * OVERLAY_DRAW_TIMING_INTERVALS * 2,
+                                               OVERLAY_DRAW_TIMING_INTERVALS * 2);
+         cmd_buffer_data->draw_timing_intervals = 0;
+         cmd_buffer_data->draw_timing_open = false;
+      }
       if (cmd_buffer_data->timestamp_query_pool) {
          device_data->vtable.CmdResetQueryPool(commandBuffer,
                                                cmd_buffer_data->timestamp_query_pool,
@@ -2263,6 +2702,7 @@ static VkResult overlay_EndCommandBuffer(
       FIND(struct command_buffer_data, commandBuffer);
    struct device_data *device_data = cmd_buffer_data->device;
 
+   draw_timing_end_interval(cmd_buffer_data);
    if (cmd_buffer_data->timestamp_query_pool) {
       device_data->vtable.CmdWriteTimestamp(commandBuffer,
                                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
@@ -2351,20 +2791,51 @@ static VkResult overlay_AllocateCommandBuffers(
                                                    NULL, &timestamp_query_pool));
    }
 
+   VkQueryPool draw_timing_query_pool = VK_NULL_HANDLE;
+   if (device_data->instance->params.draw_timing &&
+       pAllocateInfo->level == VK_COMMAND_BUFFER_LEVEL_PRIMARY) {
+      VkQueryPoolCreateInfo pool_info = {
+         VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+         NULL,
+         0,
+         VK_QUERY_TYPE_TIMESTAMP,
+         pAllocateInfo->commandBufferCount * OVERLAY_DRAW_TIMING_INTERVALS * 2,
+         0,
+      };
+      VK_CHECK(device_data->vtable.CreateQueryPool(device_data->device, &pool_info,
+                                                   NULL, &draw_timing_query_pool));
+   }
+
    for (uint32_t i = 0; i < pAllocateInfo->commandBufferCount; i++) {
       new_command_buffer_data(pCommandBuffers[i], pAllocateInfo->level,
                               pipeline_query_pool, timestamp_query_pool,
-                              i, device_data);
+                              draw_timing_query_pool, i, device_data);
    }
 
    if (pipeline_query_pool)
       map_object(HKEY(pipeline_query_pool), (void *)(uintptr_t) pAllocateInfo->commandBufferCount);
    if (timestamp_query_pool)
       map_object(HKEY(timestamp_query_pool), (void *)(uintptr_t) pAllocateInfo->commandBufferCount);
+   if (draw_timing_query_pool)
+      map_object(HKEY(draw_timing_query_pool), (void *)(uintptr_t) pAllocateInfo->commandBufferCount);
 
    return result;
 }
 
+/* Query pools are shared by the command buffers allocated together, and
+ * destroyed along the last one.
+ */
+static void unref_query_pool(struct device_data *device_data, VkQueryPool pool)
+{
+   uint64_t count = (uintptr_t)find_object_data(HKEY(pool));
+   if (count == 1) {
+      unmap_object(HKEY(pool));
+      device_data->vtable.DestroyQueryPool(device_data->device, pool, NULL);
+   } else if (count != 0) {
+      map_object(HKEY(pool), (void *)(uintptr_t)(count - 1));
+   }
+}
+
 static void overlay_FreeCommandBuffers(
    VkDevice               device,
    VkCommandPool          commandPool,
@@ -2380,23 +2851,13 @@ static void overlay_FreeCommandBuffers(
       if (!cmd_buffer_data)
          continue;
 
-      uint64_t count = (uintptr_t)find_object_data(HKEY(cmd_buffer_data->pipeline_query_pool));
-      if (count == 1) {
-         unmap_object(HKEY(cmd_buffer_data->pipeline_query_pool));
-         device_data->vtable.DestroyQueryPool(device_data->device,
-                                              cmd_buffer_data->pipeline_query_pool, NULL);
-      } else if (count != 0) {
-         map_object(HKEY(cmd_buffer_data->pipeline_query_pool), (void *)(uintptr_t)(count - 1));
-      }
-      count = (uintptr_t)find_object_data(HKEY(cmd_buffer_data->timestamp_query_pool));
-      if (count == 1) {
-         unmap_object(HKEY(cmd_buffer_data->timestamp_query_pool));
-         device_data->vtable.DestroyQueryPool(device_data->device,
-                                              cmd_buffer_data->timestamp_query_pool, NULL);
-      } else if (count != 0) {
-         map_object(HKEY(cmd_buffer_data->timestamp_query_pool), (void *)(uintptr_t)(count - 1));
-      }
+      unref_query_pool(device_data, cmd_buffer_data->pipeline_query_pool);
+      unref_query_pool(device_data, cmd_buffer_data->timestamp_query_pool);
+      unref_query_pool(device_data, cmd_buffer_data->draw_timing_query_pool);
+
+      simple_mtx_lock(&device_data->draw_timing_mtx);
       destroy_command_buffer_data(cmd_buffer_data);
+      simple_mtx_unlock(&device_data->draw_timing_mtx);
    }
 
    device_data->vtable.FreeCommandBuffers(device, commandPool,
@@ -2423,6 +2884,19 @@ static VkResult overlay_QueueSubmit(
          for (uint32_t st = 0; st < OVERLAY_PARAM_ENABLED_MAX; st++)
             device_data->frame_stats.stats[st] += cmd_buffer_data->stats.stats[st];
 
+         /* The draw_timing results are read once available, at any later
+          * QueuePresent().
+          */
+         if (cmd_buffer_data->draw_timing_intervals > 0) {
+            cmd_buffer_data->draw_timing_mask = queue_data->timestamp_mask;
+            simple_mtx_lock(&device_data->draw_timing_mtx);
+            if (list_is_empty(&cmd_buffer_data->draw_timing_link)) {
+               list_addtail(&cmd_buffer_data->draw_timing_link,
+                            &device_data->draw_timing_pending);
+            }
+            simple_mtx_unlock(&device_data->draw_timing_mtx);
+         }
+
          /* Attach the command buffer to the queue so we remember to read its
           * pipeline statistics & timestamps at QueuePresent().
           */
@@ -2590,6 +3064,13 @@ static const struct {
    ADD_HOOK(CmdDrawIndexedIndirectCount),
    ADD_ALIAS_HOOK(CmdDrawIndexedIndirectCountKHR, CmdDrawIndexedIndirectCount),
 
+   ADD_HOOK(CmdBeginRenderPass),
+   ADD_HOOK(CmdBeginRenderPass2),
+   ADD_ALIAS_HOOK(CmdBeginRenderPass2KHR, CmdBeginRenderPass2),
+   ADD_HOOK(CmdEndRenderPass),
+   ADD_HOOK(CmdEndRenderPass2),
+   ADD_ALIAS_HOOK(CmdEndRenderPass2KHR, CmdEndRenderPass2),
+
    ADD_HOOK(CmdBindPipeline),
 
    ADD_HOOK(CreateSwapchainKHR),
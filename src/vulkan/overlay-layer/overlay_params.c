@@ -87,6 +87,14 @@ parse_unsigned(const char *str)
 #define parse_width(s) parse_unsigned(s)
 #define parse_height(s) parse_unsigned(s)
 
+static unsigned
+parse_draw_timing(const char *str)
+{
+   if (!strcmp(str, "render_pass"))
+      return OVERLAY_DRAW_TIMING_RENDER_PASS;
+   return parse_unsigned(str);
+}
+
 static bool
 parse_help(const char *str)
 {
@@ -103,6 +111,7 @@ parse_help(const char *str)
    fprintf(stderr, "\toutput_file=/path/to/output.txt\n");
    fprintf(stderr, "\twidth=width-in-pixels\n");
    fprintf(stderr, "\theight=height-in-pixels\n");
+   fprintf(stderr, "\tdraw_timing=number-of-draws|render_pass\n");
 
    return true;
 }
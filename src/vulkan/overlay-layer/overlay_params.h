@@ -70,6 +70,7 @@ extern "C" {
    OVERLAY_PARAM_CUSTOM(height)                      \
    OVERLAY_PARAM_CUSTOM(no_display)                  \
    OVERLAY_PARAM_CUSTOM(control)                     \
+   OVERLAY_PARAM_CUSTOM(draw_timing)                 \
    OVERLAY_PARAM_CUSTOM(help)
 
 enum overlay_param_position {
@@ -79,6 +80,9 @@ enum overlay_param_position {
    LAYER_POSITION_BOTTOM_RIGHT,
 };
 
+/* draw_timing value timing each render pass rather than groups of draws */
+#define OVERLAY_DRAW_TIMING_RENDER_PASS UINT32_MAX
+
 enum overlay_param_enabled {
 #define OVERLAY_PARAM_BOOL(name) OVERLAY_PARAM_ENABLED_##name,
 #define OVERLAY_PARAM_CUSTOM(name)
@@ -98,6 +102,7 @@ struct overlay_params {
    bool no_display;
    unsigned width;
    unsigned height;
+   unsigned draw_timing;
 };
 
 const extern char *overlay_param_names[];
@@ -0,0 +1,942 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Serialization of the create infos of pipelines and of the objects they
+ * depend on.  Each writer has its reader right after it, both have to be
+ * kept in sync.
+ *
+ * Only what affects the compiled shaders is recorded, most extension
+ * structs are dropped.  Pointers never make it into the records, so that
+ * identical create infos hash to the same id.
+ */
+
+#include <stddef.h>
+
+#include "pipeline_capture.h"
+
+#include "util/macros.h"
+#include "util/mesa-sha1.h"
+#include "util/ralloc.h"
+#include "vk_util.h"
+
+uint64_t
+pipeline_capture_record_id(enum pipeline_capture_type type,
+                           uint64_t device_id,
+                           const void *data, size_t size)
+{
+   struct mesa_sha1 ctx;
+   unsigned char sha1[20];
+   uint32_t type32 = type;
+   uint64_t id;
+
+   _mesa_sha1_init(&ctx);
+   _mesa_sha1_update(&ctx, &type32, sizeof(type32));
+   _mesa_sha1_update(&ctx, &device_id, sizeof(device_id));
+   _mesa_sha1_update(&ctx, data, size);
+   _mesa_sha1_final(&ctx, sha1);
+
+   memcpy(&id, sha1, sizeof(id));
+
+   /* 0 means unknown object. */
+   return id ? id : 1;
+}
+
+/* Structs made of nothing but plain values after sType and pNext are
+ * written in one go, starting at their flags.
+ */
+#define WRITE_TAIL(blob, type, s) \
+   blob_write_bytes(blob, &(s)->flags, sizeof(type) - offsetof(type, flags))
+
+#define READ_TAIL(blob, type, s) \
+   blob_copy_bytes(blob, &(s)->flags, sizeof(type) - offsetof(type, flags))
+
+static void
+write_array(struct blob *blob, uint32_t count, const void *data,
+            size_t elem_size)
+{
+   blob_write_uint32(blob, count);
+   if (count)
+      blob_write_bytes(blob, data, count * elem_size);
+}
+
+static void *
+read_array(void *mem_ctx, struct blob_reader *blob, uint32_t *count,
+           size_t elem_size)
+{
+   *count = blob_read_uint32(blob);
+   if (*count == 0 || blob->overrun)
+      return NULL;
+
+   if (blob->end - blob->current < (ptrdiff_t)(*count * elem_size)) {
+      blob->overrun = true;
+      return NULL;
+   }
+
+   void *data = ralloc_size(mem_ctx, *count * elem_size);
+   if (data)
+      blob_copy_bytes(blob, data, *count * elem_size);
+   else
+      blob->overrun = true;
+
+   return data;
+}
+
+static bool
+write_handle(struct blob *blob, enum pipeline_capture_type type,
+             const void *handle, pipeline_capture_lookup_cb lookup,
+             void *data)
+{
+   uint64_t id = lookup(data, type, pipeline_capture_handle_to_u64(handle));
+   if (id == 0)
+      return false;
+
+   blob_write_uint64(blob, id);
+   return true;
+}
+
+static bool
+read_handle(struct blob_reader *blob, enum pipeline_capture_type type,
+            void *handle, pipeline_capture_lookup_cb lookup, void *data)
+{
+   uint64_t value = lookup(data, type, blob_read_uint64(blob));
+   if (value == 0 || blob->overrun)
+      return false;
+
+   memcpy(handle, &value, sizeof(value));
+   return true;
+}
+
+bool
+pipeline_capture_write_device(struct blob *blob,
+                              const VkDeviceCreateInfo *info)
+{
+   const VkPhysicalDeviceFeatures2 *features2 =
+      vk_find_struct_const(info->pNext, PHYSICAL_DEVICE_FEATURES_2);
+   const VkPhysicalDeviceFeatures *features =
+      features2 ? &features2->features : info->pEnabledFeatures;
+
+   blob_write_uint32(blob, info->enabledExtensionCount);
+   for (uint32_t i = 0; i < info->enabledExtensionCount; i++)
+      blob_write_string(blob, info->ppEnabledExtensionNames[i]);
+
+   blob_write_uint32(blob, features != NULL);
+   if (features)
+      blob_write_bytes(blob, features, sizeof(*features));
+
+   return !blob->out_of_memory;
+}
+
+VkDeviceCreateInfo *
+pipeline_capture_read_device(void *mem_ctx, struct blob_reader *blob)
+{
+   VkDeviceCreateInfo *info = rzalloc(mem_ctx, VkDeviceCreateInfo);
+   if (!info)
+      return NULL;
+
+   info->sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+
+   info->enabledExtensionCount = blob_read_uint32(blob);
+   if (blob->overrun)
+      return NULL;
+
+   if (info->enabledExtensionCount) {
+      const char **names = ralloc_array(info, const char *,
+                                        info->enabledExtensionCount);
+      if (!names)
+         return NULL;
+
+      for (uint32_t i = 0; i < info->enabledExtensionCount; i++) {
+         const char *name = blob_read_string(blob);
+         if (!name)
+            return NULL;
+         names[i] = ralloc_strdup(names, name);
+      }
+      info->ppEnabledExtensionNames = names;
+   }
+
+   if (blob_read_uint32(blob)) {
+      VkPhysicalDeviceFeatures *features =
+         ralloc(info, VkPhysicalDeviceFeatures);
+      if (!features)
+         return NULL;
+      blob_copy_bytes(blob, features, sizeof(*features));
+      info->pEnabledFeatures = features;
+   }
+
+   return blob->overrun ? NULL : info;
+}
+
+bool
+pipeline_capture_write_shader_module(struct blob *blob,
+                                     const VkShaderModuleCreateInfo *info)
+{
+   blob_write_uint32(blob, info->flags);
+   blob_write_uint64(blob, info->codeSize);
+   blob_write_bytes(blob, info->pCode, info->codeSize);
+
+   return !blob->out_of_memory;
+}
+
+VkShaderModuleCreateInfo *
+pipeline_capture_read_shader_module(void *mem_ctx, struct blob_reader *blob)
+{
+   VkShaderModuleCreateInfo *info = rzalloc(mem_ctx, VkShaderModuleCreateInfo);
+   if (!info)
+      return NULL;
+
+   info->sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+   info->flags = blob_read_uint32(blob);
+   info->codeSize = blob_read_uint64(blob);
+   if (blob->overrun ||
+       blob->end - blob->current < (ptrdiff_t)info->codeSize)
+      return NULL;
+
+   /* The code has to be 32-bit aligned. */
+   uint32_t *code = ralloc_array(info, uint32_t, DIV_ROUND_UP(info->codeSize, 4));
+   if (!code)
+      return NULL;
+   blob_copy_bytes(blob, code, info->codeSize);
+   info->pCode = code;
+
+   return blob->overrun ? NULL : info;
+}
+
+bool
+pipeline_capture_write_sampler(struct blob *blob,
+                               const VkSamplerCreateInfo *info)
+{
+   /* The conversion objects aren't captured. */
+   if (vk_find_struct_const(info->pNext, SAMPLER_YCBCR_CONVERSION_INFO))
+      return false;
+
+   WRITE_TAIL(blob, VkSamplerCreateInfo, info);
+
+   return !blob->out_of_memory;
+}
+
+VkSamplerCreateInfo *
+pipeline_capture_read_sampler(void *mem_ctx, struct blob_reader *blob)
+{
+   VkSamplerCreateInfo *info = rzalloc(mem_ctx, VkSamplerCreateInfo);
+   if (!info)
+      return NULL;
+
+   info->sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+   READ_TAIL(blob, VkSamplerCreateInfo, info);
+
+   return blob->overrun ? NULL : info;
+}
+
+static bool
+has_immutable_samplers(const VkDescriptorSetLayoutBinding *binding)
+{
+   return binding->pImmutableSamplers &&
+          (binding->descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+           binding->descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+}
+
+bool
+pipeline_capture_write_descriptor_set_layout(struct blob *blob,
+                                             const VkDescriptorSetLayoutCreateInfo *info,
+                                             pipeline_capture_lookup_cb lookup,
+                                             void *data)
+{
+   const VkDescriptorSetLayoutBindingFlagsCreateInfo *binding_flags =
+      vk_find_struct_const(info->pNext,
+                           DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO);
+
+   blob_write_uint32(blob, info->flags);
+
+   if (binding_flags) {
+      write_array(blob, binding_flags->bindingCount,
+                  binding_flags->pBindingFlags,
+                  sizeof(*binding_flags->pBindingFlags));
+   } else {
+      write_array(blob, 0, NULL, 0);
+   }
+
+   blob_write_uint32(blob, info->bindingCount);
+   for (uint32_t i = 0; i < info->bindingCount; i++) {
+      const VkDescriptorSetLayoutBinding *binding = &info->pBindings[i];
+
+      blob_write_uint32(blob, binding->binding);
+      blob_write_uint32(blob, binding->descriptorType);
+      blob_write_uint32(blob, binding->descriptorCount);
+      blob_write_uint32(blob, binding->stageFlags);
+
+      blob_write_uint32(blob, has_immutable_samplers(binding));
+      if (!has_immutable_samplers(binding))
+         continue;
+
+      for (uint32_t s = 0; s < binding->descriptorCount; s++) {
+         if (!write_handle(blob, PIPELINE_CAPTURE_SAMPLER,
+                           &binding->pImmutableSamplers[s], lookup, data))
+            return false;
+      }
+   }
+
+   return !blob->out_of_memory;
+}
+
+VkDescriptorSetLayoutCreateInfo *
+pipeline_capture_read_descriptor_set_layout(void *mem_ctx,
+                                            struct blob_reader *blob,
+                                            pipeline_capture_lookup_cb lookup,
+                                            void *data)
+{
+   VkDescriptorSetLayoutCreateInfo *info =
+      rzalloc(mem_ctx, VkDescriptorSetLayoutCreateInfo);
+   if (!info)
+      return NULL;
+
+   info->sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+   info->flags = blob_read_uint32(blob);
+
+   uint32_t flag_count;
+   VkDescriptorBindingFlags *flags =
+      read_array(info, blob, &flag_count, sizeof(*flags));
+   if (flag_count) {
+      VkDescriptorSetLayoutBindingFlagsCreateInfo *binding_flags =
+         rzalloc(info, VkDescriptorSetLayoutBindingFlagsCreateInfo);
+      if (!binding_flags || !flags)
+         return NULL;
+
+      binding_flags->sType =
+         VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+      binding_flags->bindingCount = flag_count;
+      binding_flags->pBindingFlags = flags;
+      info->pNext = binding_flags;
+   }
+
+   info->bindingCount = blob_read_uint32(blob);
+   if (blob->overrun)
+      return NULL;
+
+   if (info->bindingCount) {
+      VkDescriptorSetLayoutBinding *bindings =
+         rzalloc_array(info, VkDescriptorSetLayoutBinding, info->bindingCount);
+      if (!bindings)
+         return NULL;
+
+      for (uint32_t i = 0; i < info->bindingCount; i++) {
+         VkDescriptorSetLayoutBinding *binding = &bindings[i];
+
+         binding->binding = blob_read_uint32(blob);
+         binding->descriptorType = blob_read_uint32(blob);
+         binding->descriptorCount = blob_read_uint32(blob);
+         binding->stageFlags = blob_read_uint32(blob);
+
+         if (!blob_read_uint32(blob))
+            continue;
+
+         if (blob->overrun)
+            return NULL;
+
+         VkSampler *samplers =
+            ralloc_array(bindings, VkSampler, binding->descriptorCount);
+         if (!samplers)
+            return NULL;
+
+         for (uint32_t s = 0; s < binding->descriptorCount; s++) {
+            if (!read_handle(blob, PIPELINE_CAPTURE_SAMPLER, &samplers[s],
+                             lookup, data))
+               return NULL;
+         }
+         binding->pImmutableSamplers = samplers;
+      }
+      info->pBindings = bindings;
+   }
+
+   return blob->overrun ? NULL : info;
+}
+
+bool
+pipeline_capture_write_pipeline_layout(struct blob *blob,
+                                       const VkPipelineLayoutCreateInfo *info,
+                                       pipeline_capture_lookup_cb lookup,
+                                       void *data)
+{
+   blob_write_uint32(blob, info->flags);
+
+   blob_write_uint32(blob, info->setLayoutCount);
+   for (uint32_t i = 0; i < info->setLayoutCount; i++) {
+      if (!write_handle(blob, PIPELINE_CAPTURE_DESCRIPTOR_SET_LAYOUT,
+                        &info->pSetLayouts[i], lookup, data))
+         return false;
+   }
+
+   write_array(blob, info->pushConstantRangeCount, info->pPushConstantRanges,
+               sizeof(*info->pPushConstantRanges));
+
+   return !blob->out_of_memory;
+}
+
+VkPipelineLayoutCreateInfo *
+pipeline_capture_read_pipeline_layout(void *mem_ctx,
+                                      struct blob_reader *blob,
+                                      pipeline_capture_lookup_cb lookup,
+                                      void *data)
+{
+   VkPipelineLayoutCreateInfo *info =
+      rzalloc(mem_ctx, VkPipelineLayoutCreateInfo);
+   if (!info)
+      return NULL;
+
+   info->sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+   info->flags = blob_read_uint32(blob);
+
+   info->setLayoutCount = blob_read_uint32(blob);
+   if (blob->overrun)
+      return NULL;
+
+   if (info->setLayoutCount) {
+      VkDescriptorSetLayout *layouts =
+         ralloc_array(info, VkDescriptorSetLayout, info->setLayoutCount);
+      if (!layouts)
+         return NULL;
+
+      for (uint32_t i = 0; i < info->setLayoutCount; i++) {
+         if (!read_handle(blob, PIPELINE_CAPTURE_DESCRIPTOR_SET_LAYOUT,
+                          &layouts[i], lookup, data))
+            return NULL;
+      }
+      info->pSetLayouts = layouts;
+   }
+
+   info->pPushConstantRanges =
+      read_array(info, blob, &info->pushConstantRangeCount,
+                 sizeof(*info->pPushConstantRanges));
+
+   return blob->overrun ? NULL : info;
+}
+
+bool
+pipeline_capture_write_render_pass(struct blob *blob,
+                                   const VkRenderPassCreateInfo *info)
+{
+   const VkRenderPassMultiviewCreateInfo *multiview =
+      vk_find_struct_const(info->pNext, RENDER_PASS_MULTIVIEW_CREATE_INFO);
+
+   blob_write_uint32(blob, info->flags);
+
+   write_array(blob, info->attachmentCount, info->pAttachments,
+               sizeof(*info->pAttachments));
+
+   blob_write_uint32(blob, info->subpassCount);
+   for (uint32_t i = 0; i < info->subpassCount; i++) {
+      const VkSubpassDescription *subpass = &info->pSubpasses[i];
+
+      blob_write_uint32(blob, subpass->flags);
+      blob_write_uint32(blob, subpass->pipelineBindPoint);
+      write_array(blob, subpass->inputAttachmentCount,
+                  subpass->pInputAttachments,
+                  sizeof(*subpass->pInputAttachments));
+      write_array(blob, subpass->colorAttachmentCount,
+                  subpass->pColorAttachments,
+                  sizeof(*subpass->pColorAttachments));
+      if (subpass->pResolveAttachments) {
+         write_array(blob, subpass->colorAttachmentCount,
+                     subpass->pResolveAttachments,
+                     sizeof(*subpass->pResolveAttachments));
+      } else {
+         write_array(blob, 0, NULL, 0);
+      }
+      write_array(blob, subpass->pDepthStencilAttachment != NULL,
+                  subpass->pDepthStencilAttachment,
+                  sizeof(*subpass->pDepthStencilAttachment));
+      write_array(blob, subpass->preserveAttachmentCount,
+                  subpass->pPreserveAttachments,
+                  sizeof(*subpass->pPreserveAttachments));
+   }
+
+   write_array(blob, info->dependencyCount, info->pDependencies,
+               sizeof(*info->pDependencies));
+
+   blob_write_uint32(blob, multiview != NULL);
+   if (multiview) {
+      write_array(blob, multiview->subpassCount, multiview->pViewMasks,
+                  sizeof(*multiview->pViewMasks));
+      write_array(blob, multiview->dependencyCount, multiview->pViewOffsets,
+                  sizeof(*multiview->pViewOffsets));
+      write_array(blob, multiview->correlationMaskCount,
+                  multiview->pCorrelationMasks,
+                  sizeof(*multiview->pCorrelationMasks));
+   }
+
+   return !blob->out_of_memory;
+}
+
+VkRenderPassCreateInfo *
+pipeline_capture_read_render_pass(void *mem_ctx, struct blob_reader *blob)
+{
+   VkRenderPassCreateInfo *info = rzalloc(mem_ctx, VkRenderPassCreateInfo);
+   if (!info)
+      return NULL;
+
+   info->sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+   info->flags = blob_read_uint32(blob);
+
+   info->pAttachments = read_array(info, blob, &info->attachmentCount,
+                                   sizeof(*info->pAttachments));
+
+   info->subpassCount = blob_read_uint32(blob);
+   if (blob->overrun)
+      return NULL;
+
+   if (info->subpassCount) {
+      VkSubpassDescription *subpasses =
+         rzalloc_array(info, VkSubpassDescription, info->subpassCount);
+      if (!subpasses)
+         return NULL;
+
+      for (uint32_t i = 0; i < info->subpassCount; i++) {
+         VkSubpassDescription *subpass = &subpasses[i];
+         uint32_t count;
+
+         subpass->flags = blob_read_uint32(blob);
+         subpass->pipelineBindPoint = blob_read_uint32(blob);
+         subpass->pInputAttachments =
+            read_array(subpasses, blob, &subpass->inputAttachmentCount,
+                       sizeof(*subpass->pInputAttachments));
+         subpass->pColorAttachments =
+            read_array(subpasses, blob, &subpass->colorAttachmentCount,
+                       sizeof(*subpass->pColorAttachments));
+         subpass->pResolveAttachments =
+            read_array(subpasses, blob, &count,
+                       sizeof(*subpass->pResolveAttachments));
+         subpass->pDepthStencilAttachment =
+            read_array(subpasses, blob, &count,
+                       sizeof(*subpass->pDepthStencilAttachment));
+         subpass->pPreserveAttachments =
+            read_array(subpasses, blob, &subpass->preserveAttachmentCount,
+                       sizeof(*subpass->pPreserveAttachments));
+      }
+      info->pSubpasses = subpasses;
+   }
+
+   info->pDependencies = read_array(info, blob, &info->dependencyCount,
+                                    sizeof(*info->pDependencies));
+
+   if (blob_read_uint32(blob)) {
+      VkRenderPassMultiviewCreateInfo *multiview =
+         rzalloc(info, VkRenderPassMultiviewCreateInfo);
+      if (!multiview)
+         return NULL;
+
+      multiview->sType = VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO;
+      multiview->pViewMasks =
+         read_array(multiview, blob, &multiview->subpassCount,
+                    sizeof(*multiview->pViewMasks));
+      multiview->pViewOffsets =
+         read_array(multiview, blob, &multiview->dependencyCount,
+                    sizeof(*multiview->pViewOffsets));
+      multiview->pCorrelationMasks =
+         read_array(multiview, blob, &multiview->correlationMaskCount,
+                    sizeof(*multiview->pCorrelationMasks));
+      info->pNext = multiview;
+   }
+
+   return blob->overrun ? NULL : info;
+}
+
+static bool
+write_shader_stage(struct blob *blob,
+                   const VkPipelineShaderStageCreateInfo *stage,
+                   pipeline_capture_lookup_cb lookup, void *data)
+{
+   const VkSpecializationInfo *spec = stage->pSpecializationInfo;
+
+   blob_write_uint32(blob, stage->flags);
+   blob_write_uint32(blob, stage->stage);
+   if (!write_handle(blob, PIPELINE_CAPTURE_SHADER_MODULE, &stage->module,
+                     lookup, data))
+      return false;
+   blob_write_string(blob, stage->pName);
+
+   blob_write_uint32(blob, spec != NULL);
+   if (spec) {
+      write_array(blob, spec->mapEntryCount, spec->pMapEntries,
+                  sizeof(*spec->pMapEntries));
+      blob_write_uint64(blob, spec->dataSize);
+      blob_write_bytes(blob, spec->pData, spec->dataSize);
+   }
+
+   return true;
+}
+
+static bool
+read_shader_stage(void *mem_ctx, struct blob_reader *blob,
+                  VkPipelineShaderStageCreateInfo *stage,
+                  pipeline_capture_lookup_cb lookup, void *data)
+{
+   stage->sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+   stage->flags = blob_read_uint32(blob);
+   stage->stage = blob_read_uint32(blob);
+   if (!read_handle(blob, PIPELINE_CAPTURE_SHADER_MODULE, &stage->module,
+                    lookup, data))
+      return false;
+
+   const char *name = blob_read_string(blob);
+   if (!name)
+      return false;
+   stage->pName = ralloc_strdup(mem_ctx, name);
+
+   if (blob_read_uint32(blob)) {
+      VkSpecializationInfo *spec = rzalloc(mem_ctx, VkSpecializationInfo);
+      if (!spec)
+         return false;
+
+      spec->pMapEntries = read_array(spec, blob, &spec->mapEntryCount,
+                                     sizeof(*spec->pMapEntries));
+      spec->dataSize = blob_read_uint64(blob);
+      if (blob->overrun ||
+          blob->end - blob->current < (ptrdiff_t)spec->dataSize)
+         return false;
+
+      if (spec->dataSize) {
+         void *spec_data = ralloc_size(spec, spec->dataSize);
+         if (!spec_data)
+            return false;
+         blob_copy_bytes(blob, spec_data, spec->dataSize);
+         spec->pData = spec_data;
+      }
+      stage->pSpecializationInfo = spec;
+   }
+
+   return !blob->overrun;
+}
+
+bool
+pipeline_capture_write_graphics_pipeline(struct blob *blob,
+                                         const VkGraphicsPipelineCreateInfo *info,
+                                         bool has_depth_stencil,
+                                         bool has_color,
+                                         pipeline_capture_lookup_cb lookup,
+                                         void *data)
+{
+   const VkPipelineRasterizationStateCreateInfo *raster =
+      info->pRasterizationState;
+   VkShaderStageFlags stages = 0;
+
+   /* There is no base pipeline to derive from when replaying. */
+   blob_write_uint32(blob, info->flags & ~VK_PIPELINE_CREATE_DERIVATIVE_BIT);
+
+   blob_write_uint32(blob, info->stageCount);
+   for (uint32_t i = 0; i < info->stageCount; i++) {
+      if (!write_shader_stage(blob, &info->pStages[i], lookup, data))
+         return false;
+      stages |= info->pStages[i].stage;
+   }
+
+   const VkPipelineVertexInputStateCreateInfo *vi = info->pVertexInputState;
+   write_array(blob, vi->vertexBindingDescriptionCount,
+               vi->pVertexBindingDescriptions,
+               sizeof(*vi->pVertexBindingDescriptions));
+   write_array(blob, vi->vertexAttributeDescriptionCount,
+               vi->pVertexAttributeDescriptions,
+               sizeof(*vi->pVertexAttributeDescriptions));
+
+   WRITE_TAIL(blob, VkPipelineInputAssemblyStateCreateInfo,
+              info->pInputAssemblyState);
+
+   const VkPipelineTessellationStateCreateInfo *ts =
+      (stages & VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT) ?
+      info->pTessellationState : NULL;
+   blob_write_uint32(blob, ts != NULL);
+   if (ts)
+      WRITE_TAIL(blob, VkPipelineTessellationStateCreateInfo, ts);
+
+   WRITE_TAIL(blob, VkPipelineRasterizationStateCreateInfo, raster);
+
+   /* The other states are ignored, and may be garbage, without
+    * rasterization or the attachments they apply to.
+    */
+   const bool discard = raster->rasterizerDiscardEnable;
+
+   const VkPipelineViewportStateCreateInfo *vp =
+      discard ? NULL : info->pViewportState;
+   blob_write_uint32(blob, vp != NULL);
+   if (vp) {
+      blob_write_uint32(blob, vp->flags);
+      blob_write_uint32(blob, vp->viewportCount);
+      blob_write_uint32(blob, vp->scissorCount);
+      /* Static viewports and scissors don't matter for compiling, the
+       * replayer makes them up.
+       */
+   }
+
+   const VkPipelineMultisampleStateCreateInfo *ms =
+      discard ? NULL : info->pMultisampleState;
+   blob_write_uint32(blob, ms != NULL);
+   if (ms) {
+      blob_write_uint32(blob, ms->flags);
+      blob_write_uint32(blob, ms->rasterizationSamples);
+      blob_write_uint32(blob, ms->sampleShadingEnable);
+      blob_write_bytes(blob, &ms->minSampleShading,
+                       sizeof(ms->minSampleShading));
+      write_array(blob, ms->pSampleMask ?
+                        DIV_ROUND_UP(ms->rasterizationSamples, 32) : 0,
+                  ms->pSampleMask, sizeof(*ms->pSampleMask));
+      blob_write_uint32(blob, ms->alphaToCoverageEnable);
+      blob_write_uint32(blob, ms->alphaToOneEnable);
+   }
+
+   const VkPipelineDepthStencilStateCreateInfo *ds =
+      discard || !has_depth_stencil ? NULL : info->pDepthStencilState;
+   blob_write_uint32(blob, ds != NULL);
+   if (ds)
+      WRITE_TAIL(blob, VkPipelineDepthStencilStateCreateInfo, ds);
+
+   const VkPipelineColorBlendStateCreateInfo *cb =
+      discard || !has_color ? NULL : info->pColorBlendState;
+   blob_write_uint32(blob, cb != NULL);
+   if (cb) {
+      blob_write_uint32(blob, cb->flags);
+      blob_write_uint32(blob, cb->logicOpEnable);
+      blob_write_uint32(blob, cb->logicOp);
+      write_array(blob, cb->attachmentCount, cb->pAttachments,
+                  sizeof(*cb->pAttachments));
+      blob_write_bytes(blob, cb->blendConstants, sizeof(cb->blendConstants));
+   }
+
+   const VkPipelineDynamicStateCreateInfo *dyn = info->pDynamicState;
+   if (dyn) {
+      write_array(blob, dyn->dynamicStateCount, dyn->pDynamicStates,
+                  sizeof(*dyn->pDynamicStates));
+   } else {
+      write_array(blob, 0, NULL, 0);
+   }
+
+   if (!write_handle(blob, PIPELINE_CAPTURE_PIPELINE_LAYOUT, &info->layout,
+                     lookup, data) ||
+       !write_handle(blob, PIPELINE_CAPTURE_RENDER_PASS, &info->renderPass,
+                     lookup, data))
+      return false;
+   blob_write_uint32(blob, info->subpass);
+
+   return !blob->out_of_memory;
+}
+
+VkGraphicsPipelineCreateInfo *
+pipeline_capture_read_graphics_pipeline(void *mem_ctx,
+                                        struct blob_reader *blob,
+                                        pipeline_capture_lookup_cb lookup,
+                                        void *data)
+{
+   VkGraphicsPipelineCreateInfo *info =
+      rzalloc(mem_ctx, VkGraphicsPipelineCreateInfo);
+   if (!info)
+      return NULL;
+
+   info->sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+   info->flags = blob_read_uint32(blob);
+   info->basePipelineIndex = -1;
+
+   info->stageCount = blob_read_uint32(blob);
+   if (blob->overrun)
+      return NULL;
+
+   VkPipelineShaderStageCreateInfo *stages =
+      rzalloc_array(info, VkPipelineShaderStageCreateInfo, info->stageCount);
+   if (!stages)
+      return NULL;
+   for (uint32_t i = 0; i < info->stageCount; i++) {
+      if (!read_shader_stage(stages, blob, &stages[i], lookup, data))
+         return NULL;
+   }
+   info->pStages = stages;
+
+   VkPipelineVertexInputStateCreateInfo *vi =
+      rzalloc(info, VkPipelineVertexInputStateCreateInfo);
+   VkPipelineInputAssemblyStateCreateInfo *ia =
+      rzalloc(info, VkPipelineInputAssemblyStateCreateInfo);
+   VkPipelineRasterizationStateCreateInfo *raster =
+      rzalloc(info, VkPipelineRasterizationStateCreateInfo);
+   if (!vi || !ia || !raster)
+      return NULL;
+
+   vi->sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+   vi->pVertexBindingDescriptions =
+      read_array(vi, blob, &vi->vertexBindingDescriptionCount,
+                 sizeof(*vi->pVertexBindingDescriptions));
+   vi->pVertexAttributeDescriptions =
+      read_array(vi, blob, &vi->vertexAttributeDescriptionCount,
+                 sizeof(*vi->pVertexAttributeDescriptions));
+   info->pVertexInputState = vi;
+
+   ia->sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+   READ_TAIL(blob, VkPipelineInputAssemblyStateCreateInfo, ia);
+   info->pInputAssemblyState = ia;
+
+   if (blob_read_uint32(blob)) {
+      VkPipelineTessellationStateCreateInfo *ts =
+         rzalloc(info, VkPipelineTessellationStateCreateInfo);
+      if (!ts)
+         return NULL;
+      ts->sType = VK_STRUCTURE_TYPE_PIPELINE_TESSELLATION_STATE_CREATE_INFO;
+      READ_TAIL(blob, VkPipelineTessellationStateCreateInfo, ts);
+      info->pTessellationState = ts;
+   }
+
+   raster->sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+   READ_TAIL(blob, VkPipelineRasterizationStateCreateInfo, raster);
+   info->pRasterizationState = raster;
+
+   if (blob_read_uint32(blob)) {
+      VkPipelineViewportStateCreateInfo *vp =
+         rzalloc(info, VkPipelineViewportStateCreateInfo);
+      if (!vp)
+         return NULL;
+
+      vp->sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+      vp->flags = blob_read_uint32(blob);
+      vp->viewportCount = blob_read_uint32(blob);
+      vp->scissorCount = blob_read_uint32(blob);
+      if (blob->overrun)
+         return NULL;
+
+      VkViewport *viewports =
+         rzalloc_array(vp, VkViewport, MAX2(vp->viewportCount, 1));
+      VkRect2D *scissors =
+         rzalloc_array(vp, VkRect2D, MAX2(vp->scissorCount, 1));
+      if (!viewports || !scissors)
+         return NULL;
+      for (uint32_t i = 0; i < vp->viewportCount; i++) {
+         viewports[i].width = 1.0f;
+         viewports[i].height = 1.0f;
+         viewports[i].maxDepth = 1.0f;
+      }
+      for (uint32_t i = 0; i < vp->scissorCount; i++)
+         scissors[i].extent = (VkExtent2D) { 1, 1 };
+      vp->pViewports = viewports;
+      vp->pScissors = scissors;
+      info->pViewportState = vp;
+   }
+
+   if (blob_read_uint32(blob)) {
+      VkPipelineMultisampleStateCreateInfo *ms =
+         rzalloc(info, VkPipelineMultisampleStateCreateInfo);
+      if (!ms)
+         return NULL;
+
+      uint32_t mask_words;
+      ms->sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+      ms->flags = blob_read_uint32(blob);
+      ms->rasterizationSamples = blob_read_uint32(blob);
+      ms->sampleShadingEnable = blob_read_uint32(blob);
+      blob_copy_bytes(blob, &ms->minSampleShading,
+                      sizeof(ms->minSampleShading));
+      ms->pSampleMask = read_array(ms, blob, &mask_words,
+                                   sizeof(*ms->pSampleMask));
+      ms->alphaToCoverageEnable = blob_read_uint32(blob);
+      ms->alphaToOneEnable = blob_read_uint32(blob);
+      info->pMultisampleState = ms;
+   }
+
+   if (blob_read_uint32(blob)) {
+      VkPipelineDepthStencilStateCreateInfo *ds =
+         rzalloc(info, VkPipelineDepthStencilStateCreateInfo);
+      if (!ds)
+         return NULL;
+      ds->sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+      READ_TAIL(blob, VkPipelineDepthStencilStateCreateInfo, ds);
+      info->pDepthStencilState = ds;
+   }
+
+   if (blob_read_uint32(blob)) {
+      VkPipelineColorBlendStateCreateInfo *cb =
+         rzalloc(info, VkPipelineColorBlendStateCreateInfo);
+      if (!cb)
+         return NULL;
+      cb->sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+      cb->flags = blob_read_uint32(blob);
+      cb->logicOpEnable = blob_read_uint32(blob);
+      cb->logicOp = blob_read_uint32(blob);
+      cb->pAttachments = read_array(cb, blob, &cb->attachmentCount,
+                                    sizeof(*cb->pAttachments));
+      blob_copy_bytes(blob, cb->blendConstants, sizeof(cb->blendConstants));
+      info->pColorBlendState = cb;
+   }
+
+   uint32_t dynamic_count;
+   VkDynamicState *dynamic_states =
+      read_array(info, blob, &dynamic_count, sizeof(*dynamic_states));
+   if (dynamic_count) {
+      VkPipelineDynamicStateCreateInfo *dyn =
+         rzalloc(info, VkPipelineDynamicStateCreateInfo);
+      if (!dyn)
+         return NULL;
+      dyn->sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+      dyn->dynamicStateCount = dynamic_count;
+      dyn->pDynamicStates = dynamic_states;
+      info->pDynamicState = dyn;
+   }
+
+   if (!read_handle(blob, PIPELINE_CAPTURE_PIPELINE_LAYOUT, &info->layout,
+                    lookup, data) ||
+       !read_handle(blob, PIPELINE_CAPTURE_RENDER_PASS, &info->renderPass,
+                    lookup, data))
+      return NULL;
+   info->subpass = blob_read_uint32(blob);
+
+   return blob->overrun ? NULL : info;
+}
+
+bool
+pipeline_capture_write_compute_pipeline(struct blob *blob,
+                                        const VkComputePipelineCreateInfo *info,
+                                        pipeline_capture_lookup_cb lookup,
+                                        void *data)
+{
+   blob_write_uint32(blob, info->flags & ~VK_PIPELINE_CREATE_DERIVATIVE_BIT);
+
+   if (!write_shader_stage(blob, &info->stage, lookup, data) ||
+       !write_handle(blob, PIPELINE_CAPTURE_PIPELINE_LAYOUT, &info->layout,
+                     lookup, data))
+      return false;
+
+   return !blob->out_of_memory;
+}
+
+VkComputePipelineCreateInfo *
+pipeline_capture_read_compute_pipeline(void *mem_ctx,
+                                       struct blob_reader *blob,
+                                       pipeline_capture_lookup_cb lookup,
+                                       void *data)
+{
+   VkComputePipelineCreateInfo *info =
+      rzalloc(mem_ctx, VkComputePipelineCreateInfo);
+   if (!info)
+      return NULL;
+
+   info->sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+   info->flags = blob_read_uint32(blob);
+   info->basePipelineIndex = -1;
+
+   if (!read_shader_stage(info, blob, &info->stage, lookup, data) ||
+       !read_handle(blob, PIPELINE_CAPTURE_PIPELINE_LAYOUT, &info->layout,
+                    lookup, data))
+      return NULL;
+
+   return blob->overrun ? NULL : info;
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef PIPELINE_CAPTURE_H
+#define PIPELINE_CAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+
+#include "util/blob.h"
+
+/* A pipeline capture file is a header followed by records, each made of a
+ * struct pipeline_capture_record and its data.  Records are only ever
+ * appended, and each object a pipeline depends on is recorded before the
+ * pipeline.
+ *
+ * Records are identified by a hash of their content, which the records
+ * referencing them use in place of the Vulkan handles.  Identical objects
+ * therefore share a single record, even across runs of an application.
+ *
+ * The data is not portable across ABIs, it is meant to be replayed on the
+ * same kind of system it was captured on, with a different GPU.
+ */
+
+#define PIPELINE_CAPTURE_MAGIC "MESAPIPE"
+#define PIPELINE_CAPTURE_VERSION 1
+
+enum pipeline_capture_type {
+   PIPELINE_CAPTURE_DEVICE = 1,
+   PIPELINE_CAPTURE_SHADER_MODULE,
+   PIPELINE_CAPTURE_SAMPLER,
+   PIPELINE_CAPTURE_DESCRIPTOR_SET_LAYOUT,
+   PIPELINE_CAPTURE_PIPELINE_LAYOUT,
+   PIPELINE_CAPTURE_RENDER_PASS,
+   PIPELINE_CAPTURE_GRAPHICS_PIPELINE,
+   PIPELINE_CAPTURE_COMPUTE_PIPELINE,
+   PIPELINE_CAPTURE_NUM_TYPES,
+};
+
+struct pipeline_capture_header {
+   char magic[8];
+   uint32_t version;
+   uint32_t pad;
+};
+
+struct pipeline_capture_record {
+   uint32_t type;
+   /* Size of the data following this struct */
+   uint32_t size;
+   uint64_t id;
+   /* Id of the device record of the device the object was created on, 0
+    * for device records.
+    */
+   uint64_t device_id;
+};
+
+/* Maps a handle to the id of its record when capturing, and an id to the
+ * replayed handle when replaying.  Returns 0 if the object is unknown.
+ */
+typedef uint64_t (*pipeline_capture_lookup_cb)(void *data,
+                                               enum pipeline_capture_type type,
+                                               uint64_t key);
+
+static inline uint64_t
+pipeline_capture_handle_to_u64(const void *handle)
+{
+   /* Non-dispatchable handles are 64 bits on all ABIs. */
+   uint64_t value;
+   memcpy(&value, handle, sizeof(value));
+   return value;
+}
+
+uint64_t
+pipeline_capture_record_id(enum pipeline_capture_type type,
+                           uint64_t device_id,
+                           const void *data, size_t size);
+
+/* The writers return false if the create info uses something which can't be
+ * captured, in which case the blob is left in an undefined state.
+ */
+bool
+pipeline_capture_write_device(struct blob *blob,
+                              const VkDeviceCreateInfo *info);
+
+bool
+pipeline_capture_write_shader_module(struct blob *blob,
+                                     const VkShaderModuleCreateInfo *info);
+
+bool
+pipeline_capture_write_sampler(struct blob *blob,
+                               const VkSamplerCreateInfo *info);
+
+bool
+pipeline_capture_write_descriptor_set_layout(struct blob *blob,
+                                             const VkDescriptorSetLayoutCreateInfo *info,
+                                             pipeline_capture_lookup_cb lookup,
+                                             void *data);
+
+bool
+pipeline_capture_write_pipeline_layout(struct blob *blob,
+                                       const VkPipelineLayoutCreateInfo *info,
+                                       pipeline_capture_lookup_cb lookup,
+                                       void *data);
+
+bool
+pipeline_capture_write_render_pass(struct blob *blob,
+                                   const VkRenderPassCreateInfo *info);
+
+/* has_depth_stencil and has_color tell whether the subpass of the pipeline
+ * uses such attachments, the corresponding state is ignored otherwise.
+ */
+bool
+pipeline_capture_write_graphics_pipeline(struct blob *blob,
+                                         const VkGraphicsPipelineCreateInfo *info,
+                                         bool has_depth_stencil,
+                                         bool has_color,
+                                         pipeline_capture_lookup_cb lookup,
+                                         void *data);
+
+bool
+pipeline_capture_write_compute_pipeline(struct blob *blob,
+                                        const VkComputePipelineCreateInfo *info,
+                                        pipeline_capture_lookup_cb lookup,
+                                        void *data);
+
+/* The readers return a create info allocated out of mem_ctx, or NULL if the
+ * data is truncated or references an unknown object.
+ */
+VkDeviceCreateInfo *
+pipeline_capture_read_device(void *mem_ctx, struct blob_reader *blob);
+
+VkShaderModuleCreateInfo *
+pipeline_capture_read_shader_module(void *mem_ctx, struct blob_reader *blob);
+
+VkSamplerCreateInfo *
+pipeline_capture_read_sampler(void *mem_ctx, struct blob_reader *blob);
+
+VkDescriptorSetLayoutCreateInfo *
+pipeline_capture_read_descriptor_set_layout(void *mem_ctx,
+                                            struct blob_reader *blob,
+                                            pipeline_capture_lookup_cb lookup,
+                                            void *data);
+
+VkPipelineLayoutCreateInfo *
+pipeline_capture_read_pipeline_layout(void *mem_ctx,
+                                      struct blob_reader *blob,
+                                      pipeline_capture_lookup_cb lookup,
+                                      void *data);
+
+VkRenderPassCreateInfo *
+pipeline_capture_read_render_pass(void *mem_ctx, struct blob_reader *blob);
+
+VkGraphicsPipelineCreateInfo *
+pipeline_capture_read_graphics_pipeline(void *mem_ctx,
+                                        struct blob_reader *blob,
+                                        pipeline_capture_lookup_cb lookup,
+                                        void *data);
+
+VkComputePipelineCreateInfo *
+pipeline_capture_read_compute_pipeline(void *mem_ctx,
+                                       struct blob_reader *blob,
+                                       pipeline_capture_lookup_cb lookup,
+                                       void *data);
+
+#endif /* PIPELINE_CAPTURE_H */
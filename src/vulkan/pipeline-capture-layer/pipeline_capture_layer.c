@@ -0,0 +1,792 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Records the pipelines an application creates, and everything needed to
+ * create them again, to the file named by MESA_PIPELINE_CAPTURE_FILE.  See
+ * pipeline_capture.h for the format and mesa-pipeline-replay for the other
+ * end.
+ *
+ * Appending to an existing file only adds the pipelines it doesn't contain
+ * yet, so it can be shared by any number of runs.
+ */
+
+#include <vulkan/vk_layer.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "pipeline_capture.h"
+
+#include "c11/threads.h"
+#include "util/hash_table.h"
+#include "util/macros.h"
+#include "util/ralloc.h"
+
+struct instance_info {
+   PFN_vkGetInstanceProcAddr GetInstanceProcAddr;
+   PFN_vkDestroyInstance DestroyInstance;
+};
+
+struct capture_object {
+   uint64_t id;
+
+   /* For render passes, a bitfield of SUBPASS_HAS_* per subpass */
+   uint32_t subpass_count;
+   uint8_t *subpass_attachments;
+};
+
+#define SUBPASS_HAS_DEPTH_STENCIL 0x1
+#define SUBPASS_HAS_COLOR         0x2
+
+struct device_info {
+   /* Id of the device record */
+   uint64_t id;
+
+   /* Handle to struct capture_object, per type */
+   struct hash_table_u64 *objects[PIPELINE_CAPTURE_NUM_TYPES];
+
+   PFN_vkGetDeviceProcAddr GetDeviceProcAddr;
+   PFN_vkDestroyDevice DestroyDevice;
+   PFN_vkCreateShaderModule CreateShaderModule;
+   PFN_vkDestroyShaderModule DestroyShaderModule;
+   PFN_vkCreateSampler CreateSampler;
+   PFN_vkDestroySampler DestroySampler;
+   PFN_vkCreateDescriptorSetLayout CreateDescriptorSetLayout;
+   PFN_vkDestroyDescriptorSetLayout DestroyDescriptorSetLayout;
+   PFN_vkCreatePipelineLayout CreatePipelineLayout;
+   PFN_vkDestroyPipelineLayout DestroyPipelineLayout;
+   PFN_vkCreateRenderPass CreateRenderPass;
+   PFN_vkDestroyRenderPass DestroyRenderPass;
+   PFN_vkCreateGraphicsPipelines CreateGraphicsPipelines;
+   PFN_vkCreateComputePipelines CreateComputePipelines;
+};
+
+/* Protects everything below. */
+static mtx_t capture_mutex;
+static once_flag capture_once = ONCE_FLAG_INIT;
+
+static struct hash_table *instances;
+static struct hash_table *devices;
+
+/* The capture file, -1 if not capturing */
+static int capture_fd = -1;
+
+/* Ids of the records in the capture file */
+static struct hash_table_u64 *recorded_ids;
+
+static bool
+capture_load_ids(int fd)
+{
+   struct pipeline_capture_header header;
+   struct pipeline_capture_record record;
+   off_t offset = sizeof(header);
+   struct stat st;
+
+   if (fstat(fd, &st) == -1)
+      return false;
+
+   if (st.st_size == 0) {
+      memcpy(header.magic, PIPELINE_CAPTURE_MAGIC, sizeof(header.magic));
+      header.version = PIPELINE_CAPTURE_VERSION;
+      header.pad = 0;
+      return write(fd, &header, sizeof(header)) == sizeof(header);
+   }
+
+   if (pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+       memcmp(header.magic, PIPELINE_CAPTURE_MAGIC, sizeof(header.magic)) ||
+       header.version != PIPELINE_CAPTURE_VERSION)
+      return false;
+
+   /* A truncated last record, from a crash in the middle of a write, is
+    * simply written again.
+    */
+   while (offset + sizeof(record) <= st.st_size &&
+          pread(fd, &record, sizeof(record), offset) == sizeof(record) &&
+          offset + sizeof(record) + record.size <= st.st_size) {
+      _mesa_hash_table_u64_insert(recorded_ids, record.id, (void *)(uintptr_t)1);
+      offset += sizeof(record) + record.size;
+   }
+
+   return true;
+}
+
+static void
+capture_init(void)
+{
+   mtx_init(&capture_mutex, mtx_plain);
+
+   instances = _mesa_pointer_hash_table_create(NULL);
+   devices = _mesa_pointer_hash_table_create(NULL);
+   recorded_ids = _mesa_hash_table_u64_create(NULL);
+
+   const char *path = getenv("MESA_PIPELINE_CAPTURE_FILE");
+   if (!path) {
+      fprintf(stderr, "pipeline capture: MESA_PIPELINE_CAPTURE_FILE is not "
+                      "set, not capturing\n");
+      return;
+   }
+
+   int fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+   if (fd == -1) {
+      fprintf(stderr, "pipeline capture: failed to open %s: %s\n",
+              path, strerror(errno));
+      return;
+   }
+
+   if (!capture_load_ids(fd)) {
+      fprintf(stderr, "pipeline capture: %s is not a valid capture file\n",
+              path);
+      close(fd);
+      return;
+   }
+
+   capture_fd = fd;
+}
+
+/* Writes a record unless the file already has it, and returns its id.
+ * Called with the mutex held.
+ */
+static uint64_t
+capture_write_record(enum pipeline_capture_type type, uint64_t device_id,
+                     const struct blob *blob)
+{
+   uint64_t id = pipeline_capture_record_id(type, device_id,
+                                            blob->data, blob->size);
+
+   if (capture_fd == -1 || _mesa_hash_table_u64_search(recorded_ids, id))
+      return id;
+
+   struct pipeline_capture_record record = {
+      .type = type,
+      .size = blob->size,
+      .id = id,
+      .device_id = device_id,
+   };
+   struct iovec iov[2] = {
+      { .iov_base = &record, .iov_len = sizeof(record) },
+      { .iov_base = (void *)blob->data, .iov_len = blob->size },
+   };
+
+   /* One write per record, so that several processes can append to the
+    * same file.
+    */
+   if (writev(capture_fd, iov, ARRAY_SIZE(iov)) !=
+       (ssize_t)(sizeof(record) + blob->size)) {
+      fprintf(stderr, "pipeline capture: write failed, stopping: %s\n",
+              strerror(errno));
+      close(capture_fd);
+      capture_fd = -1;
+      return id;
+   }
+
+   _mesa_hash_table_u64_insert(recorded_ids, id, (void *)(uintptr_t)1);
+
+   return id;
+}
+
+static struct instance_info *
+capture_get_instance(VkInstance instance)
+{
+   mtx_lock(&capture_mutex);
+   struct hash_entry *entry = _mesa_hash_table_search(instances, instance);
+   mtx_unlock(&capture_mutex);
+
+   return entry ? entry->data : NULL;
+}
+
+static struct device_info *
+capture_get_device(VkDevice device)
+{
+   mtx_lock(&capture_mutex);
+   struct hash_entry *entry = _mesa_hash_table_search(devices, device);
+   mtx_unlock(&capture_mutex);
+
+   return entry ? entry->data : NULL;
+}
+
+/* Called with the mutex held. */
+static uint64_t
+capture_lookup(void *data, enum pipeline_capture_type type, uint64_t handle)
+{
+   struct device_info *dev = data;
+   struct capture_object *obj =
+      _mesa_hash_table_u64_search(dev->objects[type], handle);
+
+   return obj ? obj->id : 0;
+}
+
+/* Records an object if its create info could be written to the blob, and
+ * starts tracking its handle.  Called with the mutex held.
+ */
+static struct capture_object *
+capture_add_object(struct device_info *dev, enum pipeline_capture_type type,
+                   uint64_t handle, const struct blob *blob, bool written)
+{
+   if (!written || blob->out_of_memory)
+      return NULL;
+
+   struct capture_object *obj = rzalloc(dev, struct capture_object);
+   if (!obj)
+      return NULL;
+
+   obj->id = capture_write_record(type, dev->id, blob);
+   _mesa_hash_table_u64_insert(dev->objects[type], handle, obj);
+
+   return obj;
+}
+
+static void
+capture_remove_object(VkDevice device, enum pipeline_capture_type type,
+                      uint64_t handle)
+{
+   struct device_info *dev = capture_get_device(device);
+
+   mtx_lock(&capture_mutex);
+   struct capture_object *obj =
+      _mesa_hash_table_u64_search(dev->objects[type], handle);
+   if (obj) {
+      _mesa_hash_table_u64_remove(dev->objects[type], handle);
+      ralloc_free(obj);
+   }
+   mtx_unlock(&capture_mutex);
+}
+
+static VkResult
+capture_CreateInstance(const VkInstanceCreateInfo *pCreateInfo,
+                       const VkAllocationCallbacks *pAllocator,
+                       VkInstance *pInstance)
+{
+   VkLayerInstanceCreateInfo *chain_info;
+   for (chain_info = (VkLayerInstanceCreateInfo *)pCreateInfo->pNext;
+        chain_info; chain_info = (VkLayerInstanceCreateInfo *)chain_info->pNext) {
+      if (chain_info->sType == VK_STRUCTURE_TYPE_LOADER_INSTANCE_CREATE_INFO &&
+          chain_info->function == VK_LAYER_LINK_INFO)
+         break;
+   }
+
+   assert(chain_info && chain_info->u.pLayerInfo);
+
+   struct instance_info *info = calloc(1, sizeof(*info));
+   if (!info)
+      return VK_ERROR_OUT_OF_HOST_MEMORY;
+
+   info->GetInstanceProcAddr =
+      chain_info->u.pLayerInfo->pfnNextGetInstanceProcAddr;
+   PFN_vkCreateInstance fpCreateInstance =
+      (PFN_vkCreateInstance)info->GetInstanceProcAddr(NULL, "vkCreateInstance");
+   if (fpCreateInstance == NULL) {
+      free(info);
+      return VK_ERROR_INITIALIZATION_FAILED;
+   }
+
+   chain_info->u.pLayerInfo = chain_info->u.pLayerInfo->pNext;
+
+   VkResult result = fpCreateInstance(pCreateInfo, pAllocator, pInstance);
+   if (result != VK_SUCCESS) {
+      free(info);
+      return result;
+   }
+
+   info->DestroyInstance = (PFN_vkDestroyInstance)
+      info->GetInstanceProcAddr(*pInstance, "vkDestroyInstance");
+
+   mtx_lock(&capture_mutex);
+   _mesa_hash_table_insert(instances, *pInstance, info);
+   mtx_unlock(&capture_mutex);
+
+   return VK_SUCCESS;
+}
+
+static void
+capture_DestroyInstance(VkInstance instance,
+                        const VkAllocationCallbacks *pAllocator)
+{
+   struct instance_info *info = capture_get_instance(instance);
+
+   mtx_lock(&capture_mutex);
+   _mesa_hash_table_remove_key(instances, instance);
+   mtx_unlock(&capture_mutex);
+
+   info->DestroyInstance(instance, pAllocator);
+   free(info);
+}
+
+static VkResult
+capture_CreateDevice(VkPhysicalDevice physicalDevice,
+                     const VkDeviceCreateInfo *pCreateInfo,
+                     const VkAllocationCallbacks *pAllocator,
+                     VkDevice *pDevice)
+{
+   VkLayerDeviceCreateInfo *chain_info;
+   for (chain_info = (VkLayerDeviceCreateInfo *)pCreateInfo->pNext;
+        chain_info; chain_info = (VkLayerDeviceCreateInfo *)chain_info->pNext) {
+      if (chain_info->sType == VK_STRUCTURE_TYPE_LOADER_DEVICE_CREATE_INFO &&
+          chain_info->function == VK_LAYER_LINK_INFO)
+         break;
+   }
+
+   assert(chain_info && chain_info->u.pLayerInfo);
+
+   PFN_vkGetInstanceProcAddr fpGetInstanceProcAddr =
+      chain_info->u.pLayerInfo->pfnNextGetInstanceProcAddr;
+   PFN_vkGetDeviceProcAddr fpGetDeviceProcAddr =
+      chain_info->u.pLayerInfo->pfnNextGetDeviceProcAddr;
+   PFN_vkCreateDevice fpCreateDevice =
+      (PFN_vkCreateDevice)fpGetInstanceProcAddr(NULL, "vkCreateDevice");
+   if (fpCreateDevice == NULL)
+      return VK_ERROR_INITIALIZATION_FAILED;
+
+   struct device_info *dev = rzalloc(NULL, struct device_info);
+   if (!dev)
+      return VK_ERROR_OUT_OF_HOST_MEMORY;
+
+   for (unsigned i = 0; i < PIPELINE_CAPTURE_NUM_TYPES; i++) {
+      dev->objects[i] = _mesa_hash_table_u64_create(dev);
+      if (!dev->objects[i]) {
+         ralloc_free(dev);
+         return VK_ERROR_OUT_OF_HOST_MEMORY;
+      }
+   }
+
+   chain_info->u.pLayerInfo = chain_info->u.pLayerInfo->pNext;
+
+   VkResult result = fpCreateDevice(physicalDevice, pCreateInfo,
+                                    pAllocator, pDevice);
+   if (result != VK_SUCCESS) {
+      ralloc_free(dev);
+      return result;
+   }
+
+   dev->GetDeviceProcAddr = fpGetDeviceProcAddr;
+#define CAPTURE_GET_CB(func) \
+   dev->func = (PFN_vk##func)fpGetDeviceProcAddr(*pDevice, "vk" #func)
+   CAPTURE_GET_CB(DestroyDevice);
+   CAPTURE_GET_CB(CreateShaderModule);
+   CAPTURE_GET_CB(DestroyShaderModule);
+   CAPTURE_GET_CB(CreateSampler);
+   CAPTURE_GET_CB(DestroySampler);
+   CAPTURE_GET_CB(CreateDescriptorSetLayout);
+   CAPTURE_GET_CB(DestroyDescriptorSetLayout);
+   CAPTURE_GET_CB(CreatePipelineLayout);
+   CAPTURE_GET_CB(DestroyPipelineLayout);
+   CAPTURE_GET_CB(CreateRenderPass);
+   CAPTURE_GET_CB(DestroyRenderPass);
+   CAPTURE_GET_CB(CreateGraphicsPipelines);
+   CAPTURE_GET_CB(CreateComputePipelines);
+#undef CAPTURE_GET_CB
+
+   struct blob blob;
+   blob_init(&blob);
+   pipeline_capture_write_device(&blob, pCreateInfo);
+
+   mtx_lock(&capture_mutex);
+   dev->id = capture_write_record(PIPELINE_CAPTURE_DEVICE, 0, &blob);
+   _mesa_hash_table_insert(devices, *pDevice, dev);
+   mtx_unlock(&capture_mutex);
+
+   blob_finish(&blob);
+
+   return VK_SUCCESS;
+}
+
+static void
+capture_DestroyDevice(VkDevice device, const VkAllocationCallbacks *pAllocator)
+{
+   struct device_info *dev = capture_get_device(device);
+
+   mtx_lock(&capture_mutex);
+   _mesa_hash_table_remove_key(devices, device);
+   mtx_unlock(&capture_mutex);
+
+   dev->DestroyDevice(device, pAllocator);
+   ralloc_free(dev);
+}
+
+static VkResult
+capture_CreateShaderModule(VkDevice device,
+                           const VkShaderModuleCreateInfo *pCreateInfo,
+                           const VkAllocationCallbacks *pAllocator,
+                           VkShaderModule *pShaderModule)
+{
+   struct device_info *dev = capture_get_device(device);
+   VkResult result = dev->CreateShaderModule(device, pCreateInfo, pAllocator,
+                                             pShaderModule);
+   if (result != VK_SUCCESS)
+      return result;
+
+   struct blob blob;
+   blob_init(&blob);
+   bool written = pipeline_capture_write_shader_module(&blob, pCreateInfo);
+
+   mtx_lock(&capture_mutex);
+   capture_add_object(dev, PIPELINE_CAPTURE_SHADER_MODULE,
+                      pipeline_capture_handle_to_u64(pShaderModule),
+                      &blob, written);
+   mtx_unlock(&capture_mutex);
+
+   blob_finish(&blob);
+
+   return VK_SUCCESS;
+}
+
+static void
+capture_DestroyShaderModule(VkDevice device, VkShaderModule shaderModule,
+                            const VkAllocationCallbacks *pAllocator)
+{
+   struct device_info *dev = capture_get_device(device);
+
+   capture_remove_object(device, PIPELINE_CAPTURE_SHADER_MODULE,
+                         pipeline_capture_handle_to_u64(&shaderModule));
+   dev->DestroyShaderModule(device, shaderModule, pAllocator);
+}
+
+static VkResult
+capture_CreateSampler(VkDevice device,
+                      const VkSamplerCreateInfo *pCreateInfo,
+                      const VkAllocationCallbacks *pAllocator,
+                      VkSampler *pSampler)
+{
+   struct device_info *dev = capture_get_device(device);
+   VkResult result = dev->CreateSampler(device, pCreateInfo, pAllocator,
+                                        pSampler);
+   if (result != VK_SUCCESS)
+      return result;
+
+   struct blob blob;
+   blob_init(&blob);
+   bool written = pipeline_capture_write_sampler(&blob, pCreateInfo);
+
+   mtx_lock(&capture_mutex);
+   capture_add_object(dev, PIPELINE_CAPTURE_SAMPLER,
+                      pipeline_capture_handle_to_u64(pSampler),
+                      &blob, written);
+   mtx_unlock(&capture_mutex);
+
+   blob_finish(&blob);
+
+   return VK_SUCCESS;
+}
+
+static void
+capture_DestroySampler(VkDevice device, VkSampler sampler,
+                       const VkAllocationCallbacks *pAllocator)
+{
+   struct device_info *dev = capture_get_device(device);
+
+   capture_remove_object(device, PIPELINE_CAPTURE_SAMPLER,
+                         pipeline_capture_handle_to_u64(&sampler));
+   dev->DestroySampler(device, sampler, pAllocator);
+}
+
+static VkResult
+capture_CreateDescriptorSetLayout(VkDevice device,
+                                  const VkDescriptorSetLayoutCreateInfo *pCreateInfo,
+                                  const VkAllocationCallbacks *pAllocator,
+                                  VkDescriptorSetLayout *pSetLayout)
+{
+   struct device_info *dev = capture_get_device(device);
+   VkResult result = dev->CreateDescriptorSetLayout(device, pCreateInfo,
+                                                    pAllocator, pSetLayout);
+   if (result != VK_SUCCESS)
+      return result;
+
+   struct blob blob;
+   blob_init(&blob);
+
+   mtx_lock(&capture_mutex);
+   bool written =
+      pipeline_capture_write_descriptor_set_layout(&blob, pCreateInfo,
+                                                   capture_lookup, dev);
+   capture_add_object(dev, PIPELINE_CAPTURE_DESCRIPTOR_SET_LAYOUT,
+                      pipeline_capture_handle_to_u64(pSetLayout),
+                      &blob, written);
+   mtx_unlock(&capture_mutex);
+
+   blob_finish(&blob);
+
+   return VK_SUCCESS;
+}
+
+static void
+capture_DestroyDescriptorSetLayout(VkDevice device,
+                                   VkDescriptorSetLayout descriptorSetLayout,
+                                   const VkAllocationCallbacks *pAllocator)
+{
+   struct device_info *dev = capture_get_device(device);
+
+   capture_remove_object(device, PIPELINE_CAPTURE_DESCRIPTOR_SET_LAYOUT,
+                         pipeline_capture_handle_to_u64(&descriptorSetLayout));
+   dev->DestroyDescriptorSetLayout(device, descriptorSetLayout, pAllocator);
+}
+
+static VkResult
+capture_CreatePipelineLayout(VkDevice device,
+                             const VkPipelineLayoutCreateInfo *pCreateInfo,
+                             const VkAllocationCallbacks *pAllocator,
+                             VkPipelineLayout *pPipelineLayout)
+{
+   struct device_info *dev = capture_get_device(device);
+   VkResult result = dev->CreatePipelineLayout(device, pCreateInfo,
+                                               pAllocator, pPipelineLayout);
+   if (result != VK_SUCCESS)
+      return result;
+
+   struct blob blob;
+   blob_init(&blob);
+
+   mtx_lock(&capture_mutex);
+   bool written =
+      pipeline_capture_write_pipeline_layout(&blob, pCreateInfo,
+                                             capture_lookup, dev);
+   capture_add_object(dev, PIPELINE_CAPTURE_PIPELINE_LAYOUT,
+                      pipeline_capture_handle_to_u64(pPipelineLayout),
+                      &blob, written);
+   mtx_unlock(&capture_mutex);
+
+   blob_finish(&blob);
+
+   return VK_SUCCESS;
+}
+
+static void
+capture_DestroyPipelineLayout(VkDevice device,
+                              VkPipelineLayout pipelineLayout,
+                              const VkAllocationCallbacks *pAllocator)
+{
+   struct device_info *dev = capture_get_device(device);
+
+   capture_remove_object(device, PIPELINE_CAPTURE_PIPELINE_LAYOUT,
+                         pipeline_capture_handle_to_u64(&pipelineLayout));
+   dev->DestroyPipelineLayout(device, pipelineLayout, pAllocator);
+}
+
+static VkResult
+capture_CreateRenderPass(VkDevice device,
+                         const VkRenderPassCreateInfo *pCreateInfo,
+                         const VkAllocationCallbacks *pAllocator,
+                         VkRenderPass *pRenderPass)
+{
+   struct device_info *dev = capture_get_device(device);
+   VkResult result = dev->CreateRenderPass(device, pCreateInfo, pAllocator,
+                                           pRenderPass);
+   if (result != VK_SUCCESS)
+      return result;
+
+   struct blob blob;
+   blob_init(&blob);
+   bool written = pipeline_capture_write_render_pass(&blob, pCreateInfo);
+
+   mtx_lock(&capture_mutex);
+   struct capture_object *obj =
+      capture_add_object(dev, PIPELINE_CAPTURE_RENDER_PASS,
+                         pipeline_capture_handle_to_u64(pRenderPass),
+                         &blob, written);
+   if (obj) {
+      obj->subpass_count = pCreateInfo->subpassCount;
+      obj->subpass_attachments =
+         rzalloc_array(obj, uint8_t, pCreateInfo->subpassCount);
+      for (uint32_t i = 0; obj->subpass_attachments &&
+                           i < pCreateInfo->subpassCount; i++) {
+         const VkSubpassDescription *subpass = &pCreateInfo->pSubpasses[i];
+
+         if (subpass->pDepthStencilAttachment &&
+             subpass->pDepthStencilAttachment->attachment != VK_ATTACHMENT_UNUSED)
+            obj->subpass_attachments[i] |= SUBPASS_HAS_DEPTH_STENCIL;
+
+         for (uint32_t c = 0; c < subpass->colorAttachmentCount; c++) {
+            if (subpass->pColorAttachments[c].attachment != VK_ATTACHMENT_UNUSED)
+               obj->subpass_attachments[i] |= SUBPASS_HAS_COLOR;
+         }
+      }
+   }
+   mtx_unlock(&capture_mutex);
+
+   blob_finish(&blob);
+
+   return VK_SUCCESS;
+}
+
+static void
+capture_DestroyRenderPass(VkDevice device, VkRenderPass renderPass,
+                          const VkAllocationCallbacks *pAllocator)
+{
+   struct device_info *dev = capture_get_device(device);
+
+   capture_remove_object(device, PIPELINE_CAPTURE_RENDER_PASS,
+                         pipeline_capture_handle_to_u64(&renderPass));
+   dev->DestroyRenderPass(device, renderPass, pAllocator);
+}
+
+static VkResult
+capture_CreateGraphicsPipelines(VkDevice device,
+                                VkPipelineCache pipelineCache,
+                                uint32_t createInfoCount,
+                                const VkGraphicsPipelineCreateInfo *pCreateInfos,
+                                const VkAllocationCallbacks *pAllocator,
+                                VkPipeline *pPipelines)
+{
+   struct device_info *dev = capture_get_device(device);
+   VkResult result = dev->CreateGraphicsPipelines(device, pipelineCache,
+                                                  createInfoCount, pCreateInfos,
+                                                  pAllocator, pPipelines);
+
+   mtx_lock(&capture_mutex);
+   for (uint32_t i = 0; i < createInfoCount; i++) {
+      const VkGraphicsPipelineCreateInfo *info = &pCreateInfos[i];
+
+      if (pPipelines[i] == VK_NULL_HANDLE)
+         continue;
+
+      /* Render passes we couldn't capture, as well as those created with
+       * vkCreateRenderPass2(), are unknown.
+       */
+      struct capture_object *pass =
+         _mesa_hash_table_u64_search(dev->objects[PIPELINE_CAPTURE_RENDER_PASS],
+                                     pipeline_capture_handle_to_u64(&info->renderPass));
+      if (!pass || info->subpass >= pass->subpass_count ||
+          !pass->subpass_attachments)
+         continue;
+
+      const uint8_t attachments = pass->subpass_attachments[info->subpass];
+
+      struct blob blob;
+      blob_init(&blob);
+      if (pipeline_capture_write_graphics_pipeline(&blob, info,
+                                                   attachments & SUBPASS_HAS_DEPTH_STENCIL,
+                                                   attachments & SUBPASS_HAS_COLOR,
+                                                   capture_lookup, dev))
+         capture_write_record(PIPELINE_CAPTURE_GRAPHICS_PIPELINE, dev->id, &blob);
+      blob_finish(&blob);
+   }
+   mtx_unlock(&capture_mutex);
+
+   return result;
+}
+
+static VkResult
+capture_CreateComputePipelines(VkDevice device,
+                               VkPipelineCache pipelineCache,
+                               uint32_t createInfoCount,
+                               const VkComputePipelineCreateInfo *pCreateInfos,
+                               const VkAllocationCallbacks *pAllocator,
+                               VkPipeline *pPipelines)
+{
+   struct device_info *dev = capture_get_device(device);
+   VkResult result = dev->CreateComputePipelines(device, pipelineCache,
+                                                 createInfoCount, pCreateInfos,
+                                                 pAllocator, pPipelines);
+
+   mtx_lock(&capture_mutex);
+   for (uint32_t i = 0; i < createInfoCount; i++) {
+      if (pPipelines[i] == VK_NULL_HANDLE)
+         continue;
+
+      struct blob blob;
+      blob_init(&blob);
+      if (pipeline_capture_write_compute_pipeline(&blob, &pCreateInfos[i],
+                                                  capture_lookup, dev))
+         capture_write_record(PIPELINE_CAPTURE_COMPUTE_PIPELINE, dev->id, &blob);
+      blob_finish(&blob);
+   }
+   mtx_unlock(&capture_mutex);
+
+   return result;
+}
+
+static PFN_vkVoidFunction
+capture_get_device_func(const char *name)
+{
+#define CAPTURE_FUNC(func) \
+   if (strcmp(name, "vk" #func) == 0) \
+      return (PFN_vkVoidFunction)capture_##func;
+   CAPTURE_FUNC(DestroyDevice);
+   CAPTURE_FUNC(CreateShaderModule);
+   CAPTURE_FUNC(DestroyShaderModule);
+   CAPTURE_FUNC(CreateSampler);
+   CAPTURE_FUNC(DestroySampler);
+   CAPTURE_FUNC(CreateDescriptorSetLayout);
+   CAPTURE_FUNC(DestroyDescriptorSetLayout);
+   CAPTURE_FUNC(CreatePipelineLayout);
+   CAPTURE_FUNC(DestroyPipelineLayout);
+   CAPTURE_FUNC(CreateRenderPass);
+   CAPTURE_FUNC(DestroyRenderPass);
+   CAPTURE_FUNC(CreateGraphicsPipelines);
+   CAPTURE_FUNC(CreateComputePipelines);
+#undef CAPTURE_FUNC
+
+   return NULL;
+}
+
+static PFN_vkVoidFunction
+capture_get_device_proc_addr(VkDevice device, const char *name)
+{
+   PFN_vkVoidFunction func = capture_get_device_func(name);
+   if (func)
+      return func;
+
+   struct device_info *dev = capture_get_device(device);
+   return dev->GetDeviceProcAddr(device, name);
+}
+
+static PFN_vkVoidFunction
+capture_get_instance_proc_addr(VkInstance instance, const char *name)
+{
+   if (strcmp(name, "vkCreateInstance") == 0)
+      return (PFN_vkVoidFunction)capture_CreateInstance;
+   if (strcmp(name, "vkDestroyInstance") == 0)
+      return (PFN_vkVoidFunction)capture_DestroyInstance;
+   if (strcmp(name, "vkCreateDevice") == 0)
+      return (PFN_vkVoidFunction)capture_CreateDevice;
+   if (strcmp(name, "vkGetDeviceProcAddr") == 0)
+      return (PFN_vkVoidFunction)capture_get_device_proc_addr;
+
+   PFN_vkVoidFunction func = capture_get_device_func(name);
+   if (func)
+      return func;
+
+   struct instance_info *info = capture_get_instance(instance);
+   return info ? info->GetInstanceProcAddr(instance, name) : NULL;
+}
+
+VK_LAYER_EXPORT VkResult
+vkNegotiateLoaderLayerInterfaceVersion(VkNegotiateLayerInterface *pVersionStruct)
+{
+   if (pVersionStruct->loaderLayerInterfaceVersion < 2)
+      return VK_ERROR_INITIALIZATION_FAILED;
+   pVersionStruct->loaderLayerInterfaceVersion = 2;
+
+   call_once(&capture_once, capture_init);
+
+   pVersionStruct->pfnGetInstanceProcAddr = capture_get_instance_proc_addr;
+   pVersionStruct->pfnGetDeviceProcAddr = capture_get_device_proc_addr;
+   pVersionStruct->pfnGetPhysicalDeviceProcAddr = NULL;
+
+   return VK_SUCCESS;
+}
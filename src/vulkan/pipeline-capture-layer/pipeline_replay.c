@@ -0,0 +1,574 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Creates all the pipelines of a capture file made by the pipeline capture
+ * layer, at low priority and without a pipeline cache, so that the driver
+ * stores the compiled shaders in its disk cache.  Running this at install
+ * time avoids compiling them while the application runs.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "pipeline_capture.h"
+
+#include "util/hash_table.h"
+#include "util/macros.h"
+#include "util/os_file.h"
+#include "util/ralloc.h"
+#include "util/u_dynarray.h"
+
+/* Pipelines are created this many at a time, so that drivers can compile
+ * them in parallel.
+ */
+#define REPLAY_BATCH_SIZE 64
+
+struct replay_object {
+   enum pipeline_capture_type type;
+   uint64_t handle;
+};
+
+struct replay_device {
+   VkDevice device;
+
+   /* Record id to the uint64_t handle created for it, per type */
+   struct hash_table_u64 *handles[PIPELINE_CAPTURE_NUM_TYPES];
+
+   /* struct replay_object, destroyed along with the device */
+   struct util_dynarray objects;
+
+   /* Pipelines waiting to be created, allocated out of batch_ctx */
+   void *batch_ctx;
+   struct util_dynarray graphics;
+   struct util_dynarray compute;
+};
+
+struct replay {
+   VkInstance instance;
+   VkPhysicalDevice physical_device;
+
+   /* Device record id to struct replay_device, NULL if it couldn't be
+    * created.
+    */
+   struct hash_table_u64 *devices;
+   struct util_dynarray device_list;
+
+   unsigned num_pipelines;
+   unsigned num_failed;
+   unsigned num_skipped;
+};
+
+static uint64_t
+replay_lookup(void *data, enum pipeline_capture_type type, uint64_t id)
+{
+   struct replay_device *dev = data;
+   uint64_t *handle = _mesa_hash_table_u64_search(dev->handles[type], id);
+
+   return handle ? *handle : 0;
+}
+
+static void
+replay_add_object(struct replay_device *dev, enum pipeline_capture_type type,
+                  uint64_t id, const void *handle)
+{
+   uint64_t *value = ralloc(dev, uint64_t);
+   if (!value)
+      return;
+
+   *value = pipeline_capture_handle_to_u64(handle);
+   _mesa_hash_table_u64_insert(dev->handles[type], id, value);
+
+   struct replay_object obj = { .type = type, .handle = *value };
+   util_dynarray_append(&dev->objects, struct replay_object, obj);
+}
+
+static void
+replay_flush(struct replay *replay, struct replay_device *dev)
+{
+   VkPipeline pipelines[REPLAY_BATCH_SIZE];
+   struct {
+      struct util_dynarray *infos;
+      size_t info_size;
+      bool graphics;
+   } batches[] = {
+      { &dev->graphics, sizeof(VkGraphicsPipelineCreateInfo), true },
+      { &dev->compute, sizeof(VkComputePipelineCreateInfo), false },
+   };
+
+   for (unsigned b = 0; b < ARRAY_SIZE(batches); b++) {
+      uint32_t count = batches[b].infos->size / batches[b].info_size;
+      if (count == 0)
+         continue;
+
+      VkResult result;
+      if (batches[b].graphics) {
+         result = vkCreateGraphicsPipelines(dev->device, VK_NULL_HANDLE,
+                                            count, batches[b].infos->data,
+                                            NULL, pipelines);
+      } else {
+         result = vkCreateComputePipelines(dev->device, VK_NULL_HANDLE,
+                                           count, batches[b].infos->data,
+                                           NULL, pipelines);
+      }
+
+      /* Without VK_PIPELINE_CREATE_EARLY_RETURN_ON_FAILURE_BIT_EXT, all of
+       * them are attempted even if some fail.
+       */
+      for (uint32_t i = 0; i < count; i++) {
+         if (pipelines[i] != VK_NULL_HANDLE) {
+            vkDestroyPipeline(dev->device, pipelines[i], NULL);
+            replay->num_pipelines++;
+         } else {
+            replay->num_failed++;
+         }
+      }
+      if (result != VK_SUCCESS)
+         fprintf(stderr, "some pipelines failed to compile: %d\n", result);
+
+      util_dynarray_clear(batches[b].infos);
+   }
+
+   ralloc_free(dev->batch_ctx);
+   dev->batch_ctx = ralloc_context(dev);
+}
+
+static bool
+replay_select_queue_family(VkPhysicalDevice physical_device,
+                           uint32_t *family)
+{
+   VkQueueFamilyProperties props[16];
+   uint32_t count = ARRAY_SIZE(props);
+
+   vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &count, props);
+   for (uint32_t i = 0; i < count; i++) {
+      if (props[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+         *family = i;
+         return true;
+      }
+   }
+
+   return false;
+}
+
+/* Creates a device with the extensions and features the application's
+ * device had, as far as this one supports them.  The drivers take some of
+ * them into account when hashing the shaders.
+ */
+static struct replay_device *
+replay_create_device(struct replay *replay, struct blob_reader *blob)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   VkDeviceCreateInfo *info = pipeline_capture_read_device(mem_ctx, blob);
+   if (!info) {
+      ralloc_free(mem_ctx);
+      return NULL;
+   }
+
+   uint32_t ext_count = 0;
+   vkEnumerateDeviceExtensionProperties(replay->physical_device, NULL,
+                                        &ext_count, NULL);
+   VkExtensionProperties *exts =
+      ralloc_array(mem_ctx, VkExtensionProperties, ext_count);
+   vkEnumerateDeviceExtensionProperties(replay->physical_device, NULL,
+                                        &ext_count, exts);
+
+   const char **names =
+      ralloc_array(mem_ctx, const char *, info->enabledExtensionCount + 1);
+   uint32_t name_count = 0;
+   for (uint32_t i = 0; i < info->enabledExtensionCount; i++) {
+      for (uint32_t e = 0; e < ext_count; e++) {
+         if (strcmp(info->ppEnabledExtensionNames[i],
+                    exts[e].extensionName) == 0) {
+            names[name_count++] = info->ppEnabledExtensionNames[i];
+            break;
+         }
+      }
+   }
+   info->enabledExtensionCount = name_count;
+   info->ppEnabledExtensionNames = names;
+
+   VkPhysicalDeviceFeatures supported;
+   vkGetPhysicalDeviceFeatures(replay->physical_device, &supported);
+   if (info->pEnabledFeatures) {
+      VkBool32 *enabled = (VkBool32 *)info->pEnabledFeatures;
+      const VkBool32 *avail = (const VkBool32 *)&supported;
+
+      for (unsigned i = 0; i < sizeof(supported) / sizeof(VkBool32); i++)
+         enabled[i] &= avail[i];
+   }
+
+   const float priority = 1.0f;
+   VkDeviceQueueCreateInfo queue_info = {
+      .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+      .queueCount = 1,
+      .pQueuePriorities = &priority,
+   };
+   if (!replay_select_queue_family(replay->physical_device,
+                                   &queue_info.queueFamilyIndex)) {
+      ralloc_free(mem_ctx);
+      return NULL;
+   }
+   info->queueCreateInfoCount = 1;
+   info->pQueueCreateInfos = &queue_info;
+
+   struct replay_device *dev = rzalloc(NULL, struct replay_device);
+   VkResult result = vkCreateDevice(replay->physical_device, info, NULL,
+                                    &dev->device);
+   ralloc_free(mem_ctx);
+   if (result != VK_SUCCESS) {
+      fprintf(stderr, "failed to create a device: %d\n", result);
+      ralloc_free(dev);
+      return NULL;
+   }
+
+   for (unsigned i = 0; i < PIPELINE_CAPTURE_NUM_TYPES; i++)
+      dev->handles[i] = _mesa_hash_table_u64_create(dev);
+   util_dynarray_init(&dev->objects, dev);
+   util_dynarray_init(&dev->graphics, dev);
+   util_dynarray_init(&dev->compute, dev);
+   dev->batch_ctx = ralloc_context(dev);
+
+   return dev;
+}
+
+static void
+replay_destroy_device(struct replay *replay, struct replay_device *dev)
+{
+   replay_flush(replay, dev);
+
+   util_dynarray_foreach_reverse(&dev->objects, struct replay_object, obj) {
+      switch (obj->type) {
+#define REPLAY_DESTROY(type, func, handle_type)                         \
+      case type: {                                                      \
+         handle_type handle;                                            \
+         memcpy(&handle, &obj->handle, sizeof(handle));                 \
+         func(dev->device, handle, NULL);                               \
+         break;                                                         \
+      }
+      REPLAY_DESTROY(PIPELINE_CAPTURE_SHADER_MODULE, vkDestroyShaderModule,
+                     VkShaderModule)
+      REPLAY_DESTROY(PIPELINE_CAPTURE_SAMPLER, vkDestroySampler, VkSampler)
+      REPLAY_DESTROY(PIPELINE_CAPTURE_DESCRIPTOR_SET_LAYOUT,
+                     vkDestroyDescriptorSetLayout, VkDescriptorSetLayout)
+      REPLAY_DESTROY(PIPELINE_CAPTURE_PIPELINE_LAYOUT,
+                     vkDestroyPipelineLayout, VkPipelineLayout)
+      REPLAY_DESTROY(PIPELINE_CAPTURE_RENDER_PASS, vkDestroyRenderPass,
+                     VkRenderPass)
+#undef REPLAY_DESTROY
+      default:
+         unreachable("not an object type");
+      }
+   }
+
+   vkDestroyDevice(dev->device, NULL);
+   ralloc_free(dev);
+}
+
+static void
+replay_record(struct replay *replay,
+              const struct pipeline_capture_record *record,
+              struct blob_reader *blob)
+{
+   if (record->type == PIPELINE_CAPTURE_DEVICE) {
+      if (_mesa_hash_table_u64_search(replay->devices, record->id))
+         return;
+
+      struct replay_device *dev = replay_create_device(replay, blob);
+      if (dev) {
+         _mesa_hash_table_u64_insert(replay->devices, record->id, dev);
+         util_dynarray_append(&replay->device_list, struct replay_device *,
+                              dev);
+      }
+      return;
+   }
+
+   struct replay_device *dev =
+      _mesa_hash_table_u64_search(replay->devices, record->device_id);
+   if (!dev || record->type >= PIPELINE_CAPTURE_NUM_TYPES) {
+      replay->num_skipped++;
+      return;
+   }
+
+   /* Objects only live for as long as it takes to create them. */
+   void *mem_ctx = ralloc_context(NULL);
+   VkResult result = VK_ERROR_INITIALIZATION_FAILED;
+
+   switch (record->type) {
+   case PIPELINE_CAPTURE_SHADER_MODULE: {
+      VkShaderModuleCreateInfo *info =
+         pipeline_capture_read_shader_module(mem_ctx, blob);
+      VkShaderModule module;
+      if (info)
+         result = vkCreateShaderModule(dev->device, info, NULL, &module);
+      if (result == VK_SUCCESS)
+         replay_add_object(dev, record->type, record->id, &module);
+      break;
+   }
+
+   case PIPELINE_CAPTURE_SAMPLER: {
+      VkSamplerCreateInfo *info = pipeline_capture_read_sampler(mem_ctx, blob);
+      VkSampler sampler;
+      if (info)
+         result = vkCreateSampler(dev->device, info, NULL, &sampler);
+      if (result == VK_SUCCESS)
+         replay_add_object(dev, record->type, record->id, &sampler);
+      break;
+   }
+
+   case PIPELINE_CAPTURE_DESCRIPTOR_SET_LAYOUT: {
+      VkDescriptorSetLayoutCreateInfo *info =
+         pipeline_capture_read_descriptor_set_layout(mem_ctx, blob,
+                                                     replay_lookup, dev);
+      VkDescriptorSetLayout layout;
+      if (info)
+         result = vkCreateDescriptorSetLayout(dev->device, info, NULL, &layout);
+      if (result == VK_SUCCESS)
+         replay_add_object(dev, record->type, record->id, &layout);
+      break;
+   }
+
+   case PIPELINE_CAPTURE_PIPELINE_LAYOUT: {
+      VkPipelineLayoutCreateInfo *info =
+         pipeline_capture_read_pipeline_layout(mem_ctx, blob,
+                                               replay_lookup, dev);
+      VkPipelineLayout layout;
+      if (info)
+         result = vkCreatePipelineLayout(dev->device, info, NULL, &layout);
+      if (result == VK_SUCCESS)
+         replay_add_object(dev, record->type, record->id, &layout);
+      break;
+   }
+
+   case PIPELINE_CAPTURE_RENDER_PASS: {
+      VkRenderPassCreateInfo *info =
+         pipeline_capture_read_render_pass(mem_ctx, blob);
+      VkRenderPass pass;
+      if (info)
+         result = vkCreateRenderPass(dev->device, info, NULL, &pass);
+      if (result == VK_SUCCESS)
+         replay_add_object(dev, record->type, record->id, &pass);
+      break;
+   }
+
+   case PIPELINE_CAPTURE_GRAPHICS_PIPELINE: {
+      VkGraphicsPipelineCreateInfo *info =
+         pipeline_capture_read_graphics_pipeline(dev->batch_ctx, blob,
+                                                 replay_lookup, dev);
+      if (info) {
+         info->flags &= ~VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT_EXT;
+         util_dynarray_append(&dev->graphics, VkGraphicsPipelineCreateInfo,
+                              *info);
+         result = VK_SUCCESS;
+      }
+      break;
+   }
+
+   case PIPELINE_CAPTURE_COMPUTE_PIPELINE: {
+      VkComputePipelineCreateInfo *info =
+         pipeline_capture_read_compute_pipeline(dev->batch_ctx, blob,
+                                                replay_lookup, dev);
+      if (info) {
+         info->flags &= ~VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT_EXT;
+         util_dynarray_append(&dev->compute, VkComputePipelineCreateInfo,
+                              *info);
+         result = VK_SUCCESS;
+      }
+      break;
+   }
+
+   default:
+      break;
+   }
+
+   ralloc_free(mem_ctx);
+
+   /* Anything depending on an object which couldn't be created is skipped
+    * as well.
+    */
+   if (result != VK_SUCCESS)
+      replay->num_skipped++;
+
+   if (util_dynarray_num_elements(&dev->graphics, VkGraphicsPipelineCreateInfo) >= REPLAY_BATCH_SIZE ||
+       util_dynarray_num_elements(&dev->compute, VkComputePipelineCreateInfo) >= REPLAY_BATCH_SIZE)
+      replay_flush(replay, dev);
+}
+
+static bool
+replay_init(struct replay *replay, unsigned device_index)
+{
+   const VkApplicationInfo app_info = {
+      .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+      .pApplicationName = "mesa-pipeline-replay",
+      .apiVersion = VK_API_VERSION_1_1,
+   };
+   const VkInstanceCreateInfo info = {
+      .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+      .pApplicationInfo = &app_info,
+   };
+
+   if (vkCreateInstance(&info, NULL, &replay->instance) != VK_SUCCESS) {
+      fprintf(stderr, "failed to create a Vulkan instance\n");
+      return false;
+   }
+
+   uint32_t count = 0;
+   vkEnumeratePhysicalDevices(replay->instance, &count, NULL);
+   if (device_index >= count) {
+      fprintf(stderr, "no device %u, there are %u\n", device_index, count);
+      vkDestroyInstance(replay->instance, NULL);
+      return false;
+   }
+
+   VkPhysicalDevice *devices = calloc(count, sizeof(*devices));
+   vkEnumeratePhysicalDevices(replay->instance, &count, devices);
+   replay->physical_device = devices[device_index];
+   free(devices);
+
+   VkPhysicalDeviceProperties props;
+   vkGetPhysicalDeviceProperties(replay->physical_device, &props);
+   printf("replaying on %s\n", props.deviceName);
+
+   replay->devices = _mesa_hash_table_u64_create(NULL);
+   util_dynarray_init(&replay->device_list, NULL);
+
+   return true;
+}
+
+static void
+replay_finish(struct replay *replay)
+{
+   util_dynarray_foreach(&replay->device_list, struct replay_device *, dev)
+      replay_destroy_device(replay, *dev);
+   util_dynarray_fini(&replay->device_list);
+   _mesa_hash_table_u64_destroy(replay->devices, NULL);
+
+   vkDestroyInstance(replay->instance, NULL);
+}
+
+static void
+print_usage(const char *name)
+{
+   fprintf(stderr,
+           "usage: %s [options] <capture file>\n"
+           "\n"
+           "  -d, --device <index>   physical device to compile for\n"
+           "  -n, --nice <value>     niceness to run at, 19 by default\n",
+           name);
+}
+
+int
+main(int argc, char **argv)
+{
+   static const struct option long_options[] = {
+      { "device", required_argument, NULL, 'd' },
+      { "nice", required_argument, NULL, 'n' },
+      { "help", no_argument, NULL, 'h' },
+      { NULL, 0, NULL, 0 },
+   };
+   unsigned device_index = 0;
+   int niceness = 19;
+   int c;
+
+   while ((c = getopt_long(argc, argv, "d:n:h", long_options, NULL)) != -1) {
+      switch (c) {
+      case 'd':
+         device_index = strtoul(optarg, NULL, 0);
+         break;
+      case 'n':
+         niceness = strtol(optarg, NULL, 0);
+         break;
+      default:
+         print_usage(argv[0]);
+         return c == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+      }
+   }
+
+   if (optind != argc - 1) {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   /* Before creating any device, so that the compiler threads of the
+    * driver inherit it.
+    */
+   if (setpriority(PRIO_PROCESS, 0, niceness) == -1)
+      fprintf(stderr, "failed to set the priority: %s\n", strerror(errno));
+
+   size_t size;
+   char *data = os_read_file(argv[optind], &size);
+   if (!data) {
+      fprintf(stderr, "failed to read %s: %s\n", argv[optind], strerror(errno));
+      return EXIT_FAILURE;
+   }
+
+   const struct pipeline_capture_header *header = (const void *)data;
+   if (size < sizeof(*header) ||
+       memcmp(header->magic, PIPELINE_CAPTURE_MAGIC, sizeof(header->magic)) ||
+       header->version != PIPELINE_CAPTURE_VERSION) {
+      fprintf(stderr, "%s is not a valid capture file\n", argv[optind]);
+      free(data);
+      return EXIT_FAILURE;
+   }
+
+   struct replay replay = { 0 };
+   if (!replay_init(&replay, device_index)) {
+      free(data);
+      return EXIT_FAILURE;
+   }
+
+   size_t offset = sizeof(*header);
+   while (offset + sizeof(struct pipeline_capture_record) <= size) {
+      struct pipeline_capture_record record;
+      memcpy(&record, data + offset, sizeof(record));
+      offset += sizeof(record);
+
+      /* The last record may have been cut short. */
+      if (record.size > size - offset)
+         break;
+
+      /* The blob reader expects its data to be aligned. */
+      void *record_data = malloc(record.size);
+      if (!record_data)
+         break;
+      memcpy(record_data, data + offset, record.size);
+
+      struct blob_reader blob;
+      blob_reader_init(&blob, record_data, record.size);
+      replay_record(&replay, &record, &blob);
+      free(record_data);
+
+      offset += record.size;
+   }
+
+   replay_finish(&replay);
+   free(data);
+
+   printf("%u pipelines compiled, %u failed, %u records skipped\n",
+          replay.num_pipelines, replay.num_failed, replay.num_skipped);
+
+   return EXIT_SUCCESS;
+}
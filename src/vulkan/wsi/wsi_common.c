@@ -26,6 +26,7 @@
 #include "util/macros.h"
 #include "util/os_file.h"
 #include "util/xmlconfig.h"
+#include "util/u_cpu_trace.h"
 #include "vk_util.h"
 
 #include <time.h>
@@ -345,6 +346,58 @@ align_u32(uint32_t v, uint32_t a)
    return (v + a - 1) & ~(a - 1);
 }
 
+/* Whether wsi_create_native_image() can create images for this swapchain
+ * with the given modifier.
+ */
+bool
+wsi_device_supports_modifier(const struct wsi_device *wsi,
+                             const VkSwapchainCreateInfoKHR *pCreateInfo,
+                             uint64_t modifier)
+{
+   if (!wsi->supports_modifiers)
+      return false;
+
+   VkPhysicalDeviceImageDrmFormatModifierInfoEXT mod_info = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_DRM_FORMAT_MODIFIER_INFO_EXT,
+      .drmFormatModifier = modifier,
+      .sharingMode = pCreateInfo->imageSharingMode,
+      .queueFamilyIndexCount = pCreateInfo->queueFamilyIndexCount,
+      .pQueueFamilyIndices = pCreateInfo->pQueueFamilyIndices,
+   };
+   VkPhysicalDeviceImageFormatInfo2 format_info = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2,
+      .pNext = &mod_info,
+      .format = pCreateInfo->imageFormat,
+      .type = VK_IMAGE_TYPE_2D,
+      .tiling = VK_IMAGE_TILING_DRM_FORMAT_MODIFIER_EXT,
+      .usage = pCreateInfo->imageUsage,
+      .flags = 0,
+   };
+
+   VkImageFormatListCreateInfoKHR format_list;
+   if (pCreateInfo->flags & VK_SWAPCHAIN_CREATE_MUTABLE_FORMAT_BIT_KHR) {
+      format_info.flags |= VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT |
+                           VK_IMAGE_CREATE_EXTENDED_USAGE_BIT_KHR;
+
+      const VkImageFormatListCreateInfoKHR *swapchain_format_list =
+         vk_find_struct_const(pCreateInfo->pNext,
+                              IMAGE_FORMAT_LIST_CREATE_INFO_KHR);
+      if (swapchain_format_list) {
+         format_list = *swapchain_format_list;
+         format_list.pNext = NULL;
+         __vk_append_struct(&format_info, &format_list);
+      }
+   }
+
+   VkImageFormatProperties2 format_props = {
+      .sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2,
+      .pNext = NULL,
+   };
+   return wsi->GetPhysicalDeviceImageFormatProperties2(wsi->pdevice,
+                                                       &format_info,
+                                                       &format_props) == VK_SUCCESS;
+}
+
 VkResult
 wsi_create_native_image(const struct wsi_swapchain *chain,
                         const VkSwapchainCreateInfoKHR *pCreateInfo,
@@ -1134,6 +1187,7 @@ wsi_common_queue_present(const struct wsi_device *wsi,
                          int queue_family_index,
                          const VkPresentInfoKHR *pPresentInfo)
 {
+   UTIL_CPU_TRACE_FRAME();
    VkResult final_result = VK_SUCCESS;
 
    const VkPresentRegionsKHR *regions =
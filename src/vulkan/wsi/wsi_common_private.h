@@ -88,6 +88,11 @@ wsi_swapchain_get_present_mode(struct wsi_device *wsi,
 
 void wsi_swapchain_finish(struct wsi_swapchain *chain);
 
+bool
+wsi_device_supports_modifier(const struct wsi_device *wsi,
+                             const VkSwapchainCreateInfoKHR *pCreateInfo,
+                             uint64_t modifier);
+
 VkResult
 wsi_create_native_image(const struct wsi_swapchain *chain,
                         const VkSwapchainCreateInfoKHR *pCreateInfo,
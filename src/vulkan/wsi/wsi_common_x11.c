@@ -1291,6 +1291,21 @@ x11_image_finish(struct x11_swapchain *chain,
    wsi_destroy_image(&chain->base, &image->base);
 }
 
+static bool
+wsi_x11_has_modifier(const uint64_t *const *modifiers,
+                     const uint32_t *num_modifiers,
+                     uint32_t num_tranches, uint64_t modifier)
+{
+   for (uint32_t t = 0; t < num_tranches; t++) {
+      for (uint32_t i = 0; i < num_modifiers[t]; i++) {
+         if (modifiers[t][i] == modifier)
+            return true;
+      }
+   }
+
+   return false;
+}
+
 static void
 wsi_x11_get_dri3_modifiers(struct wsi_x11_connection *wsi_conn,
                            xcb_connection_t *conn, xcb_window_t window,
@@ -1547,11 +1562,33 @@ x11_surface_create_swapchain(VkIcdSurfaceBase *icd_surface,
                                  modifiers, num_modifiers, &num_tranches,
                                  pAllocator);
 
+   /* When the X server runs on another GPU, render directly to linear
+    * images it can import, rather than blitting every frame to a linear
+    * copy. This needs DRI3 modifiers to agree on the layout, so the blit
+    * remains the fallback.
+    */
+   const uint64_t linear_modifier = DRM_FORMAT_MOD_LINEAR;
+   const uint64_t *linear_modifiers[1] = { &linear_modifier };
+   const uint32_t num_linear_modifiers[1] = { 1 };
+   const uint64_t *const *image_modifiers = (const uint64_t *const *)modifiers;
+   const uint32_t *num_image_modifiers = num_modifiers;
+   uint32_t num_image_tranches = num_tranches;
+   if (chain->base.use_prime_blit &&
+       wsi_x11_has_modifier((const uint64_t *const *)modifiers, num_modifiers,
+                            num_tranches, DRM_FORMAT_MOD_LINEAR) &&
+       wsi_device_supports_modifier(wsi_device, pCreateInfo,
+                                    DRM_FORMAT_MOD_LINEAR)) {
+      chain->base.use_prime_blit = false;
+      image_modifiers = linear_modifiers;
+      num_image_modifiers = num_linear_modifiers;
+      num_image_tranches = 1;
+   }
+
    uint32_t image = 0;
    for (; image < chain->base.image_count; image++) {
       result = x11_image_init(device, chain, pCreateInfo, pAllocator,
-                              (const uint64_t *const *)modifiers,
-                              num_modifiers, num_tranches,
+                              image_modifiers,
+                              num_image_modifiers, num_image_tranches,
                               &chain->images[image]);
       if (result != VK_SUCCESS)
          goto fail_init_images;